@@ -1,8 +1,10 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <filesystem>
 #include <string>
+#include <AdvancedBoy.hpp>
 #include <QtCore/QThread>
 #include <SDL2/SDL.h>
 
@@ -22,6 +24,9 @@ public:
     /// @param romPath Path to ROM to load.
     void LoadROM(fs::path romPath);
 
+    /// @brief Pause audio and stop the emulation thread, waiting for it to finish. Does nothing if it isn't running.
+    void Stop();
+
     /// @brief Stop the emulation and audio threads, and power off GBA.
     void Quit();
 
@@ -29,16 +34,43 @@ public:
     /// @return Title of ROM.
     std::string RomTitle() const;
 
+    /// @brief Get the GBA run by this thread.
+    /// @return Handle to GBA, or nullptr once powered off.
+    GbaHandle Gba() const { return gba_; }
+
     /// @brief Unlock and unpause the audio device.
     void StartAudioCallback();
 
     /// @brief Lock and pause the audio device.
     void PauseAudioCallback();
 
+    /// @brief Choose whether to run as fast as possible instead of at the speed audio is played back. Audio is muted and only
+    ///        one of every ten frames is drawn while fast-forwarding. Safe to call while running.
+    /// @param enabled Whether to fast-forward.
+    void SetFastForward(bool enabled);
+
+    /// @brief Choose how many frames to run ahead of the displayed frame to hide the game's own input lag. Paused while
+    ///        fast-forwarding. Safe to call while running.
+    /// @param frames Number of frames to run ahead, or 0 to disable.
+    void SetRunAhead(int frames) { runAheadFrames_.store(frames, std::memory_order_relaxed); }
+
+    /// @brief Allow FrameCompleted to be emitted again. Must be called by whatever handles FrameCompleted.
+    void AcknowledgeFrame() { framePending_.store(false, std::memory_order_relaxed); }
+
+signals:
+    /// @brief Emitted when the GBA completes a frame. Not emitted again until AcknowledgeFrame is called, so a slow receiver
+    ///        doesn't build up a queue of stale notifications.
+    void FrameCompleted();
+
 private:
-    /// @brief Main emulation loop. Access by calling start().
+    /// @brief Main emulation loop. Access by calling start(). Refills the audio buffer, then sleeps until the audio callback
+    ///        drains it enough to need refilling again. While fast-forwarding, runs frames back to back instead.
     void run();
 
+    GbaHandle gba_;
     bool gamePakSuccessfullyLoaded_;
     SDL_AudioDeviceID audioDevice_;
+    std::atomic_bool framePending_;
+    std::atomic_bool fastForward_;
+    std::atomic_int runAheadFrames_;
 };
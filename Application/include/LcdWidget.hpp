@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <AdvancedBoy.hpp>
+#include <QtOpenGL/QOpenGLBuffer>
+#include <QtOpenGL/QOpenGLShaderProgram>
+#include <QtOpenGL/QOpenGLTexture>
+#include <QtOpenGLWidgets/QOpenGLWidget>
+#include <QtGui/QOpenGLFunctions>
+
+/// @brief Widget that presents GBA frames with OpenGL. Each frame is uploaded at its native 240x160 resolution to a texture, and
+///        scaling to the size of the widget is done entirely by the GPU when the texture is drawn. The latest frame is acquired
+///        right before each repaint, so a repaint requested when a frame completes always shows the newest frame available.
+class LcdWidget : public QOpenGLWidget, protected QOpenGLFunctions
+{
+    Q_OBJECT
+
+public:
+    /// @brief Initialize the LCD widget.
+    /// @param vsync Whether buffer swaps wait for the display's vertical blank. Without it, a repaint reaches the screen as soon
+    ///              as it's drawn at the cost of possible tearing.
+    /// @param parent Parent widget.
+    LcdWidget(bool vsync, QWidget* parent = nullptr);
+
+    /// @brief Release GPU resources.
+    ~LcdWidget();
+
+    /// @brief Choose where frames come from.
+    /// @param frameSource Function that returns the latest frame, with pixels in RGBA8888 format. Called on the UI thread.
+    void SetFrameSource(std::function<Frame()> frameSource) { frameSource_ = std::move(frameSource); }
+
+    /// @brief Choose how frames are scaled up to the size of the widget.
+    /// @param smooth True for bilinear filtering, false for nearest neighbor.
+    void SetSmoothScaling(bool smooth);
+
+protected:
+    /// @brief Create the texture, shader, and vertex buffer once an OpenGL context exists.
+    void initializeGL() override;
+
+    /// @brief Upload the latest frame if it changed, and draw it across the whole widget.
+    void paintGL() override;
+
+private:
+    /// @brief Acquire the latest frame and upload it to the texture if its contents differ from the frame on screen.
+    void UploadLatestFrame();
+
+    /// @brief Release GPU resources while the OpenGL context is still alive.
+    void CleanUp();
+
+    std::unique_ptr<QOpenGLTexture> texture_;
+    std::unique_ptr<QOpenGLShaderProgram> program_;
+    QOpenGLBuffer vertexBuffer_;
+    std::function<Frame()> frameSource_;
+    uint64_t displayedContentSequence_;
+    bool smoothScaling_;
+};
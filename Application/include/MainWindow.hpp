@@ -5,6 +5,7 @@
 #include <set>
 #include <string>
 #include <EmuThread.hpp>
+#include <LcdWidget.hpp>
 #include <QtCore/QtCore>
 #include <QtCore/QTimer>
 #include <QtWidgets/QMainWindow>
@@ -18,8 +19,9 @@ class MainWindow : public QMainWindow
 
 public:
     /// @brief Initialize the main GUI window.
+    /// @param lowLatency Whether to present each frame the moment it completes instead of at the display's next vertical blank.
     /// @param parent Parent widget.
-    MainWindow(QWidget* parent = nullptr);
+    MainWindow(bool lowLatency, QWidget* parent = nullptr);
 
 private:
     /// @brief Initialize the window menu bar.
@@ -31,11 +33,11 @@ private:
     /// @brief Resize the window to a fixed size based on window scale property.
     void ResizeWindow();
 
-    /// @brief Add whichever key was pressed to the set of currently pressed keys.
+    /// @brief Add whichever key was pressed to the set of currently pressed keys and send the new buttons to the GBA.
     /// @param event Key press event.
     void keyPressEvent(QKeyEvent* event);
 
-    /// @brief Remove whichever key was released from the set of currently pressed keys.
+    /// @brief Remove whichever key was released from the set of currently pressed keys and send the new buttons to the GBA.
     /// @param event Key release event.
     void keyReleaseEvent(QKeyEvent* event);
 
@@ -50,13 +52,14 @@ private:
     /// @param event Drop event.
     void dropEvent(QDropEvent* event);
 
-    /// @brief Update the GBA gamepad based on which keys are currently pressed.
+    /// @brief Update the GBA gamepad based on which keys are currently pressed. The emulation thread picks the change up at the
+    ///        next KEYINPUT read or scanline, without waiting for a frame to be presented.
     void SendKeyPresses() const;
 
-    /// @brief Update the window title every second with the latest FPS.
+    /// @brief Update the window title every second with the latest FPS, emulation speed, and host time per frame.
     void UpdateWindowTitle();
 
-    /// @brief Update the LCD label widget.
+    /// @brief Present the frame that just completed.
     void RefreshScreen();
 
     /// @brief Open a file explorer to allow user to select a ROM to load.
@@ -77,9 +80,11 @@ private:
     QMenu* optionsMenu_;
 
     // Display
-    QLabel lcd_;
-    QTimer refreshScreenTimer_;
+    LcdWidget lcd_;
+    bool lowLatency_;
     int screenScale_;
+    uint64_t latestFrameSequence_;
+    uint64_t fpsFrameSequence_;
 
     // Gamepad
     std::set<int> pressedKeys_;
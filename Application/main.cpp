@@ -13,7 +13,8 @@ namespace fs = std::filesystem;
 int main(int argv, char** args)
 {
     QApplication app(argv, args);
-    MainWindow mainWindow;
+    bool lowLatency = app.arguments().contains("--low-latency");
+    MainWindow mainWindow(lowLatency);
     mainWindow.show();
     return app.exec();
 }
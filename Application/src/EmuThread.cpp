@@ -1,6 +1,5 @@
 #include <EmuThread.hpp>
 #include <cstdint>
-#include <cstring>
 #include <functional>
 #include <string>
 #include <AdvancedBoy.hpp>
@@ -9,39 +8,54 @@
 
 namespace
 {
-void AudioCallback(void*, uint8_t* stream, int len)
-{
-    size_t cnt = len / sizeof(float);
-    size_t availableSamples = ::AvailableSamplesCount();
-    float* buffer = reinterpret_cast<float*>(stream);
+// Only reached if the audio device stops pulling samples without the thread being stopped
+constexpr int AUDIO_WAIT_TIMEOUT_MS = 100;
 
-    if (cnt > availableSamples)
-    {
-        ::DrainAudioBuffer(buffer, availableSamples);
-        std::memset(&buffer[availableSamples], 0, sizeof(float) * cnt - availableSamples);
-    }
-    else
-    {
-        ::DrainAudioBuffer(buffer, cnt);
-    }
+// Frames skipped after each drawn frame while fast-forwarding
+constexpr int FAST_FORWARD_FRAME_SKIP = 9;
+
+void AudioCallback(void* userdata, uint8_t* stream, int len)
+{
+    ::DrainAudioBuffer(static_cast<GbaHandle>(userdata), reinterpret_cast<float*>(stream), len / sizeof(float));
 }
 }
 
 EmuThread::EmuThread(fs::path biosPath, QObject* parent) :
     QThread(parent),
-    gamePakSuccessfullyLoaded_(false)
+    gba_(nullptr),
+    gamePakSuccessfullyLoaded_(false),
+    framePending_(false),
+    fastForward_(false),
+    runAheadFrames_(0)
 {
-    Initialize(biosPath);
+    gba_ = ::Initialize(biosPath);
+    ::SetPixelFormat(gba_, PixelFormat::RGBA8888);
+    ::SetFrameCallback(gba_, [this](uint64_t)
+    {
+        if (!framePending_.exchange(true, std::memory_order_relaxed))
+        {
+            emit FrameCompleted();
+        }
+    });
 
     // Audio startup
     SDL_Init(SDL_INIT_AUDIO);
     SDL_AudioSpec audioSpec = {};
-    audioSpec.freq = 32768;
+    audioSpec.freq = 48000;
     audioSpec.format = AUDIO_F32SYS;
     audioSpec.channels = 2;
     audioSpec.samples = 256;
     audioSpec.callback = &AudioCallback;
-    audioDevice_ = SDL_OpenAudioDevice(nullptr, 0, &audioSpec, nullptr, 0);
+    audioSpec.userdata = gba_;
+
+    // Let SDL pick the device's native rate so it doesn't have to resample again
+    SDL_AudioSpec obtainedSpec = {};
+    audioDevice_ = SDL_OpenAudioDevice(nullptr, 0, &audioSpec, &obtainedSpec, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
+
+    if (audioDevice_ != 0)
+    {
+        ::SetAudioSampleRate(gba_, obtainedSpec.freq);
+    }
 }
 
 void EmuThread::LoadROM(fs::path romPath)
@@ -51,17 +65,29 @@ void EmuThread::LoadROM(fs::path romPath)
         return;
     }
 
-    gamePakSuccessfullyLoaded_ = ::InsertCartridge(romPath);
+    gamePakSuccessfullyLoaded_ = ::InsertCartridge(gba_, romPath);
+}
+
+void EmuThread::Stop()
+{
+    if (isRunning())
+    {
+        PauseAudioCallback();
+        requestInterruption();
+        ::WakeAudioWaiter(gba_);
+        wait();
+    }
 }
 
 void EmuThread::Quit()
 {
-    ::PowerOff();
+    ::PowerOff(gba_);
+    gba_ = nullptr;
 }
 
 std::string EmuThread::RomTitle() const
 {
-    return ::RomTitle();
+    return ::RomTitle(gba_);
 }
 
 void EmuThread::StartAudioCallback()
@@ -76,11 +102,48 @@ void EmuThread::PauseAudioCallback()
     SDL_PauseAudioDevice(audioDevice_, 1);
 }
 
+void EmuThread::SetFastForward(bool enabled)
+{
+    fastForward_.store(enabled, std::memory_order_relaxed);
+
+    if (enabled && gba_)
+    {
+        ::WakeAudioWaiter(gba_);
+    }
+}
+
 void EmuThread::run()
 {
+    bool fastForwarding = false;
+    int runAheadFrames = 0;
+
     while (!isInterruptionRequested())
     {
-        ::FillAudioBuffer();
-        msleep(5);
+        if (fastForwarding != fastForward_.load(std::memory_order_relaxed))
+        {
+            fastForwarding = !fastForwarding;
+            ::SetFrameSkip(gba_, fastForwarding ? FAST_FORWARD_FRAME_SKIP : 0);
+        }
+
+        int requestedRunAhead = fastForwarding ? 0 : runAheadFrames_.load(std::memory_order_relaxed);
+
+        if (runAheadFrames != requestedRunAhead)
+        {
+            runAheadFrames = requestedRunAhead;
+            ::SetRunAhead(gba_, runAheadFrames);
+        }
+
+        if (fastForwarding)
+        {
+            ::RunFrames(gba_, FAST_FORWARD_FRAME_SKIP + 1);
+        }
+        else
+        {
+            ::FillAudioBuffer(gba_);
+            ::WaitForAudioSpace(gba_, AUDIO_WAIT_TIMEOUT_MS);
+        }
     }
+
+    ::SetFrameSkip(gba_, 0);
+    ::SetRunAhead(gba_, 0);
 }
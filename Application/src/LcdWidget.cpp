@@ -0,0 +1,173 @@
+#include <LcdWidget.hpp>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <AdvancedBoy.hpp>
+#include <QtOpenGL/QOpenGLBuffer>
+#include <QtOpenGL/QOpenGLShaderProgram>
+#include <QtOpenGL/QOpenGLTexture>
+#include <QtOpenGLWidgets/QOpenGLWidget>
+#include <QtGui/QOpenGLContext>
+#include <QtGui/QOpenGLFunctions>
+#include <QtGui/QSurfaceFormat>
+
+namespace
+{
+constexpr int LCD_WIDTH = 240;
+constexpr int LCD_HEIGHT = 160;
+
+// Full screen quad drawn as a triangle strip. Each vertex is x, y, u, v. The first row of a frame is the top of the screen.
+constexpr std::array<GLfloat, 16> QUAD_VERTICES = {
+    -1.0f,  1.0f, 0.0f, 0.0f,
+    -1.0f, -1.0f, 0.0f, 1.0f,
+     1.0f,  1.0f, 1.0f, 0.0f,
+     1.0f, -1.0f, 1.0f, 1.0f
+};
+
+constexpr char const* VERTEX_SHADER = R"(
+attribute highp vec2 position;
+attribute highp vec2 texCoord;
+varying highp vec2 fragTexCoord;
+
+void main()
+{
+    fragTexCoord = texCoord;
+    gl_Position = vec4(position, 0.0, 1.0);
+}
+)";
+
+constexpr char const* FRAGMENT_SHADER = R"(
+uniform sampler2D frame;
+varying highp vec2 fragTexCoord;
+
+void main()
+{
+    gl_FragColor = vec4(texture2D(frame, fragTexCoord).rgb, 1.0);
+}
+)";
+}
+
+LcdWidget::LcdWidget(bool vsync, QWidget* parent) :
+    QOpenGLWidget(parent),
+    texture_(nullptr),
+    program_(nullptr),
+    vertexBuffer_(QOpenGLBuffer::VertexBuffer),
+    frameSource_(),
+    displayedContentSequence_(0),
+    smoothScaling_(false)
+{
+    QSurfaceFormat surfaceFormat = format();
+    surfaceFormat.setSwapInterval(vsync ? 1 : 0);
+    setFormat(surfaceFormat);
+}
+
+LcdWidget::~LcdWidget()
+{
+    makeCurrent();
+    CleanUp();
+    doneCurrent();
+}
+
+void LcdWidget::SetSmoothScaling(bool smooth)
+{
+    smoothScaling_ = smooth;
+
+    if (texture_)
+    {
+        QOpenGLTexture::Filter filter = smoothScaling_ ? QOpenGLTexture::Linear : QOpenGLTexture::Nearest;
+        makeCurrent();
+        texture_->setMinMagFilters(filter, filter);
+        doneCurrent();
+        update();
+    }
+}
+
+void LcdWidget::initializeGL()
+{
+    initializeOpenGLFunctions();
+    connect(context(), &QOpenGLContext::aboutToBeDestroyed, this, &LcdWidget::CleanUp);
+
+    QOpenGLTexture::Filter filter = smoothScaling_ ? QOpenGLTexture::Linear : QOpenGLTexture::Nearest;
+    texture_ = std::make_unique<QOpenGLTexture>(QOpenGLTexture::Target2D);
+    texture_->setFormat(QOpenGLTexture::RGBA8_UNorm);
+    texture_->setSize(LCD_WIDTH, LCD_HEIGHT);
+    texture_->setMipLevels(1);
+    texture_->setMinMagFilters(filter, filter);
+    texture_->setWrapMode(QOpenGLTexture::ClampToEdge);
+    texture_->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8);
+
+    // Show black until the first frame arrives
+    std::vector<uint8_t> blank(LCD_WIDTH * LCD_HEIGHT * 4, 0);
+    texture_->setData(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, blank.data());
+    displayedContentSequence_ = 0;
+
+    program_ = std::make_unique<QOpenGLShaderProgram>();
+    program_->addShaderFromSourceCode(QOpenGLShader::Vertex, VERTEX_SHADER);
+    program_->addShaderFromSourceCode(QOpenGLShader::Fragment, FRAGMENT_SHADER);
+    program_->bindAttributeLocation("position", 0);
+    program_->bindAttributeLocation("texCoord", 1);
+    program_->link();
+
+    vertexBuffer_.create();
+    vertexBuffer_.bind();
+    vertexBuffer_.allocate(QUAD_VERTICES.data(), static_cast<int>(QUAD_VERTICES.size() * sizeof(GLfloat)));
+    vertexBuffer_.release();
+}
+
+void LcdWidget::paintGL()
+{
+    if (!texture_ || !program_->isLinked())
+    {
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        return;
+    }
+
+    UploadLatestFrame();
+
+    program_->bind();
+    texture_->bind(0);
+    program_->setUniformValue("frame", 0);
+
+    vertexBuffer_.bind();
+    program_->enableAttributeArray(0);
+    program_->enableAttributeArray(1);
+    program_->setAttributeBuffer(0, GL_FLOAT, 0, 2, 4 * sizeof(GLfloat));
+    program_->setAttributeBuffer(1, GL_FLOAT, 2 * sizeof(GLfloat), 2, 4 * sizeof(GLfloat));
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    program_->disableAttributeArray(0);
+    program_->disableAttributeArray(1);
+    vertexBuffer_.release();
+    texture_->release();
+    program_->release();
+}
+
+void LcdWidget::UploadLatestFrame()
+{
+    if (!frameSource_)
+    {
+        return;
+    }
+
+    Frame frame = frameSource_();
+
+    if ((frame.pixels_ != nullptr) && (frame.contentSequence_ != displayedContentSequence_))
+    {
+        texture_->setData(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, frame.pixels_);
+        displayedContentSequence_ = frame.contentSequence_;
+    }
+}
+
+void LcdWidget::CleanUp()
+{
+    texture_.reset();
+    program_.reset();
+
+    if (vertexBuffer_.isCreated())
+    {
+        vertexBuffer_.destroy();
+    }
+}
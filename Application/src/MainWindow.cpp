@@ -7,19 +7,22 @@
 #include <AdvancedBoy.hpp>
 #include <EmuThread.hpp>
 #include <Gamepad.hpp>
+#include <LcdWidget.hpp>
 #include <QtWidgets/QMainWindow>
 #include <QtWidgets/QtWidgets>
 
 namespace fs = std::filesystem;
 
-MainWindow::MainWindow(QWidget* parent) :
+MainWindow::MainWindow(bool lowLatency, QWidget* parent) :
     QMainWindow(parent),
     gbaThread_("", this),
     romTitle_("Advanced Boy"),
     fpsTimer_(this),
-    lcd_(this),
-    refreshScreenTimer_(this),
+    lcd_(!lowLatency, this),
+    lowLatency_(lowLatency),
     screenScale_(4),
+    latestFrameSequence_(0),
+    fpsFrameSequence_(0),
     pressedKeys_()
 {
     ResizeWindow();
@@ -28,9 +31,7 @@ MainWindow::MainWindow(QWidget* parent) :
     setAttribute(Qt::WA_QuitOnClose);
     setWindowTitle("Advanced Boy");
 
-    refreshScreenTimer_.setTimerType(Qt::PreciseTimer);
-    connect(&refreshScreenTimer_, &QTimer::timeout, this, &RefreshScreen);
-    refreshScreenTimer_.start(16);
+    connect(&gbaThread_, &EmuThread::FrameCompleted, this, &RefreshScreen);
 
     connect(&fpsTimer_, &QTimer::timeout, this, &UpdateWindowTitle);
     fpsTimer_.start(1000);
@@ -45,10 +46,40 @@ void MainWindow::InitializeMenuBar()
     QAction* loadRomAction = new QAction("Load ROM...", this);
     connect(loadRomAction, &QAction::triggered, this, &SelectROM);
     fileMenu_->addAction(loadRomAction);
+
+    QAction* smoothScalingAction = new QAction("Smooth Scaling", this);
+    smoothScalingAction->setCheckable(true);
+    connect(smoothScalingAction, &QAction::toggled, &lcd_, &LcdWidget::SetSmoothScaling);
+    optionsMenu_->addAction(smoothScalingAction);
+
+    QMenu* runAheadMenu = optionsMenu_->addMenu("Run-Ahead");
+    QActionGroup* runAheadGroup = new QActionGroup(this);
+
+    for (int frames = 0; frames <= 3; ++frames)
+    {
+        QAction* runAheadAction = new QAction((frames == 0) ? QString("Off") : QString("%1 Frame%2").arg(frames).arg((frames == 1) ? "" : "s"), this);
+        runAheadAction->setCheckable(true);
+        runAheadAction->setChecked(frames == 0);
+        runAheadAction->setActionGroup(runAheadGroup);
+        connect(runAheadAction, &QAction::triggered, this, [this, frames]() { gbaThread_.SetRunAhead(frames); });
+        runAheadMenu->addAction(runAheadAction);
+    }
 }
 
 void MainWindow::InitializeLCD()
 {
+    lcd_.SetFrameSource([this]()
+    {
+        Frame frame = ::AcquireLatestFrame(gbaThread_.Gba());
+
+        if (frame.pixels_ != nullptr)
+        {
+            latestFrameSequence_ = frame.sequence_;
+        }
+
+        return frame;
+    });
+
     setCentralWidget(&lcd_);
 }
 
@@ -63,39 +94,51 @@ void MainWindow::ResizeWindow()
 
 void MainWindow::keyPressEvent(QKeyEvent* event)
 {
-    if (event)
+    if (event && !event->isAutoRepeat())
     {
         pressedKeys_.insert(event->key());
+        SendKeyPresses();
+
+        if (event->key() == Qt::Key_Space)
+        {
+            gbaThread_.SetFastForward(true);
+        }
     }
 }
 
 void MainWindow::keyReleaseEvent(QKeyEvent* event)
 {
-    if (event)
+    if (event && !event->isAutoRepeat())
     {
         pressedKeys_.erase(event->key());
+        SendKeyPresses();
+
+        if (event->key() == Qt::Key_Space)
+        {
+            gbaThread_.SetFastForward(false);
+        }
 
         if (event->key() == 72)  // H
         {
-            ::ToggleCpuLogging();
+            ::ToggleCpuLogging(gbaThread_.Gba());
         }
 
         if (event->key() == 71)  // G
         {
-            ::ToggleSystemLogging();
+            ::ToggleSystemLogging(gbaThread_.Gba());
+        }
+
+        if (event->key() == 74)  // J
+        {
+            ::ToggleTraceStreaming(gbaThread_.Gba());
         }
     }
 }
 
 void MainWindow::closeEvent(QCloseEvent*)
 {
-    if (gbaThread_.isRunning())
-    {
-        gbaThread_.PauseAudioCallback();
-        gbaThread_.requestInterruption();
-        gbaThread_.wait();
-    }
-
+    gbaThread_.Stop();
+    fpsTimer_.stop();
     gbaThread_.Quit();
 }
 
@@ -139,6 +182,8 @@ void MainWindow::SendKeyPresses() const
     // Select   -> Backspace
     // L        -> Q
     // R        -> E
+    //
+    // Hold Space to fast-forward
 
     if (pressedKeys_.contains(87)) gamepad.buttons_.Up = 0;
     if (pressedKeys_.contains(65)) gamepad.buttons_.Left = 0;
@@ -154,26 +199,35 @@ void MainWindow::SendKeyPresses() const
     if (pressedKeys_.contains(81)) gamepad.buttons_.L = 0;
     if (pressedKeys_.contains(69)) gamepad.buttons_.R = 0;
 
-    ::UpdateGamepad(gamepad);
+    ::UpdateGamepad(gbaThread_.Gba(), gamepad);
 }
 
 void MainWindow::UpdateWindowTitle()
 {
-    int frames = ::GetAndResetFrameCounter();
-    std::string newTitle = std::format("{} ({} fps)", romTitle_, frames);
+    uint64_t frames = latestFrameSequence_ - fpsFrameSequence_;
+    fpsFrameSequence_ = latestFrameSequence_;
+    Telemetry telemetry = ::GetTelemetry(gbaThread_.Gba());
+    std::string newTitle = std::format("{} ({} fps, {:.0f}% speed, {:.1f} ms/frame)",
+                                       romTitle_,
+                                       frames,
+                                       telemetry.speedRatio_ * 100.0,
+                                       telemetry.frameTime_ / 1'000'000.0);
     setWindowTitle(QString::fromStdString(newTitle));
 }
 
 void MainWindow::RefreshScreen()
 {
-    uint8_t* frameBuffer = ::GetRawFrameBuffer();
+    gbaThread_.AcknowledgeFrame();
 
-    if (frameBuffer != nullptr)
+    if (lowLatency_)
     {
-        SendKeyPresses();
-        auto image = QImage(frameBuffer, 240, 160, QImage::Format_RGB555);
-        image.rgbSwap();
-        lcd_.setPixmap(QPixmap::fromImage(image).scaled(lcd_.width(), lcd_.height()));
+        // Draw and swap immediately. Vsync is off in this mode, so the swap doesn't wait for the display.
+        lcd_.repaint();
+    }
+    else
+    {
+        // Repaints are coalesced, and the swap is throttled to the display's refresh rate
+        lcd_.update();
     }
 }
 
@@ -189,13 +243,7 @@ void MainWindow::LoadROM(fs::path romPath)
 {
     if (fs::exists(fs::path(romPath)))
     {
-        if (gbaThread_.isRunning())
-        {
-            gbaThread_.PauseAudioCallback();
-            gbaThread_.requestInterruption();
-            gbaThread_.wait();
-        }
-
+        gbaThread_.Stop();
         gbaThread_.LoadROM(romPath);
         romTitle_ = gbaThread_.RomTitle();
         setWindowTitle(QString::fromStdString(romTitle_));
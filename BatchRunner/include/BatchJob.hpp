@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/// @brief A change to the buttons being held, applied right after the given number of frames have been emulated.
+struct InputChange
+{
+    uint64_t frame_;
+    uint16_t keyinput_;  // KEYINPUT value, 0 means pressed
+};
+
+/// @brief Hashes of a single frame and of the audio produced while emulating it.
+struct FrameHashes
+{
+    uint64_t frame_;
+    uint64_t audio_;
+
+    bool operator==(FrameHashes const&) const = default;
+};
+
+/// @brief One ROM to run headless, along with what to feed it and what to expect from it.
+struct BatchJob
+{
+    fs::path romPath_;
+    uint64_t frames_;
+    std::vector<InputChange> input_;
+    std::vector<uint8_t> movie_;  // Input movie to play instead of input changes, or empty if none
+    std::optional<uint64_t> expectedFrameHash_;
+    std::optional<uint64_t> expectedAudioHash_;
+    fs::path goldenPath_;  // Hashes of every frame to compare against, or empty to only check the final hashes
+    bool directBoot_;  // Whether to skip the BIOS intro and start straight from the cartridge
+};
+
+/// @brief Outcome of running a BatchJob.
+struct BatchResult
+{
+    bool passed_;
+    std::string error_;
+    uint64_t framesRun_;
+    uint64_t frameHash_;
+    uint64_t audioHash_;
+    std::optional<uint64_t> firstMismatch_;  // First frame that didn't match the golden hashes. The job stops there.
+    double hostSeconds_;
+};
+
+/// @brief Parse a list of jobs. Each non-empty line not starting with '#' is one job, formatted as
+///
+///            <ROM path> <frames> [input=<path>] [movie=<path>] [frame_hash=<hex>] [audio_hash=<hex>] [golden=<path>]
+///            [boot=bios|direct]
+///
+///        Input files hold one InputChange per line as "<frame> <KEYINPUT in hex>". Movie files are input movies recorded with
+///        StartMovieRecording. A job can have one or the other. Relative paths are resolved from the directory of the file they
+///        appear in. Jobs run the BIOS intro unless boot=direct is given.
+/// @param jobFilePath Path to job list.
+/// @return Jobs in the order they were listed.
+/// @throws std::runtime_error if the job list or an input or movie file can't be read, or the job list has a malformed line.
+std::vector<BatchJob> ParseJobFile(fs::path jobFilePath);
+
+/// @brief Read a golden file. Each non-empty line not starting with '#' holds the hashes of one frame, in order from the first
+///        frame, as "<frame> <frame hash in hex> <audio hash in hex>".
+/// @param goldenPath Path to golden file.
+/// @return Hashes of each frame.
+/// @throws std::runtime_error if the file can't be read, has a malformed line, or skips a frame.
+std::vector<FrameHashes> ReadGoldenFile(fs::path goldenPath);
+
+/// @brief Write a golden file that can be read by ReadGoldenFile.
+/// @param goldenPath Path of golden file to create.
+/// @param hashes Hashes of each frame.
+/// @throws std::runtime_error if the file can't be written.
+void WriteGoldenFile(fs::path goldenPath, std::vector<FrameHashes> const& hashes);
+
+/// @brief Run a job on a new GBA as fast as possible. Every frame and audio sample is hashed, so two runs of the same job can be
+///        compared without storing their output. If the job has a golden file, each frame is also hashed on its own and
+///        compared against it, so that a mismatch points at the exact frame where output first changed.
+/// @param job Job to run.
+/// @param biosPath Path to GBA BIOS file.
+/// @param writeGolden Whether to record the job's golden file instead of comparing against it.
+/// @return Hashes and timing of the run, and whether it matched the job's expected hashes.
+BatchResult RunJob(BatchJob const& job, fs::path biosPath, bool writeGolden = false);
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+/// @brief Runs a batch of independent tasks across a fixed number of threads. Tasks are dealt out evenly up front, and a thread
+///        that finishes its own share steals from the others, so long jobs don't leave cores idle at the end of a batch.
+class WorkStealingPool
+{
+public:
+    using Task = std::function<void(size_t workerIndex)>;
+
+    /// @brief Create a pool.
+    /// @param threadCount Number of worker threads to run tasks on. 0 uses one thread per hardware thread.
+    explicit WorkStealingPool(size_t threadCount);
+
+    WorkStealingPool() = delete;
+    WorkStealingPool(WorkStealingPool const&) = delete;
+    WorkStealingPool& operator=(WorkStealingPool const&) = delete;
+
+    /// @brief Run every task and wait for them all to finish. Tasks must not throw.
+    /// @param tasks Tasks to run. Each is passed the index of the worker running it.
+    void Run(std::vector<Task> tasks);
+
+    /// @brief Get the number of worker threads.
+    /// @return Number of threads tasks are run on.
+    size_t ThreadCount() const { return queues_.size(); }
+
+private:
+    /// @brief Main loop of a worker thread. Runs tasks from its own queue, newest first, then steals the oldest tasks from other
+    ///        workers until every queue is empty.
+    /// @param workerIndex Index of this worker's queue.
+    void WorkerLoop(size_t workerIndex);
+
+    /// @brief Take the most recently queued task from a worker's own queue.
+    /// @param workerIndex Index of queue to pop from.
+    /// @return Index of task to run, if any are left.
+    std::optional<size_t> PopLocal(size_t workerIndex);
+
+    /// @brief Take the oldest queued task from another worker's queue.
+    /// @param workerIndex Index of the worker doing the stealing.
+    /// @return Index of task to run, if any are left in any queue.
+    std::optional<size_t> Steal(size_t workerIndex);
+
+    struct WorkerQueue
+    {
+        std::mutex lock_;
+        std::deque<size_t> taskIndices_;
+    };
+
+    std::vector<WorkerQueue> queues_;
+    std::vector<Task> tasks_;
+};
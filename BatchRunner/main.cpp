@@ -0,0 +1,95 @@
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <BatchJob.hpp>
+#include <WorkStealingPool.hpp>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+/// @brief Print one result as a tab separated line.
+/// @param job Job that was run.
+/// @param result Result of running it.
+void PrintResult(BatchJob const& job, BatchResult const& result)
+{
+    double fps = (result.hostSeconds_ > 0.0) ? (result.framesRun_ / result.hostSeconds_) : 0.0;
+
+    std::cout << (result.error_.empty() ? (result.passed_ ? "PASS" : "FAIL") : "ERROR") << '\t'
+              << job.romPath_.string() << '\t'
+              << std::dec << result.framesRun_ << '\t'
+              << std::hex << std::setw(16) << std::setfill('0') << result.frameHash_ << '\t'
+              << std::hex << std::setw(16) << std::setfill('0') << result.audioHash_ << '\t'
+              << std::dec << std::fixed << std::setprecision(3) << result.hostSeconds_ << '\t'
+              << std::setprecision(1) << fps << '\t';
+
+    if (result.firstMismatch_)
+    {
+        std::cout << *result.firstMismatch_;
+    }
+    else
+    {
+        std::cout << '-';
+    }
+
+    std::cout << '\t' << result.error_ << '\n';
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> args(argv + 1, argv + argc);
+    bool writeGolden = !args.empty() && (args[0] == "--write-golden");
+
+    if (writeGolden)
+    {
+        args.erase(args.begin());
+    }
+
+    if (args.empty() || (args.size() > 2))
+    {
+        std::cerr << "Usage: " << argv[0] << " [--write-golden] <job file> [thread count]\n";
+        return EXIT_FAILURE;
+    }
+
+    std::vector<BatchJob> jobs;
+
+    try
+    {
+        jobs = ParseJobFile(args[0]);
+    }
+    catch (std::exception const& error)
+    {
+        std::cerr << error.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    WorkStealingPool pool((args.size() == 2) ? std::stoul(args[1]) : 0);
+    std::vector<BatchResult> results(jobs.size());
+    std::vector<WorkStealingPool::Task> tasks;
+    tasks.reserve(jobs.size());
+
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        tasks.push_back([&jobs, &results, writeGolden, i](size_t) { results[i] = RunJob(jobs[i], "", writeGolden); });
+    }
+
+    pool.Run(std::move(tasks));
+
+    std::cout << "status\trom\tframes\tframe_hash\taudio_hash\tseconds\tfps\tfirst_mismatch\terror\n";
+    bool allPassed = true;
+
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        PrintResult(jobs[i], results[i]);
+        allPassed &= results[i].passed_;
+    }
+
+    return allPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
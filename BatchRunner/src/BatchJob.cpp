@@ -0,0 +1,359 @@
+#include <BatchJob.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <AdvancedBoy.hpp>
+#include <Gamepad.hpp>
+#include <PixelFormat.hpp>
+
+namespace
+{
+constexpr uint64_t FNV_OFFSET_BASIS = 0xCBF2'9CE4'8422'2325;
+constexpr uint64_t FNV_PRIME = 0x0000'0100'0000'01B3;
+constexpr size_t FRAME_SIZE_IN_BYTES = 240 * 160 * BytesPerPixel(PixelFormat::BGR555);
+
+/// @brief Fold a block of bytes into a running FNV-1a hash.
+/// @param hash Hash to update.
+/// @param data Bytes to hash.
+/// @param length Number of bytes to hash.
+void HashBytes(uint64_t& hash, void const* data, size_t length)
+{
+    auto bytes = static_cast<uint8_t const*>(data);
+
+    for (size_t i = 0; i < length; ++i)
+    {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+}
+
+/// @brief Resolve a path from a job list or input file relative to the directory that file is in.
+/// @param path Path as written in the file.
+/// @param listPath Path of the file it was written in.
+/// @return Resolved path.
+fs::path ResolvePath(std::string const& path, fs::path const& listPath)
+{
+    fs::path resolved = path;
+    return resolved.is_absolute() ? resolved : (listPath.parent_path() / resolved);
+}
+
+/// @brief Parse an input file.
+/// @param inputPath Path to input file.
+/// @return Input changes sorted by frame.
+std::vector<InputChange> ParseInputFile(fs::path inputPath)
+{
+    std::ifstream inputFile(inputPath);
+
+    if (inputFile.fail())
+    {
+        throw std::runtime_error("Unable to open input file " + inputPath.string());
+    }
+
+    std::vector<InputChange> input;
+    std::string line;
+    size_t lineNumber = 0;
+
+    while (std::getline(inputFile, line))
+    {
+        ++lineNumber;
+
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+
+        std::istringstream fields(line);
+        InputChange change;
+
+        if (!(fields >> change.frame_ >> std::hex >> change.keyinput_))
+        {
+            throw std::runtime_error("Malformed line " + std::to_string(lineNumber) + " in " + inputPath.string());
+        }
+
+        input.push_back(change);
+    }
+
+    std::stable_sort(input.begin(), input.end(), [](InputChange const& a, InputChange const& b) { return a.frame_ < b.frame_; });
+    return input;
+}
+
+/// @brief Read an input movie recorded with StartMovieRecording.
+/// @param moviePath Path to movie file.
+/// @return Contents of movie.
+std::vector<uint8_t> ReadMovieFile(fs::path moviePath)
+{
+    std::ifstream movieFile(moviePath, std::ios::binary);
+
+    if (movieFile.fail())
+    {
+        throw std::runtime_error("Unable to open movie file " + moviePath.string());
+    }
+
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(movieFile), std::istreambuf_iterator<char>());
+}
+}  // namespace
+
+std::vector<BatchJob> ParseJobFile(fs::path jobFilePath)
+{
+    std::ifstream jobFile(jobFilePath);
+
+    if (jobFile.fail())
+    {
+        throw std::runtime_error("Unable to open job file " + jobFilePath.string());
+    }
+
+    std::vector<BatchJob> jobs;
+    std::string line;
+    size_t lineNumber = 0;
+
+    while (std::getline(jobFile, line))
+    {
+        ++lineNumber;
+
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+
+        std::istringstream fields(line);
+        std::string romPath;
+        BatchJob job;
+        job.directBoot_ = false;
+
+        if (!(fields >> romPath >> job.frames_))
+        {
+            throw std::runtime_error("Malformed line " + std::to_string(lineNumber) + " in " + jobFilePath.string());
+        }
+
+        job.romPath_ = ResolvePath(romPath, jobFilePath);
+        std::string option;
+
+        while (fields >> option)
+        {
+            size_t separator = option.find('=');
+            std::string key = option.substr(0, separator);
+            std::string value = (separator == std::string::npos) ? "" : option.substr(separator + 1);
+
+            if (value.empty())
+            {
+                throw std::runtime_error("Option '" + option + "' has no value on line " + std::to_string(lineNumber));
+            }
+
+            if (key == "input")
+            {
+                job.input_ = ParseInputFile(ResolvePath(value, jobFilePath));
+            }
+            else if (key == "frame_hash")
+            {
+                job.expectedFrameHash_ = std::stoull(value, nullptr, 16);
+            }
+            else if (key == "audio_hash")
+            {
+                job.expectedAudioHash_ = std::stoull(value, nullptr, 16);
+            }
+            else if (key == "golden")
+            {
+                job.goldenPath_ = ResolvePath(value, jobFilePath);
+            }
+            else if (key == "movie")
+            {
+                job.movie_ = ReadMovieFile(ResolvePath(value, jobFilePath));
+            }
+            else if (key == "boot")
+            {
+                if ((value != "bios") && (value != "direct"))
+                {
+                    throw std::runtime_error("Unknown boot mode '" + value + "' on line " + std::to_string(lineNumber));
+                }
+
+                job.directBoot_ = (value == "direct");
+            }
+            else
+            {
+                throw std::runtime_error("Unknown option '" + key + "' on line " + std::to_string(lineNumber));
+            }
+        }
+
+        if (!job.input_.empty() && !job.movie_.empty())
+        {
+            throw std::runtime_error("Job on line " + std::to_string(lineNumber) + " has both an input file and a movie");
+        }
+
+        jobs.push_back(std::move(job));
+    }
+
+    return jobs;
+}
+
+std::vector<FrameHashes> ReadGoldenFile(fs::path goldenPath)
+{
+    std::ifstream goldenFile(goldenPath);
+
+    if (goldenFile.fail())
+    {
+        throw std::runtime_error("Unable to open golden file " + goldenPath.string());
+    }
+
+    std::vector<FrameHashes> hashes;
+    std::string line;
+    size_t lineNumber = 0;
+
+    while (std::getline(goldenFile, line))
+    {
+        ++lineNumber;
+
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+
+        std::istringstream fields(line);
+        uint64_t frame;
+        FrameHashes frameHashes;
+
+        if (!(fields >> frame >> std::hex >> frameHashes.frame_ >> frameHashes.audio_) || (frame != hashes.size()))
+        {
+            throw std::runtime_error("Malformed line " + std::to_string(lineNumber) + " in " + goldenPath.string());
+        }
+
+        hashes.push_back(frameHashes);
+    }
+
+    return hashes;
+}
+
+void WriteGoldenFile(fs::path goldenPath, std::vector<FrameHashes> const& hashes)
+{
+    std::ofstream goldenFile(goldenPath, std::ios::trunc);
+
+    if (goldenFile.fail())
+    {
+        throw std::runtime_error("Unable to create golden file " + goldenPath.string());
+    }
+
+    goldenFile << "# <frame> <frame hash> <audio hash>\n" << std::setfill('0');
+
+    for (size_t frame = 0; frame < hashes.size(); ++frame)
+    {
+        goldenFile << std::dec << frame << ' '
+                   << std::hex << std::setw(16) << hashes[frame].frame_ << ' '
+                   << std::hex << std::setw(16) << hashes[frame].audio_ << '\n';
+    }
+
+    if (goldenFile.fail())
+    {
+        throw std::runtime_error("Unable to write golden file " + goldenPath.string());
+    }
+}
+
+BatchResult RunJob(BatchJob const& job, fs::path biosPath, bool writeGolden)
+{
+    BatchResult result = {false, "", 0, FNV_OFFSET_BASIS, FNV_OFFSET_BASIS, std::nullopt, 0.0};
+    GbaHandle gba = nullptr;
+
+    try
+    {
+        bool checkFrames = !job.goldenPath_.empty();
+        std::vector<FrameHashes> golden;
+
+        if (checkFrames && !writeGolden)
+        {
+            golden = ReadGoldenFile(job.goldenPath_);
+        }
+        else if (checkFrames && writeGolden)
+        {
+            golden.reserve(job.frames_);
+        }
+
+        gba = ::Initialize(biosPath);
+
+        // Every core is already busy with its own job
+        ::SetThreadedRendering(gba, false);
+        ::SetDirectBoot(gba, job.directBoot_);
+
+        if (!::InsertCartridge(gba, job.romPath_))
+        {
+            throw std::runtime_error("Unable to load ROM");
+        }
+
+        if (!job.movie_.empty() && !::StartMoviePlayback(gba, job.movie_))
+        {
+            throw std::runtime_error("Movie is invalid or was recorded on a different ROM");
+        }
+
+        std::vector<float> samples;
+        auto nextInput = job.input_.begin();
+        auto startTime = std::chrono::steady_clock::now();
+
+        for (; result.framesRun_ < job.frames_; ++result.framesRun_)
+        {
+            if ((nextInput != job.input_.end()) && (nextInput->frame_ <= result.framesRun_))
+            {
+                Gamepad gamepad;
+
+                while ((nextInput != job.input_.end()) && (nextInput->frame_ <= result.framesRun_))
+                {
+                    gamepad.halfword_ = nextInput->keyinput_;
+                    ++nextInput;
+                }
+
+                ::UpdateGamepad(gba, gamepad);
+            }
+
+            samples.clear();
+            ::RunFrames(gba, 1, &samples);
+            HashBytes(result.audioHash_, samples.data(), samples.size() * sizeof(float));
+
+            Frame frame = ::AcquireLatestFrame(gba);
+            HashBytes(result.frameHash_, frame.pixels_, FRAME_SIZE_IN_BYTES);
+
+            if (checkFrames)
+            {
+                FrameHashes frameHashes = {FNV_OFFSET_BASIS, FNV_OFFSET_BASIS};
+                HashBytes(frameHashes.frame_, frame.pixels_, FRAME_SIZE_IN_BYTES);
+                HashBytes(frameHashes.audio_, samples.data(), samples.size() * sizeof(float));
+
+                if (writeGolden)
+                {
+                    golden.push_back(frameHashes);
+                }
+                else if ((result.framesRun_ >= golden.size()) || (golden[result.framesRun_] != frameHashes))
+                {
+                    // Nothing after the first difference can be trusted, so don't spend time emulating it
+                    result.firstMismatch_ = result.framesRun_++;
+                    break;
+                }
+            }
+        }
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+        result.hostSeconds_ = elapsed.count();
+
+        if (checkFrames && writeGolden)
+        {
+            WriteGoldenFile(job.goldenPath_, golden);
+        }
+
+        result.passed_ = (!job.expectedFrameHash_ || (*job.expectedFrameHash_ == result.frameHash_)) &&
+                         (!job.expectedAudioHash_ || (*job.expectedAudioHash_ == result.audioHash_)) &&
+                         !result.firstMismatch_;
+    }
+    catch (std::exception const& error)
+    {
+        result.error_ = error.what();
+    }
+
+    ::PowerOff(gba);
+    return result;
+}
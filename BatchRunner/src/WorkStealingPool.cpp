@@ -0,0 +1,89 @@
+#include <WorkStealingPool.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+WorkStealingPool::WorkStealingPool(size_t threadCount) :
+    queues_(threadCount != 0 ? threadCount : std::max(1U, std::thread::hardware_concurrency()))
+{
+}
+
+void WorkStealingPool::Run(std::vector<Task> tasks)
+{
+    tasks_ = std::move(tasks);
+
+    for (size_t i = 0; i < tasks_.size(); ++i)
+    {
+        queues_[i % queues_.size()].taskIndices_.push_back(i);
+    }
+
+    {
+        std::vector<std::jthread> workers;
+        workers.reserve(queues_.size());
+
+        for (size_t i = 0; i < queues_.size(); ++i)
+        {
+            workers.emplace_back(&WorkStealingPool::WorkerLoop, this, i);
+        }
+    }
+
+    tasks_.clear();
+}
+
+void WorkStealingPool::WorkerLoop(size_t workerIndex)
+{
+    while (true)
+    {
+        auto taskIndex = PopLocal(workerIndex);
+
+        if (!taskIndex)
+        {
+            taskIndex = Steal(workerIndex);
+        }
+
+        if (!taskIndex)
+        {
+            // No task is ever queued once the batch has started, so empty queues mean the batch is done
+            return;
+        }
+
+        tasks_[*taskIndex](workerIndex);
+    }
+}
+
+std::optional<size_t> WorkStealingPool::PopLocal(size_t workerIndex)
+{
+    WorkerQueue& queue = queues_[workerIndex];
+    std::lock_guard<std::mutex> lock(queue.lock_);
+
+    if (queue.taskIndices_.empty())
+    {
+        return {};
+    }
+
+    size_t taskIndex = queue.taskIndices_.back();
+    queue.taskIndices_.pop_back();
+    return taskIndex;
+}
+
+std::optional<size_t> WorkStealingPool::Steal(size_t workerIndex)
+{
+    for (size_t offset = 1; offset < queues_.size(); ++offset)
+    {
+        WorkerQueue& victim = queues_[(workerIndex + offset) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.lock_);
+
+        if (!victim.taskIndices_.empty())
+        {
+            size_t taskIndex = victim.taskIndices_.front();
+            victim.taskIndices_.pop_front();
+            return taskIndex;
+        }
+    }
+
+    return {};
+}
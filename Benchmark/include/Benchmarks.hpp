@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/// @brief Outcome of one benchmark.
+struct BenchmarkResult
+{
+    std::string name_;
+    std::string kind_;  // "micro" or "macro"
+    uint64_t iterations_;  // Operations for microbenchmarks, emulated frames for macrobenchmarks
+    double seconds_;
+};
+
+/// @brief A microbenchmark body. Each call performs a batch of operations.
+/// @return Number of operations performed, and a value derived from their results so that they can't be optimized away.
+using MicroBody = std::function<std::pair<uint64_t, uint64_t>()>;
+
+/// @brief Call a microbenchmark body repeatedly until enough time has passed to get a stable measurement.
+/// @param name Name of benchmark.
+/// @param body Batch of operations to time.
+/// @return Total operations performed and time taken.
+BenchmarkResult RunMicroBenchmark(std::string name, MicroBody const& body);
+
+/// @brief Run every microbenchmark whose name contains a filter.
+/// @param filter Text that a benchmark's name must contain to run. Empty runs everything.
+/// @param results Vector to append each result to.
+void RunMicroBenchmarks(std::string const& filter, std::vector<BenchmarkResult>& results);
+
+/// @brief Run a ROM headless on a new GBA as fast as possible, without audio.
+/// @param romPath Path to ROM.
+/// @param frames Number of frames to time, after a short warm up.
+/// @return Number of frames run and time taken.
+/// @throws std::runtime_error if the ROM can't be loaded.
+BenchmarkResult RunMacroBenchmark(fs::path romPath, int frames);
+
+/// @brief Print a result as a single line of JSON.
+/// @param result Result to print.
+void PrintResult(BenchmarkResult const& result);
@@ -0,0 +1,82 @@
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <Benchmarks.hpp>
+
+namespace
+{
+constexpr int DEFAULT_MACRO_FRAMES = 3600;
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    std::string filter;
+    int frames = DEFAULT_MACRO_FRAMES;
+    bool runMicro = true;
+    std::vector<fs::path> romPaths;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+
+        if (arg.starts_with("--filter="))
+        {
+            filter = arg.substr(9);
+        }
+        else if (arg.starts_with("--frames="))
+        {
+            frames = std::stoi(arg.substr(9));
+        }
+        else if (arg == "--macro-only")
+        {
+            runMicro = false;
+        }
+        else if (arg.starts_with("--"))
+        {
+            std::cerr << "Usage: " << argv[0] << " [--filter=<text>] [--frames=<count>] [--macro-only] [ROM...]\n";
+            return EXIT_FAILURE;
+        }
+        else
+        {
+            romPaths.push_back(arg);
+        }
+    }
+
+    std::vector<BenchmarkResult> results;
+    bool allRan = true;
+
+    try
+    {
+        if (runMicro)
+        {
+            RunMicroBenchmarks(filter, results);
+        }
+    }
+    catch (std::exception const& error)
+    {
+        std::cerr << error.what() << '\n';
+        allRan = false;
+    }
+
+    for (fs::path const& romPath : romPaths)
+    {
+        try
+        {
+            results.push_back(RunMacroBenchmark(romPath, frames));
+        }
+        catch (std::exception const& error)
+        {
+            std::cerr << error.what() << '\n';
+            allRan = false;
+        }
+    }
+
+    for (BenchmarkResult const& result : results)
+    {
+        PrintResult(result);
+    }
+
+    return allRan ? EXIT_SUCCESS : EXIT_FAILURE;
+}
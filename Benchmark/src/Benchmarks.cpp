@@ -0,0 +1,73 @@
+#include <Benchmarks.hpp>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+
+namespace
+{
+// Each microbenchmark runs for at least this long, after a warm up batch
+constexpr double MIN_MICRO_SECONDS = 0.5;
+
+// Results of every batch are folded into this so that the compiler has to compute them
+volatile uint64_t benchmarkSink = 0;
+
+/// @brief Escape a string for use in JSON.
+/// @param text String to escape.
+/// @return Escaped string, without surrounding quotes.
+std::string EscapeJson(std::string const& text)
+{
+    std::string escaped;
+
+    for (char c : text)
+    {
+        if ((c == '"') || (c == '\\'))
+        {
+            escaped += '\\';
+        }
+
+        escaped += c;
+    }
+
+    return escaped;
+}
+}  // namespace
+
+BenchmarkResult RunMicroBenchmark(std::string name, MicroBody const& body)
+{
+    benchmarkSink = benchmarkSink + body().second;
+
+    BenchmarkResult result = {std::move(name), "micro", 0, 0.0};
+    auto startTime = std::chrono::steady_clock::now();
+
+    while (result.seconds_ < MIN_MICRO_SECONDS)
+    {
+        auto [operations, checksum] = body();
+        result.iterations_ += operations;
+        benchmarkSink = benchmarkSink + checksum;
+        result.seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    }
+
+    return result;
+}
+
+void PrintResult(BenchmarkResult const& result)
+{
+    double rate = (result.seconds_ > 0.0) ? (result.iterations_ / result.seconds_) : 0.0;
+
+    std::cout << "{\"name\":\"" << EscapeJson(result.name_) << "\","
+              << "\"kind\":\"" << result.kind_ << "\","
+              << "\"iterations\":" << result.iterations_ << ','
+              << "\"seconds\":" << result.seconds_ << ',';
+
+    if (result.kind_ == "micro")
+    {
+        double nanoseconds = (result.iterations_ > 0) ? (result.seconds_ * 1e9 / result.iterations_) : 0.0;
+        std::cout << "\"ns_per_op\":" << nanoseconds << ",\"ops_per_second\":" << rate << "}\n";
+    }
+    else
+    {
+        std::cout << "\"fps\":" << rate << "}\n";
+    }
+}
@@ -0,0 +1,31 @@
+#include <Benchmarks.hpp>
+#include <chrono>
+#include <filesystem>
+#include <stdexcept>
+#include <AdvancedBoy.hpp>
+
+namespace
+{
+// Frames run before timing starts, so that the BIOS intro and game start-up don't dominate short runs
+constexpr int WARM_UP_FRAMES = 60;
+}  // namespace
+
+BenchmarkResult RunMacroBenchmark(fs::path romPath, int frames)
+{
+    GbaHandle gba = ::Initialize("");
+
+    if (!::InsertCartridge(gba, romPath))
+    {
+        ::PowerOff(gba);
+        throw std::runtime_error("Unable to load ROM " + romPath.string());
+    }
+
+    ::RunFrames(gba, WARM_UP_FRAMES);
+
+    auto startTime = std::chrono::steady_clock::now();
+    ::RunFrames(gba, frames);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+
+    ::PowerOff(gba);
+    return {romPath.filename().string(), "macro", static_cast<uint64_t>(frames), elapsed.count()};
+}
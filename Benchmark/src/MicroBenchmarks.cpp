@@ -0,0 +1,298 @@
+#include <Benchmarks.hpp>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <Audio/APU.hpp>
+#include <CPU/ArmInstructions.hpp>
+#include <CPU/ThumbInstructions.hpp>
+#include <DMA/DmaChannel.hpp>
+#include <Graphics/FrameBuffer.hpp>
+#include <Graphics/Registers.hpp>
+#include <Logging/Logging.hpp>
+#include <System/EventScheduler.hpp>
+#include <System/GameBoyAdvance.hpp>
+#include <System/SystemControl.hpp>
+#include <Utilities/MemoryUtilities.hpp>
+
+namespace
+{
+constexpr size_t OPCODE_COUNT = 4096;
+constexpr int SCANLINES_PER_BATCH = 160;
+constexpr int EVENTS_PER_BATCH = 4096;
+constexpr uint32_t DMA3_ADDR = 0x0400'00D4;
+
+/// @brief Small deterministic generator, so that every run benchmarks the same inputs.
+class Lcg
+{
+public:
+    uint32_t Next() { state_ = (state_ * 1'664'525) + 1'013'904'223; return state_; }
+
+private:
+    uint32_t state_ = 0x1234'5678;
+};
+
+/// @brief Benchmark decoding random ARM or THUMB opcodes into handlers.
+/// @param thumb Whether to decode THUMB opcodes instead of ARM.
+/// @return Benchmark body.
+MicroBody DecodeBenchmark(bool thumb)
+{
+    auto opcodes = std::make_shared<std::vector<uint32_t>>(OPCODE_COUNT);
+    Lcg lcg;
+
+    for (uint32_t& opcode : *opcodes)
+    {
+        opcode = thumb ? (lcg.Next() >> 16) : lcg.Next();
+    }
+
+    return [opcodes, thumb]()
+    {
+        uint64_t checksum = 0;
+
+        for (uint32_t opcode : *opcodes)
+        {
+            CPU::InstructionHandler handler = thumb ? CPU::THUMB::LookupHandler(static_cast<uint16_t>(opcode)) :
+                                                      CPU::ARM::LookupHandler(opcode);
+            checksum += reinterpret_cast<uintptr_t>(handler);
+        }
+
+        return std::make_pair(static_cast<uint64_t>(opcodes->size()), checksum);
+    };
+}
+
+/// @brief Benchmark firing events that reschedule themselves at different rates, like timers and the PPU do.
+/// @return Benchmark body.
+MicroBody SchedulerFireBenchmark()
+{
+    auto scheduler = std::make_shared<EventScheduler>();
+    constexpr std::array<std::pair<EventType, int>, 6> periods = {{
+        {EventType::Timer0Overflow, 64},
+        {EventType::Timer1Overflow, 256},
+        {EventType::Timer2Overflow, 1024},
+        {EventType::HBlank, 1232},
+        {EventType::VBlank, 280'896},
+        {EventType::SampleAPU, 512}
+    }};
+
+    for (auto [eventType, period] : periods)
+    {
+        EventScheduler* schedulerPtr = scheduler.get();
+        scheduler->RegisterEvent(eventType, [schedulerPtr, eventType, period](int extraCycles)
+        {
+            schedulerPtr->ScheduleEvent(eventType, period - extraCycles);
+        });
+        scheduler->ScheduleEvent(eventType, period);
+    }
+
+    return [scheduler]()
+    {
+        for (int i = 0; i < EVENTS_PER_BATCH; ++i)
+        {
+            scheduler->SkipToNextEvent();
+        }
+
+        return std::make_pair(static_cast<uint64_t>(EVENTS_PER_BATCH), scheduler->TotalCycles());
+    };
+}
+
+/// @brief Benchmark scheduling and unscheduling events without firing them, like games do when reprogramming timers.
+/// @return Benchmark body.
+MicroBody SchedulerRescheduleBenchmark()
+{
+    auto scheduler = std::make_shared<EventScheduler>();
+    auto delays = std::make_shared<std::vector<uint32_t>>(EVENTS_PER_BATCH);
+    Lcg lcg;
+
+    for (uint32_t& delay : *delays)
+    {
+        delay = lcg.Next();
+    }
+
+    return [scheduler, delays]()
+    {
+        for (uint32_t delay : *delays)
+        {
+            auto eventType = static_cast<EventType>(delay % static_cast<uint32_t>(EventType::COUNT));
+
+            if (delay & 0x8000'0000)
+            {
+                scheduler->UnscheduleEvent(eventType);
+            }
+            else
+            {
+                scheduler->ScheduleEvent(eventType, (delay >> 8) & 0xFFFF);
+            }
+        }
+
+        return std::make_pair(static_cast<uint64_t>(delays->size()), scheduler->NextEventCycle());
+    };
+}
+
+/// @brief Layers and blending used by a scanline composition benchmark.
+struct ScanlineSetup
+{
+    int bgLayers_;
+    bool sprites_;
+    uint16_t bldcnt_;
+    uint16_t bldalpha_;
+    uint16_t bldy_;
+};
+
+/// @brief Benchmark composing scanlines from a set of layers.
+/// @param setup Which layers are drawn and how they're blended.
+/// @return Benchmark body.
+MicroBody ScanlineBenchmark(ScanlineSetup const& setup)
+{
+    auto frameBuffer = std::make_shared<Graphics::FrameBuffer>();
+    frameBuffer->Reset();
+    frameBuffer->InitializeWindow({{true, true, true, true}, true, true});
+
+    // Every scanline draws the same random pixels, a quarter of which are transparent
+    auto pixels = std::make_shared<std::vector<Graphics::Pixel>>();
+    Lcg lcg;
+
+    for (int layer = 0; layer <= setup.bgLayers_; ++layer)
+    {
+        bool obj = (layer == setup.bgLayers_);
+
+        if (obj && !setup.sprites_)
+        {
+            break;
+        }
+
+        auto src = obj ? Graphics::PixelSrc::OBJ : static_cast<Graphics::PixelSrc>(static_cast<int>(Graphics::PixelSrc::BG0) + layer);
+
+        for (int dot = 0; dot < Graphics::LCD_WIDTH; ++dot)
+        {
+            uint32_t random = lcg.Next();
+            pixels->emplace_back(src, random & 0x7FFF, (random >> 16) & 0x03, (random >> 24) < 0x40, obj && (random & 0x0100'0000));
+        }
+    }
+
+    Graphics::BLDCNT bldcnt;
+    Graphics::BLDALPHA bldalpha;
+    Graphics::BLDY bldy;
+    bldcnt.value = setup.bldcnt_;
+    bldalpha.value = setup.bldalpha_;
+    bldy.value = setup.bldy_;
+
+    return [frameBuffer, pixels, bldcnt, bldalpha, bldy]()
+    {
+        for (int scanline = 0; scanline < SCANLINES_PER_BATCH; ++scanline)
+        {
+            for (size_t i = 0; i < pixels->size(); ++i)
+            {
+                frameBuffer->PushPixel((*pixels)[i], i % Graphics::LCD_WIDTH);
+            }
+
+            frameBuffer->RenderScanline(0x1234, false, bldcnt, bldalpha, bldy);
+        }
+
+        frameBuffer->PublishFrame(true);
+        return std::make_pair(static_cast<uint64_t>(SCANLINES_PER_BATCH), frameBuffer->AcquireFrame().sequence_);
+    };
+}
+
+/// @brief Benchmark mixing audio samples with every PSG channel playing.
+/// @return Benchmark body.
+MicroBody ApuSampleBenchmark()
+{
+    // The APU only schedules its own sampling events, so each event skipped to is one sample
+    auto scheduler = std::make_shared<EventScheduler>();
+    auto apu = std::make_shared<Audio::APU>(*scheduler);
+    apu->Reset();
+    apu->SetOutputMode(Audio::OutputMode::Discard);
+
+    apu->WriteReg(0x0400'0084, 0x0080, AccessSize::HALFWORD);  // SOUNDCNT_X: master enable
+    apu->WriteReg(0x0400'0080, 0xFF77, AccessSize::HALFWORD);  // SOUNDCNT_L: all channels on both sides at full volume
+    apu->WriteReg(0x0400'0082, 0x0002, AccessSize::HALFWORD);  // SOUNDCNT_H: full PSG volume
+    apu->WriteReg(0x0400'0062, 0xF080, AccessSize::HALFWORD);  // Channel 1 envelope and duty
+    apu->WriteReg(0x0400'0064, 0x8700, AccessSize::HALFWORD);  // Channel 1 trigger
+    apu->WriteReg(0x0400'0068, 0xF040, AccessSize::HALFWORD);  // Channel 2 envelope and duty
+    apu->WriteReg(0x0400'006C, 0x8600, AccessSize::HALFWORD);  // Channel 2 trigger
+    apu->WriteReg(0x0400'0070, 0x0080, AccessSize::HALFWORD);  // Channel 3 playback on
+    apu->WriteReg(0x0400'0072, 0x2000, AccessSize::HALFWORD);  // Channel 3 full volume
+    apu->WriteReg(0x0400'0074, 0x8400, AccessSize::HALFWORD);  // Channel 3 trigger
+    apu->WriteReg(0x0400'0078, 0xF000, AccessSize::HALFWORD);  // Channel 4 envelope
+    apu->WriteReg(0x0400'007C, 0x8011, AccessSize::HALFWORD);  // Channel 4 trigger
+
+    return [scheduler, apu]()
+    {
+        for (int i = 0; i < EVENTS_PER_BATCH; ++i)
+        {
+            scheduler->SkipToNextEvent();
+        }
+
+        return std::make_pair(static_cast<uint64_t>(EVENTS_PER_BATCH), scheduler->TotalCycles());
+    };
+}
+
+/// @brief Parts of a GBA needed to run a DMA channel on its own.
+struct DmaBench
+{
+    DmaBench() :
+        gba_(std::make_unique<GameBoyAdvance>("")),
+        log_(scheduler_),
+        systemControl_(scheduler_, log_),
+        channel_(3, InterruptType::DMA3, *gba_, systemControl_)
+    {
+        // An empty Game Pak so that the channel can check for EEPROM accesses
+        gba_->LoadGamePak("");
+    }
+
+    std::unique_ptr<GameBoyAdvance> gba_;
+    EventScheduler scheduler_;
+    Logging::LogManager log_;
+    SystemControl systemControl_;
+    DmaChannel channel_;
+};
+
+/// @brief Benchmark immediate DMA transfers through the bulk copy path.
+/// @param src Source address.
+/// @param dest Destination address.
+/// @param control DMA control and word count.
+/// @return Benchmark body.
+MicroBody DmaBenchmark(uint32_t src, uint32_t dest, uint32_t control)
+{
+    auto bench = std::make_shared<DmaBench>();
+
+    return [bench, src, dest, control]()
+    {
+        bench->channel_.WriteReg(DMA3_ADDR, src, AccessSize::WORD);
+        bench->channel_.WriteReg(DMA3_ADDR + 4, dest, AccessSize::WORD);
+        bench->channel_.WriteReg(DMA3_ADDR + 8, control, AccessSize::WORD);
+        int cycles = bench->channel_.Execute();
+        return std::make_pair(static_cast<uint64_t>(1), static_cast<uint64_t>(cycles));
+    };
+}
+}  // namespace
+
+void RunMicroBenchmarks(std::string const& filter, std::vector<BenchmarkResult>& results)
+{
+    std::vector<std::pair<std::string, std::function<MicroBody()>>> benchmarks = {
+        {"arm_decode", []() { return DecodeBenchmark(false); }},
+        {"thumb_decode", []() { return DecodeBenchmark(true); }},
+        {"scheduler_fire", SchedulerFireBenchmark},
+        {"scheduler_reschedule", SchedulerRescheduleBenchmark},
+        {"scanline_backdrop", []() { return ScanlineBenchmark({0, false, 0x0000, 0x0000, 0x0000}); }},
+        {"scanline_4bg", []() { return ScanlineBenchmark({4, false, 0x0000, 0x0000, 0x0000}); }},
+        {"scanline_4bg_obj", []() { return ScanlineBenchmark({4, true, 0x0000, 0x0000, 0x0000}); }},
+        {"scanline_4bg_obj_alpha", []() { return ScanlineBenchmark({4, true, 0x3F5F, 0x0808, 0x0000}); }},
+        {"scanline_4bg_obj_brighten", []() { return ScanlineBenchmark({4, true, 0x009F, 0x0000, 0x0008}); }},
+        {"apu_sample", ApuSampleBenchmark},
+        {"dma_32kb_ewram_to_vram", []() { return DmaBenchmark(0x0200'0000, 0x0600'0000, 0x8400'2000); }},
+        {"dma_32kb_fill_iwram_to_vram", []() { return DmaBenchmark(0x0300'0000, 0x0600'8000, 0x8500'2000); }},
+        {"dma_1kb_halfword_ewram_to_pram", []() { return DmaBenchmark(0x0200'0000, 0x0500'0000, 0x8000'0200); }}
+    };
+
+    for (auto const& [name, createBody] : benchmarks)
+    {
+        if (name.find(filter) != std::string::npos)
+        {
+            results.push_back(RunMicroBenchmark(name, createBody()));
+        }
+    }
+}
@@ -1,62 +1,495 @@
 #pragma once
 
 #include <Gamepad.hpp>
+#include <PixelFormat.hpp>
 #include <cstdint>
 #include <filesystem>
 #include <functional>
 #include <string>
+#include <vector>
 
 namespace fs = std::filesystem;
 
-/// @brief Initialize the GBA before use.
+class GameBoyAdvance;
+
+/// @brief Handle to an emulated GBA. Every GBA owns all of its state, so any number of them can run in the same process at once,
+///        each on its own thread.
+typedef GameBoyAdvance* GbaHandle;
+
+/// @brief Create a new GBA.
 /// @param[in] biosPath Path to GBA BIOS file.
-/// @param[in] refreshScreenCallback Function callback to use when screen is ready to be refreshed.
-void Initialize(fs::path biosPath);
+/// @return Handle to the new GBA. Must be released with PowerOff.
+GbaHandle Initialize(fs::path biosPath);
+
+/// @brief Create a new GBA in the same state as an existing one, for branching one state into many that run independently, such
+///        as when searching or fuzzing inputs. BIOS and ROM data are shared with the original instead of being loaded again, so
+///        each clone only costs its own memory and one state copy. Use GetTelemetry to see how much that is. A clone's backup
+///        media is never written to a save file. Given the same input, a clone produces the same frames and audio as the
+///        original. It keeps the original's BIOS call, direct boot, and audio settings, renders on the thread that
+///        runs it, and everything else, including pixel format and callbacks, starts out at its default. Clones can be cloned
+///        again, and can outlive the GBA they were cloned from.
+/// @param[in] gba Handle of GBA to clone. Not changed, other than reusing a buffer to hold its state.
+/// @return Handle to the new GBA. Must be released with PowerOff.
+GbaHandle Clone(GbaHandle gba);
+
+/// @brief Choose whether scanlines are composed on a separate render thread instead of the emulation thread. Enabled by default
+///        on machines with more than one hardware thread. Both options produce identical frames.
+/// @param[in] gba Handle returned by Initialize.
+/// @param[in] enabled Whether to render on a separate thread.
+void SetThreadedRendering(GbaHandle gba, bool enabled);
+
+/// @brief Choose whether the most frequently called BIOS functions run as native code instead of being executed from the BIOS.
+///        Covers Div, DivArm, Sqrt, CpuSet, CpuFastSet, BgAffineSet, ObjAffineSet, and the LZ77, Huffman, and run length
+///        decompression functions. Their results match the BIOS, and the cycles they take are charged approximately, so timing
+///        sensitive code may behave slightly differently. Disabled by default. Can be changed at any time, such as to compare
+///        against real BIOS execution.
+/// @param[in] gba Handle returned by Initialize.
+/// @param[in] enabled Whether to run supported BIOS functions as native code.
+void SetBiosHle(GbaHandle gba, bool enabled);
+
+/// @brief Choose whether to skip the BIOS intro and boot straight into the cartridge. Instead of running the intro, the CPU, I/O
+///        registers, and BIOS open bus are set to the values the intro leaves behind, and execution starts at 0x0800'0000.
+///        Takes effect the next time a cartridge is inserted or the GBA is reset, such as when starting a movie. Movies must be
+///        played back with the same setting they were recorded with. Disabled by default.
+/// @param[in] gba Handle returned by Initialize.
+/// @param[in] enabled Whether to boot directly into the cartridge.
+void SetDirectBoot(GbaHandle gba, bool enabled);
+
+/// @brief Choose the pixel format of frames returned by AcquireLatestFrame. Scanlines are converted as they are drawn,
+///        so each frame can be uploaded for display as is. Defaults to BGR555 without color correction.
+/// @param[in] gba Handle returned by Initialize.
+/// @param[in] format Layout of each pixel in the frame buffer.
+/// @param[in] colorCorrection Whether to adjust colors to approximate how they appear on the GBA's LCD.
+void SetPixelFormat(GbaHandle gba, PixelFormat format, bool colorCorrection = false);
+
+/// @brief Choose how many frames to skip drawing after each one that's drawn, such as while fast-forwarding. Skipped frames are
+///        emulated in full, but none of their scanlines are composed and they never reach AcquireLatestFrame or the frame callback.
+///        Sequence numbers still count them. Takes effect at the next VBlank. Must not be called while the emulator is running.
+/// @param[in] gba Handle returned by Initialize.
+/// @param[in] frames Number of frames to skip between drawn frames. 0 draws every frame, which is the default.
+void SetFrameSkip(GbaHandle gba, int frames);
+
+/// @brief Choose how many frames to run ahead, which hides input lag built into games. At the start of every frame, the state
+///        is saved, that many frames are run with the current input while muted, and the last of them is shown in place of the
+///        frame about to be emulated. The saved state is then loaded again, so the game itself is unaffected. Each frame costs
+///        roughly one extra frame of host time per frame run ahead. Paused while recording or playing a movie and while memory
+///        watches or PC hooks are registered, since those only follow the real timeline. Must not be called while the emulator
+///        is running.
+/// @param[in] gba Handle returned by Initialize.
+/// @param[in] frames Number of frames to run ahead, from 0 to 4. 0 turns run-ahead off, which is the default.
+void SetRunAhead(GbaHandle gba, int frames);
 
 /// @brief Load a GBA ROM.
+/// @param[in] gba Handle returned by Initialize.
 /// @param[in] romPath GBA ROM file to be loaded.
-/// @pre Initialize must have been previously called.
-bool InsertCartridge(fs::path romPath);
+bool InsertCartridge(GbaHandle gba, fs::path romPath);
 
 /// @brief Run the emulator until the internal audio buffer is full.
-void FillAudioBuffer();
+/// @param[in] gba Handle returned by Initialize.
+void FillAudioBuffer(GbaHandle gba);
+
+/// @brief Run the emulator for a number of frames as fast as the host allows, regardless of how much audio has been drained. Meant
+///        for headless use, where nothing is presented in real time. Audio is either not produced at all, which is fastest, or
+///        recorded in full at the output sample rate. The internal audio buffer is left untouched either way. Must not be called
+///        while FillAudioBuffer is running.
+/// @param[in] gba Handle returned by Initialize.
+/// @param[in] frames Number of frames to run. The last one is ready for AcquireLatestFrame once this returns.
+/// @param[out] audio If not nullptr, every interleaved stereo sample produced is appended to it.
+void RunFrames(GbaHandle gba, int frames, std::vector<float>* audio = nullptr);
+
+/// @brief Run the emulator for a number of frames like RunFrames, but write audio straight into caller owned memory instead of
+///        a vector, so that nothing is copied or allocated along the way. A frame produces just under sampleRate / 59.7 stereo
+///        samples. Must not be called while FillAudioBuffer is running.
+/// @param[in] gba Handle returned by Initialize.
+/// @param[in] frames Number of frames to run.
+/// @param[out] audio Buffer to write interleaved stereo samples to, or nullptr to not produce any audio.
+/// @param[in] capacity Number of floats that fit in the audio buffer. Samples that don't fit are dropped.
+/// @return Number of floats written to the audio buffer.
+size_t RunFrames(GbaHandle gba, int frames, float* audio, size_t capacity);
 
-/// @brief Fill an external audio buffer with the requested number of samples.
+/// @brief Set the rate that audio samples are produced at. Audio is mixed internally at 32768Hz and resampled to this rate
+///        with band-limited synthesis. Defaults to 48000Hz. Must not be called while FillAudioBuffer is running.
+/// @param[in] gba Handle returned by Initialize.
+/// @param[in] sampleRate Output samples per second, from 8000 to 96000.
+void SetAudioSampleRate(GbaHandle gba, int sampleRate);
+
+/// @brief Set how much audio FillAudioBuffer keeps buffered. The resampling rate is adjusted by a fraction of a percent based on
+///        how full the buffer is, so latency stays pinned near the target without underruns. Defaults to 12ms. Must not be
+///        called while FillAudioBuffer is running.
+/// @param[in] gba Handle returned by Initialize.
+/// @param[in] milliseconds Target latency, from 4 to 50 milliseconds.
+void SetAudioLatency(GbaHandle gba, int milliseconds);
+
+/// @brief Fill an external audio buffer with the requested number of samples in a single block copy. If fewer samples are
+///        available, the rest of the buffer is filled with silence.
+/// @param[in] gba Handle returned by Initialize.
 /// @param buffer Buffer to load internal audio buffer's samples into.
 /// @param cnt Number of samples to load into external buffer.
-void DrainAudioBuffer(float* buffer, size_t cnt);
+/// @return Number of samples that came from the internal buffer.
+size_t DrainAudioBuffer(GbaHandle gba, float* buffer, size_t cnt);
 
 /// @brief Check how many audio samples are currently saved in the internal buffer. One sample is a single left or right sample.
+/// @param[in] gba Handle returned by Initialize.
 /// @return Number of samples saved in internal buffer.
-size_t AvailableSamplesCount();
+size_t AvailableSamplesCount(GbaHandle gba);
+
+/// @brief Block until the internal audio buffer has been drained far enough for FillAudioBuffer to have work to do. The thread
+///        calling DrainAudioBuffer wakes the waiter as soon as the buffer drops 1ms below the target latency, so a thread that
+///        alternates between FillAudioBuffer and this neither sleeps longer than it needs to nor wakes up with nothing to do.
+/// @param[in] gba Handle returned by Initialize.
+/// @param[in] timeoutMs Longest time to block for, in milliseconds.
+/// @return False if the timeout expired before there was space or WakeAudioWaiter was called.
+bool WaitForAudioSpace(GbaHandle gba, int timeoutMs);
 
-/// @brief Update the GBA gamepad status.
+/// @brief Make a thread blocked in WaitForAudioSpace return immediately, such as when stopping emulation while audio is paused.
+///        Safe to call from any thread.
+/// @param[in] gba Handle returned by Initialize.
+void WakeAudioWaiter(GbaHandle gba);
+
+/// @brief Update the GBA gamepad status. Safe to call from any thread, including while FillAudioBuffer is running. Buttons are
+///        left in a mailbox that the emulator checks whenever the game reads KEYINPUT and on every scanline, so they take effect
+///        mid-frame and can trigger a keypad interrupt without waiting on the caller.
+/// @param[in] gba Handle returned by Initialize.
 /// @param gamepad Current gamepad buttons being pressed.
-/// @pre Initialize must have been previously called.
-void UpdateGamepad(Gamepad gamepad);
+void UpdateGamepad(GbaHandle gba, Gamepad gamepad);
+
+/// @brief Save the complete state of the emulator into a flat binary buffer. Takes well under a millisecond, so it can be called
+///        every frame. Must not be called while FillAudioBuffer is running.
+/// @param[in] gba Handle returned by Initialize.
+/// @param[out] state Buffer to save state into. Its previous contents are replaced. Reusing the same buffer between calls avoids
+///                   reallocating it.
+void SaveState(GbaHandle gba, std::vector<uint8_t>& state);
+
+/// @brief Restore a state created by SaveState. States are only compatible with the same build of the emulator and the same ROM,
+///        which is checked before anything is changed. Must not be called while FillAudioBuffer is running.
+/// @param[in] gba Handle returned by Initialize.
+/// @param[in] state State to load.
+/// @return Whether the state was loaded. If not, the emulator is left unchanged, unless the state was corrupt in which case the
+///         GBA is reset.
+bool LoadState(GbaHandle gba, std::vector<uint8_t> const& state);
+
+/// @brief Start or stop recording a history of states to rewind through. States are stored as compressed differences from each
+///        other, so a minute of history at one state per frame typically fits in well under the default 64MB. The oldest states
+///        are dropped once the buffer is full. Loading a new ROM clears the history.
+/// @param[in] gba Handle returned by Initialize.
+/// @param[in] enabled Whether to record states.
+/// @param[in] framesPerCapture Number of frames between recorded states.
+/// @param[in] bufferSizeInBytes Max amount of memory used to store history.
+void SetRewind(GbaHandle gba, bool enabled, int framesPerCapture = 1, size_t bufferSizeInBytes = 64 * 1024 * 1024);
+
+/// @brief Step back to the most recently recorded state. Each call steps back one more state, so calling this once per frame
+///        plays the history in reverse. Must not be called while FillAudioBuffer is running.
+/// @param[in] gba Handle returned by Initialize.
+/// @return Whether there was a state to step back to.
+bool Rewind(GbaHandle gba);
+
+/// @brief What the input movie of a GBA is doing.
+enum class MovieMode
+{
+    Idle,  // Input from UpdateGamepad is applied at the next KEYINPUT read or scanline
+    Recording,  // Input from UpdateGamepad is applied and recorded at the next VBlank
+    Playing  // Input comes from the movie at each VBlank and UpdateGamepad is ignored
+};
+
+/// @brief Reset the GBA and start recording an input movie. While recording, input only changes at VBlank, so playing the movie
+///        back reproduces the run exactly, at any speed. Loading a ROM or state, or rewinding, stops the movie and discards
+///        anything recorded. Must not be called while FillAudioBuffer is running.
+/// @param[in] gba Handle returned by Initialize.
+void StartMovieRecording(GbaHandle gba);
+
+/// @brief Reset the GBA and start playing an input movie. Playback stops after the last recorded frame, and input from
+///        UpdateGamepad is used again from then on. Must not be called while FillAudioBuffer is running.
+/// @param[in] gba Handle returned by Initialize.
+/// @param[in] movie Movie returned by StopMovie.
+/// @return Whether the movie was valid and recorded on the loaded ROM. If not, the GBA is left unchanged.
+bool StartMoviePlayback(GbaHandle gba, std::vector<uint8_t> const& movie);
+
+/// @brief Stop recording or playing an input movie. Must not be called while FillAudioBuffer is running.
+/// @param[in] gba Handle returned by Initialize.
+/// @param[out] movie If recording, filled with the compact binary movie that was recorded. Otherwise cleared.
+void StopMovie(GbaHandle gba, std::vector<uint8_t>& movie);
+
+/// @brief Check what the input movie is doing.
+/// @param[in] gba Handle returned by Initialize.
+/// @return Current movie mode.
+MovieMode GetMovieMode(GbaHandle gba);
+
+/// @brief A completed frame, ready to be displayed.
+struct Frame
+{
+    /// @brief 240x160 pixels in the format chosen with SetPixelFormat, or nullptr if the GBA is uninitialized. Stays valid and
+    ///        unchanged until the next call to AcquireLatestFrame.
+    uint8_t const* pixels_;
+
+    /// @brief Number of frames the PPU has completed up to and including this one, starting from 1. 0 if no frame has completed
+    ///        yet. Keeps counting when a new ROM is loaded, so the difference between two sequence numbers is how many frames were
+    ///        emulated in between.
+    uint64_t sequence_;
+
+    /// @brief Sequence number of the earliest frame with the same contents as this one. A frame does not need to be presented
+    ///        again if its content sequence matches the frame currently on screen.
+    uint64_t contentSequence_;
+};
+
+/// @brief Get the newest completed frame without copying it or waiting on the emulation thread. Presenting a frame never
+///        causes tearing, since the emulator draws into a different buffer until the frame is released by the next call. Must
+///        only be called from one thread.
+/// @param[in] gba Handle returned by Initialize.
+/// @return Latest completed frame.
+Frame AcquireLatestFrame(GbaHandle gba);
 
-/// @brief Access the raw frame buffer data.
-/// @return Raw pointer to frame buffer.
-/// @pre Initialize must have been previously called.
-uint8_t* GetRawFrameBuffer();
+/// @brief Choose caller owned memory that frames are drawn straight into as each scanline completes, instead of the internal
+///        frame buffers. Frames drawn into a target are not returned by AcquireLatestFrame, but the frame callback is still
+///        called for each one. Scanlines that didn't change are left as they are instead of being redrawn, as long as the
+///        target is the same memory the previous frame was drawn into. Must not be called while the emulator is running, and
+///        takes full effect from the next frame, so a frame that was already partway drawn keeps whatever was drawn above.
+/// @param[in] gba Handle returned by Initialize.
+/// @param[in] pixels 240x160 pixels in the format chosen with SetPixelFormat, with no padding between rows. Must stay valid
+///                   until the target is changed again. nullptr goes back to drawing into the internal frame buffers.
+void SetFrameTarget(GbaHandle gba, void* pixels);
 
-/// @brief Get the number of times the PPU has hit VBlank since the last check.
-/// @return Number of times PPU has entered VBlank.
-int GetAndResetFrameCounter();
+/// @brief Function called each time a frame completes, with the sequence number of that frame. Called from whichever thread
+///        finished drawing the frame, right after it became available to AcquireLatestFrame. It must return quickly and must not
+///        call back into the GBA.
+using FrameCallback = std::function<void(uint64_t sequence)>;
+
+/// @brief Choose a function to be notified of each completed frame, so that a front end can present frames as they complete
+///        instead of polling for them. Must not be called while the emulator is running.
+/// @param[in] gba Handle returned by Initialize.
+/// @param[in] callback Function to call, or an empty function to stop notifications.
+void SetFrameCallback(GbaHandle gba, FrameCallback callback);
+
+/// @brief How a capture is written to disk. Audio is written next to the video as <path>.wav, in 32 bit float stereo at the
+///        output sample rate, unless it's muxed into the video by ffmpeg.
+enum class CaptureFormat
+{
+    Raw,  // Frames back to back in the pixel format chosen with SetPixelFormat, with no header
+    Lossless,  // Only the bytes that changed since the previous frame. DecodeCapture turns it back into raw frames.
+    FFmpeg  // Frames piped to an ffmpeg process on the PATH as they arrive, then muxed with the audio once the capture stops
+};
+
+/// @brief Progress of a capture. Audio sample counts are of single left or right samples.
+struct CaptureStats
+{
+    uint64_t framesWritten_;  // Including repeats of the previous frame in place of frames that were skipped or dropped
+    uint64_t framesDropped_;  // Frames that arrived while every pooled frame buffer was still waiting to be encoded
+    uint64_t samplesWritten_;  // Including silence in place of samples that were dropped
+    uint64_t samplesDropped_;  // Samples that arrived while the pooled audio buffer was full
+};
+
+/// @brief Start recording every completed frame and all audio to disk, such as to keep a video of a regression failure or a
+///        long soak test. Each frame and each block of audio is copied once into a pooled buffer as it's produced, and all
+///        encoding and file I/O happens on a background thread, so capturing never makes FillAudioBuffer or RunFrames wait. If
+///        the encoder falls behind, frames are dropped and the previous frame is repeated in their place, and audio that doesn't
+///        fit is replaced with silence, so the video keeps a constant frame rate of 59.73 fps and stays in sync with the audio.
+///        Drops are logged to <path>.log. Audio is only captured while it's being produced, which isn't the case while running
+///        ahead or running frames without audio. Starting a capture while one is running stops that one first. Pixel format and
+///        sample rate must not change while capturing. Must not be called while the emulator is running.
+/// @param[in] gba Handle returned by Initialize.
+/// @param[in] path Path of video file to create.
+/// @param[in] format How to write the video.
+/// @param[in] ffmpegOptions Output options passed to ffmpeg when encoding the video, such as "-c:v libx264 -crf 18". Only used by
+///                          CaptureFormat::FFmpeg, which uses ffmpeg's default codec for the file extension if empty.
+/// @throws std::runtime_error if an output file or the ffmpeg process can't be created.
+void StartCapture(GbaHandle gba, fs::path path, CaptureFormat format, std::string const& ffmpegOptions = "");
+
+/// @brief Stop capturing, wait for everything captured so far to be encoded, and finish the output files. Does nothing if no
+///        capture is running. Must not be called while the emulator is running.
+/// @param[in] gba Handle returned by Initialize.
+/// @return Final progress of the capture.
+/// @throws std::runtime_error if writing the capture failed partway, such as when ffmpeg exited early.
+CaptureStats StopCapture(GbaHandle gba);
+
+/// @brief Check how a running capture is doing. Safe to call from any thread, including while FillAudioBuffer is running, but not
+///        at the same time as StartCapture or StopCapture.
+/// @param[in] gba Handle returned by Initialize.
+/// @return Progress of the running capture, or all zeros if none is running.
+CaptureStats GetCaptureStats(GbaHandle gba);
+
+/// @brief Convert video captured with CaptureFormat::Lossless into the raw frames CaptureFormat::Raw would have written.
+/// @param capturePath Path to lossless capture.
+/// @param rawPath Path of raw video file to create.
+/// @throws std::runtime_error if the capture can't be read or is malformed.
+void DecodeCapture(fs::path capturePath, fs::path rawPath);
+
+/// @brief Host side performance of the most recently completed frame. Times are in nanoseconds of host time spent on the
+///        emulation thread. Timing each component costs a clock read per event, so the CPU, DMA, PPU, and timer times are only
+///        gathered in builds with GBA_ENABLE_COMPONENT_TELEMETRY, and are 0 otherwise. Without it, the APU time only covers
+///        resampling done outside of events. Frame time and event counts are gathered in every build.
+struct Telemetry
+{
+    uint64_t frame_;  // Number of frames completed when this was gathered, 0 if none have completed yet
+    uint64_t frameTime_;  // Time since the previous frame completed, including any time the emulation thread spent waiting
+    uint64_t cpuTime_;  // Running the CPU, not counting events that fired partway through an instruction
+    uint64_t dmaTime_;  // Running DMA transfers
+    uint64_t ppuTime_;  // HBlank, VBlank, and VDraw events, which includes rendering scanlines unless threaded rendering is on
+    uint64_t apuTime_;  // Mixing and resampling audio
+    uint64_t timerTime_;  // Timer overflow events
+    uint64_t ppuEvents_;  // Number of HBlank, VBlank, and VDraw events fired during the frame
+    uint64_t apuEvents_;  // Number of audio samples mixed during the frame
+    uint64_t timerEvents_;  // Number of timer overflow events fired during the frame
+    uint64_t audioUnderruns_;  // Number of DrainAudioBuffer calls since power on that had to be padded with silence
+    uint64_t instanceMemory_;  // Bytes owned by this GBA alone, including caches and buffers. Updated between frames too.
+    uint64_t sharedMemory_;  // Bytes of BIOS and ROM data, which clones share with the GBA they were cloned from
+    double speedRatio_;  // Emulated time divided by host time since the previous frame completed. 1.0 is full speed.
+};
+
+/// @brief Get the telemetry of the most recently completed frame. This is lock-free and never waits on the emulation thread, so
+///        it can be called from any number of threads at any time, including while FillAudioBuffer is running.
+/// @param[in] gba Handle returned by Initialize.
+/// @return Latest telemetry.
+Telemetry GetTelemetry(GbaHandle gba);
 
 /// @brief Toggle logging of various GBA events like DMAs and timer overflows.
-void ToggleSystemLogging();
+/// @param[in] gba Handle returned by Initialize.
+void ToggleSystemLogging(GbaHandle gba);
 
 /// @brief Toggle logging of each CPU instruction and registers state.
-void ToggleCpuLogging();
+/// @param[in] gba Handle returned by Initialize.
+void ToggleCpuLogging(GbaHandle gba);
+
+/// @brief Toggle streaming of logged CPU instructions and system events to a compressed trace file in the log directory.
+///        While streaming, the full history is kept on disk instead of only the most recent entries in memory.
+/// @param[in] gba Handle returned by Initialize.
+void ToggleTraceStreaming(GbaHandle gba);
+
+/// @brief Convert a trace file created while streaming into a human readable log.
+/// @param tracePath Path to trace file.
+/// @param logPath Path of text log to create.
+/// @throws std::runtime_error if the trace file can't be read or is malformed.
+void DecodeTrace(fs::path tracePath, fs::path logPath);
 
 /// @brief If logging was enabled, dump the log buffer to a file.
-void DumpLogs();
+/// @param[in] gba Handle returned by Initialize.
+void DumpLogs(GbaHandle gba);
+
+/// @brief Execution statistics of one aligned range of code.
+struct PcRangeProfile
+{
+    uint32_t startAddr_;
+    uint32_t endAddr_;
+    uint64_t instructions_;
+    uint64_t cycles_;  // Cycles from fetching each instruction until it finished executing, including its own memory accesses
+};
+
+/// @brief Statistics of one memory region, selected by bits 24-27 of an address.
+struct RegionProfile
+{
+    std::string name_;
+    uint64_t instructions_;  // Instructions executed from this region
+    uint64_t executionCycles_;  // Cycles spent executing those instructions
+    uint64_t accesses_;  // Individual reads and writes by the CPU or DMA, including instruction fetches
+    uint64_t accessCycles_;  // Cycles spent on those reads and writes
+};
+
+/// @brief Number of times an event fired, and how late it fired. Events can only fire between instructions, DMA units, or cached
+///        blocks, so most fire a few cycles after the cycle they were scheduled for.
+struct EventProfile
+{
+    std::string name_;
+    uint64_t count_;
+    uint64_t totalLateCycles_;  // Sum of how many cycles past its scheduled cycle each fire happened
+    uint64_t maxLateCycles_;
+    std::vector<uint64_t> lateCyclesHistogram_;  // Fires by lateness. Index 0 counts fires that were on time, index i counts
+                                                 // fires 2^(i-1) to 2^i - 1 cycles late, and the last index also counts later.
+};
+
+/// @brief Everything gathered by the profiler since it was last reset.
+struct ProfileReport
+{
+    bool available_;  // False if GbaLib was built without GBA_ENABLE_PROFILER, in which case everything else is empty
+    uint64_t totalCycles_;
+    uint64_t cpuCycles_;  // Cycles the CPU was running, including pipeline refills that aren't attributed to any instruction
+    uint64_t dmaCycles_;  // Cycles stolen from the CPU by DMA transfers
+    uint64_t haltCycles_;  // Cycles skipped while the CPU was halted
+    uint64_t idleLoopCycles_;  // Cycles skipped after detecting an idle loop
+    std::vector<PcRangeProfile> pcRanges_;  // Sorted by cycles, highest first
+    std::vector<RegionProfile> regions_;  // Indexed by bits 24-27 of address. Addresses above 0x0FFFFFFF count as region 1.
+    std::vector<EventProfile> events_;  // Indexed by event type
+};
+
+/// @brief Get what the profiler has gathered so far. The profiler only exists in builds configured with
+///        -D GBA_ENABLE_PROFILER=ON, and costs nothing otherwise. Must not be called while FillAudioBuffer is running.
+/// @param[in] gba Handle returned by Initialize.
+/// @return Profiling results.
+ProfileReport GetProfile(GbaHandle gba);
+
+/// @brief Clear everything the profiler has gathered. Must not be called while FillAudioBuffer is running.
+/// @param[in] gba Handle returned by Initialize.
+void ResetProfile(GbaHandle gba);
+
+/// @brief Write what the profiler has gathered in the collapsed stack format read by flamegraph.pl and speedscope. Each line is
+///        a stack of where cycles went, such as "cpu;IWRAM;0x03000100-0x0300011F", followed by the number of cycles spent there.
+///        Must not be called while FillAudioBuffer is running.
+/// @param[in] gba Handle returned by Initialize.
+/// @param[in] path Path of file to create.
+/// @throws std::runtime_error if GbaLib was built without the profiler or the file can't be created.
+void DumpProfile(GbaHandle gba, fs::path path);
+
+/// @brief Identifies a memory watch or PC hook so that it can be removed.
+typedef uint32_t HookId;
+
+/// @brief Which accesses trigger a memory watch.
+enum class WatchType
+{
+    Read,
+    Write,
+    ReadWrite
+};
+
+/// @brief A memory access that triggered a watch.
+struct MemoryAccess
+{
+    uint32_t addr_;  // Canonical address of the access, with mirrors resolved
+    uint32_t value_;  // Value that was read or written
+    int size_;  // Number of bytes accessed
+    bool write_;
+};
+
+/// @brief Called on the emulation thread for each access that overlaps a watch, after the access completes. Reads include
+///        instruction fetches and DMA transfers.
+/// @return True to stop emulation. RunFrames and FillAudioBuffer return once the current instruction or DMA burst finishes.
+using MemoryHook = std::function<bool(MemoryAccess const& access)>;
+
+/// @brief Called on the emulation thread right before an instruction at a hooked address executes, even if its condition fails.
+/// @return True to stop emulation. RunFrames and FillAudioBuffer return once the instruction finishes.
+using PcHook = std::function<bool(uint32_t pc)>;
+
+/// @brief Watch a range of memory. Only pages with a watch on them leave the direct memory path, so accesses to other pages run
+///        at full speed. Hooks must not add or remove hooks. Must not be called while FillAudioBuffer is running.
+/// @param[in] gba Handle returned by Initialize.
+/// @param[in] addr First address to watch. Mirrors of the address are watched too.
+/// @param[in] length Number of bytes to watch.
+/// @param[in] type Which accesses trigger the watch.
+/// @param[in] hook Function to call when the watch is triggered.
+/// @return ID of the new watch.
+HookId AddMemoryWatch(GbaHandle gba, uint32_t addr, uint32_t length, WatchType type, MemoryHook hook);
+
+/// @brief Call a function every time the instruction at an address is about to execute. Code on a page with a PC hook is
+///        interpreted instead of run from the block cache, while code on other pages is unaffected. Hooks must not add or remove
+///        hooks. Must not be called while FillAudioBuffer is running.
+/// @param[in] gba Handle returned by Initialize.
+/// @param[in] pc Address of instruction to hook.
+/// @param[in] hook Function to call.
+/// @return ID of the new hook.
+HookId AddPcHook(GbaHandle gba, uint32_t pc, PcHook hook);
+
+/// @brief Remove a memory watch or PC hook. Must not be called while FillAudioBuffer is running.
+/// @param[in] gba Handle returned by Initialize.
+/// @param[in] id ID returned when the hook was added.
+/// @return Whether a hook with that ID existed.
+bool RemoveHook(GbaHandle gba, HookId id);
+
+/// @brief Check whether the last call to RunFrames or FillAudioBuffer returned early because a hook asked to stop.
+/// @param[in] gba Handle returned by Initialize.
+/// @return True if a hook stopped emulation.
+bool HookStopped(GbaHandle gba);
 
 /// @brief Get the title of the currently loaded ROM.
+/// @param[in] gba Handle returned by Initialize.
 /// @return Title of ROM.
-/// @pre Initialize must have been previously called.
-std::string RomTitle();
+std::string RomTitle(GbaHandle gba);
 
-/// @brief Power down the GBA, creating a save file if a cartridge was loaded.
-void PowerOff();
+/// @brief Power down a GBA, creating a save file if a cartridge was loaded, and release it.
+/// @param[in] gba Handle returned by Initialize. Must not be used after this call. Does nothing if nullptr.
+void PowerOff(GbaHandle gba);
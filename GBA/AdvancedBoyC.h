@@ -0,0 +1,129 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @brief C interface to the emulator, for embedding it in programs written in other languages through a shared library. Only
+///        plain C types cross the library boundary, so the ABI stays stable across compilers and builds. The caller owns every
+///        frame and audio buffer, and each step draws and mixes straight into them without copying or allocating anything.
+
+#if defined(_WIN32)
+    #if defined(GBA_C_API_BUILD)
+        #define GBA_API __declspec(dllexport)
+    #else
+        #define GBA_API __declspec(dllimport)
+    #endif
+#else
+    #define GBA_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @brief Version of this interface. Bumped whenever a change breaks compatibility with programs built against an older one.
+#define GBA_API_VERSION 1
+
+#define GBA_FRAME_WIDTH 240
+#define GBA_FRAME_HEIGHT 160
+
+/// @brief Opaque handle to an emulated GBA.
+typedef struct gba_t gba_t;
+
+/// @brief Result codes returned by functions that can fail.
+enum gba_result
+{
+    GBA_OK = 0,
+    GBA_ERROR_INVALID_ARGUMENT = -1,  // Null handle, out of range value, or buffer too small
+    GBA_ERROR_FAILED = -2  // Emulator reported an error, such as an unreadable ROM
+};
+
+/// @brief Layout of each pixel in frames. Matches PixelFormat in PixelFormat.hpp.
+enum gba_pixel_format
+{
+    GBA_PIXEL_FORMAT_BGR555 = 0,  // uint16_t, 0bXBBBBBGGGGGRRRRR. Native GBA format.
+    GBA_PIXEL_FORMAT_RGB565 = 1,  // uint16_t, 0bRRRRRGGGGGGBBBBB
+    GBA_PIXEL_FORMAT_XRGB8888 = 2,  // uint32_t, 0xFFRRGGBB
+    GBA_PIXEL_FORMAT_RGBA8888 = 3  // Bytes R, G, B, A in memory order, A is always 0xFF
+};
+
+/// @brief Bits of the button mask passed to gba_set_buttons. A set bit means the button is pressed.
+enum gba_button
+{
+    GBA_BUTTON_A = 1 << 0,
+    GBA_BUTTON_B = 1 << 1,
+    GBA_BUTTON_SELECT = 1 << 2,
+    GBA_BUTTON_START = 1 << 3,
+    GBA_BUTTON_RIGHT = 1 << 4,
+    GBA_BUTTON_LEFT = 1 << 5,
+    GBA_BUTTON_UP = 1 << 6,
+    GBA_BUTTON_DOWN = 1 << 7,
+    GBA_BUTTON_R = 1 << 8,
+    GBA_BUTTON_L = 1 << 9
+};
+
+/// @brief Get the version of the interface the library was built with.
+/// @return GBA_API_VERSION of the library. Programs should check that it matches the version they were built against.
+GBA_API int gba_api_version(void);
+
+/// @brief Create a new GBA. Any number of them can run in the same process at once, each on its own thread.
+/// @param[in] bios_path Path to GBA BIOS file.
+/// @return Handle to the new GBA, or NULL if it couldn't be created. Must be released with gba_destroy.
+GBA_API gba_t* gba_create(char const* bios_path);
+
+/// @brief Release a GBA and everything it owns.
+/// @param[in] gba Handle returned by gba_create. Must not be used after this call. Does nothing if NULL.
+GBA_API void gba_destroy(gba_t* gba);
+
+/// @brief Create a new GBA in the same state as an existing one, sharing its BIOS and ROM data. The clone then runs independently,
+///        and its backup media is never written to a save file. Its pixel format starts out at its default.
+/// @param[in] gba Handle returned by gba_create or gba_clone.
+/// @return Handle to the new GBA, or NULL if it couldn't be created. Must be released with gba_destroy.
+GBA_API gba_t* gba_clone(gba_t* gba);
+
+/// @brief Load a GBA ROM and reset the GBA.
+/// @param[in] gba Handle returned by gba_create.
+/// @param[in] rom_path GBA ROM file to load.
+/// @return GBA_OK if the ROM was loaded.
+GBA_API int gba_load_rom(gba_t* gba, char const* rom_path);
+
+/// @brief Choose the pixel format of frames. Defaults to GBA_PIXEL_FORMAT_BGR555 without color correction.
+/// @param[in] gba Handle returned by gba_create.
+/// @param[in] format One of gba_pixel_format.
+/// @param[in] color_correction Nonzero to adjust colors to approximate how they appear on the GBA's LCD.
+/// @return GBA_OK if the format was changed.
+GBA_API int gba_set_pixel_format(gba_t* gba, int format, int color_correction);
+
+/// @brief Get how big a frame buffer passed to gba_run_frame must be in the current pixel format.
+/// @param[in] gba Handle returned by gba_create.
+/// @return Size of a frame in bytes, or 0 if gba is NULL.
+GBA_API size_t gba_frame_size(gba_t const* gba);
+
+/// @brief Set the rate that audio samples are produced at. Defaults to 48000Hz.
+/// @param[in] gba Handle returned by gba_create.
+/// @param[in] sample_rate Output samples per second, from 8000 to 96000.
+/// @return GBA_OK if the rate was changed.
+GBA_API int gba_set_sample_rate(gba_t* gba, int sample_rate);
+
+/// @brief Set which buttons are pressed. Safe to call from any thread, including while gba_run_frame is running.
+/// @param[in] gba Handle returned by gba_create.
+/// @param[in] buttons Mask of gba_button bits that are pressed.
+GBA_API void gba_set_buttons(gba_t* gba, uint32_t buttons);
+
+/// @brief Run the emulator for one frame. Scanlines are drawn straight into the frame buffer as they complete, and audio is
+///        resampled straight into the audio buffer. When the same frame buffer is passed as in the previous call, scanlines that
+///        didn't change since then are left as they are instead of being redrawn.
+/// @param[in] gba Handle returned by gba_create.
+/// @param[out] frame Buffer of gba_frame_size bytes to draw the frame into, with no padding between rows, or NULL to not
+///                   receive the frame.
+/// @param[in] frame_size Size of the frame buffer in bytes.
+/// @param[out] audio Buffer to write interleaved stereo float samples into, or NULL to not produce any audio. A frame produces
+///                   just under sample_rate / 59.7 stereo samples. Samples that don't fit are dropped.
+/// @param[in] audio_capacity Number of floats that fit in the audio buffer.
+/// @param[out] audio_count If not NULL, set to the number of floats written to the audio buffer.
+/// @return GBA_OK if the frame was run.
+GBA_API int gba_run_frame(gba_t* gba, void* frame, size_t frame_size, float* audio, size_t audio_capacity, size_t* audio_count);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+
+/// @brief Layout of each pixel in frames returned by AcquireLatestFrame.
+enum class PixelFormat
+{
+    BGR555,  // uint16_t, 0bXBBBBBGGGGGRRRRR. Native GBA format.
+    RGB565,  // uint16_t, 0bRRRRRGGGGGGBBBBB
+    XRGB8888,  // uint32_t, 0xFFRRGGBB
+    RGBA8888  // Bytes R, G, B, A in memory order, A is always 0xFF
+};
+
+/// @brief Get the size of a pixel in a particular format.
+/// @param format Pixel format.
+/// @return Number of bytes per pixel.
+constexpr size_t BytesPerPixel(PixelFormat format)
+{
+    return ((format == PixelFormat::BGR555) || (format == PixelFormat::RGB565)) ? 2 : 4;
+}
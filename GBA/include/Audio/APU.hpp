@@ -1,10 +1,17 @@
 #pragma once
 
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <mutex>
 #include <utility>
+#include <vector>
+#include <Audio/BlipBuffer.hpp>
 #include <Audio/Channel1.hpp>
 #include <Audio/Channel2.hpp>
+#include <Audio/Channel3.hpp>
 #include <Audio/Channel4.hpp>
 #include <Audio/Constants.hpp>
 #include <Audio/DmaAudio.hpp>
@@ -13,17 +20,36 @@
 #include <Utilities/MemoryUtilities.hpp>
 #include <Utilities/RingBuffer.hpp>
 
+class AvCapture;
+class EventScheduler;
+class StateSerializer;
+
 namespace Audio
 {
+/// @brief Where the APU sends resampled audio.
+enum class OutputMode
+{
+    Buffer,  // Internal ring buffer, with dynamic rate control to keep it at the target latency
+    Record,  // End of an external buffer, at exactly the output rate and without dropping anything
+    Capture,  // Caller owned memory of fixed size, at exactly the output rate. Anything that doesn't fit is dropped.
+    Discard  // Nowhere. Channels are still mixed so FIFOs drain on time, but nothing is resampled.
+};
+
 class APU
 {
 public:
     /// @brief Initialize APU registers and event registration.
-    APU();
+    /// @param scheduler Scheduler to register the sampling event with.
+    explicit APU(EventScheduler& scheduler);
 
     /// @brief Reset APU to power-up state.
     void Reset();
 
+    /// @brief Save or load the APU registers and every channel. Resampled audio that hasn't been output yet isn't part of the
+    ///        state, the resampler restarts from the loaded output level instead.
+    /// @param state Serializer to save state to or load state from.
+    void Serialize(StateSerializer& state);
+
     /// @brief Read an APU register.
     /// @param addr Address of register to read.
     /// @param alignment Number of bytes to read.
@@ -38,34 +64,128 @@ public:
 
     /// @brief Update DMA audio when timer overflows.
     /// @param timerIndex Which timer overflowed.
+    /// @param overflowCount Number of times the timer overflowed.
     /// @return Whether FIFO A and FIFO B should trigger a DMA to refill them.
-    std::pair<bool, bool> TimerOverflow(int timerIndex) { return dmaFifos_.TimerOverflow(timerIndex); }
+    std::pair<bool, bool> TimerOverflow(int timerIndex, int overflowCount)
+    {
+        return dmaFifos_.TimerOverflow(timerIndex, overflowCount);
+    }
+
+    /// @brief Get which timers DMA audio needs overflows from.
+    /// @param fifoADma Whether a DMA channel is set to refill FIFO A.
+    /// @param fifoBDma Whether a DMA channel is set to refill FIFO B.
+    /// @return Bit mask of timers.
+    uint8_t FifoTimerMask(bool fifoADma, bool fifoBDma) const { return dmaFifos_.TimerMask(fifoADma, fifoBDma); }
+
+    /// @brief Refill a DMA audio FIFO directly from a block of memory.
+    /// @param addr Address of FIFO.
+    /// @param samples Samples to push, in the order they'd be written to the FIFO register.
+    /// @param sampleCount Number of samples to push.
+    void RefillFifo(uint32_t addr, uint8_t const* samples, size_t sampleCount) { dmaFifos_.PushSamples(addr, samples, sampleCount); }
 
     // Producer thread functions
 
+    /// @brief Only call from producer thread. Set the rate that output samples are produced at. Any samples that have not been
+    ///        flushed yet are discarded.
+    /// @param sampleRate Output samples per second. Clamped to the supported range.
+    void SetSampleRate(int sampleRate);
+
+    /// @brief Only call from producer thread. Set how much audio to keep buffered. The internal buffer can hold up to twice this
+    ///        much, and the resampling rate is continuously adjusted by a fraction of a percent to keep it about half full.
+    /// @param milliseconds Target latency. Clamped to the supported range.
+    void SetTargetLatency(int milliseconds);
+
+    /// @brief Only call from producer thread. Pick up resampling exactly where another APU is, so that a clone of a GBA produces
+    ///        the same audio as the GBA it was cloned from. Call after loading the other APU's state.
+    /// @param other APU to copy sample rate, latency, and resampling position from.
+    void CopyResampling(APU const& other);
+
+    /// @brief Only call from producer thread. Choose where resampled audio goes. Anything mixed so far is flushed to the previous
+    ///        destination first.
+    /// @param mode Where to send audio from now on.
+    /// @param recording Buffer to append samples to while recording. Must stay valid until the output mode is changed again.
+    void SetOutputMode(OutputMode mode, std::vector<float>* recording = nullptr);
+
+    /// @brief Only call from producer thread. Choose where resampled audio goes, capturing it straight into caller owned memory.
+    ///        Anything mixed so far is flushed to the previous destination first.
+    /// @param mode Where to send audio from now on.
+    /// @param capture Buffer to write samples to while capturing. Must stay valid until the output mode is changed again.
+    /// @param capacity Number of floats that fit in the capture buffer.
+    void SetOutputMode(OutputMode mode, float* capture, size_t capacity);
+
+    /// @brief Only call from producer thread. Get how much of the capture buffer has been filled since capturing started. Stays
+    ///        valid after switching to another output mode, until the next capture starts.
+    /// @return Number of floats written to the capture buffer.
+    size_t CapturedSize() const { return capturedSize_; }
+
+    /// @brief Only call from producer thread. Choose where to send a copy of all resampled audio for recording, whichever output
+    ///        mode it goes to.
+    /// @param capture Capture to push audio to, or nullptr to stop sending it anywhere.
+    void SetCapture(AvCapture* capture) { capture_ = capture; }
+
+    /// @brief Only call from producer thread. Get the rate that output samples are produced at.
+    /// @return Output samples per second.
+    int SampleRate() const { return sampleRate_; }
+
+    /// @brief Only call from producer thread. Mute output while running ahead of the current point in time. Everything mixed so
+    ///        far is flushed first. The state at this point must be loaded again before calling EndRunAhead.
+    void BeginRunAhead();
+
+    /// @brief Only call from producer thread. Resume output after the state saved before BeginRunAhead was loaded. Resampling
+    ///        carries on exactly where it left off, as if the frames run ahead never happened.
+    void EndRunAhead();
+
     /// @brief Only call from producer thread. Check number of free space for samples in internal buffer.
     /// @return Number of samples that can be buffered, with one sample being two left/right samples.
     size_t FreeBufferSpace() const;
 
-    /// @brief Clear the current sample counter. Counter increments each time the APU is sampled.
+    /// @brief Only call from producer thread. Resample everything mixed since the last flush to the output rate and push it to
+    ///        the internal buffer.
+    void FlushSamples();
+
+    /// @brief Only call from producer thread. Block until the consumer drains the internal buffer to at least 1ms below the
+    ///        target latency, WakeProducer is called, or the timeout expires.
+    /// @param timeout Longest time to block for.
+    /// @param ignoreBuffer Whether to only wait for WakeProducer or the timeout, such as when there's nothing to refill it with.
+    /// @return False if the timeout expired first.
+    bool WaitForBufferSpace(std::chrono::milliseconds timeout, bool ignoreBuffer);
+
+    /// @brief Clear the current sample counter. Counter increments for each output sample worth of time that has been mixed.
     void ClearSampleCounter() { sampleCounter_ = 0; }
 
-    /// @brief Check how many times the APU has been sampled since it was last cleared.
+    /// @brief Check how many output samples have been mixed since the counter was last cleared.
     /// @return Number of samples that have been produced.
     size_t GetSampleCounter() { return sampleCounter_; }
 
     // Consumer thread functions
 
-    /// @brief Fill an external audio buffer with the requested number of samples.
+    /// @brief Fill an external audio buffer in one block copy. If fewer samples are buffered than requested, the rest of the
+    ///        external buffer is filled with silence.
     /// @param buffer Buffer to load internal audio buffer's samples into.
     /// @param cnt Number of samples to load into external buffer.
-    void DrainBuffer(float* buffer, size_t cnt) { sampleBuffer_.Read(buffer, cnt); }
+    /// @return Number of samples that came from the internal buffer.
+    size_t DrainBuffer(float* buffer, size_t cnt);
 
     /// @brief Check how many audio samples are currently saved in the internal buffer. One sample is a single left or right sample.
     /// @return Number of samples saved in internal buffer.
     size_t AvailableSamplesCount() const { return sampleBuffer_.GetAvailable(); }
 
+    // Any thread functions
+
+    /// @brief Make a producer blocked in WaitForBufferSpace return immediately. If none is blocked, the next wait returns
+    ///        immediately instead.
+    void WakeProducer();
+
 private:
+    /// @brief Recalculate the buffer level that DrainBuffer wakes the producer at. Called whenever the output rate or target
+    ///        latency changes.
+    void UpdateWatermark();
+
+    /// @brief Flush anything mixed so far to the current destination and switch to a new output mode. The caller sets up the
+    ///        new destination.
+    /// @param mode Where to send audio from now on.
+    void SwitchOutputMode(OutputMode mode);
+
     /// @brief Read an APU control register.
     /// @param addr Address of register to read.
     /// @param alignment Number of bytes to read.
@@ -78,7 +198,7 @@ private:
     /// @param alignment Number of bytes to write.
     void WriteApuCntReg(uint32_t addr, uint32_t value, AccessSize alignment);
 
-    /// @brief Sample all APU channels and push a sample to the internal buffer.
+    /// @brief Mix all APU channels and record any change in output level for resampling.
     /// @param extraCycles Number of cycles since this callback was supposed to execute.
     void Sample(int extraCycles);
 
@@ -92,11 +212,42 @@ private:
     // Channels
     Channel1 channel1_;
     Channel2 channel2_;
+    Channel3 channel3_;
     Channel4 channel4_;
     DmaAudio dmaFifos_;
 
+    // Resampling
+    BlipBuffer synth_;
+    int sampleRate_;
+    int targetLatencyMs_;
+    int16_t leftLevel_;
+    int16_t rightLevel_;
+    uint64_t frameStartCycle_;
+    uint64_t lastSampleCycle_;
+    size_t pendingSamples_;
+    std::array<float, BUFFER_SIZE> flushBuffer_;
+    OutputMode outputMode_;
+    std::vector<float>* recording_;
+    float* captureBuffer_;
+    size_t captureCapacity_;
+    size_t capturedSize_;
+    AvCapture* capture_;
+
+    // Output destination and resampling position to return to after running ahead
+    bool runningAhead_;
+    OutputMode runAheadMode_;
+    uint64_t runAheadCycle_;
+
     // Internal sample buffer
     RingBuffer<float, BUFFER_SIZE> sampleBuffer_;
     size_t sampleCounter_;
+
+    // Producer wake up
+    std::atomic_size_t lowWatermark_;  // Buffered samples at or below which the consumer signals the producer
+    std::mutex spaceMutex_;
+    std::condition_variable spaceAvailable_;
+    bool wakeRequested_;
+
+    EventScheduler& scheduler_;
 };
 }
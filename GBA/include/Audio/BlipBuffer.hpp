@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Audio
+{
+/// @brief Stereo band-limited step synthesizer. Changes in amplitude are recorded as deltas timestamped in CPU cycles, and each one
+///        is added to the output as a windowed sinc step at its exact sub-sample position. This resamples to any output rate
+///        without the aliasing of point sampling, and the output is only produced when a batch of samples is read. Left and right
+///        are interleaved throughout so that both sides share each kernel lookup and the output can be converted in one pass.
+class BlipBuffer
+{
+public:
+    /// @brief Allocate a synthesizer.
+    /// @param capacity Max number of stereo output samples that can be held between reads.
+    explicit BlipBuffer(size_t capacity);
+
+    /// @brief Set the output sample rate and clear any buffered samples.
+    /// @param sampleRate Output samples per second.
+    void SetSampleRate(int sampleRate);
+
+    /// @brief Scale the output sample rate without clearing buffered samples. Takes effect from the start of the current frame.
+    /// @param ratio Multiplier applied to the sample rate set with SetSampleRate.
+    void SetRateAdjustment(double ratio);
+
+    /// @brief Clear all buffered samples and deltas.
+    void Clear();
+
+    /// @brief Add a change in amplitude.
+    /// @param clocks Number of CPU cycles since the start of the current frame that the change happens on.
+    /// @param leftDelta Change in left amplitude.
+    /// @param rightDelta Change in right amplitude.
+    void AddDelta(uint32_t clocks, int leftDelta, int rightDelta);
+
+    /// @brief Check how many samples would be available to read if the current frame ended on a particular cycle.
+    /// @param clocks Number of CPU cycles since the start of the current frame.
+    /// @return Number of samples.
+    size_t SamplesAvailable(uint32_t clocks) const;
+
+    /// @brief Get the number of samples finished by previous frames that are available to read.
+    /// @return Number of samples.
+    size_t SamplesAvailable() const { return offset_ >> FRAC_BITS; }
+
+    /// @brief End the current frame, making its samples available to read. The next frame starts where this one ended.
+    /// @param clocks Length of the current frame in CPU cycles.
+    void EndFrame(uint32_t clocks);
+
+    /// @brief Read available samples, removing them from the buffer.
+    /// @param buffer Buffer to write interleaved left/right samples to.
+    /// @param cnt Max number of stereo samples to read.
+    /// @param gain Output value of an amplitude of 1.
+    /// @return Number of stereo samples read.
+    size_t ReadSamples(float* buffer, size_t cnt, float gain);
+
+    static constexpr size_t KERNEL_WIDTH = 16;
+    static constexpr size_t PHASE_BITS = 6;
+    static constexpr size_t PHASE_COUNT = 1 << PHASE_BITS;
+
+private:
+    static constexpr int FRAC_BITS = 32;
+
+    // Interleaved left/right deltas. Capacity plus room for the tails of steps that land near the end of the buffer.
+    std::vector<int32_t> buffer_;
+    size_t capacity_;
+
+    // Output samples per CPU cycle before and after rate adjustment, and position of the start of the current frame, all as 32.32
+    // fixed point
+    uint64_t baseFactor_;
+    uint64_t factor_;
+    uint64_t offset_;
+
+    // Running sum of left and right output deltas
+    std::array<int32_t, 2> integrators_;
+};
+}
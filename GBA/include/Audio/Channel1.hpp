@@ -6,17 +6,25 @@
 #include <Audio/Registers.hpp>
 #include <Utilities/MemoryUtilities.hpp>
 
+class EventScheduler;
+class StateSerializer;
+
 namespace Audio
 {
 class Channel1
 {
 public:
-    /// @brief Initialize Channel 1 registers and event handling.
-    Channel1();
+    /// @brief Initialize Channel 1 registers.
+    /// @param scheduler Scheduler used to tell what cycle register writes happen on.
+    explicit Channel1(EventScheduler const& scheduler);
 
     /// @brief Reset Channel 1 to its power-up state.
     void Reset();
 
+    /// @brief Save or load Channel 1's registers and timing state.
+    /// @param state Serializer to save state to or load state from.
+    void Serialize(StateSerializer& state);
+
     /// @brief Read a Channel 1 register.
     /// @param addr Address of register to read.
     /// @param alignment Number of bytes to read.
@@ -30,32 +38,30 @@ public:
     /// @return Whether this write triggered this channel to start/restart.
     bool WriteReg(uint32_t addr, uint32_t value, AccessSize alignment);
 
-    /// @brief Sample Channel 1's current output.
+    /// @brief Sample Channel 1's output at a particular cycle.
+    /// @param cycle Cycle to sample at. Must not be earlier than any cycle Channel 1 has already been updated to.
     /// @return Channel 1 output value.
-    uint8_t Sample();
+    uint8_t Sample(uint64_t cycle);
+
+    /// @brief Process everything that happened to Channel 1 up to and including a cycle. Rather than scheduling events at GB clock
+    ///        rates, duty cycle steps, envelope steps, length timer expiration, and frequency sweeps are worked out from the
+    ///        number of elapsed cycles whenever Channel 1 is sampled or accessed.
+    /// @param cycle Cycle to bring Channel 1 up to date with.
+    void Update(uint64_t cycle);
 
     /// @brief Check if Channel 1 has turned off due to its length timer expiring.
-    /// @return True if length timer has expired.
+    /// @return True if length timer had expired as of the last update.
     bool Expired() const { return lengthTimerExpired_; }
 
 private:
     /// @brief Start Channel 1 processing.
     void Start();
 
-    /// @brief Callback function to advance Channel 1's duty cycle step.
-    /// @param extraCycles Number of cycles since this callback was supposed to execute.
-    void Clock(int extraCycles);
-
-    /// @brief Callback function to advance Channel 1's envelope.
-    /// @param extraCycles Number of cycles since this callback was supposed to execute.
-    void Envelope(int extraCycles);
+    /// @brief Advance Channel 1's envelope.
+    void Envelope();
 
-    /// @brief Callback function to disable Channel 1 if its length timer was enabled when it was triggered.
-    void LengthTimer(int) { lengthTimerExpired_ = true; };
-
-    /// @brief Callback function to advance Channel 1's frequency sweep.
-    /// @param extraCycles Number of cycles since this callback was supposed to execute.
-    void FrequencySweep(int extraCycles);
+    /// @brief Advance Channel 1's frequency sweep.
+    void FrequencySweep();
 
     // Registers
     std::array<uint8_t, 8> channel1Registers_;
@@ -72,5 +78,13 @@ private:
     size_t dutyCycleIndex_;
     bool lengthTimerExpired_;
     bool frequencyOverflow_;
+
+    // Cycles that the next step of each of Channel 1's timers happens on, or MAX_U64 if not running
+    uint64_t nextClockCycle_;
+    uint64_t nextEnvelopeCycle_;
+    uint64_t lengthTimerCycle_;
+    uint64_t nextSweepCycle_;
+
+    EventScheduler const& scheduler_;
 };
 }
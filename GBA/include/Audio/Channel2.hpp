@@ -6,17 +6,25 @@
 #include <Audio/Registers.hpp>
 #include <Utilities/MemoryUtilities.hpp>
 
+class EventScheduler;
+class StateSerializer;
+
 namespace Audio
 {
 class Channel2
 {
 public:
-    /// @brief Initialize Channel 2 registers and event handling.
-    Channel2();
+    /// @brief Initialize Channel 2 registers.
+    /// @param scheduler Scheduler used to tell what cycle register writes happen on.
+    explicit Channel2(EventScheduler const& scheduler);
 
     /// @brief Reset Channel 2 to its power-up state.
     void Reset();
 
+    /// @brief Save or load Channel 2's registers and timing state.
+    /// @param state Serializer to save state to or load state from.
+    void Serialize(StateSerializer& state);
+
     /// @brief Read a Channel 2 register.
     /// @param addr Address of register to read.
     /// @param alignment Number of bytes to read.
@@ -30,28 +38,26 @@ public:
     /// @return Whether this write triggered this channel to start/restart.
     bool WriteReg(uint32_t addr, uint32_t value, AccessSize alignment);
 
-    /// @brief Sample Channel 2's current output.
+    /// @brief Sample Channel 2's output at a particular cycle.
+    /// @param cycle Cycle to sample at. Must not be earlier than any cycle Channel 2 has already been updated to.
     /// @return Channel 2 output value.
-    uint8_t Sample();
+    uint8_t Sample(uint64_t cycle);
+
+    /// @brief Process everything that happened to Channel 2 up to and including a cycle. Duty cycle steps, envelope steps, and
+    ///        length timer expiration are worked out from the number of elapsed cycles instead of being scheduled as events.
+    /// @param cycle Cycle to bring Channel 2 up to date with.
+    void Update(uint64_t cycle);
 
     /// @brief Check if Channel 2 has turned off due to its length timer expiring.
-    /// @return True if length timer has expired.
+    /// @return True if length timer had expired as of the last update.
     bool Expired() const { return lengthTimerExpired_; }
 
 private:
     /// @brief Start Channel 2 processing.
     void Start();
 
-    /// @brief Callback function to advance Channel 2's duty cycle step.
-    /// @param extraCycles Number of cycles since this callback was supposed to execute.
-    void Clock(int extraCycles);
-
-    /// @brief Callback function to advance Channel 2's envelope.
-    /// @param extraCycles Number of cycles since this callback was supposed to execute.
-    void Envelope(int extraCycles);
-
-    /// @brief Callback function to disable Channel 2 if its length timer was enabled when it was triggered.
-    void LengthTimer(int) { lengthTimerExpired_ = true; };
+    /// @brief Advance Channel 2's envelope.
+    void Envelope();
 
     // Registers
     std::array<uint8_t, 8> channel2Registers_;
@@ -66,5 +72,12 @@ private:
     uint8_t currentVolume_;
     size_t dutyCycleIndex_;
     bool lengthTimerExpired_;
+
+    // Cycles that the next step of each of Channel 2's timers happens on, or MAX_U64 if not running
+    uint64_t nextClockCycle_;
+    uint64_t nextEnvelopeCycle_;
+    uint64_t lengthTimerCycle_;
+
+    EventScheduler const& scheduler_;
 };
 }
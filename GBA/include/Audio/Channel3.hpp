@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <Audio/Registers.hpp>
+#include <Utilities/MemoryUtilities.hpp>
+
+class EventScheduler;
+class StateSerializer;
+
+namespace Audio
+{
+class Channel3
+{
+public:
+    /// @brief Initialize Channel 3 registers.
+    /// @param scheduler Scheduler used to tell what cycle register writes happen on.
+    explicit Channel3(EventScheduler const& scheduler);
+
+    /// @brief Reset Channel 3 to its power-up state.
+    void Reset();
+
+    /// @brief Save or load Channel 3's registers, wave RAM, and timing state.
+    /// @param state Serializer to save state to or load state from.
+    void Serialize(StateSerializer& state);
+
+    /// @brief Read a Channel 3 register.
+    /// @param addr Address of register to read.
+    /// @param alignment Number of bytes to read.
+    /// @return Value of register and whether this read triggered open bus behavior.
+    std::pair<uint32_t, bool> ReadReg(uint32_t addr, AccessSize alignment);
+
+    /// @brief Write a Channel 3 register.
+    /// @param addr Address of register to write.
+    /// @param value Value to write to register.
+    /// @param alignment Number of bytes to write.
+    /// @return Whether this write triggered this channel to start/restart.
+    bool WriteReg(uint32_t addr, uint32_t value, AccessSize alignment);
+
+    /// @brief Read wave RAM. The CPU can only access the bank that is not selected for playback.
+    /// @param addr Address of wave RAM to read.
+    /// @param alignment Number of bytes to read.
+    /// @return Value in wave RAM.
+    uint32_t ReadWaveRam(uint32_t addr, AccessSize alignment);
+
+    /// @brief Write wave RAM. The CPU can only access the bank that is not selected for playback.
+    /// @param addr Address of wave RAM to write.
+    /// @param value Value to write to wave RAM.
+    /// @param alignment Number of bytes to write.
+    void WriteWaveRam(uint32_t addr, uint32_t value, AccessSize alignment);
+
+    /// @brief Sample Channel 3's output at a particular cycle.
+    /// @param cycle Cycle to sample at. Must not be earlier than any cycle Channel 3 has already been updated to.
+    /// @return Channel 3 output value.
+    uint8_t Sample(uint64_t cycle);
+
+    /// @brief Process everything that happened to Channel 3 up to and including a cycle. The position in wave RAM and length
+    ///        timer expiration are worked out from the number of elapsed cycles instead of being scheduled as events.
+    /// @param cycle Cycle to bring Channel 3 up to date with.
+    void Update(uint64_t cycle);
+
+    /// @brief Check if Channel 3 has turned off due to its length timer expiring or playback being stopped.
+    /// @return True if Channel 3 was off as of the last update.
+    bool Expired() const { return lengthTimerExpired_ || !sound3cnt_l_.playback; }
+
+private:
+    /// @brief Start Channel 3 processing.
+    void Start();
+
+    /// @brief Calculate how many CPU cycles Channel 3 plays each digit of wave RAM for.
+    /// @return Number of cycles between steps.
+    uint64_t StepCycles() const { return (0x800 - sound3cnt_x_.sampleRate) * 8; }
+
+    // Registers
+    std::array<uint8_t, 8> channel3Registers_;
+    SOUND3CNT_L& sound3cnt_l_;  // NR30 (Wave RAM select)
+    SOUND3CNT_H& sound3cnt_h_;  // NR31, NR32 (Length, volume)
+    SOUND3CNT_X& sound3cnt_x_;  // NR33, NR34 (Sample rate, control)
+
+    // Two banks of 32 4-bit digits each
+    std::array<std::array<uint8_t, 16>, 2> waveRam_;
+
+    // State
+    uint8_t playbackBank_;
+    uint8_t digitIndex_;
+    bool lengthTimerExpired_;
+
+    // Cycles that the next step of each of Channel 3's timers happens on, or MAX_U64 if not running
+    uint64_t nextClockCycle_;
+    uint64_t lengthTimerCycle_;
+
+    EventScheduler const& scheduler_;
+};
+}
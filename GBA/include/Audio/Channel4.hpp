@@ -6,17 +6,25 @@
 #include <Audio/Registers.hpp>
 #include <Utilities/MemoryUtilities.hpp>
 
+class EventScheduler;
+class StateSerializer;
+
 namespace Audio
 {
 class Channel4
 {
 public:
-     /// @brief Initialize Channel 4 registers and event handling.
-    Channel4();
+     /// @brief Initialize Channel 4 registers.
+    /// @param scheduler Scheduler used to tell what cycle register writes happen on.
+    explicit Channel4(EventScheduler const& scheduler);
 
     /// @brief Reset Channel 4 to its power-up state.
     void Reset();
 
+    /// @brief Save or load Channel 4's registers, shift register, and timing state.
+    /// @param state Serializer to save state to or load state from.
+    void Serialize(StateSerializer& state);
+
     /// @brief Read a Channel 4 register.
     /// @param addr Address of register to read.
     /// @param alignment Number of bytes to read.
@@ -30,28 +38,29 @@ public:
     /// @return Whether this write triggered this channel to start/restart.
     bool WriteReg(uint32_t addr, uint32_t value, AccessSize alignment);
 
-    /// @brief Sample Channel 4's current output.
+    /// @brief Sample Channel 4's output at a particular cycle.
+    /// @param cycle Cycle to sample at. Must not be earlier than any cycle Channel 4 has already been updated to.
     /// @return Channel 4 output value.
-    uint8_t Sample();
+    uint8_t Sample(uint64_t cycle);
+
+    /// @brief Process everything that happened to Channel 4 up to and including a cycle. LFSR steps, envelope steps, and
+    ///        length timer expiration are worked out from the number of elapsed cycles instead of being scheduled as events.
+    /// @param cycle Cycle to bring Channel 4 up to date with.
+    void Update(uint64_t cycle);
 
     /// @brief Check if Channel 4 has turned off due to its length timer expiring.
-    /// @return True if length timer has expired.
+    /// @return True if length timer had expired as of the last update.
     bool Expired() const { return lengthTimerExpired_; }
 
 private:
     /// @brief Start Channel 4 processing.
     void Start();
 
-    /// @brief Callback function to advance Channel 4's duty cycle step.
-    /// @param extraCycles Number of cycles since this callback was supposed to execute.
-    void Clock(int extraCycles);
+    /// @brief Advance Channel 4's envelope.
+    void Envelope();
 
-    /// @brief Callback function to advance Channel 4's envelope.
-    /// @param extraCycles Number of cycles since this callback was supposed to execute.
-    void Envelope(int extraCycles);
-
-    /// @brief Callback function to disable Channel 4 if its length timer was enabled when it was triggered.
-    void LengthTimer(int) { lengthTimerExpired_ = true; };
+    /// @brief Advance Channel 4's shift register by one step.
+    void StepLfsr();
 
     /// @brief Calculate how many CPU cycles until Channel 4 should be clocked again based on its frequency.
     /// @return Number of cycles between clocks.
@@ -72,5 +81,12 @@ private:
 
     // Shift register
     uint16_t lsfr_;
+
+    // Cycles that the next step of each of Channel 4's timers happens on, or MAX_U64 if not running
+    uint64_t nextClockCycle_;
+    uint64_t nextEnvelopeCycle_;
+    uint64_t lengthTimerCycle_;
+
+    EventScheduler const& scheduler_;
 };
 }
@@ -5,11 +5,24 @@
 
 namespace Audio
 {
+// Rate that channels are mixed at. Output is resampled from this to the host's sample rate.
 constexpr int SAMPLING_FREQUENCY_HZ = 32768;
 constexpr int CPU_CYCLES_PER_SAMPLE = (CPU::CPU_FREQUENCY_HZ / SAMPLING_FREQUENCY_HZ);
 
-// Maintain audio buffer of 22ms
-constexpr size_t BUFFER_SIZE = ((SAMPLING_FREQUENCY_HZ * 22) / 1000) * 2;
+// Supported output sample rates
+constexpr int MIN_OUTPUT_FREQUENCY_HZ = 8000;
+constexpr int MAX_OUTPUT_FREQUENCY_HZ = 96000;
+constexpr int DEFAULT_OUTPUT_FREQUENCY_HZ = 48000;
+
+// Supported audio latency. The internal buffer holds up to twice the target latency, and dynamic rate control keeps it about
+// half full.
+constexpr int MIN_LATENCY_MS = 4;
+constexpr int MAX_LATENCY_MS = 50;
+constexpr int DEFAULT_LATENCY_MS = 12;
+constexpr size_t BUFFER_SIZE = ((MAX_OUTPUT_FREQUENCY_HZ * MAX_LATENCY_MS * 2) / 1000) * 2;
+
+// Max fractional change in resampling rate used to correct the buffer level. Small enough that the pitch shift is inaudible.
+constexpr double MAX_RATE_ADJUSTMENT = 0.005;
 
 constexpr int CPU_CYCLES_PER_GB_CYCLE = CPU::CPU_FREQUENCY_HZ / 1'048'576;
 constexpr int CPU_CYCLES_PER_ENVELOPE_SWEEP = CPU::CPU_FREQUENCY_HZ / 64;
@@ -1,11 +1,14 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <utility>
 #include <Audio/Registers.hpp>
 #include <Utilities/CircularBuffer.hpp>
 #include <Utilities/MemoryUtilities.hpp>
 
+class StateSerializer;
+
 namespace Audio
 {
 class DmaAudio
@@ -20,6 +23,10 @@ public:
     /// @brief Clear FIFOs.
     void Reset();
 
+    /// @brief Save or load the contents of both FIFOs.
+    /// @param state Serializer to save state to or load state from.
+    void Serialize(StateSerializer& state);
+
     /// @brief Read a DMA audio register. Always returns open bus status.
     /// @param addr Address of register to read.
     /// @param alignment Number of bytes to read.
@@ -32,10 +39,23 @@ public:
     /// @param alignment Number of samples to push.
     void WriteReg(uint32_t addr, uint32_t value, AccessSize alignment);
 
-    /// @brief Pop a sample off of FIFOs connected to the timer that overflowed.
+    /// @brief Push a block of samples to a DMA audio FIFO.
+    /// @param addr Address of FIFO.
+    /// @param samples Samples to push, in the order they'd be written to the FIFO register.
+    /// @param sampleCount Number of samples to push.
+    void PushSamples(uint32_t addr, uint8_t const* samples, size_t sampleCount);
+
+    /// @brief Pop a sample off of FIFOs connected to the timer that overflowed for each time it overflowed.
     /// @param timerIndex Index of timer that overflowed.
+    /// @param overflowCount Number of times the timer overflowed.
     /// @return Whether FIFO A and FIFO B should trigger a DMA to refill them.
-    std::pair<bool, bool> TimerOverflow(int timerIndex);
+    std::pair<bool, bool> TimerOverflow(int timerIndex, int overflowCount);
+
+    /// @brief Get which timers the FIFOs need overflows from. A FIFO needs its timer if it's output or refilled by DMA.
+    /// @param fifoADma Whether a DMA channel is set to refill FIFO A.
+    /// @param fifoBDma Whether a DMA channel is set to refill FIFO B.
+    /// @return Bit mask of timers.
+    uint8_t TimerMask(bool fifoADma, bool fifoBDma) const;
 
     /// @brief Sample the current output of each FIFO.
     /// @return Pair of signed FIFO samples.
@@ -51,6 +71,13 @@ private:
     /// @param sampleCount Number of samples to push.
     void FifoPush(DmaSoundFifo& fifo, uint32_t value, size_t sampleCount);
 
+    /// @brief Pop samples off of a FIFO.
+    /// @param fifo Reference to which FIFO to pop samples from.
+    /// @param sample Reference to the current output of the FIFO, set to the last sample popped.
+    /// @param popCount Number of samples to pop.
+    /// @return Whether the FIFO should trigger a DMA to refill it.
+    bool FifoPop(DmaSoundFifo& fifo, int8_t& sample, int popCount);
+
     SOUNDCNT_H& soundcnt_h_;
 
     DmaSoundFifo fifoA_;
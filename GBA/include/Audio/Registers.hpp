@@ -34,6 +34,32 @@ struct SOUND1CNT_X
 struct SOUND2CNT_L : public SOUND1CNT_H {};
 struct SOUND2CNT_H : public SOUND1CNT_X {};
 
+// Channel 3
+struct SOUND3CNT_L
+{
+    uint16_t : 5;
+    uint16_t dimension : 1;
+    uint16_t bankNumber : 1;
+    uint16_t playback : 1;
+    uint16_t : 8;
+};
+
+struct SOUND3CNT_H
+{
+    uint16_t soundLength : 8;
+    uint16_t : 5;
+    uint16_t volume : 2;
+    uint16_t forceVolume : 1;
+};
+
+struct SOUND3CNT_X
+{
+    uint16_t sampleRate : 11;
+    uint16_t : 3;
+    uint16_t lengthEnable : 1;
+    uint16_t trigger : 1;
+};
+
 // Channel 4
 struct SOUND4CNT_L
 {
@@ -1,17 +1,21 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <string>
 #include <utility>
+#include <vector>
 #include <CPU/ArmInstructions.hpp>
-#include <CPU/CPUTypes.hpp>
+#include <CPU/BlockCache.hpp>
+#include <CPU/CpuTypes.hpp>
 #include <CPU/Registers.hpp>
 #include <CPU/ThumbInstructions.hpp>
-#include <Utilities/CircularBuffer.hpp>
-#include <Utilities/Functor.hpp>
 #include <Utilities/MemoryUtilities.hpp>
 
+class EventScheduler;
 class GameBoyAdvance;
+class StateSerializer;
+namespace Logging { class LogManager; }
 
 namespace CPU
 {
@@ -19,9 +23,10 @@ class ARM7TDMI
 {
 public:
     /// @brief Initialize the ARM CPU.
-    /// @param readCallback Callback function to read memory.
-    /// @param writeCallback Callback function to write memory.
-    ARM7TDMI(MemReadCallback readCallback, MemWriteCallback writeCallback);
+    /// @param gba Reference to GBA whose memory bus the CPU reads from and writes to.
+    /// @param scheduler Scheduler to advance as instructions execute.
+    /// @param log Log to record executed instructions to.
+    ARM7TDMI(GameBoyAdvance& gba, EventScheduler& scheduler, Logging::LogManager& log);
 
     ARM7TDMI() = delete;
     ARM7TDMI(ARM7TDMI const&) = delete;
@@ -32,14 +37,68 @@ public:
     /// @brief Reset the CPU to its power-up state.
     void Reset();
 
-    /// @brief Advance the CPU by one instruction. GLobal scheduler will be advanced as well.
+    /// @brief Put the CPU in the state the BIOS leaves it in after its intro, with the GamePak's entry point next to execute.
+    /// @pre Reset was just called.
+    void SkipBIOS() { registers_.SkipBIOS(); }
+
+    /// @brief Advance the CPU by one instruction. Scheduler will be advanced as well.
     /// @param irqPending True if an IRQ is currently pending.
     void Step(bool irqPending);
 
+    /// @brief Run instructions until the next scheduled event is ready to fire, or until an instruction changes system state that
+    ///        the caller must react to (halt, DMA, timers, interrupts). Pending IRQs are serviced between instructions.
+    void RunUntilNextEvent();
+
+    /// @brief Check whether the last call to RunUntilNextEvent stopped because the CPU is stuck in an idle loop. An idle loop is a
+    ///        short cached block that branches back to itself without writing memory, and whose registers are identical after
+    ///        consecutive iterations. Such a loop cannot make progress until an event fires, so it can be skipped like a halt.
+    /// @return True if an idle loop was detected.
+    bool IdleLoopDetected() const { return idleLoopDetected_; }
+
+    /// @brief Note that a value was just read that can change without an event firing (such as a timer counter). Loops that poll
+    ///        such values are not treated as idle.
+    void MarkVolatileRead() { volatileRead_ = true; }
+
     /// @brief Get the current value of the PC register.
     /// @return Value of PC.
     uint32_t GetPC() const { return registers_.GetPC(); }
 
+    /// @brief Invalidate any cached blocks containing code at an address that was just written to.
+    /// @param addr Address that was written.
+    /// @param alignment Number of bytes written.
+    void InvalidateBlocks(uint32_t addr, AccessSize alignment);
+
+    /// @brief Invalidate any cached blocks containing code in a range of addresses that was just written to.
+    /// @param addr First address that was written.
+    /// @param length Number of bytes written.
+    void InvalidateBlocks(uint32_t addr, uint32_t length);
+
+    /// @brief Drop every cached block, so that code is decoded again the next time it runs.
+    void FlushBlockCache();
+
+    /// @brief Get how much memory the block cache takes up.
+    /// @return Approximate size of cached blocks in bytes.
+    size_t BlockCacheMemory() const { return blockCache_.MemoryUsage(); }
+
+    /// @brief Enable or disable high level emulation of BIOS calls. When enabled, the most frequently called BIOS functions
+    ///        (division, square root, memory copies, decompression, and affine matrix setup) run as native code instead of being
+    ///        executed from the BIOS, and are charged an approximation of the cycles the BIOS would take. All other BIOS
+    ///        functions, and calls with arguments that the native versions don't handle, are still executed from the BIOS.
+    /// @param enabled Whether to run supported BIOS calls as native code.
+    void SetBiosHle(bool enabled) { biosHleEnabled_ = enabled; }
+
+    /// @brief Check whether BIOS calls are run as native code.
+    /// @return True if supported BIOS calls are high level emulated.
+    bool BiosHle() const { return biosHleEnabled_; }
+
+    /// @brief Stop running the current cached block or RunUntilNextEvent loop after the instruction currently being executed.
+    ///        Used when an instruction changes system state that the CPU must react to immediately (halt, DMA, interrupts).
+    void ExitBlock() { exitBlock_ = true; }
+
+    /// @brief Save or load the pipeline and registers. Cached blocks and detected idle loops are rebuilt after loading.
+    /// @param state Serializer to save state to or load state from.
+    void Serialize(StateSerializer& state);
+
 private:
     /// @brief Determine whether a command should execute based on its condition code.
     /// @param condition 4-bit ARM condition code.
@@ -49,22 +108,166 @@ private:
     /// @brief Flush pipeline and set CPU state when IRQ occurs.
     void IRQ();
 
-    // Memory R/W callbacks
-    MemReadCallback ReadMemory;
-    MemWriteCallback WriteMemory;
+    /// @brief Fill both pipeline stages after a flush by fetching the instruction at PC and the one following it. Both fetches
+    ///        are issued back to back unless an event fires during the first one, in which case the second fetch is deferred to
+    ///        the next step so that any IRQ raised by the event is taken first.
+    /// @param alignment Width of instructions in the current operating state.
+    void RefillPipeline(AccessSize alignment);
+
+    /// @brief Execute a cached block of instructions. Events are only checked between instructions, and the block is exited
+    ///        early if an event is ready, an IRQ is pending, or the block was invalidated.
+    /// @param block Block to execute.
+    void RunBlock(Block& block);
+
+    /// @brief Check whether a cached block that just branched back to its own start is an idle loop.
+    /// @param block Block that just finished an iteration.
+    void CheckIdleLoop(Block const& block);
+
+    /// @brief Run a BIOS function as native code instead of jumping to the SWI vector. If the function is run, the CPU returns
+    ///        to the instruction after the SWI just as it would after the BIOS returned. Defined in BiosHle.cpp.
+    /// @param function Number of BIOS function being called.
+    /// @return True if the function was run, false if it must be executed from the BIOS.
+    bool HleSoftwareInterrupt(uint8_t function);
+
+    /// @brief Native version of Div (0x06) and DivArm (0x07).
+    /// @param armArguments Whether the numerator and denominator are swapped, as DivArm expects.
+    void HleDiv(bool armArguments);
+
+    /// @brief Native version of Sqrt (0x08).
+    void HleSqrt();
+
+    /// @brief Native version of CpuSet (0x0B).
+    void HleCpuSet();
+
+    /// @brief Native version of CpuFastSet (0x0C).
+    void HleCpuFastSet();
+
+    /// @brief Native version of BgAffineSet (0x0E).
+    void HleBgAffineSet();
 
-    // Instruction pipeline
-    CircularBuffer<std::pair<uint32_t, uint32_t>, 3> pipeline_;
-    alignas(32) char instructionBuffer_[32];
+    /// @brief Native version of ObjAffineSet (0x0F).
+    void HleObjAffineSet();
+
+    /// @brief Native version of LZ77UnCompWram (0x11) and LZ77UnCompVram (0x12).
+    /// @param unit Size of each write to the destination.
+    void HleLz77UnComp(AccessSize unit);
+
+    /// @brief Native version of HuffUnComp (0x13).
+    /// @return False if the data isn't made of 4 or 8 bit units, which is left to the BIOS.
+    bool HleHuffUnComp();
+
+    /// @brief Native version of RLUnCompWram (0x14) and RLUnCompVram (0x15).
+    /// @param unit Size of each write to the destination.
+    void HleRlUnComp(AccessSize unit);
+
+    /// @brief Read from the memory bus on behalf of a BIOS function, charging the access cycles.
+    /// @param addr Address to read from.
+    /// @param alignment Number of bytes to read.
+    /// @return Value at specified address.
+    uint32_t HleRead(uint32_t addr, AccessSize alignment);
+
+    /// @brief Write to the memory bus on behalf of a BIOS function, charging the access cycles.
+    /// @param addr Address to write to.
+    /// @param value Value to write.
+    /// @param alignment Number of bytes to write.
+    void HleWrite(uint32_t addr, uint32_t value, AccessSize alignment);
+
+    /// @brief Write decompressed data to the memory bus in units of a fixed size, as the BIOS decompression functions do. A
+    ///        trailing partial unit is not written.
+    /// @param addr Address to write first unit to.
+    /// @param data Decompressed bytes.
+    /// @param unit Size of each write.
+    /// @param cyclesPerByte Cycles the BIOS spends producing each decompressed byte, charged as each unit is written.
+    void HleWriteUnits(uint32_t addr, std::vector<uint8_t> const& data, AccessSize unit, int cyclesPerByte);
+
+    /// @brief Read from the GBA memory bus with an access size known at compile time. Defined in GameBoyAdvance.hpp so that bus
+    ///        accesses can be inlined.
+    /// @tparam alignment Number of bytes to read.
+    /// @param addr Address to read from.
+    /// @return Value at specified address and number of cycles taken to read.
+    template <AccessSize alignment>
+    inline std::pair<uint32_t, int> ReadMemory(uint32_t addr);
+
+    /// @brief Read from the GBA memory bus with an access size only known at runtime. Defined in GameBoyAdvance.hpp so that bus
+    ///        accesses can be inlined.
+    /// @param addr Address to read from.
+    /// @param alignment Number of bytes to read.
+    /// @return Value at specified address and number of cycles taken to read.
+    inline std::pair<uint32_t, int> ReadMemory(uint32_t addr, AccessSize alignment);
+
+    /// @brief Write to the GBA memory bus with an access size known at compile time. Defined in GameBoyAdvance.hpp so that bus
+    ///        accesses can be inlined.
+    /// @tparam alignment Number of bytes to write.
+    /// @param addr Address to write to.
+    /// @param value Value to write to specified address.
+    /// @return Number of cycles taken to write.
+    template <AccessSize alignment>
+    inline int WriteMemory(uint32_t addr, uint32_t value);
+
+    /// @brief Write to the GBA memory bus with an access size only known at runtime. Defined in GameBoyAdvance.hpp so that bus
+    ///        accesses can be inlined.
+    /// @param addr Address to write to.
+    /// @param value Value to write to specified address.
+    /// @param alignment Number of bytes to write.
+    /// @return Number of cycles taken to write.
+    inline int WriteMemory(uint32_t addr, uint32_t value, AccessSize alignment);
+
+    /// @brief Read consecutive words for a block data transfer, charging the access cycles. Words within a single directly mapped
+    ///        block of memory are read in bursts, and anything else is read one word at a time.
+    /// @param addr Address of the first word to read.
+    /// @param values Where to store the words that are read.
+    /// @param count Number of words to read.
+    void ReadMemoryBurst(uint32_t addr, uint32_t* values, uint32_t count);
+
+    /// @brief Write consecutive words for a block data transfer, charging the access cycles. Words within a single directly
+    ///        mapped block of memory are written in bursts, and anything else is written one word at a time.
+    /// @param addr Address of the first word to write.
+    /// @param values Words to write.
+    /// @param count Number of words to write.
+    void WriteMemoryBurst(uint32_t addr, uint32_t const* values, uint32_t count);
+
+    /// @brief Get how many cycles a burst can take before the next event is ready to fire.
+    /// @return Cycles until the next event, at least 1.
+    int CyclesUntilNextEvent() const;
+
+    // Memory bus
+    GameBoyAdvance& gba_;
+    EventScheduler& scheduler_;
+    Logging::LogManager& log_;
+
+    /// @brief An instruction held in the pipeline, along with the address it was fetched from.
+    struct PipelineStage
+    {
+        uint32_t opcode_;
+        uint32_t addr_;
+    };
+
+    // Instruction pipeline. Outside of a pending flush both stages always hold valid instructions. When flushPipeline_ is set,
+    // the pipeline is refilled from PC at the start of the next step. decodeStageEmpty_ is set if a refill was interrupted after
+    // its first fetch, meaning only executeStage_ is valid.
+    PipelineStage executeStage_;
+    PipelineStage decodeStage_;
     bool flushPipeline_;
+    bool decodeStageEmpty_;
+
+    // Block cache
+    BlockCache blockCache_;
+    bool exitBlock_;
+
+    // Idle loop detection
+    static constexpr uint32_t NO_IDLE_LOOP = MAX_U32;
+    uint32_t idleLoopAddr_;
+    std::array<uint32_t, 17> idleLoopState_;
+    bool idleLoopDetected_;
+    bool memoryWritten_;
+    bool volatileRead_;
+
+    // BIOS high level emulation
+    bool biosHleEnabled_;
 
     // ARM registers
     Registers registers_;
 
-    // Logging
-    std::string mnemonic_;
-    std::string regString_;
-
     friend class ARM::BranchAndExchange;
     friend class ARM::BlockDataTransfer;
     friend class ARM::Branch;
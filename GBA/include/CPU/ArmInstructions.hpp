@@ -1,18 +1,26 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <string>
-#include <CPU/CPUTypes.hpp>
+#include <CPU/CpuTypes.hpp>
 
 namespace CPU { class ARM7TDMI; }
 
 namespace CPU::ARM
 {
-/// @brief Decode a 32 bit value into an ARM instruction.
+constexpr size_t ARM_DECODE_TABLE_SIZE = 4096;
+
+/// @brief Decode a 32 bit value into an ARM instruction handler using a precomputed table indexed by bits 27-20 and 7-4.
 /// @param undecodedInstruction 32 bit value to decode.
-/// @param buffer Pointer to buffer to place instruction object.
-/// @return Pointer to newly constructed instruction object.
-CPU::Instruction* DecodeInstruction(uint32_t undecodedInstruction, void* buffer);
+/// @return Handler that constructs and executes the decoded instruction.
+InstructionHandler LookupHandler(uint32_t undecodedInstruction);
+
+/// @brief Generate a human readable mnemonic for an ARM instruction.
+/// @param undecodedInstruction 32 bit value to disassemble.
+/// @param registers Register values at the time the instruction was executed, used to resolve branch targets.
+/// @return Mnemonic of instruction.
+std::string Disassemble(uint32_t undecodedInstruction, std::array<uint32_t, 16> const& registers);
 
 class BranchAndExchange : public virtual Instruction
 {
@@ -31,11 +39,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
     void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint32_t FORMAT =      0b0000'0001'0010'1111'1111'1111'0001'0000;
     static constexpr uint32_t FORMAT_MASK = 0b0000'1111'1111'1111'1111'1111'1111'0000;
 
@@ -69,11 +77,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
     void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint32_t FORMAT =      0b0000'1000'0000'0000'0000'0000'0000'0000;
     static constexpr uint32_t FORMAT_MASK = 0b0000'1110'0000'0000'0000'0000'0000'0000;
 
@@ -113,12 +121,12 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
-    /// @param newPc PC to branch to.
-    void SetMnemonic(std::string& mnemonic, uint32_t newPC);
+    /// @param registers Register values at the time this instruction was executed.
+    void SetMnemonic(std::string& mnemonic, std::array<uint32_t, 16> const& registers);
 
+private:
     static constexpr uint32_t FORMAT =      0b0000'1010'0000'0000'0000'0000'0000'0000;
     static constexpr uint32_t FORMAT_MASK = 0b0000'1110'0000'0000'0000'0000'0000'0000;
 
@@ -153,11 +161,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
     void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint32_t FORMAT =      0b0000'1111'0000'0000'0000'0000'0000'0000;
     static constexpr uint32_t FORMAT_MASK = 0b0000'1111'0000'0000'0000'0000'0000'0000;
 
@@ -191,11 +199,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
     void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint32_t FORMAT =      0b0000'0110'0000'0000'0000'0000'0001'0000;
     static constexpr uint32_t FORMAT_MASK = 0b0000'1110'0000'0000'0000'0000'0001'0000;
 
@@ -228,12 +236,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
-    /// @param offset Offset to add/subtract to base address.
-    void SetMnemonic(std::string& mnemonic, uint32_t offset);
+    void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint32_t FORMAT =      0b0000'0100'0000'0000'0000'0000'0000'0000;
     static constexpr uint32_t FORMAT_MASK = 0b0000'1100'0000'0000'0000'0000'0000'0000;
 
@@ -284,11 +291,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
     void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint32_t FORMAT =      0b0000'0001'0000'0000'0000'0000'1001'0000;
     static constexpr uint32_t FORMAT_MASK = 0b0000'1111'1000'0000'0000'1111'1111'0000;
 
@@ -327,11 +334,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
     void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint32_t FORMAT =      0b0000'0000'0000'0000'0000'0000'1001'0000;
     static constexpr uint32_t FORMAT_MASK = 0b0000'1111'1000'0000'0000'0000'1111'0000;
 
@@ -371,11 +378,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
     void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint32_t FORMAT =      0b0000'0000'1000'0000'0000'0000'1001'0000;
     static constexpr uint32_t FORMAT_MASK = 0b0000'1111'1000'0000'0000'0000'1111'0000;
 
@@ -416,12 +423,12 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
-    /// @param offset Offset to add to transfer address.
-    void SetMnemonic(std::string& mnemonic, uint32_t offset);
+    /// @param registers Register values at the time this instruction was executed.
+    void SetMnemonic(std::string& mnemonic, std::array<uint32_t, 16> const& registers);
 
+private:
     static constexpr uint32_t FORMAT =      0b0000'0000'0000'0000'0000'0000'1001'0000;
     static constexpr uint32_t FORMAT_MASK = 0b0000'1110'0100'0000'0000'1111'1001'0000;
 
@@ -466,12 +473,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
-    /// @param offset Offset to add to transfer address.
-    void SetMnemonic(std::string& mnemonic, uint8_t offset);
+    void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint32_t FORMAT =      0b0000'0000'0100'0000'0000'0000'1001'0000;
     static constexpr uint32_t FORMAT_MASK = 0b0000'1110'0100'0000'0000'0000'1001'0000;
 
@@ -517,11 +523,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
     void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint32_t FORMAT =      0b0000'0001'0000'1111'0000'0000'0000'0000;
     static constexpr uint32_t FORMAT_MASK = 0b0000'1111'1011'1111'0000'0000'0000'0000;
 
@@ -558,11 +564,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
     void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint32_t FORMAT =      0b0000'0001'0010'0000'1111'0000'0000'0000;
     static constexpr uint32_t FORMAT_MASK = 0b0000'1101'1011'0000'1111'0000'0000'0000;
 
@@ -617,12 +623,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
-    /// @param operand2 Second operand of data processing operation.
-    void SetMnemonic(std::string& mnemonic, uint32_t operand2);
+    void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint32_t FORMAT =      0b0000'0000'0000'0000'0000'0000'0000'0000;
     static constexpr uint32_t FORMAT_MASK = 0b0000'1100'0000'0000'0000'0000'0000'0000;
 
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <CPU/CpuTypes.hpp>
+#include <Utilities/MemoryUtilities.hpp>
+
+namespace CPU
+{
+constexpr size_t MAX_BLOCK_LENGTH = 64;
+constexpr uint32_t CODE_PAGE_SIZE = 256;
+constexpr size_t MAX_IDLE_LOOP_LENGTH = 16;
+
+/// @brief A pre-decoded instruction within a cached block.
+struct CachedInstruction
+{
+    InstructionHandler handler_;
+    uint32_t instruction_;
+};
+
+/// @brief Sequence of pre-decoded instructions that were executed back to back starting at a particular address. A block ends at
+///        the first instruction that flushed the pipeline when it was recorded.
+struct Block
+{
+    /// @brief Address of first instruction in block.
+    uint32_t startAddr_;
+
+    /// @brief Whether this block contains THUMB instructions.
+    bool thumb_;
+
+    /// @brief Whether instruction fetches must still go through the memory bus (BIOS and Game Pak), or if the access time of the
+    ///        block's page can be charged per fetch instead (work RAM).
+    bool fetchFromBus_;
+
+    /// @brief Whether this block still reflects the contents of memory.
+    bool valid_;
+
+    /// @brief Decoded instructions in this block.
+    std::vector<CachedInstruction> instructions_;
+
+    /// @brief Raw opcodes in this block, plus the two opcodes following it. Used to refill the pipeline when exiting a block
+    ///        without a pipeline flush.
+    std::vector<uint32_t> opcodes_;
+};
+
+/// @brief Cache of pre-decoded instruction blocks keyed by start address and operating state.
+class BlockCache
+{
+public:
+    /// @brief Initialize an empty block cache.
+    BlockCache();
+
+    /// @brief Remove all cached blocks.
+    void Clear();
+
+    /// @brief Check whether code at an address may be cached.
+    /// @param addr Address of instruction.
+    /// @return True if address is in BIOS, work RAM, or Game Pak ROM.
+    static bool Cacheable(uint32_t addr);
+
+    /// @brief Find a valid block beginning at an address.
+    /// @param addr Address of first instruction in block.
+    /// @param thumb Whether the CPU is in THUMB state.
+    /// @return Pointer to cached block, or nullptr if no valid block exists.
+    Block* Lookup(uint32_t addr, bool thumb);
+
+    /// @brief Begin recording a new block.
+    /// @param addr Address of first instruction in block.
+    /// @param thumb Whether the CPU is in THUMB state.
+    /// @param opcodes The first three opcodes of the block, as currently held by the pipeline and fetch stage.
+    void StartRecording(uint32_t addr, bool thumb, std::array<uint32_t, 3> const& opcodes);
+
+    /// @brief Check if a block is currently being recorded.
+    /// @return True if recording.
+    bool Recording() const { return recording_; }
+
+    /// @brief Append an executed instruction to the block being recorded. Recording is aborted if the instruction does not
+    ///        directly follow the previously recorded one, and finishes once the block ends or reaches its max length.
+    /// @param addr Address of executed instruction.
+    /// @param handler Handler used to execute instruction.
+    /// @param instruction Undecoded instruction.
+    /// @param fetchedOpcode Opcode fetched during the step this instruction was executed in.
+    /// @param endOfBlock Whether this instruction flushed the pipeline and should end the block.
+    void Record(uint32_t addr, InstructionHandler handler, uint32_t instruction, uint32_t fetchedOpcode, bool endOfBlock);
+
+    /// @brief Add the block being recorded to the cache.
+    void FinishRecording();
+
+    /// @brief Stop recording without caching the block.
+    void AbortRecording() { recording_ = false; }
+
+    /// @brief Invalidate any blocks containing an address that was just written to. Only work RAM can be written.
+    /// @param addr Address that was written.
+    /// @param alignment Number of bytes written.
+    /// @return True if any cached or recording block was invalidated.
+    bool Invalidate(uint32_t addr, AccessSize alignment);
+
+    /// @brief Invalidate any blocks containing a range of addresses that was just written to. The range must not cross from one
+    ///        work RAM region into another.
+    /// @param addr First address that was written.
+    /// @param length Number of bytes written.
+    /// @return True if any cached or recording block was invalidated.
+    bool InvalidateRange(uint32_t addr, uint32_t length);
+
+    /// @brief Invalidate every block in work RAM and stop recording, such as when all of memory is replaced by loading a state.
+    ///        Blocks in BIOS and Game Pak ROM are kept, since that memory never changes.
+    void InvalidateWorkRam();
+
+    /// @brief Get the number of bytes each instruction occupies in a block.
+    /// @param block Block to check.
+    /// @return 2 for THUMB blocks, 4 for ARM blocks.
+    static uint32_t InstructionWidth(Block const& block) { return block.thumb_ ? 2 : 4; }
+
+    /// @brief Get how much memory cached blocks take up.
+    /// @return Approximate size of every cached block in bytes.
+    size_t MemoryUsage() const { return blockBytes_ + (blocks_.bucket_count() * sizeof(void*)); }
+
+private:
+    /// @brief Get how much memory a block takes up.
+    /// @param block Block to measure.
+    /// @return Approximate size of block and its instructions in bytes.
+    static size_t BlockBytes(Block const& block);
+
+    /// @brief Get the index into codePages_ for a work RAM address.
+    /// @param addr Work RAM address.
+    /// @return Code page index.
+    static size_t CodePageIndex(uint32_t addr);
+
+    /// @brief Get the key used to store a block.
+    /// @param addr Address of first instruction in block.
+    /// @param thumb Whether the CPU is in THUMB state.
+    /// @return Key into blocks_ map.
+    static uint32_t Key(uint32_t addr, bool thumb) { return addr | (thumb ? 0x01 : 0x00); }
+
+    std::unordered_map<uint32_t, Block> blocks_;
+    size_t blockBytes_;
+
+    // Keys of blocks overlapping each work RAM page, used for invalidation.
+    static constexpr size_t ON_BOARD_CODE_PAGES = (256 * KiB) / CODE_PAGE_SIZE;
+    static constexpr size_t ON_CHIP_CODE_PAGES = (32 * KiB) / CODE_PAGE_SIZE;
+    std::array<std::vector<uint32_t>, ON_BOARD_CODE_PAGES + ON_CHIP_CODE_PAGES> codePages_;
+
+    // Block currently being recorded
+    bool recording_;
+    Block recordingBlock_;
+};
+}
@@ -3,16 +3,14 @@
 #include <cstdint>
 #include <string>
 #include <utility>
-#include <Utilities/Functor.hpp>
 #include <Utilities/MemoryUtilities.hpp>
 
 namespace CPU { class ARM7TDMI; }
-class GameBoyAdvance;
 
 namespace CPU
 {
-typedef MemberFunctor<std::pair<uint32_t, int> (GameBoyAdvance::*)(uint32_t, AccessSize)> MemReadCallback;
-typedef MemberFunctor<int (GameBoyAdvance::*)(uint32_t, uint32_t, AccessSize)> MemWriteCallback;
+/// @brief Function that constructs and executes a specific class of ARM or THUMB instruction.
+typedef void (*InstructionHandler)(ARM7TDMI& cpu, uint32_t undecodedInstruction);
 
 constexpr int CPU_FREQUENCY_HZ = 16'777'216;
 
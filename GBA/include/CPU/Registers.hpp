@@ -5,6 +5,8 @@
 #include <cstdint>
 #include <string>
 
+class StateSerializer;
+
 namespace CPU
 {
 constexpr uint8_t SP_INDEX = 13;
@@ -17,54 +19,62 @@ public:
     /// @brief Reset the ARM registers to their power-up state.
     void Reset();
 
-    /// @brief If running without BIOS, initialize necessary registers to start execution from GamePak.
+    /// @brief Set the registers to the state the BIOS leaves them in after its intro, ready to start execution from the GamePak.
     void SkipBIOS();
 
+    /// @brief Save or load the contents of every register.
+    /// @param state Serializer to save state to or load state from.
+    void Serialize(StateSerializer& state);
+
     /// @brief Read a CPU register considering operating state and mode.
-    /// @param cpu Pointer to CPU.
     /// @param index Index of register to read.
     /// @return Value of selected register.
-    uint32_t ReadRegister(uint8_t index) const;
+    uint32_t ReadRegister(uint8_t index) const { return active_[index]; }
 
     /// @brief Read a CPU register from a specific operating mode.
-    /// @param cpu Pointer to CPU.
     /// @param index Index of register to read.
     /// @param mode Operating mode to read registers of.
     /// @return Value of selected register.
-    uint32_t ReadRegister(uint8_t index, OperatingMode mode) const;
+    uint32_t ReadRegister(uint8_t index, OperatingMode mode) const { return *RegisterOfMode(index, mode); }
 
     /// @brief Write a CPU register considering operating state and mode.
-    /// @param cpu Pointer to CPU.
     /// @param index Index of register to write.
     /// @param value Value to set register to.
-    void WriteRegister(uint8_t index, uint32_t value);
+    void WriteRegister(uint8_t index, uint32_t value)
+    {
+        if (index == PC_INDEX)
+        {
+            // Force align PC to either word or halfword depending on operating state.
+            value &= (GetOperatingState() == OperatingState::ARM) ? 0xFFFF'FFFC : 0xFFFF'FFFE;
+        }
+
+        active_[index] = value;
+    }
 
     /// @brief Write a CPU register from a specific operating mode.
-    /// @param cpu Pointer to CPU.
     /// @param index Index of register to write.
     /// @param value Value to set register to.
     /// @param mode Operating mode to write register of.
     void WriteRegister(uint8_t index, uint32_t value, OperatingMode mode);
 
     /// @brief Get current value of PC considering operating state and mode.
-    /// @param cpu Pointer to CPU.
     /// @return Value of program counter.
-    uint32_t GetPC() const { return systemAndUserRegisters_.R15_; }
+    uint32_t GetPC() const { return active_[PC_INDEX]; }
 
     /// @brief Set the PC.
     /// @param addr New address to set PC to.
-    void SetPC(uint32_t addr) { systemAndUserRegisters_.R15_ = addr; }
+    void SetPC(uint32_t addr) { active_[PC_INDEX] = addr; }
 
     /// @brief Advance the PC by either 2 or 4 depending on current operating state.
-    void AdvancePC() { systemAndUserRegisters_.R15_ += (GetOperatingState() == OperatingState::ARM) ? 4 : 2; }
+    void AdvancePC() { active_[PC_INDEX] += (GetOperatingState() == OperatingState::ARM) ? 4 : 2; }
 
     /// @brief Get the current stack pointer.
     /// @return Value of stack pointer.
-    uint32_t GetSP() const;
+    uint32_t GetSP() const { return active_[SP_INDEX]; }
 
     /// @brief Get the current link register.
     /// @return Value of link register.
-    uint32_t GetLR() const;
+    uint32_t GetLR() const { return active_[LR_INDEX]; }
 
     /// @brief Check if CPU is running in ARM or THUMB mode.
     /// @return Current CPU operating state.
@@ -78,49 +88,75 @@ public:
     /// @return Current CPU operating mode.
     OperatingMode GetOperatingMode() const { return OperatingMode{cpsr_.Mode}; }
 
-    /// @brief Set the CPU operating mode.
+    /// @brief Set the CPU operating mode, swapping in its banked registers.
     /// @param mode New operating mode.
-    void SetOperatingMode(OperatingMode mode) { cpsr_.Mode = static_cast<uint32_t>(mode); }
+    void SetOperatingMode(OperatingMode mode) { SwitchBank(static_cast<uint32_t>(mode)); cpsr_.Mode = static_cast<uint32_t>(mode); }
 
     /// @brief Check if Negative/Less Than flag is set.
     /// @return Current state of N flag.
-    bool IsNegative() const { return cpsr_.N; }
+    bool IsNegative() const { return lazyNZ_ ? ((flagResult_ & MSB_32) != 0) : cpsr_.N; }
 
     /// @brief Update the Negative/Less Than flag.
     /// @param state New value to set N flag to.
-    void SetNegative(bool state) { cpsr_.N = state; }
+    void SetNegative(bool state) { EvaluateNZ(); cpsr_.N = state; }
 
     /// @brief Check if Zero flag is set.
     /// @return Current state of Z flag.
-    bool IsZero() const { return cpsr_.Z; }
+    bool IsZero() const { return lazyNZ_ ? (flagResult_ == 0) : cpsr_.Z; }
 
     /// @brief Update the Zero flag.
     /// @param state New value to set Z flag to.
-    void SetZero(bool state) { cpsr_.Z = state; }
+    void SetZero(bool state) { EvaluateNZ(); cpsr_.Z = state; }
 
     /// @brief Check if Carry/Borrow/Extend flag is set.
     /// @return Current state of C flag.
-    bool IsCarry() const { return cpsr_.C; }
+    bool IsCarry() const { return lazyCV_ ? LazyCarry() : cpsr_.C; }
 
     /// @brief Update the Carry/Borrow/Extend flag.
     /// @param state New value to set C flag to.
-    void SetCarry(bool state) { cpsr_.C = state; }
+    void SetCarry(bool state) { EvaluateCV(); cpsr_.C = state; }
 
     /// @brief Check if Overflow flag is set.
     /// @return Current state of V flag.
-    bool IsOverflow() const { return cpsr_.V; }
+    bool IsOverflow() const { return lazyCV_ ? LazyOverflow() : cpsr_.V; }
 
     /// @brief Update the Overflow flag.
     /// @param state New value to set V flag to.
-    void SetOverflow(bool state) { cpsr_.V = state; }
+    void SetOverflow(bool state) { EvaluateCV(); cpsr_.V = state; }
+
+    /// @brief Lazily update the N and Z flags based on the result of an operation. C and V are unchanged, so any pending C and V
+    ///        are evaluated first since V is derived from the result being replaced.
+    /// @param result Result of operation.
+    void SetNZFlags(uint32_t result) { EvaluateCV(); flagResult_ = result; lazyNZ_ = true; }
+
+    /// @brief Update flags for a logical or shift operation. N and Z are lazily updated based on the result, V is unchanged.
+    /// @param result Result of operation.
+    /// @param carry New value to set C flag to.
+    void SetLogicalFlags(uint32_t result, bool carry) { SetCarry(carry); SetNZFlags(result); }
+
+    /// @brief Lazily update all flags for an arithmetic operation of the form result = op1 + op2 + carryIn. Subtraction of the
+    ///        form op1 - op2 - !C is expressed as op1 + ~op2 + C. Flags are only evaluated once something reads them.
+    /// @param op1 First addition operand.
+    /// @param op2 Second addition operand.
+    /// @param carryIn Carry into the addition.
+    /// @param result Result of operation.
+    void SetArithmeticFlags(uint32_t op1, uint32_t op2, bool carryIn, uint32_t result)
+    {
+        flagOp1_ = op1;
+        flagOp2_ = op2;
+        flagCarryIn_ = carryIn;
+        flagResult_ = result;
+        lazyNZ_ = true;
+        lazyCV_ = true;
+    }
 
     /// @brief Get the current value of CPSR.
     /// @return Current CPSR.
-    uint32_t GetCPSR() const { return cpsr_.Register; }
+    uint32_t GetCPSR() const;
 
-    /// @brief Set the entire CPSR register to a new value.
+    /// @brief Set the entire CPSR register to a new value, swapping in the banked registers of its mode.
     /// @param cpsr New value for CPSR register.
-    void SetCPSR(uint32_t cpsr) { cpsr_.Register = cpsr; }
+    void SetCPSR(uint32_t cpsr) { SwitchBank(cpsr); cpsr_.Register = cpsr; lazyNZ_ = false; lazyCV_ = false; }
 
     /// @brief Get the current operating mode's SPSR value.
     /// @return Current SPSR.
@@ -149,11 +185,74 @@ public:
     /// @param state New value to set F flag to. true = disabled, false = enabled.
     void SetFiqDisabled(bool state) { cpsr_.F = state; }
 
-    /// @brief Convert CPU registers to a human readable format.
-    /// @return String representing current register state.
-    std::string SetRegistersString() const;
-
 private:
+    // Banks of registers that are swapped in by mode switches
+    static constexpr size_t USER_BANK = 0;
+    static constexpr size_t FIQ_BANK = 1;
+    static constexpr size_t SUPERVISOR_BANK = 2;
+    static constexpr size_t ABORT_BANK = 3;
+    static constexpr size_t IRQ_BANK = 4;
+    static constexpr size_t UNDEFINED_BANK = 5;
+    static constexpr size_t BANK_COUNT = 6;
+
+    /// @brief Get the bank of registers used by a mode.
+    /// @param mode Mode bits of CPSR. Only the lowest 5 bits are checked.
+    /// @return Bank index. Modes that don't exist use the user bank.
+    static size_t BankIndex(uint32_t mode)
+    {
+        switch (OperatingMode{mode & 0x1F})
+        {
+            case OperatingMode::FIQ:
+                return FIQ_BANK;
+            case OperatingMode::Supervisor:
+                return SUPERVISOR_BANK;
+            case OperatingMode::Abort:
+                return ABORT_BANK;
+            case OperatingMode::IRQ:
+                return IRQ_BANK;
+            case OperatingMode::Undefined:
+                return UNDEFINED_BANK;
+            default:
+                return USER_BANK;
+        }
+    }
+
+    /// @brief Swap in the bank of registers used by a mode if it isn't already active. Call whenever the mode bits of CPSR change.
+    /// @param mode Mode bits of CPSR being switched to. Only the lowest 5 bits are checked.
+    void SwitchBank(uint32_t mode)
+    {
+        size_t bank = BankIndex(mode);
+
+        if (bank != bank_)
+        {
+            SwapBanks(bank);
+        }
+    }
+
+    /// @brief Store the active banked registers and load the registers of another bank in their place.
+    /// @param bank Bank to make active.
+    void SwapBanks(size_t bank);
+
+    /// @brief Find where a register of a mode is currently held.
+    /// @param index Index of register.
+    /// @param mode Mode to find the register of.
+    /// @return Pointer to active register if the mode's bank is active or the register isn't banked, otherwise to its banked copy.
+    uint32_t const* RegisterOfMode(uint8_t index, OperatingMode mode) const;
+
+    /// @brief Write any lazily evaluated N and Z flags into CPSR.
+    void EvaluateNZ();
+
+    /// @brief Write any lazily evaluated C and V flags into CPSR.
+    void EvaluateCV();
+
+    /// @brief Calculate the carry flag of the last arithmetic operation.
+    /// @return Carry out of last arithmetic operation.
+    bool LazyCarry() const { return (static_cast<uint64_t>(flagOp1_) + flagOp2_ + flagCarryIn_) > MAX_U32; }
+
+    /// @brief Calculate the overflow flag of the last arithmetic operation.
+    /// @return Signed overflow of last arithmetic operation.
+    bool LazyOverflow() const { return (~(flagOp1_ ^ flagOp2_) & (flagOp1_ ^ flagResult_) & MSB_32) != 0; }
+
     // CPSR layout
     union CPSR
     {
@@ -176,179 +275,25 @@ private:
     // Register data
     CPSR cpsr_;
 
-    struct
-    {
-        uint32_t R0_;
-        uint32_t R1_;
-        uint32_t R2_;
-        uint32_t R3_;
-        uint32_t R4_;
-        uint32_t R5_;
-        uint32_t R6_;
-        uint32_t R7_;
-        uint32_t R8_;
-        uint32_t R9_;
-        uint32_t R10_;
-        uint32_t R11_;
-        uint32_t R12_;
-        uint32_t R13_;
-        uint32_t R14_;
-        uint32_t R15_;
-    } systemAndUserRegisters_;
-
-    struct
-    {
-        uint32_t R8_;
-        uint32_t R9_;
-        uint32_t R10_;
-        uint32_t R11_;
-        uint32_t R12_;
-        uint32_t R13_;
-        uint32_t R14_;
-        CPSR spsr_;
-    } fiqRegisters_;
-
-    struct
-    {
-        uint32_t R13_;
-        uint32_t R14_;
-        CPSR spsr_;
-    } supervisorRegisters_;
-
-    struct
-    {
-        uint32_t R13_;
-        uint32_t R14_;
-        CPSR spsr_;
-    } abortRegisters_;
-
-    struct
-    {
-        uint32_t R13_;
-        uint32_t R14_;
-        CPSR spsr_;
-    } irqRegisters_;
-
-    struct
-    {
-        uint32_t R13_;
-        uint32_t R14_;
-        CPSR spsr_;
-    } undefinedRegisters_;
-
-    // Register lookups
-    std::array<uint32_t*, 16> systemAndUserRegistersLUT_ = {
-        &systemAndUserRegisters_.R0_,
-        &systemAndUserRegisters_.R1_,
-        &systemAndUserRegisters_.R2_,
-        &systemAndUserRegisters_.R3_,
-        &systemAndUserRegisters_.R4_,
-        &systemAndUserRegisters_.R5_,
-        &systemAndUserRegisters_.R6_,
-        &systemAndUserRegisters_.R7_,
-        &systemAndUserRegisters_.R8_,
-        &systemAndUserRegisters_.R9_,
-        &systemAndUserRegisters_.R10_,
-        &systemAndUserRegisters_.R11_,
-        &systemAndUserRegisters_.R12_,
-        &systemAndUserRegisters_.R13_,
-        &systemAndUserRegisters_.R14_,
-        &systemAndUserRegisters_.R15_
-    };
-
-    std::array<uint32_t*, 16> fiqRegistersLUT_ = {
-        &systemAndUserRegisters_.R0_,
-        &systemAndUserRegisters_.R1_,
-        &systemAndUserRegisters_.R2_,
-        &systemAndUserRegisters_.R3_,
-        &systemAndUserRegisters_.R4_,
-        &systemAndUserRegisters_.R5_,
-        &systemAndUserRegisters_.R6_,
-        &systemAndUserRegisters_.R7_,
-        &fiqRegisters_.R8_,
-        &fiqRegisters_.R9_,
-        &fiqRegisters_.R10_,
-        &fiqRegisters_.R11_,
-        &fiqRegisters_.R12_,
-        &fiqRegisters_.R13_,
-        &fiqRegisters_.R14_,
-        &systemAndUserRegisters_.R15_
-    };
-
-    std::array<uint32_t*, 16> supervisorRegistersLUT_ = {
-        &systemAndUserRegisters_.R0_,
-        &systemAndUserRegisters_.R1_,
-        &systemAndUserRegisters_.R2_,
-        &systemAndUserRegisters_.R3_,
-        &systemAndUserRegisters_.R4_,
-        &systemAndUserRegisters_.R5_,
-        &systemAndUserRegisters_.R6_,
-        &systemAndUserRegisters_.R7_,
-        &systemAndUserRegisters_.R8_,
-        &systemAndUserRegisters_.R9_,
-        &systemAndUserRegisters_.R10_,
-        &systemAndUserRegisters_.R11_,
-        &systemAndUserRegisters_.R12_,
-        &supervisorRegisters_.R13_,
-        &supervisorRegisters_.R14_,
-        &systemAndUserRegisters_.R15_
-    };
-
-    std::array<uint32_t*, 16> abortRegistersLUT_ = {
-        &systemAndUserRegisters_.R0_,
-        &systemAndUserRegisters_.R1_,
-        &systemAndUserRegisters_.R2_,
-        &systemAndUserRegisters_.R3_,
-        &systemAndUserRegisters_.R4_,
-        &systemAndUserRegisters_.R5_,
-        &systemAndUserRegisters_.R6_,
-        &systemAndUserRegisters_.R7_,
-        &systemAndUserRegisters_.R8_,
-        &systemAndUserRegisters_.R9_,
-        &systemAndUserRegisters_.R10_,
-        &systemAndUserRegisters_.R11_,
-        &systemAndUserRegisters_.R12_,
-        &abortRegisters_.R13_,
-        &abortRegisters_.R14_,
-        &systemAndUserRegisters_.R15_
-    };
-
-    std::array<uint32_t*, 16> irqRegistersLUT_ = {
-        &systemAndUserRegisters_.R0_,
-        &systemAndUserRegisters_.R1_,
-        &systemAndUserRegisters_.R2_,
-        &systemAndUserRegisters_.R3_,
-        &systemAndUserRegisters_.R4_,
-        &systemAndUserRegisters_.R5_,
-        &systemAndUserRegisters_.R6_,
-        &systemAndUserRegisters_.R7_,
-        &systemAndUserRegisters_.R8_,
-        &systemAndUserRegisters_.R9_,
-        &systemAndUserRegisters_.R10_,
-        &systemAndUserRegisters_.R11_,
-        &systemAndUserRegisters_.R12_,
-        &irqRegisters_.R13_,
-        &irqRegisters_.R14_,
-        &systemAndUserRegisters_.R15_
-    };
-
-    std::array<uint32_t*, 16> undefinedRegistersLUT_ = {
-        &systemAndUserRegisters_.R0_,
-        &systemAndUserRegisters_.R1_,
-        &systemAndUserRegisters_.R2_,
-        &systemAndUserRegisters_.R3_,
-        &systemAndUserRegisters_.R4_,
-        &systemAndUserRegisters_.R5_,
-        &systemAndUserRegisters_.R6_,
-        &systemAndUserRegisters_.R7_,
-        &systemAndUserRegisters_.R8_,
-        &systemAndUserRegisters_.R9_,
-        &systemAndUserRegisters_.R10_,
-        &systemAndUserRegisters_.R11_,
-        &systemAndUserRegisters_.R12_,
-        &undefinedRegisters_.R13_,
-        &undefinedRegisters_.R14_,
-        &systemAndUserRegisters_.R15_
-    };
+    // Lazy flag evaluation. While lazyNZ_ or lazyCV_ is set, the corresponding CPSR bits are stale and must be derived from the
+    // last flag setting operation.
+    uint32_t flagResult_;
+    uint32_t flagOp1_;
+    uint32_t flagOp2_;
+    bool flagCarryIn_;
+    bool lazyNZ_;
+    bool lazyCV_;
+
+    // Registers of the current mode. Banked registers are only copied in and out when the mode switches, so every access by an
+    // instruction is a plain index.
+    std::array<uint32_t, 16> active_;
+    size_t bank_;
+
+    // Inactive copies of banked registers. R13 and R14 are banked per mode, while R8-R12 are only banked by FIQ mode. SPSRs
+    // are never active, and the user bank has none.
+    std::array<std::array<uint32_t, 2>, BANK_COUNT> bankedSpLr_;
+    std::array<uint32_t, 5> userR8ToR12_;
+    std::array<uint32_t, 5> fiqR8ToR12_;
+    std::array<CPSR, BANK_COUNT> spsr_;
 };
 }
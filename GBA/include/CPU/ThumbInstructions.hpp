@@ -1,17 +1,26 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
-#include <CPU/CPUTypes.hpp>
+#include <string>
+#include <CPU/CpuTypes.hpp>
 
 namespace CPU { class ARM7TDMI; }
 
 namespace CPU::THUMB
 {
-/// @brief Decode a 16 bit value into a THUMB instruction.
+constexpr size_t THUMB_DECODE_TABLE_SIZE = 1024;
+
+/// @brief Decode a 16 bit value into a THUMB instruction handler using a precomputed table indexed by the top 10 bits.
 /// @param undecodedInstruction 16 bit value to decode.
-/// @param buffer Pointer to buffer to place instruction object.
-/// @return Pointer to newly constructed instruction object.
-CPU::Instruction* DecodeInstruction(uint16_t undecodedInstruction, void* buffer);
+/// @return Handler that constructs and executes the decoded instruction.
+InstructionHandler LookupHandler(uint16_t undecodedInstruction);
+
+/// @brief Generate a human readable mnemonic for a THUMB instruction.
+/// @param undecodedInstruction 16 bit value to disassemble.
+/// @param registers Register values at the time the instruction was executed, used to resolve branch targets.
+/// @return Mnemonic of instruction.
+std::string Disassemble(uint16_t undecodedInstruction, std::array<uint32_t, 16> const& registers);
 
 class SoftwareInterrupt : public virtual Instruction
 {
@@ -30,11 +39,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
     void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint16_t FORMAT =      0b1101'1111'0000'0000;
     static constexpr uint16_t FORMAT_MASK = 0b1111'1111'0000'0000;
 
@@ -67,12 +76,12 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
-    /// @param newPC New PC to branch to.
-    void SetMnemonic(std::string& mnemonic, uint32_t newPC);
+    /// @param registers Register values at the time this instruction was executed.
+    void SetMnemonic(std::string& mnemonic, std::array<uint32_t, 16> const& registers);
 
+private:
     static constexpr uint16_t FORMAT =      0b1110'0000'0000'0000;
     static constexpr uint16_t FORMAT_MASK = 0b1111'1000'0000'0000;
 
@@ -105,12 +114,12 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
-    /// @param newPC New PC to branch to.
-    void SetMnemonic(std::string& mnemonic, uint32_t newPC);
+    /// @param registers Register values at the time this instruction was executed.
+    void SetMnemonic(std::string& mnemonic, std::array<uint32_t, 16> const& registers);
 
+private:
     static constexpr uint16_t FORMAT =      0b1101'0000'0000'0000;
     static constexpr uint16_t FORMAT_MASK = 0b1111'0000'0000'0000;
 
@@ -144,11 +153,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
     void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint16_t FORMAT =      0b1100'0000'0000'0000;
     static constexpr uint16_t FORMAT_MASK = 0b1111'0000'0000'0000;
 
@@ -183,12 +192,12 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
-    /// @param newPC New PC value to branch to when H=1.
-    void SetMnemonic(std::string& mnemonic, uint32_t newPC);
+    /// @param registers Register values at the time this instruction was executed.
+    void SetMnemonic(std::string& mnemonic, std::array<uint32_t, 16> const& registers);
 
+private:
     static constexpr uint16_t FORMAT =      0b1111'0000'0000'0000;
     static constexpr uint16_t FORMAT_MASK = 0b1111'0000'0000'0000;
 
@@ -222,12 +231,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
-    /// @param offset Offset to add/subtract to SP.
-    void SetMnemonic(std::string& mnemonic, uint16_t offset);
+    void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint16_t FORMAT =      0b1011'0000'0000'0000;
     static constexpr uint16_t FORMAT_MASK = 0b1111'1111'0000'0000;
 
@@ -261,11 +269,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
     void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint16_t FORMAT =      0b1011'0100'0000'0000;
     static constexpr uint16_t FORMAT_MASK = 0b1111'0110'0000'0000;
 
@@ -301,11 +309,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
     void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint16_t FORMAT =      0b1000'0000'0000'0000;
     static constexpr uint16_t FORMAT_MASK = 0b1111'0000'0000'0000;
 
@@ -341,11 +349,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
     void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint16_t FORMAT =      0b1001'0000'0000'0000;
     static constexpr uint16_t FORMAT_MASK = 0b1111'0000'0000'0000;
 
@@ -380,13 +388,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
-    /// @param destIndex Register index to store address.
-    /// @param offset Offset added to PC/SP.
-    void SetMnemonic(std::string& mnemonic, uint8_t destIndex, uint16_t offset);
+    void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint16_t FORMAT =      0b1010'0000'0000'0000;
     static constexpr uint16_t FORMAT_MASK = 0b1111'0000'0000'0000;
 
@@ -421,11 +427,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
     void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint16_t FORMAT =      0b0110'0000'0000'0000;
     static constexpr uint16_t FORMAT_MASK = 0b1110'0000'0000'0000;
 
@@ -462,11 +468,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
     void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint16_t FORMAT =      0b0101'0000'0000'0000;
     static constexpr uint16_t FORMAT_MASK = 0b1111'0010'0000'0000;
 
@@ -504,11 +510,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
     void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint16_t FORMAT =      0b0101'0010'0000'0000;
     static constexpr uint16_t FORMAT_MASK = 0b1111'0010'0000'0000;
 
@@ -546,11 +552,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
     void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint16_t FORMAT =      0b0100'1000'0000'0000;
     static constexpr uint16_t FORMAT_MASK = 0b1111'1000'0000'0000;
 
@@ -584,13 +590,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
-    /// @param destIndex Register index to save result to.
-    /// @param srcIndex Register index source of operand.
-    void SetMnemonic(std::string& mnemonic, uint8_t destIndex, uint8_t srcIndex);
+    void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint16_t FORMAT =      0b0100'0100'0000'0000;
     static constexpr uint16_t FORMAT_MASK = 0b1111'1100'0000'0000;
 
@@ -627,11 +631,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
     void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint16_t FORMAT =      0b0100'0000'0000'0000;
     static constexpr uint16_t FORMAT_MASK = 0b1111'1100'0000'0000;
 
@@ -666,11 +670,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
     void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint16_t FORMAT =      0b0010'0000'0000'0000;
     static constexpr uint16_t FORMAT_MASK = 0b1110'0000'0000'0000;
 
@@ -705,11 +709,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
     void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint16_t FORMAT =      0b0001'1000'0000'0000;
     static constexpr uint16_t FORMAT_MASK = 0b1111'1000'0000'0000;
 
@@ -746,11 +750,11 @@ public:
     /// @param cpu Reference to the ARM CPU.
     void Execute(ARM7TDMI& cpu) override;
 
-private:
     /// @brief Generate a mnemonic string for this instruction.
     /// @param mnemonic String to assign mnemonic to.
     void SetMnemonic(std::string& mnemonic);
 
+private:
     static constexpr uint16_t FORMAT =      0b0000'0000'0000'0000;
     static constexpr uint16_t FORMAT_MASK = 0b1110'0000'0000'0000;
 
@@ -4,10 +4,15 @@
 #include <filesystem>
 #include <utility>
 #include <vector>
+#include <Cartridge/SaveFile.hpp>
 #include <Utilities/MemoryUtilities.hpp>
 
 namespace fs = std::filesystem;
 
+class EventScheduler;
+class StateSerializer;
+class SystemControl;
+
 namespace Cartridge
 {
 class EEPROM
@@ -15,7 +20,11 @@ class EEPROM
 public:
     /// @brief Initialize EEPROM storage.
     /// @param savePath Path to save file. Load existing save if present.
-    EEPROM(fs::path savePath);
+    /// @param sizeInBytes Size of EEPROM (512 bytes or 8 KiB) if known. Otherwise it's determined by the save file or the length
+    ///                    of the first index written.
+    /// @param scheduler Scheduler used to tell when writes go quiet.
+    /// @param systemControl System control to get wait states from.
+    EEPROM(fs::path savePath, size_t sizeInBytes, EventScheduler const& scheduler, SystemControl const& systemControl);
 
     /// @brief Write save data to save file.
     ~EEPROM();
@@ -53,9 +62,21 @@ public:
     /// @return Number of cycles taken to write to EEPROM.
     int WriteDoubleWord(size_t index, size_t indexLength, uint64_t value);
 
+    /// @brief Queue save data to be written to the save file if it's changed and gone long enough without being written.
+    void CheckSaveFlush();
+
+    /// @brief Get the size of the backup media.
+    /// @return Size in bytes.
+    size_t Size() const { return eeprom_.size() * sizeof(uint64_t); }
+
+    /// @brief Save or load the contents of backup media. Loaded contents are written to the save file like any other write.
+    /// @param state Serializer to save state to or load state from.
+    void Serialize(StateSerializer& state);
+
 private:
-    fs::path const savePath_;
+    SaveFile saveFile_;
     uint16_t currentIndex_;
     std::vector<uint64_t> eeprom_;
+    SystemControl const& systemControl_;
 };
 }
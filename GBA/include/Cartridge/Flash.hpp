@@ -5,10 +5,15 @@
 #include <filesystem>
 #include <utility>
 #include <vector>
+#include <Cartridge/SaveFile.hpp>
 #include <Utilities/MemoryUtilities.hpp>
 
 namespace fs = std::filesystem;
 
+class EventScheduler;
+class StateSerializer;
+class SystemControl;
+
 namespace Cartridge
 {
 constexpr size_t FLASH_BANK_SIZE = 64 * KiB;
@@ -53,7 +58,9 @@ public:
     /// @brief Initialize Flash storage.
     /// @param savePath Path to save file. Load existing save if present.
     /// @param flashSizeInBytes Size of flash storage in bytes.
-    Flash(fs::path savePath, size_t flashSizeInBytes);
+    /// @param scheduler Scheduler used to tell when writes go quiet.
+    /// @param systemControl System control to get wait states from.
+    Flash(fs::path savePath, size_t flashSizeInBytes, EventScheduler const& scheduler, SystemControl const& systemControl);
 
     /// @brief Write save data to save file.
     ~Flash();
@@ -74,12 +81,24 @@ public:
     /// @return Number of cycles taken to write/issue command.
     int Write(uint32_t addr, uint32_t value, AccessSize alignment);
 
+    /// @brief Queue save data to be written to the save file if it's changed and gone long enough without being written.
+    void CheckSaveFlush();
+
+    /// @brief Get the size of the backup media.
+    /// @return Size in bytes.
+    size_t Size() const { return flash_.size() * FLASH_BANK_SIZE; }
+
+    /// @brief Save or load the contents of backup media. Loaded contents are written to the save file like any other write.
+    /// @param state Serializer to save state to or load state from.
+    void Serialize(StateSerializer& state);
+
 private:
-    fs::path const savePath_;
+    SaveFile saveFile_;
     FlashState state_;
     bool chipIdMode_;
     bool eraseMode_;
     size_t bank_;
     std::vector<std::array<uint8_t, FLASH_BANK_SIZE>> flash_;
+    SystemControl const& systemControl_;
 };
 }
@@ -9,29 +9,42 @@
 #include <vector>
 #include <Cartridge/EEPROM.hpp>
 #include <Cartridge/Flash.hpp>
+#include <Cartridge/RomDatabase.hpp>
 #include <Cartridge/SRAM.hpp>
+#include <System/SystemControl.hpp>
+#include <Utilities/MappedFile.hpp>
 #include <Utilities/MemoryUtilities.hpp>
 
+class EventScheduler;
+class StateSerializer;
+
 namespace fs = std::filesystem;
 
 namespace Cartridge
 {
 constexpr uint32_t MAX_ROM_SIZE = 32 * MiB;
 
-enum class BackupType
-{
-    None,
-    SRAM,
-    EEPROM,
-    FLASH
-};
+constexpr size_t CARTRIDGE_HEADER_SIZE = 0xC0;
+constexpr size_t GAME_CODE_OFFSET = 0xAC;
 
 class GamePak
 {
 public:
     /// @brief Initialize a Game Pak.
     /// @param romPath Path to GBA ROM file.
-    GamePak(fs::path romPath);
+    /// @param scheduler Scheduler used to time prefetching and save file flushes.
+    /// @param systemControl System control to get wait states and prefetch settings from.
+    GamePak(fs::path romPath, EventScheduler const& scheduler, SystemControl const& systemControl);
+
+    /// @brief Initialize a Game Pak that shares another's ROM data instead of loading it again. Its backup media starts out empty
+    ///        and isn't tied to a save file, so it never overwrites the other Game Pak's save. Load a state to fill it in.
+    /// @param parent Game Pak to share ROM data with.
+    /// @param scheduler Scheduler used to time prefetching.
+    /// @param systemControl System control to get wait states and prefetch settings from.
+    GamePak(GamePak const& parent, EventScheduler const& scheduler, SystemControl const& systemControl);
+
+    GamePak(GamePak const&) = delete;
+    GamePak& operator=(GamePak const&) = delete;
 
     /// @brief Reset the GamePak to its power-up state.
     void Reset();
@@ -44,6 +57,44 @@ public:
     /// @return Title of ROM.
     std::string RomTitle() const { return romTitle_; }
 
+    /// @brief Access the raw ROM data.
+    /// @return Raw pointer to ROM.
+    uint8_t* GetRawROM() { return romData_; }
+
+    /// @brief Get the size of the loaded ROM.
+    /// @return Size of ROM in bytes.
+    size_t RomSize() const { return romSize_; }
+
+    /// @brief Get how much memory is used by backup media.
+    /// @return Size of backup media in bytes.
+    size_t BackupSize() const;
+
+    /// @brief Get the CRC of the loaded ROM's cartridge header. Used to identify which ROM a save state belongs to.
+    /// @return CRC-32 of cartridge header, or 0 if the ROM is too small to have one.
+    uint32_t HeaderCrc() const { return headerCrc_; }
+
+    /// @brief Calculate the number of cycles a ROM access takes and update the prefetch buffer. Used by accesses that read ROM
+    ///        data directly instead of through ReadGamePak.
+    /// @param addr Address being read. Must map to loaded ROM.
+    /// @param alignment BYTE, HALFWORD, or WORD.
+    /// @return Number of cycles taken to read.
+    int RomAccessCycles(uint32_t addr, AccessSize alignment);
+
+    /// @brief Calculate the number of cycles a run of consecutive ROM accesses takes and update the prefetch buffer. Equivalent to
+    ///        calling RomAccessCycles on each address in order until either the count or cycle limit is reached.
+    /// @param addr Address of the first access. The whole run must map to loaded ROM.
+    /// @param alignment BYTE, HALFWORD, or WORD.
+    /// @param maxCount Max number of accesses.
+    /// @param maxCycles Stop once this many cycles have passed. At least one access is always made.
+    /// @param cyclesBetweenAccesses Cycles spent after each access, such as writing out the value read. These count towards
+    ///                              maxCycles but aren't included in the returned cycle count.
+    /// @return Number of accesses made and number of cycles taken to read.
+    std::pair<uint32_t, int> RomBurstCycles(uint32_t addr,
+                                            AccessSize alignment,
+                                            uint32_t maxCount,
+                                            int maxCycles,
+                                            int cyclesBetweenAccesses);
+
     /// @brief Read an address on the cartridge. Includes ROM, SRAM, EEPROM, and Flash.
     /// @param addr Address to read.
     /// @param alignment BYTE, HALFWORD, or WORD.
@@ -89,10 +140,27 @@ public:
     /// @return Total number of cycles taken to write to EEPROM.
     int WriteToEeprom(size_t index, int indexLength, uint64_t value);
 
+    /// @brief Queue backup media to be written to its save file on a background thread if it's changed and gone long enough
+    ///        without being written. Call periodically from the emulation thread.
+    void CheckSaveFlush();
+
+    /// @brief Save or load the prefetch buffer and the contents and state of backup media.
+    /// @param state Serializer to save state to or load state from.
+    void Serialize(StateSerializer& state);
+
 private:
     std::tuple<uint32_t, int, bool> ReadROM(uint32_t addr, AccessSize alignment);
 
-    /// @brief Read the ROM for a string indicating what type of backup media this cartridge contains.
+    /// @brief Calculate the number of cycles a ROM access takes and update the prefetch buffer.
+    /// @param addr Address being read, adjusted to be relative to wait state 0 region.
+    /// @param region Which wait state region is being accessed.
+    /// @param alignment BYTE, HALFWORD, or WORD.
+    /// @param currentCycle Low 32 bits of the cycle count the access starts on.
+    /// @return Number of cycles taken to read.
+    int AccessTiming(uint32_t addr, WaitState region, AccessSize alignment, uint32_t currentCycle);
+
+    /// @brief Search the ROM for a string indicating what type of backup media this cartridge contains. The first match at a word
+    ///        aligned offset is used.
     /// @return Backup type and if relevant, size of backup media in bytes.
     std::pair<BackupType, size_t> DetectBackupType();
 
@@ -100,9 +168,13 @@ private:
     bool romLoaded_;
     std::string romTitle_;
     fs::path romPath_;
+    uint32_t headerCrc_;
 
-    // Memory
-    std::vector<uint8_t> ROM_;
+    // Memory. ROM data is mapped from the file when possible, otherwise it's read into ROM_. Either is shared with clones.
+    std::shared_ptr<MappedFile> mappedROM_;
+    std::shared_ptr<std::vector<uint8_t>> ROM_;
+    uint8_t* romData_;
+    size_t romSize_;
 
     // Backup Media
     BackupType backupType_;
@@ -110,9 +182,14 @@ private:
     std::unique_ptr<Flash> flash_;
     std::unique_ptr<SRAM> sram_;
 
-    // Prefetch buffer and access timing info
+    // Prefetch buffer and access timing info. Idle time on the Game Pak bus is measured against the scheduler's cycle count, which
+    // is a single load of a counter that the CPU, DMA, and halting already advance. Having the CPU report idle cycles instead
+    // would mean bumping a second counter everywhere those advance the clock, which costs more than the load it replaces.
     uint32_t nextSequentialAddr_;
-    uint64_t lastReadCompletionCycle_;
-    int prefetchedWaitStates_;
+    uint32_t lastReadCompletionCycle_;
+    uint32_t prefetchedWaitStates_;
+
+    EventScheduler const& scheduler_;
+    SystemControl const& systemControl_;
 };
 }
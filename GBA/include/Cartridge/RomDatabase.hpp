@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace fs = std::filesystem;
+
+namespace Cartridge
+{
+enum class BackupType
+{
+    None,
+    SRAM,
+    EEPROM,
+    FLASH
+};
+
+/// @brief Backup media info for a ROM.
+struct RomInfo
+{
+    BackupType backupType_;
+
+    /// @brief Size of backup media in bytes. For EEPROM, 0 means the size is detected from the save file or first access.
+    size_t backupSize_;
+};
+
+/// @brief On-disk database of backup media info, keyed by game code and a CRC of the cartridge header. Detected entries are added
+///        automatically so that repeat loads skip scanning the ROM. Entries can be edited by hand to override wrong detection.
+///
+///        The file is plain text with one entry per line: game code, header CRC in hex, backup type (NONE, SRAM, EEPROM, or FLASH),
+///        and backup size in bytes. For example: "AXVE 8F1D1A6B FLASH 131072". Blank lines and lines starting with '#' are ignored.
+class RomDatabase
+{
+public:
+    /// @brief Load a ROM database.
+    /// @param databasePath Path to database file. If empty, the database is disabled.
+    explicit RomDatabase(fs::path databasePath);
+
+    /// @brief Look up the backup media info of a ROM.
+    /// @param gameCode Four character game code from the cartridge header.
+    /// @param headerCrc CRC-32 of the cartridge header.
+    /// @return Backup media info if the ROM is in the database.
+    std::optional<RomInfo> Lookup(std::string const& gameCode, uint32_t headerCrc) const;
+
+    /// @brief Add a ROM to the database and append it to the database file.
+    /// @param gameCode Four character game code from the cartridge header.
+    /// @param headerCrc CRC-32 of the cartridge header.
+    /// @param info Backup media info.
+    void Store(std::string const& gameCode, uint32_t headerCrc, RomInfo info);
+
+    /// @brief Calculate the CRC-32 of a block of memory.
+    /// @param data Pointer to data.
+    /// @param length Number of bytes.
+    /// @return CRC-32 of data.
+    static uint32_t Crc32(uint8_t const* data, size_t length);
+
+private:
+    fs::path const databasePath_;
+    std::map<std::pair<std::string, uint32_t>, RomInfo> entries_;
+};
+}
@@ -4,10 +4,15 @@
 #include <cstdint>
 #include <filesystem>
 #include <utility>
+#include <Cartridge/SaveFile.hpp>
 #include <Utilities/MemoryUtilities.hpp>
 
 namespace fs = std::filesystem;
 
+class EventScheduler;
+class StateSerializer;
+class SystemControl;
+
 namespace Cartridge
 {
 class SRAM
@@ -15,7 +20,9 @@ class SRAM
 public:
     /// @brief Initialize SRAM storage.
     /// @param savePath Path to save file. Load existing save if present.
-    SRAM(fs::path savePath);
+    /// @param scheduler Scheduler used to tell when writes go quiet.
+    /// @param systemControl System control to get wait states from.
+    SRAM(fs::path savePath, EventScheduler const& scheduler, SystemControl const& systemControl);
 
     /// @brief Write save data to save file.
     ~SRAM();
@@ -33,8 +40,20 @@ public:
     /// @return Number of cycles taken to write.
     int Write(uint32_t addr, uint32_t value, AccessSize alignment);
 
+    /// @brief Queue save data to be written to the save file if it's changed and gone long enough without being written.
+    void CheckSaveFlush();
+
+    /// @brief Get the size of the backup media.
+    /// @return Size in bytes.
+    size_t Size() const { return sram_.size(); }
+
+    /// @brief Save or load the contents of backup media. Loaded contents are written to the save file like any other write.
+    /// @param state Serializer to save state to or load state from.
+    void Serialize(StateSerializer& state);
+
 private:
-    fs::path const savePath_;
+    SaveFile saveFile_;
     std::array<uint8_t, 32 * KiB> sram_;
+    SystemControl const& systemControl_;
 };
 }
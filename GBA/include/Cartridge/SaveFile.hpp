@@ -0,0 +1,76 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <CPU/CpuTypes.hpp>
+
+class EventScheduler;
+
+namespace fs = std::filesystem;
+
+namespace Cartridge
+{
+/// @brief How long backup media has to go without being written before it's flushed to its save file. Measured in emulated
+///        cycles so that games which write a save over several frames get a single flush.
+constexpr uint64_t SAVE_FLUSH_DELAY_CYCLES = CPU::CPU_FREQUENCY_HZ / 2;
+
+/// @brief Persists backup media to disk on a background thread. Backup media marks itself dirty when written, and once writes go
+///        quiet a snapshot is handed off to the I/O thread so that the emulation thread never waits on disk. Each flush writes a
+///        temporary file and renames it over the save file, so a crash mid-write leaves the previous save intact.
+class SaveFile
+{
+public:
+    /// @brief Start the I/O thread for a save file.
+    /// @param savePath Path to save file. If empty, the backup media isn't persisted at all, no thread is started, and flushes
+    ///                 are dropped.
+    /// @param scheduler Scheduler used to tell how long it's been since the last write.
+    SaveFile(fs::path savePath, EventScheduler const& scheduler);
+
+    /// @brief Finish any pending write and stop the I/O thread.
+    ~SaveFile();
+
+    SaveFile(SaveFile const&) = delete;
+    SaveFile& operator=(SaveFile const&) = delete;
+
+    /// @brief Record that the backup media was just written.
+    void MarkDirty();
+
+    /// @brief Check if the backup media has changed and gone long enough without being written to flush it.
+    /// @return True if Flush should be called.
+    bool FlushDue() const;
+
+    /// @brief Copy the contents of backup media and queue them to be written to the save file.
+    /// @param data Pointer to backup media.
+    /// @param size Size of backup media in bytes.
+    void Flush(uint8_t const* data, size_t size);
+
+private:
+    /// @brief Main loop of the I/O thread. Writes each snapshot queued by Flush until the save file is destroyed.
+    void WriterLoop();
+
+    /// @brief Write data to a temporary file and replace the save file with it.
+    /// @param data Data to write.
+    void WriteAtomically(std::vector<uint8_t> const& data);
+
+    fs::path const savePath_;
+
+    // Emulation thread only
+    bool dirty_;
+    uint64_t lastWriteCycle_;
+    EventScheduler const& scheduler_;
+
+    // Shared with I/O thread
+    std::mutex lock_;
+    std::condition_variable cv_;
+    std::vector<uint8_t> pendingData_;
+    bool writePending_;
+    bool stop_;
+
+    std::thread writerThread_;
+};
+}
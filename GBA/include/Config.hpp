@@ -14,4 +14,28 @@
     #define BIOS_PATH ""
 #endif
 
+#ifdef _DISABLE_LOGGING
+    #define LOGGING_ENABLED false
+#else
+    #define LOGGING_ENABLED true
+#endif
+
+#ifdef _ENABLE_PROFILER
+    #define PROFILER_ENABLED true
+#else
+    #define PROFILER_ENABLED false
+#endif
+
+#ifdef _ENABLE_COMPONENT_TELEMETRY
+    #define COMPONENT_TELEMETRY_ENABLED true
+#else
+    #define COMPONENT_TELEMETRY_ENABLED false
+#endif
+
+#ifdef _ROM_DATABASE_PATH
+    #define ROM_DATABASE_PATH _ROM_DATABASE_PATH
+#else
+    #define ROM_DATABASE_PATH ""
+#endif
+
 namespace fs = std::filesystem;
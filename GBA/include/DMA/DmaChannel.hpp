@@ -7,6 +7,7 @@
 #include <Utilities/MemoryUtilities.hpp>
 
 class GameBoyAdvance;
+class StateSerializer;
 
 enum class DmaXfer
 {
@@ -27,11 +28,16 @@ public:
     /// @param index Which channel index this is.
     /// @param interrupt What interrupt type should be requested when this channel executes, if IRQs are enabled.
     /// @param gba Reference to GBA for accessing memory.
-    DmaChannel(int index, InterruptType interrupt, GameBoyAdvance& gba);
+    /// @param systemControl System control to request the channel's interrupt from.
+    DmaChannel(int index, InterruptType interrupt, GameBoyAdvance& gba, SystemControl& systemControl);
 
     /// @brief Reset to power-up state.
     void Reset();
 
+    /// @brief Save or load the channel's registers, including the internal registers of a transfer in progress.
+    /// @param state Serializer to save state to or load state from.
+    void Serialize(StateSerializer& state);
+
     uint32_t GetSrc() const { return internalSrcAddr_; }
 
     uint32_t GetDest() const { return internalDestAddr_; }
@@ -54,14 +60,28 @@ public:
     /// @return True if this channel is running or scheduled to run with special timing.
     bool Enabled() const { return dmacnt_.enable; }
 
-    /// @brief Execute a DMA transfer based on this channel's current configuration.
+    /// @brief Execute a DMA transfer based on this channel's current configuration in one step.
     /// @return Number of cycles taken to complete the transfer.
     int Execute();
 
+    /// @brief Check whether this channel's transfer can be run in chunks with other events in between. EEPROM and audio FIFO
+    ///        transfers always run in one step.
+    /// @return True if this is a regular transfer.
+    bool Interruptible() const;
+
+    /// @brief Run part of a regular DMA transfer.
+    /// @param maxCycles Stop after the unit that brings the cycles taken to at least this many.
+    /// @return Number of cycles taken and whether the transfer finished.
+    std::pair<int, bool> ExecuteChunk(int maxCycles);
+
 private:
-    /// @brief Execute a regular DMA transfer.
-    /// @return Number of cycles taken to complete the transfer.
-    int ExecuteNormalXfer();
+    /// @brief Transfer units of a regular DMA transfer until it finishes or reaches a cycle limit.
+    /// @param maxCycles Stop after the unit that brings the cycles taken to at least this many.
+    /// @return Number of cycles taken.
+    int ExecuteNormalXfer(int maxCycles);
+
+    /// @brief Update internal registers and request an interrupt, if enabled, after a transfer finishes.
+    void CompleteXfer();
 
     /// @brief Execute a DMA transfer to/from EEPROM.
     /// @param read True if this transfer is set to read from EEPROM and write to system memory.
@@ -84,9 +104,19 @@ private:
     /// @brief Set the internal address and word count registers.
     void SetInternalRegisters();
 
-    /// @brief Read a bit from the bitstream in system memory that's being written to EEPROM. Updates internal registers.
-    /// @return Current value at internal source address and number of cycles taken to read.
-    std::pair<uint32_t, int> ReadForEepromXfer();
+    /// @brief Read the bitstream in system memory that's being written to EEPROM, one bit per halfword. Runs in directly mapped
+    ///        memory are read in one step. Updates internal registers.
+    /// @param bitstream Where to store each halfword that's read.
+    /// @param count Number of halfwords to read.
+    /// @return Number of cycles taken to read.
+    int ReadEepromBitstream(uint16_t* bitstream, int count);
+
+    /// @brief Write the bitstream read from EEPROM to system memory, one bit per halfword. Runs in directly mapped memory are
+    ///        written in one step. Updates internal registers.
+    /// @param bitstream Halfwords to write.
+    /// @param count Number of halfwords to write.
+    /// @return Number of cycles taken to write.
+    int WriteEepromBitstream(uint16_t const* bitstream, int count);
 
     union DMACNT
     {
@@ -123,4 +153,5 @@ private:
     int const channelIndex_;
     InterruptType const interruptType_;
     GameBoyAdvance& gba_;
+    SystemControl& systemControl_;
 };
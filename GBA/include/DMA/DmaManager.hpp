@@ -4,20 +4,31 @@
 #include <cstdint>
 #include <utility>
 #include <DMA/DmaChannel.hpp>
+#include <System/EventScheduler.hpp>
 #include <Utilities/MemoryUtilities.hpp>
 
 class GameBoyAdvance;
+class StateSerializer;
+class SystemControl;
+namespace Logging { class LogManager; }
 
 class DmaManager
 {
 public:
     /// @brief Register DMA event handling and initialize DMA channels.
     /// @param gba Reference to GBA for accessing memory.
-    DmaManager(GameBoyAdvance& gba);
+    /// @param scheduler Scheduler to advance while transfers run.
+    /// @param systemControl System control to request DMA interrupts from.
+    /// @param log Log to record transfers to.
+    DmaManager(GameBoyAdvance& gba, EventScheduler& scheduler, SystemControl& systemControl, Logging::LogManager& log);
 
     /// @brief Reset the DMA channels to their power-up states.
     void Reset();
 
+    /// @brief Save or load every channel and which special timing events they're waiting on.
+    /// @param state Serializer to save state to or load state from.
+    void Serialize(StateSerializer& state);
+
     /// @brief Read a DMA register.
     /// @param addr Address of register to read.
     /// @param alignment Number of bytes to read.
@@ -30,9 +41,13 @@ public:
     /// @param alignment Number of bytes to write.
     void WriteReg(uint32_t addr, uint32_t value, AccessSize alignment);
 
-    /// @brief Check if any of the DMA channels are currently running.
-    /// @return True if any channel is active.
-    bool DmaActive() const { return dmaActive_; }
+    /// @brief Check if any of the DMA channels are currently running or holding the bus.
+    /// @return True if the CPU can't run because DMA is active.
+    bool DmaActive() const { return (runningChannels_ != 0) || (scheduler_.TotalCycles() < stallEndCycle_); }
+
+    /// @brief Run the highest priority active transfer until the next scheduled event, or until it finishes. Only call while
+    ///        DmaActive is true.
+    void RunUntilNextEvent();
 
     /// @brief Run any DMA channels set to run on VBlank.
     void CheckVBlankChannels() { CheckSpecialTiming(vblank_, DmaXfer::VBLANK); }
@@ -46,21 +61,38 @@ public:
     /// @brief Run any DMA channels set to replenish audio FIFO B.
     void CheckFifoBChannels() { CheckSpecialTiming(fifoB_, DmaXfer::FIFO_B); }
 
+    /// @brief Check if any DMA channels are set to replenish an audio FIFO.
+    /// @param xferType Which FIFO to check, either DmaXfer::FIFO_A or DmaXfer::FIFO_B.
+    /// @return True if at least one channel is set to replenish the FIFO.
+    bool FifoChannelsEnabled(DmaXfer xferType) const;
+
 private:
-    /// @brief Run any DMA channels set to run with special timing.
+    /// @brief Start any DMA channels set to run with special timing.
     /// @param enabledChannels Array of bools indicating which channels should be run based on the current special event.
+    /// @param xferType Special event that occurred.
     void CheckSpecialTiming(std::array<bool, 4>& enabledChannels, DmaXfer xferType);
 
-    /// @brief Callback function to resume CPU execution after a DMA transfer completes.
-    void EndDma(int) { dmaActive_ = false; }
+    /// @brief Start a DMA transfer. Regular transfers are run in chunks by RunUntilNextEvent, everything else runs immediately and
+    ///        stalls the bus for as long as it took. Channels that are already running ignore the request.
+    /// @param index Index of channel to start.
+    /// @param xferType What triggered the transfer.
+    void StartXfer(int index, DmaXfer xferType);
+
+    /// @brief Hold the bus after a transfer. Stalls are tracked as a cycle instead of a scheduled event since audio FIFO transfers
+    ///        happen thousands of times per second.
+    /// @param cycles Number of cycles taken by the transfer, not including the overhead added by this function.
+    void Stall(int cycles);
 
-    /// @brief Schedule when a DMA event should end.
-    /// @param cycles Number of cycles until the transfer would finish.
-    void HandleDmaEvent(int cycles);
+    /// @brief Stop a channel from running on any special timing event.
+    /// @param index Index of channel.
+    void ClearStartTiming(int index);
 
     // Status
     GameBoyAdvance& gba_;
-    bool dmaActive_;
+    EventScheduler& scheduler_;
+    Logging::LogManager& log_;
+    uint8_t runningChannels_;
+    uint64_t stallEndCycle_;
 
     // Channels
     std::array<DmaChannel, 4> dmaChannels_;
@@ -1,24 +1,51 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <cstdint>
 #include <utility>
 #include <GamePad.hpp>
 #include <Utilities/MemoryUtilities.hpp>
 
+class StateSerializer;
+class SystemControl;
+
 class GamepadManager
 {
 public:
     /// @brief Initialize the Gamepad registers (no buttons pressed and no interrupts enabled).
-    GamepadManager();
+    /// @param systemControl System control to request keypad interrupts from.
+    explicit GamepadManager(SystemControl& systemControl);
 
     /// @brief Reset the gamepad registers to their power-up state.
     void Reset();
 
+    /// @brief Save or load the gamepad registers.
+    /// @param state Serializer to save state to or load state from.
+    void Serialize(StateSerializer& state);
+
     /// @brief Update the KEYINPUT register based on currently pressed buttons and check for Gamepad IRQ.
     /// @param gamepad 
     void UpdateGamepad(Gamepad gamepad);
 
+    /// @brief Leave the host's current buttons in the input mailbox. Safe to call from any thread, including while the emulator
+    ///        is running. Takes effect the next time PollInput is called.
+    /// @param gamepad Current gamepad status.
+    void PostInput(Gamepad gamepad) { mailbox_.store(gamepad.halfword_, std::memory_order_relaxed); }
+
+    /// @brief Apply the buttons in the input mailbox to KEYINPUT if they changed, checking for a Gamepad IRQ.
+    void PollInput()
+    {
+        uint16_t posted = mailbox_.load(std::memory_order_relaxed);
+
+        if (posted != KEYINPUT_.halfword_)
+        {
+            Gamepad gamepad;
+            gamepad.halfword_ = posted;
+            UpdateGamepad(gamepad);
+        }
+    }
+
     /// @brief Read KEYINPUT or KEYCNT registers.
     /// @param addr Address to read.
     /// @param alignment BYTE, HALFWORD, or WORD.
@@ -39,4 +66,9 @@ private:
     std::array<uint8_t, 4> gamepadRegisters_;
     Gamepad& KEYINPUT_;
     Gamepad& KEYCNT_;
+
+    // Latest KEYINPUT value posted by the host. Not part of the emulated state, so resets and loaded states keep it.
+    std::atomic_uint16_t mailbox_;
+
+    SystemControl& systemControl_;
 };
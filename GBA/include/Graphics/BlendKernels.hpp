@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Graphics
+{
+/// @brief Alpha blend two spans of BGR555 pixels.
+/// @param targetA First target pixels.
+/// @param targetB Second target pixels.
+/// @param output Blended pixels. May alias targetA or targetB.
+/// @param count Number of pixels in each span.
+/// @param eva First target coefficient (1.4 fixed point, at most 0x10).
+/// @param evb Second target coefficient (1.4 fixed point, at most 0x10).
+void AlphaBlendSpan(uint16_t const* targetA, uint16_t const* targetB, uint16_t* output, size_t count, uint16_t eva, uint16_t evb);
+
+/// @brief Increase the brightness of a span of BGR555 pixels.
+/// @param target Pixels to brighten.
+/// @param output Brightened pixels. May alias target.
+/// @param count Number of pixels in span.
+/// @param evy Brightness coefficient (1.4 fixed point, at most 0x10).
+void IncreaseBrightnessSpan(uint16_t const* target, uint16_t* output, size_t count, uint16_t evy);
+
+/// @brief Decrease the brightness of a span of BGR555 pixels.
+/// @param target Pixels to darken.
+/// @param output Darkened pixels. May alias target.
+/// @param count Number of pixels in span.
+/// @param evy Brightness coefficient (1.4 fixed point, at most 0x10).
+void DecreaseBrightnessSpan(uint16_t const* target, uint16_t* output, size_t count, uint16_t evy);
+
+/// @brief Blending kernels built for one instruction set.
+struct BlendKernelSet
+{
+    char const* name_;
+    void (*alphaBlend_)(uint16_t const*, uint16_t const*, uint16_t*, size_t, uint16_t, uint16_t);
+    void (*increaseBrightness_)(uint16_t const*, uint16_t*, size_t, uint16_t);
+    void (*decreaseBrightness_)(uint16_t const*, uint16_t*, size_t, uint16_t);
+};
+
+/// @brief Get every set of blending kernels the host CPU can run, so that they can be checked against each other. The span
+///        functions above always use the widest of them.
+/// @return Scalar kernels first, followed by each supported vector width from narrowest to widest.
+std::vector<BlendKernelSet> SupportedBlendKernels();
+}
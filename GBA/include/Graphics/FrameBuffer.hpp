@@ -1,9 +1,20 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <bit>
 #include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
 #include <vector>
 #include <Graphics/Registers.hpp>
+#include <PixelFormat.hpp>
+#include <Utilities/MemoryUtilities.hpp>
+
+class AvCapture;
+class StateSerializer;
 
 /// @brief 
 namespace Graphics
@@ -36,10 +47,111 @@ struct WindowSettings
     bool effectsEnabled_;
 };
 
+/// @brief One bit for each dot of a scanline, set at dots where a window enables a layer.
+class WindowMask
+{
+public:
+    /// @brief Set or clear every dot.
+    /// @param enabled Whether the layer is enabled everywhere.
+    void Fill(bool enabled) { words_.fill(enabled ? MAX_U64 : 0); }
+
+    /// @brief Set or clear a range of dots.
+    /// @param begin First dot of range (inclusive).
+    /// @param end Last dot of range (exclusive).
+    /// @param enabled Whether the layer is enabled in the range.
+    void Assign(int begin, int end, bool enabled)
+    {
+        if (begin >= end)
+        {
+            return;
+        }
+
+        for (int word = begin / 64; (word * 64) < end; ++word)
+        {
+            int const first = std::max(begin - (word * 64), 0);
+            int const last = std::min(end - (word * 64), 64);
+            uint64_t const range = (MAX_U64 >> (64 - (last - first))) << first;
+            words_[word] = enabled ? (words_[word] | range) : (words_[word] & ~range);
+        }
+    }
+
+    /// @brief Set or clear every dot that is set in another mask.
+    /// @param area Dots to change.
+    /// @param enabled Whether the layer is enabled at those dots.
+    void Assign(WindowMask const& area, bool enabled)
+    {
+        for (size_t word = 0; word < WORD_COUNT; ++word)
+        {
+            words_[word] = enabled ? (words_[word] | area.words_[word]) : (words_[word] & ~area.words_[word]);
+        }
+    }
+
+    /// @brief Set a single dot.
+    /// @param dot Dot to set.
+    void Set(int dot) { words_[dot / 64] |= (0x01ULL << (dot % 64)); }
+
+    /// @brief Check whether a dot is set.
+    /// @param dot Dot to check.
+    /// @return True if the layer is enabled at the dot.
+    bool Test(int dot) const { return (words_[dot / 64] >> (dot % 64)) & 0x01; }
+
+    /// @brief Call a function for each run of consecutive set dots within a range.
+    /// @tparam Function Callable taking the first (inclusive) and last (exclusive) dot of a run.
+    /// @param begin First dot of range to search (inclusive).
+    /// @param end Last dot of range to search (exclusive).
+    /// @param function Function to call with each run.
+    template <typename Function>
+    void ForEachSpan(int begin, int end, Function function) const
+    {
+        int dot = begin;
+
+        while (dot < end)
+        {
+            dot = FindNext(dot, end, true);
+
+            if (dot < end)
+            {
+                int const spanEnd = FindNext(dot, end, false);
+                function(dot, spanEnd);
+                dot = spanEnd;
+            }
+        }
+    }
+
+private:
+    /// @brief Find the next dot that is set or clear.
+    /// @param dot Dot to start searching at.
+    /// @param end Dot to stop searching at.
+    /// @param set True to find a set dot, false to find a clear one.
+    /// @return Index of next matching dot, or end if there isn't one before it.
+    int FindNext(int dot, int end, bool set) const
+    {
+        while (dot < end)
+        {
+            uint64_t const word = (set ? words_[dot / 64] : ~words_[dot / 64]) >> (dot % 64);
+
+            if (word != 0)
+            {
+                return std::min(dot + std::countr_zero(word), end);
+            }
+
+            dot = ((dot / 64) + 1) * 64;
+        }
+
+        return end;
+    }
+
+    static constexpr size_t WORD_COUNT = (LCD_WIDTH + 63) / 64;
+    std::array<uint64_t, WORD_COUNT> words_;
+};
+
+/// @brief A pixel drawn by a single layer, packed into 32 bits. The upper byte is laid out so that comparing the packed values
+///        of pixels from different layers orders them by drawing priority: opaque pixels before transparent ones, then by priority,
+///        then by source. The lowest packed value at a dot is the pixel drawn on top.
 struct Pixel
 {
-    /// @brief Default construct a Pixel as uninitialized.
-    Pixel() : initialized_(false) {}
+    /// @brief Default construct a Pixel as empty, meaning no layer drew anything at its location.
+    Pixel() : value_(EMPTY) {}
 
     /// @brief Create a Pixel.
     /// @param src Source that generated this pixel.
@@ -48,26 +160,55 @@ struct Pixel
     /// @param transparent Whether this pixel is transparent.
     /// @param semiTransparent If this is a OBJ pixel, then whether this pixel is part of a semi-transparent sprite.
     Pixel(PixelSrc src, uint16_t bgr555, int priority, bool transparent, bool semiTransparent = false) :
-        src_(src),
-        bgr555_(bgr555),
-        priority_(priority),
-        transparent_(transparent),
-        semiTransparent_(semiTransparent),
-        initialized_(true)
+        value_((transparent ? TRANSPARENT_FLAG : 0) |
+               (static_cast<uint32_t>(priority & 0x03) << PRIORITY_SHIFT) |
+               (static_cast<uint32_t>(src) << SRC_SHIFT) |
+               (semiTransparent ? SEMI_TRANSPARENT_FLAG : 0) |
+               bgr555)
     {
     }
 
-    /// @brief Compare the priority of two pixels. If Pixel A < Pixel B, then A has higher priority and should be drawn over B.
-    /// @param rhs Pixel to compare to.
-    /// @return True if this pixel has a higher priority than rhs.
-    bool operator<(Pixel const& rhs) const;
-
-    PixelSrc src_;
-    uint16_t bgr555_;
-    int priority_;
-    bool transparent_;
-    bool semiTransparent_;
-    bool initialized_;
+    /// @brief Get the source that generated this pixel.
+    /// @return Layer this pixel belongs to.
+    PixelSrc Src() const { return static_cast<PixelSrc>((value_ >> SRC_SHIFT) & 0x07); }
+
+    /// @brief Get the color of this pixel.
+    /// @return BGR555 color value.
+    uint16_t Bgr555() const { return value_ & MAX_U16; }
+
+    /// @brief Get the priority of this pixel.
+    /// @return Priority (0-3).
+    int Priority() const { return (value_ >> PRIORITY_SHIFT) & 0x03; }
+
+    /// @brief Check if this pixel is transparent. Empty pixels are transparent.
+    /// @return True if transparent.
+    bool Transparent() const { return (value_ & TRANSPARENT_FLAG) != 0; }
+
+    /// @brief Check if this pixel is part of a semi-transparent sprite.
+    /// @return True if semi-transparent.
+    bool SemiTransparent() const { return (value_ & SEMI_TRANSPARENT_FLAG) != 0; }
+
+    static constexpr uint32_t EMPTY = MAX_U32;
+    static constexpr uint32_t TRANSPARENT_FLAG = 0x8000'0000;
+    static constexpr uint32_t PRIORITY_SHIFT = 27;
+    static constexpr uint32_t SRC_SHIFT = 24;
+    static constexpr uint32_t SEMI_TRANSPARENT_FLAG = 0x0001'0000;
+
+    uint32_t value_;
+};
+
+/// @brief A frame handed from the frame buffer to its consumer.
+struct CompletedFrame
+{
+    /// @brief Pixel data of the frame.
+    uint8_t const* pixels_;
+
+    /// @brief Number of frames completed up to and including this one. 0 if no frame has completed yet.
+    uint64_t sequence_;
+
+    /// @brief Sequence number of the first frame with the same contents as this one. Frames with the same content sequence are
+    ///        identical.
+    uint64_t contentSequence_;
 };
 
 class FrameBuffer
@@ -79,14 +220,54 @@ public:
     /// @brief Reset the frame buffer to its power-up state.
     void Reset();
 
-    /// @brief Access the raw frame buffer data of the last fully drawn frame.
-    /// @return Raw pointer to frame buffer.
-    uint8_t* GetRawFrameBuffer();
+    /// @brief Save or load how far drawing has gotten into the current frame. Pixels already drawn aren't saved, so the first frame
+    ///        after loading keeps whatever was drawn above the loaded scanline.
+    /// @param state Serializer to save state to or load state from.
+    void Serialize(StateSerializer& state);
+
+    /// @brief Take ownership of the most recently completed frame, releasing the one taken by the previous call. Safe to call from
+    ///        a different thread than the one drawing scanlines, but only one thread may consume frames. Never blocks.
+    /// @return Latest frame. Its pixel data stays valid and unchanged until the next call. Frames are numbered from 1 in the
+    ///         order they complete, and numbering continues across resets.
+    CompletedFrame AcquireFrame();
+
+    /// @brief Choose the pixel format that scanlines are converted to as they are written to the frame buffer. Both output frames
+    ///        are cleared to white.
+    /// @param format Output pixel format.
+    /// @param colorCorrection Whether to adjust colors to approximate how they appear on the GBA's LCD.
+    void SetOutputFormat(PixelFormat format, bool colorCorrection);
+
+    /// @brief Get the pixel format of the frame buffer.
+    /// @return Output pixel format.
+    PixelFormat GetOutputFormat() const { return outputFormat_; }
+
+    /// @brief Choose caller owned memory to draw frames straight into instead of the internal output frames. Frames drawn into
+    ///        a target are still published, but are never handed off to AcquireFrame. Must be called between frames.
+    /// @param target 240x160 pixels in the output format, or nullptr to go back to drawing into the internal output frames.
+    /// @return Whether the new output already holds the last published frame, so that its scanlines can be repeated.
+    bool SetFrameTarget(uint8_t* target)
+    {
+        frameTarget_ = target;
+        return target == publishedTarget_;
+    }
+
+    /// @brief Choose a function to call each time a frame is published.
+    /// @param callback Function to call with the sequence number of each published frame, on the thread that published it.
+    void SetFrameCallback(std::function<void(uint64_t)> callback) { frameCallback_ = std::move(callback); }
+
+    /// @brief Choose where to send a copy of each published frame for recording.
+    /// @param capture Capture to push frames to, or nullptr to stop sending them anywhere.
+    void SetCapture(AvCapture* capture) { capture_ = capture; }
 
     /// @brief Add a pixel to be considered for drawing to screen.
     /// @param pixel Pixel to potentially draw.
     /// @param dot Index of current scanline to add pixel to.
-    void PushPixel(Pixel pixel, int dot);
+    void PushPixel(Pixel pixel, int dot)
+    {
+        size_t layer = static_cast<size_t>(pixel.Src());
+        layers_[layer][dot] = pixel;
+        activeLayers_ |= (0x01 << layer);
+    }
 
     /// @brief Iterate through each pixel of current scanline and render the highest priority pixel for each dot.
     /// @param backdropColor BGR555 value of backdrop color to use if no pixels were drawn at a location.
@@ -94,36 +275,185 @@ public:
     /// @param forceBlank Whether to force display a white screen.
     void RenderScanline(uint16_t backdropColor, bool forceBlank, BLDCNT const& bldcnt, BLDALPHA const& bldalpha, BLDY const& bldy);
 
-    /// @brief Reset the frame index to begin drawing at the top of the screen again.
-    void ResetFrameIndex();
+    /// @brief Claim the current scanline so that it can be written directly, bypassing the layer buffers and compositor. The
+    ///        caller must fill all LCD_WIDTH pixels with BGR555 values and then call FinishDirectScanline.
+    /// @return Pointer to the first pixel of the current scanline.
+    uint16_t* StartDirectScanline() { return CurrentScanlineBuffer(); }
+
+    /// @brief Write the scanline claimed by StartDirectScanline to the output frame.
+    void FinishDirectScanline() { EmitScanline(); }
+
+    /// @brief Copy the current scanline from the previously drawn frame instead of rendering it. When drawing into a frame
+    ///        target, the target is expected to still hold the previous frame.
+    void RepeatPreviousScanline();
+
+    /// @brief Hand the frame that was just drawn off to the consumer and begin drawing the next one at the top of the screen.
+    /// @param modified Whether any scanline of the frame may differ from the previous frame.
+    void PublishFrame(bool modified);
+
+    /// @brief Count a frame that was skipped without drawing any of it. The frame being drawn is kept for the next frame, and
+    ///        the next published frame's sequence number accounts for every skipped frame.
+    void SkipFrame()
+    {
+        ++completedFrames_;
+        pixelIndex_ = 0;
+    }
+
+    /// @brief Get the number of frames completed so far, including skipped ones.
+    /// @return Number of completed frames.
+    uint64_t CompletedFrames() const { return completedFrames_; }
+
+    /// @brief Set the number of frames completed so far. The next published frame is numbered one higher.
+    /// @param frames Number of completed frames.
+    void SetCompletedFrames(uint64_t frames) { completedFrames_ = frames; }
 
-    /// @brief Uninitialize all pixels in sprite scanline buffer.
-    void ClearSpritePixels();
+    /// @brief Empty all pixels in the sprite layer.
+    void ClearSpritePixels() { layers_[OBJ_LAYER].fill(Pixel()); }
 
     /// @brief Get a sprite pixel on the current scanline at a particular dot.
     /// @param dot Dot to get sprite pixel at.
     /// @return Reference to pixel at specified dot.
-    Pixel& GetSpritePixel(size_t dot) { return spriteScanline_.at(dot); }
+    Pixel& GetSpritePixel(size_t dot) { return layers_[OBJ_LAYER][dot]; }
 
-    /// @brief Merge the sprite pixels scanline buffer into the main scanline buffer.
-    void PushSpritePixels();
+    /// @brief Mark the sprite layer as drawn so that it is considered when rendering the current scanline.
+    void PushSpritePixels() { activeLayers_ |= (0x01 << OBJ_LAYER); }
 
-    /// @brief Initialize the window settings by setting each pixel to a default setting.
-    /// @param outsideSettings Default window settings for each pixel.
-    void InitializeWindow(WindowSettings defaultSettings) { windowScanline_.fill(defaultSettings); }
+    /// @brief Initialize the window settings by applying the same settings to every dot.
+    /// @param defaultSettings Default window settings for each dot.
+    void InitializeWindow(WindowSettings defaultSettings)
+    {
+        ForEachWindowMask(defaultSettings, [](WindowMask& mask, bool enabled) { mask.Fill(enabled); });
+    }
 
-    /// @brief Get the window settings at a dot on the current scanline.
-    /// @param dot Index to get window settings at.
-    /// @return Window settings at specified dot.
-    WindowSettings& GetWindowSettings(size_t dot) { return windowScanline_.at(dot); }
+    /// @brief Apply window settings to a range of dots on the current scanline.
+    /// @param begin First dot of window (inclusive).
+    /// @param end Last dot of window (exclusive).
+    /// @param settings Settings for inside this window.
+    void ApplyWindow(int begin, int end, WindowSettings settings)
+    {
+        ForEachWindowMask(settings, [=](WindowMask& mask, bool enabled) { mask.Assign(begin, end, enabled); });
+    }
+
+    /// @brief Apply window settings to an arbitrarily shaped area of the current scanline.
+    /// @param area Dots inside this window.
+    /// @param settings Settings for inside this window.
+    void ApplyWindow(WindowMask const& area, WindowSettings settings)
+    {
+        ForEachWindowMask(settings, [&](WindowMask& mask, bool enabled) { mask.Assign(area, enabled); });
+    }
+
+    /// @brief Get the dots on the current scanline where a background is enabled by the window settings.
+    /// @param bgIndex Which background (0-3) to get the mask of.
+    /// @return Mask of enabled dots.
+    WindowMask const& BgWindow(int bgIndex) const { return windowMasks_[bgIndex]; }
+
+    /// @brief Get the dots on the current scanline where sprites are enabled by the window settings.
+    /// @return Mask of enabled dots.
+    WindowMask const& ObjWindow() const { return windowMasks_[OBJ_WINDOW]; }
 
 private:
-    std::array<std::vector<Pixel>, LCD_WIDTH> scanline_;
-    std::array<Pixel, LCD_WIDTH> spriteScanline_;
-    std::array<WindowSettings, LCD_WIDTH> windowScanline_;
+    /// @brief Call a function on the mask of each layer controlled by window settings.
+    /// @tparam Function Callable taking a mask and whether the settings enable its layer.
+    /// @param settings Window settings to apply.
+    /// @param function Function to call with each mask.
+    template <typename Function>
+    void ForEachWindowMask(WindowSettings const& settings, Function function)
+    {
+        for (size_t bgIndex = 0; bgIndex < 4; ++bgIndex)
+        {
+            function(windowMasks_[bgIndex], settings.bgEnabled_[bgIndex]);
+        }
+
+        function(windowMasks_[OBJ_WINDOW], settings.objEnabled_);
+        function(windowMasks_[EFFECTS_WINDOW], settings.effectsEnabled_);
+    }
+
+    /// @brief Empty each layer that was drawn on the current scanline.
+    void ClearLayers();
+
+    /// @brief Get where the BGR555 pixels of the current scanline should be composed. This is the output frame itself when no
+    ///        conversion is needed.
+    /// @return Pointer to the first pixel of the current scanline.
+    uint16_t* CurrentScanlineBuffer()
+    {
+        if (nativeOutput_)
+        {
+            return reinterpret_cast<uint16_t*>(CurrentOutputLine());
+        }
+
+        return scanlineBuffer_.data();
+    }
+
+    /// @brief Get the current scanline of the frame being drawn, which is either the frame target or an internal output frame.
+    /// @return Pointer to the first byte of the current scanline.
+    uint8_t* CurrentOutputLine()
+    {
+        if (frameTarget_ != nullptr)
+        {
+            return frameTarget_ + (pixelIndex_ * BytesPerPixel(outputFormat_));
+        }
+
+        return OutputLine(writeIndex_);
+    }
+
+    /// @brief Get the current scanline of an output frame.
+    /// @param frameIndex Which output frame to index.
+    /// @return Pointer to the first byte of the current scanline.
+    uint8_t* OutputLine(size_t frameIndex)
+    {
+        return reinterpret_cast<uint8_t*>(frameBuffers_[frameIndex].data()) + (pixelIndex_ * BytesPerPixel(outputFormat_));
+    }
+
+    /// @brief Fill both output frames with white.
+    void ClearFrames();
+
+    /// @brief Convert the current scanline to the output format if needed, and advance to the next scanline.
+    void EmitScanline();
+
+    /// @brief Convert a scanline of BGR555 pixels to the output format.
+    /// @param src Scanline to convert.
+    /// @param dest Where to write converted scanline.
+    void ConvertScanline(uint16_t const* src, uint8_t* dest) const;
+
+    static constexpr size_t LAYER_COUNT = 5;
+    static constexpr size_t OBJ_LAYER = static_cast<size_t>(PixelSrc::OBJ);
 
-    std::array<std::array<uint16_t, LCD_WIDTH * LCD_HEIGHT>, 2> frameBuffers_;
-    size_t activeFrameBufferIndex_;
+    // Pixels drawn by each layer (OBJ, BG0-BG3) on the current scanline
+    std::array<std::array<Pixel, LCD_WIDTH>, LAYER_COUNT> layers_;
+    uint8_t activeLayers_;
+
+    // Dots where each of BG0-BG3, OBJ, and special effects are enabled by the window settings on the current scanline
+    static constexpr size_t OBJ_WINDOW = 4;
+    static constexpr size_t EFFECTS_WINDOW = 5;
+    std::array<WindowMask, 6> windowMasks_;
+
+    // Output frames are sized for the largest pixel format. At any time one frame is being drawn, one is owned by the consumer,
+    // and the third is waiting in the handoff slot to be swapped with either of them.
+    static constexpr size_t FRAME_COUNT = 3;
+    static constexpr uint8_t FRAME_INDEX_MASK = 0x03;
+    static constexpr uint8_t FRESH_FRAME_FLAG = 0x04;
+
+    std::array<std::array<uint32_t, LCD_WIDTH * LCD_HEIGHT>, FRAME_COUNT> frameBuffers_;
+    std::array<uint64_t, FRAME_COUNT> frameSequences_;
+    std::array<uint64_t, FRAME_COUNT> contentSequences_;
+    std::atomic_uint8_t handoff_;  // Index of frame in handoff slot, plus whether it completed since the consumer last took one
+    size_t writeIndex_;
+    size_t previousIndex_;  // Last frame published, read by RepeatPreviousScanline
+    size_t readIndex_;
+    uint64_t completedFrames_;
+    uint64_t lastModifiedFrame_;
+    std::function<void(uint64_t)> frameCallback_;
+    AvCapture* capture_;
     size_t pixelIndex_;
+
+    // Caller owned frame being drawn into, and the one the last published frame was drawn into. nullptr means internal frames.
+    uint8_t* frameTarget_;
+    uint8_t const* publishedTarget_;
+
+    // Output format, and the color of each BGR555 value in that format when conversion is needed
+    PixelFormat outputFormat_;
+    bool nativeOutput_;
+    std::shared_ptr<std::vector<uint32_t> const> colorLut_;  // Shared with every other frame buffer using the same conversion
+    std::array<uint16_t, LCD_WIDTH> scanlineBuffer_;
 };
 }
@@ -1,26 +1,44 @@
 #pragma once
 
 #include <array>
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <functional>
+#include <mutex>
+#include <thread>
 #include <utility>
-#include <Graphics/FrameBuffer.hpp>
 #include <Graphics/Registers.hpp>
+#include <Graphics/Renderer.hpp>
+#include <PixelFormat.hpp>
 #include <Utilities/MemoryUtilities.hpp>
+#include <Utilities/RingBuffer.hpp>
+
+class AvCapture;
+class EventScheduler;
+class StateSerializer;
+class SystemControl;
 
 namespace Graphics
 {
-struct OamEntry;
-
 class PPU
 {
 public:
     /// @brief Initialize the PPU.
-    PPU();
+    /// @param scheduler Scheduler to register and schedule scanline events with.
+    /// @param systemControl System control to request LCD interrupts from.
+    PPU(EventScheduler& scheduler, SystemControl& systemControl);
+
+    /// @brief Stop the render thread if it is running.
+    ~PPU();
 
     /// @brief Reset the PPU to its power-on state.
     void Reset();
 
+    /// @brief Save or load the LCD registers, video memory, and renderer. Waits for the render thread to catch up first.
+    /// @param state Serializer to save state to or load state from.
+    void Serialize(StateSerializer& state);
+
     //                Bus   Read      Write     Cycles
     //  Palette RAM   16    8/16/32   16/32     1/1/2 *
     std::pair<uint32_t, int> ReadPRAM(uint32_t addr, AccessSize alignment);
@@ -48,13 +66,77 @@ public:
     /// @param alignment BYTE, HALFWORD, or WORD.
     void WriteReg(uint32_t addr, uint32_t value, AccessSize alignment);
 
-    /// @brief Access the raw frame buffer data.
-    /// @return Raw pointer to frame buffer.
-    uint8_t* GetRawFrameBuffer() { return frameBuffer_.GetRawFrameBuffer(); }
-
-    /// @brief Get the number of times the PPU has hit VBlank since the last check.
-    /// @return Number of times PPU has entered VBlank.
-    int GetAndResetFrameCounter() { int temp = frameCounter_; frameCounter_ = 0; return temp; }
+    /// @brief Get the memory backing an LCD I/O register that can be read straight from memory.
+    /// @param addr Address of halfword register.
+    /// @return Pointer to the register's memory, or nullptr if the register is write only.
+    uint8_t const* RegisterMemory(uint32_t addr) const;
+
+    /// @brief Take ownership of the most recently completed frame, releasing the previously acquired one. Safe to call from a
+    ///        different thread than the emulation thread.
+    /// @return Latest frame. Its pixel data is valid until the next call.
+    CompletedFrame AcquireFrame() { return renderer_.AcquireFrame(); }
+
+    /// @brief Choose the pixel format of the frame buffer.
+    /// @param format Output pixel format.
+    /// @param colorCorrection Whether to approximate the colors of the GBA's LCD.
+    void SetOutputFormat(PixelFormat format, bool colorCorrection) { FinishRendering(); renderer_.SetOutputFormat(format, colorCorrection); }
+
+    /// @brief Choose caller owned memory to draw frames straight into instead of the internal frame buffer.
+    /// @param target 240x160 pixels in the output format, or nullptr to draw into the internal frame buffer.
+    void SetFrameTarget(uint8_t* target) { FinishRendering(); renderer_.SetFrameTarget(target); }
+
+    /// @brief Choose a function to call each time a frame completes.
+    /// @param callback Function to call with the sequence number of each completed frame.
+    void SetFrameCallback(std::function<void(uint64_t)> callback) { FinishRendering(); renderer_.SetFrameCallback(std::move(callback)); }
+
+    /// @brief Choose where to send a copy of each completed frame for recording.
+    /// @param capture Capture to push frames to, or nullptr to stop sending them anywhere.
+    void SetCapture(AvCapture* capture) { FinishRendering(); renderer_.SetCapture(capture); }
+
+    /// @brief Get the pixel format of the frame buffer.
+    /// @return Output pixel format.
+    PixelFormat GetOutputFormat() const { return renderer_.GetOutputFormat(); }
+
+    /// @brief Access the raw palette RAM data.
+    /// @return Raw pointer to palette RAM.
+    uint8_t* GetRawPRAM() { return PRAM_.data(); }
+
+    /// @brief Access the raw VRAM data.
+    /// @return Raw pointer to VRAM.
+    uint8_t* GetRawVRAM() { return VRAM_.data(); }
+
+    /// @brief Access the raw OAM data.
+    /// @return Raw pointer to OAM.
+    uint8_t* GetRawOAM() { return OAM_.data(); }
+
+    /// @brief Forward a write that was made to PRAM, VRAM, or OAM without going through the PPU write functions to the
+    ///        renderer. Should only be called if the write changed the contents of memory.
+    /// @param addr Canonical address that was modified.
+    /// @param alignment Number of bytes that were written.
+    void VideoMemoryWritten(uint32_t addr, AccessSize alignment);
+
+    /// @brief Choose whether scanlines are composed on a separate render thread or synchronously during HBlank. Both produce
+    ///        identical frames.
+    /// @param enabled Whether to render on a separate thread.
+    void SetRenderThreadEnabled(bool enabled);
+
+    /// @brief Block until the render thread has executed every command submitted to it.
+    void FinishRendering();
+
+    /// @brief Choose how many frames to skip drawing after each drawn frame. Skipped frames still advance VCOUNT, raise LCD
+    ///        interrupts, and trigger HBlank and VBlank DMAs, but none of their scanlines are composed and they're never handed
+    ///        off to the consumer. The frame currently being emulated is drawn or skipped as already decided.
+    /// @param frames Number of frames to skip between drawn frames. 0 draws every frame.
+    void SetFrameSkip(int frames);
+
+    /// @brief Start running frames ahead of the current point in time. Must be called right after entering VBlank. Only the last
+    ///        frame run ahead is drawn, and only if frame skip would have drawn the frame about to start.
+    /// @param frames Number of frames that will be run ahead.
+    void BeginRunAhead(int frames);
+
+    /// @brief Finish running ahead, once the state saved before BeginRunAhead has been loaded. Frame skip and frame numbering
+    ///        pick up where they left off. The frame about to start isn't drawn, since the frame run ahead was shown in its place.
+    void EndRunAhead();
 
     /// @brief Check the current scanline being processed.
     /// @return Current scanline [0, 227].
@@ -82,154 +164,39 @@ private:
     /// @param alignment Number of bytes to write.
     void WriteDispstatVcount(uint32_t addr, uint32_t value, AccessSize alignment);
 
+    /// @brief Check whether an LCD I/O register is write only.
+    /// @param addr Address of register.
+    /// @return True if reading the register is an open bus read.
+    static bool WriteOnlyRegister(uint32_t addr);
+
     /// @brief Determine whether window 0 and window 1 are active on the current scanline.
     void SetNonObjWindowEnabled();
 
-    /// @brief Apply window settings to pixels within a window on the current scanline.
-    /// @param leftEdge X1 - Left edge of window (inclusive).
-    /// @param rightEdge X2 - Right edge of window (exclusive).
-    /// @param settings Settings for inside this window region.
-    void ConfigureNonObjWindow(uint8_t leftEdge, uint8_t rightEdge, WindowSettings settings);
-
-    /// @brief Render BG pixels in mode 0.
-    void RenderMode0Scanline();
-
-    /// @brief Render BG pixels in mode 1.
-    void RenderMode1Scanline();
-
-    /// @brief Render BG pixels in mode 2.
-    void RenderMode2Scanline();
-
-    /// @brief Render BG pixels in mode 3.
-    void RenderMode3Scanline();
-
-    /// @brief Render BG pixels in mode 4.
-    void RenderMode4Scanline();
-
-    /// @brief Render a regular tiled text background scanline.
-    /// @param bgIndex Which background to render.
-    /// @param control Control register of specified background.
-    /// @param xOffset X offset register value of specified background.
-    /// @param yOffset Y offset register value of specified background.
-    void RenderRegularTiledBackgroundScanline(int bgIndex, BGCNT const& control, int xOffset, int yOffset);
-
-    /// @brief Render a regular tiled text background scanline that uses 4bpp colors.
-    /// @param bgIndex Which background to render.
-    /// @param control Control register of specified background.
-    /// @param x X-coordinate within background map.
-    /// @param y Y-Coordinate within background map.
-    /// @param width Width of map.
-    void RenderRegular4bppBackground(int bgIndex, BGCNT const& control, int x, int y, int width);
-
-    /// @brief Render a regular tiled text background scanline that uses 8bpp colors.
-    /// @param bgIndex Which background to render.
-    /// @param control Control register of specified background.
-    /// @param x X-coordinate within background map.
-    /// @param y Y-Coordinate within background map.
-    /// @param width Width of map.
-    void RenderRegular8bppBackground(int bgIndex, BGCNT const& control, int x, int y, int width);
-
-    /// @brief Render a tiled affined background scanline.
-    /// @param bgIndex Which background to render.
-    /// @param control Control register of specified background.
-    /// @param dx Reference point x-coordinate.
-    /// @param dy Reference point y-coordinate.
-    /// @param pa Amount to increment x-coordinate by after each pixel.
-    /// @param pc Amount to increment y-coordinate by after each pixel.
-    void RenderAffineTiledBackgroundScanline(int bgIndex, BGCNT const& control, int32_t dx, int32_t dy, int16_t pa, int16_t pc);
-
-    /// @brief Render sprites and mix with background.
-    /// @param windowSettingsPtr Pointer to OBJ window settings, or nullptr if rendering a visible sprites.
-    void EvaluateOAM(WindowSettings* windowSettingsPtr = nullptr);
-
-    /// @brief Render a one dimensional 4bpp sprite into an array of pixels.
-    /// @param x X-coordinate of top left corner of sprite.
-    /// @param y Y-coordinate of top left corner of sprite.
-    /// @param width Width of sprite in pixels.
-    /// @param height Height of sprite in pixels.
-    /// @param oamEntry Reference to OAM entry for sprite.
-    /// @param windowSettingsPtr Pointer to OBJ window settings, or nullptr if rendering a visible sprite.
-    void Render1d4bppRegularSprite(int x, int y, int width, int height, OamEntry const& oamEntry, WindowSettings* windowSettingsPtr);
-
-    /// @brief Render a one dimensional 8bpp sprite into an array of pixels.
-    /// @param x X-coordinate of top left corner of sprite.
-    /// @param y Y-coordinate of top left corner of sprite.
-    /// @param width Width of sprite in pixels.
-    /// @param height Height of sprite in pixels.
-    /// @param oamEntry Reference to OAM entry for sprite.
-    /// @param windowSettingsPtr Pointer to OBJ window settings, or nullptr if rendering a visible sprite.
-    void Render1d8bppRegularSprite(int x, int y, int width, int height, OamEntry const& oamEntry, WindowSettings* windowSettingsPtr);
-
-    /// @brief Render a two dimensional 4bpp sprite into an array of pixels.
-    /// @param x X-coordinate of top left corner of sprite.
-    /// @param y Y-coordinate of top left corner of sprite.
-    /// @param width Width of sprite in pixels.
-    /// @param height Height of sprite in pixels.
-    /// @param oamEntry Reference to OAM entry for sprite.
-    /// @param windowSettingsPtr Pointer to OBJ window settings, or nullptr if rendering a visible sprite.
-    void Render2d4bppRegularSprite(int x, int y, int width, int height, OamEntry const& oamEntry, WindowSettings* windowSettingsPtr);
-
-    /// @brief Render a two dimensional 8bpp sprite into an array of pixels.
-    /// @param x X-coordinate of top left corner of sprite.
-    /// @param y Y-coordinate of top left corner of sprite.
-    /// @param width Width of sprite in pixels.
-    /// @param height Height of sprite in pixels.
-    /// @param oamEntry Reference to OAM entry for sprite.
-    /// @param windowSettingsPtr Pointer to OBJ window settings, or nullptr if rendering a visible sprite.
-    void Render2d8bppRegularSprite(int x, int y, int width, int height, OamEntry const& oamEntry, WindowSettings* windowSettingsPtr);
-
-    /// @brief Render a one dimensional 4bpp affine sprite into an array of pixels.
-    /// @param x X-coordinate of top left corner of sprite.
-    /// @param y Y-coordinate of top left corner of sprite.
-    /// @param width Width of sprite in pixels.
-    /// @param height Height of sprite in pixels.
-    /// @param oamEntry Reference to OAM entry for sprite.
-    /// @param windowSettingsPtr Pointer to OBJ window settings, or nullptr if rendering a visible sprite.
-    void Render1d4bppAffineSprite(int x, int y, int width, int height, OamEntry const& oamEntry, WindowSettings* windowSettingsPtr);
-
-    /// @brief Render a two dimensional 4bpp affine sprite into an array of pixels.
-    /// @param x X-coordinate of top left corner of sprite.
-    /// @param y Y-coordinate of top left corner of sprite.
-    /// @param width Width of sprite in pixels.
-    /// @param height Height of sprite in pixels.
-    /// @param oamEntry Reference to OAM entry for sprite.
-    /// @param windowSettingsPtr Pointer to OBJ window settings, or nullptr if rendering a visible sprite.
-    void Render2d4bppAffineSprite(int x, int y, int width, int height, OamEntry const& oamEntry, WindowSettings* windowSettingsPtr);
-
-    /// @brief Render a one dimensional 8bpp affine sprite into an array of pixels.
-    /// @param x X-coordinate of top left corner of sprite.
-    /// @param y Y-coordinate of top left corner of sprite.
-    /// @param width Width of sprite in pixels.
-    /// @param height Height of sprite in pixels.
-    /// @param oamEntry Reference to OAM entry for sprite.
-    /// @param windowSettingsPtr Pointer to OBJ window settings, or nullptr if rendering a visible sprite.
-    void Render1d8bppAffineSprite(int x, int y, int width, int height, OamEntry const& oamEntry, WindowSettings* windowSettingsPtr);
-
-    /// @brief Render a two dimensional 8bpp affine sprite into an array of pixels.
-    /// @param x X-coordinate of top left corner of sprite.
-    /// @param y Y-coordinate of top left corner of sprite.
-    /// @param width Width of sprite in pixels.
-    /// @param height Height of sprite in pixels.
-    /// @param oamEntry Reference to OAM entry for sprite.
-    /// @param windowSettingsPtr Pointer to OBJ window settings, or nullptr if rendering a visible sprite.
-    void Render2d8bppAffineSprite(int x, int y, int width, int height, OamEntry const& oamEntry, WindowSettings* windowSettingsPtr);
-
-    void AddSpritePixelToLineBuffer(int dot, uint16_t bgr555, int priority, bool transparent, bool semiTransparent, WindowSettings* windowSettingsPtr);
-
-    /// @brief Increment BG2 and BG3 reference points after a scanline is rendered.
-    void IncrementAffineBackgroundReferencePoints();
+    /// @brief Send a command to the renderer. Executes it immediately if the render thread is not running.
+    /// @param command Command to send.
+    void SubmitRenderCommand(RenderCommand command);
+
+    /// @brief Wake the render thread if it is waiting for commands.
+    void WakeRenderThread();
+
+    /// @brief Main loop of the render thread. Executes commands until told to stop.
+    void RenderThreadMain();
 
     // Frame status
-    FrameBuffer frameBuffer_;
     uint8_t scanline_;
     bool window0EnabledOnScanline_;
     bool window1EnabledOnScanline_;
 
-    // Affine background reference points
-    int32_t bg2RefX_;
-    int32_t bg2RefY_;
-    int32_t bg3RefX_;
-    int32_t bg3RefY_;
+    // Frame skip
+    int frameSkip_;
+    int framesUntilDraw_;
+    bool skippingFrame_;
+
+    // Run-ahead
+    int runAheadFramesLeft_;
+    bool drawRunAhead_;
+    int runAheadFramesUntilDraw_;
+    uint64_t runAheadCompletedFrames_;
 
     // LCD I/O Registers (0400'0000h - 0400'005Fh)
     std::array<uint8_t, 0x60> lcdRegisters_;
@@ -242,7 +209,19 @@ private:
     std::array<uint8_t,  96 * KiB> VRAM_;
     std::array<uint8_t,   1 * KiB> OAM_;
 
-    // FPS counting
-    int frameCounter_;
+    // Rendering
+    static constexpr size_t RENDER_QUEUE_SIZE = 128 * 1024;
+    Renderer renderer_;
+    RingBuffer<RenderCommand, RENDER_QUEUE_SIZE> renderQueue_;
+    std::thread renderThread_;
+    std::mutex renderMutex_;
+    std::condition_variable renderCv_;
+    std::atomic_bool renderThreadWaiting_;
+    std::atomic_bool stopRenderThread_;
+    uint64_t submittedCommands_;
+    std::atomic_uint64_t executedCommands_;
+
+    EventScheduler& scheduler_;
+    SystemControl& systemControl_;
 };
 }
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <Graphics/FrameBuffer.hpp>
+#include <Graphics/Registers.hpp>
+#include <PixelFormat.hpp>
+#include <Utilities/MemoryUtilities.hpp>
+
+class AvCapture;
+class StateSerializer;
+
+namespace Graphics
+{
+struct OamEntry;
+
+/// @brief Actions the PPU forwards to the renderer, in the order they happened on the emulation thread.
+enum class RenderCommandType : uint8_t
+{
+    WRITE_PRAM,
+    WRITE_VRAM,
+    WRITE_OAM,
+    WRITE_REG,
+    RENDER_SCANLINE,
+    END_FRAME
+};
+
+/// @brief A single change to video state or request to draw.
+struct RenderCommand
+{
+    /// @brief Type of command.
+    RenderCommandType type_;
+
+    /// @brief Number of bytes written by a memory or register write.
+    AccessSize alignment_;
+
+    /// @brief Offset into the written memory region, or the scanline to draw.
+    uint32_t index_;
+
+    /// @brief Value written, the window 0 (bit 0) and window 1 (bit 1) enabled flags of the scanline to draw, or whether the
+    ///        frame being ended was skipped.
+    uint32_t value_;
+};
+
+/// @brief Composes scanlines from its own copy of video memory and LCD registers. The copy is kept up to date by replaying
+///        the writes seen by the PPU, so rendering can happen on a different thread than the one running the CPU while still
+///        seeing the exact state each scanline was drawn with.
+class Renderer
+{
+public:
+    /// @brief Initialize the renderer.
+    Renderer();
+
+    /// @brief Reset the renderer to its power-on state.
+    /// @param PRAM Current contents of palette RAM.
+    /// @param VRAM Current contents of VRAM.
+    /// @param OAM Current contents of OAM.
+    void Reset(std::array<uint8_t, 1 * KiB> const& PRAM,
+               std::array<uint8_t, 96 * KiB> const& VRAM,
+               std::array<uint8_t, 1 * KiB> const& OAM);
+
+    /// @brief Save or load the renderer's registers and position in the frame. Video memory isn't saved since the renderer's copy
+    ///        matches the PPU's once every command has been executed, so it's copied from the PPU when loading instead.
+    /// @param state Serializer to save state to or load state from.
+    /// @param PRAM Current contents of palette RAM.
+    /// @param VRAM Current contents of VRAM.
+    /// @param OAM Current contents of OAM.
+    void Serialize(StateSerializer& state,
+                   std::array<uint8_t, 1 * KiB> const& PRAM,
+                   std::array<uint8_t, 96 * KiB> const& VRAM,
+                   std::array<uint8_t, 1 * KiB> const& OAM);
+
+    /// @brief Apply a memory or register write, or draw a scanline.
+    /// @param command Command to execute.
+    void Execute(RenderCommand const& command);
+
+    /// @brief Take ownership of the most recently completed frame, releasing the previously acquired one. Safe to call while
+    ///        the renderer is executing commands on another thread.
+    /// @return Latest frame. Its pixel data is valid until the next call.
+    CompletedFrame AcquireFrame() { return frameBuffer_.AcquireFrame(); }
+
+    /// @brief Choose the pixel format of the frame buffer. Must not be called while the renderer is executing commands.
+    /// @param format Output pixel format.
+    /// @param colorCorrection Whether to approximate the colors of the GBA's LCD.
+    void SetOutputFormat(PixelFormat format, bool colorCorrection);
+
+    /// @brief Get the number of frames completed so far, including skipped ones. Must not be called while the renderer is
+    ///        executing commands.
+    /// @return Number of completed frames.
+    uint64_t CompletedFrames() const { return frameBuffer_.CompletedFrames(); }
+
+    /// @brief Set the number of frames completed so far, such as to undo frames that were run ahead. Must not be called while
+    ///        the renderer is executing commands.
+    /// @param frames Number of completed frames.
+    void SetCompletedFrames(uint64_t frames) { frameBuffer_.SetCompletedFrames(frames); }
+
+    /// @brief Choose caller owned memory to draw frames straight into. Must not be called while the renderer is executing commands.
+    /// @param target 240x160 pixels in the output format, or nullptr to draw into the internal frame buffer.
+    void SetFrameTarget(uint8_t* target);
+
+    /// @brief Choose a function to call each time a frame completes. Must not be called while the renderer is executing commands.
+    /// @param callback Function to call with the sequence number of each completed frame.
+    void SetFrameCallback(std::function<void(uint64_t)> callback) { frameBuffer_.SetFrameCallback(std::move(callback)); }
+
+    /// @brief Choose where to send a copy of each completed frame for recording. Must not be called while the renderer is
+    ///        executing commands.
+    /// @param capture Capture to push frames to, or nullptr to stop sending them anywhere.
+    void SetCapture(AvCapture* capture) { frameBuffer_.SetCapture(capture); }
+
+    /// @brief Get the pixel format of the frame buffer.
+    /// @return Output pixel format.
+    PixelFormat GetOutputFormat() const { return frameBuffer_.GetOutputFormat(); }
+
+private:
+    /// @brief Everything besides the scanline index that determines the output of a rendered scanline.
+    struct ScanlineState
+    {
+        uint64_t version_;
+        std::array<int32_t, 4> refPoints_;
+        bool window0Enabled_;
+        bool window1Enabled_;
+
+        bool operator==(ScanlineState const&) const = default;
+    };
+
+    /// @brief Indices of the OAM entries that cross a scanline, in OAM order.
+    struct SpriteBin
+    {
+        std::array<uint8_t, 128> indices_;
+        size_t count_;
+    };
+
+    /// @brief Draw the current scanline into the frame buffer.
+    void RenderScanline();
+
+    /// @brief Finish the current frame and reload the affine reference points.
+    /// @param skipped Whether none of the frame's scanlines were drawn. Skipped frames are counted but not handed off.
+    void EndFrame(bool skipped);
+
+    /// @brief Apply window settings to pixels within a window on the current scanline.
+    /// @param leftEdge X1 - Left edge of window (inclusive).
+    /// @param rightEdge X2 - Right edge of window (exclusive).
+    /// @param settings Settings for inside this window region.
+    void ConfigureNonObjWindow(uint8_t leftEdge, uint8_t rightEdge, WindowSettings settings);
+
+    /// @brief Render BG pixels in mode 0.
+    void RenderMode0Scanline();
+
+    /// @brief Render BG pixels in mode 1.
+    void RenderMode1Scanline();
+
+    /// @brief Render BG pixels in mode 2.
+    void RenderMode2Scanline();
+
+    /// @brief Render BG pixels in mode 3.
+    void RenderMode3Scanline();
+
+    /// @brief Render BG pixels in mode 4.
+    void RenderMode4Scanline();
+
+    /// @brief Render BG pixels in mode 5.
+    void RenderMode5Scanline();
+
+    /// @brief Check whether the current scanline is a bitmap mode scanline without windows, sprites, or color special effects,
+    ///        meaning BG2 can be written straight to the output without going through the compositor.
+    /// @return True if RenderBitmapScanlineDirect can be used for the current scanline.
+    bool DirectBitmapScanline() const;
+
+    /// @brief Write the current bitmap mode scanline directly to the frame buffer.
+    void RenderBitmapScanlineDirect();
+
+    /// @brief Render a regular tiled text background scanline.
+    /// @param bgIndex Which background to render.
+    /// @param control Control register of specified background.
+    /// @param xOffset X offset register value of specified background.
+    /// @param yOffset Y offset register value of specified background.
+    void RenderRegularTiledBackgroundScanline(int bgIndex, BGCNT const& control, int xOffset, int yOffset);
+
+    /// @brief Render a regular tiled text background scanline that uses 4bpp colors.
+    /// @param bgIndex Which background to render.
+    /// @param control Control register of specified background.
+    /// @param x X-coordinate within background map.
+    /// @param y Y-Coordinate within background map.
+    /// @param width Width of map.
+    void RenderRegular4bppBackground(int bgIndex, BGCNT const& control, int x, int y, int width);
+
+    /// @brief Render a regular tiled text background scanline that uses 8bpp colors.
+    /// @param bgIndex Which background to render.
+    /// @param control Control register of specified background.
+    /// @param x X-coordinate within background map.
+    /// @param y Y-Coordinate within background map.
+    /// @param width Width of map.
+    void RenderRegular8bppBackground(int bgIndex, BGCNT const& control, int x, int y, int width);
+
+    /// @brief Render a tiled affined background scanline.
+    /// @param bgIndex Which background to render.
+    /// @param control Control register of specified background.
+    /// @param dx Reference point x-coordinate.
+    /// @param dy Reference point y-coordinate.
+    /// @param pa Amount to increment x-coordinate by after each pixel.
+    /// @param pc Amount to increment y-coordinate by after each pixel.
+    void RenderAffineTiledBackgroundScanline(int bgIndex, BGCNT const& control, int32_t dx, int32_t dy, int16_t pa, int16_t pc);
+
+    /// @brief Sort each enabled OAM entry into the bin of every scanline it crosses.
+    void RebuildSpriteBins();
+
+    /// @brief Render sprites and mix with background.
+    /// @param objWindowPtr Mask to mark the OBJ window in, or nullptr if rendering visible sprites.
+    void EvaluateOAM(WindowMask* objWindowPtr = nullptr);
+
+    /// @brief Render the part of a sprite that's on the current scanline. Each combination of sprite attributes gets its own
+    ///        instantiation, so that the inner loops don't need to check them for every pixel.
+    /// @tparam OneDimMapping Whether sprite tiles are laid out with one dimensional mapping.
+    /// @tparam Color256 Whether the sprite uses 8bpp colors.
+    /// @tparam Affine Whether the sprite uses rotation/scaling.
+    /// @tparam ObjWindow Whether the sprite marks the OBJ window instead of being drawn.
+    /// @param x X-coordinate of top left corner of sprite, or of its center if it's double sized.
+    /// @param y Y-coordinate of top left corner of sprite, or of its center if it's double sized.
+    /// @param width Width of sprite in pixels.
+    /// @param height Height of sprite in pixels.
+    /// @param oamEntry Reference to OAM entry for sprite.
+    /// @param objWindowPtr Mask to mark the OBJ window in. Only used when ObjWindow is true.
+    template <bool OneDimMapping, bool Color256, bool Affine, bool ObjWindow>
+    void RenderSprite(int x, int y, int width, int height, OamEntry const& oamEntry, WindowMask* objWindowPtr);
+
+    /// @brief Instantiation of RenderSprite for one combination of sprite attributes.
+    using SpriteRenderer = void (Renderer::*)(int, int, int, int, OamEntry const&, WindowMask*);
+
+    /// @brief RenderSprite instantiations, indexed by one dimensional mapping (bit 3), 8bpp (bit 2), affine (bit 1), and OBJ
+    ///        window (bit 0).
+    static std::array<SpriteRenderer, 16> const SPRITE_RENDERERS;
+
+    /// @brief Increment BG2 and BG3 reference points after a scanline is rendered.
+    void IncrementAffineBackgroundReferencePoints();
+
+    /// @brief Capture the state that the current scanline will be rendered with.
+    /// @return Current scanline state.
+    ScanlineState CurrentScanlineState() const;
+
+    // Frame status
+    FrameBuffer frameBuffer_;
+    int scanline_;
+    bool window0EnabledOnScanline_;
+    bool window1EnabledOnScanline_;
+
+    // Affine background reference points
+    int32_t bg2RefX_;
+    int32_t bg2RefY_;
+    int32_t bg3RefX_;
+    int32_t bg3RefY_;
+
+    // LCD I/O Registers (0400'0000h - 0400'005Fh)
+    std::array<uint8_t, 0x60> lcdRegisters_;
+    DISPCNT& dispcnt_;
+
+    // Sprites crossing each scanline, rebuilt before the next sprite pass whenever OAM changes
+    std::array<SpriteBin, LCD_HEIGHT> spriteBins_;
+    bool spriteBinsDirty_;
+
+    // Memory
+    std::array<uint8_t,   1 * KiB> PRAM_;
+    std::array<uint8_t,  96 * KiB> VRAM_;
+    std::array<uint8_t,   1 * KiB> OAM_;
+
+    // Dirty tracking. stateVersion_ is incremented whenever memory or registers that affect rendering change, so that a
+    // scanline whose state matches the one it was last drawn with in the previous frame can be copied instead of rendered.
+    uint64_t stateVersion_;
+    std::array<ScanlineState, LCD_HEIGHT> previousScanlineStates_;
+    bool frameModified_;
+};
+}
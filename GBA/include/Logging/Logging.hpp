@@ -1,16 +1,22 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <exception>
 #include <filesystem>
+#include <memory>
 #include <string>
 #include <vector>
+#include <Config.hpp>
 #include <DMA/DmaChannel.hpp>
 #include <System/SystemControl.hpp>
 #include <Utilities/CircularBuffer.hpp>
 
 namespace fs = std::filesystem;
 
+class EventScheduler;
+
 namespace Logging
 {
 constexpr size_t LOG_BUFFER_SIZE = 100'000;
@@ -20,34 +26,70 @@ constexpr size_t LOG_BUFFER_SIZE = 100'000;
 /// @return ARM condition mnemonic.
 std::string ConditionMnemonic(uint8_t condition);
 
+/// @brief Snapshot of the CPU taken just before an instruction executes. Disassembly and formatting are deferred until the
+///        log is dumped, so tracing only costs a copy of the register file per instruction.
+struct InstructionRecord
+{
+    uint64_t cycle_;
+    uint64_t messageIndex_;  // Number of system messages logged before this instruction, used to interleave the two at dump time
+    uint32_t pc_;
+    uint32_t opcode_;
+    std::array<uint32_t, 16> registers_;
+    uint32_t cpsr_;
+    uint32_t spsr_;
+};
+
+/// @brief Disassemble and format a logged instruction.
+/// @param record Logged instruction.
+/// @return Log line for this instruction.
+std::string InstructionString(InstructionRecord const& record);
+
+class TraceWriter;
+
 class LogManager
 {
 public:
     /// @brief Initialize with logging disabled.
-    LogManager();
+    /// @param scheduler Scheduler that logged messages are timestamped with.
+    LogManager(EventScheduler const& scheduler);
+
+    /// @brief Stop streaming if a trace is being streamed to disk.
+    ~LogManager();
+
+    LogManager() = delete;
+    LogManager(LogManager const&) = delete;
+    LogManager& operator=(LogManager const&) = delete;
 
-    /// @brief Initialize LogManager and prepare to log.
+    /// @brief Initialize LogManager and prepare to log. Nothing is touched on disk until there's something to write.
     void Initialize();
 
-    /// @brief Toggle system event logging on/off.
-    void ToggleSystemLogging() { systemLoggingEnabled_ = !systemLoggingEnabled_; }
+    /// @brief Toggle system event logging on/off. The message buffer is allocated the first time this is enabled.
+    void ToggleSystemLogging();
 
-    /// @brief Toggle CPU instruction logging on/off.
-    void ToggleCpuLogging() { cpuLoggingEnabled_ = !cpuLoggingEnabled_; }
+    /// @brief Toggle CPU instruction logging on/off. The instruction trace buffer is allocated the first time this is enabled.
+    void ToggleCpuLogging();
 
-    /// @brief Check if system logging is currently enabled.
+    /// @brief Toggle streaming of logged instructions and system events to a trace file instead of keeping only the most recent
+    ///        ones in memory. Safe to call from any thread; the change takes effect the next time something is logged.
+    void ToggleTraceStreaming() { streamingRequested_.store(!streamingRequested_.load()); }
+
+    /// @brief Check if system logging is currently enabled. Always false when logging is compiled out, so guarded logging calls
+    ///        are removed entirely.
     /// @return True if system events should be logged.
-    bool SystemLoggingEnabled() const { return systemLoggingEnabled_; }
+    bool SystemLoggingEnabled() const { return LOGGING_ENABLED && systemLoggingEnabled_; }
 
-    /// @brief Check if CPU logging is currently enabled.
+    /// @brief Check if CPU logging is currently enabled. Always false when logging is compiled out, so guarded logging calls
+    ///        are removed entirely.
     /// @return True if CPU instructions should be logged.
-    bool CpuLoggingEnabled() const { return cpuLoggingEnabled_; }
+    bool CpuLoggingEnabled() const { return LOGGING_ENABLED && cpuLoggingEnabled_; }
 
-    /// @brief Save a logged instruction into buffer.
+    /// @brief Save an instruction that's about to execute into the trace buffer, overwriting the oldest one if it's full.
     /// @param pc PC value of logged instruction.
-    /// @param mnemonic Human readable mnemonic.
-    /// @param registers 
-    void LogInstruction(uint32_t pc, std::string mnemonic, std::string registers);
+    /// @param opcode Undecoded ARM or THUMB instruction.
+    /// @param registers R0-R15 in the current operating mode.
+    /// @param cpsr Current CPSR value.
+    /// @param spsr SPSR of current operating mode.
+    void LogInstruction(uint32_t pc, uint32_t opcode, std::array<uint32_t, 16> const& registers, uint32_t cpsr, uint32_t spsr);
 
     /// @brief Log when an IRQ occurs.
     void LogIRQ();
@@ -83,7 +125,8 @@ public:
     /// @param index Index of timer that overflowed.
     void LogTimerOverflow(int index);
 
-    /// @brief Dump logged instructions to file.
+    /// @brief Disassemble logged instructions and dump them to file along with any system messages. If a trace is being
+    ///        streamed, everything logged so far is also flushed to the trace file.
     void DumpLogs();
 
 private:
@@ -91,13 +134,29 @@ private:
     /// @param message Message to log.
     void LogMessage(std::string message);
 
-    CircularBuffer<std::string, LOG_BUFFER_SIZE> buffer_;
+    /// @brief Start or stop streaming to match the most recent call to ToggleTraceStreaming.
+    void UpdateStreaming();
+
+    /// @brief Create the log directory and clear the previous log the first time anything is written to disk.
+    void PrepareLogDirectory();
+
+    std::unique_ptr<CircularBuffer<std::string, LOG_BUFFER_SIZE>> buffer_;
+    uint64_t messagesLogged_;
+
+    std::vector<InstructionRecord> instructionBuffer_;
+    size_t instructionHead_;
+    size_t instructionCount_;
+
+    std::atomic<bool> streamingRequested_;
+    std::unique_ptr<TraceWriter> traceWriter_;
+    fs::path tracePath_;
 
     fs::path logPath_;
     bool loggingInitialized_;
+    bool logDirectoryPrepared_;
     bool systemLoggingEnabled_;
     bool cpuLoggingEnabled_;
-};
 
-extern LogManager LogMgr;
+    EventScheduler const& scheduler_;
+};
 }
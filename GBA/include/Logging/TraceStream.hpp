@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <Logging/Logging.hpp>
+
+namespace fs = std::filesystem;
+
+namespace Logging
+{
+constexpr size_t TRACE_CHUNK_SIZE = 32'768;
+
+/// @brief Streams instruction records and system messages to a compressed trace file. Records are collected into one of two
+///        fixed size chunks while a background thread encodes and writes the other, so memory use stays constant no matter how
+///        long the trace runs. Each record is stored as the difference from the one before it, which is typically only the PC
+///        and a couple of registers.
+class TraceWriter
+{
+public:
+    /// @brief Create a trace file and start the writer thread.
+    /// @param tracePath Path of trace file to create. Any existing file is overwritten.
+    /// @throws std::runtime_error if the trace file can't be created.
+    explicit TraceWriter(fs::path tracePath);
+
+    /// @brief Write any records that are still buffered and stop the writer thread.
+    ~TraceWriter();
+
+    TraceWriter() = delete;
+    TraceWriter(TraceWriter const&) = delete;
+    TraceWriter& operator=(TraceWriter const&) = delete;
+
+    /// @brief Get the next record slot to fill in. If the current chunk is full it's handed off to the writer thread first.
+    /// @return Reference to uninitialized record.
+    InstructionRecord& NextRecord();
+
+    /// @brief Add a system message to the trace, ordered after any records already added.
+    /// @param message Fully formatted message.
+    void AddMessage(std::string message);
+
+    /// @brief Hand off whatever is currently buffered to the writer thread and wait for it to reach the disk.
+    void Flush();
+
+private:
+    struct Chunk
+    {
+        std::vector<InstructionRecord> records_;
+        std::vector<std::pair<size_t, std::string>> messages_;  // Number of records preceding each message
+    };
+
+    /// @brief Pass the active chunk to the writer thread and swap to the other one. Only blocks if the writer is still busy
+    ///        with the previous chunk.
+    void SubmitActiveChunk();
+
+    /// @brief Main loop of writer thread. Encodes and writes chunks as they're submitted.
+    void WriterLoop();
+
+    /// @brief Append a delta encoded record to the output buffer.
+    /// @param record Record to encode.
+    void EncodeRecord(InstructionRecord const& record);
+
+    /// @brief Append a message to the output buffer.
+    /// @param message Message to encode.
+    void EncodeMessage(std::string const& message);
+
+    // Double buffer. The active chunk belongs to the emulation thread and a pending chunk to the writer thread.
+    std::array<Chunk, 2> chunks_;
+    size_t activeChunk_;
+
+    // Writer thread only
+    std::ofstream traceFile_;
+    std::vector<char> output_;
+    InstructionRecord previousRecord_;
+
+    // Shared with writer thread
+    std::mutex lock_;
+    std::condition_variable chunkSubmitted_;
+    std::condition_variable chunkWritten_;
+    bool chunkPending_;
+    size_t pendingChunk_;
+    bool stop_;
+    std::thread writerThread_;
+};
+
+/// @brief Convert a trace file created by TraceWriter into the same text format used by LogManager::DumpLogs.
+/// @param tracePath Path to trace file.
+/// @param logPath Path of text log to create.
+/// @throws std::runtime_error if the trace file can't be read or is malformed.
+void DecodeTrace(fs::path tracePath, fs::path logPath);
+}
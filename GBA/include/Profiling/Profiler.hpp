@@ -0,0 +1,98 @@
+#pragma once
+
+#include <AdvancedBoy.hpp>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <unordered_map>
+#include <System/EventScheduler.hpp>
+
+namespace fs = std::filesystem;
+
+namespace Profiling
+{
+// Executed code is grouped into ranges of 2^PC_RANGE_SHIFT bytes
+constexpr uint32_t PC_RANGE_SHIFT = 5;
+constexpr size_t REGION_COUNT = 16;
+
+/// @brief Counts where emulated cycles go. Every Record/Add call is made from inside an `if constexpr (PROFILER_ENABLED)` block,
+///        so builds without the profiler never touch it.
+class Profiler
+{
+public:
+    /// @brief Initialize the profiler.
+    /// @param scheduler Reference to event scheduler, which counts each event that fires and how late it fired.
+    Profiler(EventScheduler& scheduler);
+
+    /// @brief Clear all counts, including the scheduler's event lateness.
+    void Reset();
+
+    /// @brief Count an executed instruction.
+    /// @param pc Address of instruction.
+    /// @param cycles Cycles from fetching the instruction until it finished executing.
+    void RecordInstruction(uint32_t pc, uint64_t cycles);
+
+    /// @brief Count a single read or write.
+    /// @param addr Address accessed.
+    /// @param cycles Cycles taken by the access.
+    void RecordAccess(uint32_t addr, int cycles)
+    {
+        size_t region = (addr < 0x1000'0000) ? (addr >> 24) : 1;
+        ++accesses_[region];
+        accessCycles_[region] += cycles;
+    }
+
+    /// @brief Count cycles spent running the CPU.
+    /// @param cycles Number of cycles.
+    void AddCpuCycles(uint64_t cycles) { cpuCycles_ += cycles; }
+
+    /// @brief Count cycles stolen by DMA transfers.
+    /// @param cycles Number of cycles.
+    void AddDmaCycles(uint64_t cycles) { dmaCycles_ += cycles; }
+
+    /// @brief Count cycles skipped while halted.
+    /// @param cycles Number of cycles.
+    void AddHaltCycles(uint64_t cycles) { haltCycles_ += cycles; }
+
+    /// @brief Count cycles skipped due to an idle loop.
+    /// @param cycles Number of cycles.
+    void AddIdleLoopCycles(uint64_t cycles) { idleLoopCycles_ += cycles; }
+
+    /// @brief Gather all counts into a report.
+    /// @return Profiling results.
+    ProfileReport Report() const;
+
+    /// @brief Write all counts in collapsed stack format.
+    /// @param path Path of file to create.
+    /// @throws std::runtime_error if the file can't be created.
+    void WriteFlameGraph(fs::path path) const;
+
+private:
+    struct PcRangeStats
+    {
+        uint64_t instructions_;
+        uint64_t cycles_;
+    };
+
+    EventScheduler& scheduler_;
+
+    // The scheduler counts events from power on, so keep its counts from the last reset to subtract
+    std::array<uint64_t, static_cast<size_t>(EventType::COUNT)> eventCountsAtReset_;
+
+    // Executed code, keyed by PC >> PC_RANGE_SHIFT. Most instructions land in the same range as the one before, so that range
+    // is cached to skip the lookup. Pointers to unordered_map elements stay valid across rehashing.
+    std::unordered_map<uint32_t, PcRangeStats> pcRanges_;
+    uint32_t lastRangeKey_;
+    PcRangeStats* lastRange_;
+
+    // Memory accesses by region
+    std::array<uint64_t, REGION_COUNT> accesses_;
+    std::array<uint64_t, REGION_COUNT> accessCycles_;
+
+    // Where time went outside of individual instructions
+    uint64_t cpuCycles_;
+    uint64_t dmaCycles_;
+    uint64_t haltCycles_;
+    uint64_t idleLoopCycles_;
+};
+}
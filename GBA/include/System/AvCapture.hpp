@@ -0,0 +1,174 @@
+#pragma once
+
+#include <AdvancedBoy.hpp>
+#include <PixelFormat.hpp>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <Utilities/RingBuffer.hpp>
+
+namespace fs = std::filesystem;
+
+/// @brief Records every published frame and all resampled audio to disk. Producers copy each frame and each block of audio once
+///        into a pooled buffer and queue it for a background encoder thread, which does all the encoding and file I/O. Queueing
+///        never locks or waits, so capturing can't stall the emulation or render thread.
+///
+///        When the encoder falls behind, frames that find every pooled frame buffer in use are dropped, and audio that doesn't fit
+///        in the audio pool is replaced with the same amount of silence. The encoder repeats the previous frame in place of each
+///        frame missing from the sequence, whether it was dropped or skipped, so the video keeps a constant frame rate and stays
+///        in sync with the audio. Drops are logged to a text file next to the capture.
+class AvCapture
+{
+public:
+    /// @brief Create the output files and start the encoder thread.
+    /// @param path Path of video file to create. Audio is written to <path>.wav and drops are logged to <path>.log.
+    /// @param format How to write the video.
+    /// @param ffmpegOptions Output options passed to ffmpeg when encoding the video with CaptureFormat::FFmpeg.
+    /// @param pixelFormat Pixel format of the frames that will be pushed.
+    /// @param sampleRate Output sample rate of the audio that will be pushed.
+    /// @throws std::runtime_error if an output file or the ffmpeg process can't be created.
+    AvCapture(fs::path path, CaptureFormat format, std::string const& ffmpegOptions, PixelFormat pixelFormat, int sampleRate);
+
+    /// @brief Stop the capture if Stop hasn't been called, ignoring any error.
+    ~AvCapture();
+
+    AvCapture() = delete;
+    AvCapture(AvCapture const&) = delete;
+    AvCapture& operator=(AvCapture const&) = delete;
+
+    /// @brief Copy a published frame into the pool and queue it for encoding, or drop it if every pooled frame is in use. Only
+    ///        call from the thread that publishes frames. Never blocks.
+    /// @param pixels 240x160 pixels in the pixel format the capture was started with.
+    /// @param sequence Sequence number of the frame.
+    void PushFrame(uint8_t const* pixels, uint64_t sequence);
+
+    /// @brief Copy resampled audio into the pool and queue it for encoding, or replace it with silence if it doesn't fit. Only
+    ///        call from the emulation thread. Never blocks.
+    /// @param samples Interleaved stereo samples.
+    /// @param cnt Number of samples, counting left and right separately.
+    void PushAudio(float const* samples, size_t cnt);
+
+    /// @brief Get how much has been captured so far. Safe to call from any thread.
+    /// @return Progress of the capture.
+    CaptureStats Stats() const;
+
+    /// @brief Encode everything still queued, stop the encoder thread, and finish the output files. Nothing may be pushed after
+    ///        this is called.
+    /// @return Final progress of the capture.
+    /// @throws std::runtime_error if writing the capture failed partway.
+    CaptureStats Stop();
+
+private:
+    static constexpr size_t FRAME_POOL_SIZE = 16;
+    static constexpr size_t AUDIO_POOL_SIZE = 256 * 1024;  // Over a second of stereo audio at the highest output rate
+    static constexpr size_t AUDIO_BLOCK_SIZE = 4096;
+
+    /// @brief A frame waiting to be encoded.
+    struct QueuedFrame
+    {
+        uint64_t sequence_;
+        uint32_t slot_;  // Index of pooled frame buffer holding the frame
+    };
+
+    /// @brief Wake the encoder thread after queueing something. Never blocks.
+    void WakeEncoder()
+    {
+        work_.fetch_add(1, std::memory_order_release);
+        work_.notify_one();
+    }
+
+    /// @brief Main loop of encoder thread. Encodes whatever is queued until the capture is stopped.
+    void EncoderLoop();
+
+    /// @brief Encode everything that's currently queued and return the frame buffers it was in to the pool.
+    void EncodeQueued();
+
+    /// @brief Write a frame to the video, preceded by repeats of the previous frame in place of any frames missing from the
+    ///        sequence.
+    /// @param pixels Pixels of frame.
+    /// @param sequence Sequence number of frame.
+    void EncodeFrame(uint8_t const* pixels, uint64_t sequence);
+
+    /// @brief Write one frame to the video in the capture's format.
+    /// @param pixels Pixels of frame.
+    void WriteFrame(uint8_t const* pixels);
+
+    /// @brief Append audio samples to the WAV file.
+    /// @param samples Interleaved stereo samples.
+    /// @param cnt Number of samples.
+    void WriteAudio(float const* samples, size_t cnt);
+
+    /// @brief Log any drops that happened since the last call.
+    /// @param sequence Sequence number of the frame most recently encoded.
+    void LogDrops(uint64_t sequence);
+
+    /// @brief Add a line to the capture log, creating it the first time.
+    /// @param message Message to log.
+    void Log(std::string const& message);
+
+    /// @brief Remember the first error writing the capture and stop writing anything else but the log.
+    /// @param message Description of error.
+    void Fail(std::string const& message);
+
+    /// @brief Fill in the sizes in the WAV header now that all audio has been written.
+    void FinishWav();
+
+    /// @brief Close the pipe to ffmpeg and mux the encoded video with the audio into the final output.
+    void FinishFFmpeg();
+
+    // Settings
+    fs::path path_;
+    fs::path audioPath_;
+    fs::path logPath_;
+    fs::path ffmpegVideoPath_;
+    CaptureFormat format_;
+    PixelFormat pixelFormat_;
+    int sampleRate_;
+    size_t frameSize_;
+
+    // Frame pool. Free slots go back to the producer and filled ones forward to the encoder.
+    std::vector<uint8_t> framePool_;
+    RingBuffer<uint32_t, FRAME_POOL_SIZE + 1> freeSlots_;
+    RingBuffer<QueuedFrame, FRAME_POOL_SIZE + 1> queuedFrames_;
+
+    // Audio pool, plus silence owed in place of dropped samples that's queued ahead of the next samples that fit
+    RingBuffer<float, AUDIO_POOL_SIZE> queuedAudio_;
+    size_t pendingSilence_;
+
+    // Shared with encoder thread. The work counter changes whenever there's something new for the encoder to look at.
+    std::atomic_uint32_t work_;
+    std::atomic_bool stop_;
+    std::atomic_uint64_t framesWritten_;
+    std::atomic_uint64_t framesDropped_;
+    std::atomic_uint64_t samplesWritten_;
+    std::atomic_uint64_t samplesDropped_;
+    bool stopped_;
+    std::thread encoderThread_;
+
+    // Encoder thread only
+    std::ofstream videoFile_;
+    std::ofstream audioFile_;
+    std::ofstream logFile_;
+    std::FILE* ffmpegPipe_;
+    std::vector<uint8_t> previousFrame_;
+    std::vector<char> output_;
+    std::array<float, AUDIO_BLOCK_SIZE> audioBlock_;
+    uint64_t previousSequence_;
+    uint64_t loggedFramesDropped_;
+    uint64_t loggedSamplesDropped_;
+    uint64_t audioBytes_;
+    std::string error_;
+};
+
+/// @brief Convert video captured with CaptureFormat::Lossless into raw frames.
+/// @param capturePath Path to lossless capture.
+/// @param rawPath Path of raw video file to create.
+/// @throws std::runtime_error if the capture can't be read or is malformed.
+void DecodeLosslessCapture(fs::path capturePath, fs::path rawPath);
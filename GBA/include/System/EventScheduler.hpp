@@ -1,10 +1,12 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <functional>
 #include <optional>
-#include <unordered_map>
-#include <vector>
+#include <Utilities/MemoryUtilities.hpp>
+
+class StateSerializer;
 
 constexpr int SCHEDULE_NOW = 0;
 
@@ -12,29 +14,12 @@ constexpr int SCHEDULE_NOW = 0;
 ///        the same time (lower value = higher priority).
 enum class EventType
 {
-    // APU
-    Channel1Clock,
-    Channel1Envelope,
-    Channel1LengthTimer,
-    Channel1FrequencySweep,
-
-    Channel2Clock,
-    Channel2Envelope,
-    Channel2LengthTimer,
-
-    Channel4Clock,
-    Channel4Envelope,
-    Channel4LengthTimer,
-
     // Timers
     Timer0Overflow,
     Timer1Overflow,
     Timer2Overflow,
     Timer3Overflow,
 
-    // DMA
-    DmaComplete,
-
     // PPU
     HBlank,
     VBlank,
@@ -47,22 +32,26 @@ enum class EventType
     COUNT
 };
 
+// Buckets of event lateness histograms. Bucket 0 counts events that fired on the cycle they were scheduled for, bucket i counts
+// events that fired 2^(i-1) to 2^i - 1 cycles late, and the last bucket also counts anything later.
+constexpr size_t LATENESS_BUCKETS = 16;
+
+/// @brief How late events of one type fired, in cycles past the cycle they were scheduled for.
+struct EventLateness
+{
+    uint64_t total_;
+    uint64_t max_;
+    std::array<uint64_t, LATENESS_BUCKETS> histogram_;
+};
+
 /// @brief Data needed to execute a scheduled event.
 struct Event
 {
-    /// @brief What type of event this is.
-    EventType eventType_;
-
     /// @brief Cycle that this event was added to queue.
     uint64_t cycleQueued_;
 
     /// @brief Cycle that this event should execute its callback.
     uint64_t cycleToExecute_;
-
-    /// @brief Compare priority of events. If A > B, then B should execute first.
-    /// @param rhs Event to compare.
-    /// @return True if rhs is a lower priority event.
-    bool operator>(Event const& rhs) const;
 };
 
 /// @brief Manager for scheduling and executing events.
@@ -74,13 +63,25 @@ public:
 
     void Reset();
 
-    /// @brief Advance the scheduler during a CPU instruction.
+    /// @brief Advance the scheduler during a CPU instruction. Fires any events that become ready.
     /// @param cycles Number of cycles to advance.
-    void Step(uint64_t cycles);
+    void Step(uint64_t cycles) { totalCycles_ += cycles; if (EventReady()) { CheckEventQueue(); } }
 
     /// @brief Check for any events to fire after a CPU instruction completes.
     void CheckEventQueue();
 
+    /// @brief Advance the scheduler without checking for events to fire.
+    /// @param cycles Number of cycles to advance.
+    void AdvanceCycles(uint64_t cycles) { totalCycles_ += cycles; }
+
+    /// @brief Check if the next event in the queue is ready to fire.
+    /// @return True if CheckEventQueue would execute at least one event.
+    bool EventReady() const { return totalCycles_ >= nextEventCycle_; }
+
+    /// @brief Get the cycle that the next scheduled event will fire on.
+    /// @return Cycle of next event, or MAX_U64 if no events are scheduled.
+    uint64_t NextEventCycle() const { return nextEventCycle_; }
+
     /// @brief If the CPU is stopped due to a halt or DMA transfer, skip straight to next event.
     void SkipToNextEvent();
 
@@ -89,7 +90,8 @@ public:
     /// @param callback Callback function to use for eventType.
     void RegisterEvent(EventType eventType, std::function<void(int)> callback);
 
-    /// @brief Schedule an event to be executed in some number of cycles from now.
+    /// @brief Schedule an event to be executed in some number of cycles from now. Only one event of each type can be scheduled at a
+    ///        time; scheduling an event that is already queued replaces it.
     /// @param event Type of event that should be scheduled.
     /// @param cycles Number of cycles from now that this event should fire.
     void ScheduleEvent(EventType eventType, int cycles);
@@ -130,11 +132,62 @@ public:
     /// @return Total number of cycles.
     uint64_t TotalCycles() const { return totalCycles_; }
 
+    /// @brief Get how many times each event type has fired since power on.
+    /// @return Number of times each event fired, indexed by event type.
+    std::array<uint64_t, static_cast<size_t>(EventType::COUNT)> const& EventCounts() const { return eventCounts_; }
+
+    /// @brief Get how much host time has been spent in each event type's callback since power on. Only timed in builds with
+    ///        component telemetry enabled.
+    /// @return Nanoseconds spent in each event's callback, indexed by event type.
+    std::array<uint64_t, static_cast<size_t>(EventType::COUNT)> const& EventHostTime() const { return eventHostTime_; }
+
+    /// @brief Get how much host time has been spent in all event callbacks since power on.
+    /// @return Nanoseconds spent in event callbacks.
+    uint64_t TotalEventHostTime() const { return totalEventHostTime_; }
+
+    /// @brief Get how late each event type fired since lateness was last reset. Only gathered in builds with the profiler.
+    /// @return Lateness of each event type, indexed by event type.
+    std::array<EventLateness, static_cast<size_t>(EventType::COUNT)> const& EventLatenessStats() const { return eventLateness_; }
+
+    /// @brief Clear the lateness of every event type.
+    void ResetEventLateness() { eventLateness_.fill({}); }
+
+    void Serialize(StateSerializer& state);
+
 private:
-    std::vector<Event> queue_;
-    std::unordered_map<EventType, std::function<void(int)>> registeredEvents_;
+    /// @brief Find the event that should fire next and cache it.
+    void UpdateNextEvent();
+
+    /// @brief Add a fired event to its type's lateness.
+    /// @param eventType Type of event that fired.
+    /// @param lateCycles Number of cycles past its scheduled cycle that the event fired.
+    void RecordLateness(EventType eventType, uint64_t lateCycles);
+
+    /// @brief Get the bit representing an event type in scheduledEvents_.
+    /// @param eventType Event type.
+    /// @return Bit mask for event type.
+    static uint32_t EventBit(EventType eventType) { return 0x01 << static_cast<uint32_t>(eventType); }
+
+    static constexpr size_t EVENT_COUNT = static_cast<size_t>(EventType::COUNT);
+    static_assert(EVENT_COUNT <= 32, "Scheduled event mask is too small");
+
+    // One slot per event type. A slot is only valid if its bit is set in scheduledEvents_.
+    std::array<Event, EVENT_COUNT> events_;
+    std::array<std::function<void(int)>, EVENT_COUNT> registeredEvents_;
+    uint32_t scheduledEvents_;
+
+    // Cached next event. If no events are scheduled, nextEventCycle_ is MAX_U64.
+    EventType nextEvent_;
+    uint64_t nextEventCycle_;
+
     uint64_t totalCycles_;
     bool irqPending_;
-};
 
-extern EventScheduler Scheduler;
+    // Telemetry. Not cleared by Reset so that counts carry across loading a new ROM.
+    std::array<uint64_t, EVENT_COUNT> eventCounts_;
+    std::array<uint64_t, EVENT_COUNT> eventHostTime_;
+    uint64_t totalEventHostTime_;
+
+    // Profiling
+    std::array<EventLateness, EVENT_COUNT> eventLateness_;
+};
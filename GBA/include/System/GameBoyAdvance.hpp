@@ -2,24 +2,42 @@
 
 #include <CPU/ARM7TDMI.hpp>
 #include <array>
+#include <chrono>
 #include <cstdint>
 #include <filesystem>
 #include <functional>
 #include <memory>
 #include <optional>
 #include <string>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 #include <Audio/APU.hpp>
 #include <Cartridge/GamePak.hpp>
+#include <Config.hpp>
 #include <DMA/DmaChannel.hpp>
 #include <DMA/DmaManager.hpp>
 #include <Gamepad/GamepadManager.hpp>
 #include <Graphics/PPU.hpp>
+#include <Logging/Logging.hpp>
+#include <PixelFormat.hpp>
+#include <Profiling/Profiler.hpp>
+#include <System/AvCapture.hpp>
+#include <System/EventScheduler.hpp>
+#include <System/HookRegistry.hpp>
+#include <System/InputMovie.hpp>
+#include <System/MemoryMap.hpp>
+#include <System/PageTable.hpp>
+#include <System/SystemControl.hpp>
+#include <System/TelemetryRecorder.hpp>
 #include <Timers/TimerManager.hpp>
 #include <Utilities/MemoryUtilities.hpp>
+#include <Utilities/RewindBuffer.hpp>
 
 namespace fs = std::filesystem;
 
+class StateSerializer;
+
 class GameBoyAdvance
 {
 public:
@@ -35,16 +53,65 @@ public:
 
     ~GameBoyAdvance();
 
+    /// @brief Create a new GBA in the same state as this one, which then runs independently of it. The clone shares the BIOS and
+    ///        ROM data instead of loading them again, and its backup media isn't tied to the save file, so nothing it does is
+    ///        ever written to disk. CPU, BIOS call, and audio settings are copied, and resampling continues where this GBA is so
+    ///        that both produce the same audio. Pixel format, callbacks, hooks, rewind, run-ahead, and input movies start out at
+    ///        their defaults, and the clone renders on the thread that runs it.
+    /// @return New GBA.
+    std::unique_ptr<GameBoyAdvance> Clone();
+
     /// @brief Reset the GBA and all its components to its power-up state.
     void Reset();
 
+    /// @brief Choose whether a GBA with a GamePak loaded skips the BIOS intro when it's reset.
+    /// @param enabled Whether to start at the GamePak's entry point with the state the BIOS would have left behind.
+    void SetDirectBoot(bool enabled) { directBoot_ = enabled; }
+
+    /// @brief Choose how many frames to run ahead of each frame before showing it.
+    /// @param frames Number of frames to run ahead, or 0 to not run ahead.
+    void SetRunAhead(int frames);
+
     /// @brief Run the emulator until the internal audio buffer is full.
     void FillAudioBuffer();
 
-    /// @brief Fill an external audio buffer with the requested number of samples.
+    /// @brief Run the emulator for a number of frames as fast as possible, regardless of how much audio has been consumed.
+    /// @param frames Number of frames to run.
+    /// @param audio Buffer to append every sample produced along the way to, or nullptr to not produce any audio.
+    void RunFrames(int frames, std::vector<float>* audio);
+
+    /// @brief Run the emulator for a number of frames as fast as possible, capturing audio straight into caller owned memory.
+    /// @param frames Number of frames to run.
+    /// @param audio Buffer to write samples produced along the way to. Samples that don't fit are dropped.
+    /// @param capacity Number of floats that fit in the audio buffer.
+    /// @return Number of floats written to the audio buffer.
+    size_t RunFrames(int frames, float* audio, size_t capacity);
+
+    /// @brief Set the rate that audio samples are produced at.
+    /// @param sampleRate Output samples per second.
+    void SetAudioSampleRate(int sampleRate) { apu_.SetSampleRate(sampleRate); }
+
+    /// @brief Set how much audio to keep buffered.
+    /// @param milliseconds Target latency.
+    void SetAudioLatency(int milliseconds) { apu_.SetTargetLatency(milliseconds); }
+
+    /// @brief Block until there's room for more audio, WakeAudioWaiter is called, or the timeout expires. If nothing is loaded,
+    ///        only WakeAudioWaiter or the timeout end the wait, since FillAudioBuffer would have nothing to refill the buffer with.
+    /// @param timeout Longest time to block for.
+    /// @return False if the timeout expired first.
+    bool WaitForAudioSpace(std::chrono::milliseconds timeout)
+    {
+        return apu_.WaitForBufferSpace(timeout, !biosLoaded_ && !gamePakLoaded_);
+    }
+
+    /// @brief Make a thread blocked in WaitForAudioSpace return immediately.
+    void WakeAudioWaiter() { apu_.WakeProducer(); }
+
+    /// @brief Fill an external audio buffer with the requested number of samples, padding with silence if not enough are buffered.
     /// @param buffer Buffer to load internal audio buffer's samples into.
     /// @param cnt Number of samples to load into external buffer.
-    void DrainAudioBuffer(float* buffer, size_t cnt) { apu_.DrainBuffer(buffer, cnt); }
+    /// @return Number of samples that came from the internal buffer.
+    size_t DrainAudioBuffer(float* buffer, size_t cnt);
 
     /// @brief Check how many audio samples are currently saved in the internal buffer. One sample is a single left or right sample.
     /// @return Number of samples saved in internal buffer.
@@ -55,47 +122,368 @@ public:
     /// @return Whether the GamePak was valid and successfully loaded.
     bool LoadGamePak(fs::path romPath);
 
-    /// @brief Update the KEYINPUT register based on current buttons being pressed.
+    /// @brief Update the KEYINPUT register based on current buttons being pressed. Safe to call from any thread. Applied at the
+    ///        next KEYINPUT read or scanline, deferred to the next VBlank while recording a movie, and ignored while playing one.
     /// @param gamepad Current gamepad status.
     void UpdateGamepad(Gamepad gamepad);
 
-    /// @brief Access the raw frame buffer data.
-    /// @return Raw pointer to frame buffer.
-    uint8_t* GetRawFrameBuffer() { return ppu_.GetRawFrameBuffer(); }
+    /// @brief Reset the GBA and start recording an input movie.
+    void StartMovieRecording();
+
+    /// @brief Reset the GBA and start playing an input movie.
+    /// @param data Pointer to movie.
+    /// @param size Size of movie in bytes.
+    /// @return Whether the movie was valid and recorded on the loaded ROM.
+    bool StartMoviePlayback(uint8_t const* data, size_t size);
+
+    /// @brief Stop recording or playing an input movie.
+    /// @param movie If recording, filled with the recorded movie. Otherwise cleared.
+    void StopMovie(std::vector<uint8_t>& movie) { movie_.Stop(movie); }
+
+    /// @brief Check what the input movie is doing.
+    /// @return Current movie mode.
+    MovieMode GetMovieMode() const { return movie_.Mode(); }
+
+    /// @brief Take ownership of the most recently completed frame, releasing the previously acquired one.
+    /// @return Latest frame. Its pixel data is valid until the next call.
+    Graphics::CompletedFrame AcquireFrame() { return ppu_.AcquireFrame(); }
+
+    /// @brief Choose the pixel format of the frame buffer.
+    /// @param format Output pixel format.
+    /// @param colorCorrection Whether to approximate the colors of the GBA's LCD.
+    void SetOutputFormat(PixelFormat format, bool colorCorrection) { ppu_.SetOutputFormat(format, colorCorrection); }
+
+    /// @brief Choose caller owned memory to draw frames straight into instead of the internal frame buffer.
+    /// @param target 240x160 pixels in the output format, or nullptr to draw into the internal frame buffer.
+    void SetFrameTarget(uint8_t* target) { ppu_.SetFrameTarget(target); }
+
+    /// @brief Choose how many frames to skip drawing after each drawn frame.
+    /// @param frames Number of frames to skip between drawn frames.
+    void SetFrameSkip(int frames) { ppu_.SetFrameSkip(frames); }
+
+    /// @brief Choose a function to call each time a frame completes.
+    /// @param callback Function to call with the sequence number of each completed frame.
+    void SetFrameCallback(std::function<void(uint64_t)> callback) { ppu_.SetFrameCallback(std::move(callback)); }
+
+    /// @brief Start recording completed frames and resampled audio to disk, stopping any capture that's already running first.
+    /// @param path Path of video file to create.
+    /// @param format How to write the video.
+    /// @param ffmpegOptions Output options passed to ffmpeg when encoding the video with CaptureFormat::FFmpeg.
+    void StartCapture(fs::path path, CaptureFormat format, std::string const& ffmpegOptions);
+
+    /// @brief Stop recording and finish the output files.
+    /// @return Final progress of the capture, or all zeros if none was running.
+    CaptureStats StopCapture();
 
-    /// @brief Get the number of times the PPU has hit VBlank since the last check.
-    /// @return Number of times PPU has entered VBlank.
-    int GetAndResetFrameCounter() { return ppu_.GetAndResetFrameCounter(); }
+    /// @brief Check how the running capture is doing. Safe to call from any thread.
+    /// @return Progress of the capture, or all zeros if none is running.
+    CaptureStats GetCaptureStats() const { return capture_ ? capture_->Stats() : CaptureStats{}; }
 
     /// @brief Get the title of the currently loaded ROM.
     /// @return Title of ROM.
     std::string RomTitle() const;
 
+    /// @brief Toggle logging of system events like DMAs and timer overflows.
+    void ToggleSystemLogging() { log_.ToggleSystemLogging(); }
+
+    /// @brief Toggle logging of each CPU instruction and registers state.
+    void ToggleCpuLogging() { log_.ToggleCpuLogging(); }
+
+    /// @brief Toggle streaming of logged instructions and events to a trace file.
+    void ToggleTraceStreaming() { log_.ToggleTraceStreaming(); }
+
     /// @brief Dump log buffer to file.
-    void DumpLogs() const;
+    void DumpLogs();
+
+    /// @brief Enable or disable composing scanlines on a separate render thread.
+    /// @param enabled Whether the PPU should render on its own thread.
+    void SetRenderThreadEnabled(bool enabled) { ppu_.SetRenderThreadEnabled(enabled); }
+
+    /// @brief Enable or disable running frequently called BIOS functions as native code.
+    /// @param enabled Whether the CPU should run supported BIOS functions natively.
+    void SetBiosHle(bool enabled) { cpu_.SetBiosHle(enabled); }
+
+    /// @brief Save the state of the GBA and every component.
+    /// @param state Buffer to save state into. Its previous contents are replaced, but its capacity is reused.
+    void SaveState(std::vector<uint8_t>& state);
+
+    /// @brief Restore a state created by SaveState. The state must come from the same build and ROM, which is checked before
+    ///        anything is changed. If the state turns out to be corrupt partway through loading, the GBA is reset.
+    /// @param data Pointer to save state.
+    /// @param size Size of save state in bytes.
+    /// @return Whether the state was loaded.
+    bool LoadState(uint8_t const* data, size_t size);
+
+    /// @brief Start or stop capturing states to rewind to. Any previous history is dropped.
+    /// @param enabled Whether to capture states.
+    /// @param framesPerCapture Number of frames between captured states.
+    /// @param bufferSize Max number of bytes of history to keep.
+    void SetRewind(bool enabled, int framesPerCapture, size_t bufferSize);
+
+    /// @brief Load the most recently captured state and drop it from the history, so that each call steps further back. The
+    ///        oldest state is kept once everything newer has been dropped.
+    /// @return Whether there was a state to rewind to.
+    bool Rewind();
+
+    /// @brief Get the telemetry of the most recently completed frame. Safe to call from any thread.
+    /// @return Latest telemetry.
+    Telemetry GetTelemetry() const { return telemetry_.Read(); }
+
+    /// @brief Get what the profiler has gathered since it was last reset.
+    /// @return Profiling results.
+    ProfileReport GetProfile() const { return profiler_.Report(); }
+
+    /// @brief Clear everything the profiler has gathered.
+    void ResetProfile() { profiler_.Reset(); }
+
+    /// @brief Write what the profiler has gathered in collapsed stack format.
+    /// @param path Path of file to create.
+    void DumpProfile(fs::path path) const { profiler_.WriteFlameGraph(path); }
+
+    /// @brief Watch a range of memory, taking any pages it covers out of the page table.
+    /// @param addr First address to watch.
+    /// @param length Number of bytes to watch.
+    /// @param type Which accesses trigger the watch.
+    /// @param hook Function to call when the watch is triggered.
+    /// @return ID of new watch.
+    HookId AddMemoryWatch(uint32_t addr, uint32_t length, WatchType type, MemoryHook hook);
+
+    /// @brief Hook an instruction, dropping any cached blocks so that its page is interpreted from now on.
+    /// @param pc Address of instruction to hook.
+    /// @param hook Function to call.
+    /// @return ID of new hook.
+    HookId AddPcHook(uint32_t pc, PcHook hook);
+
+    /// @brief Remove a memory watch or PC hook.
+    /// @param id ID returned when the hook was added.
+    /// @return Whether a hook with that ID existed.
+    bool RemoveHook(HookId id);
+
+    /// @brief Check whether the last run returned early because a hook asked to stop.
+    /// @return True if a hook stopped emulation.
+    bool HookStopped() const { return hookStop_; }
 
 private:
+    using BiosImage = std::array<uint8_t, 16 * KiB>;
+
+    /// @brief Initialize the Game Boy Advance with a BIOS that's already in memory.
+    /// @param bios BIOS to run, or nullptr if none could be loaded. Never modified, so it can be shared by any number of GBAs.
+    explicit GameBoyAdvance(std::shared_ptr<BiosImage const> bios);
+
+    /// @brief Publish how much memory is owned by this GBA and how much is shared with its clones.
+    void UpdateMemoryUsage();
+
     /// @brief Run the emulator until the APU has been sampled a set number of times.
     /// @param samples How many times the APU should be sampled before returning.
     void Run(size_t samples);
 
-    /// @brief Top level function to read an address. Determine which memory region to route the read to. Force aligns address.
+    /// @brief Run whichever of the CPU or DMA is active, or skip ahead while halted, until the next scheduled event, then handle
+    ///        any events that are due.
+    void RunUntilNextEvent();
+
+    /// @brief Run until a number of frames have entered VBlank, with audio already routed wherever the caller wants it. Routes
+    ///        audio back to the internal buffer once done.
+    /// @param frames Number of frames to run.
+    void RunFramesWithOutput(int frames);
+
+    /// @brief Top level function to read an address. Pages mapped in the page table are read directly, everything else is routed
+    ///        to the appropriate memory region. Force aligns address.
+    /// @tparam alignment Number of bytes to read.
+    /// @param addr Address to read from.
+    /// @return Value at specified address and number of cycles taken to read.
+    template <AccessSize alignment>
+    std::pair<uint32_t, int> ReadMemory(uint32_t addr);
+
+    /// @brief Read an address with an access size only known at runtime.
     /// @param addr Address to read from.
     /// @param alignment Number of bytes to read.
     /// @return Value at specified address and number of cycles taken to read.
     std::pair<uint32_t, int> ReadMemory(uint32_t addr, AccessSize alignment);
 
-    /// @brief Top level function to write to an address. Determine which memory region to route the write to. Force aligns address.
+    /// @brief Top level function to write to an address. Pages mapped in the page table are written directly, everything else is
+    ///        routed to the appropriate memory region. Force aligns address.
+    /// @tparam alignment Number of bytes to write.
+    /// @param addr Address to write to.
+    /// @param value Value to write to specified address.
+    /// @return Number of cycles taken to write.
+    template <AccessSize alignment>
+    int WriteMemory(uint32_t addr, uint32_t value);
+
+    /// @brief Write to an address with an access size only known at runtime.
     /// @param addr Address to write to.
     /// @param value Value to write to specified address.
     /// @param alignment Number of bytes to write.
     /// @return Number of cycles taken to write.
     int WriteMemory(uint32_t addr, uint32_t value, AccessSize alignment);
 
+    /// @brief Read from a page that's directly mapped to host memory.
+    /// @tparam alignment Number of bytes to read.
+    /// @param entry Page table entry of the page being read.
+    /// @param addr Aligned address to read from.
+    /// @return Value at specified address and number of cycles taken to read.
+    template <AccessSize alignment>
+    std::pair<uint32_t, int> ReadMappedMemory(PageTableEntry const& entry, uint32_t addr);
+
+    /// @brief Write to a page that's directly mapped to host memory.
+    /// @tparam alignment Number of bytes to write.
+    /// @param entry Page table entry of the page being written.
+    /// @param addr Aligned address to write to.
+    /// @param value Value to write to specified address.
+    /// @return Number of cycles taken to write.
+    template <AccessSize alignment>
+    int WriteMappedMemory(PageTableEntry const& entry, uint32_t addr, uint32_t value);
+
+    /// @brief Handle a read whose page isn't directly mapped, checking memory watches if there are any.
+    /// @param addr Aligned address to read from.
+    /// @param alignment Number of bytes to read.
+    /// @return Value at specified address and number of cycles taken to read.
+    std::pair<uint32_t, int> ReadUnmappedMemory(uint32_t addr, AccessSize alignment);
+
+    /// @brief Handle a write whose page isn't directly mapped, checking memory watches if there are any.
+    /// @param addr Aligned address to write to.
+    /// @param value Value to write to specified address.
+    /// @param alignment Number of bytes to write.
+    /// @return Number of cycles taken to write.
+    int WriteUnmappedMemory(uint32_t addr, uint32_t value, AccessSize alignment);
+
+    /// @brief Determine which memory region to route a read to.
+    /// @param addr Aligned address to read from.
+    /// @param alignment Number of bytes to read.
+    /// @return Value at specified address and number of cycles taken to read.
+    std::pair<uint32_t, int> ReadMemoryRegion(uint32_t addr, AccessSize alignment);
+
+    /// @brief Determine which memory region to route a write to.
+    /// @param addr Aligned address to write to.
+    /// @param value Value to write to specified address.
+    /// @param alignment Number of bytes to write.
+    /// @return Number of cycles taken to write.
+    int WriteMemoryRegion(uint32_t addr, uint32_t value, AccessSize alignment);
+
+    /// @brief Read from memory while memory watches exist. Pages taken out of the page table for a watch are accessed the same
+    ///        way they would have been through the page table.
+    /// @param addr Aligned address to read from.
+    /// @param alignment Number of bytes to read.
+    /// @return Value at specified address and number of cycles taken to read.
+    std::pair<uint32_t, int> ReadWatchedMemory(uint32_t addr, AccessSize alignment);
+
+    /// @brief Write to memory while memory watches exist. Pages taken out of the page table for a watch are accessed the same
+    ///        way they would have been through the page table.
+    /// @param addr Aligned address to write to.
+    /// @param value Value to write to specified address.
+    /// @param alignment Number of bytes to write.
+    /// @return Number of cycles taken to write.
+    int WriteWatchedMemory(uint32_t addr, uint32_t value, AccessSize alignment);
+
+    /// @brief Get the page table entry an address would use if no pages were taken out for memory watches.
+    /// @param addr Address to look up. Must be below 0x1000'0000.
+    /// @return Unwatched page table entry.
+    PageTableEntry const& UnwatchedEntry(uint32_t addr) const;
+
+    /// @brief Check the PC hooks on an instruction that's about to execute.
+    /// @param pc Address of instruction.
+    void CheckPcHooks(uint32_t pc);
+
+    /// @brief Get direct access to a run of units in a directly mapped page, as if each unit was read in order.
+    /// @param addr Address of the first unit to read.
+    /// @param units Number of units to read.
+    /// @param alignment HALFWORD or WORD.
+    /// @return Host memory holding the run and number of cycles taken to read it. nullptr if the run isn't within a single
+    ///         directly mapped block of memory.
+    std::pair<uint8_t*, int> ReadMemoryBlock(uint32_t addr, uint32_t units, AccessSize alignment);
+
+    /// @brief Write a run of units to a directly mapped block of memory in one step, as if each unit was written in order.
+    /// @param addr Address of the first unit to write.
+    /// @param values Units to write.
+    /// @param units Number of units to write.
+    /// @param alignment HALFWORD or WORD.
+    /// @return Whether the run was written and number of cycles taken to write it. Nothing is written if the run isn't within a
+    ///         single directly mapped block of memory.
+    std::pair<bool, int> WriteMemoryBlock(uint32_t addr, uint8_t const* values, uint32_t units, AccessSize alignment);
+
+    /// @brief Read a run of consecutive words from a directly mapped block of memory in one step, as if each word was read in
+    ///        order. Used by block data transfers to load several registers at once.
+    /// @param addr Address of the first word to read.
+    /// @param values Where to store the words that are read.
+    /// @param maxCount Max number of words to read.
+    /// @param maxCycles Stop after the word that brings the cycles taken to at least this many.
+    /// @return Number of words read and number of cycles taken. No words are read if the run isn't within a single directly
+    ///         mapped block of memory.
+    std::pair<uint32_t, int> ReadMemoryBurst(uint32_t addr, uint32_t* values, uint32_t maxCount, int maxCycles);
+
+    /// @brief Write a run of consecutive words to a directly mapped block of memory in one step, as if each word was written in
+    ///        order. Used by block data transfers to store several registers at once.
+    /// @param addr Address of the first word to write.
+    /// @param values Words to write.
+    /// @param maxCount Max number of words to write.
+    /// @param maxCycles Stop after the word that brings the cycles taken to at least this many.
+    /// @return Number of words written and number of cycles taken. No words are written if the run isn't within a single
+    ///         directly mapped block of memory.
+    std::pair<uint32_t, int> WriteMemoryBurst(uint32_t addr, uint32_t const* values, uint32_t maxCount, int maxCycles);
+
+    /// @brief Copy a run of units between two directly mapped pages in one step. Used by DMA transfers between plain memory.
+    /// @param srcAddr Address of the first unit to read.
+    /// @param destAddr Address of the first unit to write.
+    /// @param maxUnits Max number of units to copy.
+    /// @param alignment HALFWORD or WORD.
+    /// @param fixedSrc Whether every unit is read from srcAddr instead of from incrementing addresses.
+    /// @param maxCycles Stop after the unit that brings the cycles taken to at least this many.
+    /// @return Number of units copied and number of cycles taken. No units are copied if either address isn't directly mapped or
+    ///         the source and destination overlap.
+    std::pair<uint32_t, int> CopyMemory(uint32_t srcAddr,
+                                        uint32_t destAddr,
+                                        uint32_t maxUnits,
+                                        AccessSize alignment,
+                                        bool fixedSrc,
+                                        int maxCycles);
+
+    /// @brief Map work RAM, palette RAM, VRAM, and OAM into the page table. All other pages are set to use the slow path.
+    void BuildPageTable();
+
+    /// @brief Fill in the I/O register table from the registers each component owns.
+    void BuildIoTable();
+
+    /// @brief Map the currently loaded Game Pak ROM into the page table. Pages that overlap backup media are left on the slow
+    ///        path, as are all ROM pages if no Game Pak is loaded.
+    void MapGamePakPages();
+
+    /// @brief Set the access timing of on-board work RAM pages from the internal memory control register.
+    void UpdateWramTiming();
+
+    /// @brief Put every page taken out of the page table for a memory watch back in.
+    void RestoreWatchedPages();
+
+    /// @brief Take every directly mapped page that a memory watch covers out of the page table, so that accesses to it go through
+    ///        the watch checks. Reads and writes are taken out separately.
+    void RemoveWatchedPages();
+
+    /// @brief Map a range of pages to a block of host memory.
+    /// @param addrMin First address of range of pages to map.
+    /// @param addrMax Last address of range of pages to map.
+    /// @param regionAddr Canonical address of the first byte of the memory being mapped.
+    /// @param memory Host memory to map.
+    /// @param size Size of host memory in bytes. Pages are mirrored every size bytes.
+    /// @param type Page type.
+    /// @param writable Whether non-byte writes can be performed directly.
+    /// @param byteWritable Whether byte writes can be performed directly.
+    /// @param cycles Access cycles for byte/halfword and word accesses.
+    void MapPages(uint32_t addrMin,
+                  uint32_t addrMax,
+                  uint32_t regionAddr,
+                  uint8_t* memory,
+                  uint32_t size,
+                  PageType type,
+                  bool writable,
+                  bool byteWritable,
+                  std::array<uint8_t, 2> cycles);
+
     /// @brief Load GBA BIOS into memory.
     /// @param biosPath Path to GBA BIOS.
-    /// @return Whether valid BIOS was loaded.
-    bool LoadBIOS(fs::path biosPath);
+    /// @return BIOS, or nullptr if a valid BIOS couldn't be loaded.
+    static std::shared_ptr<BiosImage const> LoadBIOS(fs::path biosPath);
+
+    /// @brief Set everything the BIOS intro changes to the values it leaves behind, so that a freshly reset GBA starts executing
+    ///        the GamePak immediately.
+    void SkipBIOS();
 
     /// @brief Callback function upon entering HBlank. Updates PPU and checks for HBlank DMAs.
     /// @param extraCycles Number of cycles that passed since this event was supposed to execute.
@@ -118,6 +506,32 @@ private:
     /// @param extraCycles Number of cycles that passed since the overflow happened.
     void TimerOverflow(int timer, int extraCycles);
 
+    /// @brief Tell the timers which of them DMA audio currently depends on.
+    void UpdateFifoTimers();
+
+    /// @brief Save the current state into the rewind history.
+    void CaptureRewindState();
+
+    /// @brief Save state, run ahead with the current input while muted, and load the saved state again. Only the last frame run
+    ///        ahead is drawn, and is shown in place of the next frame.
+    void RunAhead();
+
+    /// @brief Start the next frame of the input movie, updating KEYINPUT if its input changes.
+    void ApplyMovieInput();
+
+    /// @brief Apply the host's latest buttons to KEYINPUT, unless a movie is in control of it.
+    void PollHostInput()
+    {
+        if (movie_.Mode() == MovieMode::Idle)
+        {
+            gamepad_.PollInput();
+        }
+    }
+
+    /// @brief Save or load every component and the GBA's own memory.
+    /// @param state Serializer to save state to or load state from.
+    void Serialize(StateSerializer& state);
+
     // Area specific R/W handling
 
     //                Bus   Read      Write     Cycles
@@ -144,6 +558,17 @@ private:
     // State
     bool const biosLoaded_;
     bool gamePakLoaded_;
+    bool directBoot_;
+
+    // Shared by every component, so these must be constructed first
+    EventScheduler scheduler_;
+    Logging::LogManager log_;
+    SystemControl systemControl_;
+    Profiling::Profiler profiler_;
+    TelemetryRecorder telemetry_;
+
+    // A/V capture. Components push to it, so it must outlive them.
+    std::unique_ptr<AvCapture> capture_;
 
     // Components
     Audio::APU apu_;
@@ -154,18 +579,194 @@ private:
     TimerManager timerMgr_;
     std::unique_ptr<Cartridge::GamePak> gamePak_;
 
-    // Memory
-    std::array<uint8_t,  16 * KiB> BIOS_;
+    // Memory. BIOS is shared with clones.
+    std::shared_ptr<BiosImage const> BIOS_;
     std::array<uint8_t, 256 * KiB> onBoardWRAM_;
     std::array<uint8_t,  32 * KiB> onChipWRAM_;
 
     std::array<uint8_t, 0x804> placeholderIoRegisters_;
 
+    /// @brief Component that handles accesses to an I/O register.
+    enum class IoRegion : uint8_t
+    {
+        OPEN_BUS,
+        LCD,
+        SOUND,
+        DMA,
+        TIMER,
+        SERIAL,
+        KEYPAD,
+        SYSTEM_CONTROL
+    };
+
+    /// @brief Entry in the I/O register table, one per halfword register.
+    struct IoRegisterEntry
+    {
+        /// @brief Memory the register is read from when reads have no side effects, or nullptr if reads go to its component.
+        uint8_t const* readMemory_;
+
+        /// @brief Component that handles writes, and reads that can't be served from memory.
+        IoRegion region_;
+    };
+
+    // I/O register table, indexed by halfword, so that accesses go straight to the component that owns each register
+    std::array<IoRegisterEntry, (IO_REG_ADDR_MAX - IO_REG_ADDR_MIN + 1) / 2> ioTable_;
+
+    // Page table for directly accessing host memory
+    PageTable pageTable_;
+
     // Open bus
     uint32_t lastBiosFetch_;
     uint32_t lastReadValue_;
 
-    // DMA friends
+    // Rewind. Captures are requested on VBlank and taken between instructions by Run.
+    std::unique_ptr<RewindBuffer> rewindBuffer_;
+    std::vector<uint8_t> rewindCapture_;
+    int framesPerRewindCapture_;
+    int framesUntilRewindCapture_;
+    bool rewindCapturePending_;
+
+    // Run-ahead. Requested on VBlank and run between instructions by Run.
+    std::vector<uint8_t> runAheadState_;
+    int runAheadFrames_;
+    bool runAheadPending_;
+    bool runningAhead_;
+
+    // State copied into clones, kept to reuse its capacity
+    std::vector<uint8_t> cloneState_;
+
+    // Number of frames that have entered VBlank, used by RunFrames
+    uint64_t framesCompleted_;
+
+    // Input movie. Input changes are applied on VBlank while recording or playing.
+    InputMovie movie_;
+
+    // Instrumentation. Original entries of pages taken out of the page table for memory watches are kept so they can be accessed
+    // the same way on the slow path and restored once the watches are removed.
+    HookRegistry hooks_;
+    std::unordered_map<uint32_t, PageTableEntry> watchedPages_;
+    bool hookStop_;
+
+    // Memory bus friends
+    friend class CPU::ARM7TDMI;
     friend class DmaChannel;
     friend class DmaManager;
 };
+
+template <AccessSize alignment>
+inline std::pair<uint32_t, int> GameBoyAdvance::ReadMemory(uint32_t addr)
+{
+    addr = AlignAddress<alignment>(addr);
+
+    if (addr < 0x1000'0000)
+    {
+        PageTableEntry const& entry = pageTable_[addr >> PAGE_SHIFT];
+
+        if (entry.readMemory_ != nullptr)
+        {
+            return ReadMappedMemory<alignment>(entry, addr);
+        }
+    }
+
+    return ReadUnmappedMemory(addr, alignment);
+}
+
+inline std::pair<uint32_t, int> GameBoyAdvance::ReadMemory(uint32_t addr, AccessSize alignment)
+{
+    return DispatchAccessSize(alignment, [&](auto size) { return ReadMemory<size>(addr); });
+}
+
+template <AccessSize alignment>
+inline std::pair<uint32_t, int> GameBoyAdvance::ReadMappedMemory(PageTableEntry const& entry, uint32_t addr)
+{
+    uint32_t value = ReadPointer<alignment>(entry.readMemory_ + (addr & entry.mask_));
+    int cycles = (entry.type_ == PageType::ROM) ? gamePak_->RomAccessCycles(addr, alignment) :
+                                                  entry.cycles_[alignment == AccessSize::WORD];
+    lastReadValue_ = value;
+
+    if constexpr (PROFILER_ENABLED)
+    {
+        profiler_.RecordAccess(addr, cycles);
+    }
+
+    return {value, cycles};
+}
+
+template <AccessSize alignment>
+inline int GameBoyAdvance::WriteMemory(uint32_t addr, uint32_t value)
+{
+    addr = AlignAddress<alignment>(addr);
+
+    if (addr < 0x1000'0000)
+    {
+        PageTableEntry const& entry = pageTable_[addr >> PAGE_SHIFT];
+
+        if ((entry.writeMemory_ != nullptr) && ((alignment != AccessSize::BYTE) || entry.byteWritable_))
+        {
+            return WriteMappedMemory<alignment>(entry, addr, value);
+        }
+    }
+
+    return WriteUnmappedMemory(addr, value, alignment);
+}
+
+inline int GameBoyAdvance::WriteMemory(uint32_t addr, uint32_t value, AccessSize alignment)
+{
+    return DispatchAccessSize(alignment, [&](auto size) { return WriteMemory<size>(addr, value); });
+}
+
+template <AccessSize alignment>
+inline int GameBoyAdvance::WriteMappedMemory(PageTableEntry const& entry, uint32_t addr, uint32_t value)
+{
+    uint32_t offset = addr & entry.mask_;
+    uint8_t* bytePtr = entry.writeMemory_ + offset;
+    int cycles = entry.cycles_[alignment == AccessSize::WORD];
+
+    if constexpr (PROFILER_ENABLED)
+    {
+        profiler_.RecordAccess(addr, cycles);
+    }
+
+    if (entry.type_ == PageType::VIDEO)
+    {
+        if (WritePointerAndCompare<alignment>(bytePtr, value))
+        {
+            ppu_.VideoMemoryWritten(entry.baseAddr_ + offset, alignment);
+        }
+
+        return cycles;
+    }
+
+    WritePointer<alignment>(bytePtr, value);
+
+    if (entry.type_ == PageType::WRAM)
+    {
+        cpu_.InvalidateBlocks(entry.baseAddr_ + offset, alignment);
+    }
+
+    return cycles;
+}
+
+template <AccessSize alignment>
+inline std::pair<uint32_t, int> CPU::ARM7TDMI::ReadMemory(uint32_t addr)
+{
+    return gba_.ReadMemory<alignment>(addr);
+}
+
+inline std::pair<uint32_t, int> CPU::ARM7TDMI::ReadMemory(uint32_t addr, AccessSize alignment)
+{
+    return gba_.ReadMemory(addr, alignment);
+}
+
+template <AccessSize alignment>
+inline int CPU::ARM7TDMI::WriteMemory(uint32_t addr, uint32_t value)
+{
+    memoryWritten_ = true;
+    return gba_.WriteMemory<alignment>(addr, value);
+}
+
+inline int CPU::ARM7TDMI::WriteMemory(uint32_t addr, uint32_t value, AccessSize alignment)
+{
+    memoryWritten_ = true;
+    return gba_.WriteMemory(addr, value, alignment);
+}
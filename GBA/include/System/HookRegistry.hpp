@@ -0,0 +1,97 @@
+#pragma once
+
+#include <AdvancedBoy.hpp>
+#include <cstdint>
+#include <vector>
+#include <System/PageTable.hpp>
+#include <Utilities/MemoryUtilities.hpp>
+
+/// @brief Memory watches and PC hooks attached to a GBA. Nothing here is consulted while no hooks are registered. Once some are,
+///        the GBA takes watched pages out of its page table so that only accesses to those pages reach CheckMemory, and the CPU
+///        only checks PC hooks for instructions on pages that have one.
+class HookRegistry
+{
+public:
+    /// @brief Initialize an empty registry.
+    HookRegistry();
+
+    HookRegistry(HookRegistry const&) = delete;
+    HookRegistry& operator=(HookRegistry const&) = delete;
+
+    /// @brief Add a memory watch.
+    /// @param addr Canonical address of first watched byte.
+    /// @param length Number of watched bytes.
+    /// @param type Which accesses trigger the watch.
+    /// @param hook Function to call for each access that overlaps the watched bytes.
+    /// @return ID of new watch.
+    HookId AddMemoryWatch(uint32_t addr, uint32_t length, WatchType type, MemoryHook hook);
+
+    /// @brief Add a PC hook.
+    /// @param pc Address of instruction to hook.
+    /// @param hook Function to call before each time the instruction executes.
+    /// @return ID of new hook.
+    HookId AddPcHook(uint32_t pc, PcHook hook);
+
+    /// @brief Remove a memory watch or PC hook.
+    /// @param id ID returned when the hook was added.
+    /// @return Whether a hook with that ID existed.
+    bool Remove(HookId id);
+
+    /// @brief Check whether any memory watches are registered.
+    /// @return True if at least one memory watch exists.
+    bool HasMemoryWatches() const { return !memoryWatches_.empty(); }
+
+    /// @brief Check whether any PC hooks are registered.
+    /// @return True if at least one PC hook exists.
+    bool HasPcHooks() const { return !pcHooks_.empty(); }
+
+    /// @brief Check whether any memory watch covers part of a range of canonical addresses.
+    /// @param addrMin First address of range.
+    /// @param addrMax Last address of range.
+    /// @param write Whether to check for watches triggered by writes instead of reads.
+    /// @return True if any watch of that kind overlaps the range.
+    bool Watched(uint32_t addrMin, uint32_t addrMax, bool write) const;
+
+    /// @brief Check whether a PC hook is on the same page as an address.
+    /// @param pc Address of instruction.
+    /// @return True if any PC hook is on the same page.
+    bool PcHookOnPage(uint32_t pc) const { return (pc < 0x1000'0000) && pcHookPages_[pc >> PAGE_SHIFT]; }
+
+    /// @brief Call every memory watch that an access triggers.
+    /// @param addr Canonical address that was accessed.
+    /// @param value Value that was read or written.
+    /// @param alignment Number of bytes accessed.
+    /// @param write Whether the access was a write.
+    /// @return True if any watch asked for emulation to stop.
+    bool CheckMemory(uint32_t addr, uint32_t value, AccessSize alignment, bool write);
+
+    /// @brief Call every PC hook on an instruction that's about to execute.
+    /// @param pc Address of instruction.
+    /// @return True if any hook asked for emulation to stop.
+    bool CheckPc(uint32_t pc);
+
+private:
+    struct MemoryWatch
+    {
+        HookId id_;
+        uint32_t addrMin_;
+        uint32_t addrMax_;
+        WatchType type_;
+        MemoryHook hook_;
+    };
+
+    struct PcHookEntry
+    {
+        HookId id_;
+        uint32_t pc_;
+        PcHook hook_;
+    };
+
+    /// @brief Recalculate which pages have PC hooks on them.
+    void UpdatePcHookPages();
+
+    std::vector<MemoryWatch> memoryWatches_;
+    std::vector<PcHookEntry> pcHooks_;
+    std::vector<bool> pcHookPages_;
+    HookId nextId_;
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <AdvancedBoy.hpp>
+#include <Gamepad.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/// @brief Records and replays the KEYINPUT register one frame at a time. Input only changes at VBlank while a movie is active, so
+///        a movie replays identically no matter when the host happened to sample its buttons.
+///
+///        Movies are stored as a header followed by a stream of changes. Each change is the number of frames since the previous
+///        change as a little endian base 128 varint, followed by the new KEYINPUT value as two little endian bytes. Buttons are
+///        held for many frames at a time, so most changes take three bytes.
+class InputMovie
+{
+public:
+    /// @brief Initialize an idle movie.
+    InputMovie();
+
+    InputMovie(InputMovie const&) = delete;
+    InputMovie& operator=(InputMovie const&) = delete;
+
+    /// @brief Get what the movie is currently doing. Safe to call from any thread.
+    /// @return Current mode.
+    MovieMode Mode() const { return mode_.load(std::memory_order_relaxed); }
+
+    /// @brief Get the number of frames recorded or played so far.
+    /// @return Frames since the movie started.
+    uint64_t Frame() const { return frame_; }
+
+    /// @brief Start recording a new movie, dropping anything previously recorded or loaded.
+    /// @param romSize Size of the loaded ROM in bytes.
+    /// @param romHeaderCrc CRC of the loaded ROM's header.
+    void StartRecording(uint32_t romSize, uint32_t romHeaderCrc);
+
+    /// @brief Start playing a movie.
+    /// @param data Movie created by StopRecording.
+    /// @param size Size of movie in bytes.
+    /// @param romSize Size of the loaded ROM in bytes.
+    /// @param romHeaderCrc CRC of the loaded ROM's header.
+    /// @return Whether the movie was valid and recorded on the same ROM. If not, the movie is left idle.
+    bool StartPlayback(uint8_t const* data, size_t size, uint32_t romSize, uint32_t romHeaderCrc);
+
+    /// @brief Stop recording or playing.
+    /// @param movie If recording, filled with the complete movie. Otherwise cleared.
+    void Stop(std::vector<uint8_t>& movie);
+
+    /// @brief Set the buttons to use at the next VBlank while recording. Safe to call from any thread.
+    /// @param gamepad Current gamepad status.
+    void SetPendingInput(Gamepad gamepad) { pendingInput_.store(gamepad.halfword_, std::memory_order_relaxed); }
+
+    /// @brief Start the next frame of the movie. Called when the movie starts and at every VBlank after. While recording, the
+    ///        pending input is recorded if it changed. While playing, playback stops on its own once every recorded frame has
+    ///        been played.
+    /// @return New KEYINPUT value to use from this frame on, or std::nullopt if it doesn't change.
+    std::optional<Gamepad> NextFrame();
+
+private:
+    /// @brief Read a varint from the stream being played.
+    /// @param index Index to read from. Advanced past the varint.
+    /// @param value Value that was read.
+    /// @return Whether a complete varint was read.
+    bool ReadVarint(size_t& index, uint64_t& value) const;
+
+    /// @brief Read the next change from the stream being played.
+    void ReadChange();
+
+    /// @brief Append a change to the stream being recorded.
+    /// @param frame Frame the change happens on.
+    /// @param keyinput New KEYINPUT value.
+    void WriteChange(uint64_t frame, uint16_t keyinput);
+
+    std::atomic<MovieMode> mode_;
+    uint64_t frame_;
+    std::atomic_uint16_t pendingInput_;
+
+    // Movie being recorded or played, including its header
+    std::vector<uint8_t> stream_;
+
+    // Recording
+    uint64_t lastChangeFrame_;
+    uint16_t lastInput_;
+
+    // Playback
+    size_t readIndex_;
+    uint64_t nextChangeFrame_;
+    uint16_t nextChangeInput_;
+    bool changePending_;
+    uint64_t length_;  // Number of frames in movie
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <Utilities/MemoryUtilities.hpp>
+
+constexpr uint32_t PAGE_SHIFT = 15;
+constexpr uint32_t PAGE_SIZE = 1 << PAGE_SHIFT;
+constexpr size_t PAGE_TABLE_SIZE = 0x1000'0000 >> PAGE_SHIFT;
+
+/// @brief How accesses to a page are timed and what side effects they have.
+enum class PageType : uint8_t
+{
+    SLOW,  // Routed through region specific handlers
+    RAM,  // Fixed access timing
+    WRAM,  // Fixed access timing, writes invalidate cached CPU blocks
+    VIDEO,  // Fixed access timing, writes that change memory mark the PPU output as stale
+    ROM  // Game Pak ROM, timing determined by wait state control and prefetch buffer
+};
+
+/// @brief Entry in the memory page table. Maps a page of the GBA address space directly to host memory so that accesses to
+///        plain memory skip the per-region handlers. Mirrors smaller than a page are handled by the address mask.
+struct PageTableEntry
+{
+    /// @brief Host memory backing the start of this page, or nullptr if reads must use the region specific handler.
+    uint8_t* readMemory_;
+
+    /// @brief Host memory backing the start of this page, or nullptr if writes must use the region specific handler.
+    uint8_t* writeMemory_;
+
+    /// @brief Mask applied to an address to get its offset from the host memory pointer.
+    uint32_t mask_;
+
+    /// @brief Address of the first byte of host memory in its canonical (non-mirrored) region.
+    uint32_t baseAddr_;
+
+    /// @brief Timing and side effects of this page.
+    PageType type_;
+
+    /// @brief Whether byte writes can be stored directly. PRAM, VRAM, and OAM have special byte write behavior.
+    bool byteWritable_;
+
+    /// @brief Access cycles for byte/halfword accesses and word accesses. Unused for ROM pages.
+    std::array<uint8_t, 2> cycles_;
+};
+
+typedef std::array<PageTableEntry, PAGE_TABLE_SIZE> PageTable;
@@ -5,6 +5,10 @@
 #include <utility>
 #include <Utilities/MemoryUtilities.hpp>
 
+class EventScheduler;
+class StateSerializer;
+namespace Logging { class LogManager; }
+
 enum class InterruptType : uint16_t
 {
     LCD_VBLANK              = 0x0001,
@@ -36,7 +40,13 @@ class SystemControl
 {
 public:
     /// @brief Initialize system control registers.
-    SystemControl();
+    /// @param scheduler Scheduler whose IRQ line is driven by the interrupt registers.
+    /// @param log Log to record halts and interrupt requests to.
+    SystemControl(EventScheduler& scheduler, Logging::LogManager& log);
+
+    SystemControl() = delete;
+    SystemControl(SystemControl const&) = delete;
+    SystemControl& operator=(SystemControl const&) = delete;
 
     /// @brief Zero out system control related registers.
     void Reset();
@@ -57,6 +67,11 @@ public:
     /// @param alignment Number of bytes to write.
     void WriteReg(uint32_t addr, uint32_t value, AccessSize alignment);
 
+    /// @brief Get the memory backing a register that can be read straight from memory.
+    /// @param addr Address of halfword register.
+    /// @return Pointer to the register's memory, or nullptr if reads must go through ReadReg.
+    uint8_t const* RegisterMemory(uint32_t addr) const;
+
     /// @brief Set an interrupt flag in the IF register.
     /// @param interrupt Which interrupt type to request.
     void RequestInterrupt(InterruptType interrupt);
@@ -66,12 +81,21 @@ public:
     /// @param sequential Whether this access is sequential to the last one.
     /// @param alignment Number of bytes being read/written.
     /// @return Number of additional wait states for the current read/write operation.
-    int WaitStates(WaitState state, bool sequential, AccessSize alignment) const;
+    int WaitStates(WaitState state, bool sequential, AccessSize alignment) const
+    {
+        return waitStateTable_[static_cast<int>(state)][sequential][alignment == AccessSize::WORD];
+    }
+
+    /// @brief Get the access timing of on-board work RAM, which is set by the internal memory control register.
+    /// @return Access cycles for byte/halfword and word accesses.
+    std::array<uint8_t, 2> WramCycles() const;
 
     /// @brief Check if the GamePak prefetcher is enabled.
     /// @return Whether prefetcher is currently enabled.
     bool GamePakPrefetchEnabled() const { return waitcnt_.prefetchBuffer; }
 
+    void Serialize(StateSerializer& state);
+
 private:
     /// @brief If an enabled interrupt is pending and the master interrupt control is enabled, schedule an IRQ.
     void CheckForInterrupt();
@@ -88,6 +112,9 @@ private:
     /// @param alignment Number of bytes to write.
     void WriteInterruptWaitcnt(uint32_t addr, uint32_t value, AccessSize alignment);
 
+    /// @brief Decode WAITCNT into the wait state table. Must be called whenever WAITCNT changes.
+    void UpdateWaitStateTable();
+
     /// @brief Clear acknowledged interrupt flags in IF.
     /// @param acknowledgement Bitmap of interrupts to acknowledge.
     void AcknowledgeInterrupt(uint16_t acknowledgement);
@@ -127,6 +154,10 @@ private:
     };
 
     WAITCNT& waitcnt_;
-};
 
-extern SystemControl SystemController;
+    // Wait states of each WaitState region, indexed by [region][sequential][word access]
+    std::array<std::array<std::array<uint8_t, 2>, 2>, 4> waitStateTable_;
+
+    EventScheduler& scheduler_;
+    Logging::LogManager& log_;
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <AdvancedBoy.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <System/EventScheduler.hpp>
+
+/// @brief Times each part of the emulator on the emulation thread and publishes the totals once per frame. Published telemetry
+///        is guarded by a sequence lock, so readers on other threads never block the emulation thread or each other. A reader
+///        that overlaps a publish just retries, which is rare since publishing only happens once per frame.
+class TelemetryRecorder
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// @brief Initialize the recorder.
+    /// @param scheduler Reference to event scheduler, which times each event that fires.
+    TelemetryRecorder(EventScheduler& scheduler);
+
+    TelemetryRecorder() = delete;
+    TelemetryRecorder(TelemetryRecorder const&) = delete;
+    TelemetryRecorder& operator=(TelemetryRecorder const&) = delete;
+
+    /// @brief Add host time spent running the CPU.
+    /// @param time Host time, including any events that fired partway through an instruction.
+    /// @param eventTime Host time spent in those events.
+    void AddCpuTime(Clock::duration time, uint64_t eventTime) { cpuTime_ += Nanoseconds(time) - eventTime; }
+
+    /// @brief Add host time spent running DMA transfers.
+    /// @param time Host time, including any events that fired partway through a transfer.
+    /// @param eventTime Host time spent in those events.
+    void AddDmaTime(Clock::duration time, uint64_t eventTime) { dmaTime_ += Nanoseconds(time) - eventTime; }
+
+    /// @brief Add host time spent resampling audio outside of events.
+    /// @param time Host time.
+    void AddApuTime(Clock::duration time) { apuTime_ += Nanoseconds(time); }
+
+    /// @brief Get the frame number that was most recently published.
+    /// @return Number of frames completed as of the last publish.
+    uint64_t PublishedFrame() const { return publishedFrame_; }
+
+    /// @brief Publish everything gathered since the last frame completed and start gathering for the next one.
+    /// @param frame Number of frames completed.
+    /// @param totalCycles Total number of emulated cycles elapsed.
+    void FrameCompleted(uint64_t frame, uint64_t totalCycles);
+
+    /// @brief Count a call to drain the audio buffer. Called from the audio thread.
+    /// @param underrun Whether there weren't enough samples to fill the request.
+    void AudioDrained(bool underrun) { if (underrun) { audioUnderruns_.fetch_add(1, std::memory_order_relaxed); } }
+
+    /// @brief Record how much memory the GBA uses. Readers see it immediately rather than once the next frame completes.
+    /// @param instanceBytes Bytes owned by this GBA alone.
+    /// @param sharedBytes Bytes of read-only data that clones share.
+    void SetMemoryUsage(uint64_t instanceBytes, uint64_t sharedBytes)
+    {
+        instanceMemory_.store(instanceBytes, std::memory_order_relaxed);
+        sharedMemory_.store(sharedBytes, std::memory_order_relaxed);
+    }
+
+    /// @brief Get the most recently published telemetry. Safe to call from any thread.
+    /// @return Latest telemetry.
+    Telemetry Read() const;
+
+private:
+    static constexpr size_t TELEMETRY_WORDS = sizeof(Telemetry) / sizeof(uint64_t);
+    static_assert(sizeof(Telemetry) % sizeof(uint64_t) == 0, "Telemetry must be made of 64 bit fields");
+
+    /// @brief Convert a host duration to nanoseconds.
+    /// @param time Host duration.
+    /// @return Number of nanoseconds.
+    static uint64_t Nanoseconds(Clock::duration time)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+    }
+
+    EventScheduler& scheduler_;
+
+    // Emulation thread only. Totals for the frame in progress, and the state of the scheduler and host clock when it started.
+    uint64_t cpuTime_;
+    uint64_t dmaTime_;
+    uint64_t apuTime_;
+    std::array<uint64_t, static_cast<size_t>(EventType::COUNT)> frameStartEventCounts_;
+    std::array<uint64_t, static_cast<size_t>(EventType::COUNT)> frameStartEventHostTime_;
+    uint64_t frameStartCycle_;
+    Clock::time_point frameStartTime_;
+    uint64_t publishedFrame_;
+
+    // Shared with reader threads. The sequence is odd while a publish is in progress.
+    std::atomic_uint64_t sequence_;
+    std::array<std::atomic_uint64_t, TELEMETRY_WORDS> published_;
+    std::atomic_uint64_t audioUnderruns_;
+    std::atomic_uint64_t instanceMemory_;
+    std::atomic_uint64_t sharedMemory_;
+};
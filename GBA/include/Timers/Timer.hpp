@@ -2,10 +2,26 @@
 
 #include <array>
 #include <cstdint>
+#include <utility>
 #include <System/EventScheduler.hpp>
 #include <System/SystemControl.hpp>
 #include <Utilities/MemoryUtilities.hpp>
 
+class StateSerializer;
+
+constexpr int MAX_BATCHED_OVERFLOWS = 16;
+
+// Prescaler selections divide the CPU clock by 1, 64, 256, and 1024
+constexpr std::array<uint8_t, 4> PRESCALER_SHIFTS = {0, 6, 8, 10};
+
+/// @brief How a timer's overflows are delivered.
+enum class OverflowMode
+{
+    NONE,  // Nothing depends on individual overflows. No events are scheduled and the counter is calculated when read.
+    BATCHED,  // Only DMA audio depends on overflows. Overflows between APU samples are handled by a single event.
+    EACH  // An IRQ or cascading timer depends on overflows. Every overflow is handled by its own event.
+};
+
 class Timer
 {
 public:
@@ -13,11 +29,16 @@ public:
     /// @param index Which timer (0-3) this is.
     /// @param overflowEvent Which event should fire when this timer overflows.
     /// @param interruptType What interrupt to request if IRQs are enabled for this timer.
-    Timer(int index, EventType overflowEvent, InterruptType interruptType);
+    /// @param scheduler Scheduler to time the counter with and schedule overflow events on.
+    Timer(int index, EventType overflowEvent, InterruptType interruptType, EventScheduler& scheduler);
 
     /// @brief Reset a timer to its power-up state.
     void Reset();
 
+    /// @brief Save or load the timer's registers and counter. Its overflow event is saved along with the scheduler.
+    /// @param state Serializer to save state to or load state from.
+    void Serialize(StateSerializer& state);
+
     /// @brief Read a memory mapped timer register.
     /// @param addr Address of memory mapped register.
     /// @param alignment Number of bytes to read.
@@ -33,11 +54,15 @@ public:
     /// @brief Reload the internal counter and schedule a timer overflow event for a timer that was just enabled.
     void StartTimer();
 
-    /// @brief Update a non-cascade mode timer that overflowed.
+    /// @brief Update a timer that overflowed and schedule its next overflow event.
     /// @param extraCycles How many cycles have passed since this timer overflowed.
-    /// @return Total number of overflow events that occurred.
+    /// @return Total number of overflows that occurred since the last overflow event.
     int Overflow(int extraCycles);
 
+    /// @brief Set how overflows need to be delivered based on what depends on them.
+    /// @param mode New overflow mode.
+    void SetOverflowMode(OverflowMode mode);
+
     /// @brief If this timer is in cascade mode, handle the previous timer overflowing.
     /// @param incrementCount Number of times to increment internal counter.
     void CascadeModeIncrement(int incrementCount);
@@ -59,14 +84,21 @@ public:
     InterruptType GetInterruptType() const { return interruptType_; }
 
 private:
-    /// @brief Update the internal counter based on how many cycles have passed since this timer started.
-    /// @param divider Clock divider to use for calculating internal counter value.
-    void UpdateInternalCounter(uint16_t divider);
+    /// @brief Get how many times the internal counter of a running non-cascade mode timer has ticked since it was last updated.
+    /// @return Number of ticks.
+    uint64_t ElapsedTicks() const;
+
+    /// @brief Calculate the value of the internal counter after some number of ticks, reloading it on any overflows.
+    /// @param ticks Number of ticks.
+    /// @return New counter value and number of overflows.
+    std::pair<uint16_t, int> AdvanceCounter(uint64_t ticks) const;
 
-    /// @brief Get divider to use for calculating this timer's update frequency.
-    /// @param prescalerSelection Frequency divider from control register.
-    /// @return CPU clock divider.
-    uint16_t GetDivider(uint16_t prescalerSelection) const;
+    /// @brief Bring the internal counter of a running non-cascade mode timer up to date. Overflows are added to the count that
+    ///        the next overflow event will report.
+    void UpdateInternalCounter();
+
+    /// @brief Schedule an event for the next overflow, or for the last overflow before the APU samples it if batching.
+    void ScheduleOverflow();
 
     union TIMCNT
     {
@@ -89,8 +121,17 @@ private:
     uint16_t internalTimer_;
     TIMCNT& timerControl_;
 
+    // Cycle that internalTimer_ was last updated on. While starting up, this is the cycle the timer begins counting on.
+    uint64_t counterCycle_;
+    OverflowMode overflowMode_;
+    int pendingOverflows_;
+
+    // log2 of the CPU clock divider selected by the prescaler
+    uint8_t prescalerShift_;
+
     // Timer info
     int const timerIndex_;
     EventType const overflowEvent_;
     InterruptType const interruptType_;
+    EventScheduler& scheduler_;
 };
@@ -6,15 +6,25 @@
 #include <Timers/Timer.hpp>
 #include <Utilities/MemoryUtilities.hpp>
 
+class StateSerializer;
+namespace Logging { class LogManager; }
+
 class TimerManager
 {
 public:
     /// @brief Initialize the timers and set scheduler callbacks for timer overflows.
-    TimerManager();
+    /// @param scheduler Scheduler to register overflow events with.
+    /// @param systemControl System control to request timer interrupts from.
+    /// @param log Log to record overflows to.
+    TimerManager(EventScheduler& scheduler, SystemControl& systemControl, Logging::LogManager& log);
 
     /// @brief Reset the timers to their power-up state.
     void Reset();
 
+    /// @brief Save or load all four timers.
+    /// @param state Serializer to save state to or load state from.
+    void Serialize(StateSerializer& state);
+
     /// @brief Read a memory mapped timer register.
     /// @param addr Address of memory mapped register.
     /// @param alignment Number of bytes to read.
@@ -27,27 +37,41 @@ public:
     /// @param alignment Number of bytes to write.
     void WriteReg(uint32_t addr, uint32_t value, AccessSize alignment);
 
+    /// @brief Set which timers drive DMA audio, so their overflows are delivered in batches when nothing else depends on them.
+    /// @param timerMask Bit mask of timers that DMA audio FIFOs are clocked by.
+    void SetFifoTimers(uint8_t timerMask);
+
     /// @brief Callback function for a timer 0 overflow event.
     /// @param extraCycles Number of cycles that passed since this event was supposed to execute.
-    void Timer0Overflow(int extraCycles) { TimerOverflow(0, extraCycles); }
+    /// @return Number of times timer 0 overflowed.
+    int Timer0Overflow(int extraCycles) { return TimerOverflow(0, extraCycles); }
 
     /// @brief Callback function for a timer 1 overflow event.
     /// @param extraCycles Number of cycles that passed since this event was supposed to execute.
-    void Timer1Overflow(int extraCycles) { TimerOverflow(1, extraCycles); }
+    /// @return Number of times timer 1 overflowed.
+    int Timer1Overflow(int extraCycles) { return TimerOverflow(1, extraCycles); }
 
 private:
     /// @brief Callback function for a timer 2 overflow event.
     /// @param extraCycles Number of cycles that passed since this event was supposed to execute.
-    void Timer2Overflow(int extraCycles) { TimerOverflow(2, extraCycles); }
+    void Timer2Overflow(int extraCycles) { (void)TimerOverflow(2, extraCycles); }
 
     /// @brief Callback function for a timer 3 overflow event.
     /// @param extraCycles Number of cycles that passed since this event was supposed to execute.
-    void Timer3Overflow(int extraCycles) { TimerOverflow(3, extraCycles); }
+    void Timer3Overflow(int extraCycles) { (void)TimerOverflow(3, extraCycles); }
 
     /// @brief Handle a timer overflow event.
     /// @param timerIndex Index of timer that overflowed.
     /// @param extraCycles Number of cycles that passed since this event was supposed to execute.
-    void TimerOverflow(int timerIndex, int extraCycles);
+    /// @return Number of times the timer overflowed.
+    int TimerOverflow(int timerIndex, int extraCycles);
+
+    /// @brief Pick how each timer's overflows are delivered based on what currently depends on them.
+    void UpdateOverflowModes();
 
     std::array<Timer, 4> timers_;
+    uint8_t fifoTimers_;
+
+    SystemControl& systemControl_;
+    Logging::LogManager& log_;
 };
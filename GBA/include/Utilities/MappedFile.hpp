@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+/// @brief Copy-on-write memory mapping of a file. Pages are loaded on demand and shared with every other process mapping the
+///        same file until they're written to, which never happens for ROM data.
+class MappedFile
+{
+public:
+    /// @brief Map a file into memory. Check Mapped to see if it succeeded.
+    /// @param path Path to file to map.
+    explicit MappedFile(fs::path const& path);
+
+    /// @brief Unmap the file.
+    ~MappedFile();
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    /// @brief Check if the file was successfully mapped.
+    /// @return True if Data points to the contents of the file.
+    bool Mapped() const { return data_ != nullptr; }
+
+    /// @brief Access the mapped file.
+    /// @return Pointer to the start of the file, or nullptr if it isn't mapped.
+    uint8_t* Data() const { return data_; }
+
+    /// @brief Get the size of the mapped file.
+    /// @return Size of file in bytes, or 0 if it isn't mapped.
+    size_t Size() const { return size_; }
+
+private:
+    uint8_t* data_;
+    size_t size_;
+};
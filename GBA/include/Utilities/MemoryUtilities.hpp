@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <limits>
+#include <type_traits>
 
 enum class AccessSize : uint8_t
 {
@@ -39,23 +40,127 @@ constexpr uint8_t MAX_U8 = std::numeric_limits<uint8_t>::max();
 
 // Generic Read/Write Functions
 
+/// @brief Call a function with an access size that's only known at runtime as a compile time constant, so that everything it
+///        calls can be specialized for that size. Used to make the decision once at the top of an access instead of at each layer.
+/// @param alignment Access size.
+/// @param function Generic callable taking a std::integral_constant<AccessSize, alignment>.
+/// @return Whatever the function returns.
+template <typename Function>
+inline decltype(auto) DispatchAccessSize(AccessSize alignment, Function&& function)
+{
+    switch (alignment)
+    {
+        case AccessSize::BYTE:
+            return function(std::integral_constant<AccessSize, AccessSize::BYTE>{});
+        case AccessSize::HALFWORD:
+            return function(std::integral_constant<AccessSize, AccessSize::HALFWORD>{});
+        case AccessSize::WORD:
+        default:
+            return function(std::integral_constant<AccessSize, AccessSize::WORD>{});
+    }
+}
+
+/// @brief Forcibly align unaligned address to down to nearest aligned address.
+/// @tparam alignment Access size.
+/// @param addr Address to align.
+/// @return Aligned address.
+template <AccessSize alignment>
+inline uint32_t AlignAddress(uint32_t addr)
+{
+    return addr & ~(static_cast<uint32_t>(alignment) - 1);
+}
+
 /// @brief Forcibly align unaligned address to down to nearest aligned address.
 /// @param addr Address to align.
 /// @param alignment Access size.
 /// @return Aligned address.
-uint32_t AlignAddress(uint32_t addr, AccessSize alignment);
+inline uint32_t AlignAddress(uint32_t addr, AccessSize alignment)
+{
+    return addr & ~(static_cast<uint32_t>(alignment) - 1);
+}
+
+/// @brief Read a byte, halfword, or word from an aligned pointer.
+/// @tparam alignment Access size.
+/// @param bytePtr Pointer to a byte on a properly aligned address.
+/// @return Value at specified address.
+template <AccessSize alignment>
+inline uint32_t ReadPointer(uint8_t const* bytePtr)
+{
+    if constexpr (alignment == AccessSize::BYTE)
+    {
+        return *bytePtr;
+    }
+    else if constexpr (alignment == AccessSize::HALFWORD)
+    {
+        return *reinterpret_cast<uint16_t const*>(bytePtr);
+    }
+    else
+    {
+        return *reinterpret_cast<uint32_t const*>(bytePtr);
+    }
+}
 
 /// @brief Read a byte, halfword, or word from an aligned pointer.
 /// @param bytePtr Pointer to a byte on a properly aligned address.
 /// @param alignment Access size.
 /// @return Value at specified address.
-uint32_t ReadPointer(uint8_t* bytePtr, AccessSize alignment);
+inline uint32_t ReadPointer(uint8_t const* bytePtr, AccessSize alignment)
+{
+    return DispatchAccessSize(alignment, [=](auto size) { return ReadPointer<size>(bytePtr); });
+}
 
 /// @brief Write a byte, halfword, or word to an aligned pointer.
+/// @tparam alignment Access size.
 /// @param bytePtr Pointer to a byte on a properly aligned address.
+/// @param value Value to write to specified address.
+template <AccessSize alignment>
+inline void WritePointer(uint8_t* bytePtr, uint32_t value)
+{
+    if constexpr (alignment == AccessSize::BYTE)
+    {
+        *bytePtr = value;
+    }
+    else if constexpr (alignment == AccessSize::HALFWORD)
+    {
+        *reinterpret_cast<uint16_t*>(bytePtr) = value;
+    }
+    else
+    {
+        *reinterpret_cast<uint32_t*>(bytePtr) = value;
+    }
+}
+
+/// @brief Write a byte, halfword, or word to an aligned pointer.
+/// @param bytePtr Pointer to a byte on a properly aligned address.
+/// @param value Value to write to specified address.
 /// @param alignment Access size.
-/// @return Value to write to specified address.
-void WritePointer(uint8_t* bytePtr, uint32_t value, AccessSize alignment);
+inline void WritePointer(uint8_t* bytePtr, uint32_t value, AccessSize alignment)
+{
+    DispatchAccessSize(alignment, [=](auto size) { WritePointer<size>(bytePtr, value); });
+}
+
+/// @brief Write a byte, halfword, or word to an aligned pointer and check whether it changed what was stored there.
+/// @tparam alignment Access size.
+/// @param bytePtr Pointer to a byte on a properly aligned address.
+/// @param value Value to write to specified address.
+/// @return True if the contents of memory changed.
+template <AccessSize alignment>
+inline bool WritePointerAndCompare(uint8_t* bytePtr, uint32_t value)
+{
+    uint32_t previousValue = ReadPointer<alignment>(bytePtr);
+    WritePointer<alignment>(bytePtr, value);
+    return ReadPointer<alignment>(bytePtr) != previousValue;
+}
+
+/// @brief Write a byte, halfword, or word to an aligned pointer and check whether it changed what was stored there.
+/// @param bytePtr Pointer to a byte on a properly aligned address.
+/// @param value Value to write to specified address.
+/// @param alignment Access size.
+/// @return True if the contents of memory changed.
+inline bool WritePointerAndCompare(uint8_t* bytePtr, uint32_t value, AccessSize alignment)
+{
+    return DispatchAccessSize(alignment, [=](auto size) { return WritePointerAndCompare<size>(bytePtr, value); });
+}
 
 /// @brief Sign extend to an 8 bit signed type.
 /// @param input Unsigned value to sign extend.
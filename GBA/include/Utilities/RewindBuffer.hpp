@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/// @brief History of save states for rewinding, held in a fixed amount of memory. Only the newest state is stored in full. Every
+///        older state is stored as the XOR of itself and the next newer state, compressed by encoding runs of unchanged bytes.
+///        Consecutive states are mostly identical, so each delta is a small fraction of a full state. Stepping back one state
+///        only decodes one delta onto the newest state, no matter how long the history is.
+///
+///        Deltas are packed into a circular arena that's allocated once. When the arena or the delta table fills up, the oldest
+///        states are dropped.
+class RewindBuffer
+{
+public:
+    /// @brief Allocate a rewind buffer.
+    /// @param capacity Max number of bytes used to store deltas, not including the newest state.
+    explicit RewindBuffer(size_t capacity);
+
+    RewindBuffer(RewindBuffer const&) = delete;
+    RewindBuffer& operator=(RewindBuffer const&) = delete;
+
+    /// @brief Add a state as the newest in the history.
+    /// @param state State to add. Swapped with the buffer that held the previous newest state, so that the same two buffers keep
+    ///              being reused and capturing doesn't allocate.
+    void Push(std::vector<uint8_t>& state);
+
+    /// @brief Drop the newest state, making the one before it the newest.
+    /// @return False if there was no older state to step back to, in which case nothing changes.
+    bool Pop();
+
+    /// @brief Get the newest state in the history.
+    /// @return Newest state, empty if nothing has been pushed.
+    std::vector<uint8_t> const& Newest() const { return newest_; }
+
+    /// @brief Get how many states can be stepped through.
+    /// @return Number of states, including the newest.
+    size_t Count() const { return entryCount_ + (newest_.empty() ? 0 : 1); }
+
+    /// @brief Get how much memory the history holds on to, whether or not it's in use yet.
+    /// @return Size of the arena, delta table, and state buffers in bytes.
+    size_t MemoryUsage() const
+    {
+        return capacity_ + (entries_.capacity() * sizeof(Entry)) + newest_.capacity() + encodeBuffer_.capacity();
+    }
+
+    /// @brief Drop every state.
+    void Clear();
+
+private:
+    struct Entry
+    {
+        size_t offset_;  // Location in arena
+        size_t length_;  // Size of encoded delta
+        size_t stateSize_;  // Size of the state the delta restores
+    };
+
+    /// @brief Encode the difference between two states.
+    /// @param older State that decoding should restore.
+    /// @param newer State that the delta will be applied to.
+    /// @param dest Buffer to write encoded delta to. Must hold at least MaxEncodedSize(older.size()) bytes.
+    /// @return Size of encoded delta.
+    static size_t EncodeDelta(std::vector<uint8_t> const& older, std::vector<uint8_t> const& newer, uint8_t* dest);
+
+    /// @brief Apply an encoded delta to a state in place, turning it into the older state the delta was encoded from.
+    /// @param src Encoded delta.
+    /// @param length Size of encoded delta.
+    /// @param state State to apply delta to. Must already be resized to the size of the older state.
+    static void DecodeDelta(uint8_t const* src, size_t length, std::vector<uint8_t>& state);
+
+    /// @brief Get the largest size a delta can be encoded to.
+    /// @param stateSize Size of the state being restored.
+    /// @return Max encoded size in bytes.
+    static size_t MaxEncodedSize(size_t stateSize);
+
+    /// @brief Reserve space in the arena for a delta, dropping the oldest deltas until it fits.
+    /// @param length Size of delta.
+    /// @return Offset of reserved space.
+    size_t Allocate(size_t length);
+
+    /// @brief Drop the oldest delta.
+    void DropOldest();
+
+    // Newest state, and scratch space to encode the next delta into
+    std::vector<uint8_t> newest_;
+    std::vector<uint8_t> encodeBuffer_;
+
+    // Arena holding encoded deltas in order from oldest to newest, wrapping around to the beginning when the end is reached
+    size_t const capacity_;
+    std::unique_ptr<uint8_t[]> arena_;
+
+    // Circular table of deltas
+    std::vector<Entry> entries_;
+    size_t oldestEntry_;
+    size_t entryCount_;
+};
@@ -18,7 +18,7 @@ public:
     /// @param data Pointer to buffer of data to store.
     /// @param cnt Number of items to write into ring buffer.
     /// @return Whether there was adequate space in the buffer to write the requested number of items.
-    bool Write(T* data, size_t cnt);
+    bool Write(T const* data, size_t cnt);
 
     /// @brief Read data from ring buffer. Should only be called from consumer thread.
     /// @param data Buffer to write data into from ring buffer.
@@ -26,6 +26,12 @@ public:
     /// @return Whether there were enough items in the ring buffer to satisfy the read request.
     bool Read(T* data, size_t cnt);
 
+    /// @brief Read as many items as are available from ring buffer, up to a limit. Should only be called from consumer thread.
+    /// @param data Buffer to write data into from ring buffer.
+    /// @param cnt Max number of items to read from ring buffer.
+    /// @return Number of items that were read.
+    size_t ReadUpTo(T* data, size_t cnt);
+
     /// @brief Get the number of items that can be written into the ring buffer. Should only be called from producer thread.
     /// @return Max number of items that can currently be written to ring buffer.
     size_t GetFree() const;
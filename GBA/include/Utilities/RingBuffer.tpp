@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Utilities/RingBuffer.hpp>
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <cstring>
@@ -13,7 +14,7 @@ RingBuffer<T, size>::RingBuffer()
 }
 
 template <typename T, size_t size>
-bool RingBuffer<T, size>::Write(T* data, size_t cnt)
+bool RingBuffer<T, size>::Write(T const* data, size_t cnt)
 {
     size_t head = head_.load(std::memory_order_relaxed);
     size_t tail = tail_.load(std::memory_order_acquire);
@@ -49,14 +50,22 @@ bool RingBuffer<T, size>::Write(T* data, size_t cnt)
 template <typename T, size_t size>
 bool RingBuffer<T, size>::Read(T* data, size_t cnt)
 {
-    size_t tail = tail_.load(std::memory_order_relaxed);
-    size_t head = head_.load(std::memory_order_acquire);
-
-    if (CalculateAvailable(head, tail) < cnt)
+    if (GetAvailable() < cnt)
     {
         return false;
     }
 
+    ReadUpTo(data, cnt);
+    return true;
+}
+
+template <typename T, size_t size>
+size_t RingBuffer<T, size>::ReadUpTo(T* data, size_t cnt)
+{
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t head = head_.load(std::memory_order_acquire);
+    cnt = std::min(cnt, CalculateAvailable(head, tail));
+
     if ((tail + cnt) <= size)
     {
         std::memcpy(data, &buffer_[tail], cnt * sizeof(T));
@@ -77,7 +86,7 @@ bool RingBuffer<T, size>::Read(T* data, size_t cnt)
     }
 
     tail_.store(tail, std::memory_order_release);
-    return true;
+    return cnt;
 }
 
 template <typename T, size_t size>
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+/// @brief Reads or writes a flat binary save state. Each component has a single Serialize function that passes its members through
+///        a StateSerializer, so saving and loading always visit the same fields in the same order. Values are copied raw, so states
+///        are only compatible between builds with the same layout. The state version should be bumped whenever a field changes.
+class StateSerializer
+{
+public:
+    /// @brief Prepare to save state. The buffer is overwritten in place and only grows when a state doesn't fit, so saving into
+    ///        the same buffer repeatedly is nothing but a copy of each field. Finish must be called once everything is saved.
+    /// @param buffer Buffer to write state to.
+    explicit StateSerializer(std::vector<uint8_t>& buffer);
+
+    /// @brief Prepare to load state. Data is read in place from the caller's buffer.
+    /// @param data Pointer to save state.
+    /// @param size Size of save state in bytes.
+    StateSerializer(uint8_t const* data, size_t size);
+
+    /// @brief Check which direction state is being copied.
+    /// @return True if loading state, false if saving it.
+    bool Loading() const { return loading_; }
+
+    /// @brief Get how far into the save state the serializer is.
+    /// @return Number of bytes saved or loaded so far.
+    size_t Offset() const { return offset_; }
+
+    /// @brief Save or load a trivially copyable value, including arrays of them.
+    /// @param value Value to save, or set to the loaded value.
+    template <typename T>
+    void Value(T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be saved directly");
+        Bytes(&value, sizeof(T));
+    }
+
+    /// @brief Save or load a vector of trivially copyable values. The vector is resized to match the loaded state.
+    /// @param vector Vector to save, or set to the loaded contents.
+    template <typename T>
+    void Vector(std::vector<T>& vector)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be saved directly");
+        uint64_t count = vector.size();
+        Value(count);
+
+        if (loading_)
+        {
+            CheckRemaining(count, sizeof(T));
+            vector.resize(count);
+        }
+
+        Bytes(vector.data(), count * sizeof(T));
+    }
+
+    /// @brief Save or load a block of memory.
+    /// @param data Pointer to memory to save, or to overwrite with loaded state.
+    /// @param size Number of bytes.
+    void Bytes(void* data, size_t size);
+
+    /// @brief Check whether the next value in a state being loaded is identical to a value, without loading it.
+    /// @param value Value to compare against.
+    /// @return True if loading would leave the value unchanged. Always false when saving.
+    template <typename T>
+    bool Unchanged(T const& value) const
+    {
+        return Matches(offset_, &value, sizeof(T));
+    }
+
+    /// @brief Check whether the next vector in a state being loaded is identical to a vector, without loading it.
+    /// @param vector Vector to compare against.
+    /// @return True if loading would leave the vector unchanged. Always false when saving.
+    template <typename T>
+    bool VectorUnchanged(std::vector<T> const& vector) const
+    {
+        uint64_t count = vector.size();
+        return Matches(offset_, &count, sizeof(count)) && Matches(offset_ + sizeof(count), vector.data(), count * sizeof(T));
+    }
+
+    /// @brief Trim the buffer being saved to down to the size of the state. Does nothing when loading.
+    void Finish();
+
+private:
+    /// @brief Make sure enough of the save state is left to load a number of items.
+    /// @param count Number of items.
+    /// @param itemSize Size of each item in bytes.
+    void CheckRemaining(uint64_t count, size_t itemSize) const;
+
+    /// @brief Check whether part of a state being loaded is identical to a block of memory.
+    /// @param offset Offset into the state.
+    /// @param data Memory to compare against.
+    /// @param size Number of bytes to compare.
+    /// @return True if loading and the bytes are identical.
+    bool Matches(size_t offset, void const* data, size_t size) const;
+
+    bool const loading_;
+    std::vector<uint8_t>* const buffer_;
+    uint8_t const* const data_;
+    size_t const size_;
+    size_t offset_;
+};
@@ -1,40 +1,111 @@
 #include <AdvancedBoy.hpp>
 #include <Gamepad.hpp>
+#include <PixelFormat.hpp>
 #include <Config.hpp>
-#include <Logging/Logging.hpp>
+#include <Logging/TraceStream.hpp>
+#include <System/AvCapture.hpp>
 #include <System/GameBoyAdvance.hpp>
+#include <chrono>
 #include <filesystem>
 #include <functional>
-#include <memory>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace fs = std::filesystem;
 
-// Globals
-std::unique_ptr<GameBoyAdvance> gba;
-bool gamePakLoaded;
-
 // Public header definitions
 
-void Initialize(fs::path biosPath)
+GbaHandle Initialize(fs::path biosPath)
+{
+    GbaHandle gba = new GameBoyAdvance(biosPath);
+    SetThreadedRendering(gba, std::thread::hardware_concurrency() > 1);
+    return gba;
+}
+
+GbaHandle Clone(GbaHandle gba)
+{
+    if (!gba)
+    {
+        throw std::runtime_error("Clone uninitialized GBA");
+    }
+
+    return gba->Clone().release();
+}
+
+void SetThreadedRendering(GbaHandle gba, bool enabled)
+{
+    if (!gba)
+    {
+        throw std::runtime_error("Set threaded rendering of uninitialized GBA");
+    }
+
+    gba->SetRenderThreadEnabled(enabled);
+}
+
+void SetBiosHle(GbaHandle gba, bool enabled)
+{
+    if (!gba)
+    {
+        throw std::runtime_error("Set BIOS HLE of uninitialized GBA");
+    }
+
+    gba->SetBiosHle(enabled);
+}
+
+void SetDirectBoot(GbaHandle gba, bool enabled)
+{
+    if (!gba)
+    {
+        throw std::runtime_error("Set direct boot of uninitialized GBA");
+    }
+
+    gba->SetDirectBoot(enabled);
+}
+
+void SetPixelFormat(GbaHandle gba, PixelFormat format, bool colorCorrection)
 {
-    gba.reset();
-    gba = std::make_unique<GameBoyAdvance>(biosPath);
+    if (!gba)
+    {
+        throw std::runtime_error("Set pixel format of uninitialized GBA");
+    }
+
+    gba->SetOutputFormat(format, colorCorrection);
+}
+
+void SetFrameSkip(GbaHandle gba, int frames)
+{
+    if (!gba)
+    {
+        throw std::runtime_error("Set frame skip of uninitialized GBA");
+    }
+
+    gba->SetFrameSkip(frames);
+}
+
+void SetRunAhead(GbaHandle gba, int frames)
+{
+    if (!gba)
+    {
+        throw std::runtime_error("Set run-ahead of uninitialized GBA");
+    }
+
+    gba->SetRunAhead(frames);
 }
 
-bool InsertCartridge(fs::path romPath)
+bool InsertCartridge(GbaHandle gba, fs::path romPath)
 {
     if (!gba)
     {
         throw std::runtime_error("Inserted cartridge into uninitialized GBA");
     }
 
-    gamePakLoaded = gba->LoadGamePak(romPath);
-    return gamePakLoaded;
+    return gba->LoadGamePak(romPath);
 }
 
-void FillAudioBuffer()
+void FillAudioBuffer(GbaHandle gba)
 {
     if (!gba)
     {
@@ -44,17 +115,57 @@ void FillAudioBuffer()
     gba->FillAudioBuffer();
 }
 
-void DrainAudioBuffer(float* buffer, size_t cnt)
+void RunFrames(GbaHandle gba, int frames, std::vector<float>* audio)
+{
+    if (!gba)
+    {
+        throw std::runtime_error("Ran uninitialized GBA");
+    }
+
+    gba->RunFrames(frames, audio);
+}
+
+size_t RunFrames(GbaHandle gba, int frames, float* audio, size_t capacity)
+{
+    if (!gba)
+    {
+        throw std::runtime_error("Ran uninitialized GBA");
+    }
+
+    return gba->RunFrames(frames, audio, capacity);
+}
+
+void SetAudioSampleRate(GbaHandle gba, int sampleRate)
+{
+    if (!gba)
+    {
+        throw std::runtime_error("Set audio sample rate of uninitialized GBA");
+    }
+
+    gba->SetAudioSampleRate(sampleRate);
+}
+
+void SetAudioLatency(GbaHandle gba, int milliseconds)
+{
+    if (!gba)
+    {
+        throw std::runtime_error("Set audio latency of uninitialized GBA");
+    }
+
+    gba->SetAudioLatency(milliseconds);
+}
+
+size_t DrainAudioBuffer(GbaHandle gba, float* buffer, size_t cnt)
 {
     if (!gba)
     {
         throw std::runtime_error("Audio callback with uninitialized GBA");
     }
 
-    gba->DrainAudioBuffer(buffer, cnt);
+    return gba->DrainAudioBuffer(buffer, cnt);
 }
 
-size_t AvailableSamplesCount()
+size_t AvailableSamplesCount(GbaHandle gba)
 {
     if (!gba)
     {
@@ -64,7 +175,27 @@ size_t AvailableSamplesCount()
     return gba->AvailableSamplesCount();
 }
 
-void UpdateGamepad(Gamepad gamepad)
+bool WaitForAudioSpace(GbaHandle gba, int timeoutMs)
+{
+    if (!gba)
+    {
+        throw std::runtime_error("Waited for audio space of uninitialized GBA");
+    }
+
+    return gba->WaitForAudioSpace(std::chrono::milliseconds(timeoutMs));
+}
+
+void WakeAudioWaiter(GbaHandle gba)
+{
+    if (!gba)
+    {
+        throw std::runtime_error("Woke audio waiter of uninitialized GBA");
+    }
+
+    gba->WakeAudioWaiter();
+}
+
+void UpdateGamepad(GbaHandle gba, Gamepad gamepad)
 {
     if (gba)
     {
@@ -72,37 +203,192 @@ void UpdateGamepad(Gamepad gamepad)
     }
 }
 
-uint8_t* GetRawFrameBuffer()
+void SaveState(GbaHandle gba, std::vector<uint8_t>& state)
+{
+    if (!gba)
+    {
+        throw std::runtime_error("Saved state of uninitialized GBA");
+    }
+
+    gba->SaveState(state);
+}
+
+bool LoadState(GbaHandle gba, std::vector<uint8_t> const& state)
+{
+    if (!gba)
+    {
+        throw std::runtime_error("Loaded state into uninitialized GBA");
+    }
+
+    return gba->LoadState(state.data(), state.size());
+}
+
+void SetRewind(GbaHandle gba, bool enabled, int framesPerCapture, size_t bufferSizeInBytes)
+{
+    if (!gba)
+    {
+        throw std::runtime_error("Set rewind on uninitialized GBA");
+    }
+
+    gba->SetRewind(enabled, framesPerCapture, bufferSizeInBytes);
+}
+
+bool Rewind(GbaHandle gba)
 {
     if (!gba)
     {
-        return nullptr;
+        throw std::runtime_error("Rewound uninitialized GBA");
     }
 
-    return gba->GetRawFrameBuffer();
+    return gba->Rewind();
 }
 
-int GetAndResetFrameCounter()
+void StartMovieRecording(GbaHandle gba)
 {
     if (!gba)
     {
-        return 0;
+        throw std::runtime_error("Started movie recording on uninitialized GBA");
     }
 
-    return gba->GetAndResetFrameCounter();
+    gba->StartMovieRecording();
 }
 
-void ToggleSystemLogging()
+bool StartMoviePlayback(GbaHandle gba, std::vector<uint8_t> const& movie)
 {
-    Logging::LogMgr.ToggleSystemLogging();
+    if (!gba)
+    {
+        throw std::runtime_error("Started movie playback on uninitialized GBA");
+    }
+
+    return gba->StartMoviePlayback(movie.data(), movie.size());
 }
 
-void ToggleCpuLogging()
+void StopMovie(GbaHandle gba, std::vector<uint8_t>& movie)
 {
-    Logging::LogMgr.ToggleCpuLogging();
+    if (!gba)
+    {
+        throw std::runtime_error("Stopped movie on uninitialized GBA");
+    }
+
+    gba->StopMovie(movie);
 }
 
-void DumpLogs()
+MovieMode GetMovieMode(GbaHandle gba)
+{
+    if (!gba)
+    {
+        throw std::runtime_error("Checked movie mode of uninitialized GBA");
+    }
+
+    return gba->GetMovieMode();
+}
+
+Frame AcquireLatestFrame(GbaHandle gba)
+{
+    if (!gba)
+    {
+        return {nullptr, 0, 0};
+    }
+
+    auto frame = gba->AcquireFrame();
+    return {frame.pixels_, frame.sequence_, frame.contentSequence_};
+}
+
+void SetFrameTarget(GbaHandle gba, void* pixels)
+{
+    if (!gba)
+    {
+        throw std::runtime_error("Set frame target of uninitialized GBA");
+    }
+
+    gba->SetFrameTarget(static_cast<uint8_t*>(pixels));
+}
+
+void SetFrameCallback(GbaHandle gba, FrameCallback callback)
+{
+    if (!gba)
+    {
+        throw std::runtime_error("Set frame callback of uninitialized GBA");
+    }
+
+    gba->SetFrameCallback(std::move(callback));
+}
+
+void StartCapture(GbaHandle gba, fs::path path, CaptureFormat format, std::string const& ffmpegOptions)
+{
+    if (!gba)
+    {
+        throw std::runtime_error("Started capture on uninitialized GBA");
+    }
+
+    gba->StartCapture(path, format, ffmpegOptions);
+}
+
+CaptureStats StopCapture(GbaHandle gba)
+{
+    if (!gba)
+    {
+        throw std::runtime_error("Stopped capture on uninitialized GBA");
+    }
+
+    return gba->StopCapture();
+}
+
+CaptureStats GetCaptureStats(GbaHandle gba)
+{
+    if (!gba)
+    {
+        throw std::runtime_error("Got capture stats of uninitialized GBA");
+    }
+
+    return gba->GetCaptureStats();
+}
+
+void DecodeCapture(fs::path capturePath, fs::path rawPath)
+{
+    DecodeLosslessCapture(capturePath, rawPath);
+}
+
+Telemetry GetTelemetry(GbaHandle gba)
+{
+    if (!gba)
+    {
+        throw std::runtime_error("Got telemetry of uninitialized GBA");
+    }
+
+    return gba->GetTelemetry();
+}
+
+void ToggleSystemLogging(GbaHandle gba)
+{
+    if (gba)
+    {
+        gba->ToggleSystemLogging();
+    }
+}
+
+void ToggleCpuLogging(GbaHandle gba)
+{
+    if (gba)
+    {
+        gba->ToggleCpuLogging();
+    }
+}
+
+void ToggleTraceStreaming(GbaHandle gba)
+{
+    if (gba)
+    {
+        gba->ToggleTraceStreaming();
+    }
+}
+
+void DecodeTrace(fs::path tracePath, fs::path logPath)
+{
+    Logging::DecodeTrace(tracePath, logPath);
+}
+
+void DumpLogs(GbaHandle gba)
 {
     if (!gba)
     {
@@ -112,20 +398,87 @@ void DumpLogs()
     gba->DumpLogs();
 }
 
-std::string RomTitle()
+ProfileReport GetProfile(GbaHandle gba)
 {
     if (!gba)
     {
-        throw std::runtime_error("Got ROM title of uninitialized GBA");
+        throw std::runtime_error("Got profile of uninitialized GBA");
     }
 
-    return gba->RomTitle();
+    return gba->GetProfile();
 }
 
-void PowerOff()
+void ResetProfile(GbaHandle gba)
 {
-    if (gba)
+    if (!gba)
+    {
+        throw std::runtime_error("Reset profile of uninitialized GBA");
+    }
+
+    gba->ResetProfile();
+}
+
+void DumpProfile(GbaHandle gba, fs::path path)
+{
+    if (!gba)
+    {
+        throw std::runtime_error("Dumped profile of uninitialized GBA");
+    }
+
+    gba->DumpProfile(path);
+}
+
+HookId AddMemoryWatch(GbaHandle gba, uint32_t addr, uint32_t length, WatchType type, MemoryHook hook)
+{
+    if (!gba)
     {
-        gba.reset();
+        throw std::runtime_error("Added memory watch to uninitialized GBA");
     }
+
+    return gba->AddMemoryWatch(addr, length, type, std::move(hook));
+}
+
+HookId AddPcHook(GbaHandle gba, uint32_t pc, PcHook hook)
+{
+    if (!gba)
+    {
+        throw std::runtime_error("Added PC hook to uninitialized GBA");
+    }
+
+    return gba->AddPcHook(pc, std::move(hook));
+}
+
+bool RemoveHook(GbaHandle gba, HookId id)
+{
+    if (!gba)
+    {
+        throw std::runtime_error("Removed hook from uninitialized GBA");
+    }
+
+    return gba->RemoveHook(id);
+}
+
+bool HookStopped(GbaHandle gba)
+{
+    if (!gba)
+    {
+        throw std::runtime_error("Checked hooks of uninitialized GBA");
+    }
+
+    return gba->HookStopped();
+}
+
+std::string RomTitle(GbaHandle gba)
+{
+    if (!gba)
+    {
+        throw std::runtime_error("Got ROM title of uninitialized GBA");
+    }
+
+    return gba->RomTitle();
+}
+
+void PowerOff(GbaHandle gba)
+{
+    delete gba;
 }
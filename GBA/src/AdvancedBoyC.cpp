@@ -0,0 +1,175 @@
+#include <AdvancedBoyC.h>
+#include <AdvancedBoy.hpp>
+#include <Gamepad.hpp>
+#include <PixelFormat.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+
+/// @brief State kept alongside each GBA, so that nothing needs to be queried from it while running a frame.
+struct gba_t
+{
+    GbaHandle handle_;
+    PixelFormat format_;
+};
+
+namespace
+{
+/// @brief Call into the C++ API without letting exceptions cross the C boundary.
+/// @param function Function to call.
+/// @return GBA_OK, or GBA_ERROR_FAILED if the function threw.
+template <typename Function>
+int Guard(Function function)
+{
+    try
+    {
+        function();
+        return GBA_OK;
+    }
+    catch (std::exception const&)
+    {
+        return GBA_ERROR_FAILED;
+    }
+}
+}
+
+// Public header definitions
+
+int gba_api_version(void)
+{
+    return GBA_API_VERSION;
+}
+
+gba_t* gba_create(char const* bios_path)
+{
+    if (bios_path == nullptr)
+    {
+        return nullptr;
+    }
+
+    try
+    {
+        return new gba_t{Initialize(bios_path), PixelFormat::BGR555};
+    }
+    catch (std::exception const&)
+    {
+        return nullptr;
+    }
+}
+
+gba_t* gba_clone(gba_t* gba)
+{
+    if (gba == nullptr)
+    {
+        return nullptr;
+    }
+
+    try
+    {
+        return new gba_t{Clone(gba->handle_), PixelFormat::BGR555};
+    }
+    catch (std::exception const&)
+    {
+        return nullptr;
+    }
+}
+
+void gba_destroy(gba_t* gba)
+{
+    if (gba != nullptr)
+    {
+        PowerOff(gba->handle_);
+        delete gba;
+    }
+}
+
+int gba_load_rom(gba_t* gba, char const* rom_path)
+{
+    if ((gba == nullptr) || (rom_path == nullptr))
+    {
+        return GBA_ERROR_INVALID_ARGUMENT;
+    }
+
+    bool loaded = false;
+    int result = Guard([&]() { loaded = InsertCartridge(gba->handle_, rom_path); });
+    return ((result == GBA_OK) && !loaded) ? GBA_ERROR_FAILED : result;
+}
+
+int gba_set_pixel_format(gba_t* gba, int format, int color_correction)
+{
+    if ((gba == nullptr) || (format < GBA_PIXEL_FORMAT_BGR555) || (format > GBA_PIXEL_FORMAT_RGBA8888))
+    {
+        return GBA_ERROR_INVALID_ARGUMENT;
+    }
+
+    PixelFormat pixelFormat = static_cast<PixelFormat>(format);
+    int result = Guard([&]() { SetPixelFormat(gba->handle_, pixelFormat, color_correction != 0); });
+
+    if (result == GBA_OK)
+    {
+        gba->format_ = pixelFormat;
+    }
+
+    return result;
+}
+
+size_t gba_frame_size(gba_t const* gba)
+{
+    if (gba == nullptr)
+    {
+        return 0;
+    }
+
+    return GBA_FRAME_WIDTH * GBA_FRAME_HEIGHT * BytesPerPixel(gba->format_);
+}
+
+int gba_set_sample_rate(gba_t* gba, int sample_rate)
+{
+    if ((gba == nullptr) || (sample_rate < 8000) || (sample_rate > 96000))
+    {
+        return GBA_ERROR_INVALID_ARGUMENT;
+    }
+
+    return Guard([&]() { SetAudioSampleRate(gba->handle_, sample_rate); });
+}
+
+void gba_set_buttons(gba_t* gba, uint32_t buttons)
+{
+    if (gba == nullptr)
+    {
+        return;
+    }
+
+    // KEYINPUT bits are 0 while a button is pressed
+    Gamepad gamepad;
+    gamepad.halfword_ = ~buttons & 0x03FF;
+    UpdateGamepad(gba->handle_, gamepad);
+}
+
+int gba_run_frame(gba_t* gba, void* frame, size_t frame_size, float* audio, size_t audio_capacity, size_t* audio_count)
+{
+    if (audio_count != nullptr)
+    {
+        *audio_count = 0;
+    }
+
+    if ((gba == nullptr) || ((frame != nullptr) && (frame_size < gba_frame_size(gba))))
+    {
+        return GBA_ERROR_INVALID_ARGUMENT;
+    }
+
+    size_t audioSize = 0;
+
+    int result = Guard([&]()
+    {
+        SetFrameTarget(gba->handle_, frame);
+        audioSize = RunFrames(gba->handle_, 1, audio, (audio != nullptr) ? audio_capacity : 0);
+    });
+
+    if (audio_count != nullptr)
+    {
+        *audio_count = audioSize;
+    }
+
+    return result;
+}
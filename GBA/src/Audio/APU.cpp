@@ -1,29 +1,62 @@
 #include <Audio/APU.hpp>
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <cstdint>
 #include <functional>
+#include <mutex>
 #include <utility>
+#include <vector>
+#include <Audio/BlipBuffer.hpp>
 #include <Audio/Channel1.hpp>
 #include <Audio/Channel2.hpp>
+#include <Audio/Channel3.hpp>
 #include <Audio/Channel4.hpp>
 #include <Audio/DmaAudio.hpp>
 #include <Audio/Registers.hpp>
+#include <System/AvCapture.hpp>
 #include <System/EventScheduler.hpp>
 #include <System/MemoryMap.hpp>
 #include <Utilities/MemoryUtilities.hpp>
+#include <Utilities/StateSerializer.hpp>
 
 namespace Audio
 {
-APU::APU() :
+APU::APU(EventScheduler& scheduler) :
     apuRegisters_(),
     soundcnt_l_(*reinterpret_cast<SOUNDCNT_L*>(&apuRegisters_[0x20])),
     soundcnt_h_(*reinterpret_cast<SOUNDCNT_H*>(&apuRegisters_[0x22])),
     soundcnt_x_(*reinterpret_cast<SOUNDCNT_X*>(&apuRegisters_[0x24])),
     soundbias_(*reinterpret_cast<SOUNDBIAS*>(&apuRegisters_[0x28])),
-    dmaFifos_(soundcnt_h_)
+    channel1_(scheduler),
+    channel2_(scheduler),
+    channel3_(scheduler),
+    channel4_(scheduler),
+    dmaFifos_(soundcnt_h_),
+    synth_(BUFFER_SIZE / 2),
+    sampleRate_(DEFAULT_OUTPUT_FREQUENCY_HZ),
+    targetLatencyMs_(DEFAULT_LATENCY_MS),
+    leftLevel_(0),
+    rightLevel_(0),
+    frameStartCycle_(0),
+    lastSampleCycle_(0),
+    pendingSamples_(0),
+    outputMode_(OutputMode::Buffer),
+    recording_(nullptr),
+    captureBuffer_(nullptr),
+    captureCapacity_(0),
+    capturedSize_(0),
+    capture_(nullptr),
+    runningAhead_(false),
+    runAheadMode_(OutputMode::Buffer),
+    runAheadCycle_(0),
+    lowWatermark_(0),
+    wakeRequested_(false),
+    scheduler_(scheduler)
 {
-    Scheduler.RegisterEvent(EventType::SampleAPU, std::bind(&Sample, this, std::placeholders::_1));
+    scheduler_.RegisterEvent(EventType::SampleAPU, std::bind(&Sample, this, std::placeholders::_1));
+    synth_.SetSampleRate(sampleRate_);
+    UpdateWatermark();
 }
 
 void APU::Reset()
@@ -31,11 +64,41 @@ void APU::Reset()
     apuRegisters_.fill(0);
     channel1_.Reset();
     channel2_.Reset();
+    channel3_.Reset();
     channel4_.Reset();
     dmaFifos_.Reset();
     sampleCounter_ = 0;
 
-    Scheduler.ScheduleEvent(EventType::SampleAPU, CPU_CYCLES_PER_SAMPLE);
+    synth_.Clear();
+    leftLevel_ = 0;
+    rightLevel_ = 0;
+    frameStartCycle_ = scheduler_.TotalCycles();
+    lastSampleCycle_ = frameStartCycle_;
+    pendingSamples_ = 0;
+
+    scheduler_.ScheduleEvent(EventType::SampleAPU, CPU_CYCLES_PER_SAMPLE);
+}
+
+void APU::Serialize(StateSerializer& state)
+{
+    state.Value(apuRegisters_);
+    channel1_.Serialize(state);
+    channel2_.Serialize(state);
+    channel3_.Serialize(state);
+    channel4_.Serialize(state);
+    dmaFifos_.Serialize(state);
+    state.Value(leftLevel_);
+    state.Value(rightLevel_);
+
+    // Rolling back to where the APU started running ahead leaves resampling untouched, so that output doesn't skip
+    if (state.Loading() && !runningAhead_)
+    {
+        synth_.Clear();
+        frameStartCycle_ = scheduler_.TotalCycles();
+        lastSampleCycle_ = frameStartCycle_;
+        pendingSamples_ = 0;
+        synth_.AddDelta(0, leftLevel_, rightLevel_);
+    }
 }
 
 std::pair<uint32_t, bool> APU::ReadReg(uint32_t addr, AccessSize alignment)
@@ -43,9 +106,6 @@ std::pair<uint32_t, bool> APU::ReadReg(uint32_t addr, AccessSize alignment)
     uint32_t value = 0;
     bool openBus = false;
 
-    // Temporary register handling until all channels are implemented
-    uint8_t* bytePtr = nullptr;
-
     switch (addr)
     {
         case CHANNEL_1_ADDR_MIN ... CHANNEL_1_ADDR_MAX:
@@ -55,11 +115,8 @@ std::pair<uint32_t, bool> APU::ReadReg(uint32_t addr, AccessSize alignment)
             std::tie(value, openBus) = channel2_.ReadReg(addr, alignment);
             break;
         case CHANNEL_3_ADDR_MIN ... CHANNEL_3_ADDR_MAX:
-        {
-            size_t index = addr - SOUND_IO_ADDR_MIN;
-            bytePtr = &apuRegisters_.at(index);
+            std::tie(value, openBus) = channel3_.ReadReg(addr, alignment);
             break;
-        }
         case CHANNEL_4_ADDR_MIN ... CHANNEL_4_ADDR_MAX:
             std::tie(value, openBus) = channel4_.ReadReg(addr, alignment);
             break;
@@ -67,11 +124,8 @@ std::pair<uint32_t, bool> APU::ReadReg(uint32_t addr, AccessSize alignment)
             std::tie(value, openBus) = ReadApuCntReg(addr, alignment);
             break;
         case WAVE_RAM_ADDR_MIN ... WAVE_RAM_ADDR_MAX:
-        {
-            size_t index = addr - SOUND_IO_ADDR_MIN;
-            bytePtr = &apuRegisters_.at(index);
+            value = channel3_.ReadWaveRam(addr, alignment);
             break;
-        }
         case DMA_AUDIO_ADDR_MIN ... DMA_AUDIO_ADDR_MAX:
             std::tie(value, openBus) = dmaFifos_.ReadReg(addr, alignment);
             break;
@@ -80,20 +134,11 @@ std::pair<uint32_t, bool> APU::ReadReg(uint32_t addr, AccessSize alignment)
             break;
     }
 
-    // Temporary register handling until all channels are implemented
-    if (bytePtr != nullptr)
-    {
-        value = ReadPointer(bytePtr, alignment);
-    }
-
     return {value, openBus};
 }
 
 void APU::WriteReg(uint32_t addr, uint32_t value, AccessSize alignment)
 {
-    // Temporary register handling until all channels are implemented
-    uint8_t* bytePtr = nullptr;
-
     switch (addr)
     {
         case CHANNEL_1_ADDR_MIN ... CHANNEL_1_ADDR_MAX:
@@ -120,8 +165,13 @@ void APU::WriteReg(uint32_t addr, uint32_t value, AccessSize alignment)
         }
         case CHANNEL_3_ADDR_MIN ... CHANNEL_3_ADDR_MAX:
         {
-            size_t index = addr - SOUND_IO_ADDR_MIN;
-            bytePtr = &apuRegisters_.at(index);
+            bool triggered = channel3_.WriteReg(addr, value, alignment);
+
+            if (triggered)
+            {
+                soundcnt_x_.chan3On = 1;
+            }
+
             break;
         }
         case CHANNEL_4_ADDR_MIN ... CHANNEL_4_ADDR_MAX:
@@ -139,30 +189,246 @@ void APU::WriteReg(uint32_t addr, uint32_t value, AccessSize alignment)
             WriteApuCntReg(addr, value, alignment);
             break;
         case WAVE_RAM_ADDR_MIN ... WAVE_RAM_ADDR_MAX:
-        {
-            size_t index = addr - SOUND_IO_ADDR_MIN;
-            bytePtr = &apuRegisters_.at(index);
+            channel3_.WriteWaveRam(addr, value, alignment);
             break;
-        }
         case DMA_AUDIO_ADDR_MIN ... DMA_AUDIO_ADDR_MAX:
             dmaFifos_.WriteReg(addr, value, alignment);
             break;
         default:
             break;
     }
+}
 
-    // Temporary register handling until all channels are implemented
-    if (bytePtr != nullptr)
+void APU::SetSampleRate(int sampleRate)
+{
+    sampleRate_ = std::clamp(sampleRate, MIN_OUTPUT_FREQUENCY_HZ, MAX_OUTPUT_FREQUENCY_HZ);
+    synth_.SetSampleRate(sampleRate_);
+    frameStartCycle_ = lastSampleCycle_;
+    pendingSamples_ = 0;
+    UpdateWatermark();
+
+    // Restore the current output level since clearing the synthesizers reset it to silence
+    synth_.AddDelta(0, leftLevel_, rightLevel_);
+}
+
+void APU::SetTargetLatency(int milliseconds)
+{
+    targetLatencyMs_ = std::clamp(milliseconds, MIN_LATENCY_MS, MAX_LATENCY_MS);
+    UpdateWatermark();
+}
+
+void APU::CopyResampling(APU const& other)
+{
+    sampleRate_ = other.sampleRate_;
+    targetLatencyMs_ = other.targetLatencyMs_;
+    synth_ = other.synth_;
+    frameStartCycle_ = other.frameStartCycle_;
+    lastSampleCycle_ = other.lastSampleCycle_;
+    pendingSamples_ = other.pendingSamples_;
+    UpdateWatermark();
+}
+
+void APU::SetOutputMode(OutputMode mode, std::vector<float>* recording)
+{
+    if ((mode == outputMode_) && (recording == recording_))
     {
-        WritePointer(bytePtr, value, alignment);
+        return;
     }
+
+    SwitchOutputMode(mode);
+    recording_ = (mode == OutputMode::Record) ? recording : nullptr;
+}
+
+void APU::SetOutputMode(OutputMode mode, float* capture, size_t capacity)
+{
+    SwitchOutputMode(mode);
+    recording_ = nullptr;
+
+    if (mode == OutputMode::Capture)
+    {
+        captureBuffer_ = capture;
+        captureCapacity_ = capacity;
+        capturedSize_ = 0;
+    }
+}
+
+void APU::SwitchOutputMode(OutputMode mode)
+{
+    FlushSamples();
+
+    if (outputMode_ == OutputMode::Discard)
+    {
+        // Nothing was resampled while discarding, so restart from the current output level
+        synth_.Clear();
+        frameStartCycle_ = lastSampleCycle_;
+        pendingSamples_ = 0;
+        synth_.AddDelta(0, leftLevel_, rightLevel_);
+    }
+
+    if (mode != OutputMode::Buffer)
+    {
+        synth_.SetRateAdjustment(1.0);
+    }
+
+    outputMode_ = mode;
+}
+
+void APU::BeginRunAhead()
+{
+    FlushSamples();
+    runAheadMode_ = outputMode_;
+    runAheadCycle_ = lastSampleCycle_;
+    outputMode_ = OutputMode::Discard;
+    runningAhead_ = true;
+}
+
+void APU::EndRunAhead()
+{
+    frameStartCycle_ = runAheadCycle_;
+    lastSampleCycle_ = runAheadCycle_;
+    pendingSamples_ = 0;
+    outputMode_ = runAheadMode_;
+    runningAhead_ = false;
 }
 
 size_t APU::FreeBufferSpace() const
 {
-    size_t bufferSpace = sampleBuffer_.GetFree();
+    // Keep the same amount of buffered audio regardless of output rate
+    size_t targetSize = ((sampleRate_ * targetLatencyMs_) / 1000) * 2;
+    size_t bufferedSize = (BUFFER_SIZE - 1) - sampleBuffer_.GetFree();
+
+    if (bufferedSize >= targetSize)
+    {
+        return 0;
+    }
+
+    size_t bufferSpace = std::min(targetSize - bufferedSize, sampleBuffer_.GetFree());
     bufferSpace >>= 1;
-    return bufferSpace;
+    return (bufferSpace > pendingSamples_) ? (bufferSpace - pendingSamples_) : 0;
+}
+
+void APU::FlushSamples()
+{
+    if (outputMode_ == OutputMode::Discard)
+    {
+        return;
+    }
+
+    uint32_t frameLength = lastSampleCycle_ - frameStartCycle_;
+    synth_.EndFrame(frameLength);
+    frameStartCycle_ = lastSampleCycle_;
+    pendingSamples_ = 0;
+    float gain = 1.0 / 512.0;
+
+    if (outputMode_ == OutputMode::Record)
+    {
+        size_t offset = recording_->size();
+        recording_->resize(offset + (synth_.SamplesAvailable() * 2));
+        size_t sampleCount = synth_.ReadSamples(recording_->data() + offset, synth_.SamplesAvailable(), gain);
+        recording_->resize(offset + (sampleCount * 2));
+
+        if (capture_ != nullptr)
+        {
+            capture_->PushAudio(recording_->data() + offset, sampleCount * 2);
+        }
+
+        return;
+    }
+
+    if (outputMode_ == OutputMode::Capture)
+    {
+        size_t sampleCount = synth_.ReadSamples(captureBuffer_ + capturedSize_, (captureCapacity_ - capturedSize_) / 2, gain);
+
+        if (capture_ != nullptr)
+        {
+            capture_->PushAudio(captureBuffer_ + capturedSize_, sampleCount * 2);
+        }
+
+        capturedSize_ += sampleCount * 2;
+
+        // Whatever doesn't fit in the caller's buffer is dropped, but still recorded
+        while (synth_.SamplesAvailable() > 0)
+        {
+            sampleCount = synth_.ReadSamples(flushBuffer_.data(), flushBuffer_.size() / 2, gain);
+
+            if (capture_ != nullptr)
+            {
+                capture_->PushAudio(flushBuffer_.data(), sampleCount * 2);
+            }
+        }
+
+        return;
+    }
+
+    // One batch of resampling per flush. Anything that doesn't fit in twice the target latency is dropped.
+    size_t sampleCount = synth_.ReadSamples(flushBuffer_.data(), flushBuffer_.size() / 2, gain);
+
+    // Recording gets everything that was resampled, including what's dropped below, so that it keeps pace with emulated time
+    if (capture_ != nullptr)
+    {
+        capture_->PushAudio(flushBuffer_.data(), sampleCount * 2);
+    }
+
+    size_t capacity = ((sampleRate_ * targetLatencyMs_ * 2) / 1000) * 2;
+    size_t bufferedSize = (BUFFER_SIZE - 1) - sampleBuffer_.GetFree();
+    size_t freeSpace = (capacity > bufferedSize) ? (capacity - bufferedSize) : 0;
+    sampleCount = std::min(sampleCount, freeSpace / 2);
+    sampleBuffer_.Write(flushBuffer_.data(), sampleCount * 2);
+
+    // Dynamic rate control. Produce slightly fewer samples per emulated second while the buffer is more than half full, and
+    // slightly more while it's less than half full, so that it neither underruns nor builds up latency.
+    double fillLevel = static_cast<double>(bufferedSize + (sampleCount * 2)) / capacity;
+    double ratio = 1.0 + (MAX_RATE_ADJUSTMENT * (1.0 - (2.0 * std::min(fillLevel, 1.0))));
+    synth_.SetRateAdjustment(ratio);
+}
+
+bool APU::WaitForBufferSpace(std::chrono::milliseconds timeout, bool ignoreBuffer)
+{
+    std::unique_lock lock(spaceMutex_);
+
+    bool ready = spaceAvailable_.wait_for(lock, timeout, [this, ignoreBuffer]()
+    {
+        size_t bufferedSize = (BUFFER_SIZE - 1) - sampleBuffer_.GetFree();
+        return wakeRequested_ || (!ignoreBuffer && (bufferedSize <= lowWatermark_.load(std::memory_order_relaxed)));
+    });
+
+    wakeRequested_ = false;
+    return ready;
+}
+
+size_t APU::DrainBuffer(float* buffer, size_t cnt)
+{
+    size_t drained = sampleBuffer_.ReadUpTo(buffer, cnt);
+    std::fill(buffer + drained, buffer + cnt, 0.0f);
+
+    if (sampleBuffer_.GetAvailable() <= lowWatermark_.load(std::memory_order_relaxed))
+    {
+        // Taking the lock orders this drain with the producer's check of the buffer level, so the notification can't be missed
+        {
+            std::lock_guard lock(spaceMutex_);
+        }
+
+        spaceAvailable_.notify_one();
+    }
+
+    return drained;
+}
+
+void APU::WakeProducer()
+{
+    {
+        std::lock_guard lock(spaceMutex_);
+        wakeRequested_ = true;
+    }
+
+    spaceAvailable_.notify_one();
+}
+
+void APU::UpdateWatermark()
+{
+    size_t targetSize = ((sampleRate_ * targetLatencyMs_) / 1000) * 2;
+    size_t oneMillisecond = (sampleRate_ / 1000) * 2;
+    lowWatermark_.store(targetSize - oneMillisecond, std::memory_order_relaxed);
 }
 
 std::pair<uint32_t, bool> APU::ReadApuCntReg(uint32_t addr, AccessSize alignment)
@@ -186,6 +452,12 @@ std::pair<uint32_t, bool> APU::ReadApuCntReg(uint32_t addr, AccessSize alignment
         return {0, true};
     }
 
+    uint64_t currentCycle = scheduler_.TotalCycles();
+    channel1_.Update(currentCycle);
+    channel2_.Update(currentCycle);
+    channel3_.Update(currentCycle);
+    channel4_.Update(currentCycle);
+
     if (channel1_.Expired())
     {
         soundcnt_x_.chan1On = 0;
@@ -196,6 +468,11 @@ std::pair<uint32_t, bool> APU::ReadApuCntReg(uint32_t addr, AccessSize alignment
         soundcnt_x_.chan2On = 0;
     }
 
+    if (channel3_.Expired())
+    {
+        soundcnt_x_.chan3On = 0;
+    }
+
     if (channel4_.Expired())
     {
         soundcnt_x_.chan4On = 0;
@@ -227,7 +504,8 @@ void APU::WriteApuCntReg(uint32_t addr, uint32_t value, AccessSize alignment)
 
 void APU::Sample(int extraCycles)
 {
-    Scheduler.ScheduleEvent(EventType::SampleAPU, CPU_CYCLES_PER_SAMPLE - extraCycles);
+    scheduler_.ScheduleEvent(EventType::SampleAPU, CPU_CYCLES_PER_SAMPLE - extraCycles);
+    uint64_t sampleCycle = scheduler_.TotalCycles() - extraCycles;
 
     int16_t leftSample = 0;
     int16_t rightSample = 0;
@@ -239,7 +517,7 @@ void APU::Sample(int extraCycles)
         uint16_t psgRightSample = 0;
 
         // Channel 1
-        uint8_t channel1Sample = channel1_.Sample();
+        uint8_t channel1Sample = channel1_.Sample(sampleCycle);
 
         if (soundcnt_l_.chan1EnableLeft)
         {
@@ -252,7 +530,7 @@ void APU::Sample(int extraCycles)
         }
 
         // Channel 2
-        uint8_t channel2Sample = channel2_.Sample();
+        uint8_t channel2Sample = channel2_.Sample(sampleCycle);
 
         if (soundcnt_l_.chan2EnableLeft)
         {
@@ -264,8 +542,21 @@ void APU::Sample(int extraCycles)
             psgRightSample += channel2Sample;
         }
 
+        // Channel 3
+        uint8_t channel3Sample = channel3_.Sample(sampleCycle);
+
+        if (soundcnt_l_.chan3EnableLeft)
+        {
+            psgLeftSample += channel3Sample;
+        }
+
+        if (soundcnt_l_.chan3EnableRight)
+        {
+            psgRightSample += channel3Sample;
+        }
+
         // Channel 4
-        uint8_t channel4Sample = channel4_.Sample();
+        uint8_t channel4Sample = channel4_.Sample(sampleCycle);
 
         if (soundcnt_l_.chan4EnableLeft)
         {
@@ -326,11 +617,36 @@ void APU::Sample(int extraCycles)
         std::clamp(rightSample, MIN_OUTPUT_LEVEL, MAX_OUTPUT_LEVEL);
     }
 
-    float leftOutput = (leftSample - 512) / 512.0;
-    float rightOutput = (rightSample - 512) / 512.0;
+    if (outputMode_ == OutputMode::Discard)
+    {
+        leftLevel_ = leftSample - 512;
+        rightLevel_ = rightSample - 512;
+        lastSampleCycle_ = sampleCycle;
+        frameStartCycle_ = sampleCycle;
+        return;
+    }
+
+    // Record changes in output level relative to silence
+    uint32_t clocks = sampleCycle - frameStartCycle_;
+    int16_t leftLevel = leftSample - 512;
+    int16_t rightLevel = rightSample - 512;
+
+    if ((leftLevel != leftLevel_) || (rightLevel != rightLevel_))
+    {
+        synth_.AddDelta(clocks, leftLevel - leftLevel_, rightLevel - rightLevel_);
+        leftLevel_ = leftLevel;
+        rightLevel_ = rightLevel;
+    }
+
+    lastSampleCycle_ = sampleCycle;
+    size_t pendingSamples = synth_.SamplesAvailable(clocks);
+    sampleCounter_ += pendingSamples - pendingSamples_;
+    pendingSamples_ = pendingSamples;
 
-    float sample[2] = {leftOutput, rightOutput};
-    sampleBuffer_.Write(&sample[0], 2);
-    ++sampleCounter_;
+    // Flush early if nobody else has before the synthesizers fill up
+    if ((pendingSamples_ + (MAX_OUTPUT_FREQUENCY_HZ / SAMPLING_FREQUENCY_HZ) + 1) >= (BUFFER_SIZE / 2))
+    {
+        FlushSamples();
+    }
 }
 }
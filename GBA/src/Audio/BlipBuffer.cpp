@@ -0,0 +1,169 @@
+#include <Audio/BlipBuffer.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <numbers>
+#include <vector>
+#include <CPU/CpuTypes.hpp>
+
+namespace
+{
+constexpr int KERNEL_UNITY_BITS = 15;
+constexpr int32_t KERNEL_UNITY = 1 << KERNEL_UNITY_BITS;
+
+// Fraction of the output sample rate to pass through. Just under Nyquist leaves room for the window's transition band.
+constexpr double CUTOFF = 0.45;
+
+typedef std::array<std::array<int32_t, Audio::BlipBuffer::KERNEL_WIDTH>, Audio::BlipBuffer::PHASE_COUNT> KernelTable;
+
+/// @brief Build the impulse of a band-limited step for each sub-sample phase. Each kernel sums to exactly KERNEL_UNITY so that
+///        integrating the output never drifts.
+/// @return Kernel for each phase.
+KernelTable BuildKernels()
+{
+    constexpr int halfWidth = Audio::BlipBuffer::KERNEL_WIDTH / 2;
+    KernelTable kernels;
+
+    for (size_t phase = 0; phase < Audio::BlipBuffer::PHASE_COUNT; ++phase)
+    {
+        std::array<double, Audio::BlipBuffer::KERNEL_WIDTH> impulse;
+        double sum = 0.0;
+
+        for (size_t tap = 0; tap < Audio::BlipBuffer::KERNEL_WIDTH; ++tap)
+        {
+            double x = static_cast<double>(tap) - (halfWidth - 1) - (static_cast<double>(phase) / Audio::BlipBuffer::PHASE_COUNT);
+            double angle = std::numbers::pi * 2.0 * CUTOFF * x;
+            double sinc = (angle == 0.0) ? 1.0 : (std::sin(angle) / angle);
+            double window = 0.42 + (0.5 * std::cos(std::numbers::pi * x / halfWidth)) +
+                            (0.08 * std::cos(2.0 * std::numbers::pi * x / halfWidth));
+            impulse[tap] = sinc * window;
+            sum += impulse[tap];
+        }
+
+        int32_t roundedSum = 0;
+        size_t largestTap = 0;
+
+        for (size_t tap = 0; tap < Audio::BlipBuffer::KERNEL_WIDTH; ++tap)
+        {
+            kernels[phase][tap] = static_cast<int32_t>(std::lround(impulse[tap] * KERNEL_UNITY / sum));
+            roundedSum += kernels[phase][tap];
+
+            if (kernels[phase][tap] > kernels[phase][largestTap])
+            {
+                largestTap = tap;
+            }
+        }
+
+        kernels[phase][largestTap] += KERNEL_UNITY - roundedSum;
+    }
+
+    return kernels;
+}
+
+KernelTable const& Kernels()
+{
+    static KernelTable const kernels = BuildKernels();
+    return kernels;
+}
+}
+
+namespace Audio
+{
+BlipBuffer::BlipBuffer(size_t capacity) :
+    buffer_((capacity + KERNEL_WIDTH) * 2, 0),
+    capacity_(capacity),
+    baseFactor_(0),
+    factor_(0),
+    offset_(0),
+    integrators_({0, 0})
+{
+    Kernels();
+}
+
+void BlipBuffer::SetSampleRate(int sampleRate)
+{
+    baseFactor_ = (static_cast<uint64_t>(sampleRate) << FRAC_BITS) / CPU::CPU_FREQUENCY_HZ;
+    factor_ = baseFactor_;
+    Clear();
+}
+
+void BlipBuffer::SetRateAdjustment(double ratio)
+{
+    factor_ = static_cast<uint64_t>(std::llround(baseFactor_ * ratio));
+}
+
+void BlipBuffer::Clear()
+{
+    std::fill(buffer_.begin(), buffer_.end(), 0);
+    offset_ = 0;
+    integrators_ = {0, 0};
+}
+
+void BlipBuffer::AddDelta(uint32_t clocks, int leftDelta, int rightDelta)
+{
+    uint64_t time = offset_ + (clocks * factor_);
+    size_t index = time >> FRAC_BITS;
+
+    if (index >= capacity_)
+    {
+        return;
+    }
+
+    size_t phase = (time >> (FRAC_BITS - PHASE_BITS)) & (PHASE_COUNT - 1);
+    auto const& kernel = Kernels()[phase];
+    int32_t* output = &buffer_[index * 2];
+
+    // Fixed width multiply-add over contiguous taps, which the compiler vectorizes
+    for (size_t tap = 0; tap < KERNEL_WIDTH; ++tap)
+    {
+        output[tap * 2] += kernel[tap] * leftDelta;
+        output[(tap * 2) + 1] += kernel[tap] * rightDelta;
+    }
+}
+
+size_t BlipBuffer::SamplesAvailable(uint32_t clocks) const
+{
+    return (offset_ + (clocks * factor_)) >> FRAC_BITS;
+}
+
+void BlipBuffer::EndFrame(uint32_t clocks)
+{
+    offset_ += clocks * factor_;
+}
+
+size_t BlipBuffer::ReadSamples(float* buffer, size_t cnt, float gain)
+{
+    size_t available = std::min(SamplesAvailable(), capacity_);
+    cnt = std::min(cnt, available);
+    float scale = gain / KERNEL_UNITY;
+
+    // Integrate in place. Each output depends on the previous one, so this pass is kept to plain integer adds.
+    auto [left, right] = integrators_;
+
+    for (size_t i = 0; i < cnt; ++i)
+    {
+        left += buffer_[i * 2];
+        right += buffer_[(i * 2) + 1];
+        buffer_[i * 2] = left;
+        buffer_[(i * 2) + 1] = right;
+    }
+
+    integrators_ = {left, right};
+
+    // Convert to float in a separate pass over contiguous memory so that it vectorizes
+    for (size_t i = 0; i < (cnt * 2); ++i)
+    {
+        buffer[i] = buffer_[i] * scale;
+    }
+
+    // Move the unread samples and tails of recent steps to the front of the buffer
+    size_t remaining = ((available - cnt) + KERNEL_WIDTH) * 2;
+    std::memmove(buffer_.data(), &buffer_[cnt * 2], remaining * sizeof(int32_t));
+    std::fill(buffer_.begin() + remaining, buffer_.begin() + remaining + (cnt * 2), 0);
+    offset_ -= static_cast<uint64_t>(cnt) << FRAC_BITS;
+    return cnt;
+}
+}
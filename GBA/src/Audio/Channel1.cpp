@@ -2,26 +2,23 @@
 #include <algorithm>
 #include <array>
 #include <cstdint>
-#include <functional>
 #include <utility>
 #include <Audio/Constants.hpp>
 #include <Audio/Registers.hpp>
 #include <System/EventScheduler.hpp>
 #include <System/MemoryMap.hpp>
 #include <Utilities/MemoryUtilities.hpp>
+#include <Utilities/StateSerializer.hpp>
 
 namespace Audio
 {
-Channel1::Channel1() :
+Channel1::Channel1(EventScheduler const& scheduler) :
     channel1Registers_(),
     sound1cnt_l_(*reinterpret_cast<SOUND1CNT_L*>(&channel1Registers_[0])),
     sound1cnt_h_(*reinterpret_cast<SOUND1CNT_H*>(&channel1Registers_[2])),
-    sound1cnt_x_(*reinterpret_cast<SOUND1CNT_X*>(&channel1Registers_[4]))
+    sound1cnt_x_(*reinterpret_cast<SOUND1CNT_X*>(&channel1Registers_[4])),
+    scheduler_(scheduler)
 {
-    Scheduler.RegisterEvent(EventType::Channel1Clock, std::bind(&Clock, this, std::placeholders::_1));
-    Scheduler.RegisterEvent(EventType::Channel1Envelope, std::bind(&Envelope, this, std::placeholders::_1));
-    Scheduler.RegisterEvent(EventType::Channel1LengthTimer, std::bind(&LengthTimer, this, std::placeholders::_1));
-    Scheduler.RegisterEvent(EventType::Channel1FrequencySweep, std::bind(&FrequencySweep, this, std::placeholders::_1));
 }
 
 void Channel1::Reset()
@@ -34,10 +31,25 @@ void Channel1::Reset()
     lengthTimerExpired_ = false;
     frequencyOverflow_ = false;
 
-    Scheduler.UnscheduleEvent(EventType::Channel1Clock);
-    Scheduler.UnscheduleEvent(EventType::Channel1Envelope);
-    Scheduler.UnscheduleEvent(EventType::Channel1LengthTimer);
-    Scheduler.UnscheduleEvent(EventType::Channel1FrequencySweep);
+    nextClockCycle_ = MAX_U64;
+    nextEnvelopeCycle_ = MAX_U64;
+    lengthTimerCycle_ = MAX_U64;
+    nextSweepCycle_ = MAX_U64;
+}
+
+void Channel1::Serialize(StateSerializer& state)
+{
+    state.Value(channel1Registers_);
+    state.Value(envelopeIncrease_);
+    state.Value(envelopePace_);
+    state.Value(currentVolume_);
+    state.Value(dutyCycleIndex_);
+    state.Value(lengthTimerExpired_);
+    state.Value(frequencyOverflow_);
+    state.Value(nextClockCycle_);
+    state.Value(nextEnvelopeCycle_);
+    state.Value(lengthTimerCycle_);
+    state.Value(nextSweepCycle_);
 }
 
 std::pair<uint32_t, bool> Channel1::ReadReg(uint32_t addr, AccessSize alignment)
@@ -47,6 +59,7 @@ std::pair<uint32_t, bool> Channel1::ReadReg(uint32_t addr, AccessSize alignment)
         return {0, false};
     }
 
+    Update(scheduler_.TotalCycles());
     size_t index = addr - CHANNEL_1_ADDR_MIN;
     uint8_t* bytePtr = &channel1Registers_.at(index);
     uint32_t value = ReadPointer(bytePtr, alignment);
@@ -55,6 +68,7 @@ std::pair<uint32_t, bool> Channel1::ReadReg(uint32_t addr, AccessSize alignment)
 
 bool Channel1::WriteReg(uint32_t addr, uint32_t value, AccessSize alignment)
 {
+    Update(scheduler_.TotalCycles());
     size_t index = addr - CHANNEL_1_ADDR_MIN;
     uint8_t* bytePtr = &channel1Registers_.at(index);
     WritePointer(bytePtr, value, alignment);
@@ -70,8 +84,10 @@ bool Channel1::WriteReg(uint32_t addr, uint32_t value, AccessSize alignment)
     return triggered;
 }
 
-uint8_t Channel1::Sample()
+uint8_t Channel1::Sample(uint64_t cycle)
 {
+    Update(cycle);
+
     if (lengthTimerExpired_ || frequencyOverflow_)
     {
         return 0;
@@ -80,8 +96,46 @@ uint8_t Channel1::Sample()
     return currentVolume_ * DUTY_CYCLE[sound1cnt_h_.waveDuty][dutyCycleIndex_];
 }
 
+void Channel1::Update(uint64_t cycle)
+{
+    while (!lengthTimerExpired_ && !frequencyOverflow_)
+    {
+        uint64_t nextEventCycle = std::min({nextEnvelopeCycle_, lengthTimerCycle_, nextSweepCycle_});
+
+        if (std::min(nextClockCycle_, nextEventCycle) > cycle)
+        {
+            break;
+        }
+
+        if (nextClockCycle_ <= nextEventCycle)
+        {
+            // The period only changes on a frequency sweep or register write, so every duty cycle step up until the next event
+            // is evenly spaced. Steps take priority over other events that happen on the same cycle.
+            uint64_t lastCycle = std::min(cycle, nextEventCycle);
+            uint64_t interval = (0x800 - sound1cnt_x_.period) * CPU_CYCLES_PER_GB_CYCLE;
+            uint64_t steps = ((lastCycle - nextClockCycle_) / interval) + 1;
+            dutyCycleIndex_ = (dutyCycleIndex_ + steps) % 8;
+            nextClockCycle_ += steps * interval;
+        }
+        else if (nextEnvelopeCycle_ == nextEventCycle)
+        {
+            Envelope();
+        }
+        else if (lengthTimerCycle_ == nextEventCycle)
+        {
+            lengthTimerExpired_ = true;
+        }
+        else
+        {
+            FrequencySweep();
+        }
+    }
+}
+
 void Channel1::Start()
 {
+    uint64_t currentCycle = scheduler_.TotalCycles();
+
     // Set latched registers
     envelopeIncrease_ = sound1cnt_h_.direction;
     envelopePace_ = sound1cnt_h_.pace;
@@ -92,49 +146,27 @@ void Channel1::Start()
     lengthTimerExpired_ = false;
     frequencyOverflow_ = false;
 
-    // Unschedule any existing events
-    Scheduler.UnscheduleEvent(EventType::Channel1Clock);
-    Scheduler.UnscheduleEvent(EventType::Channel1Envelope);
-    Scheduler.UnscheduleEvent(EventType::Channel1LengthTimer);
-    Scheduler.UnscheduleEvent(EventType::Channel1FrequencySweep);
-
-    // Schedule relevant events
-    Scheduler.ScheduleEvent(EventType::Channel1Clock, ((0x800 - sound1cnt_x_.period) * CPU_CYCLES_PER_GB_CYCLE));
+    // Set timers
+    nextClockCycle_ = currentCycle + ((0x800 - sound1cnt_x_.period) * CPU_CYCLES_PER_GB_CYCLE);
+    nextEnvelopeCycle_ = MAX_U64;
+    lengthTimerCycle_ = MAX_U64;
 
     if (sound1cnt_h_.pace != 0)
     {
-        Scheduler.ScheduleEvent(EventType::Channel1Envelope, envelopePace_ * CPU_CYCLES_PER_ENVELOPE_SWEEP);
+        nextEnvelopeCycle_ = currentCycle + (envelopePace_ * CPU_CYCLES_PER_ENVELOPE_SWEEP);
     }
 
     if (sound1cnt_x_.lengthEnable)
     {
-        int cyclesUntilEvent = (64 - sound1cnt_h_.initialLengthTimer) * CPU_CYCLES_PER_SOUND_LENGTH;
-        Scheduler.ScheduleEvent(EventType::Channel1LengthTimer, cyclesUntilEvent);
+        lengthTimerCycle_ = currentCycle + ((64 - sound1cnt_h_.initialLengthTimer) * CPU_CYCLES_PER_SOUND_LENGTH);
     }
 
     uint8_t sweepPace = std::max(sound1cnt_l_.pace, static_cast<uint16_t>(1));
-    Scheduler.ScheduleEvent(EventType::Channel1FrequencySweep, sweepPace * CPU_CYCLES_PER_FREQUENCY_SWEEP);
+    nextSweepCycle_ = currentCycle + (sweepPace * CPU_CYCLES_PER_FREQUENCY_SWEEP);
 }
 
-void Channel1::Clock(int extraCycles)
+void Channel1::Envelope()
 {
-    if (lengthTimerExpired_ || frequencyOverflow_)
-    {
-        return;
-    }
-
-    dutyCycleIndex_ = (dutyCycleIndex_ + 1) % 8;
-    int cyclesUntilNextEvent =  ((0x800 - sound1cnt_x_.period) * CPU_CYCLES_PER_GB_CYCLE) - extraCycles;
-    Scheduler.ScheduleEvent(EventType::Channel1Clock, cyclesUntilNextEvent);
-}
-
-void Channel1::Envelope(int extraCycles)
-{
-    if (lengthTimerExpired_ || frequencyOverflow_)
-    {
-        return;
-    }
-
     bool reschedule = true;
 
     if (envelopeIncrease_ && (currentVolume_ < 0x0F))
@@ -152,18 +184,16 @@ void Channel1::Envelope(int extraCycles)
 
     if (reschedule)
     {
-        int cyclesUntilNextEvent = (envelopePace_ * CPU_CYCLES_PER_ENVELOPE_SWEEP) - extraCycles;
-        Scheduler.ScheduleEvent(EventType::Channel1Envelope, cyclesUntilNextEvent);
+        nextEnvelopeCycle_ += envelopePace_ * CPU_CYCLES_PER_ENVELOPE_SWEEP;
     }
-}
-
-void Channel1::FrequencySweep(int extraCycles)
-{
-    if (lengthTimerExpired_ || frequencyOverflow_)
+    else
     {
-        return;
+        nextEnvelopeCycle_ = MAX_U64;
     }
+}
 
+void Channel1::FrequencySweep()
+{
     uint16_t currentPeriod = sound1cnt_x_.period;
     uint16_t delta = currentPeriod / (0x01 << sound1cnt_l_.step);
     uint16_t updatedPeriod = 0;
@@ -196,11 +226,6 @@ void Channel1::FrequencySweep(int extraCycles)
     }
 
     sweepPace = std::max(sweepPace, static_cast<uint8_t>(1));
-
-    if (!frequencyOverflow_)
-    {
-        int cyclesUntilNextEvent = (sweepPace * CPU_CYCLES_PER_FREQUENCY_SWEEP) - extraCycles;
-        Scheduler.ScheduleEvent(EventType::Channel1FrequencySweep, cyclesUntilNextEvent);
-    }
+    nextSweepCycle_ += sweepPace * CPU_CYCLES_PER_FREQUENCY_SWEEP;
 }
 }
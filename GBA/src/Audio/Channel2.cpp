@@ -1,24 +1,23 @@
 #include <Audio/Channel2.hpp>
+#include <algorithm>
 #include <array>
 #include <cstdint>
-#include <functional>
 #include <utility>
 #include <Audio/Constants.hpp>
 #include <Audio/Registers.hpp>
 #include <System/EventScheduler.hpp>
 #include <System/MemoryMap.hpp>
 #include <Utilities/MemoryUtilities.hpp>
+#include <Utilities/StateSerializer.hpp>
 
 namespace Audio
 {
-Channel2::Channel2() :
+Channel2::Channel2(EventScheduler const& scheduler) :
     channel2Registers_(),
     sound2cnt_l_(*reinterpret_cast<SOUND2CNT_L*>(&channel2Registers_[0])),
-    sound2cnt_h_(*reinterpret_cast<SOUND2CNT_H*>(&channel2Registers_[4]))
+    sound2cnt_h_(*reinterpret_cast<SOUND2CNT_H*>(&channel2Registers_[4])),
+    scheduler_(scheduler)
 {
-    Scheduler.RegisterEvent(EventType::Channel2Clock, std::bind(&Clock, this, std::placeholders::_1));
-    Scheduler.RegisterEvent(EventType::Channel2Envelope, std::bind(&Envelope, this, std::placeholders::_1));
-    Scheduler.RegisterEvent(EventType::Channel2LengthTimer, std::bind(&LengthTimer, this, std::placeholders::_1));
 }
 
 void Channel2::Reset()
@@ -30,9 +29,22 @@ void Channel2::Reset()
     dutyCycleIndex_ = 0;
     lengthTimerExpired_ = false;
 
-    Scheduler.UnscheduleEvent(EventType::Channel2Clock);
-    Scheduler.UnscheduleEvent(EventType::Channel2Envelope);
-    Scheduler.UnscheduleEvent(EventType::Channel2LengthTimer);
+    nextClockCycle_ = MAX_U64;
+    nextEnvelopeCycle_ = MAX_U64;
+    lengthTimerCycle_ = MAX_U64;
+}
+
+void Channel2::Serialize(StateSerializer& state)
+{
+    state.Value(channel2Registers_);
+    state.Value(envelopeIncrease_);
+    state.Value(envelopePace_);
+    state.Value(currentVolume_);
+    state.Value(dutyCycleIndex_);
+    state.Value(lengthTimerExpired_);
+    state.Value(nextClockCycle_);
+    state.Value(nextEnvelopeCycle_);
+    state.Value(lengthTimerCycle_);
 }
 
 std::pair<uint32_t, bool> Channel2::ReadReg(uint32_t addr, AccessSize alignment)
@@ -45,6 +57,7 @@ std::pair<uint32_t, bool> Channel2::ReadReg(uint32_t addr, AccessSize alignment)
         return {0, false};
     }
 
+    Update(scheduler_.TotalCycles());
     size_t index = addr - CHANNEL_2_ADDR_MIN;
     uint8_t* bytePtr = &channel2Registers_.at(index);
     uint32_t value = ReadPointer(bytePtr, alignment);
@@ -53,6 +66,7 @@ std::pair<uint32_t, bool> Channel2::ReadReg(uint32_t addr, AccessSize alignment)
 
 bool Channel2::WriteReg(uint32_t addr, uint32_t value, AccessSize alignment)
 {
+    Update(scheduler_.TotalCycles());
     size_t index = addr - CHANNEL_2_ADDR_MIN;
     uint8_t* bytePtr = &channel2Registers_.at(index);
     WritePointer(bytePtr, value, alignment);
@@ -68,8 +82,10 @@ bool Channel2::WriteReg(uint32_t addr, uint32_t value, AccessSize alignment)
     return triggered;
 }
 
-uint8_t Channel2::Sample()
+uint8_t Channel2::Sample(uint64_t cycle)
 {
+    Update(cycle);
+
     if (lengthTimerExpired_)
     {
         return 0;
@@ -80,6 +96,8 @@ uint8_t Channel2::Sample()
 
 void Channel2::Start()
 {
+    uint64_t currentCycle = scheduler_.TotalCycles();
+
     // Set latched registers
     envelopeIncrease_ = sound2cnt_l_.direction;
     envelopePace_ = sound2cnt_l_.pace;
@@ -89,45 +107,56 @@ void Channel2::Start()
     dutyCycleIndex_ = 0;
     lengthTimerExpired_ = false;
 
-    // Unschedule any existing events
-    Scheduler.UnscheduleEvent(EventType::Channel2Clock);
-    Scheduler.UnscheduleEvent(EventType::Channel2Envelope);
-    Scheduler.UnscheduleEvent(EventType::Channel2LengthTimer);
-
-    // Schedule relevant events
-    Scheduler.ScheduleEvent(EventType::Channel2Clock, ((0x800 - sound2cnt_h_.period) * CPU_CYCLES_PER_GB_CYCLE));
+    // Set timers
+    nextClockCycle_ = currentCycle + ((0x800 - sound2cnt_h_.period) * CPU_CYCLES_PER_GB_CYCLE);
+    nextEnvelopeCycle_ = MAX_U64;
+    lengthTimerCycle_ = MAX_U64;
 
     if (sound2cnt_l_.pace != 0)
     {
-        Scheduler.ScheduleEvent(EventType::Channel2Envelope, envelopePace_ * CPU_CYCLES_PER_ENVELOPE_SWEEP);
+        nextEnvelopeCycle_ = currentCycle + (envelopePace_ * CPU_CYCLES_PER_ENVELOPE_SWEEP);
     }
 
     if (sound2cnt_h_.lengthEnable)
     {
-        int cyclesUntilEvent = (64 - sound2cnt_l_.initialLengthTimer) * CPU_CYCLES_PER_SOUND_LENGTH;
-        Scheduler.ScheduleEvent(EventType::Channel2LengthTimer, cyclesUntilEvent);
+        lengthTimerCycle_ = currentCycle + ((64 - sound2cnt_l_.initialLengthTimer) * CPU_CYCLES_PER_SOUND_LENGTH);
     }
 }
 
-void Channel2::Clock(int extraCycles)
+void Channel2::Update(uint64_t cycle)
 {
-    if (lengthTimerExpired_)
+    while (!lengthTimerExpired_)
     {
-        return;
+        uint64_t nextEventCycle = std::min(nextEnvelopeCycle_, lengthTimerCycle_);
+
+        if (std::min(nextClockCycle_, nextEventCycle) > cycle)
+        {
+            break;
+        }
+
+        if (nextClockCycle_ <= nextEventCycle)
+        {
+            // The period only changes on a register write, so every duty cycle step up until the next event is evenly spaced.
+            // Steps take priority over other events that happen on the same cycle.
+            uint64_t lastCycle = std::min(cycle, nextEventCycle);
+            uint64_t interval = (0x800 - sound2cnt_h_.period) * CPU_CYCLES_PER_GB_CYCLE;
+            uint64_t steps = ((lastCycle - nextClockCycle_) / interval) + 1;
+            dutyCycleIndex_ = (dutyCycleIndex_ + steps) % 8;
+            nextClockCycle_ += steps * interval;
+        }
+        else if (nextEnvelopeCycle_ == nextEventCycle)
+        {
+            Envelope();
+        }
+        else
+        {
+            lengthTimerExpired_ = true;
+        }
     }
-
-    dutyCycleIndex_ = (dutyCycleIndex_ + 1) % 8;
-    int cyclesUntilNextEvent =  ((0x800 - sound2cnt_h_.period) * CPU_CYCLES_PER_GB_CYCLE) - extraCycles;
-    Scheduler.ScheduleEvent(EventType::Channel2Clock, cyclesUntilNextEvent);
 }
 
-void Channel2::Envelope(int extraCycles)
+void Channel2::Envelope()
 {
-    if (lengthTimerExpired_)
-    {
-        return;
-    }
-
     bool reschedule = true;
 
     if (envelopeIncrease_ && (currentVolume_ < 0x0F))
@@ -145,8 +174,11 @@ void Channel2::Envelope(int extraCycles)
 
     if (reschedule)
     {
-        int cyclesUntilNextEvent = (envelopePace_ * CPU_CYCLES_PER_ENVELOPE_SWEEP) - extraCycles;
-        Scheduler.ScheduleEvent(EventType::Channel2Envelope, cyclesUntilNextEvent);
+        nextEnvelopeCycle_ += envelopePace_ * CPU_CYCLES_PER_ENVELOPE_SWEEP;
+    }
+    else
+    {
+        nextEnvelopeCycle_ = MAX_U64;
     }
 }
 }
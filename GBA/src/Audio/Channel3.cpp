@@ -0,0 +1,178 @@
+#include <Audio/Channel3.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <Audio/Constants.hpp>
+#include <Audio/Registers.hpp>
+#include <System/EventScheduler.hpp>
+#include <System/MemoryMap.hpp>
+#include <Utilities/MemoryUtilities.hpp>
+#include <Utilities/StateSerializer.hpp>
+
+namespace Audio
+{
+Channel3::Channel3(EventScheduler const& scheduler) :
+    channel3Registers_(),
+    sound3cnt_l_(*reinterpret_cast<SOUND3CNT_L*>(&channel3Registers_[0])),
+    sound3cnt_h_(*reinterpret_cast<SOUND3CNT_H*>(&channel3Registers_[2])),
+    sound3cnt_x_(*reinterpret_cast<SOUND3CNT_X*>(&channel3Registers_[4])),
+    scheduler_(scheduler)
+{
+}
+
+void Channel3::Reset()
+{
+    channel3Registers_.fill(0);
+
+    for (auto& bank : waveRam_)
+    {
+        bank.fill(0);
+    }
+
+    playbackBank_ = 0;
+    digitIndex_ = 0;
+    lengthTimerExpired_ = false;
+
+    nextClockCycle_ = MAX_U64;
+    lengthTimerCycle_ = MAX_U64;
+}
+
+void Channel3::Serialize(StateSerializer& state)
+{
+    state.Value(channel3Registers_);
+    state.Value(waveRam_);
+    state.Value(playbackBank_);
+    state.Value(digitIndex_);
+    state.Value(lengthTimerExpired_);
+    state.Value(nextClockCycle_);
+    state.Value(lengthTimerCycle_);
+}
+
+std::pair<uint32_t, bool> Channel3::ReadReg(uint32_t addr, AccessSize alignment)
+{
+    if (((addr == 0x0400'0074) && (alignment == AccessSize::WORD)) || (addr >= 0x0400'0076))
+    {
+        return {0, false};
+    }
+
+    size_t index = addr - CHANNEL_3_ADDR_MIN;
+    uint8_t* bytePtr = &channel3Registers_.at(index);
+    uint32_t value = ReadPointer(bytePtr, alignment);
+    return {value, false};
+}
+
+bool Channel3::WriteReg(uint32_t addr, uint32_t value, AccessSize alignment)
+{
+    Update(scheduler_.TotalCycles());
+    size_t index = addr - CHANNEL_3_ADDR_MIN;
+    uint8_t* bytePtr = &channel3Registers_.at(index);
+    WritePointer(bytePtr, value, alignment);
+
+    bool triggered = sound3cnt_x_.trigger;
+
+    if (triggered)
+    {
+        sound3cnt_x_.trigger = 0;
+        Start();
+    }
+
+    return triggered && sound3cnt_l_.playback;
+}
+
+uint32_t Channel3::ReadWaveRam(uint32_t addr, AccessSize alignment)
+{
+    size_t index = addr - WAVE_RAM_ADDR_MIN;
+    uint8_t* bytePtr = &waveRam_[sound3cnt_l_.bankNumber ^ 0x01].at(index);
+    return ReadPointer(bytePtr, alignment);
+}
+
+void Channel3::WriteWaveRam(uint32_t addr, uint32_t value, AccessSize alignment)
+{
+    Update(scheduler_.TotalCycles());
+    size_t index = addr - WAVE_RAM_ADDR_MIN;
+    uint8_t* bytePtr = &waveRam_[sound3cnt_l_.bankNumber ^ 0x01].at(index);
+    WritePointer(bytePtr, value, alignment);
+}
+
+uint8_t Channel3::Sample(uint64_t cycle)
+{
+    Update(cycle);
+
+    if (Expired())
+    {
+        return 0;
+    }
+
+    // Digits are played from the upper nibble of each byte first. In two bank mode, playback moves on to the other bank after
+    // the first 32 digits.
+    uint8_t bank = playbackBank_ ^ ((digitIndex_ >= 32) ? 0x01 : 0x00);
+    uint8_t digitPair = waveRam_[bank][(digitIndex_ & 0x1F) >> 1];
+    uint8_t digit = (digitIndex_ & 0x01) ? (digitPair & 0x0F) : (digitPair >> 4);
+
+    if (sound3cnt_h_.forceVolume)
+    {
+        return (digit * 3) >> 2;
+    }
+
+    switch (sound3cnt_h_.volume)
+    {
+        case 0:
+            return 0;
+        case 1:
+            return digit;
+        case 2:
+            return digit >> 1;
+        case 3:
+            return digit >> 2;
+        default:
+            return 0;
+    }
+}
+
+void Channel3::Update(uint64_t cycle)
+{
+    while (!lengthTimerExpired_)
+    {
+        if (std::min(nextClockCycle_, lengthTimerCycle_) > cycle)
+        {
+            break;
+        }
+
+        if (nextClockCycle_ <= lengthTimerCycle_)
+        {
+            // The sample rate only changes on a register write, so every step through wave RAM up until the length timer expires
+            // is evenly spaced. Steps take priority over the length timer if they happen on the same cycle.
+            uint64_t lastCycle = std::min(cycle, lengthTimerCycle_);
+            uint64_t interval = StepCycles();
+            uint64_t steps = ((lastCycle - nextClockCycle_) / interval) + 1;
+            uint8_t digitCount = sound3cnt_l_.dimension ? 64 : 32;
+            digitIndex_ = (digitIndex_ + steps) % digitCount;
+            nextClockCycle_ += steps * interval;
+        }
+        else
+        {
+            lengthTimerExpired_ = true;
+        }
+    }
+}
+
+void Channel3::Start()
+{
+    uint64_t currentCycle = scheduler_.TotalCycles();
+
+    // Set initial status
+    playbackBank_ = sound3cnt_l_.bankNumber;
+    digitIndex_ = 0;
+    lengthTimerExpired_ = false;
+
+    // Set timers
+    nextClockCycle_ = currentCycle + StepCycles();
+    lengthTimerCycle_ = MAX_U64;
+
+    if (sound3cnt_x_.lengthEnable)
+    {
+        lengthTimerCycle_ = currentCycle + ((256 - sound3cnt_h_.soundLength) * CPU_CYCLES_PER_SOUND_LENGTH);
+    }
+}
+}
@@ -1,24 +1,23 @@
 #include <Audio/Channel4.hpp>
+#include <algorithm>
 #include <array>
 #include <cstdint>
-#include <functional>
 #include <utility>
 #include <Audio/Constants.hpp>
 #include <Audio/Registers.hpp>
 #include <System/EventScheduler.hpp>
 #include <System/MemoryMap.hpp>
 #include <Utilities/MemoryUtilities.hpp>
+#include <Utilities/StateSerializer.hpp>
 
 namespace Audio
 {
-Channel4::Channel4() :
+Channel4::Channel4(EventScheduler const& scheduler) :
     channel4Registers_(),
     sound4cnt_l_(*reinterpret_cast<SOUND4CNT_L*>(&channel4Registers_[0])),
-    sound4cnt_h_(*reinterpret_cast<SOUND4CNT_H*>(&channel4Registers_[4]))
+    sound4cnt_h_(*reinterpret_cast<SOUND4CNT_H*>(&channel4Registers_[4])),
+    scheduler_(scheduler)
 {
-    Scheduler.RegisterEvent(EventType::Channel4Clock, std::bind(&Clock, this, std::placeholders::_1));
-    Scheduler.RegisterEvent(EventType::Channel4Envelope, std::bind(&Envelope, this, std::placeholders::_1));
-    Scheduler.RegisterEvent(EventType::Channel4LengthTimer, std::bind(&LengthTimer, this, std::placeholders::_1));
 }
 
 void Channel4::Reset()
@@ -29,9 +28,22 @@ void Channel4::Reset()
     currentVolume_ = 0;
     lengthTimerExpired_ = false;
 
-    Scheduler.UnscheduleEvent(EventType::Channel4Clock);
-    Scheduler.UnscheduleEvent(EventType::Channel4Envelope);
-    Scheduler.UnscheduleEvent(EventType::Channel4LengthTimer);
+    nextClockCycle_ = MAX_U64;
+    nextEnvelopeCycle_ = MAX_U64;
+    lengthTimerCycle_ = MAX_U64;
+}
+
+void Channel4::Serialize(StateSerializer& state)
+{
+    state.Value(channel4Registers_);
+    state.Value(envelopeIncrease_);
+    state.Value(envelopePace_);
+    state.Value(currentVolume_);
+    state.Value(lengthTimerExpired_);
+    state.Value(lsfr_);
+    state.Value(nextClockCycle_);
+    state.Value(nextEnvelopeCycle_);
+    state.Value(lengthTimerCycle_);
 }
 
 std::pair<uint32_t, bool> Channel4::ReadReg(uint32_t addr, AccessSize alignment)
@@ -44,6 +56,7 @@ std::pair<uint32_t, bool> Channel4::ReadReg(uint32_t addr, AccessSize alignment)
         return {0, false};
     }
 
+    Update(scheduler_.TotalCycles());
     size_t index = addr - CHANNEL_4_ADDR_MIN;
     uint8_t* bytePtr = &channel4Registers_.at(index);
     uint32_t value = ReadPointer(bytePtr, alignment);
@@ -52,6 +65,7 @@ std::pair<uint32_t, bool> Channel4::ReadReg(uint32_t addr, AccessSize alignment)
 
 bool Channel4::WriteReg(uint32_t addr, uint32_t value, AccessSize alignment)
 {
+    Update(scheduler_.TotalCycles());
     size_t index = addr - CHANNEL_4_ADDR_MIN;
     uint8_t* bytePtr = &channel4Registers_.at(index);
     WritePointer(bytePtr, value, alignment);
@@ -67,8 +81,10 @@ bool Channel4::WriteReg(uint32_t addr, uint32_t value, AccessSize alignment)
     return triggered;
 }
 
-uint8_t Channel4::Sample()
+uint8_t Channel4::Sample(uint64_t cycle)
 {
+    Update(cycle);
+
     if (lengthTimerExpired_)
     {
         return 0;
@@ -79,6 +95,8 @@ uint8_t Channel4::Sample()
 
 void Channel4::Start()
 {
+    uint64_t currentCycle = scheduler_.TotalCycles();
+
     // Set latched registers
     envelopeIncrease_ = sound4cnt_l_.direction;
     envelopePace_ = sound4cnt_l_.pace;
@@ -87,54 +105,63 @@ void Channel4::Start()
     currentVolume_ = sound4cnt_l_.initialVolume;
     lengthTimerExpired_ = false;
 
-    // Unschedule any existing events
-    Scheduler.UnscheduleEvent(EventType::Channel4Clock);
-    Scheduler.UnscheduleEvent(EventType::Channel4Envelope);
-    Scheduler.UnscheduleEvent(EventType::Channel4LengthTimer);
-
-    // Schedule relevant events
-    Scheduler.ScheduleEvent(EventType::Channel4Clock, EventCycles());
+    // Set timers
+    nextClockCycle_ = currentCycle + EventCycles();
+    nextEnvelopeCycle_ = MAX_U64;
+    lengthTimerCycle_ = MAX_U64;
 
     if (envelopePace_ != 0)
     {
-        Scheduler.ScheduleEvent(EventType::Channel4Envelope, envelopePace_ * CPU_CYCLES_PER_ENVELOPE_SWEEP);
+        nextEnvelopeCycle_ = currentCycle + (envelopePace_ * CPU_CYCLES_PER_ENVELOPE_SWEEP);
     }
 
     if (sound4cnt_h_.lengthEnable)
     {
-        int cyclesUntilEvent = (64 - sound4cnt_l_.initialLengthTimer) * CPU_CYCLES_PER_SOUND_LENGTH;
-        Scheduler.ScheduleEvent(EventType::Channel4LengthTimer, cyclesUntilEvent);
+        lengthTimerCycle_ = currentCycle + ((64 - sound4cnt_l_.initialLengthTimer) * CPU_CYCLES_PER_SOUND_LENGTH);
     }
 
     lsfr_ = 0xFFFF;
 }
 
-void Channel4::Clock(int extraCycles)
+void Channel4::Update(uint64_t cycle)
 {
-    if (lengthTimerExpired_)
-    {
-        return;
-    }
-
-    uint16_t result = (lsfr_ & 0x0001) ^ ((lsfr_ & 0x0002) >> 1);
-    lsfr_ = (lsfr_ & 0x7FFF) | (result << 15);
-
-    if (sound4cnt_h_.countWidth)
+    while (!lengthTimerExpired_)
     {
-        lsfr_ = (lsfr_ & 0xFF7F) | (result << 7);
+        uint64_t nextEventCycle = std::min(nextEnvelopeCycle_, lengthTimerCycle_);
+
+        if (std::min(nextClockCycle_, nextEventCycle) > cycle)
+        {
+            break;
+        }
+
+        if (nextClockCycle_ <= nextEventCycle)
+        {
+            // The frequency only changes on a register write, so every shift up until the next event is evenly spaced. Shifts
+            // take priority over other events that happen on the same cycle.
+            uint64_t lastCycle = std::min(cycle, nextEventCycle);
+            uint64_t interval = EventCycles();
+            uint64_t steps = ((lastCycle - nextClockCycle_) / interval) + 1;
+
+            for (uint64_t i = 0; i < steps; ++i)
+            {
+                StepLfsr();
+            }
+
+            nextClockCycle_ += steps * interval;
+        }
+        else if (nextEnvelopeCycle_ == nextEventCycle)
+        {
+            Envelope();
+        }
+        else
+        {
+            lengthTimerExpired_ = true;
+        }
     }
-
-    lsfr_ >>= 1;
-    Scheduler.ScheduleEvent(EventType::Channel4Clock, EventCycles() - extraCycles);
 }
 
-void Channel4::Envelope(int extraCycles)
+void Channel4::Envelope()
 {
-    if (lengthTimerExpired_)
-    {
-        return;
-    }
-
     bool reschedule = true;
 
     if (envelopeIncrease_ && (currentVolume_ < 0x0F))
@@ -152,9 +179,25 @@ void Channel4::Envelope(int extraCycles)
 
     if (reschedule)
     {
-        int cyclesUntilNextEvent = (envelopePace_ * CPU_CYCLES_PER_ENVELOPE_SWEEP) - extraCycles;
-        Scheduler.ScheduleEvent(EventType::Channel4Envelope, cyclesUntilNextEvent);
+        nextEnvelopeCycle_ += envelopePace_ * CPU_CYCLES_PER_ENVELOPE_SWEEP;
+    }
+    else
+    {
+        nextEnvelopeCycle_ = MAX_U64;
+    }
+}
+
+void Channel4::StepLfsr()
+{
+    uint16_t result = (lsfr_ & 0x0001) ^ ((lsfr_ & 0x0002) >> 1);
+    lsfr_ = (lsfr_ & 0x7FFF) | (result << 15);
+
+    if (sound4cnt_h_.countWidth)
+    {
+        lsfr_ = (lsfr_ & 0xFF7F) | (result << 7);
     }
+
+    lsfr_ >>= 1;
 }
 
 int Channel4::EventCycles() const
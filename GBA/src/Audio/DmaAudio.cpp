@@ -1,10 +1,12 @@
 #include <Audio/DmaAudio.hpp>
+#include <cstddef>
 #include <cstdint>
 #include <utility>
 #include <Audio/Registers.hpp>
 #include <System/MemoryMap.hpp>
 #include <Utilities/CircularBuffer.hpp>
 #include <Utilities/MemoryUtilities.hpp>
+#include <Utilities/StateSerializer.hpp>
 
 namespace Audio
 {
@@ -22,6 +24,14 @@ void DmaAudio::Reset()
     fifoBSample_ = 0;
 }
 
+void DmaAudio::Serialize(StateSerializer& state)
+{
+    state.Value(fifoA_);
+    state.Value(fifoB_);
+    state.Value(fifoASample_);
+    state.Value(fifoBSample_);
+}
+
 std::pair<uint32_t, bool> DmaAudio::ReadReg(uint32_t addr, AccessSize alignment)
 {
     (void)addr;
@@ -43,34 +53,51 @@ void DmaAudio::WriteReg(uint32_t addr, uint32_t value, AccessSize alignment)
     }
 }
 
-std::pair<bool, bool> DmaAudio::TimerOverflow(int timerIndex)
+void DmaAudio::PushSamples(uint32_t addr, uint8_t const* samples, size_t sampleCount)
+{
+    DmaSoundFifo& fifo = (addr < FIFO_B_ADDR) ? fifoA_ : fifoB_;
+
+    for (size_t i = 0; (i < sampleCount) && !fifo.Full(); ++i)
+    {
+        fifo.Push(static_cast<int8_t>(samples[i]));
+    }
+}
+
+std::pair<bool, bool> DmaAudio::TimerOverflow(int timerIndex, int overflowCount)
 {
     bool replenishA = false;
     bool replenishB = false;
 
     if (soundcnt_h_.dmaTimerSelectA == timerIndex)
     {
-        if (!fifoA_.Empty())
-        {
-            fifoASample_ = fifoA_.Pop();
-        }
-
-        replenishA = (fifoA_.Size() < 17);
+        replenishA = FifoPop(fifoA_, fifoASample_, overflowCount);
     }
 
     if (soundcnt_h_.dmaTimerSelectB == timerIndex)
     {
-        if (!fifoB_.Empty())
-        {
-            fifoBSample_ = fifoB_.Pop();
-        }
-
-        replenishB = (fifoB_.Size() < 17);
+        replenishB = FifoPop(fifoB_, fifoBSample_, overflowCount);
     }
 
     return {replenishA, replenishB};
 }
 
+uint8_t DmaAudio::TimerMask(bool fifoADma, bool fifoBDma) const
+{
+    uint8_t timerMask = 0;
+
+    if (fifoADma || soundcnt_h_.dmaEnableRightA || soundcnt_h_.dmaEnableLeftA)
+    {
+        timerMask |= (1 << soundcnt_h_.dmaTimerSelectA);
+    }
+
+    if (fifoBDma || soundcnt_h_.dmaEnableRightB || soundcnt_h_.dmaEnableLeftB)
+    {
+        timerMask |= (1 << soundcnt_h_.dmaTimerSelectB);
+    }
+
+    return timerMask;
+}
+
 std::pair<int16_t, int16_t> DmaAudio::Sample() const
 {
     int16_t sampleA = (soundcnt_h_.dmaVolumeA ? (fifoASample_ * 4) : (fifoASample_ * 2));
@@ -105,4 +132,15 @@ void DmaAudio::FifoPush(DmaSoundFifo& fifo, uint32_t value, size_t sampleCount)
         --sampleCount;
     }
 }
+
+bool DmaAudio::FifoPop(DmaSoundFifo& fifo, int8_t& sample, int popCount)
+{
+    while ((popCount > 0) && !fifo.Empty())
+    {
+        sample = fifo.Pop();
+        --popCount;
+    }
+
+    return fifo.Size() < 17;
+}
 }
@@ -1,98 +1,297 @@
 #include <CPU/ARM7TDMI.hpp>
+#include <algorithm>
+#include <array>
 #include <cstdint>
+#include <limits>
 #include <stdexcept>
 #include <utility>
 #include <CPU/ArmInstructions.hpp>
-#include <CPU/CPUTypes.hpp>
+#include <CPU/BlockCache.hpp>
+#include <CPU/CpuTypes.hpp>
 #include <CPU/ThumbInstructions.hpp>
+#include <Config.hpp>
 #include <Logging/Logging.hpp>
+#include <Profiling/Profiler.hpp>
 #include <System/EventScheduler.hpp>
-#include <Utilities/CircularBuffer.hpp>
-#include <Utilities/Functor.hpp>
+#include <System/GameBoyAdvance.hpp>
 #include <Utilities/MemoryUtilities.hpp>
+#include <Utilities/StateSerializer.hpp>
 
 namespace CPU
 {
 using namespace Logging;
 
-ARM7TDMI::ARM7TDMI(MemReadCallback readCallback, MemWriteCallback writeCallback) :
-    ReadMemory(readCallback),
-    WriteMemory(writeCallback),
-    flushPipeline_(false)
+ARM7TDMI::ARM7TDMI(GameBoyAdvance& gba, EventScheduler& scheduler, LogManager& log) :
+    gba_(gba),
+    scheduler_(scheduler),
+    log_(log),
+    executeStage_({0, 0}),
+    decodeStage_({0, 0}),
+    flushPipeline_(true),
+    decodeStageEmpty_(false),
+    exitBlock_(false),
+    idleLoopAddr_(NO_IDLE_LOOP),
+    idleLoopDetected_(false),
+    memoryWritten_(false),
+    volatileRead_(false),
+    biosHleEnabled_(false)
 {
 }
 
 void ARM7TDMI::Reset()
 {
-    pipeline_.Clear();
-    flushPipeline_ = false;
+    executeStage_ = {0, 0};
+    decodeStage_ = {0, 0};
+    flushPipeline_ = true;
+    decodeStageEmpty_ = false;
+    blockCache_.Clear();
+    exitBlock_ = false;
+    idleLoopAddr_ = NO_IDLE_LOOP;
+    idleLoopDetected_ = false;
     registers_.Reset();
-
-    mnemonic_ = "";
-    regString_ = "";
 }
 
 void ARM7TDMI::Step(bool irqPending)
 {
     if (irqPending && !registers_.IsIrqDisabled())
     {
+        blockCache_.AbortRecording();
         IRQ();
     }
 
     bool armMode = registers_.GetOperatingState() == OperatingState::ARM;
     AccessSize alignment = armMode ? AccessSize::WORD : AccessSize::HALFWORD;
+    bool cpuLogging = log_.CpuLoggingEnabled();
+
+    if (flushPipeline_)
+    {
+        RefillPipeline(alignment);
+        return;
+    }
+
+    // Run a cached block if one starts at the next instruction to execute
+    if (!cpuLogging)
+    {
+        Block* block = blockCache_.Lookup(executeStage_.addr_, !armMode);
+
+        if (block != nullptr)
+        {
+            if (blockCache_.Recording())
+            {
+                blockCache_.FinishRecording();
+            }
+
+            RunBlock(*block);
+            return;
+        }
+    }
 
     // Fetch
+    uint64_t startCycle = scheduler_.TotalCycles();
     uint32_t fetchedPC = registers_.GetPC();
     auto [fetchedInstruction, cycles] = ReadMemory(fetchedPC, alignment);
-    pipeline_.Push({fetchedInstruction, fetchedPC});
-    Scheduler.Step(cycles);
+    scheduler_.Step(cycles);
 
     // Decode and execute
-    if (pipeline_.Full())
+    auto [undecodedInstruction, executedPC] = executeStage_;
+    executeStage_ = decodeStage_;
+    decodeStage_ = {fetchedInstruction, fetchedPC};
+
+    // Any instruction executed outside of a cached block breaks up a potential idle loop
+    idleLoopAddr_ = NO_IDLE_LOOP;
+
+    if (cpuLogging)
     {
-        auto [undecodedInstruction, executedPC] = pipeline_.Pop();
+        std::array<uint32_t, 16> registers;
 
-        if (LogMgr.CpuLoggingEnabled())
+        for (uint8_t i = 0; i < 16; ++i)
         {
-            regString_ = registers_.SetRegistersString();
+            registers[i] = registers_.ReadRegister(i);
         }
 
-        Instruction* instruction = nullptr;
+        log_.LogInstruction(executedPC, undecodedInstruction, registers, registers_.GetCPSR(), registers_.GetSPSR());
+    }
 
-        if (armMode)
-        {
-            instruction = ARM::DecodeInstruction(undecodedInstruction, instructionBuffer_);
-        }
-        else
-        {
-            instruction = THUMB::DecodeInstruction(undecodedInstruction, instructionBuffer_);
-        }
+    InstructionHandler handler = armMode ? ARM::LookupHandler(undecodedInstruction) :
+                                           THUMB::LookupHandler(static_cast<uint16_t>(undecodedInstruction));
+
+    bool pcHooked = gba_.hooks_.HasPcHooks() && gba_.hooks_.PcHookOnPage(executedPC);
+
+    if (pcHooked)
+    {
+        // Code on hooked pages is never cached, so every instruction on them comes through here
+        blockCache_.AbortRecording();
+        gba_.CheckPcHooks(executedPC);
+    }
+
+    if (!cpuLogging && !pcHooked && !blockCache_.Recording() && BlockCache::Cacheable(executedPC))
+    {
+        blockCache_.StartRecording(executedPC, !armMode, {undecodedInstruction, executeStage_.opcode_, fetchedInstruction});
+    }
+
+    handler(*this, undecodedInstruction);
+
+    if constexpr (PROFILER_ENABLED)
+    {
+        gba_.profiler_.RecordInstruction(executedPC, scheduler_.TotalCycles() - startCycle);
+    }
+
+    if (blockCache_.Recording())
+    {
+        blockCache_.Record(executedPC, handler, undecodedInstruction, fetchedInstruction, flushPipeline_);
+    }
+
+    if (!flushPipeline_)
+    {
+        registers_.AdvancePC();
+    }
+}
+
+void ARM7TDMI::RefillPipeline(AccessSize alignment)
+{
+    if (!decodeStageEmpty_)
+    {
+        uint32_t fetchedPC = registers_.GetPC();
+        auto [fetchedInstruction, cycles] = ReadMemory(fetchedPC, alignment);
+        executeStage_ = {fetchedInstruction, fetchedPC};
+        registers_.AdvancePC();
+        scheduler_.AdvanceCycles(cycles);
 
-        if (instruction != nullptr)
+        if (scheduler_.EventReady())
         {
-            instruction->Execute(*this);
+            scheduler_.CheckEventQueue();
+            decodeStageEmpty_ = true;
+            return;
         }
-        else
+    }
+
+    uint32_t fetchedPC = registers_.GetPC();
+    auto [fetchedInstruction, cycles] = ReadMemory(fetchedPC, alignment);
+    decodeStage_ = {fetchedInstruction, fetchedPC};
+    registers_.AdvancePC();
+    flushPipeline_ = false;
+    decodeStageEmpty_ = false;
+    scheduler_.Step(cycles);
+}
+
+void ARM7TDMI::RunUntilNextEvent()
+{
+    // Events scheduled earlier than this while running can only come from I/O writes, which set exitBlock_, or from callbacks of
+    // events that fired mid-instruction, which means this cycle has already been reached.
+    uint64_t nextEventCycle = scheduler_.NextEventCycle();
+    exitBlock_ = false;
+    idleLoopDetected_ = false;
+
+    do
+    {
+        Step(scheduler_.GetPendingIRQ());
+    } while (!exitBlock_ && !idleLoopDetected_ && (scheduler_.TotalCycles() < nextEventCycle));
+}
+
+void ARM7TDMI::FlushBlockCache()
+{
+    blockCache_.Clear();
+    idleLoopAddr_ = NO_IDLE_LOOP;
+}
+
+void ARM7TDMI::Serialize(StateSerializer& state)
+{
+    state.Value(executeStage_);
+    state.Value(decodeStage_);
+    state.Value(flushPipeline_);
+    state.Value(decodeStageEmpty_);
+    state.Value(exitBlock_);
+    registers_.Serialize(state);
+
+    if (state.Loading())
+    {
+        // Blocks in work RAM were decoded from memory that was just replaced, and idle loops are detected from cached blocks.
+        // States only load on the same ROM, so blocks decoded from ROM and BIOS still hold.
+        blockCache_.InvalidateWorkRam();
+        idleLoopAddr_ = NO_IDLE_LOOP;
+        idleLoopDetected_ = false;
+    }
+}
+
+void ARM7TDMI::InvalidateBlocks(uint32_t addr, AccessSize alignment)
+{
+    if (blockCache_.Invalidate(addr, alignment))
+    {
+        exitBlock_ = true;
+    }
+}
+
+void ARM7TDMI::InvalidateBlocks(uint32_t addr, uint32_t length)
+{
+    if (blockCache_.InvalidateRange(addr, length))
+    {
+        exitBlock_ = true;
+    }
+}
+
+void ARM7TDMI::ReadMemoryBurst(uint32_t addr, uint32_t* values, uint32_t count)
+{
+    uint32_t index = 0;
+
+    // Each burst ends on the word that an event fires after, so events interleave with the words the same way they would if
+    // every word was read individually
+    while (index < count)
+    {
+        auto [words, cycles] = gba_.ReadMemoryBurst(addr + (index * 4), values + index, count - index, CyclesUntilNextEvent());
+
+        if (words == 0)
         {
-            throw std::runtime_error("Unable to decode instruction");
+            break;
         }
 
-        if (LogMgr.CpuLoggingEnabled())
+        scheduler_.Step(cycles);
+        index += words;
+    }
+
+    for (; index < count; ++index)
+    {
+        auto [value, cycles] = ReadMemory<AccessSize::WORD>(addr + (index * 4));
+        scheduler_.Step(cycles);
+        values[index] = value;
+    }
+}
+
+void ARM7TDMI::WriteMemoryBurst(uint32_t addr, uint32_t const* values, uint32_t count)
+{
+    memoryWritten_ = true;
+    uint32_t index = 0;
+
+    while (index < count)
+    {
+        auto [words, cycles] = gba_.WriteMemoryBurst(addr + (index * 4), values + index, count - index, CyclesUntilNextEvent());
+
+        if (words == 0)
         {
-            LogMgr.LogInstruction(executedPC, mnemonic_, regString_);
+            break;
         }
+
+        scheduler_.Step(cycles);
+        index += words;
     }
 
-    if (flushPipeline_)
+    for (; index < count; ++index)
     {
-        pipeline_.Clear();
-        flushPipeline_ = false;
+        int cycles = WriteMemory<AccessSize::WORD>(addr + (index * 4), values[index]);
+        scheduler_.Step(cycles);
     }
-    else
+}
+
+int ARM7TDMI::CyclesUntilNextEvent() const
+{
+    uint64_t currentCycle = scheduler_.TotalCycles();
+    uint64_t nextEventCycle = scheduler_.NextEventCycle();
+
+    if (nextEventCycle <= currentCycle)
     {
-        registers_.AdvancePC();
+        return 1;
     }
+
+    return static_cast<int>(std::min<uint64_t>(nextEventCycle - currentCycle, std::numeric_limits<int>::max()));
 }
 
 bool ARM7TDMI::ArmConditionSatisfied(uint8_t condition)
@@ -139,22 +338,11 @@ bool ARM7TDMI::ArmConditionSatisfied(uint8_t condition)
 void ARM7TDMI::IRQ()
 {
     uint32_t currentCPSR = registers_.GetCPSR();
-    uint32_t savedPC = 0;
+    uint32_t savedPC = ((flushPipeline_ && !decodeStageEmpty_) ? registers_.GetPC() : executeStage_.addr_) + 4;
 
-    if (pipeline_.Empty())
+    if (log_.CpuLoggingEnabled())
     {
-        savedPC = registers_.GetPC();
-    }
-    else
-    {
-        savedPC = pipeline_.Peak().second;
-    }
-
-    savedPC += 4;
-
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        LogMgr.LogIRQ();
+        log_.LogIRQ();
     }
 
     registers_.SetOperatingState(OperatingState::ARM);
@@ -163,6 +351,103 @@ void ARM7TDMI::IRQ()
     registers_.SetIrqDisabled(true);
     registers_.SetSPSR(currentCPSR);
     registers_.SetPC(IRQ_VECTOR);
-    pipeline_.Clear();
+    flushPipeline_ = true;
+    decodeStageEmpty_ = false;
+}
+
+void ARM7TDMI::RunBlock(Block& block)
+{
+    AccessSize alignment = block.thumb_ ? AccessSize::HALFWORD : AccessSize::WORD;
+    uint32_t width = BlockCache::InstructionWidth(block);
+    size_t length = block.instructions_.size();
+    size_t index = 0;
+    uint64_t fetchCycles = 0;
+
+    // Work RAM timing can only change through an I/O write, which ends the block, so its access time holds for the whole block
+    uint64_t pageFetchCycles = gba_.pageTable_[block.startAddr_ >> PAGE_SHIFT].cycles_[alignment == AccessSize::WORD];
+    exitBlock_ = false;
+    memoryWritten_ = false;
+    volatileRead_ = false;
+
+    if (block.startAddr_ != idleLoopAddr_)
+    {
+        idleLoopAddr_ = NO_IDLE_LOOP;
+    }
+
+    while (true)
+    {
+        uint64_t startCycle = scheduler_.TotalCycles();
+
+        if (block.fetchFromBus_)
+        {
+            fetchCycles = ReadMemory(registers_.GetPC(), alignment).second;
+        }
+        else
+        {
+            fetchCycles = pageFetchCycles;
+        }
+
+        scheduler_.AdvanceCycles(fetchCycles);
+        CachedInstruction const& cachedInstruction = block.instructions_[index];
+        cachedInstruction.handler_(*this, cachedInstruction.instruction_);
+
+        if constexpr (PROFILER_ENABLED)
+        {
+            gba_.profiler_.RecordInstruction(block.startAddr_ + (index * width), scheduler_.TotalCycles() - startCycle);
+        }
+
+        ++index;
+
+        if (flushPipeline_)
+        {
+            if ((index == length) && (registers_.GetPC() == block.startAddr_))
+            {
+                CheckIdleLoop(block);
+            }
+
+            return;
+        }
+
+        registers_.AdvancePC();
+
+        if ((index == length) || exitBlock_ || !block.valid_ || scheduler_.EventReady() ||
+            (scheduler_.GetPendingIRQ() && !registers_.IsIrqDisabled()))
+        {
+            break;
+        }
+    }
+
+    // The two instructions already in the pipeline were part of this block, so refill the pipeline from the block on exit.
+    uint32_t nextAddr = block.startAddr_ + (index * width);
+    executeStage_ = {block.opcodes_[index], nextAddr};
+    decodeStage_ = {block.opcodes_[index + 1], nextAddr + width};
+}
+
+void ARM7TDMI::CheckIdleLoop(Block const& block)
+{
+    if ((block.instructions_.size() > MAX_IDLE_LOOP_LENGTH) || memoryWritten_ || volatileRead_ ||
+        (scheduler_.GetPendingIRQ() && !registers_.IsIrqDisabled()))
+    {
+        idleLoopAddr_ = NO_IDLE_LOOP;
+        return;
+    }
+
+    std::array<uint32_t, 17> state;
+
+    for (uint8_t i = 0; i < 16; ++i)
+    {
+        state[i] = registers_.ReadRegister(i);
+    }
+
+    state[16] = registers_.GetCPSR();
+
+    if ((idleLoopAddr_ == block.startAddr_) && (state == idleLoopState_))
+    {
+        idleLoopDetected_ = true;
+        return;
+    }
+
+    idleLoopAddr_ = block.startAddr_;
+    idleLoopState_ = state;
 }
 }
@@ -1,77 +1,29 @@
 #include <CPU/ArmInstructions.hpp>
+#include <array>
 #include <bit>
 #include <cmath>
 #include <cstdint>
+#include <stdexcept>
+#include <tuple>
 #include <utility>
 #include <CPU/ARM7TDMI.hpp>
 #include <CPU/CpuTypes.hpp>
 #include <Logging/Logging.hpp>
 #include <System/EventScheduler.hpp>
+#include <System/GameBoyAdvance.hpp>
 #include <System/SystemControl.hpp>
 
 namespace
 {
-/// @brief Determine the result of the overflow flag for addition operation: result = op1 + op2
-/// @param op1 Addition operand
-/// @param op2 Addition operand
-/// @param result Addition result
-/// @return State of overflow flag after addition
-bool AdditionOverflow(uint32_t op1, uint32_t op2, uint32_t result)
-{
-    return (~(op1 ^ op2) & ((op1 ^ result)) & MSB_32) != 0;
-}
-
-/// @brief Determine the result of the overflow flag for subtraction operation: result = op1 - op2
-/// @param op1 Subtraction operand
-/// @param op2 Subtraction operand
-/// @param result Subtraction result
-/// @return State of overflow flag after subtraction
-bool SubtractionOverflow(uint32_t op1, uint32_t op2, uint32_t result)
-{
-    return ((op1 ^ op2) & ((op1 ^ result)) & MSB_32) != 0;
-}
-
-/// @brief Calculate the result of a THUMB add or add w/ carry operation, along with the carry and overflow flags.
+/// @brief Calculate op1 + op2 + carry, which is how every ARM addition and subtraction is performed. Subtraction of the form
+///        op1 - op2 - !C is calculated as op1 + ~op2 + C.
 /// @param op1 First addition operand.
 /// @param op2 Second addition operand.
-/// @param result Result of addition, returned by reference.
-/// @param carry Carry flag, defaults to 0 meaning non ADC operation.
-/// @return Pair of {carry_flag, overflow_flag}.
-std::pair<bool, bool> Add32(uint32_t op1, uint32_t op2, uint32_t& result, bool carry = 0)
+/// @param carry Carry into addition.
+/// @return Result of addition.
+uint32_t AddWithCarry(uint32_t op1, uint32_t op2, bool carry)
 {
-    uint64_t result64 = static_cast<uint64_t>(op1) + static_cast<uint64_t>(op2) + static_cast<uint64_t>(carry);
-    result = result64 & MAX_U32;
-    bool c = (result64 > MAX_U32);
-    bool v = AdditionOverflow(op1, op2, result);
-    return {c, v};
-}
-
-/// @brief Calculate the result of a THUMB sub or sub w/ carry operation, along with the carry and overflow flags.
-/// @param op1 First subtraction operand.
-/// @param op2 Second subtraction operand.
-/// @param result Result of subtraction (op1 - op2), returned by reference.
-/// @param sbc Whether this is a subtract with carry operation.
-/// @param carry Current value of carry flag.
-/// @return Pair of {carry_flag, overflow_flag}.
-std::pair<bool, bool> Sub32(uint32_t op1, uint32_t op2, uint32_t& result, bool sbc = false, bool carry = 0)
-{
-    uint64_t result64;
-    bool c;
-
-    if (sbc)
-    {
-        result64 = static_cast<uint64_t>(op1) + static_cast<uint64_t>(~op2) + static_cast<uint64_t>(carry);
-        c = (result64 > MAX_U32);
-    }
-    else
-    {
-        result64 = static_cast<uint64_t>(op1) + static_cast<uint64_t>(~op2 + 1);
-        c = op1 >= op2;
-    }
-
-    result = result64 & MAX_U32;
-    bool v = SubtractionOverflow(op1, op2, result);
-    return {c, v};
+    return op1 + op2 + (carry ? 1 : 0);
 }
 }
 
@@ -79,77 +31,146 @@ namespace CPU::ARM
 {
 using namespace Logging;
 
-CPU::Instruction* DecodeInstruction(uint32_t undecodedInstruction, void* buffer)
+namespace
 {
-    CPU::Instruction* instructionPtr = nullptr;
+/// @brief Construct an instruction of a specific class and execute it. Since the concrete type is known, the call to
+///        Execute is resolved statically.
+/// @tparam T ARM instruction class.
+/// @param cpu Reference to the ARM CPU.
+/// @param undecodedInstruction 32-bit ARM instruction.
+template <typename T>
+void ExecuteHandler(ARM7TDMI& cpu, uint32_t undecodedInstruction)
+{
+    T(undecodedInstruction).Execute(cpu);
+}
 
+/// @brief Handler for bit patterns that do not match any ARM instruction format.
+void DecodeFailure(ARM7TDMI&, uint32_t)
+{
+    throw std::runtime_error("Unable to decode instruction");
+}
+
+/// @brief Decode a 32 bit value into the handler for its ARM instruction class.
+/// @param undecodedInstruction 32 bit value to decode.
+/// @return Handler that executes the decoded instruction.
+constexpr InstructionHandler DecodeHandler(uint32_t undecodedInstruction)
+{
     if (BranchAndExchange::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) BranchAndExchange(undecodedInstruction);
+        return &ExecuteHandler<BranchAndExchange>;
     }
     else if (BlockDataTransfer::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) BlockDataTransfer(undecodedInstruction);
+        return &ExecuteHandler<BlockDataTransfer>;
     }
     else if (Branch::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) Branch(undecodedInstruction);
+        return &ExecuteHandler<Branch>;
     }
     else if (SoftwareInterrupt::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) SoftwareInterrupt(undecodedInstruction);
+        return &ExecuteHandler<SoftwareInterrupt>;
     }
     else if (Undefined::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) Undefined(undecodedInstruction);
+        return &ExecuteHandler<Undefined>;
     }
     else if (SingleDataTransfer::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) SingleDataTransfer(undecodedInstruction);
+        return &ExecuteHandler<SingleDataTransfer>;
     }
     else if (SingleDataSwap::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) SingleDataSwap(undecodedInstruction);
+        return &ExecuteHandler<SingleDataSwap>;
     }
     else if (Multiply::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) Multiply(undecodedInstruction);
+        return &ExecuteHandler<Multiply>;
     }
     else if (MultiplyLong::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) MultiplyLong(undecodedInstruction);
+        return &ExecuteHandler<MultiplyLong>;
     }
     else if (HalfwordDataTransferRegisterOffset::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) HalfwordDataTransferRegisterOffset(undecodedInstruction);
+        return &ExecuteHandler<HalfwordDataTransferRegisterOffset>;
     }
     else if (HalfwordDataTransferImmediateOffset::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) HalfwordDataTransferImmediateOffset(undecodedInstruction);
+        return &ExecuteHandler<HalfwordDataTransferImmediateOffset>;
     }
     else if (PSRTransferMRS::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) PSRTransferMRS(undecodedInstruction);
+        return &ExecuteHandler<PSRTransferMRS>;
     }
     else if (PSRTransferMSR::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) PSRTransferMSR(undecodedInstruction);
+        return &ExecuteHandler<PSRTransferMSR>;
     }
     else if (DataProcessing::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) DataProcessing(undecodedInstruction);
+        return &ExecuteHandler<DataProcessing>;
     }
 
-    return instructionPtr;
+    return &DecodeFailure;
 }
 
-void BranchAndExchange::Execute(ARM7TDMI& cpu)
+/// @brief Handler for decode table entries whose instruction class depends on bits outside of the table index. Falls back
+///        to fully decoding the instruction.
+/// @param cpu Reference to the ARM CPU.
+/// @param undecodedInstruction 32-bit ARM instruction.
+void AmbiguousHandler(ARM7TDMI& cpu, uint32_t undecodedInstruction)
+{
+    DecodeHandler(undecodedInstruction)(cpu, undecodedInstruction);
+}
+
+/// @brief Build the ARM decode table. Each entry is indexed by bits 27-20 and 7-4 of an instruction. The remaining bits
+///        that some formats check (19-8) are tested with all-zero, all-one, and mixed nibbles. If every combination
+///        decodes to the same class the entry points directly to that class's handler, otherwise it falls back to a full
+///        decode.
+/// @return Table of instruction handlers.
+constexpr std::array<InstructionHandler, ARM_DECODE_TABLE_SIZE> BuildDecodeTable()
 {
-    if (LogMgr.CpuLoggingEnabled())
+    constexpr std::array<uint32_t, 3> nibbles = {0x0, 0xF, 0x1};
+    std::array<InstructionHandler, ARM_DECODE_TABLE_SIZE> table = {};
+
+    for (uint32_t index = 0; index < ARM_DECODE_TABLE_SIZE; ++index)
     {
-        SetMnemonic(cpu.mnemonic_);
+        uint32_t base = ((index & 0x0FF0) << 16) | ((index & 0x000F) << 4);
+        InstructionHandler handler = DecodeHandler(base);
+
+        for (uint32_t rn : nibbles)
+        {
+            for (uint32_t rd : nibbles)
+            {
+                for (uint32_t rs : nibbles)
+                {
+                    uint32_t instruction = base | (rn << 16) | (rd << 12) | (rs << 8);
+
+                    if (DecodeHandler(instruction) != handler)
+                    {
+                        handler = &AmbiguousHandler;
+                    }
+                }
+            }
+        }
+
+        table[index] = handler;
     }
 
+    return table;
+}
+
+constexpr std::array<InstructionHandler, ARM_DECODE_TABLE_SIZE> DECODE_TABLE = BuildDecodeTable();
+}
+
+InstructionHandler LookupHandler(uint32_t undecodedInstruction)
+{
+    return DECODE_TABLE[((undecodedInstruction >> 16) & 0x0FF0) | ((undecodedInstruction >> 4) & 0x000F)];
+}
+
+void BranchAndExchange::Execute(ARM7TDMI& cpu)
+{
     if (!cpu.ArmConditionSatisfied(instruction_.Cond))
     {
         return;
@@ -174,11 +195,6 @@ void BranchAndExchange::Execute(ARM7TDMI& cpu)
 
 void BlockDataTransfer::Execute(ARM7TDMI& cpu)
 {
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_);
-    }
-
     if (!cpu.ArmConditionSatisfied(instruction_.Cond))
     {
         return;
@@ -269,18 +285,18 @@ void BlockDataTransfer::Execute(ARM7TDMI& cpu)
         }
     }
 
+    std::array<uint32_t, 16> values;
     uint8_t regIndex = 0;
-    uint32_t addr = minAddr;
+    uint32_t count = 0;
 
-    while (regList != 0)
+    if (instruction_.L)
     {
-        if (regList & 0x01)
+        cpu.ReadMemoryBurst(minAddr, values.data(), regListSize);
+
+        while (regList != 0)
         {
-            if (instruction_.L)
+            if (regList & 0x01)
             {
-                auto [readValue, readCycles] = cpu.ReadMemory(addr, AccessSize::WORD);
-                Scheduler.Step(readCycles);
-
                 if (regIndex == PC_INDEX)
                 {
                     cpu.flushPipeline_ = true;
@@ -291,9 +307,18 @@ void BlockDataTransfer::Execute(ARM7TDMI& cpu)
                     }
                 }
 
-                cpu.registers_.WriteRegister(regIndex, readValue, mode);
+                cpu.registers_.WriteRegister(regIndex, values[count++], mode);
             }
-            else
+
+            ++regIndex;
+            regList >>= 1;
+        }
+    }
+    else
+    {
+        while (regList != 0)
+        {
+            if (regList & 0x01)
             {
                 uint32_t regValue = cpu.registers_.ReadRegister(regIndex, mode);
 
@@ -306,15 +331,14 @@ void BlockDataTransfer::Execute(ARM7TDMI& cpu)
                     regValue = wbAddr;
                 }
 
-                int writeCycles = cpu.WriteMemory(addr, regValue, AccessSize::WORD);
-                Scheduler.Step(writeCycles);
+                values[count++] = regValue;
             }
 
-            addr += 4;
+            ++regIndex;
+            regList >>= 1;
         }
 
-        ++regIndex;
-        regList >>= 1;
+        cpu.WriteMemoryBurst(minAddr, values.data(), regListSize);
     }
 
     if (instruction_.W && !(wbIndexInList && instruction_.L))
@@ -325,7 +349,7 @@ void BlockDataTransfer::Execute(ARM7TDMI& cpu)
     if (instruction_.L)
     {
         // Run 1 extra internal cycle for final write back of load operation.
-        Scheduler.Step(1);
+        cpu.scheduler_.Step(1);
     }
 }
 
@@ -335,11 +359,6 @@ void Branch::Execute(ARM7TDMI& cpu)
     int32_t signedOffset = SignExtend32(unsignedOffset, 25);
     uint32_t newPC = cpu.registers_.GetPC() + signedOffset;
 
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_, newPC);
-    }
-
     if (!cpu.ArmConditionSatisfied(instruction_.Cond))
     {
         return;
@@ -356,12 +375,13 @@ void Branch::Execute(ARM7TDMI& cpu)
 
 void SoftwareInterrupt::Execute(ARM7TDMI& cpu)
 {
-    if (LogMgr.CpuLoggingEnabled())
+    if (!cpu.ArmConditionSatisfied(instruction_.Cond))
     {
-        SetMnemonic(cpu.mnemonic_);
+        return;
     }
 
-    if (!cpu.ArmConditionSatisfied(instruction_.Cond))
+    // The BIOS function number is in the upper byte of the comment field
+    if (cpu.biosHleEnabled_ && cpu.HleSoftwareInterrupt(instruction_.CommentField >> 16))
     {
         return;
     }
@@ -377,11 +397,6 @@ void SoftwareInterrupt::Execute(ARM7TDMI& cpu)
 
 void Undefined::Execute(ARM7TDMI& cpu)
 {
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_);
-    }
-
     if (!cpu.ArmConditionSatisfied(instruction_.Cond))
     {
         return;
@@ -454,11 +469,6 @@ void SingleDataTransfer::Execute(ARM7TDMI& cpu)
         }
     }
 
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_, offset);
-    }
-
     if (!cpu.ArmConditionSatisfied(instruction_.flags.Cond))
     {
         return;
@@ -486,7 +496,7 @@ void SingleDataTransfer::Execute(ARM7TDMI& cpu)
         // Load
         AccessSize alignment = instruction_.flags.B ? AccessSize::BYTE : AccessSize::WORD;
         auto [value, readCycles] = cpu.ReadMemory(addr, alignment);
-        Scheduler.Step(readCycles);
+        cpu.scheduler_.Step(readCycles);
 
         if ((alignment == AccessSize::WORD) && (addr & 0x03))
         {
@@ -516,7 +526,7 @@ void SingleDataTransfer::Execute(ARM7TDMI& cpu)
         }
 
         int writeCycles = cpu.WriteMemory(addr, value, alignment);
-        Scheduler.Step(writeCycles);
+        cpu.scheduler_.Step(writeCycles);
     }
 
     if (postIndex)
@@ -539,17 +549,12 @@ void SingleDataTransfer::Execute(ARM7TDMI& cpu)
     if (instruction_.flags.L)
     {
         // Run 1 extra internal cycle for final write back of load operation.
-        Scheduler.Step(1);
+        cpu.scheduler_.Step(1);
     }
 }
 
 void SingleDataSwap::Execute(ARM7TDMI& cpu)
 {
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_);
-    }
-
     if (!cpu.ArmConditionSatisfied(instruction_.Cond))
     {
         return;
@@ -569,16 +574,11 @@ void SingleDataSwap::Execute(ARM7TDMI& cpu)
     int writeCycles = cpu.WriteMemory(addr, regValue, alignment);
     cpu.registers_.WriteRegister(instruction_.Rd, memValue);
 
-    Scheduler.Step(readCycles + writeCycles);
+    cpu.scheduler_.Step(readCycles + writeCycles);
 }
 
 void Multiply::Execute(ARM7TDMI& cpu)
 {
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_);
-    }
-
     if (!cpu.ArmConditionSatisfied(instruction_.Cond))
     {
         return;
@@ -627,16 +627,11 @@ void Multiply::Execute(ARM7TDMI& cpu)
     }
 
     cpu.registers_.WriteRegister(destIndex, result & MAX_U32);
-    Scheduler.Step(cycles);
+    cpu.scheduler_.Step(cycles);
 }
 
 void MultiplyLong::Execute(ARM7TDMI& cpu)
 {
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_);
-    }
-
     if (!cpu.ArmConditionSatisfied(instruction_.Cond))
     {
         return;
@@ -721,7 +716,7 @@ void MultiplyLong::Execute(ARM7TDMI& cpu)
 
     cpu.registers_.WriteRegister(instruction_.RdHi, result >> 32);
     cpu.registers_.WriteRegister(instruction_.RdLo, result & MAX_U32);
-    Scheduler.Step(cycles);
+    cpu.scheduler_.Step(cycles);
 }
 
 void HalfwordDataTransferRegisterOffset::Execute(ARM7TDMI& cpu)
@@ -734,11 +729,6 @@ void HalfwordDataTransferRegisterOffset::Execute(ARM7TDMI& cpu)
     uint8_t srcDestIndex = instruction_.Rd;
     uint32_t addr = cpu.registers_.ReadRegister(baseIndex);
 
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_, offset);
-    }
-
     if (!cpu.ArmConditionSatisfied(instruction_.Cond))
     {
         return;
@@ -780,16 +770,16 @@ void HalfwordDataTransferRegisterOffset::Execute(ARM7TDMI& cpu)
             if (h)
             {
                 // S = 1, H = 1
-                auto [halfWord, readCycles] = cpu.ReadMemory(addr, AccessSize::HALFWORD);
-                Scheduler.Step(readCycles);
+                auto [halfWord, readCycles] = cpu.ReadMemory<AccessSize::HALFWORD>(addr);
+                cpu.scheduler_.Step(readCycles);
                 signExtendedWord = SignExtend32(halfWord, 15);
                 cpu.registers_.WriteRegister(srcDestIndex, signExtendedWord);
             }
             else
             {
                 // S = 1, H = 0
-                auto [byte, readCycles] = cpu.ReadMemory(addr, AccessSize::BYTE);
-                Scheduler.Step(readCycles);
+                auto [byte, readCycles] = cpu.ReadMemory<AccessSize::BYTE>(addr);
+                cpu.scheduler_.Step(readCycles);
                 signExtendedWord = SignExtend32(byte, 7);
                 cpu.registers_.WriteRegister(srcDestIndex, signExtendedWord);
             }
@@ -797,8 +787,8 @@ void HalfwordDataTransferRegisterOffset::Execute(ARM7TDMI& cpu)
         else
         {
             // S = 0, H = 1
-            auto [halfWord, readCycles] = cpu.ReadMemory(addr, AccessSize::HALFWORD);
-            Scheduler.Step(readCycles);
+            auto [halfWord, readCycles] = cpu.ReadMemory<AccessSize::HALFWORD>(addr);
+            cpu.scheduler_.Step(readCycles);
 
             if (misaligned)
             {
@@ -818,8 +808,8 @@ void HalfwordDataTransferRegisterOffset::Execute(ARM7TDMI& cpu)
             halfWord += 4;
         }
 
-        int writeCycles = cpu.WriteMemory(addr, halfWord, AccessSize::HALFWORD);
-        Scheduler.Step(writeCycles);
+        int writeCycles = cpu.WriteMemory<AccessSize::HALFWORD>(addr, halfWord);
+        cpu.scheduler_.Step(writeCycles);
     }
 
     if (postIndex)
@@ -842,7 +832,7 @@ void HalfwordDataTransferRegisterOffset::Execute(ARM7TDMI& cpu)
     if (instruction_.L)
     {
         // Run 1 extra internal cycle for final write back of load operation.
-        Scheduler.Step(1);
+        cpu.scheduler_.Step(1);
     }
 }
 
@@ -856,11 +846,6 @@ void HalfwordDataTransferImmediateOffset::Execute(ARM7TDMI& cpu)
     uint8_t srcDestIndex = instruction_.Rd;
     uint32_t addr = cpu.registers_.ReadRegister(baseIndex);
 
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_, offset);
-    }
-
     if (!cpu.ArmConditionSatisfied(instruction_.Cond))
     {
         return;
@@ -902,16 +887,16 @@ void HalfwordDataTransferImmediateOffset::Execute(ARM7TDMI& cpu)
             if (h)
             {
                 // S = 1, H = 1
-                auto [halfWord, readCycles] = cpu.ReadMemory(addr, AccessSize::HALFWORD);
-                Scheduler.Step(readCycles);
+                auto [halfWord, readCycles] = cpu.ReadMemory<AccessSize::HALFWORD>(addr);
+                cpu.scheduler_.Step(readCycles);
                 signExtendedWord = SignExtend32(halfWord, 15);
                 cpu.registers_.WriteRegister(srcDestIndex, signExtendedWord);
             }
             else
             {
                 // S = 1, H = 0
-                auto [byte, readCycles] = cpu.ReadMemory(addr, AccessSize::BYTE);
-                Scheduler.Step(readCycles);
+                auto [byte, readCycles] = cpu.ReadMemory<AccessSize::BYTE>(addr);
+                cpu.scheduler_.Step(readCycles);
                 signExtendedWord = SignExtend32(byte, 7);
                 cpu.registers_.WriteRegister(srcDestIndex, signExtendedWord);
             }
@@ -919,8 +904,8 @@ void HalfwordDataTransferImmediateOffset::Execute(ARM7TDMI& cpu)
         else
         {
             // S = 0, H = 1
-            auto [halfWord, readCycles] = cpu.ReadMemory(addr, AccessSize::HALFWORD);
-            Scheduler.Step(readCycles);
+            auto [halfWord, readCycles] = cpu.ReadMemory<AccessSize::HALFWORD>(addr);
+            cpu.scheduler_.Step(readCycles);
 
             if (misaligned)
             {
@@ -940,8 +925,8 @@ void HalfwordDataTransferImmediateOffset::Execute(ARM7TDMI& cpu)
             halfWord += 4;
         }
 
-        int writeCycles = cpu.WriteMemory(addr, halfWord, AccessSize::HALFWORD);
-        Scheduler.Step(writeCycles);
+        int writeCycles = cpu.WriteMemory<AccessSize::HALFWORD>(addr, halfWord);
+        cpu.scheduler_.Step(writeCycles);
     }
 
     if (postIndex)
@@ -964,17 +949,12 @@ void HalfwordDataTransferImmediateOffset::Execute(ARM7TDMI& cpu)
     if (instruction_.L)
     {
         // Run 1 extra internal cycle for final write back of load operation.
-        Scheduler.Step(1);
+        cpu.scheduler_.Step(1);
     }
 }
 
 void PSRTransferMRS::Execute(ARM7TDMI& cpu)
 {
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_);
-    }
-
     if (!cpu.ArmConditionSatisfied(instruction_.Cond))
     {
         return;
@@ -986,11 +966,6 @@ void PSRTransferMRS::Execute(ARM7TDMI& cpu)
 
 void PSRTransferMSR::Execute(ARM7TDMI& cpu)
 {
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_);
-    }
-
     if (!cpu.ArmConditionSatisfied(instruction_.commonFlags.Cond))
     {
         return;
@@ -1050,7 +1025,6 @@ void DataProcessing::Execute(ARM7TDMI& cpu)
     uint8_t destIndex = instruction_.flags.Rd;
 
     bool carryOut = cpu.registers_.IsCarry();
-    bool overflowOut = cpu.registers_.IsOverflow();
 
     if (instruction_.flags.I)
     {
@@ -1084,7 +1058,7 @@ void DataProcessing::Execute(ARM7TDMI& cpu)
             }
 
             // One extra internal cycles when shifting by register.
-            Scheduler.Step(1);
+            cpu.scheduler_.Step(1);
         }
 
         switch (instruction_.shiftRegByReg.ShiftType)
@@ -1190,11 +1164,6 @@ void DataProcessing::Execute(ARM7TDMI& cpu)
         }
     }
 
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_, op2);
-    }
-
     if (!cpu.ArmConditionSatisfied(instruction_.flags.Cond))
     {
         return;
@@ -1202,72 +1171,80 @@ void DataProcessing::Execute(ARM7TDMI& cpu)
 
     uint32_t result = 0;
     bool writeResult = true;
-    bool updateOverflow = true;
+    bool arithmetic = true;
+    uint32_t addOp1 = 0;
+    uint32_t addOp2 = 0;
+    bool carryIn = false;
 
     switch (instruction_.flags.OpCode)
     {
         case 0b0000:  // AND
             result = op1 & op2;
-            updateOverflow = false;
+            arithmetic = false;
             break;
         case 0b0001:  // EOR
             result = op1 ^ op2;
-            updateOverflow = false;
+            arithmetic = false;
             break;
         case 0b0010:  // SUB
-            std::tie(carryOut, overflowOut) = Sub32(op1, op2, result);
+            std::tie(addOp1, addOp2, carryIn) = std::tuple(op1, ~op2, true);
             break;
         case 0b0011:  // RSB
-            std::tie(carryOut, overflowOut) = Sub32(op2, op1, result);
+            std::tie(addOp1, addOp2, carryIn) = std::tuple(op2, ~op1, true);
             break;
         case 0b0100:  // ADD
-            std::tie(carryOut, overflowOut) = Add32(op1, op2, result);
+            std::tie(addOp1, addOp2, carryIn) = std::tuple(op1, op2, false);
             break;
         case 0b0101:  // ADC
-            std::tie(carryOut, overflowOut) = Add32(op1, op2, result, cpu.registers_.IsCarry());
+            std::tie(addOp1, addOp2, carryIn) = std::tuple(op1, op2, cpu.registers_.IsCarry());
             break;
         case 0b0110:  // SBC
-            std::tie(carryOut, overflowOut) = Sub32(op1, op2, result, true, cpu.registers_.IsCarry());
+            std::tie(addOp1, addOp2, carryIn) = std::tuple(op1, ~op2, cpu.registers_.IsCarry());
             break;
         case 0b0111:  // RSC
-            std::tie(carryOut, overflowOut) = Sub32(op2, op1, result, true, cpu.registers_.IsCarry());
+            std::tie(addOp1, addOp2, carryIn) = std::tuple(op2, ~op1, cpu.registers_.IsCarry());
             break;
         case 0b1000:  // TST
             result = op1 & op2;
-            updateOverflow = false;
+            arithmetic = false;
             writeResult = false;
             break;
         case 0b1001:  // TEQ
             result = op1 ^ op2;
-            updateOverflow = false;
+            arithmetic = false;
             writeResult = false;
             break;
         case 0b1010:  // CMP
-            std::tie(carryOut, overflowOut) = Sub32(op1, op2, result);
+            std::tie(addOp1, addOp2, carryIn) = std::tuple(op1, ~op2, true);
             writeResult = false;
             break;
         case 0b1011:  // CMN
-            std::tie(carryOut, overflowOut) = Add32(op1, op2, result);
+            std::tie(addOp1, addOp2, carryIn) = std::tuple(op1, op2, false);
             writeResult = false;
             break;
         case 0b1100:  // ORR
             result = op1 | op2;
-            updateOverflow = false;
+            arithmetic = false;
             break;
         case 0b1101:  // MOV
             result = op2;
-            updateOverflow = false;
+            arithmetic = false;
             break;
         case 0b1110:  // BIC
             result = op1 & ~op2;
-            updateOverflow = false;
+            arithmetic = false;
             break;
         case 0b1111:  // MVN
             result = ~op2;
-            updateOverflow = false;
+            arithmetic = false;
             break;
     }
 
+    if (arithmetic)
+    {
+        result = AddWithCarry(addOp1, addOp2, carryIn);
+    }
+
     if (instruction_.flags.S)
     {
         if (destIndex == PC_INDEX)
@@ -1277,13 +1254,13 @@ void DataProcessing::Execute(ARM7TDMI& cpu)
         }
         else
         {
-            cpu.registers_.SetNegative(result & MSB_32);
-            cpu.registers_.SetZero(result == 0);
-            cpu.registers_.SetCarry(carryOut);
-
-            if (updateOverflow)
+            if (arithmetic)
+            {
+                cpu.registers_.SetArithmeticFlags(addOp1, addOp2, carryIn, result);
+            }
+            else
             {
-                cpu.registers_.SetOverflow(overflowOut);
+                cpu.registers_.SetLogicalFlags(result, carryOut);
             }
         }
     }
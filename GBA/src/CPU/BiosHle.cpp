@@ -0,0 +1,520 @@
+#include <CPU/ARM7TDMI.hpp>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <numbers>
+#include <vector>
+#include <CPU/CpuTypes.hpp>
+#include <System/GameBoyAdvance.hpp>
+#include <Utilities/MemoryUtilities.hpp>
+
+namespace
+{
+// Approximate cycles spent by BIOS code, not counting the memory accesses that the native versions charge as they make them.
+// These are estimates based on the length of each function's loops, since BIOS instructions are fetched in a single cycle. They
+// are charged as each loop iteration completes, since the scheduler must never be stepped past more than one event at a time.
+constexpr int SWI_CALL_CYCLES = 40;  // SWI dispatch and return, including both pipeline refills
+constexpr int DIV_BASE_CYCLES = 20;
+constexpr int DIV_CYCLES_PER_BIT = 4;
+constexpr int SQRT_BASE_CYCLES = 20;
+constexpr int SQRT_CYCLES_PER_BIT = 8;
+constexpr int CPU_SET_CYCLES_PER_UNIT = 6;
+constexpr int CPU_FAST_SET_CYCLES_PER_BLOCK = 8;  // One LDM/STM pair moves a block of 8 words
+constexpr int AFFINE_CYCLES_PER_ENTRY = 60;
+constexpr int LZ77_CYCLES_PER_FLAG = 6;
+constexpr int LZ77_CYCLES_PER_BYTE = 8;
+constexpr int HUFF_CYCLES_PER_BIT = 10;
+constexpr int RL_CYCLES_PER_FLAG = 8;
+constexpr int RL_CYCLES_PER_BYTE = 5;
+
+// Value left on the BIOS open bus after returning from a SWI
+constexpr uint32_t BIOS_OPEN_BUS_AFTER_SWI = 0xE3A0'2004;
+
+/// @brief Get the sine table that BgAffineSet and ObjAffineSet use. Angles are in units of 1/256 of a full turn, and results
+///        have 14 fractional bits.
+/// @return Sine table.
+std::array<int16_t, 256> const& SineTable()
+{
+    static std::array<int16_t, 256> const table = []
+    {
+        std::array<int16_t, 256> sines;
+
+        for (size_t i = 0; i < sines.size(); ++i)
+        {
+            sines[i] = static_cast<int16_t>(std::lround(std::sin(i * 2.0 * std::numbers::pi / 256.0) * 0x4000));
+        }
+
+        return sines;
+    }();
+
+    return table;
+}
+
+/// @brief Calculate an affine matrix the same way the BIOS does.
+/// @param scaleX Horizontal scale, 8.8 fixed point.
+/// @param scaleY Vertical scale, 8.8 fixed point.
+/// @param angle Angle of rotation. Only the upper 8 bits are used.
+/// @return PA, PB, PC, and PD in 8.8 fixed point.
+std::array<int16_t, 4> AffineMatrix(int16_t scaleX, int16_t scaleY, uint16_t angle)
+{
+    std::array<int16_t, 256> const& sines = SineTable();
+    uint8_t theta = angle >> 8;
+    int32_t sin = sines[theta];
+    int32_t cos = sines[static_cast<uint8_t>(theta + 64)];
+
+    return {static_cast<int16_t>((scaleX * cos) >> 14),
+            static_cast<int16_t>(-((scaleX * sin) >> 14)),
+            static_cast<int16_t>((scaleY * sin) >> 14),
+            static_cast<int16_t>((scaleY * cos) >> 14)};
+}
+
+/// @brief Check whether the BIOS would refuse to copy or decompress from an address. The BIOS protects itself by ignoring
+///        requests whose source is within the BIOS region.
+/// @param src Source address.
+/// @return True if the BIOS ignores the request.
+bool ProtectedSource(uint32_t src)
+{
+    return (src & 0x0E00'0000) == 0;
+}
+}
+
+namespace CPU
+{
+bool ARM7TDMI::HleSoftwareInterrupt(uint8_t function)
+{
+    switch (function)
+    {
+        case 0x06:
+            HleDiv(false);
+            break;
+        case 0x07:
+            HleDiv(true);
+            break;
+        case 0x08:
+            HleSqrt();
+            break;
+        case 0x0B:
+            HleCpuSet();
+            break;
+        case 0x0C:
+            HleCpuFastSet();
+            break;
+        case 0x0E:
+            HleBgAffineSet();
+            break;
+        case 0x0F:
+            HleObjAffineSet();
+            break;
+        case 0x11:
+            HleLz77UnComp(AccessSize::BYTE);
+            break;
+        case 0x12:
+            HleLz77UnComp(AccessSize::HALFWORD);
+            break;
+        case 0x13:
+            if (!HleHuffUnComp())
+            {
+                return false;
+            }
+
+            break;
+        case 0x14:
+            HleRlUnComp(AccessSize::BYTE);
+            break;
+        case 0x15:
+            HleRlUnComp(AccessSize::HALFWORD);
+            break;
+        default:
+            return false;
+    }
+
+    // Return to the instruction after the SWI, refilling the pipeline as the BIOS's return would
+    uint32_t instructionWidth = (registers_.GetOperatingState() == OperatingState::ARM) ? 4 : 2;
+    registers_.SetPC(registers_.GetPC() - instructionWidth);
+    flushPipeline_ = true;
+    gba_.lastBiosFetch_ = BIOS_OPEN_BUS_AFTER_SWI;
+    scheduler_.Step(SWI_CALL_CYCLES);
+    return true;
+}
+
+void ARM7TDMI::HleDiv(bool armArguments)
+{
+    int32_t numerator = registers_.ReadRegister(armArguments ? 1 : 0);
+    int32_t denominator = registers_.ReadRegister(armArguments ? 0 : 1);
+    int32_t quotient;
+    int32_t remainder;
+
+    if (denominator == 0)
+    {
+        // The BIOS never returns when dividing anything but 0 or 1 by 0. Return something reasonable instead of hanging.
+        quotient = (numerator < 0) ? -1 : 1;
+        remainder = numerator;
+    }
+    else if ((numerator == std::numeric_limits<int32_t>::min()) && (denominator == -1))
+    {
+        quotient = numerator;
+        remainder = 0;
+    }
+    else
+    {
+        quotient = numerator / denominator;
+        remainder = numerator % denominator;
+    }
+
+    registers_.WriteRegister(0, quotient);
+    registers_.WriteRegister(1, remainder);
+    registers_.WriteRegister(3, static_cast<uint32_t>(std::abs(static_cast<int64_t>(quotient))));
+
+    int quotientBits = std::bit_width(static_cast<uint32_t>(std::abs(static_cast<int64_t>(quotient))));
+    scheduler_.Step(DIV_BASE_CYCLES + (quotientBits * DIV_CYCLES_PER_BIT));
+}
+
+void ARM7TDMI::HleSqrt()
+{
+    uint32_t value = registers_.ReadRegister(0);
+    uint32_t root = 0;
+
+    for (uint32_t bit = 1U << 15; bit != 0; bit >>= 1)
+    {
+        uint32_t candidate = root | bit;
+
+        if ((candidate * candidate) <= value)
+        {
+            root = candidate;
+        }
+    }
+
+    registers_.WriteRegister(0, root);
+    scheduler_.Step(SQRT_BASE_CYCLES + (std::bit_width(root) * SQRT_CYCLES_PER_BIT));
+}
+
+void ARM7TDMI::HleCpuSet()
+{
+    uint32_t src = registers_.ReadRegister(0);
+    uint32_t dst = registers_.ReadRegister(1);
+    uint32_t control = registers_.ReadRegister(2);
+    uint32_t count = control & 0x001F'FFFF;
+    bool fill = control & 0x0100'0000;
+    AccessSize unit = (control & 0x0400'0000) ? AccessSize::WORD : AccessSize::HALFWORD;
+    uint32_t width = static_cast<uint32_t>(unit);
+
+    if (ProtectedSource(src))
+    {
+        return;
+    }
+
+    uint32_t value = fill ? HleRead(src, unit) : 0;
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (!fill)
+        {
+            value = HleRead(src, unit);
+            src += width;
+        }
+
+        HleWrite(dst, value, unit);
+        dst += width;
+        scheduler_.Step(CPU_SET_CYCLES_PER_UNIT);
+    }
+}
+
+void ARM7TDMI::HleCpuFastSet()
+{
+    uint32_t src = registers_.ReadRegister(0);
+    uint32_t dst = registers_.ReadRegister(1);
+    uint32_t control = registers_.ReadRegister(2);
+    uint32_t count = ((control & 0x001F'FFFF) + 7) & ~7U;  // Always copies whole blocks of 8 words
+    bool fill = control & 0x0100'0000;
+
+    if (ProtectedSource(src))
+    {
+        return;
+    }
+
+    uint32_t value = fill ? HleRead(src, AccessSize::WORD) : 0;
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (!fill)
+        {
+            value = HleRead(src, AccessSize::WORD);
+            src += 4;
+        }
+
+        HleWrite(dst, value, AccessSize::WORD);
+        dst += 4;
+
+        if ((i % 8) == 7)
+        {
+            scheduler_.Step(CPU_FAST_SET_CYCLES_PER_BLOCK);
+        }
+    }
+}
+
+void ARM7TDMI::HleBgAffineSet()
+{
+    uint32_t src = registers_.ReadRegister(0);
+    uint32_t dst = registers_.ReadRegister(1);
+    uint32_t count = registers_.ReadRegister(2);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        // Source is 20 bytes: origin x and y (24.8), display x and y, scale x and y (8.8), and angle
+        int32_t originX = HleRead(src, AccessSize::WORD);
+        int32_t originY = HleRead(src + 4, AccessSize::WORD);
+        int16_t displayX = HleRead(src + 8, AccessSize::HALFWORD);
+        int16_t displayY = HleRead(src + 10, AccessSize::HALFWORD);
+        int16_t scaleX = HleRead(src + 12, AccessSize::HALFWORD);
+        int16_t scaleY = HleRead(src + 14, AccessSize::HALFWORD);
+        uint16_t angle = HleRead(src + 16, AccessSize::HALFWORD);
+        auto [pa, pb, pc, pd] = AffineMatrix(scaleX, scaleY, angle);
+
+        // Destination is 16 bytes: PA, PB, PC, PD, and the reference point x and y
+        int32_t startX = originX - ((pa * displayX) + (pb * displayY));
+        int32_t startY = originY - ((pc * displayX) + (pd * displayY));
+        HleWrite(dst, static_cast<uint16_t>(pa), AccessSize::HALFWORD);
+        HleWrite(dst + 2, static_cast<uint16_t>(pb), AccessSize::HALFWORD);
+        HleWrite(dst + 4, static_cast<uint16_t>(pc), AccessSize::HALFWORD);
+        HleWrite(dst + 6, static_cast<uint16_t>(pd), AccessSize::HALFWORD);
+        HleWrite(dst + 8, startX, AccessSize::WORD);
+        HleWrite(dst + 12, startY, AccessSize::WORD);
+
+        src += 20;
+        dst += 16;
+        scheduler_.Step(AFFINE_CYCLES_PER_ENTRY);
+    }
+}
+
+void ARM7TDMI::HleObjAffineSet()
+{
+    uint32_t src = registers_.ReadRegister(0);
+    uint32_t dst = registers_.ReadRegister(1);
+    uint32_t count = registers_.ReadRegister(2);
+    uint32_t stride = registers_.ReadRegister(3);  // 2 for a packed matrix, 8 for OAM
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        // Source is 8 bytes: scale x and y (8.8) and angle, followed by padding
+        int16_t scaleX = HleRead(src, AccessSize::HALFWORD);
+        int16_t scaleY = HleRead(src + 2, AccessSize::HALFWORD);
+        uint16_t angle = HleRead(src + 4, AccessSize::HALFWORD);
+
+        for (int16_t parameter : AffineMatrix(scaleX, scaleY, angle))
+        {
+            HleWrite(dst, static_cast<uint16_t>(parameter), AccessSize::HALFWORD);
+            dst += stride;
+        }
+
+        src += 8;
+        scheduler_.Step(AFFINE_CYCLES_PER_ENTRY);
+    }
+}
+
+void ARM7TDMI::HleLz77UnComp(AccessSize unit)
+{
+    uint32_t src = registers_.ReadRegister(0);
+    uint32_t dst = registers_.ReadRegister(1);
+
+    if (ProtectedSource(src))
+    {
+        return;
+    }
+
+    uint32_t size = HleRead(src, AccessSize::WORD) >> 8;
+    src += 4;
+    std::vector<uint8_t> data;
+    data.reserve(size);
+
+    while (data.size() < size)
+    {
+        uint8_t flags = HleRead(src++, AccessSize::BYTE);
+        scheduler_.Step(LZ77_CYCLES_PER_FLAG);
+
+        for (int i = 0; (i < 8) && (data.size() < size); ++i, flags <<= 1)
+        {
+            if ((flags & 0x80) == 0)
+            {
+                data.push_back(HleRead(src++, AccessSize::BYTE));
+                continue;
+            }
+
+            uint8_t high = HleRead(src++, AccessSize::BYTE);
+            uint8_t low = HleRead(src++, AccessSize::BYTE);
+            uint32_t displacement = (((high & 0x0F) << 8) | low) + 1;
+            uint32_t length = (high >> 4) + 3;
+
+            for (uint32_t j = 0; (j < length) && (data.size() < size); ++j)
+            {
+                uint32_t position = data.size();
+
+                // References to before the start of the output read whatever was already at the destination
+                data.push_back((position >= displacement) ? data[position - displacement] :
+                                                            HleRead(dst + position - displacement, AccessSize::BYTE));
+            }
+        }
+    }
+
+    HleWriteUnits(dst, data, unit, LZ77_CYCLES_PER_BYTE);
+}
+
+bool ARM7TDMI::HleHuffUnComp()
+{
+    uint32_t src = registers_.ReadRegister(0);
+    uint32_t dst = registers_.ReadRegister(1);
+
+    if (ProtectedSource(src))
+    {
+        return true;
+    }
+
+    uint32_t header = HleRead(src, AccessSize::WORD);
+    uint32_t dataBits = header & 0x0F;
+
+    if ((dataBits != 4) && (dataBits != 8))
+    {
+        return false;
+    }
+
+    // The tree follows its size byte, and the bit stream follows the tree
+    uint32_t size = header >> 8;
+    uint32_t treeSize = (HleRead(src + 4, AccessSize::BYTE) + 1) * 2;
+    std::vector<uint8_t> tree(treeSize);
+
+    for (uint32_t i = 0; i < treeSize; ++i)
+    {
+        tree[i] = HleRead(src + 4 + i, AccessSize::BYTE);
+    }
+
+    uint32_t bitStream = src + 4 + treeSize;
+    std::vector<uint8_t> data;
+    data.reserve(size + 3);
+    uint32_t nodeIndex = 1;
+    uint32_t word = 0;
+    uint32_t wordBits = 0;
+
+    while (data.size() < size)
+    {
+        uint32_t bits = HleRead(bitStream, AccessSize::WORD);
+        bitStream += 4;
+
+        for (int i = 31; (i >= 0) && (data.size() < size); --i)
+        {
+            uint8_t node = tree[nodeIndex];
+            bool right = (bits >> i) & 0x01;
+            uint32_t childIndex = (nodeIndex & ~1U) + ((node & 0x3F) * 2) + 2 + (right ? 1 : 0);
+            bool leaf = node & (right ? 0x40 : 0x80);
+            scheduler_.Step(HUFF_CYCLES_PER_BIT);
+
+            if (childIndex >= treeSize)
+            {
+                // Malformed tree that points past its end. Stop there instead of walking whatever follows it in memory.
+                childIndex = treeSize - 1;
+                leaf = true;
+            }
+
+            if (!leaf)
+            {
+                nodeIndex = childIndex;
+                continue;
+            }
+
+            word |= (tree[childIndex] & ((1U << dataBits) - 1)) << wordBits;
+            wordBits += dataBits;
+            nodeIndex = 1;
+
+            if (wordBits == 32)
+            {
+                for (int j = 0; j < 4; ++j)
+                {
+                    data.push_back((word >> (8 * j)) & 0xFF);
+                }
+
+                word = 0;
+                wordBits = 0;
+            }
+        }
+    }
+
+    HleWriteUnits(dst, data, AccessSize::WORD, 0);
+    return true;
+}
+
+void ARM7TDMI::HleRlUnComp(AccessSize unit)
+{
+    uint32_t src = registers_.ReadRegister(0);
+    uint32_t dst = registers_.ReadRegister(1);
+
+    if (ProtectedSource(src))
+    {
+        return;
+    }
+
+    uint32_t size = HleRead(src, AccessSize::WORD) >> 8;
+    src += 4;
+    std::vector<uint8_t> data;
+    data.reserve(size);
+
+    while (data.size() < size)
+    {
+        uint8_t flag = HleRead(src++, AccessSize::BYTE);
+        scheduler_.Step(RL_CYCLES_PER_FLAG);
+
+        if (flag & 0x80)
+        {
+            uint32_t length = (flag & 0x7F) + 3;
+            uint8_t value = HleRead(src++, AccessSize::BYTE);
+
+            for (uint32_t i = 0; (i < length) && (data.size() < size); ++i)
+            {
+                data.push_back(value);
+            }
+        }
+        else
+        {
+            uint32_t length = (flag & 0x7F) + 1;
+
+            for (uint32_t i = 0; (i < length) && (data.size() < size); ++i)
+            {
+                data.push_back(HleRead(src++, AccessSize::BYTE));
+            }
+        }
+    }
+
+    HleWriteUnits(dst, data, unit, RL_CYCLES_PER_BYTE);
+}
+
+uint32_t ARM7TDMI::HleRead(uint32_t addr, AccessSize alignment)
+{
+    auto [value, cycles] = ReadMemory(addr, alignment);
+    scheduler_.Step(cycles);
+    return value;
+}
+
+void ARM7TDMI::HleWrite(uint32_t addr, uint32_t value, AccessSize alignment)
+{
+    int cycles = WriteMemory(addr, value, alignment);
+    scheduler_.Step(cycles);
+}
+
+void ARM7TDMI::HleWriteUnits(uint32_t addr, std::vector<uint8_t> const& data, AccessSize unit, int cyclesPerByte)
+{
+    uint32_t width = static_cast<uint32_t>(unit);
+
+    for (size_t i = 0; (i + width) <= data.size(); i += width)
+    {
+        uint32_t value = 0;
+
+        for (uint32_t j = 0; j < width; ++j)
+        {
+            value |= data[i + j] << (8 * j);
+        }
+
+        HleWrite(addr + i, value, unit);
+        scheduler_.Step(cyclesPerByte * width);
+    }
+}
+}
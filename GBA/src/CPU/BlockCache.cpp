@@ -0,0 +1,219 @@
+#include <CPU/BlockCache.hpp>
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <CPU/CpuTypes.hpp>
+#include <System/MemoryMap.hpp>
+#include <Utilities/MemoryUtilities.hpp>
+
+namespace
+{
+/// @brief Check if an address is in on-board or on-chip work RAM, excluding mirrors.
+/// @param addr Address to check.
+/// @return True if address is in work RAM.
+bool InWorkRam(uint32_t addr)
+{
+    return ((WRAM_ON_BOARD_ADDR_MIN <= addr) && (addr <= WRAM_ON_BOARD_ADDR_MAX)) ||
+           ((WRAM_ON_CHIP_ADDR_MIN <= addr) && (addr <= WRAM_ON_CHIP_ADDR_MAX));
+}
+}
+
+namespace CPU
+{
+BlockCache::BlockCache()
+{
+    Clear();
+}
+
+void BlockCache::Clear()
+{
+    blocks_.clear();
+    blockBytes_ = 0;
+
+    for (auto& page : codePages_)
+    {
+        page.clear();
+    }
+
+    recording_ = false;
+}
+
+bool BlockCache::Cacheable(uint32_t addr)
+{
+    return (addr <= BIOS_ADDR_MAX) || InWorkRam(addr) || ((GAME_PAK_ADDR_MIN <= addr) && (addr < SRAM_ADDR_MIN));
+}
+
+Block* BlockCache::Lookup(uint32_t addr, bool thumb)
+{
+    auto it = blocks_.find(Key(addr, thumb));
+
+    if ((it == blocks_.end()) || !it->second.valid_)
+    {
+        return nullptr;
+    }
+
+    return &it->second;
+}
+
+void BlockCache::StartRecording(uint32_t addr, bool thumb, std::array<uint32_t, 3> const& opcodes)
+{
+    recording_ = true;
+    recordingBlock_.startAddr_ = addr;
+    recordingBlock_.thumb_ = thumb;
+    recordingBlock_.valid_ = true;
+    recordingBlock_.instructions_.clear();
+    recordingBlock_.opcodes_.assign(opcodes.begin(), opcodes.end());
+
+    recordingBlock_.fetchFromBus_ = !InWorkRam(addr);
+}
+
+void BlockCache::Record(uint32_t addr,
+                        InstructionHandler handler,
+                        uint32_t instruction,
+                        uint32_t fetchedOpcode,
+                        bool endOfBlock)
+{
+    uint32_t width = InstructionWidth(recordingBlock_);
+    size_t length = recordingBlock_.instructions_.size();
+    uint32_t expectedAddr = recordingBlock_.startAddr_ + (length * width);
+    uint32_t lastFetchedAddr = addr + (2 * width);
+
+    if ((addr != expectedAddr) || !Cacheable(lastFetchedAddr) ||
+        (InWorkRam(recordingBlock_.startAddr_) != InWorkRam(lastFetchedAddr)))
+    {
+        recording_ = false;
+        return;
+    }
+
+    recordingBlock_.instructions_.push_back({handler, instruction});
+
+    if (length != 0)
+    {
+        recordingBlock_.opcodes_.push_back(fetchedOpcode);
+    }
+
+    if (endOfBlock || (recordingBlock_.instructions_.size() == MAX_BLOCK_LENGTH))
+    {
+        FinishRecording();
+    }
+}
+
+void BlockCache::FinishRecording()
+{
+    recording_ = false;
+
+    if (recordingBlock_.instructions_.empty())
+    {
+        return;
+    }
+
+    uint32_t startAddr = recordingBlock_.startAddr_;
+    uint32_t key = Key(startAddr, recordingBlock_.thumb_);
+
+    if (InWorkRam(startAddr))
+    {
+        uint32_t endAddr = startAddr + (recordingBlock_.opcodes_.size() * InstructionWidth(recordingBlock_)) - 1;
+
+        for (size_t page = CodePageIndex(startAddr); page <= CodePageIndex(endAddr); ++page)
+        {
+            codePages_[page].push_back(key);
+        }
+    }
+
+    auto [it, inserted] = blocks_.try_emplace(key);
+
+    if (!inserted)
+    {
+        blockBytes_ -= BlockBytes(it->second);
+    }
+
+    it->second = std::move(recordingBlock_);
+    blockBytes_ += BlockBytes(it->second);
+}
+
+bool BlockCache::Invalidate(uint32_t addr, AccessSize alignment)
+{
+    return InvalidateRange(addr, static_cast<uint32_t>(alignment));
+}
+
+bool BlockCache::InvalidateRange(uint32_t addr, uint32_t length)
+{
+    bool invalidated = false;
+
+    if (recording_)
+    {
+        uint32_t startAddr = recordingBlock_.startAddr_;
+        uint32_t endAddr = startAddr + (recordingBlock_.opcodes_.size() * InstructionWidth(recordingBlock_));
+
+        if (((addr + length) > startAddr) && (addr < endAddr))
+        {
+            recording_ = false;
+            invalidated = true;
+        }
+    }
+
+    for (size_t pageIndex = CodePageIndex(addr); pageIndex <= CodePageIndex(addr + length - 1); ++pageIndex)
+    {
+        auto& page = codePages_[pageIndex];
+
+        if (page.empty())
+        {
+            continue;
+        }
+
+        for (uint32_t key : page)
+        {
+            auto it = blocks_.find(key);
+
+            if (it != blocks_.end())
+            {
+                it->second.valid_ = false;
+            }
+        }
+
+        page.clear();
+        invalidated = true;
+    }
+
+    return invalidated;
+}
+
+void BlockCache::InvalidateWorkRam()
+{
+    recording_ = false;
+
+    for (auto& page : codePages_)
+    {
+        for (uint32_t key : page)
+        {
+            auto it = blocks_.find(key);
+
+            if (it != blocks_.end())
+            {
+                it->second.valid_ = false;
+            }
+        }
+
+        page.clear();
+    }
+}
+
+size_t BlockCache::BlockBytes(Block const& block)
+{
+    // Each map node also holds the key and a pointer to the next node
+    return sizeof(Block) + sizeof(uint32_t) + sizeof(void*) +
+           (block.instructions_.capacity() * sizeof(CachedInstruction)) + (block.opcodes_.capacity() * sizeof(uint32_t));
+}
+
+size_t BlockCache::CodePageIndex(uint32_t addr)
+{
+    if (addr >= WRAM_ON_CHIP_ADDR_MIN)
+    {
+        return ON_BOARD_CODE_PAGES + ((addr - WRAM_ON_CHIP_ADDR_MIN) / CODE_PAGE_SIZE);
+    }
+
+    return (addr - WRAM_ON_BOARD_ADDR_MIN) / CODE_PAGE_SIZE;
+}
+}
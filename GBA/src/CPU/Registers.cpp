@@ -1,74 +1,67 @@
 #include <CPU/Registers.hpp>
+#include <algorithm>
 #include <cstdint>
-#include <format>
-#include <sstream>
-#include <string>
 #include <CPU/CpuTypes.hpp>
 #include <System/SystemControl.hpp>
+#include <Utilities/StateSerializer.hpp>
 
 namespace CPU
 {
 void Registers::Reset()
 {
     cpsr_.Register = 0;
+    lazyNZ_ = false;
+    lazyCV_ = false;
+
+    active_ = {};
+    bank_ = BankIndex(static_cast<uint32_t>(OperatingMode::Supervisor));
+    bankedSpLr_ = {};
+    userR8ToR12_ = {};
+    fiqR8ToR12_ = {};
+    spsr_ = {};
+
     SetOperatingMode(OperatingMode::Supervisor);
     SetOperatingState(OperatingState::ARM);
     SetIrqDisabled(true);
     SetFiqDisabled(true);
-
-    systemAndUserRegisters_ = {};
-    fiqRegisters_ = {};
-    supervisorRegisters_ = {};
-    abortRegisters_ = {};
-    irqRegisters_ = {};
-    undefinedRegisters_ = {};
-
     SetPC(RESET_VECTOR);
 }
 
 void Registers::SkipBIOS()
 {
     SetOperatingMode(OperatingMode::System);
+    SetIrqDisabled(false);
+    SetFiqDisabled(false);
     SetPC(0x0800'0000);
     WriteRegister(SP_INDEX, 0x0300'7F00, OperatingMode::System);
     WriteRegister(SP_INDEX, 0x0300'7FA0, OperatingMode::IRQ);
     WriteRegister(SP_INDEX, 0x0300'7FE0, OperatingMode::Supervisor);
 }
 
-uint32_t Registers::ReadRegister(uint8_t index) const
-{
-    auto mode = GetOperatingMode();
-    return ReadRegister(index, mode);
-}
-
-uint32_t Registers::ReadRegister(uint8_t index, OperatingMode mode) const
+void Registers::Serialize(StateSerializer& state)
 {
-    switch (mode)
+    // Lazy flags are saved as is rather than evaluated so that saving doesn't change CPU state
+    state.Value(cpsr_);
+    state.Value(flagResult_);
+    state.Value(flagOp1_);
+    state.Value(flagOp2_);
+    state.Value(flagCarryIn_);
+    state.Value(lazyNZ_);
+    state.Value(lazyCV_);
+
+    // Active registers always belong to the bank of the saved mode
+    state.Value(active_);
+    state.Value(bankedSpLr_);
+    state.Value(userR8ToR12_);
+    state.Value(fiqR8ToR12_);
+    state.Value(spsr_);
+
+    if (state.Loading())
     {
-        case OperatingMode::User:
-        case OperatingMode::System:
-            return *systemAndUserRegistersLUT_.at(index);
-        case OperatingMode::FIQ:
-            return *fiqRegistersLUT_.at(index);
-        case OperatingMode::Supervisor:
-            return *supervisorRegistersLUT_.at(index);
-        case OperatingMode::Abort:
-            return *abortRegistersLUT_.at(index);
-        case OperatingMode::IRQ:
-            return *irqRegistersLUT_.at(index);
-        case OperatingMode::Undefined:
-            return *undefinedRegistersLUT_.at(index);
-        default:
-            return 0;
+        bank_ = BankIndex(cpsr_.Mode);
     }
 }
 
-void Registers::WriteRegister(uint8_t index, uint32_t value)
-{
-    auto mode = GetOperatingMode();
-    WriteRegister(index, value, mode);
-}
-
 void Registers::WriteRegister(uint8_t index, uint32_t value, OperatingMode mode)
 {
     if (index == PC_INDEX)
@@ -77,186 +70,114 @@ void Registers::WriteRegister(uint8_t index, uint32_t value, OperatingMode mode)
         value &= (GetOperatingState() == OperatingState::ARM) ? 0xFFFF'FFFC : 0xFFFF'FFFE;
     }
 
-    switch (mode)
-    {
-        case OperatingMode::User:
-        case OperatingMode::System:
-            *systemAndUserRegistersLUT_.at(index) = value;
-            break;
-        case OperatingMode::FIQ:
-            *fiqRegistersLUT_.at(index) = value;
-            break;
-        case OperatingMode::Supervisor:
-            *supervisorRegistersLUT_.at(index) = value;
-            break;
-        case OperatingMode::Abort:
-            *abortRegistersLUT_.at(index) = value;
-            break;
-        case OperatingMode::IRQ:
-            *irqRegistersLUT_.at(index) = value;
-            break;
-        case OperatingMode::Undefined:
-            *undefinedRegistersLUT_.at(index) = value;
-            break;
-    }
+    *const_cast<uint32_t*>(RegisterOfMode(index, mode)) = value;
 }
 
-uint32_t Registers::GetSP() const
+uint32_t const* Registers::RegisterOfMode(uint8_t index, OperatingMode mode) const
 {
-    switch (GetOperatingMode())
+    size_t bank = BankIndex(static_cast<uint32_t>(mode));
+
+    if ((bank == bank_) || (index < 8) || (index == PC_INDEX))
+    {
+        return &active_[index];
+    }
+
+    if (index >= SP_INDEX)
+    {
+        return &bankedSpLr_[bank][index - SP_INDEX];
+    }
+
+    // R8-R12 are shared by every mode except FIQ
+    if ((bank == FIQ_BANK) || (bank_ == FIQ_BANK))
     {
-        case OperatingMode::User:
-        case OperatingMode::System:
-            return *systemAndUserRegistersLUT_.at(SP_INDEX);
-        case OperatingMode::FIQ:
-            return *fiqRegistersLUT_.at(SP_INDEX);
-        case OperatingMode::Supervisor:
-            return *supervisorRegistersLUT_.at(SP_INDEX);
-        case OperatingMode::Abort:
-            return *abortRegistersLUT_.at(SP_INDEX);
-        case OperatingMode::IRQ:
-            return *irqRegistersLUT_.at(SP_INDEX);
-        case OperatingMode::Undefined:
-            return *undefinedRegistersLUT_.at(SP_INDEX);
-        default:
-            return 0;
+        return (bank == FIQ_BANK) ? &fiqR8ToR12_[index - 8] : &userR8ToR12_[index - 8];
     }
+
+    return &active_[index];
 }
 
-uint32_t Registers::GetLR() const
+void Registers::SwapBanks(size_t bank)
 {
-    switch (GetOperatingMode())
+    bankedSpLr_[bank_] = {active_[SP_INDEX], active_[LR_INDEX]};
+
+    if (bank_ == FIQ_BANK)
     {
-        case OperatingMode::User:
-        case OperatingMode::System:
-            return *systemAndUserRegistersLUT_.at(LR_INDEX);
-        case OperatingMode::FIQ:
-            return *fiqRegistersLUT_.at(LR_INDEX);
-        case OperatingMode::Supervisor:
-            return *supervisorRegistersLUT_.at(LR_INDEX);
-        case OperatingMode::Abort:
-            return *abortRegistersLUT_.at(LR_INDEX);
-        case OperatingMode::IRQ:
-            return *irqRegistersLUT_.at(LR_INDEX);
-        case OperatingMode::Undefined:
-            return *undefinedRegistersLUT_.at(LR_INDEX);
-        default:
-            return 0;
+        std::copy_n(&active_[8], 5, fiqR8ToR12_.begin());
+        std::copy_n(userR8ToR12_.begin(), 5, &active_[8]);
     }
+    else if (bank == FIQ_BANK)
+    {
+        std::copy_n(&active_[8], 5, userR8ToR12_.begin());
+        std::copy_n(fiqR8ToR12_.begin(), 5, &active_[8]);
+    }
+
+    active_[SP_INDEX] = bankedSpLr_[bank][0];
+    active_[LR_INDEX] = bankedSpLr_[bank][1];
+    bank_ = bank;
 }
 
 void Registers::SetSPSR(uint32_t spsr)
 {
-    auto mode = GetOperatingMode();
-
-    switch (mode)
+    if (bank_ != USER_BANK)
     {
-        case OperatingMode::FIQ:
-            fiqRegisters_.spsr_.Register = spsr;
-            break;
-        case OperatingMode::Supervisor:
-            supervisorRegisters_.spsr_.Register = spsr;
-            break;
-        case OperatingMode::Abort:
-            abortRegisters_.spsr_.Register = spsr;
-            break;
-        case OperatingMode::IRQ:
-            irqRegisters_.spsr_.Register = spsr;
-            break;
-        case OperatingMode::Undefined:
-            undefinedRegisters_.spsr_.Register = spsr;
-            break;
-        default:
-            break;
+        spsr_[bank_].Register = spsr;
     }
 }
 
 uint32_t Registers::GetSPSR() const
 {
-    auto mode = GetOperatingMode();
-
-    switch (mode)
-    {
-        case OperatingMode::FIQ:
-            return fiqRegisters_.spsr_.Register;
-        case OperatingMode::Supervisor:
-            return supervisorRegisters_.spsr_.Register;
-        case OperatingMode::Abort:
-            return abortRegisters_.spsr_.Register;
-        case OperatingMode::IRQ:
-            return irqRegisters_.spsr_.Register;
-        case OperatingMode::Undefined:
-            return undefinedRegisters_.spsr_.Register;
-        default:
-            return cpsr_.Register;
-    }
+    return (bank_ != USER_BANK) ? spsr_[bank_].Register : GetCPSR();
 }
 
 void Registers::LoadSPSR()
 {
-    auto mode = GetOperatingMode();
+    EvaluateNZ();
+    EvaluateCV();
 
-    switch (mode)
+    if (bank_ != USER_BANK)
     {
-        case OperatingMode::FIQ:
-            cpsr_ = fiqRegisters_.spsr_;
-            break;
-        case OperatingMode::Supervisor:
-            cpsr_ = supervisorRegisters_.spsr_;
-            break;
-        case OperatingMode::Abort:
-            cpsr_ = abortRegisters_.spsr_;
-            break;
-        case OperatingMode::IRQ:
-            cpsr_ = irqRegisters_.spsr_;
-            break;
-        case OperatingMode::Undefined:
-            cpsr_ = undefinedRegisters_.spsr_;
-            break;
-        default:
-            break;
+        CPSR spsr = spsr_[bank_];
+        SwitchBank(spsr.Mode);
+        cpsr_ = spsr;
     }
 }
 
-std::string Registers::SetRegistersString() const
+uint32_t Registers::GetCPSR() const
 {
-    std::stringstream regStream;
-    bool const isThumbState = GetOperatingState() == OperatingState::THUMB;
+    CPSR cpsr = cpsr_;
 
-    for (int i = 0; i < 16; ++i)
+    if (lazyNZ_)
     {
-        regStream << std::format("R{} {:08X}  ", i, ReadRegister(i));
+        cpsr.N = IsNegative();
+        cpsr.Z = IsZero();
     }
 
-    regStream << "CPSR: " << (IsNegative() ? "N" : "-") << (IsZero() ? "Z" : "-") << (IsCarry() ? "C" : "-") << (IsOverflow() ? "V" : "-") << "  ";
-    regStream << (IsIrqDisabled() ? "I" : "-") << (IsFiqDisabled() ? "F" : "-") << (isThumbState ? "T" : "-") << "  " << "Mode: ";
-    uint32_t spsr = GetSPSR();
+    if (lazyCV_)
+    {
+        cpsr.C = LazyCarry();
+        cpsr.V = LazyOverflow();
+    }
 
-    switch (GetOperatingMode())
+    return cpsr.Register;
+}
+
+void Registers::EvaluateNZ()
+{
+    if (lazyNZ_)
     {
-        case OperatingMode::User:
-            regStream << "User";
-            break;
-        case OperatingMode::FIQ:
-            regStream << std::format("FIQ         SPSR: {:08X}", spsr);
-            break;
-        case OperatingMode::IRQ:
-            regStream << std::format("IRQ         SPSR: {:08X}", spsr);
-            break;
-        case OperatingMode::Supervisor:
-            regStream << std::format("Supervisor  SPSR: {:08X}", spsr);
-            break;
-        case OperatingMode::Abort:
-            regStream << std::format("Abort       SPSR: {:08X}", spsr);
-            break;
-        case OperatingMode::System:
-            regStream << "System";
-            break;
-        case OperatingMode::Undefined:
-            regStream << std::format("Undefined   SPSR: {:08X}", spsr);
-            break;
+        cpsr_.N = IsNegative();
+        cpsr_.Z = IsZero();
+        lazyNZ_ = false;
     }
+}
 
-    return regStream.str();
+void Registers::EvaluateCV()
+{
+    if (lazyCV_)
+    {
+        cpsr_.C = LazyCarry();
+        cpsr_.V = LazyOverflow();
+        lazyCV_ = false;
+    }
 }
 }  // namespace CPU
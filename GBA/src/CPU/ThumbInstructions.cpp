@@ -1,64 +1,27 @@
 #include <CPU/ThumbInstructions.hpp>
+#include <array>
 #include <bit>
 #include <cstdint>
+#include <stdexcept>
+#include <tuple>
 #include <utility>
 #include <CPU/ARM7TDMI.hpp>
 #include <CPU/CpuTypes.hpp>
 #include <Logging/Logging.hpp>
 #include <System/EventScheduler.hpp>
+#include <System/GameBoyAdvance.hpp>
 
 namespace
 {
-/// @brief Determine the result of the overflow flag for addition operation: result = op1 + op2
-/// @param op1 Addition operand
-/// @param op2 Addition operand
-/// @param result Addition result
-/// @return State of overflow flag after addition
-bool AdditionOverflow(uint32_t op1, uint32_t op2, uint32_t result)
-{
-    return (~(op1 ^ op2) & ((op1 ^ result)) & MSB_32) != 0;
-}
-
-/// @brief Determine the result of the overflow flag for subtraction operation: result = op1 - op2
-/// @param op1 Subtraction operand
-/// @param op2 Subtraction operand
-/// @param result Subtraction result
-/// @return State of overflow flag after subtraction
-bool SubtractionOverflow(uint32_t op1, uint32_t op2, uint32_t result)
-{
-    return ((op1 ^ op2) & ((op1 ^ result)) & MSB_32) != 0;
-}
-
-/// @brief Calculate the result of a THUMB add or add w/ carry operation, along with the carry and overflow flags.
+/// @brief Calculate op1 + op2 + carry, which is how every THUMB addition and subtraction is performed. Subtraction of the form
+///        op1 - op2 - !C is calculated as op1 + ~op2 + C.
 /// @param op1 First addition operand.
 /// @param op2 Second addition operand.
-/// @param result Result of addition, returned by reference.
-/// @param carry Carry flag, defaults to 0 meaning non ADC operation.
-/// @return Pair of {carry_flag, overflow_flag}.
-std::pair<bool, bool> Add32(uint32_t op1, uint32_t op2, uint32_t& result, bool carry = 0)
-{
-    uint64_t result64 = static_cast<uint64_t>(op1) + static_cast<uint64_t>(op2) + static_cast<uint64_t>(carry);
-    result = result64 & MAX_U32;
-    bool c = (result64 > MAX_U32);
-    bool v = AdditionOverflow(op1, op2, result);
-    return {c, v};
-}
-
-/// @brief Calculate the result of a THUMB sub or sub w/ carry operation, along with the carry and overflow flags.
-/// @param op1 First subtraction operand.
-/// @param op2 Second subtraction operand.
-/// @param result Result of subtraction (op1 - op2), returned by reference.
-/// @param carry Carry flag, defaults to 1 meaning non SBC operation.
-/// @return Pair of {carry_flag, overflow_flag}.
-std::pair<bool, bool> Sub32(uint32_t op1, uint32_t op2, uint32_t& result, bool carry = 1)
+/// @param carry Carry into addition.
+/// @return Result of addition.
+uint32_t AddWithCarry(uint32_t op1, uint32_t op2, bool carry)
 {
-    uint32_t carryVal = carry ? 0 : 1;
-    carryVal = ~carryVal + 1;
-    uint64_t result64 = static_cast<uint64_t>(op1) + static_cast<uint64_t>(~op2 + 1) + static_cast<uint64_t>(carryVal);
-    result = result64 & MAX_U32;
-    bool c = op1 >= op2;
-    bool v = SubtractionOverflow(op1, op2, result);
-    return {c, v};
+    return op1 + op2 + (carry ? 1 : 0);
 }
 
 /// @brief Determine the number of internal cycles needed to perform a multiplication op.
@@ -93,95 +56,138 @@ namespace CPU::THUMB
 {
 using namespace Logging;
 
-CPU::Instruction* DecodeInstruction(uint16_t undecodedInstruction, void* buffer)
+namespace
+{
+/// @brief Construct an instruction of a specific class and execute it. Since the concrete type is known, the call to
+///        Execute is resolved statically.
+/// @tparam T THUMB instruction class.
+/// @param cpu Reference to the ARM CPU.
+/// @param undecodedInstruction 16-bit THUMB instruction.
+template <typename T>
+void ExecuteHandler(ARM7TDMI& cpu, uint32_t undecodedInstruction)
+{
+    T(static_cast<uint16_t>(undecodedInstruction)).Execute(cpu);
+}
+
+/// @brief Handler for bit patterns that do not match any THUMB instruction format.
+void DecodeFailure(ARM7TDMI&, uint32_t)
 {
-    CPU::Instruction* instructionPtr = nullptr;
+    throw std::runtime_error("Unable to decode instruction");
+}
 
+/// @brief Decode a 32 bit value into the handler for its THUMB instruction class.
+/// @param undecodedInstruction 16 bit value to decode.
+/// @return Handler that executes the decoded instruction.
+constexpr InstructionHandler DecodeHandler(uint16_t undecodedInstruction)
+{
     if (SoftwareInterrupt::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) SoftwareInterrupt(undecodedInstruction);
+        return &ExecuteHandler<SoftwareInterrupt>;
     }
     else if (UnconditionalBranch::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) UnconditionalBranch(undecodedInstruction);
+        return &ExecuteHandler<UnconditionalBranch>;
     }
     else if (ConditionalBranch::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) ConditionalBranch(undecodedInstruction);
+        return &ExecuteHandler<ConditionalBranch>;
     }
     else if (MultipleLoadStore::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) MultipleLoadStore(undecodedInstruction);
+        return &ExecuteHandler<MultipleLoadStore>;
     }
     else if (LongBranchWithLink::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) LongBranchWithLink(undecodedInstruction);
+        return &ExecuteHandler<LongBranchWithLink>;
     }
     else if (AddOffsetToStackPointer::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) AddOffsetToStackPointer(undecodedInstruction);
+        return &ExecuteHandler<AddOffsetToStackPointer>;
     }
     else if (PushPopRegisters::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) PushPopRegisters(undecodedInstruction);
+        return &ExecuteHandler<PushPopRegisters>;
     }
     else if (LoadStoreHalfword::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) LoadStoreHalfword(undecodedInstruction);
+        return &ExecuteHandler<LoadStoreHalfword>;
     }
     else if (SPRelativeLoadStore::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) SPRelativeLoadStore(undecodedInstruction);
+        return &ExecuteHandler<SPRelativeLoadStore>;
     }
     else if (LoadAddress::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) LoadAddress(undecodedInstruction);
+        return &ExecuteHandler<LoadAddress>;
     }
     else if (LoadStoreWithImmediateOffset::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) LoadStoreWithImmediateOffset(undecodedInstruction);
+        return &ExecuteHandler<LoadStoreWithImmediateOffset>;
     }
     else if (LoadStoreWithRegisterOffset::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) LoadStoreWithRegisterOffset(undecodedInstruction);
+        return &ExecuteHandler<LoadStoreWithRegisterOffset>;
     }
     else if (LoadStoreSignExtendedByteHalfword::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) LoadStoreSignExtendedByteHalfword(undecodedInstruction);
+        return &ExecuteHandler<LoadStoreSignExtendedByteHalfword>;
     }
     else if (PCRelativeLoad::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) PCRelativeLoad(undecodedInstruction);
+        return &ExecuteHandler<PCRelativeLoad>;
     }
     else if (HiRegisterOperationsBranchExchange::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) HiRegisterOperationsBranchExchange(undecodedInstruction);
+        return &ExecuteHandler<HiRegisterOperationsBranchExchange>;
     }
     else if (ALUOperations::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) ALUOperations(undecodedInstruction);
+        return &ExecuteHandler<ALUOperations>;
     }
     else if (MoveCompareAddSubtractImmediate::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) MoveCompareAddSubtractImmediate(undecodedInstruction);
+        return &ExecuteHandler<MoveCompareAddSubtractImmediate>;
     }
     else if (AddSubtract::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) AddSubtract(undecodedInstruction);
+        return &ExecuteHandler<AddSubtract>;
     }
     else if (MoveShiftedRegister::IsInstanceOf(undecodedInstruction))
     {
-        instructionPtr = new(buffer) MoveShiftedRegister(undecodedInstruction);
+        return &ExecuteHandler<MoveShiftedRegister>;
     }
 
-    return instructionPtr;
+    return &DecodeFailure;
+}
+
+/// @brief Build the THUMB decode table. Each entry is indexed by the top 10 bits of an instruction. Every THUMB format is
+///        fully identified by those bits, so each entry points directly to its class's handler.
+/// @return Table of instruction handlers.
+constexpr std::array<InstructionHandler, THUMB_DECODE_TABLE_SIZE> BuildDecodeTable()
+{
+    std::array<InstructionHandler, THUMB_DECODE_TABLE_SIZE> table = {};
+
+    for (uint32_t index = 0; index < THUMB_DECODE_TABLE_SIZE; ++index)
+    {
+        table[index] = DecodeHandler(index << 6);
+    }
+
+    return table;
+}
+
+constexpr std::array<InstructionHandler, THUMB_DECODE_TABLE_SIZE> DECODE_TABLE = BuildDecodeTable();
+}
+
+InstructionHandler LookupHandler(uint16_t undecodedInstruction)
+{
+    return DECODE_TABLE[undecodedInstruction >> 6];
 }
 
 void SoftwareInterrupt::Execute(ARM7TDMI& cpu)
 {
-    if (LogMgr.CpuLoggingEnabled())
+    if (cpu.biosHleEnabled_ && cpu.HleSoftwareInterrupt(instruction_.Value8))
     {
-        SetMnemonic(cpu.mnemonic_);
+        return;
     }
 
     uint32_t currentCPSR = cpu.registers_.GetCPSR();
@@ -200,11 +206,6 @@ void UnconditionalBranch::Execute(ARM7TDMI& cpu)
     int16_t signedOffset = SignExtend16(offset, 11);
     uint32_t newPC = cpu.registers_.GetPC() + signedOffset;
 
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_, newPC);
-    }
-
     cpu.registers_.SetPC(newPC);
     cpu.flushPipeline_ = true;
 }
@@ -215,11 +216,6 @@ void ConditionalBranch::Execute(ARM7TDMI& cpu)
     int16_t signedOffset = SignExtend16(offset, 8);
     uint32_t newPC = cpu.registers_.GetPC() + signedOffset;
 
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_, newPC);
-    }
-
     if (cpu.ArmConditionSatisfied(instruction_.Cond))
     {
         cpu.registers_.SetPC(newPC);
@@ -229,11 +225,6 @@ void ConditionalBranch::Execute(ARM7TDMI& cpu)
 
 void MultipleLoadStore::Execute(ARM7TDMI& cpu)
 {
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_);
-    }
-
     uint8_t regList = instruction_.Rlist;
     uint32_t addr = cpu.registers_.ReadRegister(instruction_.Rb);
     uint32_t wbAddr = addr;
@@ -258,19 +249,22 @@ void MultipleLoadStore::Execute(ARM7TDMI& cpu)
         wbAddr += (4 * std::popcount(regList));
     }
 
+    // An empty list transfers PC
+    std::array<uint32_t, 9> values;
+    uint32_t count = emptyRlist ? 1 : std::popcount(regList);
+    uint32_t index = 0;
+    uint8_t regIndex = 0;
+
     if (instruction_.L)
     {
         // Load
-        uint8_t regIndex = 0;
+        cpu.ReadMemoryBurst(addr, values.data(), count);
 
         while (regList != 0)
         {
             if (regList & 0x01)
             {
-                auto [value, readCycles] = cpu.ReadMemory(addr, AccessSize::WORD);
-                Scheduler.Step(readCycles);
-                cpu.registers_.WriteRegister(regIndex, value);
-                addr += 4;
+                cpu.registers_.WriteRegister(regIndex, values[index++]);
             }
 
             ++regIndex;
@@ -279,16 +273,12 @@ void MultipleLoadStore::Execute(ARM7TDMI& cpu)
 
         if (emptyRlist)
         {
-            auto [value, readCycles] = cpu.ReadMemory(addr, AccessSize::WORD);
-            Scheduler.Step(readCycles);
-            cpu.registers_.WriteRegister(PC_INDEX, value);
+            cpu.registers_.WriteRegister(PC_INDEX, values[0]);
             cpu.flushPipeline_ = true;
         }
     }
     else
     {
-        uint8_t regIndex = 0;
-
         while (regList != 0)
         {
             if (regList & 0x01)
@@ -300,9 +290,7 @@ void MultipleLoadStore::Execute(ARM7TDMI& cpu)
                     value = wbAddr;
                 }
 
-                int writeCycles = cpu.WriteMemory(addr, value, AccessSize::WORD);
-                Scheduler.Step(writeCycles);
-                addr += 4;
+                values[index++] = value;
             }
 
             ++regIndex;
@@ -311,10 +299,15 @@ void MultipleLoadStore::Execute(ARM7TDMI& cpu)
 
         if (emptyRlist)
         {
-            uint32_t value = cpu.registers_.GetPC() + 2;
-            int writeCycles = cpu.WriteMemory(addr, value, AccessSize::WORD);
-            Scheduler.Step(writeCycles);
+            values[0] = cpu.registers_.GetPC() + 2;
         }
+
+        cpu.WriteMemoryBurst(addr, values.data(), count);
+    }
+
+    if (!emptyRlist)
+    {
+        addr += 4 * count;
     }
 
     if (emptyRlist)
@@ -330,7 +323,7 @@ void MultipleLoadStore::Execute(ARM7TDMI& cpu)
     if (instruction_.L)
     {
         // Run 1 extra internal cycle for final write back of load operation.
-        Scheduler.Step(1);
+        cpu.scheduler_.Step(1);
     }
 }
 
@@ -350,11 +343,6 @@ void LongBranchWithLink::Execute(ARM7TDMI& cpu)
 
         uint32_t lr = cpu.registers_.GetPC() + offset;
         cpu.registers_.WriteRegister(LR_INDEX, lr);
-
-        if (LogMgr.CpuLoggingEnabled())
-        {
-            SetMnemonic(cpu.mnemonic_, 0);
-        }
     }
     else
     {
@@ -364,11 +352,6 @@ void LongBranchWithLink::Execute(ARM7TDMI& cpu)
         uint32_t newPC = cpu.registers_.ReadRegister(LR_INDEX) + offset;
         uint32_t lr = (cpu.registers_.GetPC() - 2) | 0x01;
 
-        if (LogMgr.CpuLoggingEnabled())
-        {
-            SetMnemonic(cpu.mnemonic_, newPC);
-        }
-
         cpu.registers_.WriteRegister(LR_INDEX, lr);
         cpu.registers_.SetPC(newPC);
         cpu.flushPipeline_ = true;
@@ -379,11 +362,6 @@ void AddOffsetToStackPointer::Execute(ARM7TDMI& cpu)
 {
     uint16_t offset = instruction_.SWord7 << 2;
 
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_, offset);
-    }
-
     uint32_t newSP = cpu.registers_.GetSP();
 
     if (instruction_.S)
@@ -400,29 +378,27 @@ void AddOffsetToStackPointer::Execute(ARM7TDMI& cpu)
 
 void PushPopRegisters::Execute(ARM7TDMI& cpu)
 {
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_);
-    }
-
     // Full Descending stack - Decrement SP and then push, or pop and then increment SP
     uint8_t regList = instruction_.Rlist;
     bool emptyRlist = (regList == 0) && !instruction_.R;
     uint32_t addr = cpu.registers_.GetSP();
 
+    // Registers are transferred in ascending order, with LR or PC above them. An empty list transfers PC.
+    std::array<uint32_t, 9> values;
+    uint32_t count = std::popcount(regList) + ((instruction_.R || emptyRlist) ? 1 : 0);
+    uint32_t index = 0;
+    uint8_t regIndex = 0;
+
     if (instruction_.L)
     {
         // POP
-        uint8_t regIndex = 0;
+        cpu.ReadMemoryBurst(addr, values.data(), count);
 
         while (regList != 0)
         {
             if (regList & 0x01)
             {
-                auto [value, readCycles] = cpu.ReadMemory(addr, AccessSize::WORD);
-                Scheduler.Step(readCycles);
-                cpu.registers_.WriteRegister(regIndex, value);
-                addr += 4;
+                cpu.registers_.WriteRegister(regIndex, values[index++]);
             }
 
             ++regIndex;
@@ -431,46 +407,37 @@ void PushPopRegisters::Execute(ARM7TDMI& cpu)
 
         if (instruction_.R || emptyRlist)
         {
-            auto [value, readCycles] = cpu.ReadMemory(addr, AccessSize::WORD);
-            Scheduler.Step(readCycles);
-            cpu.registers_.WriteRegister(PC_INDEX, value);
-            addr += 4;
+            cpu.registers_.WriteRegister(PC_INDEX, values[index]);
             cpu.flushPipeline_ = true;
         }
+
+        addr += 4 * count;
     }
     else
     {
         // PUSH
+        while (regList != 0)
+        {
+            if (regList & 0x01)
+            {
+                values[index++] = cpu.registers_.ReadRegister(regIndex);
+            }
+
+            ++regIndex;
+            regList >>= 1;
+        }
+
         if (instruction_.R)
         {
-            addr -= 4;
-            uint32_t value = cpu.registers_.ReadRegister(LR_INDEX);
-            int writeCycles = cpu.WriteMemory(addr, value, AccessSize::WORD);
-            Scheduler.Step(writeCycles);
+            values[index] = cpu.registers_.ReadRegister(LR_INDEX);
         }
         else if (emptyRlist)
         {
-            addr -= 4;
-            uint32_t value = cpu.registers_.GetPC() + 2;
-            int writeCycles = cpu.WriteMemory(addr, value, AccessSize::WORD);
-            Scheduler.Step(writeCycles);
+            values[index] = cpu.registers_.GetPC() + 2;
         }
 
-        uint8_t regIndex = 7;
-
-        while (regList != 0)
-        {
-            if (regList & 0x80)
-            {
-                addr -= 4;
-                uint32_t value = cpu.registers_.ReadRegister(regIndex);
-                int writeCycles = cpu.WriteMemory(addr, value, AccessSize::WORD);
-                Scheduler.Step(writeCycles);
-            }
-
-            --regIndex;
-            regList <<= 1;
-        }
+        addr -= 4 * count;
+        cpu.WriteMemoryBurst(addr, values.data(), count);
     }
 
     if (emptyRlist)
@@ -486,24 +453,19 @@ void PushPopRegisters::Execute(ARM7TDMI& cpu)
     if (instruction_.L)
     {
         // Run 1 extra internal cycle for final write back of load operation.
-        Scheduler.Step(1);
+        cpu.scheduler_.Step(1);
     }
 }
 
 void LoadStoreHalfword::Execute(ARM7TDMI& cpu)
 {
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_);
-    }
-
     uint32_t addr = cpu.registers_.ReadRegister(instruction_.Rb) + (instruction_.Offset5 << 1);
 
     if (instruction_.L)
     {
         bool misaligned = addr & 0x01;
-        auto [value, readCycles] = cpu.ReadMemory(addr, AccessSize::HALFWORD);
-        Scheduler.Step(readCycles);
+        auto [value, readCycles] = cpu.ReadMemory<AccessSize::HALFWORD>(addr);
+        cpu.scheduler_.Step(readCycles);
 
         if (misaligned)
         {
@@ -515,30 +477,25 @@ void LoadStoreHalfword::Execute(ARM7TDMI& cpu)
     else
     {
         uint16_t value = cpu.registers_.ReadRegister(instruction_.Rd) & MAX_U16;
-        int writeCycles = cpu.WriteMemory(addr, value, AccessSize::HALFWORD);
-        Scheduler.Step(writeCycles);
+        int writeCycles = cpu.WriteMemory<AccessSize::HALFWORD>(addr, value);
+        cpu.scheduler_.Step(writeCycles);
     }
 
     if (instruction_.L)
     {
         // Run 1 extra internal cycle for final write back of load operation.
-        Scheduler.Step(1);
+        cpu.scheduler_.Step(1);
     }
 }
 
 void SPRelativeLoadStore::Execute(ARM7TDMI& cpu)
 {
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_);
-    }
-
     uint32_t addr = cpu.registers_.GetSP() + (instruction_.Word8 << 2);
 
     if (instruction_.L)
     {
-        auto [value, readCycles] = cpu.ReadMemory(addr, AccessSize::WORD);
-        Scheduler.Step(readCycles);
+        auto [value, readCycles] = cpu.ReadMemory<AccessSize::WORD>(addr);
+        cpu.scheduler_.Step(readCycles);
 
         if (addr & 0x03)
         {
@@ -550,14 +507,14 @@ void SPRelativeLoadStore::Execute(ARM7TDMI& cpu)
     else
     {
         uint32_t value = cpu.registers_.ReadRegister(instruction_.Rd);
-        int writeCycles = cpu.WriteMemory(addr, value, AccessSize::WORD);
-        Scheduler.Step(writeCycles);
+        int writeCycles = cpu.WriteMemory<AccessSize::WORD>(addr, value);
+        cpu.scheduler_.Step(writeCycles);
     }
 
     if (instruction_.L)
     {
         // Run 1 extra internal cycle for final write back of load operation.
-        Scheduler.Step(1);
+        cpu.scheduler_.Step(1);
     }
 }
 
@@ -566,11 +523,6 @@ void LoadAddress::Execute(ARM7TDMI& cpu)
     uint8_t destIndex = instruction_.Rd;
     uint16_t offset = (instruction_.Word8 << 2);
 
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_, destIndex, offset);
-    }
-
     uint32_t addr = 0;
 
     if (instruction_.SP)
@@ -588,11 +540,6 @@ void LoadAddress::Execute(ARM7TDMI& cpu)
 
 void LoadStoreWithImmediateOffset::Execute(ARM7TDMI& cpu)
 {
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_);
-    }
-
     AccessSize alignment = instruction_.B ? AccessSize::BYTE : AccessSize::WORD;
     uint8_t offset = instruction_.B ? instruction_.Offset5 : (instruction_.Offset5 << 2);
     uint32_t addr = cpu.registers_.ReadRegister(instruction_.Rb) + offset;
@@ -601,7 +548,7 @@ void LoadStoreWithImmediateOffset::Execute(ARM7TDMI& cpu)
     {
         // Load
         auto [value, readCycles] = cpu.ReadMemory(addr, alignment);
-        Scheduler.Step(readCycles);
+        cpu.scheduler_.Step(readCycles);
 
         if ((alignment == AccessSize::WORD) && (addr & 0x03))
         {
@@ -615,23 +562,18 @@ void LoadStoreWithImmediateOffset::Execute(ARM7TDMI& cpu)
         // Store
         uint32_t value = cpu.registers_.ReadRegister(instruction_.Rd);
         int writeCycles = cpu.WriteMemory(addr, value, alignment);
-        Scheduler.Step(writeCycles);
+        cpu.scheduler_.Step(writeCycles);
     }
 
     if (instruction_.L)
     {
         // Run 1 extra internal cycle for final write back of load operation.
-        Scheduler.Step(1);
+        cpu.scheduler_.Step(1);
     }
 }
 
 void LoadStoreWithRegisterOffset::Execute(ARM7TDMI& cpu)
 {
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_);
-    }
-
     uint32_t addr = cpu.registers_.ReadRegister(instruction_.Rb) + cpu.registers_.ReadRegister(instruction_.Ro);
     AccessSize alignment = (instruction_.B) ? AccessSize::BYTE : AccessSize::WORD;
 
@@ -639,7 +581,7 @@ void LoadStoreWithRegisterOffset::Execute(ARM7TDMI& cpu)
     {
         // Load
         auto [value, readCycles] = cpu.ReadMemory(addr, alignment);
-        Scheduler.Step(readCycles);
+        cpu.scheduler_.Step(readCycles);
 
         if ((alignment == AccessSize::WORD) && (addr & 0x03))
         {
@@ -653,23 +595,18 @@ void LoadStoreWithRegisterOffset::Execute(ARM7TDMI& cpu)
         // Store
         uint32_t value = cpu.registers_.ReadRegister(instruction_.Rd);
         int writeCycles = cpu.WriteMemory(addr, value, alignment);
-        Scheduler.Step(writeCycles);
+        cpu.scheduler_.Step(writeCycles);
     }
 
     if (instruction_.L)
     {
         // Run 1 extra internal cycle for final write back of load operation.
-        Scheduler.Step(1);
+        cpu.scheduler_.Step(1);
     }
 }
 
 void LoadStoreSignExtendedByteHalfword::Execute(ARM7TDMI& cpu)
 {
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_);
-    }
-
     uint32_t addr = cpu.registers_.ReadRegister(instruction_.Rb) + cpu.registers_.ReadRegister(instruction_.Ro);
     bool isLoad = false;
 
@@ -689,17 +626,17 @@ void LoadStoreSignExtendedByteHalfword::Execute(ARM7TDMI& cpu)
         if (h)
         {
             // LDSH
-            std::tie(value, readCycles) = cpu.ReadMemory(addr, AccessSize::HALFWORD);
+            std::tie(value, readCycles) = cpu.ReadMemory<AccessSize::HALFWORD>(addr);
             value = SignExtend32(value, 15);
         }
         else
         {
             // LDSB
-            std::tie(value, readCycles) = cpu.ReadMemory(addr, AccessSize::BYTE);
+            std::tie(value, readCycles) = cpu.ReadMemory<AccessSize::BYTE>(addr);
             value = SignExtend32(value, 7);
         }
 
-        Scheduler.Step(readCycles);
+        cpu.scheduler_.Step(readCycles);
         cpu.registers_.WriteRegister(instruction_.Rd, value);
     }
     else
@@ -708,8 +645,8 @@ void LoadStoreSignExtendedByteHalfword::Execute(ARM7TDMI& cpu)
         {
             // LDRH
             isLoad = true;
-            auto [value, readCycles] = cpu.ReadMemory(addr, AccessSize::HALFWORD);
-            Scheduler.Step(readCycles);
+            auto [value, readCycles] = cpu.ReadMemory<AccessSize::HALFWORD>(addr);
+            cpu.scheduler_.Step(readCycles);
 
             if (addr & 0x01)
             {
@@ -722,28 +659,23 @@ void LoadStoreSignExtendedByteHalfword::Execute(ARM7TDMI& cpu)
         {
             // STRH
             uint32_t value = cpu.registers_.ReadRegister(instruction_.Rd);
-            int writeCycles = cpu.WriteMemory(addr, value, AccessSize::HALFWORD);
-            Scheduler.Step(writeCycles);
+            int writeCycles = cpu.WriteMemory<AccessSize::HALFWORD>(addr, value);
+            cpu.scheduler_.Step(writeCycles);
         }
     }
 
     if (isLoad)
     {
-        Scheduler.Step(1);
+        cpu.scheduler_.Step(1);
         cpu.flushPipeline_ = (instruction_.Rd == PC_INDEX);
     }
 }
 
 void PCRelativeLoad::Execute(ARM7TDMI& cpu)
 {
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_);
-    }
-
     uint32_t addr = (cpu.registers_.GetPC() & 0xFFFF'FFFC) + (instruction_.Word8 << 2);
-    auto [value, readCycles] = cpu.ReadMemory(addr, AccessSize::WORD);
-    Scheduler.Step(readCycles);
+    auto [value, readCycles] = cpu.ReadMemory<AccessSize::WORD>(addr);
+    cpu.scheduler_.Step(readCycles);
 
     if (addr & 0x03)
     {
@@ -768,11 +700,6 @@ void HiRegisterOperationsBranchExchange::Execute(ARM7TDMI& cpu)
         srcIndex += 8;
     }
 
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_, destIndex, srcIndex);
-    }
-
     switch (instruction_.Op)
     {
         case 0b00:  // ADD
@@ -786,14 +713,8 @@ void HiRegisterOperationsBranchExchange::Execute(ARM7TDMI& cpu)
         {
             uint32_t op1 = cpu.registers_.ReadRegister(destIndex);
             uint32_t op2 = cpu.registers_.ReadRegister(srcIndex);
-            uint32_t result = 0;
-
-            auto [c, v] = Sub32(op1, op2, result);
-
-            cpu.registers_.SetNegative(result & MSB_32);
-            cpu.registers_.SetZero(result == 0);
-            cpu.registers_.SetCarry(c);
-            cpu.registers_.SetOverflow(v);
+            uint32_t result = AddWithCarry(op1, ~op2, true);
+            cpu.registers_.SetArithmeticFlags(op1, ~op2, true, result);
             break;
         }
         case 0b10:  // MOV
@@ -822,16 +743,13 @@ void HiRegisterOperationsBranchExchange::Execute(ARM7TDMI& cpu)
 
 void ALUOperations::Execute(ARM7TDMI& cpu)
 {
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_);
-    }
-
     bool storeResult = true;
     bool updateCarry = true;
-    bool updateOverflow = true;
+    bool arithmetic = false;
     bool carryOut = cpu.registers_.IsCarry();
-    bool overflowOut = cpu.registers_.IsOverflow();
+    uint32_t addOp1 = 0;
+    uint32_t addOp2 = 0;
+    bool carryIn = false;
 
     uint32_t result = 0;
     uint32_t op1 = cpu.registers_.ReadRegister(instruction_.Rd);
@@ -842,18 +760,15 @@ void ALUOperations::Execute(ARM7TDMI& cpu)
         case 0b0000:  // AND
             result = op1 & op2;
             updateCarry = false;
-            updateOverflow = false;
             break;
         case 0b0001:  // EOR
             result = op1 ^ op2;
             updateCarry = false;
-            updateOverflow = false;
             break;
         case 0b0010:  // LSL
         {
             op2 &= 0xFF;
             result = op1;
-            updateOverflow = false;
 
             if (op2 > 32)
             {
@@ -871,14 +786,13 @@ void ALUOperations::Execute(ARM7TDMI& cpu)
                 result <<= op2;
             }
 
-            Scheduler.Step(1);
+            cpu.scheduler_.Step(1);
             break;
         }
         case 0b0011:  // LSR
         {
             op2 &= 0xFF;
             result = op1;
-            updateOverflow = false;
 
             if (op2 > 32)
             {
@@ -896,14 +810,13 @@ void ALUOperations::Execute(ARM7TDMI& cpu)
                 result >>= op2;
             }
 
-            Scheduler.Step(1);
+            cpu.scheduler_.Step(1);
             break;
         }
         case 0b0100:  // ASR
         {
             op2 &= 0xFF;
             result = op1;
-            updateOverflow = false;
 
             bool msbSet = op1 & MSB_32;
 
@@ -924,20 +837,21 @@ void ALUOperations::Execute(ARM7TDMI& cpu)
                 }
             }
 
-            Scheduler.Step(1);
+            cpu.scheduler_.Step(1);
             break;
         }
         case 0b0101:  // ADC
-            std::tie(carryOut, overflowOut) = Add32(op1, op2, result, carryOut);
+            std::tie(addOp1, addOp2, carryIn) = std::tuple(op1, op2, carryOut);
+            arithmetic = true;
             break;
         case 0b0110:  // SBC
-            std::tie(carryOut, overflowOut) = Sub32(op1, op2, result, carryOut);
+            std::tie(addOp1, addOp2, carryIn) = std::tuple(op1, ~op2, carryOut);
+            arithmetic = true;
             break;
         case 0b0111:  // ROR
         {
             op2 &= 0xFF;
             result = op1;
-            updateOverflow = false;
 
             if (op2 > 32)
             {
@@ -950,59 +864,58 @@ void ALUOperations::Execute(ARM7TDMI& cpu)
                 result = std::rotr(result, op2);
             }
 
-            Scheduler.Step(1);
+            cpu.scheduler_.Step(1);
             break;
         }
         case 0b1000:  // TST
             result = op1 & op2;
             storeResult = false;
             updateCarry = false;
-            updateOverflow = false;
             break;
         case 0b1001:  // NEG
-            std::tie(carryOut, overflowOut) = Sub32(0, op2, result);
+            std::tie(addOp1, addOp2, carryIn) = std::tuple(0, ~op2, true);
+            arithmetic = true;
             break;
         case 0b1010:  // CMP
-            std::tie(carryOut, overflowOut) = Sub32(op1, op2, result);
+            std::tie(addOp1, addOp2, carryIn) = std::tuple(op1, ~op2, true);
+            arithmetic = true;
             storeResult = false;
             break;
         case 0b1011:  // CMN
-            std::tie(carryOut, overflowOut) = Add32(op1, op2, result);
+            std::tie(addOp1, addOp2, carryIn) = std::tuple(op1, op2, false);
+            arithmetic = true;
             storeResult = false;
             break;
         case 0b1100:  // ORR
             result = op1 | op2;
             updateCarry = false;
-            updateOverflow = false;
             break;
         case 0b1101:  // MUL
             result = op1 * op2;
-            updateOverflow = false;
-            Scheduler.Step(InternalMultiplyCycles(op1));
+            cpu.scheduler_.Step(InternalMultiplyCycles(op1));
             break;
         case 0b1110:  // BIC
             result = op1 & ~op2;
             updateCarry = false;
-            updateOverflow = false;
             break;
         case 0b1111:  // MVN
             result = ~op2;
             updateCarry = false;
-            updateOverflow = false;
             break;
     }
 
-    cpu.registers_.SetNegative(result & MSB_32);
-    cpu.registers_.SetZero(result == 0);
-
-    if (updateCarry)
+    if (arithmetic)
     {
-        cpu.registers_.SetCarry(carryOut);
+        result = AddWithCarry(addOp1, addOp2, carryIn);
+        cpu.registers_.SetArithmeticFlags(addOp1, addOp2, carryIn, result);
     }
-
-    if (updateOverflow)
+    else if (updateCarry)
+    {
+        cpu.registers_.SetLogicalFlags(result, carryOut);
+    }
+    else
     {
-        cpu.registers_.SetOverflow(overflowOut);
+        cpu.registers_.SetNZFlags(result);
     }
 
     if (storeResult)
@@ -1013,15 +926,9 @@ void ALUOperations::Execute(ARM7TDMI& cpu)
 
 void MoveCompareAddSubtractImmediate::Execute(ARM7TDMI& cpu)
 {
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_);
-    }
-
-    bool carryOut = cpu.registers_.IsCarry();
-    bool overflowOut = cpu.registers_.IsOverflow();
     bool saveResult = true;
     bool updateAllFlags = true;
+    bool carryIn = false;
     uint32_t op1 = cpu.registers_.ReadRegister(instruction_.Rd);
     uint32_t op2 = instruction_.Offset8;
     uint32_t result = 0;
@@ -1029,28 +936,28 @@ void MoveCompareAddSubtractImmediate::Execute(ARM7TDMI& cpu)
     switch (instruction_.Op)
     {
         case 0b00:  // MOV
-            result = op2;
             updateAllFlags = false;
             break;
         case 0b01:  // CMP
-            std::tie(carryOut, overflowOut) = Sub32(op1, op2, result);
+            std::tie(op2, carryIn) = std::pair(~op2, true);
             saveResult = false;
             break;
         case 0b10:  // ADD
-            std::tie(carryOut, overflowOut) = Add32(op1, op2, result);
             break;
         case 0b11:  // SUB
-            std::tie(carryOut, overflowOut) = Sub32(op1, op2, result);
+            std::tie(op2, carryIn) = std::pair(~op2, true);
             break;
     }
 
-    cpu.registers_.SetNegative(result & MSB_32);
-    cpu.registers_.SetZero(result == 0);
-
     if (updateAllFlags)
     {
-        cpu.registers_.SetCarry(carryOut);
-        cpu.registers_.SetOverflow(overflowOut);
+        result = AddWithCarry(op1, op2, carryIn);
+        cpu.registers_.SetArithmeticFlags(op1, op2, carryIn, result);
+    }
+    else
+    {
+        result = op2;
+        cpu.registers_.SetNZFlags(result);
     }
 
     if (saveResult)
@@ -1061,40 +968,24 @@ void MoveCompareAddSubtractImmediate::Execute(ARM7TDMI& cpu)
 
 void AddSubtract::Execute(ARM7TDMI& cpu)
 {
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_);
-    }
-
     uint32_t op1 = cpu.registers_.ReadRegister(instruction_.Rs);
     uint32_t op2 = instruction_.I ? instruction_.RnOffset3 : cpu.registers_.ReadRegister(instruction_.RnOffset3);
-    bool carryOut;
-    bool overflowOut;
-    uint32_t result;
+    bool carryIn = false;
 
     if (instruction_.Op)
     {
-        std::tie(carryOut, overflowOut) = Sub32(op1, op2, result);
-    }
-    else
-    {
-        std::tie(carryOut, overflowOut) = Add32(op1, op2, result);
+        // SUB
+        op2 = ~op2;
+        carryIn = true;
     }
 
-    cpu.registers_.SetNegative(result & MSB_32);
-    cpu.registers_.SetZero(result == 0);
-    cpu.registers_.SetCarry(carryOut);
-    cpu.registers_.SetOverflow(overflowOut);
+    uint32_t result = AddWithCarry(op1, op2, carryIn);
+    cpu.registers_.SetArithmeticFlags(op1, op2, carryIn, result);
     cpu.registers_.WriteRegister(instruction_.Rd, result);
 }
 
 void MoveShiftedRegister::Execute(ARM7TDMI& cpu)
 {
-    if (LogMgr.CpuLoggingEnabled())
-    {
-        SetMnemonic(cpu.mnemonic_);
-    }
-
     bool carryOut = cpu.registers_.IsCarry();
 
     uint32_t result = 0;
@@ -1160,9 +1051,7 @@ void MoveShiftedRegister::Execute(ARM7TDMI& cpu)
         }
     }
 
-    cpu.registers_.SetNegative(result & MSB_32);
-    cpu.registers_.SetZero(result == 0);
-    cpu.registers_.SetCarry(carryOut);
+    cpu.registers_.SetLogicalFlags(result, carryOut);
     cpu.registers_.WriteRegister(instruction_.Rd, result);
 }
 }
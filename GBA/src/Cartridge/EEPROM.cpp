@@ -4,30 +4,38 @@
 #include <fstream>
 #include <utility>
 #include <vector>
+#include <Cartridge/SaveFile.hpp>
 #include <System/SystemControl.hpp>
 #include <Utilities/MemoryUtilities.hpp>
+#include <Utilities/StateSerializer.hpp>
 
 namespace Cartridge
 {
-EEPROM::EEPROM(fs::path savePath) :
-    savePath_(savePath)
+EEPROM::EEPROM(fs::path savePath, size_t sizeInBytes, EventScheduler const& scheduler, SystemControl const& systemControl) :
+    saveFile_(savePath, scheduler),
+    systemControl_(systemControl)
 {
     if (fs::exists(savePath))
     {
-        size_t sizeInBytes = fs::file_size(savePath);
+        size_t saveSizeInBytes = fs::file_size(savePath);
 
-        if ((sizeInBytes == 512) || (sizeInBytes == 8 * KiB))
+        if ((saveSizeInBytes == 512) || (saveSizeInBytes == 8 * KiB))
         {
-            eeprom_.resize(sizeInBytes / sizeof(uint64_t));
+            eeprom_.resize(saveSizeInBytes / sizeof(uint64_t));
             std::ifstream saveFile(savePath, std::ios::binary);
 
             if (!saveFile.fail())
             {
-                saveFile.read(reinterpret_cast<char*>(eeprom_.data()), sizeInBytes);
+                saveFile.read(reinterpret_cast<char*>(eeprom_.data()), saveSizeInBytes);
             }
         }
     }
 
+    if (eeprom_.empty() && ((sizeInBytes == 512) || (sizeInBytes == 8 * KiB)))
+    {
+        eeprom_.resize(sizeInBytes / sizeof(uint64_t), MAX_U64);
+    }
+
     currentIndex_ = MAX_U16;
 }
 
@@ -35,12 +43,7 @@ EEPROM::~EEPROM()
 {
     if (!eeprom_.empty())
     {
-        std::ofstream saveFile(savePath_, std::ios::binary);
-
-        if (!saveFile.fail())
-        {
-            saveFile.write(reinterpret_cast<char*>(eeprom_.data()), eeprom_.size() * sizeof(eeprom_[0]));
-        }
+        saveFile_.Flush(reinterpret_cast<uint8_t const*>(eeprom_.data()), eeprom_.size() * sizeof(eeprom_[0]));
     }
 }
 
@@ -53,7 +56,7 @@ std::pair<uint32_t, int> EEPROM::Read(uint32_t addr, AccessSize alignment)
 {
     (void)addr;
     int cycles = 1;
-    cycles += SystemController.WaitStates(WaitState::TWO, false, alignment);
+    cycles += systemControl_.WaitStates(WaitState::TWO, false, alignment);
     return {1, cycles};
 }
 
@@ -62,15 +65,15 @@ int EEPROM::Write(uint32_t addr, uint32_t value, AccessSize alignment)
     (void)addr;
     (void)value;
     int cycles = 1;
-    cycles += SystemController.WaitStates(WaitState::TWO, false, alignment);
+    cycles += systemControl_.WaitStates(WaitState::TWO, false, alignment);
     return cycles;
 }
 
 int EEPROM::SetIndex(size_t index, size_t indexLength)
 {
     int cycles = indexLength + 3;
-    cycles += SystemController.WaitStates(WaitState::TWO, false, AccessSize::HALFWORD) +
-              (SystemController.WaitStates(WaitState::TWO, true, AccessSize::HALFWORD) * (indexLength + 2));
+    cycles += systemControl_.WaitStates(WaitState::TWO, false, AccessSize::HALFWORD) +
+              (systemControl_.WaitStates(WaitState::TWO, true, AccessSize::HALFWORD) * (indexLength + 2));
 
     if (eeprom_.empty())
     {
@@ -91,8 +94,8 @@ int EEPROM::SetIndex(size_t index, size_t indexLength)
 std::pair<uint64_t, int> EEPROM::ReadDoubleWord()
 {
     int cycles = 68;
-    cycles += SystemController.WaitStates(WaitState::TWO, false, AccessSize::HALFWORD) +
-              (SystemController.WaitStates(WaitState::TWO, true, AccessSize::HALFWORD) * 67);
+    cycles += systemControl_.WaitStates(WaitState::TWO, false, AccessSize::HALFWORD) +
+              (systemControl_.WaitStates(WaitState::TWO, true, AccessSize::HALFWORD) * 67);
 
     if (eeprom_.empty() || (currentIndex_ >= eeprom_.size()))
     {
@@ -105,8 +108,8 @@ std::pair<uint64_t, int> EEPROM::ReadDoubleWord()
 int EEPROM::WriteDoubleWord(size_t index, size_t indexLength, uint64_t value)
 {
     int cycles = 67 + indexLength;
-    cycles += SystemController.WaitStates(WaitState::TWO, false, AccessSize::HALFWORD) +
-              (SystemController.WaitStates(WaitState::TWO, true, AccessSize::HALFWORD) * (indexLength + 66));
+    cycles += systemControl_.WaitStates(WaitState::TWO, false, AccessSize::HALFWORD) +
+              (systemControl_.WaitStates(WaitState::TWO, true, AccessSize::HALFWORD) * (indexLength + 66));
 
     if (eeprom_.empty())
     {
@@ -125,8 +128,30 @@ int EEPROM::WriteDoubleWord(size_t index, size_t indexLength, uint64_t value)
     if (!eeprom_.empty() && (index < eeprom_.size()))
     {
         eeprom_[index] = value;
+        saveFile_.MarkDirty();
     }
 
     return cycles;
 }
+
+void EEPROM::CheckSaveFlush()
+{
+    if (!eeprom_.empty() && saveFile_.FlushDue())
+    {
+        saveFile_.Flush(reinterpret_cast<uint8_t const*>(eeprom_.data()), eeprom_.size() * sizeof(eeprom_[0]));
+    }
+}
+
+void EEPROM::Serialize(StateSerializer& state)
+{
+    state.Value(currentIndex_);
+
+    bool changed = state.Loading() && !state.VectorUnchanged(eeprom_);
+    state.Vector(eeprom_);
+
+    if (changed)
+    {
+        saveFile_.MarkDirty();
+    }
+}
 }
@@ -6,14 +6,20 @@
 #include <fstream>
 #include <utility>
 #include <vector>
+#include <Cartridge/SaveFile.hpp>
 #include <System/MemoryMap.hpp>
 #include <System/SystemControl.hpp>
 #include <Utilities/MemoryUtilities.hpp>
+#include <Utilities/StateSerializer.hpp>
 
 namespace Cartridge
 {
-Flash::Flash(fs::path savePath, size_t flashSizeInBytes) :
-    savePath_(savePath)
+Flash::Flash(fs::path savePath,
+             size_t flashSizeInBytes,
+             EventScheduler const& scheduler,
+             SystemControl const& systemControl) :
+    saveFile_(savePath, scheduler),
+    systemControl_(systemControl)
 {
     if (flashSizeInBytes == FLASH_BANK_SIZE)
     {
@@ -47,15 +53,7 @@ Flash::~Flash()
 {
     if (!flash_.empty())
     {
-        std::ofstream saveFile(savePath_, std::ios::binary);
-
-        if (!saveFile.fail())
-        {
-            for (auto& bank : flash_)
-            {
-                saveFile.write(reinterpret_cast<char*>(bank.data()), bank.size());
-            }
-        }
+        saveFile_.Flush(flash_.front().data(), flash_.size() * FLASH_BANK_SIZE);
     }
 }
 
@@ -76,7 +74,7 @@ std::pair<uint32_t, int> Flash::Read(uint32_t addr, AccessSize alignment)
 
     uint32_t value = 0;
     int cycles = 1;
-    cycles += SystemController.WaitStates(WaitState::SRAM, false, alignment);
+    cycles += systemControl_.WaitStates(WaitState::SRAM, false, alignment);
 
     if (chipIdMode_ && (addr == 0x0E00'0000))
     {
@@ -104,7 +102,7 @@ int Flash::Write(uint32_t addr, uint32_t value, AccessSize alignment)
 {
     uint8_t byte = value & MAX_U8;
     int cycles = 1;
-    cycles += SystemController.WaitStates(WaitState::SRAM, false, alignment);
+    cycles += systemControl_.WaitStates(WaitState::SRAM, false, alignment);
 
     if (alignment != AccessSize::BYTE)
     {
@@ -202,6 +200,8 @@ int Flash::Write(uint32_t addr, uint32_t value, AccessSize alignment)
                             std::fill(bank.begin(), bank.end(), 0xFF);
                         }
 
+                        saveFile_.MarkDirty();
+
                         state_ = FlashState::READY;
                     }
 
@@ -213,6 +213,7 @@ int Flash::Write(uint32_t addr, uint32_t value, AccessSize alignment)
                     auto blockStart = flash_.at(bank_).begin() + block;
                     auto blockEnd = flash_.at(bank_).begin() + block + 0x1000;
                     std::fill(blockStart, blockEnd, 0xFF);
+                    saveFile_.MarkDirty();
                     state_ = FlashState::READY;
                     break;
                 }
@@ -226,6 +227,7 @@ int Flash::Write(uint32_t addr, uint32_t value, AccessSize alignment)
         {
             size_t index = addr - SRAM_ADDR_MIN;
             flash_.at(bank_).at(index) = byte;
+            saveFile_.MarkDirty();
             state_ = FlashState::READY;
             break;
         }
@@ -244,4 +246,28 @@ int Flash::Write(uint32_t addr, uint32_t value, AccessSize alignment)
 
     return cycles;
 }
+
+void Flash::CheckSaveFlush()
+{
+    if (!flash_.empty() && saveFile_.FlushDue())
+    {
+        saveFile_.Flush(flash_.front().data(), flash_.size() * FLASH_BANK_SIZE);
+    }
+}
+
+void Flash::Serialize(StateSerializer& state)
+{
+    state.Value(state_);
+    state.Value(chipIdMode_);
+    state.Value(eraseMode_);
+    state.Value(bank_);
+
+    bool changed = state.Loading() && !state.VectorUnchanged(flash_);
+    state.Vector(flash_);
+
+    if (changed)
+    {
+        saveFile_.MarkDirty();
+    }
+}
 }
@@ -1,56 +1,85 @@
 #include <Cartridge/GamePak.hpp>
 #include <algorithm>
+#include <array>
+#include <cctype>
 #include <cstdint>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <memory>
+#include <optional>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <utility>
 #include <vector>
 #include <Cartridge/EEPROM.hpp>
 #include <Cartridge/Flash.hpp>
+#include <Cartridge/RomDatabase.hpp>
 #include <Cartridge/SRAM.hpp>
+#include <Config.hpp>
 #include <System/EventScheduler.hpp>
 #include <System/MemoryMap.hpp>
 #include <System/SystemControl.hpp>
+#include <Utilities/MappedFile.hpp>
 #include <Utilities/MemoryUtilities.hpp>
+#include <Utilities/StateSerializer.hpp>
 
 namespace Cartridge
 {
-GamePak::GamePak(fs::path const romPath) :
+GamePak::GamePak(fs::path const romPath, EventScheduler const& scheduler, SystemControl const& systemControl) :
     romLoaded_(false),
     romTitle_(""),
     romPath_(romPath),
+    headerCrc_(0),
+    mappedROM_(nullptr),
+    romData_(nullptr),
+    romSize_(0),
     backupType_(BackupType::None),
     eeprom_(nullptr),
     flash_(nullptr),
-    sram_(nullptr)
+    sram_(nullptr),
+    scheduler_(scheduler),
+    systemControl_(systemControl)
 {
     if (romPath.empty())
     {
         return;
     }
 
-    // Load ROM data into memory.
-    auto const fileSizeInBytes = fs::file_size(romPath);
-    ROM_.resize(fileSizeInBytes);
-    std::ifstream rom(romPath, std::ios::binary);
+    // Map ROM data into memory, or read it in if the file can't be mapped.
+    mappedROM_ = std::make_shared<MappedFile>(romPath);
 
-    if (rom.fail())
+    if (mappedROM_->Mapped())
     {
-        return;
+        romData_ = mappedROM_->Data();
+        romSize_ = mappedROM_->Size();
     }
+    else
+    {
+        mappedROM_.reset();
+        auto const fileSizeInBytes = fs::file_size(romPath);
+        ROM_ = std::make_shared<std::vector<uint8_t>>(fileSizeInBytes);
+        std::ifstream rom(romPath, std::ios::binary);
+
+        if (rom.fail())
+        {
+            return;
+        }
 
-    rom.read(reinterpret_cast<char*>(ROM_.data()), fileSizeInBytes);
+        rom.read(reinterpret_cast<char*>(ROM_->data()), fileSizeInBytes);
+        romData_ = ROM_->data();
+        romSize_ = ROM_->size();
+    }
 
     // Read game title from cartridge header.
     std::stringstream titleStream;
 
     for (size_t charIndex = 0; charIndex < 12; ++charIndex)
     {
-        uint8_t titleChar = ROM_.at(0x00A0 + charIndex);
+        uint8_t titleChar = (romSize_ > (0x00A0 + charIndex)) ? romData_[0x00A0 + charIndex] : 0;
 
         if (titleChar == 0)
         {
@@ -62,9 +91,37 @@ GamePak::GamePak(fs::path const romPath) :
 
     romTitle_ = titleStream.str();
 
-    // Setup backup media and load save file if present
+    // Look up backup media in the ROM database, or scan the ROM for it and cache the result
     size_t backupSizeInBytes = 0;
-    std::tie(backupType_, backupSizeInBytes) = DetectBackupType();
+    RomDatabase database(ROM_DATABASE_PATH);
+    std::string gameCode;
+    std::optional<RomInfo> romInfo;
+
+    if (romSize_ >= CARTRIDGE_HEADER_SIZE)
+    {
+        gameCode.assign(reinterpret_cast<char const*>(&romData_[GAME_CODE_OFFSET]), 4);
+
+        // Homebrew often leaves the game code blank, so keep database entries to one whitespace separated token
+        std::replace_if(gameCode.begin(), gameCode.end(), [](char c) { return !std::isalnum(static_cast<unsigned char>(c)); }, '_');
+        headerCrc_ = RomDatabase::Crc32(romData_, CARTRIDGE_HEADER_SIZE);
+        romInfo = database.Lookup(gameCode, headerCrc_);
+    }
+
+    if (romInfo.has_value())
+    {
+        backupType_ = romInfo->backupType_;
+        backupSizeInBytes = romInfo->backupSize_;
+    }
+    else
+    {
+        std::tie(backupType_, backupSizeInBytes) = DetectBackupType();
+
+        if (romSize_ >= CARTRIDGE_HEADER_SIZE)
+        {
+            database.Store(gameCode, headerCrc_, {backupType_, backupSizeInBytes});
+        }
+    }
+
     fs::path savePath = romPath;
     savePath.replace_extension("sav");
 
@@ -73,19 +130,54 @@ GamePak::GamePak(fs::path const romPath) :
         case BackupType::None:
             break;
         case BackupType::SRAM:
-            sram_ = std::make_unique<SRAM>(savePath);
+            sram_ = std::make_unique<SRAM>(savePath, scheduler_, systemControl_);
             break;
         case BackupType::EEPROM:
-            eeprom_ = std::make_unique<EEPROM>(savePath);
+            eeprom_ = std::make_unique<EEPROM>(savePath, backupSizeInBytes, scheduler_, systemControl_);
             break;
         case BackupType::FLASH:
-            flash_ = std::make_unique<Flash>(savePath, backupSizeInBytes);
+            flash_ = std::make_unique<Flash>(savePath, backupSizeInBytes, scheduler_, systemControl_);
             break;
     }
 
     romLoaded_ = true;
 }
 
+GamePak::GamePak(GamePak const& parent, EventScheduler const& scheduler, SystemControl const& systemControl) :
+    romLoaded_(parent.romLoaded_),
+    romTitle_(parent.romTitle_),
+    romPath_(parent.romPath_),
+    headerCrc_(parent.headerCrc_),
+    mappedROM_(parent.mappedROM_),
+    ROM_(parent.ROM_),
+    romData_(parent.romData_),
+    romSize_(parent.romSize_),
+    backupType_(parent.backupType_),
+    eeprom_(nullptr),
+    flash_(nullptr),
+    sram_(nullptr),
+    scheduler_(scheduler),
+    systemControl_(systemControl)
+{
+    // Contents of backup media come from the state that's loaded after cloning
+    switch (backupType_)
+    {
+        case BackupType::None:
+            break;
+        case BackupType::SRAM:
+            sram_ = std::make_unique<SRAM>(fs::path(), scheduler_, systemControl_);
+            break;
+        case BackupType::EEPROM:
+            eeprom_ = std::make_unique<EEPROM>(fs::path(), parent.eeprom_->Size(), scheduler_, systemControl_);
+            break;
+        case BackupType::FLASH:
+            flash_ = std::make_unique<Flash>(fs::path(), parent.flash_->Size(), scheduler_, systemControl_);
+            break;
+    }
+
+    Reset();
+}
+
 void GamePak::Reset()
 {
     if (eeprom_ != nullptr)
@@ -151,7 +243,7 @@ bool GamePak::EepromAccess(uint32_t addr) const
         return false;
     }
 
-    if (ROM_.size() > (16 * MiB))
+    if (romSize_ > (16 * MiB))
     {
         return (EEPROM_ADDR_LARGE_CART_MIN <= addr) && (addr <= EEPROM_ADDR_MAX);
     }
@@ -206,6 +298,125 @@ int GamePak::WriteToEeprom(size_t index, int indexLength, uint64_t value)
     return cycles;
 }
 
+int GamePak::RomAccessCycles(uint32_t addr, AccessSize alignment)
+{
+    auto region = static_cast<WaitState>(((addr >> 24) - 0x08) / 2);
+    addr = GAME_PAK_ADDR_MIN + ((addr - GAME_PAK_ADDR_MIN) % MAX_ROM_SIZE);
+    return AccessTiming(addr, region, alignment, static_cast<uint32_t>(scheduler_.TotalCycles()));
+}
+
+std::pair<uint32_t, int> GamePak::RomBurstCycles(uint32_t addr,
+                                                 AccessSize alignment,
+                                                 uint32_t maxCount,
+                                                 int maxCycles,
+                                                 int cyclesBetweenAccesses)
+{
+    auto region = static_cast<WaitState>(((addr >> 24) - 0x08) / 2);
+    addr = GAME_PAK_ADDR_MIN + ((addr - GAME_PAK_ADDR_MIN) % MAX_ROM_SIZE);
+    uint32_t unitSize = static_cast<uint32_t>(alignment);
+
+    uint32_t currentCycle = static_cast<uint32_t>(scheduler_.TotalCycles());
+
+    if (systemControl_.GamePakPrefetchEnabled())
+    {
+        // The scheduler isn't advanced until the whole burst is done, so keep a local clock for the prefetcher to fill against
+        uint32_t count = 0;
+        int cycles = 0;
+        int64_t totalCycles = 0;
+
+        while ((count < maxCount) && (totalCycles < maxCycles))
+        {
+            int accessCycles = AccessTiming(addr + (count * unitSize), region, alignment, currentCycle);
+            cycles += accessCycles;
+            totalCycles += accessCycles + cyclesBetweenAccesses;
+            currentCycle += accessCycles + cyclesBetweenAccesses;
+            ++count;
+        }
+
+        return {count, cycles};
+    }
+
+    // Without prefetch, every access after the first is sequential with a fixed cost
+    int cycles = AccessTiming(addr, region, alignment, currentCycle);
+    int64_t remainingCycles = static_cast<int64_t>(maxCycles) - cycles - cyclesBetweenAccesses;
+
+    if ((maxCount == 1) || (remainingCycles <= 0))
+    {
+        return {1, cycles};
+    }
+
+    int sequentialCycles = 1 + systemControl_.WaitStates(region, true, alignment);
+    int64_t cyclesPerAccess = sequentialCycles + cyclesBetweenAccesses;
+    int64_t extraCount = (remainingCycles + cyclesPerAccess - 1) / cyclesPerAccess;
+    uint32_t count = static_cast<uint32_t>(std::min<int64_t>(maxCount, 1 + extraCount));
+    cycles += (count - 1) * sequentialCycles;
+    nextSequentialAddr_ = addr + (count * unitSize);
+    lastReadCompletionCycle_ = currentCycle + cycles + ((count - 1) * cyclesBetweenAccesses);
+    return {count, cycles};
+}
+
+size_t GamePak::BackupSize() const
+{
+    if (eeprom_ != nullptr)
+    {
+        return eeprom_->Size();
+    }
+    else if (flash_ != nullptr)
+    {
+        return flash_->Size();
+    }
+    else if (sram_ != nullptr)
+    {
+        return sram_->Size();
+    }
+
+    return 0;
+}
+
+void GamePak::CheckSaveFlush()
+{
+    if (eeprom_ != nullptr)
+    {
+        eeprom_->CheckSaveFlush();
+    }
+    else if (flash_ != nullptr)
+    {
+        flash_->CheckSaveFlush();
+    }
+    else if (sram_ != nullptr)
+    {
+        sram_->CheckSaveFlush();
+    }
+}
+
+void GamePak::Serialize(StateSerializer& state)
+{
+    BackupType backupType = backupType_;
+    state.Value(backupType);
+
+    if (backupType != backupType_)
+    {
+        throw std::runtime_error("Save state has a different type of backup media");
+    }
+
+    if (eeprom_ != nullptr)
+    {
+        eeprom_->Serialize(state);
+    }
+    else if (flash_ != nullptr)
+    {
+        flash_->Serialize(state);
+    }
+    else if (sram_ != nullptr)
+    {
+        sram_->Serialize(state);
+    }
+
+    state.Value(nextSequentialAddr_);
+    state.Value(lastReadCompletionCycle_);
+    state.Value(prefetchedWaitStates_);
+}
+
 std::tuple<uint32_t, int, bool> GamePak::ReadROM(uint32_t addr, AccessSize alignment)
 {
     uint32_t value = 0;
@@ -232,83 +443,101 @@ std::tuple<uint32_t, int, bool> GamePak::ReadROM(uint32_t addr, AccessSize align
 
     size_t index = addr - GAME_PAK_ADDR_MIN;
 
-    if (index >= ROM_.size())
+    if (index >= romSize_)
     {
         return {value, cycles, true};
     }
 
+    cycles = AccessTiming(addr, region, alignment, static_cast<uint32_t>(scheduler_.TotalCycles()));
+    uint8_t* bytePtr = &romData_[index];
+    value = ReadPointer(bytePtr, alignment);
+    return {value, cycles, false};
+}
+
+int GamePak::AccessTiming(uint32_t addr, WaitState region, AccessSize alignment, uint32_t currentCycle)
+{
     bool sequential = (addr == nextSequentialAddr_);
-    uint64_t currentCycle = Scheduler.TotalCycles();
-    int waitStates = SystemController.WaitStates(region, sequential, alignment);
+    int waitStates = systemControl_.WaitStates(region, sequential, alignment);
+    nextSequentialAddr_ = addr + static_cast<uint8_t>(alignment);
 
-    if (SystemController.GamePakPrefetchEnabled())
+    if (sequential && systemControl_.GamePakPrefetchEnabled())
     {
-        if (sequential)
-        {
-            int maxPrefetchedWaitStates = 8 * SystemController.WaitStates(region, true, AccessSize::HALFWORD);
-            prefetchedWaitStates_ = std::min(prefetchedWaitStates_ + (currentCycle - lastReadCompletionCycle_),
-                                             static_cast<uint64_t>(maxPrefetchedWaitStates));
-
-            if (prefetchedWaitStates_ >= waitStates)
-            {
-                prefetchedWaitStates_ -= waitStates;
-                waitStates = 0;
-            }
-            else
-            {
-                waitStates -= prefetchedWaitStates_;
-                prefetchedWaitStates_ = 0;
-            }
-        }
-        else
-        {
-            prefetchedWaitStates_ = 0;
-        }
+        // The prefetcher fills whenever the Game Pak bus is idle, up to 8 halfwords ahead. Only the low 32 bits of the cycle count
+        // are kept, since the difference between them is all that matters and it's clamped to the buffer size anyway.
+        uint32_t maxPrefetchedWaitStates = 8 * systemControl_.WaitStates(region, true, AccessSize::HALFWORD);
+        uint32_t idleCycles = std::min(currentCycle - lastReadCompletionCycle_, maxPrefetchedWaitStates);
+        int prefetched = std::min(prefetchedWaitStates_ + idleCycles, maxPrefetchedWaitStates);
+        int consumed = std::min(prefetched, waitStates);
+        prefetchedWaitStates_ = prefetched - consumed;
+        waitStates -= consumed;
     }
     else
     {
         prefetchedWaitStates_ = 0;
     }
 
-    uint8_t* bytePtr = &ROM_[index];
-    value = ReadPointer(bytePtr, alignment);
-
-    nextSequentialAddr_ = addr + static_cast<uint8_t>(alignment);
-    cycles += waitStates;
+    int cycles = 1 + waitStates;
     lastReadCompletionCycle_ = currentCycle + cycles;
-
-    return {value, cycles, false};
+    return cycles;
 }
 
 std::pair<BackupType, size_t> GamePak::DetectBackupType()
 {
-    for (size_t i = 0; (i + 11) < ROM_.size(); i += 4)
+    // Every ID string has an underscore at a fixed offset, so search for underscores and check which ID, if any, each one ends.
+    // Underscores found past the start of a match may still belong to an earlier aligned match that's further along.
+    struct BackupId
+    {
+        std::string_view prefix_;
+        size_t underscoreOffset_;
+        BackupType type_;
+        size_t size_;
+    };
+
+    static constexpr std::array<BackupId, 5> backupIds = {{
+        {"EEPROM_V", 6, BackupType::EEPROM, 0},
+        {"SRAM_V", 4, BackupType::SRAM, 32 * KiB},
+        {"FLASH_V", 5, BackupType::FLASH, 64 * KiB},
+        {"FLASH512_V", 8, BackupType::FLASH, 64 * KiB},
+        {"FLASH1M_V", 7, BackupType::FLASH, 128 * KiB}
+    }};
+
+    constexpr size_t maxUnderscoreOffset = 8;
+    constexpr size_t idLength = 12;
+
+    std::pair<BackupType, size_t> backup = {BackupType::None, 0};
+    size_t matchStart = romSize_;
+    uint8_t const* romEnd = romData_ + romSize_;
+    uint8_t const* underscore = romData_;
+
+    while ((underscore = static_cast<uint8_t const*>(std::memchr(underscore, '_', romEnd - underscore))) != nullptr)
     {
-        char* start = reinterpret_cast<char*>(&ROM_[i]);
-        std::string idString;
-        idString.assign(start, 12);
+        size_t underscoreIndex = underscore - romData_;
 
-        if (idString.starts_with("EEPROM_V"))
+        if (underscoreIndex > (matchStart + maxUnderscoreOffset))
         {
-            return {BackupType::EEPROM, 0};
-        }
-        else if (idString.starts_with("SRAM_V"))
-        {
-            return {BackupType::SRAM, 32 * KiB};
+            break;
         }
-        else if (idString.starts_with("FLASH"))
+
+        for (auto const& id : backupIds)
         {
-            if (idString.starts_with("FLASH_V") || idString.starts_with("FLASH512_V"))
+            if (underscoreIndex < id.underscoreOffset_)
             {
-                return {BackupType::FLASH, 64 * KiB};
+                continue;
             }
-            else if (idString.starts_with("FLASH1M_V"))
+
+            size_t start = underscoreIndex - id.underscoreOffset_;
+
+            if (((start % 4) == 0) && (start < matchStart) && ((start + idLength) <= romSize_) &&
+                (std::memcmp(&romData_[start], id.prefix_.data(), id.prefix_.size()) == 0))
             {
-                return {BackupType::FLASH, 128 * KiB};
+                matchStart = start;
+                backup = {id.type_, id.size_};
             }
         }
+
+        ++underscore;
     }
 
-    return {BackupType::None, 0};
+    return backup;
 }
 }
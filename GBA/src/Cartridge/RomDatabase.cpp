@@ -0,0 +1,146 @@
+#include <Cartridge/RomDatabase.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <Utilities/MemoryUtilities.hpp>
+
+namespace
+{
+constexpr std::array<std::pair<Cartridge::BackupType, char const*>, 4> BACKUP_TYPE_NAMES = {{
+    {Cartridge::BackupType::None, "NONE"},
+    {Cartridge::BackupType::SRAM, "SRAM"},
+    {Cartridge::BackupType::EEPROM, "EEPROM"},
+    {Cartridge::BackupType::FLASH, "FLASH"}
+}};
+
+/// @brief Build the lookup table for the reflected CRC-32 polynomial.
+/// @return CRC of each byte value.
+constexpr std::array<uint32_t, 256> BuildCrcTable()
+{
+    std::array<uint32_t, 256> table = {};
+
+    for (uint32_t i = 0; i < 256; ++i)
+    {
+        uint32_t crc = i;
+
+        for (int bit = 0; bit < 8; ++bit)
+        {
+            crc = (crc & 0x01) ? ((crc >> 1) ^ 0xEDB8'8320) : (crc >> 1);
+        }
+
+        table[i] = crc;
+    }
+
+    return table;
+}
+
+constexpr std::array<uint32_t, 256> CRC_TABLE = BuildCrcTable();
+}
+
+namespace Cartridge
+{
+RomDatabase::RomDatabase(fs::path databasePath) :
+    databasePath_(databasePath)
+{
+    if (databasePath_.empty() || !fs::exists(databasePath_))
+    {
+        return;
+    }
+
+    std::ifstream databaseFile(databasePath_);
+    std::string line;
+
+    while (std::getline(databaseFile, line))
+    {
+        if (line.empty() || line.starts_with('#'))
+        {
+            continue;
+        }
+
+        std::istringstream lineStream(line);
+        std::string gameCode;
+        std::string typeName;
+        uint32_t headerCrc;
+        size_t backupSize;
+
+        if (!(lineStream >> gameCode >> std::hex >> headerCrc >> typeName >> std::dec >> backupSize))
+        {
+            continue;
+        }
+
+        for (auto [type, name] : BACKUP_TYPE_NAMES)
+        {
+            if (typeName == name)
+            {
+                entries_[{gameCode, headerCrc}] = {type, backupSize};
+                break;
+            }
+        }
+    }
+}
+
+std::optional<RomInfo> RomDatabase::Lookup(std::string const& gameCode, uint32_t headerCrc) const
+{
+    auto it = entries_.find({gameCode, headerCrc});
+
+    if (it == entries_.end())
+    {
+        return {};
+    }
+
+    return it->second;
+}
+
+void RomDatabase::Store(std::string const& gameCode, uint32_t headerCrc, RomInfo info)
+{
+    entries_[{gameCode, headerCrc}] = info;
+
+    if (databasePath_.empty())
+    {
+        return;
+    }
+
+    std::ofstream databaseFile(databasePath_, std::ios::app);
+
+    if (databaseFile.fail())
+    {
+        return;
+    }
+
+    char const* typeName = "NONE";
+
+    for (auto [type, name] : BACKUP_TYPE_NAMES)
+    {
+        if (type == info.backupType_)
+        {
+            typeName = name;
+            break;
+        }
+    }
+
+    std::ostringstream entry;
+    entry << gameCode << ' ' << std::hex << std::uppercase << std::setw(8) << std::setfill('0') << headerCrc << ' ' << typeName
+          << ' ' << std::dec << info.backupSize_;
+    databaseFile << entry.str() << '\n';
+}
+
+uint32_t RomDatabase::Crc32(uint8_t const* data, size_t length)
+{
+    uint32_t crc = MAX_U32;
+
+    for (size_t i = 0; i < length; ++i)
+    {
+        crc = CRC_TABLE[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return ~crc;
+}
+}
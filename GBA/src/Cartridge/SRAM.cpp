@@ -5,14 +5,17 @@
 #include <filesystem>
 #include <fstream>
 #include <utility>
+#include <Cartridge/SaveFile.hpp>
 #include <System/MemoryMap.hpp>
 #include <System/SystemControl.hpp>
 #include <Utilities/MemoryUtilities.hpp>
+#include <Utilities/StateSerializer.hpp>
 
 namespace Cartridge
 {
-SRAM::SRAM(fs::path savePath) :
-    savePath_(savePath)
+SRAM::SRAM(fs::path savePath, EventScheduler const& scheduler, SystemControl const& systemControl) :
+    saveFile_(savePath, scheduler),
+    systemControl_(systemControl)
 {
     if (fs::exists(savePath) && (fs::file_size(savePath) == sram_.size()))
     {
@@ -31,18 +34,13 @@ SRAM::SRAM(fs::path savePath) :
 
 SRAM::~SRAM()
 {
-    std::ofstream saveFile(savePath_, std::ios::binary);
-
-    if (!saveFile.fail())
-    {
-        saveFile.write(reinterpret_cast<char*>(sram_.data()), sram_.size());
-    }
+    saveFile_.Flush(sram_.data(), sram_.size());
 }
 
 std::pair<uint32_t, int> SRAM::Read(uint32_t addr, AccessSize alignment)
 {
     int cycles = 1;
-    cycles += SystemController.WaitStates(WaitState::SRAM, false, alignment);
+    cycles += systemControl_.WaitStates(WaitState::SRAM, false, alignment);
     size_t index = (addr - SRAM_ADDR_MIN) % sram_.size();
     uint32_t value = sram_[index];
 
@@ -57,7 +55,7 @@ std::pair<uint32_t, int> SRAM::Read(uint32_t addr, AccessSize alignment)
 int SRAM::Write(uint32_t addr, uint32_t value, AccessSize alignment)
 {
     int cycles = 1;
-    cycles += SystemController.WaitStates(WaitState::SRAM, false, alignment);
+    cycles += systemControl_.WaitStates(WaitState::SRAM, false, alignment);
 
     if (alignment != AccessSize::BYTE)
     {
@@ -66,6 +64,28 @@ int SRAM::Write(uint32_t addr, uint32_t value, AccessSize alignment)
 
     size_t index = (addr - SRAM_ADDR_MIN) % sram_.size();
     sram_[index] = value;
+    saveFile_.MarkDirty();
     return cycles;
 }
+
+void SRAM::CheckSaveFlush()
+{
+    if (saveFile_.FlushDue())
+    {
+        saveFile_.Flush(sram_.data(), sram_.size());
+    }
+}
+
+void SRAM::Serialize(StateSerializer& state)
+{
+    // Only restart the save file's flush countdown if loading actually changed the backup, so that frequently loaded states
+    // don't keep postponing the flush
+    bool changed = state.Loading() && !state.Unchanged(sram_);
+    state.Value(sram_);
+
+    if (changed)
+    {
+        saveFile_.MarkDirty();
+    }
+}
 }
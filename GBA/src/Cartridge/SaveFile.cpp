@@ -0,0 +1,137 @@
+#include <Cartridge/SaveFile.hpp>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <System/EventScheduler.hpp>
+
+namespace Cartridge
+{
+SaveFile::SaveFile(fs::path savePath, EventScheduler const& scheduler) :
+    savePath_(savePath),
+    dirty_(false),
+    lastWriteCycle_(0),
+    scheduler_(scheduler),
+    writePending_(false),
+    stop_(false),
+    writerThread_()
+{
+    if (!savePath_.empty())
+    {
+        writerThread_ = std::thread(&SaveFile::WriterLoop, this);
+    }
+}
+
+SaveFile::~SaveFile()
+{
+    if (!writerThread_.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        stop_ = true;
+    }
+
+    cv_.notify_one();
+    writerThread_.join();
+}
+
+void SaveFile::MarkDirty()
+{
+    dirty_ = true;
+    lastWriteCycle_ = scheduler_.TotalCycles();
+}
+
+bool SaveFile::FlushDue() const
+{
+    if (!dirty_)
+    {
+        return false;
+    }
+
+    // The cycle counter restarts when the system is reset
+    uint64_t currentCycle = scheduler_.TotalCycles();
+    return (currentCycle < lastWriteCycle_) || ((currentCycle - lastWriteCycle_) >= SAVE_FLUSH_DELAY_CYCLES);
+}
+
+void SaveFile::Flush(uint8_t const* data, size_t size)
+{
+    if (!writerThread_.joinable())
+    {
+        dirty_ = false;
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        pendingData_.assign(data, data + size);
+        writePending_ = true;
+    }
+
+    dirty_ = false;
+    cv_.notify_one();
+}
+
+void SaveFile::WriterLoop()
+{
+    std::vector<uint8_t> data;
+    std::unique_lock<std::mutex> lock(lock_);
+
+    while (true)
+    {
+        cv_.wait(lock, [this]() { return writePending_ || stop_; });
+
+        if (writePending_)
+        {
+            data.swap(pendingData_);
+            writePending_ = false;
+            lock.unlock();
+            WriteAtomically(data);
+            lock.lock();
+        }
+        else if (stop_)
+        {
+            return;
+        }
+    }
+}
+
+void SaveFile::WriteAtomically(std::vector<uint8_t> const& data)
+{
+    fs::path tempPath = savePath_;
+    tempPath += ".tmp";
+
+    {
+        std::ofstream tempFile(tempPath, std::ios::binary | std::ios::trunc);
+
+        if (tempFile.fail())
+        {
+            return;
+        }
+
+        tempFile.write(reinterpret_cast<char const*>(data.data()), data.size());
+        tempFile.flush();
+
+        if (tempFile.fail())
+        {
+            return;
+        }
+    }
+
+    std::error_code error;
+    fs::rename(tempPath, savePath_, error);
+
+    if (error)
+    {
+        fs::remove(tempPath, error);
+    }
+}
+}
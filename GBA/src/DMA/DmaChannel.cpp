@@ -1,12 +1,16 @@
 #include <DMA/DmaChannel.hpp>
+#include <array>
 #include <cstdint>
+#include <cstring>
+#include <limits>
 #include <utility>
 #include <System/GameBoyAdvance.hpp>
 #include <System/MemoryMap.hpp>
 #include <System/SystemControl.hpp>
 #include <Utilities/MemoryUtilities.hpp>
+#include <Utilities/StateSerializer.hpp>
 
-DmaChannel::DmaChannel(int index, InterruptType interrupt, GameBoyAdvance& gba) :
+DmaChannel::DmaChannel(int index, InterruptType interrupt, GameBoyAdvance& gba, SystemControl& systemControl) :
     dmaRegisters_(),
     sad_(*reinterpret_cast<uint32_t*>(&dmaRegisters_[0])),
     dad_(*reinterpret_cast<uint32_t*>(&dmaRegisters_[4])),
@@ -14,7 +18,8 @@ DmaChannel::DmaChannel(int index, InterruptType interrupt, GameBoyAdvance& gba)
     dmacnt_(*reinterpret_cast<DMACNT*>(&dmaRegisters_[10])),
     channelIndex_(index),
     interruptType_(interrupt),
-    gba_(gba)
+    gba_(gba),
+    systemControl_(systemControl)
 {
 }
 
@@ -26,6 +31,14 @@ void DmaChannel::Reset()
     internalWordCount_ = 0;
 }
 
+void DmaChannel::Serialize(StateSerializer& state)
+{
+    state.Value(dmaRegisters_);
+    state.Value(internalSrcAddr_);
+    state.Value(internalDestAddr_);
+    state.Value(internalWordCount_);
+}
+
 std::pair<uint32_t, bool> DmaChannel::ReadReg(uint32_t addr, AccessSize alignment)
 {
     uint32_t value = 0;
@@ -87,9 +100,34 @@ int DmaChannel::Execute()
     }
     else
     {
-        xferTime = ExecuteNormalXfer();
+        return ExecuteChunk(std::numeric_limits<int>::max()).first;
+    }
+
+    CompleteXfer();
+    return xferTime;
+}
+
+bool DmaChannel::Interruptible() const
+{
+    return !gba_.gamePak_->EepromAccess(internalSrcAddr_) && !gba_.gamePak_->EepromAccess(internalDestAddr_) && !IsFifoXfer();
+}
+
+std::pair<int, bool> DmaChannel::ExecuteChunk(int maxCycles)
+{
+    int xferCycles = ExecuteNormalXfer(maxCycles);
+
+    if (internalWordCount_ > 0)
+    {
+        // A transfer that disabled its own channel ends early
+        return {xferCycles, !dmacnt_.enable};
     }
 
+    CompleteXfer();
+    return {xferCycles, true};
+}
+
+void DmaChannel::CompleteXfer()
+{
     if (dmacnt_.repeat)
     {
         internalWordCount_ = wordCount_ & ((channelIndex_ == 3) ? 0xFFFF : 0x3FFF);
@@ -112,13 +150,11 @@ int DmaChannel::Execute()
 
     if (dmacnt_.irq)
     {
-        SystemController.RequestInterrupt(interruptType_);
+        systemControl_.RequestInterrupt(interruptType_);
     }
-
-    return xferTime;
 }
 
-int DmaChannel::ExecuteNormalXfer()
+int DmaChannel::ExecuteNormalXfer(int maxCycles)
 {
     int xferCycles = 0;
     AccessSize alignment = dmacnt_.xferType ? AccessSize::WORD : AccessSize::HALFWORD;
@@ -153,8 +189,31 @@ int DmaChannel::ExecuteNormalXfer()
             break;
     }
 
-    while (internalWordCount_ > 0)
+    // Runs between plain memory are copied in bulk. Decrementing addresses and fixed destinations are rare enough to always take
+    // the per-unit path.
+    bool bulkEligible = (srcAddrDelta >= 0) && (destAddrDelta > 0);
+
+    while ((internalWordCount_ > 0) && (xferCycles < maxCycles) && dmacnt_.enable)
     {
+        if (bulkEligible)
+        {
+            auto [units, cycles] = gba_.CopyMemory(internalSrcAddr_,
+                                                   internalDestAddr_,
+                                                   internalWordCount_,
+                                                   alignment,
+                                                   srcAddrDelta == 0,
+                                                   maxCycles - xferCycles);
+
+            if (units > 0)
+            {
+                xferCycles += cycles;
+                internalWordCount_ -= units;
+                internalSrcAddr_ += srcAddrDelta * units;
+                internalDestAddr_ += destAddrDelta * units;
+                continue;
+            }
+        }
+
         auto [value, readCycles] = gba_.ReadMemory(internalSrcAddr_, alignment);
         int writeCycles = gba_.WriteMemory(internalDestAddr_, value, alignment);
         xferCycles += readCycles + writeCycles;
@@ -185,23 +244,15 @@ int DmaChannel::ExecuteEepromXfer(bool read, bool write)
             auto [doubleWord, readCycles] = gba_.gamePak_->ReadFromEeprom();
             xferCycles += readCycles;
 
-            for (int i = 0; i < 4; ++i)
-            {
-                xferCycles += gba_.WriteMemory(internalDestAddr_, 0, AccessSize::HALFWORD);
-                internalDestAddr_ += static_cast<uint32_t>(AccessSize::HALFWORD);
-                internalSrcAddr_ += static_cast<uint32_t>(AccessSize::HALFWORD);
-                --internalWordCount_;
-            }
+            // 4 ignored bits, followed by the double word starting from its most significant bit
+            std::array<uint16_t, 68> bitstream = {};
 
-            while (internalWordCount_ > 0)
+            for (int i = 0; i < 64; ++i)
             {
-                uint16_t value = (doubleWord & MSB_64) >> 63;
-                doubleWord <<= 1;
-                xferCycles += gba_.WriteMemory(internalDestAddr_, value, AccessSize::HALFWORD);
-                internalDestAddr_ += static_cast<uint32_t>(AccessSize::HALFWORD);
-                internalSrcAddr_ += static_cast<uint32_t>(AccessSize::HALFWORD);
-                --internalWordCount_;
+                bitstream[4 + i] = (doubleWord >> (63 - i)) & 0x01;
             }
+
+            xferCycles += WriteEepromBitstream(bitstream.data(), bitstream.size());
         }
     }
     else if (write)
@@ -211,71 +262,33 @@ int DmaChannel::ExecuteEepromXfer(bool read, bool write)
             (dmacnt_.xferType == 0) &&
             ((internalWordCount_ == 9) || (internalWordCount_ == 17) || (internalWordCount_ == 73) || (internalWordCount_ == 81)))
         {
-            if ((internalWordCount_ == 9) || (internalWordCount_ == 17))  // Writing to set up for a read
-            {
-                uint16_t index = 0;
-                int indexLength = internalWordCount_ - 3;
+            int const count = internalWordCount_;
+            std::array<uint16_t, 81> bitstream;
+            xferCycles += ReadEepromBitstream(bitstream.data(), count);
 
-                for (int i = 0; i < 2; ++i)
-                {
-                    // Read and throw away first 2 bits (should be 0b11).
-                    auto [value, readCycles] = ReadForEepromXfer();
-                    xferCycles += readCycles;
-                }
+            // Commands start with 2 request bits (0b11 for a read, 0b10 for a write) and end with a 0 bit, all of which are ignored.
+            // Each value in between is sent starting from its most significant bit.
+            auto getBits = [&](int first, int length)
+            {
+                uint64_t value = 0;
 
-                for (int i = 0; i < indexLength; ++i)
+                for (int i = first; i < (first + length); ++i)
                 {
-                    // Read index bitstream from memory.
-                    index <<= 1;
-                    auto [value, readCycles] = ReadForEepromXfer();
-                    index |= (value & 0x01);
-                    xferCycles += readCycles;
+                    value = (value << 1) | (bitstream[i] & 0x01);
                 }
 
-                // Read final bit (should be 0)
-                auto [value, readCycles] = ReadForEepromXfer();
-                xferCycles += readCycles;
+                return value;
+            };
 
-                // Send bitstream to EEPROM
-                xferCycles += gba_.gamePak_->SetEepromIndex(index, indexLength);
+            if ((count == 9) || (count == 17))  // Setting up for a read
+            {
+                int indexLength = count - 3;
+                xferCycles += gba_.gamePak_->SetEepromIndex(getBits(2, indexLength), indexLength);
             }
-            else  // Writing a double word to EEPROM
+            else  // Writing a double word
             {
-                uint16_t index = 0;
-                int indexLength = internalWordCount_ - 67;
-                uint64_t doubleWord = 0;
-
-                for (int i = 0; i < 2; ++i)
-                {
-                    // Read and throw away first 2 bits (should be 0b10).
-                    auto [value, readCycles] = ReadForEepromXfer();
-                    xferCycles += readCycles;
-                }
-
-                for (int i = 0; i < indexLength; ++i)
-                {
-                    // Read index bitstream from memory.
-                    index <<= 1;
-                    auto [value, readCycles] = ReadForEepromXfer();
-                    index |= (value & 0x01);
-                    xferCycles += readCycles;
-                }
-
-                for (int i = 0; i < 64; ++i)
-                {
-                    // Get double word from memory to write to EEPROM.
-                    doubleWord <<= 1;
-                    auto [value, readCycles] = ReadForEepromXfer();
-                    doubleWord |= (value & 0x01);
-                    xferCycles += readCycles;
-                }
-
-                // Read final bit (should be 0).
-                auto [value, readCycles] = ReadForEepromXfer();
-                xferCycles += readCycles;
-
-                // Send double word to EEPROM.
-                xferCycles += gba_.gamePak_->WriteToEeprom(index, indexLength, doubleWord);
+                int indexLength = count - 67;
+                xferCycles += gba_.gamePak_->WriteToEeprom(getBits(2, indexLength), indexLength, getBits(2 + indexLength, 64));
             }
         }
     }
@@ -301,9 +314,22 @@ int DmaChannel::ExecuteFifoXfer()
             break;
     }
 
+    // Samples streamed from ROM or work RAM go straight from memory into the FIFO
+    if (srcAddrDelta > 0)
+    {
+        auto [samples, readCycles] = gba_.ReadMemoryBlock(internalSrcAddr_, 4, AccessSize::WORD);
+
+        if (samples != nullptr)
+        {
+            gba_.apu_.RefillFifo(internalDestAddr_, samples, 16);
+            internalSrcAddr_ += 16;
+            return readCycles + 4;
+        }
+    }
+
     for (int i = 0; i < 4; ++i)
     {
-        auto [value, readCycles] = gba_.ReadMemory(internalSrcAddr_, AccessSize::WORD);
+        auto [value, readCycles] = gba_.ReadMemory<AccessSize::WORD>(internalSrcAddr_);
         gba_.apu_.WriteReg(internalDestAddr_, value, AccessSize::WORD);
         xferCycles += readCycles + 1;
         internalSrcAddr_ += srcAddrDelta;
@@ -369,11 +395,45 @@ void DmaChannel::SetInternalRegisters()
     }
 }
 
-std::pair<uint32_t, int> DmaChannel::ReadForEepromXfer()
+int DmaChannel::ReadEepromBitstream(uint16_t* bitstream, int count)
 {
-    auto [value, readCycles] = gba_.ReadMemory(internalSrcAddr_, AccessSize::HALFWORD);
-    internalDestAddr_ += static_cast<uint32_t>(AccessSize::HALFWORD);
-    internalSrcAddr_ += static_cast<uint32_t>(AccessSize::HALFWORD);
-    --internalWordCount_;
-    return {value, readCycles};
+    auto [memory, xferCycles] = gba_.ReadMemoryBlock(internalSrcAddr_, count, AccessSize::HALFWORD);
+
+    if (memory != nullptr)
+    {
+        std::memcpy(bitstream, memory, count * sizeof(uint16_t));
+    }
+    else
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            auto [value, readCycles] = gba_.ReadMemory<AccessSize::HALFWORD>(internalSrcAddr_ + (i * sizeof(uint16_t)));
+            bitstream[i] = value;
+            xferCycles += readCycles;
+        }
+    }
+
+    internalSrcAddr_ += count * sizeof(uint16_t);
+    internalDestAddr_ += count * sizeof(uint16_t);
+    internalWordCount_ -= count;
+    return xferCycles;
+}
+
+int DmaChannel::WriteEepromBitstream(uint16_t const* bitstream, int count)
+{
+    auto [written, xferCycles] =
+        gba_.WriteMemoryBlock(internalDestAddr_, reinterpret_cast<uint8_t const*>(bitstream), count, AccessSize::HALFWORD);
+
+    if (!written)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            xferCycles += gba_.WriteMemory<AccessSize::HALFWORD>(internalDestAddr_ + (i * sizeof(uint16_t)), bitstream[i]);
+        }
+    }
+
+    internalSrcAddr_ += count * sizeof(uint16_t);
+    internalDestAddr_ += count * sizeof(uint16_t);
+    internalWordCount_ -= count;
+    return xferCycles;
 }
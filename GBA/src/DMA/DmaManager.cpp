@@ -1,28 +1,33 @@
 #include <DMA/DmaManager.hpp>
+#include <algorithm>
 #include <array>
+#include <bit>
 #include <cstdint>
-#include <functional>
-#include <optional>
+#include <limits>
 #include <utility>
 #include <DMA/DmaChannel.hpp>
 #include <Logging/Logging.hpp>
+#include <System/EventScheduler.hpp>
 #include <System/GameBoyAdvance.hpp>
 #include <System/SystemControl.hpp>
 #include <Utilities/MemoryUtilities.hpp>
+#include <Utilities/StateSerializer.hpp>
 
-DmaManager::DmaManager(GameBoyAdvance& gba) :
+DmaManager::DmaManager(GameBoyAdvance& gba, EventScheduler& scheduler, SystemControl& systemControl, Logging::LogManager& log) :
     gba_(gba),
-    dmaChannels_({DmaChannel(0, InterruptType::DMA0, gba),
-                  DmaChannel(1, InterruptType::DMA1, gba),
-                  DmaChannel(2, InterruptType::DMA2, gba),
-                  DmaChannel(3, InterruptType::DMA3, gba)})
+    scheduler_(scheduler),
+    log_(log),
+    dmaChannels_({DmaChannel(0, InterruptType::DMA0, gba, systemControl),
+                  DmaChannel(1, InterruptType::DMA1, gba, systemControl),
+                  DmaChannel(2, InterruptType::DMA2, gba, systemControl),
+                  DmaChannel(3, InterruptType::DMA3, gba, systemControl)})
 {
-    Scheduler.RegisterEvent(EventType::DmaComplete, std::bind(&EndDma, this, std::placeholders::_1));
 }
 
 void DmaManager::Reset()
 {
-    dmaActive_ = false;
+    runningChannels_ = 0;
+    stallEndCycle_ = 0;
 
     for (auto& dmaChannel : dmaChannels_)
     {
@@ -36,6 +41,23 @@ void DmaManager::Reset()
     videoCapture_.fill(false);
 }
 
+void DmaManager::Serialize(StateSerializer& state)
+{
+    state.Value(runningChannels_);
+    state.Value(stallEndCycle_);
+
+    for (auto& dmaChannel : dmaChannels_)
+    {
+        dmaChannel.Serialize(state);
+    }
+
+    state.Value(vblank_);
+    state.Value(hblank_);
+    state.Value(fifoA_);
+    state.Value(fifoB_);
+    state.Value(videoCapture_);
+}
+
 std::pair<uint32_t, bool> DmaManager::ReadReg(uint32_t addr, AccessSize alignment)
 {
     if ((0x0400'00B0 <= addr) && (addr < 0x0400'00BC))
@@ -84,18 +106,16 @@ void DmaManager::WriteReg(uint32_t addr, uint32_t value, AccessSize alignment)
 
     if (xferType != DmaXfer::NO_CHANGE)
     {
-        vblank_[index] = false;
-        hblank_[index] = false;
-        fifoA_[index] = false;
-        fifoB_[index] = false;
-        videoCapture_[index] = false;
+        ClearStartTiming(index);
 
         switch (xferType)
         {
             case DmaXfer::NO_CHANGE:
-            case DmaXfer::DISABLE:
             case DmaXfer::IMMEDIATE:
                 break;
+            case DmaXfer::DISABLE:
+                runningChannels_ &= ~(1 << index);
+                break;
             case DmaXfer::VBLANK:
                 vblank_[index] = true;
                 break;
@@ -115,47 +135,101 @@ void DmaManager::WriteReg(uint32_t addr, uint32_t value, AccessSize alignment)
 
         if (xferType == DmaXfer::IMMEDIATE)
         {
-            int dmaCycles = dmaChannels_[index].Execute();
-            HandleDmaEvent(dmaCycles);
-            dmaActive_ = true;
+            StartXfer(index, xferType);
         }
     }
 }
 
-void DmaManager::CheckSpecialTiming(std::array<bool, 4>& enabledChannels, DmaXfer xferType)
+void DmaManager::RunUntilNextEvent()
 {
-    for (int i = 0; i < 4; ++i)
+    uint64_t currentCycle = scheduler_.TotalCycles();
+    uint64_t nextEventCycle = scheduler_.NextEventCycle();
+
+    if (currentCycle < stallEndCycle_)
     {
-        if (enabledChannels[i])
-        {
-            DmaChannel& channel = dmaChannels_[i];
+        scheduler_.AdvanceCycles(std::min(stallEndCycle_, nextEventCycle) - currentCycle);
+        return;
+    }
 
-            if (Logging::LogMgr.SystemLoggingEnabled())
-            {
-                Logging::LogMgr.LogDmaTransfer(i, xferType, channel.GetSrc(), channel.GetDest(), channel.GetCnt());
-            }
+    // Lower numbered channels have priority. Anything that can start a higher priority transfer is an event, so the highest
+    // priority running channel keeps the bus until the next event.
+    int index = std::countr_zero(runningChannels_);
+    int maxCycles = static_cast<int>(std::clamp<uint64_t>(nextEventCycle - currentCycle, 1, std::numeric_limits<int>::max()));
+    auto [cycles, finished] = dmaChannels_[index].ExecuteChunk(maxCycles);
+    scheduler_.AdvanceCycles(cycles);
 
-            int dmaCycles = channel.Execute();
-            enabledChannels[i] = channel.Enabled();
+    if (finished)
+    {
+        runningChannels_ &= ~(1 << index);
+        Stall(0);
 
-            if (dmaCycles > 0)
-            {
-                HandleDmaEvent(dmaCycles);
-                dmaActive_ = true;
-            }
+        if (!dmaChannels_[index].Enabled())
+        {
+            ClearStartTiming(index);
         }
     }
 }
 
-void DmaManager::HandleDmaEvent(int cycles)
+void DmaManager::StartXfer(int index, DmaXfer xferType)
 {
-    auto currentDmaRemainingCycles = Scheduler.CyclesRemaining(EventType::DmaComplete);
+    DmaChannel& channel = dmaChannels_[index];
+
+    if (runningChannels_ & (1 << index))
+    {
+        return;
+    }
+
+    if (log_.SystemLoggingEnabled())
+    {
+        log_.LogDmaTransfer(index, xferType, channel.GetSrc(), channel.GetDest(), channel.GetCnt());
+    }
 
-    if (currentDmaRemainingCycles.has_value())
+    if (channel.Interruptible())
     {
-        Scheduler.UnscheduleEvent(EventType::DmaComplete);
-        cycles += currentDmaRemainingCycles.value();
+        runningChannels_ |= (1 << index);
+        return;
     }
 
-    Scheduler.ScheduleEvent(EventType::DmaComplete, cycles + 2);
+    int dmaCycles = channel.Execute();
+
+    if (!channel.Enabled())
+    {
+        ClearStartTiming(index);
+    }
+
+    if (dmaCycles > 0)
+    {
+        Stall(dmaCycles);
+    }
+}
+
+void DmaManager::Stall(int cycles)
+{
+    stallEndCycle_ = std::max(stallEndCycle_, scheduler_.TotalCycles()) + cycles + 2;
+}
+
+void DmaManager::ClearStartTiming(int index)
+{
+    vblank_[index] = false;
+    hblank_[index] = false;
+    fifoA_[index] = false;
+    fifoB_[index] = false;
+    videoCapture_[index] = false;
+}
+
+bool DmaManager::FifoChannelsEnabled(DmaXfer xferType) const
+{
+    auto const& enabledChannels = (xferType == DmaXfer::FIFO_A) ? fifoA_ : fifoB_;
+    return std::find(enabledChannels.begin(), enabledChannels.end(), true) != enabledChannels.end();
+}
+
+void DmaManager::CheckSpecialTiming(std::array<bool, 4>& enabledChannels, DmaXfer xferType)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        if (enabledChannels[i])
+        {
+            StartXfer(i, xferType);
+        }
+    }
 }
@@ -5,11 +5,14 @@
 #include <System/MemoryMap.hpp>
 #include <System/SystemControl.hpp>
 #include <Utilities/MemoryUtilities.hpp>
+#include <Utilities/StateSerializer.hpp>
 
-GamepadManager::GamepadManager() :
+GamepadManager::GamepadManager(SystemControl& systemControl) :
     gamepadRegisters_(),
     KEYINPUT_(*reinterpret_cast<Gamepad*>(&gamepadRegisters_.at(0))),
-    KEYCNT_(*reinterpret_cast<Gamepad*>(&gamepadRegisters_.at(2)))
+    KEYCNT_(*reinterpret_cast<Gamepad*>(&gamepadRegisters_.at(2))),
+    mailbox_(Gamepad().halfword_),
+    systemControl_(systemControl)
 {
 }
 
@@ -19,6 +22,11 @@ void GamepadManager::Reset()
     KEYCNT_.halfword_ = 0;
 }
 
+void GamepadManager::Serialize(StateSerializer& state)
+{
+    state.Value(gamepadRegisters_);
+}
+
 void GamepadManager::UpdateGamepad(Gamepad gamepad)
 {
     KEYINPUT_ = gamepad;
@@ -81,6 +89,6 @@ void GamepadManager::CheckForGamepadIRQ()
 
     if (gamepadIRQ)
     {
-        SystemController.RequestInterrupt(InterruptType::KEYPAD);
+        systemControl_.RequestInterrupt(InterruptType::KEYPAD);
     }
 }
@@ -0,0 +1,283 @@
+#include <Graphics/BlendKernels.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+/// @brief Blend the top two layers together.
+/// @param eva First target coefficient.
+/// @param evb Second target coefficient.
+/// @param targetA bgr555 value of first target.
+/// @param targetB bgr555 value of second target.
+/// @return Blended bgr555 value of the two pixels.
+inline uint16_t AlphaBlend(uint16_t eva, uint16_t evb, uint16_t targetA, uint16_t targetB)
+{
+    // Isolate individual r, g, and b intensities as 1.4 fixed point values
+    uint16_t redA = (targetA & 0x001F) << 4;
+    uint16_t redB = (targetB & 0x001F) << 4;
+    uint16_t greenA = (targetA & 0x03E0) >> 1;
+    uint16_t greenB = (targetB & 0x03E0) >> 1;
+    uint16_t blueA = (targetA & 0x7C00) >> 6;
+    uint16_t blueB = (targetB & 0x7C00) >> 6;
+
+    uint16_t red = ((eva * redA) + (evb * redB)) >> 8;
+    uint16_t green = ((eva * greenA) + (evb * greenB)) >> 8;
+    uint16_t blue = ((eva * blueA) + (evb * blueB)) >> 8;
+
+    red = std::min(static_cast<uint16_t>(31), red);
+    green = std::min(static_cast<uint16_t>(31), green);
+    blue = std::min(static_cast<uint16_t>(31), blue);
+
+    return (blue << 10) | (green << 5) | red;
+}
+
+/// @brief Increase the brightness of the top layer.
+/// @param evy Brightness coefficient.
+/// @param target bgr555 value to increase brightness of.
+/// @return Increased brightness bgr555 value.
+inline uint16_t IncreaseBrightness(uint16_t evy, uint16_t target)
+{
+    // Isolate individual r, g, and b intensities as 1.4 fixed point values
+    uint16_t red = (target & 0x001F) << 4;
+    uint16_t green = (target & 0x03E0) >> 1;
+    uint16_t blue = (target & 0x7C00) >> 6;
+
+    red = (red + (((0x01F0 - red) * evy) >> 4)) >> 4;
+    green = (green + (((0x01F0 - green) * evy) >> 4)) >> 4;
+    blue = (blue + (((0x01F0 - blue) * evy) >> 4)) >> 4;
+
+    return (blue << 10) | (green << 5) | red;
+}
+
+/// @brief Decrease the brightness of the top layer.
+/// @param evy Brightness coefficient.
+/// @param target bgr555 value to decrease brightness of.
+/// @return Decreased brightness bgr555 value.
+inline uint16_t DecreaseBrightness(uint16_t evy, uint16_t target)
+{
+    // Isolate individual r, g, and b intensities as 1.4 fixed point values
+    uint16_t red = (target & 0x001F) << 4;
+    uint16_t green = (target & 0x03E0) >> 1;
+    uint16_t blue = (target & 0x7C00) >> 6;
+
+    red = (red - ((red * evy) >> 4)) >> 4;
+    green = (green - ((green * evy) >> 4)) >> 4;
+    blue = (blue - ((blue * evy) >> 4)) >> 4;
+
+    return (blue << 10) | (green << 5) | red;
+}
+
+void AlphaBlendScalar(uint16_t const* targetA,
+                      uint16_t const* targetB,
+                      uint16_t* output,
+                      size_t count,
+                      uint16_t eva,
+                      uint16_t evb)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        output[i] = AlphaBlend(eva, evb, targetA[i], targetB[i]);
+    }
+}
+
+void IncreaseBrightnessScalar(uint16_t const* target, uint16_t* output, size_t count, uint16_t evy)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        output[i] = IncreaseBrightness(evy, target[i]);
+    }
+}
+
+void DecreaseBrightnessScalar(uint16_t const* target, uint16_t* output, size_t count, uint16_t evy)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        output[i] = DecreaseBrightness(evy, target[i]);
+    }
+}
+
+// Vector kernels are written with GCC/Clang vector extensions, which lower to SSE2 on x86-64, NEON on AArch64, and AVX2 when
+// compiled into a function targeting it. Every intermediate value fits in 16 bits, so each lane matches the scalar version
+// exactly. Kernels are force inlined so that they pick up the instruction set of the function they're expanded into.
+typedef uint16_t Vec8 __attribute__((vector_size(16)));
+typedef uint16_t Vec16 __attribute__((vector_size(32)));
+
+template <typename Vec>
+[[gnu::always_inline]] inline void AlphaBlendVector(uint16_t const* targetA,
+                                                    uint16_t const* targetB,
+                                                    uint16_t* output,
+                                                    size_t count,
+                                                    uint16_t eva,
+                                                    uint16_t evb)
+{
+    constexpr size_t lanes = sizeof(Vec) / sizeof(uint16_t);
+    size_t i = 0;
+
+    for (; (i + lanes) <= count; i += lanes)
+    {
+        Vec a;
+        Vec b;
+        std::memcpy(&a, &targetA[i], sizeof(Vec));
+        std::memcpy(&b, &targetB[i], sizeof(Vec));
+
+        Vec red = ((eva * ((a & 0x001F) << 4)) + (evb * ((b & 0x001F) << 4))) >> 8;
+        Vec green = ((eva * ((a & 0x03E0) >> 1)) + (evb * ((b & 0x03E0) >> 1))) >> 8;
+        Vec blue = ((eva * ((a & 0x7C00) >> 6)) + (evb * ((b & 0x7C00) >> 6))) >> 8;
+
+        Vec redSaturated = reinterpret_cast<Vec>(red > 31);
+        Vec greenSaturated = reinterpret_cast<Vec>(green > 31);
+        Vec blueSaturated = reinterpret_cast<Vec>(blue > 31);
+        red = (red & ~redSaturated) | (redSaturated & 31);
+        green = (green & ~greenSaturated) | (greenSaturated & 31);
+        blue = (blue & ~blueSaturated) | (blueSaturated & 31);
+
+        Vec result = (blue << 10) | (green << 5) | red;
+        std::memcpy(&output[i], &result, sizeof(Vec));
+    }
+
+    for (; i < count; ++i)
+    {
+        output[i] = AlphaBlend(eva, evb, targetA[i], targetB[i]);
+    }
+}
+
+template <typename Vec>
+[[gnu::always_inline]] inline void IncreaseBrightnessVector(uint16_t const* target, uint16_t* output, size_t count, uint16_t evy)
+{
+    constexpr size_t lanes = sizeof(Vec) / sizeof(uint16_t);
+    size_t i = 0;
+
+    for (; (i + lanes) <= count; i += lanes)
+    {
+        Vec pixels;
+        std::memcpy(&pixels, &target[i], sizeof(Vec));
+
+        Vec red = (pixels & 0x001F) << 4;
+        Vec green = (pixels & 0x03E0) >> 1;
+        Vec blue = (pixels & 0x7C00) >> 6;
+
+        red = (red + (((0x01F0 - red) * evy) >> 4)) >> 4;
+        green = (green + (((0x01F0 - green) * evy) >> 4)) >> 4;
+        blue = (blue + (((0x01F0 - blue) * evy) >> 4)) >> 4;
+
+        Vec result = (blue << 10) | (green << 5) | red;
+        std::memcpy(&output[i], &result, sizeof(Vec));
+    }
+
+    for (; i < count; ++i)
+    {
+        output[i] = IncreaseBrightness(evy, target[i]);
+    }
+}
+
+template <typename Vec>
+[[gnu::always_inline]] inline void DecreaseBrightnessVector(uint16_t const* target, uint16_t* output, size_t count, uint16_t evy)
+{
+    constexpr size_t lanes = sizeof(Vec) / sizeof(uint16_t);
+    size_t i = 0;
+
+    for (; (i + lanes) <= count; i += lanes)
+    {
+        Vec pixels;
+        std::memcpy(&pixels, &target[i], sizeof(Vec));
+
+        Vec red = (pixels & 0x001F) << 4;
+        Vec green = (pixels & 0x03E0) >> 1;
+        Vec blue = (pixels & 0x7C00) >> 6;
+
+        red = (red - ((red * evy) >> 4)) >> 4;
+        green = (green - ((green * evy) >> 4)) >> 4;
+        blue = (blue - ((blue * evy) >> 4)) >> 4;
+
+        Vec result = (blue << 10) | (green << 5) | red;
+        std::memcpy(&output[i], &result, sizeof(Vec));
+    }
+
+    for (; i < count; ++i)
+    {
+        output[i] = DecreaseBrightness(evy, target[i]);
+    }
+}
+
+void AlphaBlend8(uint16_t const* targetA, uint16_t const* targetB, uint16_t* output, size_t count, uint16_t eva, uint16_t evb)
+{
+    AlphaBlendVector<Vec8>(targetA, targetB, output, count, eva, evb);
+}
+
+void IncreaseBrightness8(uint16_t const* target, uint16_t* output, size_t count, uint16_t evy)
+{
+    IncreaseBrightnessVector<Vec8>(target, output, count, evy);
+}
+
+void DecreaseBrightness8(uint16_t const* target, uint16_t* output, size_t count, uint16_t evy)
+{
+    DecreaseBrightnessVector<Vec8>(target, output, count, evy);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+void AlphaBlend16(uint16_t const* targetA, uint16_t const* targetB, uint16_t* output, size_t count, uint16_t eva, uint16_t evb)
+{
+    AlphaBlendVector<Vec16>(targetA, targetB, output, count, eva, evb);
+}
+
+__attribute__((target("avx2")))
+void IncreaseBrightness16(uint16_t const* target, uint16_t* output, size_t count, uint16_t evy)
+{
+    IncreaseBrightnessVector<Vec16>(target, output, count, evy);
+}
+
+__attribute__((target("avx2")))
+void DecreaseBrightness16(uint16_t const* target, uint16_t* output, size_t count, uint16_t evy)
+{
+    DecreaseBrightnessVector<Vec16>(target, output, count, evy);
+}
+#endif
+
+/// @brief Pick the widest kernels supported by the host CPU.
+/// @return Kernels to use for blending.
+Graphics::BlendKernelSet SelectKernels()
+{
+    return Graphics::SupportedBlendKernels().back();
+}
+
+Graphics::BlendKernelSet const Kernels = SelectKernels();
+}
+
+namespace Graphics
+{
+void AlphaBlendSpan(uint16_t const* targetA, uint16_t const* targetB, uint16_t* output, size_t count, uint16_t eva, uint16_t evb)
+{
+    Kernels.alphaBlend_(targetA, targetB, output, count, eva, evb);
+}
+
+void IncreaseBrightnessSpan(uint16_t const* target, uint16_t* output, size_t count, uint16_t evy)
+{
+    Kernels.increaseBrightness_(target, output, count, evy);
+}
+
+void DecreaseBrightnessSpan(uint16_t const* target, uint16_t* output, size_t count, uint16_t evy)
+{
+    Kernels.decreaseBrightness_(target, output, count, evy);
+}
+
+std::vector<BlendKernelSet> SupportedBlendKernels()
+{
+    std::vector<BlendKernelSet> kernels = {
+        {"Scalar", AlphaBlendScalar, IncreaseBrightnessScalar, DecreaseBrightnessScalar},
+        {"128-bit", AlphaBlend8, IncreaseBrightness8, DecreaseBrightness8}
+    };
+
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2"))
+    {
+        kernels.push_back({"AVX2", AlphaBlend16, IncreaseBrightness16, DecreaseBrightness16});
+    }
+#endif
+
+    return kernels;
+}
+}
@@ -1,133 +1,169 @@
 #include <Graphics/FrameBuffer.hpp>
 #include <algorithm>
 #include <array>
+#include <cmath>
 #include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <utility>
+#include <vector>
+#include <Graphics/BlendKernels.hpp>
 #include <Graphics/Registers.hpp>
+#include <PixelFormat.hpp>
+#include <System/AvCapture.hpp>
+#include <Utilities/StateSerializer.hpp>
 
 namespace
 {
-/// @brief Blend the top two layers together.
-/// @param eva First target coefficient.
-/// @param evb Second target coefficient.
-/// @param targetA bgr555 value of first target.
-/// @param targetB bgr555 value of second target.
-/// @return Blended bgr555 value of the two pixels.
-inline uint16_t AlphaBlend(uint16_t eva, uint16_t evb, uint16_t targetA, uint16_t targetB)
+/// @brief Convert a BGR555 color to another pixel format.
+/// @param bgr555 Color to convert. Bit 15 is ignored.
+/// @param format Pixel format to convert to.
+/// @param colorCorrection Whether to approximate the colors of the GBA's LCD, which is darker and less saturated than a modern
+///                        display.
+/// @return Converted color. 16 bit formats are stored in the lower halfword.
+uint32_t ConvertColor(uint16_t bgr555, PixelFormat format, bool colorCorrection)
 {
-    // Isolate individual r, g, and b intensities as 1.4 fixed point values
-    uint16_t redA = (targetA & 0x001F) << 4;
-    uint16_t redB = (targetB & 0x001F) << 4;
-    uint16_t greenA = (targetA & 0x03E0) >> 1;
-    uint16_t greenB = (targetB & 0x03E0) >> 1;
-    uint16_t blueA = (targetA & 0x7C00) >> 6;
-    uint16_t blueB = (targetB & 0x7C00) >> 6;
-
-    uint16_t red = ((eva * redA) + (evb * redB)) >> 8;
-    uint16_t green = ((eva * greenA) + (evb * greenB)) >> 8;
-    uint16_t blue = ((eva * blueA) + (evb * blueB)) >> 8;
-
-    red = std::min(static_cast<uint16_t>(31), red);
-    green = std::min(static_cast<uint16_t>(31), green);
-    blue = std::min(static_cast<uint16_t>(31), blue);
-
-    return (blue << 10) | (green << 5) | red;
-}
+    double red = (bgr555 & 0x1F) / 31.0;
+    double green = ((bgr555 >> 5) & 0x1F) / 31.0;
+    double blue = ((bgr555 >> 10) & 0x1F) / 31.0;
 
-/// @brief Increase the brightness of the top layer.
-/// @param evy Brightness coefficient.
-/// @param target bgr555 value to increase brightness of.
-/// @return Increased brightness bgr555 value.
-inline uint16_t IncreaseBrightness(uint16_t evy, uint16_t target)
-{
-    // Isolate individual r, g, and b intensities as 1.4 fixed point values
-    uint16_t red = (target & 0x001F) << 4;
-    uint16_t green = (target & 0x03E0) >> 1;
-    uint16_t blue = (target & 0x7C00) >> 6;
+    if (colorCorrection)
+    {
+        // Linearize with the LCD's gamma, mix channels to account for its color bleed, then re-encode for an sRGB display.
+        constexpr double LCD_GAMMA = 4.0;
+        constexpr double OUT_GAMMA = 2.2;
+        double const lr = std::pow(red, LCD_GAMMA);
+        double const lg = std::pow(green, LCD_GAMMA);
+        double const lb = std::pow(blue, LCD_GAMMA);
+        red = std::pow(((255 * lr) + (50 * lg) + (0 * lb)) / 255.0, 1.0 / OUT_GAMMA) * (255.0 / 280.0);
+        green = std::pow(((10 * lr) + (230 * lg) + (30 * lb)) / 255.0, 1.0 / OUT_GAMMA) * (255.0 / 280.0);
+        blue = std::pow(((50 * lr) + (10 * lg) + (220 * lb)) / 255.0, 1.0 / OUT_GAMMA) * (255.0 / 280.0);
+    }
 
-    red = (red + (((0x01F0 - red) * evy) >> 4)) >> 4;
-    green = (green + (((0x01F0 - green) * evy) >> 4)) >> 4;
-    blue = (blue + (((0x01F0 - blue) * evy) >> 4)) >> 4;
+    auto quantize = [](double channel, int maxValue) { return static_cast<uint32_t>(std::lround(std::clamp(channel, 0.0, 1.0) * maxValue)); };
+
+    switch (format)
+    {
+        case PixelFormat::BGR555:
+            return (quantize(blue, 31) << 10) | (quantize(green, 31) << 5) | quantize(red, 31);
+        case PixelFormat::RGB565:
+            return (quantize(red, 31) << 11) | (quantize(green, 63) << 5) | quantize(blue, 31);
+        case PixelFormat::XRGB8888:
+            return 0xFF00'0000 | (quantize(red, 255) << 16) | (quantize(green, 255) << 8) | quantize(blue, 255);
+        case PixelFormat::RGBA8888:
+        {
+            uint8_t const bytes[4] = {static_cast<uint8_t>(quantize(red, 255)),
+                                      static_cast<uint8_t>(quantize(green, 255)),
+                                      static_cast<uint8_t>(quantize(blue, 255)),
+                                      0xFF};
+            uint32_t color;
+            std::memcpy(&color, bytes, sizeof(color));
+            return color;
+        }
+    }
 
-    return (blue << 10) | (green << 5) | red;
+    return 0;
 }
 
-/// @brief Decrease the brightness of the top layer.
-/// @param evy Brightness coefficient.
-/// @param target bgr555 value to decrease brightness of.
-/// @return Decreased brightness bgr555 value.
-inline uint16_t DecreaseBrightness(uint16_t evy, uint16_t target)
+/// @brief Get the table that converts every BGR555 color to a pixel format. Tables never change once built and are shared by
+///        every GBA in the process, so only the first one to use a format pays to build its table.
+/// @param format Pixel format to convert to.
+/// @param colorCorrection Whether to approximate the colors of the GBA's LCD.
+/// @return Table of 0x8000 converted colors, indexed by BGR555 color.
+std::shared_ptr<std::vector<uint32_t> const> SharedColorLut(PixelFormat format, bool colorCorrection)
 {
-    // Isolate individual r, g, and b intensities as 1.4 fixed point values
-    uint16_t red = (target & 0x001F) << 4;
-    uint16_t green = (target & 0x03E0) >> 1;
-    uint16_t blue = (target & 0x7C00) >> 6;
-
-    red = (red - ((red * evy) >> 4)) >> 4;
-    green = (green - ((green * evy) >> 4)) >> 4;
-    blue = (blue - ((blue * evy) >> 4)) >> 4;
+    static std::mutex cacheMutex;
+    static std::map<std::pair<PixelFormat, bool>, std::shared_ptr<std::vector<uint32_t> const>> cache;
 
-    return (blue << 10) | (green << 5) | red;
-}
-}
+    std::lock_guard lock(cacheMutex);
+    auto& colorLut = cache[{format, colorCorrection}];
 
-namespace Graphics
-{
-bool Pixel::operator<(Pixel const& rhs) const
-{
-    if (transparent_ && !rhs.transparent_)
+    if (!colorLut)
     {
-        return false;
-    }
-    else if (!transparent_ && rhs.transparent_)
-    {
-        return true;
-    }
+        auto newLut = std::make_shared<std::vector<uint32_t>>(0x8000);
 
-    if (priority_ == rhs.priority_)
-    {
-        return src_ < rhs.src_;
+        for (uint32_t bgr555 = 0; bgr555 < 0x8000; ++bgr555)
+        {
+            (*newLut)[bgr555] = ConvertColor(bgr555, format, colorCorrection);
+        }
+
+        colorLut = std::move(newLut);
     }
 
-    return priority_ < rhs.priority_;
+    return colorLut;
+}
 }
 
+namespace Graphics
+{
 FrameBuffer::FrameBuffer()
 {
-    for (auto& pixels : scanline_)
+    for (auto& layer : layers_)
     {
-        pixels.reserve(5);
+        layer.fill(Pixel());
     }
+
+    activeLayers_ = 0;
+
+    // Sequence numbers keep counting across resets, so the triple buffer is only set up once
+    frameSequences_.fill(0);
+    contentSequences_.fill(0);
+    writeIndex_ = 0;
+    handoff_.store(1, std::memory_order_release);
+    previousIndex_ = 1;
+    readIndex_ = 2;
+    completedFrames_ = 0;
+    lastModifiedFrame_ = 0;
+    frameTarget_ = nullptr;
+    publishedTarget_ = nullptr;
+    capture_ = nullptr;
+
+    SetOutputFormat(PixelFormat::BGR555, false);
+    Reset();
 }
 
 void FrameBuffer::Reset()
 {
-    frameBuffers_[0].fill(0xFFFF);
-    frameBuffers_[1].fill(0xFFFF);
-    activeFrameBufferIndex_ = 0;
+    ClearFrames();
     pixelIndex_ = 0;
+    ClearLayers();
 }
 
-uint8_t* FrameBuffer::GetRawFrameBuffer()
+void FrameBuffer::Serialize(StateSerializer& state)
 {
-    return reinterpret_cast<uint8_t*>(frameBuffers_[activeFrameBufferIndex_ ^ 1].data());
+    state.Value(pixelIndex_);
 }
 
-void FrameBuffer::PushPixel(Pixel pixel, int dot)
+CompletedFrame FrameBuffer::AcquireFrame()
 {
-    scanline_[dot].push_back(pixel);
+    if (handoff_.load(std::memory_order_relaxed) & FRESH_FRAME_FLAG)
+    {
+        readIndex_ = handoff_.exchange(readIndex_, std::memory_order_acq_rel) & FRAME_INDEX_MASK;
+    }
+
+    return {reinterpret_cast<uint8_t const*>(frameBuffers_[readIndex_].data()), frameSequences_[readIndex_], contentSequences_[readIndex_]};
+}
+
+void FrameBuffer::SetOutputFormat(PixelFormat format, bool colorCorrection)
+{
+    outputFormat_ = format;
+    nativeOutput_ = (format == PixelFormat::BGR555) && !colorCorrection;
+
+    colorLut_ = nativeOutput_ ? nullptr : SharedColorLut(format, colorCorrection);
+
+    ClearFrames();
 }
 
 void FrameBuffer::RenderScanline(uint16_t backdropColor, bool forceBlank, BLDCNT const& bldcnt, BLDALPHA const& bldalpha, BLDY const& bldy)
 {
     if (forceBlank)
     {
-        for (int dot = 0; dot < LCD_WIDTH; ++dot)
-        {
-            frameBuffers_[activeFrameBufferIndex_].at(pixelIndex_++) = 0x7FFF;
-            scanline_[dot].clear();
-        }
-
+        std::fill_n(CurrentScanlineBuffer(), LCD_WIDTH, 0x7FFF);
+        EmitScanline();
+        ClearLayers();
         return;
     }
 
@@ -137,10 +173,19 @@ void FrameBuffer::RenderScanline(uint16_t backdropColor, bool forceBlank, BLDCNT
     std::array<bool, 6> secondTargetLayer = {bldcnt.objB, bldcnt.bg0B, bldcnt.bg1B, bldcnt.bg2B, bldcnt.bg3B, bldcnt.bdB};
     #pragma GCC diagnostic pop
 
-    Pixel bdPixel = Pixel(PixelSrc::BD, backdropColor, 4, false);
-    Pixel* pixelA = nullptr;
-    Pixel* pixelB = nullptr;
+    // Only layers that were drawn this scanline need to be considered at each dot
+    std::array<Pixel const*, LAYER_COUNT> layers;
+    size_t layerCount = 0;
 
+    for (size_t layer = 0; layer < LAYER_COUNT; ++layer)
+    {
+        if (activeLayers_ & (0x01 << layer))
+        {
+            layers[layerCount++] = layers_[layer].data();
+        }
+    }
+
+    Pixel const bdPixel = Pixel(PixelSrc::BD, backdropColor, 0, false);
     SpecialEffect const bldcntEffect = static_cast<SpecialEffect>(bldcnt.specialEffect);
 
     // Coefficients are 1.4 fixed point values
@@ -148,45 +193,42 @@ void FrameBuffer::RenderScanline(uint16_t backdropColor, bool forceBlank, BLDCNT
     uint16_t const evb = std::min(bldalpha.evbCoefficient, static_cast<uint16_t>(0x10));
     uint16_t const evy = std::min(bldy.evyCoefficient, static_cast<uint16_t>(0x10));
 
+    // Resolve the top two layers and which effect applies at each dot. Effects are then applied to the whole scanline at once.
+    uint16_t* outputLine = CurrentScanlineBuffer();
+    std::array<uint16_t, LCD_WIDTH> targetB;
+    std::array<SpecialEffect, LCD_WIDTH> effects;
+    bool alphaBlendUsed = false;
+    bool brightnessUsed = false;
+    WindowMask const& effectsWindow = windowMasks_[EFFECTS_WINDOW];
+
     for (int dot = 0; dot < LCD_WIDTH; ++dot)
     {
-        auto& pixels = scanline_[dot];
+        // Find the two highest priority pixels. Since packed pixels order by priority, this is just a min search.
+        Pixel pixelA;
+        Pixel pixelB;
 
-        switch (pixels.size())
+        for (size_t i = 0; i < layerCount; ++i)
         {
-            case 0:
-                pixelA = nullptr;
-                pixelB = nullptr;
-                break;
-            case 1:
-                pixelA = &pixels[0];
-                pixelB = nullptr;
-                break;
-            default:
-                std::nth_element(pixels.begin(), pixels.begin() + 1, pixels.end());
-                pixelA = &pixels[0];
-                pixelB = &pixels[1];
-                break;
+            uint32_t value = layers[i][dot].value_;
+            pixelB.value_ = std::min(pixelB.value_, std::max(pixelA.value_, value));
+            pixelA.value_ = std::min(pixelA.value_, value);
         }
 
-        if (!pixelA || pixelA->transparent_)
-        {
-            pixelA = &bdPixel;
-            pixelB = nullptr;
-        }
-        else if (pixelB && pixelB->transparent_)
+        bool const hasPixelB = !pixelA.Transparent() && !pixelB.Transparent();
+
+        if (pixelA.Transparent())
         {
-            pixelB = nullptr;
+            pixelA = bdPixel;
         }
 
-        uint16_t bgr555 = pixelA->bgr555_;
         SpecialEffect actualEffect = bldcntEffect;
+        bool const firstTarget = firstTargetLayer[static_cast<uint8_t>(pixelA.Src())];
 
-        if ((pixelA->semiTransparent_) && pixelB && !pixelB->transparent_)
+        if (pixelA.SemiTransparent() && hasPixelB)
         {
             actualEffect = SpecialEffect::AlphaBlending;
         }
-        else if (!windowScanline_[dot].effectsEnabled_)
+        else if (!effectsWindow.Test(dot))
         {
             actualEffect = SpecialEffect::None;
         }
@@ -197,59 +239,176 @@ void FrameBuffer::RenderScanline(uint16_t backdropColor, bool forceBlank, BLDCNT
                 break;
             case SpecialEffect::AlphaBlending:
             {
-                if (pixelB && (firstTargetLayer[static_cast<uint8_t>(pixelA->src_)] || pixelA->semiTransparent_) && secondTargetLayer[static_cast<uint8_t>(pixelB->src_)])
+                if (!hasPixelB || !(firstTarget || pixelA.SemiTransparent()) || !secondTargetLayer[static_cast<uint8_t>(pixelB.Src())])
                 {
-                    bgr555 = AlphaBlend(eva, evb, pixelA->bgr555_, pixelB->bgr555_);
+                    actualEffect = SpecialEffect::None;
                 }
 
                 break;
             }
             case SpecialEffect::BrightnessIncrease:
+            case SpecialEffect::BrightnessDecrease:
             {
-                if (firstTargetLayer[static_cast<uint8_t>(pixelA->src_)])
+                if (!firstTarget)
                 {
-                    bgr555 = IncreaseBrightness(evy, pixelA->bgr555_);
+                    actualEffect = SpecialEffect::None;
                 }
 
                 break;
             }
-            case SpecialEffect::BrightnessDecrease:
+        }
+
+        outputLine[dot] = pixelA.Bgr555();
+        targetB[dot] = pixelB.Bgr555();
+        effects[dot] = actualEffect;
+        alphaBlendUsed |= (actualEffect == SpecialEffect::AlphaBlending);
+        brightnessUsed |= (actualEffect == SpecialEffect::BrightnessIncrease) || (actualEffect == SpecialEffect::BrightnessDecrease);
+    }
+
+    if (alphaBlendUsed || brightnessUsed)
+    {
+        std::array<uint16_t, LCD_WIDTH> blended;
+        std::array<uint16_t, LCD_WIDTH> brightened;
+
+        if (alphaBlendUsed)
+        {
+            AlphaBlendSpan(outputLine, targetB.data(), blended.data(), LCD_WIDTH, eva, evb);
+        }
+
+        if (brightnessUsed)
+        {
+            if (bldcntEffect == SpecialEffect::BrightnessIncrease)
             {
-                if (firstTargetLayer[static_cast<uint8_t>(pixelA->src_)])
-                {
-                    bgr555 = DecreaseBrightness(evy, pixelA->bgr555_);
-                }
+                IncreaseBrightnessSpan(outputLine, brightened.data(), LCD_WIDTH, evy);
+            }
+            else
+            {
+                DecreaseBrightnessSpan(outputLine, brightened.data(), LCD_WIDTH, evy);
+            }
+        }
 
-                break;
+        for (int dot = 0; dot < LCD_WIDTH; ++dot)
+        {
+            if (effects[dot] == SpecialEffect::AlphaBlending)
+            {
+                outputLine[dot] = blended[dot];
+            }
+            else if (effects[dot] != SpecialEffect::None)
+            {
+                outputLine[dot] = brightened[dot];
             }
         }
+    }
+
+    EmitScanline();
+    ClearLayers();
+}
 
-        frameBuffers_[activeFrameBufferIndex_].at(pixelIndex_++) = bgr555;
-        pixels.clear();
+void FrameBuffer::RepeatPreviousScanline()
+{
+    if (frameTarget_ == nullptr)
+    {
+        // The last published frame is only ever read until the writer gets it back from a later handoff
+        std::memcpy(OutputLine(writeIndex_), OutputLine(previousIndex_), LCD_WIDTH * BytesPerPixel(outputFormat_));
     }
+
+    pixelIndex_ += LCD_WIDTH;
 }
 
-void FrameBuffer::ResetFrameIndex()
+void FrameBuffer::PublishFrame(bool modified)
 {
-    activeFrameBufferIndex_ ^= 1;
+    ++completedFrames_;
+
+    if (modified)
+    {
+        lastModifiedFrame_ = completedFrames_;
+    }
+
+    if (frameTarget_ == nullptr)
+    {
+        frameSequences_[writeIndex_] = completedFrames_;
+        contentSequences_[writeIndex_] = lastModifiedFrame_;
+        previousIndex_ = writeIndex_;
+        writeIndex_ = handoff_.exchange(writeIndex_ | FRESH_FRAME_FLAG, std::memory_order_acq_rel) & FRAME_INDEX_MASK;
+    }
+
+    publishedTarget_ = frameTarget_;
     pixelIndex_ = 0;
+
+    if (capture_ != nullptr)
+    {
+        uint8_t const* internalFrame = reinterpret_cast<uint8_t const*>(frameBuffers_[previousIndex_].data());
+        capture_->PushFrame((frameTarget_ != nullptr) ? frameTarget_ : internalFrame, completedFrames_);
+    }
+
+    if (frameCallback_)
+    {
+        frameCallback_(completedFrames_);
+    }
+}
+
+void FrameBuffer::ClearLayers()
+{
+    for (size_t layer = 0; layer < LAYER_COUNT; ++layer)
+    {
+        if (activeLayers_ & (0x01 << layer))
+        {
+            layers_[layer].fill(Pixel());
+        }
+    }
+
+    activeLayers_ = 0;
+}
+
+void FrameBuffer::ClearFrames()
+{
+    scanlineBuffer_.fill(0xFFFF);
+
+    for (auto& frame : frameBuffers_)
+    {
+        uint8_t* framePtr = reinterpret_cast<uint8_t*>(frame.data());
+
+        for (int line = 0; line < LCD_HEIGHT; ++line)
+        {
+            ConvertScanline(scanlineBuffer_.data(), framePtr + (line * LCD_WIDTH * BytesPerPixel(outputFormat_)));
+        }
+    }
 }
 
-void FrameBuffer::ClearSpritePixels()
+void FrameBuffer::EmitScanline()
 {
-    for (Pixel& pixel : spriteScanline_)
+    if (!nativeOutput_)
     {
-        pixel.initialized_ = false;
+        ConvertScanline(scanlineBuffer_.data(), CurrentOutputLine());
     }
+
+    pixelIndex_ += LCD_WIDTH;
 }
 
-void FrameBuffer::PushSpritePixels()
+void FrameBuffer::ConvertScanline(uint16_t const* src, uint8_t* dest) const
 {
-    for (size_t dot = 0; dot < LCD_WIDTH; ++dot)
+    if (nativeOutput_)
+    {
+        std::memcpy(dest, src, LCD_WIDTH * sizeof(uint16_t));
+    }
+    else if (BytesPerPixel(outputFormat_) == 2)
     {
-        if (spriteScanline_[dot].initialized_)
+        uint32_t const* colorLut = colorLut_->data();
+        uint16_t* outputLine = reinterpret_cast<uint16_t*>(dest);
+
+        for (int dot = 0; dot < LCD_WIDTH; ++dot)
+        {
+            outputLine[dot] = colorLut[src[dot] & 0x7FFF];
+        }
+    }
+    else
+    {
+        uint32_t const* colorLut = colorLut_->data();
+        uint32_t* outputLine = reinterpret_cast<uint32_t*>(dest);
+
+        for (int dot = 0; dot < LCD_WIDTH; ++dot)
         {
-            scanline_[dot].push_back(spriteScanline_[dot]);
+            outputLine[dot] = colorLut[src[dot] & 0x7FFF];
         }
     }
 }
@@ -0,0 +1,1220 @@
+#include <Graphics/Renderer.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <Graphics/FrameBuffer.hpp>
+#include <Graphics/Registers.hpp>
+#include <Graphics/VramTypes.hpp>
+#include <Utilities/MemoryUtilities.hpp>
+#include <Utilities/StateSerializer.hpp>
+
+namespace
+{
+/// @brief Horizontally flip a row of a 4bpp tile.
+/// @param row Eight 4-bit palette indices, with the leftmost pixel in the least significant nibble.
+/// @return Row with the order of its nibbles reversed.
+uint32_t FlipTileRow4bpp(uint32_t row)
+{
+    row = __builtin_bswap32(row);
+    return ((row & 0x0F0F'0F0F) << 4) | ((row >> 4) & 0x0F0F'0F0F);
+}
+
+/// @brief Horizontally flip a row of an 8bpp tile.
+/// @param row Eight 8-bit palette indices, with the leftmost pixel in the least significant byte.
+/// @return Row with the order of its bytes reversed.
+uint64_t FlipTileRow8bpp(uint64_t row)
+{
+    return __builtin_bswap64(row);
+}
+
+/// @brief Divide two integers, rounding towards negative infinity.
+/// @param dividend Dividend.
+/// @param divisor Divisor, must be non-zero.
+/// @return Floor of quotient.
+int64_t FloorDiv(int64_t dividend, int64_t divisor)
+{
+    int64_t quotient = dividend / divisor;
+    return (((dividend % divisor) != 0) && ((dividend < 0) != (divisor < 0))) ? (quotient - 1) : quotient;
+}
+
+/// @brief Divide two integers, rounding towards positive infinity.
+/// @param dividend Dividend.
+/// @param divisor Divisor, must be non-zero.
+/// @return Ceiling of quotient.
+int64_t CeilDiv(int64_t dividend, int64_t divisor)
+{
+    int64_t quotient = dividend / divisor;
+    return (((dividend % divisor) != 0) && ((dividend < 0) == (divisor < 0))) ? (quotient + 1) : quotient;
+}
+
+/// @brief Find the steps along a scanline for which an affine texture coordinate lands inside a texture.
+/// @param start Coordinate at step 0, as a fixed point value with 8 fractional bits.
+/// @param step Amount the coordinate changes by at each step.
+/// @param size Size of texture along this axis in pixels.
+/// @param count Number of steps in the scanline.
+/// @return Range [first, last) of steps within [0, count) where the integer part of the coordinate is in [0, size). Empty if
+///         first >= last.
+std::pair<int, int> AffineSpan(int32_t start, int32_t step, int size, int count)
+{
+    int64_t const lowerBound = 0;
+    int64_t const upperBound = (static_cast<int64_t>(size) << 8) - 1;
+    int64_t first;
+    int64_t last;
+
+    if (step == 0)
+    {
+        bool inside = (lowerBound <= start) && (start <= upperBound);
+        return {0, inside ? count : 0};
+    }
+    else if (step > 0)
+    {
+        first = CeilDiv(lowerBound - start, step);
+        last = FloorDiv(upperBound - start, step) + 1;
+    }
+    else
+    {
+        first = CeilDiv(upperBound - start, step);
+        last = FloorDiv(lowerBound - start, step) + 1;
+    }
+
+    first = std::max(first, static_cast<int64_t>(0));
+    last = std::min(last, static_cast<int64_t>(count));
+    return {static_cast<int>(first), static_cast<int>(last)};
+}
+
+/// @brief Find the dots of an affine sprite's scanline that are on screen and sample inside the sprite.
+/// @param startDot First dot the sprite's scanline covers. affineX and affineY are the texture coordinates at this dot.
+/// @param endDot Dot after the last one the sprite's scanline covers.
+/// @param affineX Texture x-coordinate at startDot.
+/// @param affineY Texture y-coordinate at startDot.
+/// @param pa Amount to increment x-coordinate by after each dot.
+/// @param pc Amount to increment y-coordinate by after each dot.
+/// @param width Width of sprite in pixels.
+/// @param height Height of sprite in pixels.
+/// @return Range of dots [first, last) to draw. Empty if first >= last.
+std::pair<int, int> AffineSpriteSpan(int startDot, int endDot, int32_t affineX, int32_t affineY, int16_t pa, int16_t pc, int width, int height)
+{
+    int const count = std::min(endDot, Graphics::LCD_WIDTH) - startDot;
+
+    if (count <= 0)
+    {
+        return {0, 0};
+    }
+
+    auto [firstX, lastX] = AffineSpan(affineX, pa, width, count);
+    auto [firstY, lastY] = AffineSpan(affineY, pc, height, count);
+    int const first = std::max({firstX, firstY, -startDot});
+    int const last = std::min(lastX, lastY);
+    return {startDot + first, startDot + last};
+}
+
+/// @brief Determine the dimensions of a sprite in terms of pixels.
+/// @param oamEntry OAM entry of sprite.
+/// @return Width and height of sprite, or zero for both if its shape and size are an illegal combination.
+std::pair<int, int> SpriteDimensions(Graphics::OamEntry const& oamEntry)
+{
+    uint8_t pixelDimensions = (oamEntry.attribute0_.objShape_ << 2) | oamEntry.attribute1_.sharedFlags_.objSize_;
+
+    switch (pixelDimensions)
+    {
+        // Square
+        case 0b00'00:
+            return {8, 8};
+        case 0b00'01:
+            return {16, 16};
+        case 0b00'10:
+            return {32, 32};
+        case 0b00'11:
+            return {64, 64};
+
+        // Horizontal
+        case 0b01'00:
+            return {16, 8};
+        case 0b01'01:
+            return {32, 8};
+        case 0b01'10:
+            return {32, 16};
+        case 0b01'11:
+            return {64, 32};
+
+        // Vertical
+        case 0b10'00:
+            return {8, 16};
+        case 0b10'01:
+            return {8, 32};
+        case 0b10'10:
+            return {16, 32};
+        case 0b10'11:
+            return {32, 64};
+
+        // Illegal combination
+        default:
+            return {0, 0};
+    }
+}
+}
+
+namespace Graphics
+{
+static_assert(sizeof(ScreenBlock) == SCREENBLOCK_SIZE);
+static_assert(sizeof(ScreenBlockEntry) == 2);
+static_assert(sizeof(TileData8bpp) == 64);
+static_assert(sizeof(TileData4bpp) == 32);
+static_assert(sizeof(OamEntry) == 8);
+static_assert(sizeof(AffineObjMatrix) == 32);
+static_assert(sizeof(TwoDim4bppMap) == 2 * CHARBLOCK_SIZE);
+static_assert(sizeof(TwoDim8bppMap) == 2 * CHARBLOCK_SIZE);
+
+Renderer::Renderer() :
+    lcdRegisters_(),
+    dispcnt_(*reinterpret_cast<DISPCNT*>(&lcdRegisters_[0]))
+{
+}
+
+void Renderer::Reset(std::array<uint8_t, 1 * KiB> const& PRAM,
+                     std::array<uint8_t, 96 * KiB> const& VRAM,
+                     std::array<uint8_t, 1 * KiB> const& OAM)
+{
+    scanline_ = 0;
+    window0EnabledOnScanline_ = false;
+    window1EnabledOnScanline_ = false;
+    lcdRegisters_.fill(0);
+    frameBuffer_.Reset();
+
+    PRAM_ = PRAM;
+    VRAM_ = VRAM;
+    OAM_ = OAM;
+
+    stateVersion_ = 0;
+    previousScanlineStates_.fill({MAX_U64, {}, false, false});
+    frameModified_ = true;
+    spriteBinsDirty_ = true;
+}
+
+void Renderer::Serialize(StateSerializer& state,
+                         std::array<uint8_t, 1 * KiB> const& PRAM,
+                         std::array<uint8_t, 96 * KiB> const& VRAM,
+                         std::array<uint8_t, 1 * KiB> const& OAM)
+{
+    state.Value(scanline_);
+    state.Value(window0EnabledOnScanline_);
+    state.Value(window1EnabledOnScanline_);
+    state.Value(bg2RefX_);
+    state.Value(bg2RefY_);
+    state.Value(bg3RefX_);
+    state.Value(bg3RefY_);
+    state.Value(lcdRegisters_);
+    frameBuffer_.Serialize(state);
+
+    if (state.Loading())
+    {
+        PRAM_ = PRAM;
+        VRAM_ = VRAM;
+        OAM_ = OAM;
+
+        // Scanlines drawn before loading were drawn from different memory, so none of them can be reused
+        ++stateVersion_;
+        previousScanlineStates_.fill({MAX_U64, {}, false, false});
+        frameModified_ = true;
+        spriteBinsDirty_ = true;
+    }
+}
+
+void Renderer::SetOutputFormat(PixelFormat format, bool colorCorrection)
+{
+    frameBuffer_.SetOutputFormat(format, colorCorrection);
+
+    // Scanlines from previous frames were written in the old format, so none of them can be reused
+    previousScanlineStates_.fill({MAX_U64, {}, false, false});
+    frameModified_ = true;
+}
+
+void Renderer::SetFrameTarget(uint8_t* target)
+{
+    if (!frameBuffer_.SetFrameTarget(target))
+    {
+        // The new output doesn't hold the previous frame, so none of its scanlines can be repeated
+        previousScanlineStates_.fill({MAX_U64, {}, false, false});
+        frameModified_ = true;
+    }
+}
+
+void Renderer::Execute(RenderCommand const& command)
+{
+    switch (command.type_)
+    {
+        case RenderCommandType::WRITE_PRAM:
+            WritePointer(&PRAM_[command.index_], command.value_, command.alignment_);
+            ++stateVersion_;
+            break;
+        case RenderCommandType::WRITE_VRAM:
+            WritePointer(&VRAM_[command.index_], command.value_, command.alignment_);
+            ++stateVersion_;
+            break;
+        case RenderCommandType::WRITE_OAM:
+            WritePointer(&OAM_[command.index_], command.value_, command.alignment_);
+            ++stateVersion_;
+            spriteBinsDirty_ = true;
+            break;
+        case RenderCommandType::WRITE_REG:
+        {
+            size_t index = command.index_;
+
+            if (WritePointerAndCompare(&lcdRegisters_[index], command.value_, command.alignment_))
+            {
+                ++stateVersion_;
+            }
+
+            // Writing to a reference point register always reloads the internal reference point, even if its value is unchanged.
+            if ((0x28 <= index) && (index < 0x2C))
+            {
+                bg2RefX_ = SignExtend32(*reinterpret_cast<uint32_t*>(&lcdRegisters_[0x28]), 27);
+            }
+            else if ((0x2C <= index) && (index < 0x30))
+            {
+                bg2RefY_ = SignExtend32(*reinterpret_cast<uint32_t*>(&lcdRegisters_[0x2C]), 27);
+            }
+            else if ((0x38 <= index) && (index < 0x3C))
+            {
+                bg3RefX_ = SignExtend32(*reinterpret_cast<uint32_t*>(&lcdRegisters_[0x38]), 27);
+            }
+            else if ((0x3C <= index) && (index < 0x40))
+            {
+                bg3RefY_ = SignExtend32(*reinterpret_cast<uint32_t*>(&lcdRegisters_[0x3C]), 27);
+            }
+
+            break;
+        }
+        case RenderCommandType::RENDER_SCANLINE:
+            scanline_ = command.index_;
+            window0EnabledOnScanline_ = (command.value_ & 0x01) != 0;
+            window1EnabledOnScanline_ = (command.value_ & 0x02) != 0;
+            RenderScanline();
+            break;
+        case RenderCommandType::END_FRAME:
+            EndFrame(command.value_ != 0);
+            break;
+    }
+}
+
+void Renderer::RenderScanline()
+{
+    ScanlineState state = CurrentScanlineState();
+    ScanlineState& previousState = previousScanlineStates_[scanline_];
+
+    if (state == previousState)
+    {
+        // Nothing affecting this scanline has changed since it was drawn in the previous frame.
+        frameBuffer_.RepeatPreviousScanline();
+        IncrementAffineBackgroundReferencePoints();
+        return;
+    }
+
+    previousState = state;
+    frameModified_ = true;
+
+    if (DirectBitmapScanline())
+    {
+        RenderBitmapScanlineDirect();
+        IncrementAffineBackgroundReferencePoints();
+        return;
+    }
+
+    uint16_t backdrop = *reinterpret_cast<uint16_t const*>(&PRAM_[0]);
+    bool windowEnabled = (dispcnt_.value & 0xE000) != 0;
+    bool forceBlank = dispcnt_.forceBlank;
+
+    if (!forceBlank)
+    {
+        if (windowEnabled)
+        {
+            WININ const& winin = *reinterpret_cast<WININ const*>(&lcdRegisters_[0x48]);
+            WINOUT const& winout = *reinterpret_cast<WINOUT const*>(&lcdRegisters_[0x4A]);
+
+            #pragma GCC diagnostic push
+            #pragma GCC diagnostic ignored "-Wnarrowing"
+            WindowSettings outOfWindow = {
+                {winout.outsideBg0Enabled, winout.outsideBg1Enabled, winout.outsideBg2Enabled, winout.outsideBg3Enabled},
+                winout.outsideObjEnabled,
+                winout.outsideSpecialEffect
+            };
+            #pragma GCC diagnostic pop
+
+            frameBuffer_.InitializeWindow(outOfWindow);
+
+            if (dispcnt_.screenDisplayObj && dispcnt_.objWindowDisplay)
+            {
+                #pragma GCC diagnostic push
+                #pragma GCC diagnostic ignored "-Wnarrowing"
+                WindowSettings objWindow = {
+                    {winout.objWinBg0Enabled, winout.objWinBg1Enabled, winout.objWinBg2Enabled, winout.objWinBg3Enabled},
+                    winout.objWinObjEnabled,
+                    winout.objWinSpecialEffect
+                };
+                #pragma GCC diagnostic pop
+
+                WindowMask objWindowArea;
+                objWindowArea.Fill(false);
+                EvaluateOAM(&objWindowArea);
+                frameBuffer_.ApplyWindow(objWindowArea, objWindow);
+            }
+
+            if (dispcnt_.window1Display)
+            {
+                #pragma GCC diagnostic push
+                #pragma GCC diagnostic ignored "-Wnarrowing"
+                WindowSettings window1 = {
+                    {winin.win1Bg0Enabled, winin.win1Bg1Enabled, winin.win1Bg2Enabled, winin.win1Bg3Enabled},
+                    winin.win1ObjEnabled,
+                    winin.win1SpecialEffect
+                };
+                #pragma GCC diagnostic pop
+
+                uint8_t x1 = lcdRegisters_[0x43];
+                uint8_t x2 = lcdRegisters_[0x42];
+
+                if (window1EnabledOnScanline_)
+                {
+                    ConfigureNonObjWindow(x1, x2, window1);
+                }
+            }
+
+            if (dispcnt_.window0Display)
+            {
+                #pragma GCC diagnostic push
+                #pragma GCC diagnostic ignored "-Wnarrowing"
+                WindowSettings window0 = {
+                    {winin.win0Bg0Enabled, winin.win0Bg1Enabled, winin.win0Bg2Enabled, winin.win0Bg3Enabled},
+                    winin.win0ObjEnabled,
+                    winin.win0SpecialEffect
+                };
+                #pragma GCC diagnostic pop
+
+                uint8_t x1 = lcdRegisters_[0x41];
+                uint8_t x2 = lcdRegisters_[0x40];
+
+                if (window0EnabledOnScanline_)
+                {
+                    ConfigureNonObjWindow(x1, x2, window0);
+                }
+            }
+        }
+        else
+        {
+            WindowSettings allEnabled = {
+                {true, true, true, true},
+                true,
+                true
+            };
+
+            frameBuffer_.InitializeWindow(allEnabled);
+        }
+
+        if (dispcnt_.screenDisplayObj)
+        {
+            frameBuffer_.ClearSpritePixels();
+            EvaluateOAM();
+            frameBuffer_.PushSpritePixels();
+        }
+
+        switch (dispcnt_.bgMode)
+        {
+            case 0:
+                RenderMode0Scanline();
+                break;
+            case 1:
+                RenderMode1Scanline();
+                break;
+            case 2:
+                RenderMode2Scanline();
+                break;
+            case 3:
+                RenderMode3Scanline();
+                break;
+            case 4:
+                RenderMode4Scanline();
+                break;
+            case 5:
+                RenderMode5Scanline();
+                break;
+            default:
+                backdrop = 0xFFFF;
+                break;
+        }
+    }
+
+    BLDCNT const& bldcnt = *reinterpret_cast<BLDCNT*>(&lcdRegisters_[0x50]);
+    BLDALPHA const& bldalpha = *reinterpret_cast<BLDALPHA*>(&lcdRegisters_[0x52]);
+    BLDY const& bldy = *reinterpret_cast<BLDY*>(&lcdRegisters_[0x54]);
+
+    frameBuffer_.RenderScanline(backdrop, forceBlank, bldcnt, bldalpha, bldy);
+    IncrementAffineBackgroundReferencePoints();
+}
+
+void Renderer::EndFrame(bool skipped)
+{
+    if (skipped)
+    {
+        frameBuffer_.SkipFrame();
+    }
+    else
+    {
+        frameBuffer_.PublishFrame(frameModified_);
+        frameModified_ = false;
+    }
+
+    bg2RefX_ = SignExtend32(*reinterpret_cast<uint32_t*>(&lcdRegisters_[0x28]), 27);
+    bg2RefY_ = SignExtend32(*reinterpret_cast<uint32_t*>(&lcdRegisters_[0x2C]), 27);
+    bg3RefX_ = SignExtend32(*reinterpret_cast<uint32_t*>(&lcdRegisters_[0x38]), 27);
+    bg3RefY_ = SignExtend32(*reinterpret_cast<uint32_t*>(&lcdRegisters_[0x3C]), 27);
+}
+
+void Renderer::ConfigureNonObjWindow(uint8_t leftEdge, uint8_t rightEdge, WindowSettings settings)
+{
+    if (rightEdge > 240)
+    {
+        rightEdge = 240;
+    }
+
+    if (leftEdge <= rightEdge)
+    {
+        frameBuffer_.ApplyWindow(leftEdge, rightEdge, settings);
+    }
+    else
+    {
+        frameBuffer_.ApplyWindow(0, rightEdge, settings);
+        frameBuffer_.ApplyWindow(leftEdge, 240, settings);
+    }
+}
+
+void Renderer::RenderMode0Scanline()
+{
+    for (uint16_t i = 0; i < 4; ++i)
+    {
+        if (dispcnt_.value & (0x100 << i))
+        {
+            BGCNT const& bgControl = *reinterpret_cast<BGCNT*>(&lcdRegisters_[0x08 + (2 * i)]);
+            uint16_t xOffset = *reinterpret_cast<uint16_t*>(&lcdRegisters_[0x10 + (4 * i)]) & 0x01FF;
+            uint16_t yOffset = *reinterpret_cast<uint16_t*>(&lcdRegisters_[0x12 + (4 * i)]) & 0x01FF;
+            RenderRegularTiledBackgroundScanline(i, bgControl, xOffset, yOffset);
+        }
+    }
+}
+
+void Renderer::RenderMode1Scanline()
+{
+    for (uint16_t i = 0; i < 2; ++i)
+    {
+        if (dispcnt_.value & (0x100 << i))
+        {
+            BGCNT const& bgControl = *reinterpret_cast<BGCNT*>(&lcdRegisters_[0x08 + (2 * i)]);
+            uint16_t xOffset = *reinterpret_cast<uint16_t*>(&lcdRegisters_[0x10 + (4 * i)]) & 0x01FF;
+            uint16_t yOffset = *reinterpret_cast<uint16_t*>(&lcdRegisters_[0x12 + (4 * i)]) & 0x01FF;
+            RenderRegularTiledBackgroundScanline(i, bgControl, xOffset, yOffset);
+        }
+    }
+
+    if (dispcnt_.screenDisplayBg2)
+    {
+        BGCNT const& bgControl = *reinterpret_cast<BGCNT*>(&lcdRegisters_[0x0C]);
+        int16_t pa = *reinterpret_cast<int16_t*>(&lcdRegisters_[0x20]);
+        int16_t pc = *reinterpret_cast<int16_t*>(&lcdRegisters_[0x24]);
+        RenderAffineTiledBackgroundScanline(2, bgControl, bg2RefX_, bg2RefY_, pa, pc);
+    }
+}
+
+void Renderer::RenderMode2Scanline()
+{
+    if (dispcnt_.screenDisplayBg2)
+    {
+        BGCNT const& bgControl = *reinterpret_cast<BGCNT*>(&lcdRegisters_[0x0C]);
+        int16_t pa = *reinterpret_cast<int16_t*>(&lcdRegisters_[0x20]);
+        int16_t pc = *reinterpret_cast<int16_t*>(&lcdRegisters_[0x24]);
+        RenderAffineTiledBackgroundScanline(2, bgControl, bg2RefX_, bg2RefY_, pa, pc);
+    }
+
+    if (dispcnt_.screenDisplayBg3)
+    {
+        BGCNT const& bgControl = *reinterpret_cast<BGCNT*>(&lcdRegisters_[0x0E]);
+        int16_t pa = *reinterpret_cast<int16_t*>(&lcdRegisters_[0x30]);
+        int16_t pc = *reinterpret_cast<int16_t*>(&lcdRegisters_[0x34]);
+        RenderAffineTiledBackgroundScanline(3, bgControl, bg3RefX_, bg3RefY_, pa, pc);
+    }
+}
+
+void Renderer::RenderMode3Scanline()
+{
+    BGCNT const& bgControl = *reinterpret_cast<BGCNT*>(&lcdRegisters_[0x0C]);
+    size_t vramIndex = scanline_ * 480;
+    uint16_t const* vramPtr = reinterpret_cast<uint16_t const*>(&VRAM_.at(vramIndex));
+
+    if (dispcnt_.screenDisplayBg2)
+    {
+        frameBuffer_.BgWindow(2).ForEachSpan(0, LCD_WIDTH, [&](int firstDot, int lastDot)
+        {
+            for (int dot = firstDot; dot < lastDot; ++dot)
+            {
+                frameBuffer_.PushPixel({PixelSrc::BG2, vramPtr[dot], bgControl.bgPriority, false}, dot);
+            }
+        });
+    }
+}
+
+void Renderer::RenderMode4Scanline()
+{
+    BGCNT const& bgControl = *reinterpret_cast<BGCNT*>(&lcdRegisters_[0x0C]);
+    size_t vramIndex = scanline_ * 240;
+    uint16_t const* palettePtr = reinterpret_cast<uint16_t const*>(PRAM_.data());
+
+    if (dispcnt_.displayFrameSelect)
+    {
+        vramIndex += 0xA000;
+    }
+
+    if (dispcnt_.screenDisplayBg2)
+    {
+        uint8_t const* vramPtr = &VRAM_.at(vramIndex);
+
+        frameBuffer_.BgWindow(2).ForEachSpan(0, LCD_WIDTH, [&](int firstDot, int lastDot)
+        {
+            for (int dot = firstDot; dot < lastDot; ++dot)
+            {
+                uint8_t paletteIndex = vramPtr[dot];
+                bool transparent = (paletteIndex == 0);
+                uint16_t bgr555 = palettePtr[paletteIndex];
+                frameBuffer_.PushPixel({PixelSrc::BG2, bgr555, bgControl.bgPriority, transparent}, dot);
+            }
+        });
+    }
+}
+
+void Renderer::RenderMode5Scanline()
+{
+    constexpr int MODE_5_WIDTH = 160;
+    constexpr int MODE_5_HEIGHT = 128;
+
+    if (!dispcnt_.screenDisplayBg2 || (scanline_ >= MODE_5_HEIGHT))
+    {
+        return;
+    }
+
+    BGCNT const& bgControl = *reinterpret_cast<BGCNT*>(&lcdRegisters_[0x0C]);
+    size_t vramIndex = scanline_ * MODE_5_WIDTH * 2;
+
+    if (dispcnt_.displayFrameSelect)
+    {
+        vramIndex += 0xA000;
+    }
+
+    uint16_t const* vramPtr = reinterpret_cast<uint16_t const*>(&VRAM_.at(vramIndex));
+
+    frameBuffer_.BgWindow(2).ForEachSpan(0, MODE_5_WIDTH, [&](int firstDot, int lastDot)
+    {
+        for (int dot = firstDot; dot < lastDot; ++dot)
+        {
+            frameBuffer_.PushPixel({PixelSrc::BG2, vramPtr[dot], bgControl.bgPriority, false}, dot);
+        }
+    });
+}
+
+bool Renderer::DirectBitmapScanline() const
+{
+    BLDCNT const& bldcnt = *reinterpret_cast<BLDCNT const*>(&lcdRegisters_[0x50]);
+
+    return (dispcnt_.bgMode >= 3) && (dispcnt_.bgMode <= 5) &&
+           !dispcnt_.forceBlank &&
+           !dispcnt_.screenDisplayObj &&
+           ((dispcnt_.value & 0xE000) == 0) &&
+           (static_cast<SpecialEffect>(bldcnt.specialEffect) == SpecialEffect::None);
+}
+
+void Renderer::RenderBitmapScanlineDirect()
+{
+    uint16_t* outputLine = frameBuffer_.StartDirectScanline();
+    uint16_t const* palettePtr = reinterpret_cast<uint16_t const*>(PRAM_.data());
+    uint16_t const backdrop = palettePtr[0];
+
+    if (!dispcnt_.screenDisplayBg2)
+    {
+        std::fill_n(outputLine, LCD_WIDTH, backdrop);
+        frameBuffer_.FinishDirectScanline();
+        return;
+    }
+
+    size_t frameOffset = dispcnt_.displayFrameSelect ? 0xA000 : 0;
+
+    switch (dispcnt_.bgMode)
+    {
+        case 3:
+        {
+            uint8_t const* vramPtr = &VRAM_[scanline_ * LCD_WIDTH * 2];
+            std::memcpy(outputLine, vramPtr, LCD_WIDTH * sizeof(uint16_t));
+            break;
+        }
+        case 4:
+        {
+            // Palette index 0 is transparent and shows the backdrop, which is also palette entry 0.
+            uint8_t const* vramPtr = &VRAM_[frameOffset + (scanline_ * LCD_WIDTH)];
+
+            for (int dot = 0; dot < LCD_WIDTH; ++dot)
+            {
+                outputLine[dot] = palettePtr[vramPtr[dot]];
+            }
+
+            break;
+        }
+        case 5:
+        {
+            constexpr int MODE_5_WIDTH = 160;
+            constexpr int MODE_5_HEIGHT = 128;
+
+            if (scanline_ >= MODE_5_HEIGHT)
+            {
+                std::fill_n(outputLine, LCD_WIDTH, backdrop);
+                break;
+            }
+
+            uint8_t const* vramPtr = &VRAM_[frameOffset + (scanline_ * MODE_5_WIDTH * 2)];
+            std::memcpy(outputLine, vramPtr, MODE_5_WIDTH * sizeof(uint16_t));
+            std::fill_n(outputLine + MODE_5_WIDTH, LCD_WIDTH - MODE_5_WIDTH, backdrop);
+            break;
+        }
+        default:
+            break;
+    }
+
+    frameBuffer_.FinishDirectScanline();
+}
+
+void Renderer::RenderRegularTiledBackgroundScanline(int bgIndex, BGCNT const& control, int xOffset, int yOffset)
+{
+    int const width = (control.screenSize & 0b01) ? 512 : 256;
+    int const height = (control.screenSize & 0b10) ? 512 : 256;
+
+    int const x = xOffset % width;
+    int const y = (scanline_ + yOffset) % height;
+
+    if (control.colorMode)
+    {
+        RenderRegular8bppBackground(bgIndex, control, x, y, width);
+    }
+    else
+    {
+        RenderRegular4bppBackground(bgIndex, control, x, y, width);
+    }
+}
+
+void Renderer::RenderRegular4bppBackground(int bgIndex, BGCNT const& control, int x, int y, int width)
+{
+    ScreenBlock const* screenBlockPtr =
+        reinterpret_cast<ScreenBlock const*>(&VRAM_[control.screenBaseBlock * SCREENBLOCK_SIZE]);
+
+    if (y > 255)
+    {
+        ++screenBlockPtr;
+
+        if (width == 512)
+        {
+            ++screenBlockPtr;
+        }
+    }
+
+    int const mapY = (y / 8) % 32;
+    TileData4bpp const* baseTilePtr = reinterpret_cast<TileData4bpp const*>(&VRAM_[control.charBaseBlock * CHARBLOCK_SIZE]);
+    uint16_t const* palettePtr = reinterpret_cast<uint16_t const*>(&PRAM_[0]);
+
+    // Control data
+    PixelSrc const src = static_cast<PixelSrc>(bgIndex + 1);
+    int const priority = control.bgPriority;
+    WindowMask const& bgWindow = frameBuffer_.BgWindow(bgIndex);
+
+    // Decode one tile row at a time. Transparent pixels are never drawn over anything, so they're skipped.
+    int dot = 0;
+
+    while (dot < LCD_WIDTH)
+    {
+        int const mapX = x / 8;
+        int const span = std::min(8 - (x % 8), LCD_WIDTH - dot);
+        size_t const screenBlockIndex = (mapX > 31) ? 1 : 0;
+        ScreenBlockEntry const& screenBlockEntry = screenBlockPtr[screenBlockIndex].screenBlockEntry_[mapY][mapX % 32];
+
+        int const tileY = screenBlockEntry.verticalFlip_ ? ((y % 8) ^ 7) : (y % 8);
+        uint32_t tileRow;
+        std::memcpy(&tileRow, &baseTilePtr[screenBlockEntry.tile_].paletteIndex_[tileY][0], sizeof(tileRow));
+
+        if (screenBlockEntry.horizontalFlip_)
+        {
+            tileRow = FlipTileRow4bpp(tileRow);
+        }
+
+        tileRow >>= (4 * (x % 8));
+        size_t const palette = (screenBlockEntry.palette_ << 4);
+
+        for (int i = 0; i < span; ++i, ++dot, tileRow >>= 4)
+        {
+            size_t paletteIndex = tileRow & 0x0F;
+
+            if ((paletteIndex != 0) && bgWindow.Test(dot))
+            {
+                frameBuffer_.PushPixel({src, palettePtr[palette | paletteIndex], priority, false}, dot);
+            }
+        }
+
+        x = (x + span) % width;
+    }
+}
+
+void Renderer::RenderRegular8bppBackground(int bgIndex, BGCNT const& control, int x, int y, int width)
+{
+    ScreenBlock const* screenBlockPtr =
+        reinterpret_cast<ScreenBlock const*>(&VRAM_[control.screenBaseBlock * SCREENBLOCK_SIZE]);
+
+    if (y > 255)
+    {
+        ++screenBlockPtr;
+
+        if (width == 512)
+        {
+            ++screenBlockPtr;
+        }
+    }
+
+    int const mapY = (y / 8) % 32;
+    size_t const charBlockAddr = control.charBaseBlock * CHARBLOCK_SIZE;
+    TileData8bpp const* baseTilePtr = reinterpret_cast<TileData8bpp const*>(&VRAM_[charBlockAddr]);
+    uint16_t const* palettePtr = reinterpret_cast<uint16_t const*>(&PRAM_[0]);
+
+    // Control data
+    PixelSrc const src = static_cast<PixelSrc>(bgIndex + 1);
+    int const priority = control.bgPriority;
+    WindowMask const& bgWindow = frameBuffer_.BgWindow(bgIndex);
+
+    // Decode one tile row at a time. Transparent pixels are never drawn over anything, so they're skipped.
+    int dot = 0;
+
+    while (dot < LCD_WIDTH)
+    {
+        int const mapX = x / 8;
+        int const span = std::min(8 - (x % 8), LCD_WIDTH - dot);
+        size_t const screenBlockIndex = (mapX > 31) ? 1 : 0;
+        ScreenBlockEntry const& screenBlockEntry = screenBlockPtr[screenBlockIndex].screenBlockEntry_[mapY][mapX % 32];
+        bool const outOfRange = (charBlockAddr + (screenBlockEntry.tile_ * sizeof(TileData8bpp))) >= 0x0001'0000;
+
+        if (outOfRange)
+        {
+            dot += span;
+            x = (x + span) % width;
+            continue;
+        }
+
+        int const tileY = screenBlockEntry.verticalFlip_ ? ((y % 8) ^ 7) : (y % 8);
+        uint64_t tileRow;
+        std::memcpy(&tileRow, &baseTilePtr[screenBlockEntry.tile_].paletteIndex_[tileY][0], sizeof(tileRow));
+
+        if (screenBlockEntry.horizontalFlip_)
+        {
+            tileRow = FlipTileRow8bpp(tileRow);
+        }
+
+        tileRow >>= (8 * (x % 8));
+
+        for (int i = 0; i < span; ++i, ++dot, tileRow >>= 8)
+        {
+            size_t paletteIndex = tileRow & 0xFF;
+
+            if ((paletteIndex != 0) && bgWindow.Test(dot))
+            {
+                frameBuffer_.PushPixel({src, palettePtr[paletteIndex], priority, false}, dot);
+            }
+        }
+
+        x = (x + span) % width;
+    }
+}
+
+void Renderer::RenderAffineTiledBackgroundScanline(int bgIndex, BGCNT const& control, int32_t dx, int32_t dy, int16_t pa, int16_t pc)
+{
+    // Map size
+    int mapSizeInTiles;
+
+    switch (control.screenSize)
+    {
+        case 0:
+            mapSizeInTiles = 16;
+            break;
+        case 1:
+            mapSizeInTiles = 32;
+            break;
+        case 2:
+            mapSizeInTiles = 64;
+            break;
+        case 3:
+            mapSizeInTiles = 128;
+            break;
+    }
+
+    int const mapSizeInPixels = mapSizeInTiles * 8;
+    int const mapMask = mapSizeInPixels - 1;
+
+    // Control fields
+    bool const wrapOnOverflow = control.overflowMode;
+    int const priority = control.bgPriority;
+    PixelSrc const src = static_cast<PixelSrc>(bgIndex + 1);
+
+    // VRAM pointers
+    uint8_t const* screenBlockPtr = &VRAM_[control.screenBaseBlock * SCREENBLOCK_SIZE];
+    TileData8bpp const* tilePtr = reinterpret_cast<TileData8bpp const*>(&VRAM_[control.charBaseBlock * CHARBLOCK_SIZE]);
+    uint16_t const* palettePtr = reinterpret_cast<uint16_t const*>(PRAM_.data());
+
+    // Dots outside the map are transparent when not wrapping, so only the span that lands inside the map needs to be drawn.
+    int firstDot = 0;
+    int lastDot = LCD_WIDTH;
+
+    if (!wrapOnOverflow)
+    {
+        auto [firstX, lastX] = AffineSpan(dx, pa, mapSizeInPixels, LCD_WIDTH);
+        auto [firstY, lastY] = AffineSpan(dy, pc, mapSizeInPixels, LCD_WIDTH);
+        firstDot = std::max(firstX, firstY);
+        lastDot = std::min(lastX, lastY);
+    }
+
+    WindowMask const& bgWindow = frameBuffer_.BgWindow(bgIndex);
+
+    if ((pa == 0x100) && (pc == 0))
+    {
+        // Unscaled and unrotated, so every dot samples the same map row and steps one pixel to the right.
+        int const screenY = (dy >> 8) & mapMask;
+        uint8_t const* mapRowPtr = &screenBlockPtr[(screenY / 8) * mapSizeInTiles];
+        int const tileY = screenY % 8;
+
+        bgWindow.ForEachSpan(firstDot, lastDot, [&](int spanFirstDot, int spanLastDot)
+        {
+            int32_t screenX = (dx >> 8) + spanFirstDot;
+
+            for (int dot = spanFirstDot; dot < spanLastDot; ++dot, ++screenX)
+            {
+                int const wrappedX = screenX & mapMask;
+                size_t tileIndex = mapRowPtr[wrappedX / 8];
+                size_t paletteIndex = tilePtr[tileIndex].paletteIndex_[tileY][wrappedX % 8];
+
+                if (paletteIndex != 0)
+                {
+                    frameBuffer_.PushPixel({src, palettePtr[paletteIndex], priority, false}, dot);
+                }
+            }
+        });
+
+        return;
+    }
+
+    bgWindow.ForEachSpan(firstDot, lastDot, [&](int spanFirstDot, int spanLastDot)
+    {
+        int32_t affineX = dx + (spanFirstDot * pa);
+        int32_t affineY = dy + (spanFirstDot * pc);
+
+        for (int dot = spanFirstDot; dot < spanLastDot; ++dot)
+        {
+            int const screenX = (affineX >> 8) & mapMask;
+            int const screenY = (affineY >> 8) & mapMask;
+            size_t tileIndex = screenBlockPtr[(screenX / 8) + ((screenY / 8) * mapSizeInTiles)];
+            size_t paletteIndex = tilePtr[tileIndex].paletteIndex_[screenY % 8][screenX % 8];
+
+            if (paletteIndex != 0)
+            {
+                frameBuffer_.PushPixel({src, palettePtr[paletteIndex], priority, false}, dot);
+            }
+
+            affineX += pa;
+            affineY += pc;
+        }
+    });
+}
+
+void Renderer::RebuildSpriteBins()
+{
+    OamEntry const* oam = reinterpret_cast<OamEntry const*>(OAM_.data());
+
+    for (auto& bin : spriteBins_)
+    {
+        bin.count_ = 0;
+    }
+
+    for (int i = 0; i < 128; ++i)
+    {
+        OamEntry const& oamEntry = oam[i];
+
+        // Skip disabled sprites and illegal sprites
+        if ((oamEntry.attribute0_.objMode_ == 2) || (oamEntry.attribute0_.gfxMode_ == 3))
+        {
+            continue;
+        }
+
+        auto [width, height] = SpriteDimensions(oamEntry);
+
+        if (height == 0)
+        {
+            continue;
+        }
+
+        int topEdge = oamEntry.attribute0_.yCoordinate_;
+
+        if (topEdge >= 160)
+        {
+            topEdge -= 256;
+        }
+
+        int bottomEdge = topEdge + height - 1;
+
+        if (oamEntry.attribute0_.objMode_ == 3)
+        {
+            // Double size affine sprites
+            bottomEdge = topEdge + (2 * height) - 1;
+        }
+
+        for (int scanline = std::max(topEdge, 0); scanline <= std::min(bottomEdge, LCD_HEIGHT - 1); ++scanline)
+        {
+            SpriteBin& bin = spriteBins_[scanline];
+            bin.indices_[bin.count_++] = i;
+        }
+    }
+
+    spriteBinsDirty_ = false;
+}
+
+void Renderer::EvaluateOAM(WindowMask* objWindowPtr)
+{
+    if (spriteBinsDirty_)
+    {
+        RebuildSpriteBins();
+    }
+
+    OamEntry const* oam = reinterpret_cast<OamEntry const*>(OAM_.data());
+    bool const evaluateWindowSprites = (objWindowPtr != nullptr);
+    SpriteBin const& bin = spriteBins_[scanline_];
+
+    for (size_t binIndex = 0; binIndex < bin.count_; ++binIndex)
+    {
+        OamEntry const& oamEntry = oam[bin.indices_[binIndex]];
+
+        // Skip window sprites when evaluating visible sprites, and vice versa
+        if ((evaluateWindowSprites && (oamEntry.attribute0_.gfxMode_ != 2)) ||
+            (!evaluateWindowSprites && (oamEntry.attribute0_.gfxMode_ == 2)))
+        {
+            continue;
+        }
+
+        auto [width, height] = SpriteDimensions(oamEntry);
+        int y = oamEntry.attribute0_.yCoordinate_;
+        int x = oamEntry.attribute1_.sharedFlags_.xCoordinate_;
+
+        if (y >= 160)
+        {
+            y -= 256;
+        }
+
+        if (x & 0x0100)
+        {
+            x = (~0x01FF) | (x & 0x01FF);
+        }
+
+        if (oamEntry.attribute0_.objMode_ == 3)
+        {
+            y += (height / 2);
+            x += (width / 2);
+        }
+
+        size_t const rendererIndex = (dispcnt_.objCharacterVramMapping ? 0x08 : 0) |
+                                     (oamEntry.attribute0_.colorMode_ ? 0x04 : 0) |
+                                     ((oamEntry.attribute0_.objMode_ != 0) ? 0x02 : 0) |
+                                     (evaluateWindowSprites ? 0x01 : 0);
+
+        (this->*SPRITE_RENDERERS[rendererIndex])(x, y, width, height, oamEntry, objWindowPtr);
+    }
+}
+
+template <bool OneDimMapping, bool Color256, bool Affine, bool ObjWindow>
+void Renderer::RenderSprite(int x, int y, int width, int height, OamEntry const& oamEntry, WindowMask* objWindowPtr)
+{
+    using TileRow = std::conditional_t<Color256, uint64_t, uint32_t>;
+    constexpr int BITS_PER_PIXEL = Color256 ? 8 : 4;
+    constexpr TileRow PIXEL_MASK = Color256 ? 0xFF : 0x0F;
+
+    uint8_t const* const charPtr = &VRAM_[OBJ_CHARBLOCK_ADDR];
+    uint16_t const* const palettePtr = reinterpret_cast<uint16_t const*>(&PRAM_[OBJ_PALETTE_ADDR]);
+    WindowMask const& objWindow = frameBuffer_.ObjWindow();
+
+    int const widthInTiles = width / 8;
+    int const baseTile = oamEntry.attribute2_.tile_;
+    int const palette = Color256 ? 0 : (oamEntry.attribute2_.palette_ << 4);
+    int const priority = oamEntry.attribute2_.priority_;
+    bool const semiTransparent = (oamEntry.attribute0_.gfxMode_ == 1);
+
+    // Offset into OBJ character data of the row of pixels that a sprite texture row crosses within a tile column. Offsets wrap
+    // around the end of character data, and since rows are aligned to their size, a single row never crosses it.
+    auto tileRowOffset = [=](int tileColumn, int textureY)
+    {
+        constexpr int TILE_STEP = Color256 ? 2 : 1;
+        int const tileRow = textureY / 8;
+        int const tile = OneDimMapping ?
+            baseTile + (((tileRow * widthInTiles) + tileColumn) * TILE_STEP) :
+            (Color256 ? (baseTile & ~0x01) : baseTile) + (tileRow * 32) + (tileColumn * TILE_STEP);
+
+        return ((tile * sizeof(TileData4bpp)) + ((textureY % 8) * sizeof(TileRow))) % (2 * CHARBLOCK_SIZE);
+    };
+
+    // Mark or draw a pixel. Palette index 0 is transparent and never affects anything.
+    auto drawPixel = [&](int dot, size_t paletteIndex)
+    {
+        if (paletteIndex == 0)
+        {
+            return;
+        }
+
+        if constexpr (ObjWindow)
+        {
+            objWindowPtr->Set(dot);
+        }
+        else
+        {
+            Pixel& currentPixel = frameBuffer_.GetSpritePixel(dot);
+
+            if (objWindow.Test(dot) && (currentPixel.Transparent() || (priority < currentPixel.Priority())))
+            {
+                currentPixel = Pixel(PixelSrc::OBJ, palettePtr[palette | paletteIndex], priority, false, semiTransparent);
+            }
+        }
+    };
+
+    if constexpr (!Affine)
+    {
+        bool const verticalFlip = oamEntry.attribute1_.noRotationOrScaling_.verticalFlip_;
+        bool const horizontalFlip = oamEntry.attribute1_.noRotationOrScaling_.horizontalFlip_;
+        int const textureY = verticalFlip ? (height - 1 - (scanline_ - y)) : (scanline_ - y);
+        int const lastDot = std::min(LCD_WIDTH, x + width);
+        int dot = std::max(0, x);
+
+        // Decode one tile row at a time
+        while (dot < lastDot)
+        {
+            int const spriteX = dot - x;
+            int const tileColumn = horizontalFlip ? (widthInTiles - (spriteX / 8) - 1) : (spriteX / 8);
+            int const span = std::min(8 - (spriteX % 8), lastDot - dot);
+
+            TileRow tileRow;
+            std::memcpy(&tileRow, &charPtr[tileRowOffset(tileColumn, textureY)], sizeof(tileRow));
+
+            if (horizontalFlip)
+            {
+                if constexpr (Color256)
+                {
+                    tileRow = FlipTileRow8bpp(tileRow);
+                }
+                else
+                {
+                    tileRow = FlipTileRow4bpp(tileRow);
+                }
+            }
+
+            tileRow >>= (BITS_PER_PIXEL * (spriteX % 8));
+
+            for (int i = 0; i < span; ++i, ++dot, tileRow >>= BITS_PER_PIXEL)
+            {
+                drawPixel(dot, tileRow & PIXEL_MASK);
+            }
+        }
+    }
+    else
+    {
+        AffineObjMatrix const& affineMatrix =
+            reinterpret_cast<AffineObjMatrix const*>(&OAM_[0])[oamEntry.attribute1_.rotationOrScaling_.parameterSelection_];
+
+        int16_t const pa = affineMatrix.pa_;
+        int16_t const pb = affineMatrix.pb_;
+        int16_t const pc = affineMatrix.pc_;
+        int16_t const pd = affineMatrix.pd_;
+
+        int leftEdge = x;
+        int rightEdge = x + width;
+        int topEdge = y;
+        int const halfWidth = width / 2;
+        int const halfHeight = height / 2;
+        bool const doubleSize = (oamEntry.attribute0_.objMode_ == 3);
+
+        if (doubleSize)
+        {
+            leftEdge -= halfWidth;
+            rightEdge += halfWidth;
+            topEdge -= halfHeight;
+        }
+
+        // Rotation center
+        int16_t const x0 = doubleSize ? width : halfWidth;
+        int16_t const y0 = doubleSize ? height : halfHeight;
+
+        // Screen position
+        int16_t const x1 = 0;
+        int16_t const y1 = scanline_ - topEdge;
+
+        int32_t affineX = (pa * (x1 - x0)) + (pb * (y1 - y0)) + (halfWidth << 8);
+        int32_t affineY = (pc * (x1 - x0)) + (pd * (y1 - y0)) + (halfHeight << 8);
+
+        auto [firstDot, lastDot] = AffineSpriteSpan(leftEdge, rightEdge, affineX, affineY, pa, pc, width, height);
+        affineX += (firstDot - leftEdge) * pa;
+        affineY += (firstDot - leftEdge) * pc;
+
+        for (int dot = firstDot; dot < lastDot; ++dot)
+        {
+            int32_t const textureX = (affineX >> 8);
+            int32_t const textureY = (affineY >> 8);
+            affineX += pa;
+            affineY += pc;
+
+            uint8_t const* const rowPtr = &charPtr[tileRowOffset(textureX / 8, textureY)];
+
+            if constexpr (Color256)
+            {
+                drawPixel(dot, rowPtr[textureX % 8]);
+            }
+            else
+            {
+                drawPixel(dot, (rowPtr[(textureX % 8) / 2] >> (4 * (textureX % 2))) & PIXEL_MASK);
+            }
+        }
+    }
+}
+
+std::array<Renderer::SpriteRenderer, 16> const Renderer::SPRITE_RENDERERS = {
+    &Renderer::RenderSprite<false, false, false, false>,
+    &Renderer::RenderSprite<false, false, false, true>,
+    &Renderer::RenderSprite<false, false, true, false>,
+    &Renderer::RenderSprite<false, false, true, true>,
+    &Renderer::RenderSprite<false, true, false, false>,
+    &Renderer::RenderSprite<false, true, false, true>,
+    &Renderer::RenderSprite<false, true, true, false>,
+    &Renderer::RenderSprite<false, true, true, true>,
+    &Renderer::RenderSprite<true, false, false, false>,
+    &Renderer::RenderSprite<true, false, false, true>,
+    &Renderer::RenderSprite<true, false, true, false>,
+    &Renderer::RenderSprite<true, false, true, true>,
+    &Renderer::RenderSprite<true, true, false, false>,
+    &Renderer::RenderSprite<true, true, false, true>,
+    &Renderer::RenderSprite<true, true, true, false>,
+    &Renderer::RenderSprite<true, true, true, true>
+};
+
+void Renderer::IncrementAffineBackgroundReferencePoints()
+{
+    bg2RefX_ += *reinterpret_cast<int16_t*>(&lcdRegisters_[0x22]);  // PB
+    bg2RefY_ += *reinterpret_cast<int16_t*>(&lcdRegisters_[0x26]);  // PD
+    bg3RefX_ += *reinterpret_cast<int16_t*>(&lcdRegisters_[0x32]);  // PB
+    bg3RefY_ += *reinterpret_cast<int16_t*>(&lcdRegisters_[0x36]);  // PD
+}
+
+Renderer::ScanlineState Renderer::CurrentScanlineState() const
+{
+    return {stateVersion_, {bg2RefX_, bg2RefY_, bg3RefX_, bg3RefY_}, window0EnabledOnScanline_, window1EnabledOnScanline_};
+}
+}
@@ -1,4 +1,5 @@
 #include <CPU/ArmInstructions.hpp>
+#include <array>
 #include <bit>
 #include <cstdint>
 #include <format>
@@ -183,8 +184,10 @@ void BlockDataTransfer::SetMnemonic(std::string& mnemonic)
         instruction_.word, op, cond, addr, instruction_.W ? "!" : "", regStream.str(), instruction_.S ? "^" : "");
 }
 
-void Branch::SetMnemonic(std::string& mnemonic, uint32_t newPC)
+void Branch::SetMnemonic(std::string& mnemonic, std::array<uint32_t, 16> const& registers)
 {
+    int32_t signedOffset = SignExtend32(instruction_.Offset << 2, 25);
+    uint32_t newPC = registers[PC_INDEX] + signedOffset;
     std::string op = instruction_.L ? "BL" : "B";
     std::string cond = Logging::ConditionMnemonic(instruction_.Cond);
     mnemonic = std::format("{:08X} -> {}{} 0x{:08X}", instruction_.word, op, cond, newPC);
@@ -203,8 +206,9 @@ void Undefined::SetMnemonic(std::string& mnemonic)
     mnemonic = std::format("{:08X} -> UNDEFINED {}", instruction_.word, cond);
 }
 
-void SingleDataTransfer::SetMnemonic(std::string& mnemonic, uint32_t offset)
+void SingleDataTransfer::SetMnemonic(std::string& mnemonic)
 {
+    uint32_t offset = instruction_.flags.Offset;
     std::string op = instruction_.flags.L ? "LDR" : "STR";
     std::string cond = Logging::ConditionMnemonic(instruction_.flags.Cond);
     std::string xfer = instruction_.flags.B ? "B" : "";
@@ -349,8 +353,9 @@ void MultiplyLong::SetMnemonic(std::string& mnemonic)
     }
 }
 
-void HalfwordDataTransferRegisterOffset::SetMnemonic(std::string& mnemonic, uint32_t offset)
+void HalfwordDataTransferRegisterOffset::SetMnemonic(std::string& mnemonic, std::array<uint32_t, 16> const& registers)
 {
+    uint32_t offset = registers[instruction_.Rm];
     uint8_t offsetRegIndex = instruction_.Rm;
     std::string offsetExpression = (offset == 0 ? "" : std::format("R{}", offsetRegIndex));
     std::string halfwordDataTransferStr = HalfwordDataTransferHelper(instruction_.L,
@@ -367,8 +372,9 @@ void HalfwordDataTransferRegisterOffset::SetMnemonic(std::string& mnemonic, uint
     mnemonic = std::format("{:08X} -> {}", instruction_.word, halfwordDataTransferStr);
 }
 
-void HalfwordDataTransferImmediateOffset::SetMnemonic(std::string& mnemonic, uint8_t offset)
+void HalfwordDataTransferImmediateOffset::SetMnemonic(std::string& mnemonic)
 {
+    uint8_t offset = (instruction_.Offset1 << 4) | instruction_.Offset;
     std::string offsetExpression = (offset == 0 ? "" : std::format("#{}", offset));
     std::string halfwordDataTransferStr = HalfwordDataTransferHelper(instruction_.L,
                                                                      instruction_.Cond,
@@ -423,8 +429,10 @@ void PSRTransferMSR::SetMnemonic(std::string& mnemonic)
     mnemonic = std::format("{:08X} -> MSR{} {}", instruction_.word, cond, expression);
 }
 
-void DataProcessing::SetMnemonic(std::string& mnemonic, uint32_t operand2)
+void DataProcessing::SetMnemonic(std::string& mnemonic)
 {
+    uint32_t operand2 = instruction_.rotatedImmediate.Imm;
+    operand2 = std::rotr(operand2, instruction_.rotatedImmediate.RotateAmount << 1);
     std::string op;
     std::string cond = Logging::ConditionMnemonic(instruction_.flags.Cond);
     std::string s = instruction_.flags.S ? "S" : "";
@@ -576,4 +584,72 @@ void DataProcessing::SetMnemonic(std::string& mnemonic, uint32_t operand2)
 
     mnemonic = std::format("{:08X} -> {}{}{} {}", instruction_.word, op, cond, s, regInfo);
 }
+
+std::string Disassemble(uint32_t undecodedInstruction, std::array<uint32_t, 16> const& registers)
+{
+    std::string mnemonic;
+
+    if (BranchAndExchange::IsInstanceOf(undecodedInstruction))
+    {
+        BranchAndExchange(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else if (BlockDataTransfer::IsInstanceOf(undecodedInstruction))
+    {
+        BlockDataTransfer(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else if (Branch::IsInstanceOf(undecodedInstruction))
+    {
+        Branch(undecodedInstruction).SetMnemonic(mnemonic, registers);
+    }
+    else if (SoftwareInterrupt::IsInstanceOf(undecodedInstruction))
+    {
+        SoftwareInterrupt(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else if (Undefined::IsInstanceOf(undecodedInstruction))
+    {
+        Undefined(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else if (SingleDataTransfer::IsInstanceOf(undecodedInstruction))
+    {
+        SingleDataTransfer(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else if (SingleDataSwap::IsInstanceOf(undecodedInstruction))
+    {
+        SingleDataSwap(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else if (Multiply::IsInstanceOf(undecodedInstruction))
+    {
+        Multiply(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else if (MultiplyLong::IsInstanceOf(undecodedInstruction))
+    {
+        MultiplyLong(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else if (HalfwordDataTransferRegisterOffset::IsInstanceOf(undecodedInstruction))
+    {
+        HalfwordDataTransferRegisterOffset(undecodedInstruction).SetMnemonic(mnemonic, registers);
+    }
+    else if (HalfwordDataTransferImmediateOffset::IsInstanceOf(undecodedInstruction))
+    {
+        HalfwordDataTransferImmediateOffset(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else if (PSRTransferMRS::IsInstanceOf(undecodedInstruction))
+    {
+        PSRTransferMRS(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else if (PSRTransferMSR::IsInstanceOf(undecodedInstruction))
+    {
+        PSRTransferMSR(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else if (DataProcessing::IsInstanceOf(undecodedInstruction))
+    {
+        DataProcessing(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else
+    {
+        mnemonic = std::format("{:08X} -> UNKNOWN", undecodedInstruction);
+    }
+
+    return mnemonic;
+}
 }
@@ -1,12 +1,21 @@
 #include <Logging/Logging.hpp>
 #include <Config.hpp>
+#include <array>
 #include <cstdint>
+#include <exception>
 #include <filesystem>
 #include <format>
 #include <fstream>
+#include <memory>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <utility>
+#include <CPU/ArmInstructions.hpp>
+#include <CPU/CpuTypes.hpp>
+#include <CPU/ThumbInstructions.hpp>
 #include <DMA/DmaChannel.hpp>
+#include <Logging/TraceStream.hpp>
 #include <System/EventScheduler.hpp>
 #include <System/SystemControl.hpp>
 
@@ -75,42 +84,165 @@ std::string DmaXferString(DmaXfer xferType)
 
     return "";
 }
+
+/// @brief Convert the registers captured in an instruction record to a human readable format.
+/// @param record Logged instruction.
+/// @return String representing register state when the instruction executed.
+std::string RegistersString(Logging::InstructionRecord const& record)
+{
+    std::stringstream regStream;
+    uint32_t const cpsr = record.cpsr_;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        regStream << std::format("R{} {:08X}  ", i, record.registers_[i]);
+    }
+
+    regStream << "CPSR: " << ((cpsr & 0x8000'0000) ? "N" : "-") << ((cpsr & 0x4000'0000) ? "Z" : "-")
+              << ((cpsr & 0x2000'0000) ? "C" : "-") << ((cpsr & 0x1000'0000) ? "V" : "-") << "  ";
+    regStream << ((cpsr & 0x80) ? "I" : "-") << ((cpsr & 0x40) ? "F" : "-") << ((cpsr & 0x20) ? "T" : "-") << "  " << "Mode: ";
+    uint32_t spsr = record.spsr_;
+
+    switch (static_cast<CPU::OperatingMode>(cpsr & 0x1F))
+    {
+        case CPU::OperatingMode::User:
+            regStream << "User";
+            break;
+        case CPU::OperatingMode::FIQ:
+            regStream << std::format("FIQ         SPSR: {:08X}", spsr);
+            break;
+        case CPU::OperatingMode::IRQ:
+            regStream << std::format("IRQ         SPSR: {:08X}", spsr);
+            break;
+        case CPU::OperatingMode::Supervisor:
+            regStream << std::format("Supervisor  SPSR: {:08X}", spsr);
+            break;
+        case CPU::OperatingMode::Abort:
+            regStream << std::format("Abort       SPSR: {:08X}", spsr);
+            break;
+        case CPU::OperatingMode::System:
+            regStream << "System";
+            break;
+        case CPU::OperatingMode::Undefined:
+            regStream << std::format("Undefined   SPSR: {:08X}", spsr);
+            break;
+    }
+
+    return regStream.str();
+}
 }
 
 namespace Logging
 {
-LogManager::LogManager() :
+LogManager::LogManager(EventScheduler const& scheduler) :
+    messagesLogged_(0),
+    instructionHead_(0),
+    instructionCount_(0),
+    streamingRequested_(false),
     loggingInitialized_(false),
+    logDirectoryPrepared_(false),
     systemLoggingEnabled_(false),
-    cpuLoggingEnabled_(false)
+    cpuLoggingEnabled_(false),
+    scheduler_(scheduler)
 {
 }
 
+LogManager::~LogManager() = default;
+
 void LogManager::Initialize()
 {
     logPath_ = LOG_PATH;
 
-    if (!logPath_.empty() && !loggingInitialized_)
+    if (LOGGING_ENABLED && !logPath_.empty() && !loggingInitialized_)
     {
-        if (!fs::exists(logPath_))
-        {
-            fs::create_directory(logPath_);
-        }
-
+        tracePath_ = logPath_ / "trace.gbatrace";
         logPath_ /= "log.log";
+        loggingInitialized_ = true;
+    }
+}
 
-        if (fs::exists(logPath_))
-        {
-            fs::remove(logPath_);
-        }
+void LogManager::PrepareLogDirectory()
+{
+    if (logDirectoryPrepared_)
+    {
+        return;
+    }
 
-        loggingInitialized_ = true;
+    fs::path logDirectory = logPath_.parent_path();
+
+    if (!fs::exists(logDirectory))
+    {
+        fs::create_directory(logDirectory);
+    }
+
+    if (fs::exists(logPath_))
+    {
+        fs::remove(logPath_);
+    }
+
+    logDirectoryPrepared_ = true;
+}
+
+void LogManager::ToggleSystemLogging()
+{
+    systemLoggingEnabled_ = !systemLoggingEnabled_;
+
+    if (LOGGING_ENABLED && systemLoggingEnabled_ && !buffer_)
+    {
+        buffer_ = std::make_unique<CircularBuffer<std::string, LOG_BUFFER_SIZE>>();
+    }
+}
+
+void LogManager::ToggleCpuLogging()
+{
+    cpuLoggingEnabled_ = !cpuLoggingEnabled_;
+
+    if (LOGGING_ENABLED && cpuLoggingEnabled_ && instructionBuffer_.empty())
+    {
+        instructionBuffer_.resize(LOG_BUFFER_SIZE);
     }
 }
 
-void LogManager::LogInstruction(uint32_t pc, std::string mnemonic, std::string registers)
+void LogManager::LogInstruction(uint32_t pc, uint32_t opcode, std::array<uint32_t, 16> const& registers, uint32_t cpsr, uint32_t spsr)
 {
-    LogMessage(std::format("{:08X}:  {:<40}  {}", pc, mnemonic, registers));
+    if (!LOGGING_ENABLED || !loggingInitialized_)
+    {
+        return;
+    }
+
+    if (streamingRequested_.load(std::memory_order_relaxed) != (traceWriter_ != nullptr))
+    {
+        UpdateStreaming();
+    }
+
+    InstructionRecord* record;
+
+    if (traceWriter_)
+    {
+        record = &traceWriter_->NextRecord();
+    }
+    else
+    {
+        record = &instructionBuffer_[instructionHead_];
+
+        if (++instructionHead_ == LOG_BUFFER_SIZE)
+        {
+            instructionHead_ = 0;
+        }
+
+        if (instructionCount_ < LOG_BUFFER_SIZE)
+        {
+            ++instructionCount_;
+        }
+    }
+
+    record->cycle_ = scheduler_.TotalCycles();
+    record->messageIndex_ = messagesLogged_;
+    record->pc_ = pc;
+    record->opcode_ = opcode;
+    record->registers_ = registers;
+    record->cpsr_ = cpsr;
+    record->spsr_ = spsr;
 }
 
 void LogManager::LogIRQ()
@@ -171,28 +303,103 @@ void LogManager::LogTimerOverflow(int index)
 
 void LogManager::DumpLogs()
 {
-    if (loggingInitialized_)
+    if (LOGGING_ENABLED && loggingInitialized_)
     {
+        UpdateStreaming();
+
+        if (traceWriter_)
+        {
+            traceWriter_->Flush();
+        }
+
+        size_t bufferedMessages = buffer_ ? buffer_->Size() : 0;
+
+        if ((bufferedMessages == 0) && (instructionCount_ == 0))
+        {
+            return;
+        }
+
+        PrepareLogDirectory();
         std::ofstream logFile;
         logFile.open(logPath_);
 
-        while (!buffer_.Empty())
+        // Messages still in the buffer are the most recent ones logged, so the index of the oldest can be recovered from the count
+        uint64_t messageIndex = messagesLogged_ - bufferedMessages;
+        size_t recordIndex = (instructionHead_ + LOG_BUFFER_SIZE - instructionCount_) % LOG_BUFFER_SIZE;
+
+        for (; instructionCount_ > 0; --instructionCount_)
         {
-            logFile << buffer_.Pop();
+            InstructionRecord const& record = instructionBuffer_[recordIndex];
+
+            while (buffer_ && !buffer_->Empty() && (messageIndex < record.messageIndex_))
+            {
+                logFile << buffer_->Pop();
+                ++messageIndex;
+            }
+
+            logFile << InstructionString(record);
+            recordIndex = (recordIndex + 1) % LOG_BUFFER_SIZE;
+        }
+
+        while (buffer_ && !buffer_->Empty())
+        {
+            logFile << buffer_->Pop();
         }
     }
 }
 
 void LogManager::LogMessage(std::string message)
 {
-    if (loggingInitialized_)
+    if (LOGGING_ENABLED && loggingInitialized_)
     {
-        if (buffer_.Full())
+        if (streamingRequested_.load(std::memory_order_relaxed) != (traceWriter_ != nullptr))
+        {
+            UpdateStreaming();
+        }
+
+        std::string entry = std::format("{}  -  ", scheduler_.TotalCycles()) + message + "\n";
+        ++messagesLogged_;
+
+        if (traceWriter_)
         {
-            buffer_.Pop();
+            traceWriter_->AddMessage(std::move(entry));
+            return;
         }
 
-        buffer_.Push(std::format("{}  -  ", Scheduler.TotalCycles()) + message + "\n");
+        if (!buffer_)
+        {
+            buffer_ = std::make_unique<CircularBuffer<std::string, LOG_BUFFER_SIZE>>();
+        }
+
+        if (buffer_->Full())
+        {
+            buffer_->Pop();
+        }
+
+        buffer_->Push(std::move(entry));
+    }
+}
+
+void LogManager::UpdateStreaming()
+{
+    bool streaming = streamingRequested_.load();
+
+    if (!streaming)
+    {
+        traceWriter_.reset();
+    }
+    else if (!traceWriter_)
+    {
+        try
+        {
+            PrepareLogDirectory();
+            traceWriter_ = std::make_unique<TraceWriter>(tracePath_);
+        }
+        catch (std::exception const& error)
+        {
+            streamingRequested_.store(false);
+            LogMessage(error.what());
+        }
     }
 }
 
@@ -235,5 +442,18 @@ std::string ConditionMnemonic(uint8_t condition)
     }
 }
 
-LogManager LogMgr;
+std::string InstructionString(InstructionRecord const& record)
+{
+    std::string mnemonic;
+
+    // The disassembler isn't built when logging is compiled out
+    if constexpr (LOGGING_ENABLED)
+    {
+        bool thumb = record.cpsr_ & 0x20;
+        mnemonic = thumb ? CPU::THUMB::Disassemble(static_cast<uint16_t>(record.opcode_), record.registers_) :
+                           CPU::ARM::Disassemble(record.opcode_, record.registers_);
+    }
+
+    return std::format("{}  -  {:08X}:  {:<40}  {}\n", record.cycle_, record.pc_, mnemonic, RegistersString(record));
+}
 }
@@ -1,4 +1,6 @@
 #include <CPU/ThumbInstructions.hpp>
+#include <array>
+#include <cstdint>
 #include <format>
 #include <sstream>
 #include <string>
@@ -35,13 +37,17 @@ void SoftwareInterrupt::SetMnemonic(std::string& mnemonic)
     mnemonic = std::format("{:04X} -> SWI #{:02X}", instruction_.halfword, comment);
 }
 
-void UnconditionalBranch::SetMnemonic(std::string& mnemonic, uint32_t newPC)
+void UnconditionalBranch::SetMnemonic(std::string& mnemonic, std::array<uint32_t, 16> const& registers)
 {
+    int16_t signedOffset = SignExtend16(instruction_.Offset11 << 1, 11);
+    uint32_t newPC = registers[PC_INDEX] + signedOffset;
     mnemonic = std::format("{:04X} -> B #{:08X}", instruction_.halfword, newPC);
 }
 
-void ConditionalBranch::SetMnemonic(std::string& mnemonic, uint32_t newPC)
+void ConditionalBranch::SetMnemonic(std::string& mnemonic, std::array<uint32_t, 16> const& registers)
 {
+    int16_t signedOffset = SignExtend16(instruction_.SOffset8 << 1, 8);
+    uint32_t newPC = registers[PC_INDEX] + signedOffset;
     std::string condition = Logging::ConditionMnemonic(instruction_.Cond);
     mnemonic = std::format("{:04X} -> B{} 0x{:08X}", instruction_.halfword, condition, newPC);
 }
@@ -87,7 +93,7 @@ void MultipleLoadStore::SetMnemonic(std::string& mnemonic)
     mnemonic = std::format("{:04X} -> {} R{}!, {}", instruction_.halfword, op, rb, regStream.str());
 }
 
-void LongBranchWithLink::SetMnemonic(std::string& mnemonic, uint32_t newPC)
+void LongBranchWithLink::SetMnemonic(std::string& mnemonic, std::array<uint32_t, 16> const& registers)
 {
     if (!instruction_.H)
     {
@@ -97,12 +103,14 @@ void LongBranchWithLink::SetMnemonic(std::string& mnemonic, uint32_t newPC)
     else
     {
         // Instruction 2
+        uint32_t newPC = registers[LR_INDEX] + (instruction_.Offset << 1);
         mnemonic = std::format("{:04X} -> BL 0x{:08X}", instruction_.halfword, newPC);
     }
 }
 
-void AddOffsetToStackPointer::SetMnemonic(std::string& mnemonic, uint16_t offset)
+void AddOffsetToStackPointer::SetMnemonic(std::string& mnemonic)
 {
+    uint16_t offset = instruction_.SWord7 << 2;
     std::string imm = std::format("#{}{}", instruction_.S ? "-" : "", offset);
     mnemonic = std::format("{:04X} -> ADD SP, {}", instruction_.halfword, imm);
 }
@@ -182,8 +190,10 @@ void SPRelativeLoadStore::SetMnemonic(std::string& mnemonic)
     mnemonic = std::format("{:04X} -> {} R{}, [SP, #{}]",instruction_.halfword, op, rd, imm);
 }
 
-void LoadAddress::SetMnemonic(std::string& mnemonic, uint8_t destIndex, uint16_t offset)
+void LoadAddress::SetMnemonic(std::string& mnemonic)
 {
+    uint8_t destIndex = instruction_.Rd;
+    uint16_t offset = instruction_.Word8 << 2;
     std::string reg = instruction_.SP ? "SP" : "PC";
     mnemonic = std::format("{:04X} -> ADD R{}, {}, #{}", instruction_.halfword, destIndex, reg, offset);
 }
@@ -243,8 +253,10 @@ void LoadStoreSignExtendedByteHalfword::SetMnemonic(std::string& mnemonic)
     mnemonic = std::format("{:04X} -> {} {}", instruction_.halfword, op, regString);
 }
 
-void HiRegisterOperationsBranchExchange::SetMnemonic(std::string& mnemonic, uint8_t destIndex, uint8_t srcIndex)
+void HiRegisterOperationsBranchExchange::SetMnemonic(std::string& mnemonic)
 {
+    uint8_t destIndex = instruction_.RdHd + (instruction_.H1 ? 8 : 0);
+    uint8_t srcIndex = instruction_.RsHs + (instruction_.H2 ? 8 : 0);
     std::string op;
     std::string regString = std::format("R{}, R{}", destIndex, srcIndex);
 
@@ -417,4 +429,92 @@ void MoveShiftedRegister::SetMnemonic(std::string& mnemonic)
 
     mnemonic = std::format("{:04X} -> {} R{}, R{}, #{}", instruction_.halfword, op, destIndex, srcIndex, offset);
 }
-}
\ No newline at end of file
+
+std::string Disassemble(uint16_t undecodedInstruction, std::array<uint32_t, 16> const& registers)
+{
+    std::string mnemonic;
+
+    if (SoftwareInterrupt::IsInstanceOf(undecodedInstruction))
+    {
+        SoftwareInterrupt(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else if (UnconditionalBranch::IsInstanceOf(undecodedInstruction))
+    {
+        UnconditionalBranch(undecodedInstruction).SetMnemonic(mnemonic, registers);
+    }
+    else if (ConditionalBranch::IsInstanceOf(undecodedInstruction))
+    {
+        ConditionalBranch(undecodedInstruction).SetMnemonic(mnemonic, registers);
+    }
+    else if (MultipleLoadStore::IsInstanceOf(undecodedInstruction))
+    {
+        MultipleLoadStore(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else if (LongBranchWithLink::IsInstanceOf(undecodedInstruction))
+    {
+        LongBranchWithLink(undecodedInstruction).SetMnemonic(mnemonic, registers);
+    }
+    else if (AddOffsetToStackPointer::IsInstanceOf(undecodedInstruction))
+    {
+        AddOffsetToStackPointer(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else if (PushPopRegisters::IsInstanceOf(undecodedInstruction))
+    {
+        PushPopRegisters(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else if (LoadStoreHalfword::IsInstanceOf(undecodedInstruction))
+    {
+        LoadStoreHalfword(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else if (SPRelativeLoadStore::IsInstanceOf(undecodedInstruction))
+    {
+        SPRelativeLoadStore(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else if (LoadAddress::IsInstanceOf(undecodedInstruction))
+    {
+        LoadAddress(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else if (LoadStoreWithImmediateOffset::IsInstanceOf(undecodedInstruction))
+    {
+        LoadStoreWithImmediateOffset(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else if (LoadStoreWithRegisterOffset::IsInstanceOf(undecodedInstruction))
+    {
+        LoadStoreWithRegisterOffset(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else if (LoadStoreSignExtendedByteHalfword::IsInstanceOf(undecodedInstruction))
+    {
+        LoadStoreSignExtendedByteHalfword(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else if (PCRelativeLoad::IsInstanceOf(undecodedInstruction))
+    {
+        PCRelativeLoad(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else if (HiRegisterOperationsBranchExchange::IsInstanceOf(undecodedInstruction))
+    {
+        HiRegisterOperationsBranchExchange(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else if (ALUOperations::IsInstanceOf(undecodedInstruction))
+    {
+        ALUOperations(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else if (MoveCompareAddSubtractImmediate::IsInstanceOf(undecodedInstruction))
+    {
+        MoveCompareAddSubtractImmediate(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else if (AddSubtract::IsInstanceOf(undecodedInstruction))
+    {
+        AddSubtract(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else if (MoveShiftedRegister::IsInstanceOf(undecodedInstruction))
+    {
+        MoveShiftedRegister(undecodedInstruction).SetMnemonic(mnemonic);
+    }
+    else
+    {
+        mnemonic = std::format("{:04X} -> UNKNOWN", undecodedInstruction);
+    }
+
+    return mnemonic;
+}
+}
@@ -0,0 +1,350 @@
+#include <Logging/TraceStream.hpp>
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <Logging/Logging.hpp>
+
+namespace
+{
+constexpr std::array<char, 8> TRACE_MAGIC = {'G', 'B', 'A', 'T', 'R', 'A', 'C', 'E'};
+constexpr uint8_t INSTRUCTION_TAG = 0;
+constexpr uint8_t MESSAGE_TAG = 1;
+
+// Bits of the changed register mask beyond R0-R15
+constexpr uint32_t CPSR_CHANGED = 0x0001'0000;
+constexpr uint32_t SPSR_CHANGED = 0x0002'0000;
+
+/// @brief Append an unsigned LEB128 value to a buffer.
+/// @param buffer Buffer to append to.
+/// @param value Value to encode.
+void PutVarint(std::vector<char>& buffer, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        buffer.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+
+    buffer.push_back(static_cast<char>(value));
+}
+
+/// @brief Append a 32 bit little endian value to a buffer.
+/// @param buffer Buffer to append to.
+/// @param value Value to encode.
+void PutWord(std::vector<char>& buffer, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        buffer.push_back(static_cast<char>(value & 0xFF));
+        value >>= 8;
+    }
+}
+
+/// @brief Read an unsigned LEB128 value from a trace file.
+/// @param traceFile File to read from.
+/// @return Decoded value.
+/// @throws std::runtime_error if the file ends mid value.
+uint64_t GetVarint(std::ifstream& traceFile)
+{
+    uint64_t value = 0;
+
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        int byte = traceFile.get();
+
+        if (byte == std::char_traits<char>::eof())
+        {
+            throw std::runtime_error("Trace file ended unexpectedly");
+        }
+
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+        if (!(byte & 0x80))
+        {
+            return value;
+        }
+    }
+
+    throw std::runtime_error("Malformed value in trace file");
+}
+
+/// @brief Read a 32 bit little endian value from a trace file.
+/// @param traceFile File to read from.
+/// @return Decoded value.
+/// @throws std::runtime_error if the file ends mid value.
+uint32_t GetWord(std::ifstream& traceFile)
+{
+    std::array<unsigned char, 4> bytes;
+
+    if (!traceFile.read(reinterpret_cast<char*>(bytes.data()), bytes.size()))
+    {
+        throw std::runtime_error("Trace file ended unexpectedly");
+    }
+
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+}
+
+namespace Logging
+{
+TraceWriter::TraceWriter(fs::path tracePath) :
+    activeChunk_(0),
+    traceFile_(tracePath, std::ios::binary | std::ios::trunc),
+    previousRecord_(),
+    chunkPending_(false),
+    pendingChunk_(0),
+    stop_(false)
+{
+    if (traceFile_.fail())
+    {
+        throw std::runtime_error("Unable to create trace file " + tracePath.string());
+    }
+
+    traceFile_.write(TRACE_MAGIC.data(), TRACE_MAGIC.size());
+
+    for (Chunk& chunk : chunks_)
+    {
+        chunk.records_.reserve(TRACE_CHUNK_SIZE);
+    }
+
+    // Worst case is a tag, three 10 byte varints, a 3 byte mask, and 18 words per record
+    output_.reserve(TRACE_CHUNK_SIZE * 106);
+    writerThread_ = std::thread(&TraceWriter::WriterLoop, this);
+}
+
+TraceWriter::~TraceWriter()
+{
+    SubmitActiveChunk();
+
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        stop_ = true;
+    }
+
+    chunkSubmitted_.notify_one();
+    writerThread_.join();
+}
+
+InstructionRecord& TraceWriter::NextRecord()
+{
+    if (chunks_[activeChunk_].records_.size() == TRACE_CHUNK_SIZE)
+    {
+        SubmitActiveChunk();
+    }
+
+    return chunks_[activeChunk_].records_.emplace_back();
+}
+
+void TraceWriter::AddMessage(std::string message)
+{
+    Chunk& chunk = chunks_[activeChunk_];
+    chunk.messages_.emplace_back(chunk.records_.size(), std::move(message));
+}
+
+void TraceWriter::Flush()
+{
+    SubmitActiveChunk();
+    std::unique_lock<std::mutex> lock(lock_);
+    chunkWritten_.wait(lock, [this]() { return !chunkPending_; });
+}
+
+void TraceWriter::SubmitActiveChunk()
+{
+    Chunk const& chunk = chunks_[activeChunk_];
+
+    if (chunk.records_.empty() && chunk.messages_.empty())
+    {
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        chunkWritten_.wait(lock, [this]() { return !chunkPending_; });
+        chunkPending_ = true;
+        pendingChunk_ = activeChunk_;
+    }
+
+    chunkSubmitted_.notify_one();
+    activeChunk_ ^= 1;
+}
+
+void TraceWriter::WriterLoop()
+{
+    std::unique_lock<std::mutex> lock(lock_);
+
+    while (true)
+    {
+        chunkSubmitted_.wait(lock, [this]() { return chunkPending_ || stop_; });
+
+        if (chunkPending_)
+        {
+            Chunk& chunk = chunks_[pendingChunk_];
+            lock.unlock();
+
+            auto message = chunk.messages_.begin();
+
+            for (size_t i = 0; i < chunk.records_.size(); ++i)
+            {
+                for (; (message != chunk.messages_.end()) && (message->first == i); ++message)
+                {
+                    EncodeMessage(message->second);
+                }
+
+                EncodeRecord(chunk.records_[i]);
+            }
+
+            for (; message != chunk.messages_.end(); ++message)
+            {
+                EncodeMessage(message->second);
+            }
+
+            traceFile_.write(output_.data(), output_.size());
+            traceFile_.flush();
+            output_.clear();
+            chunk.records_.clear();
+            chunk.messages_.clear();
+
+            lock.lock();
+            chunkPending_ = false;
+            chunkWritten_.notify_one();
+        }
+        else if (stop_)
+        {
+            return;
+        }
+    }
+}
+
+void TraceWriter::EncodeRecord(InstructionRecord const& record)
+{
+    uint32_t changed = 0;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        changed |= (record.registers_[i] != previousRecord_.registers_[i]) ? (0x01 << i) : 0;
+    }
+
+    changed |= (record.cpsr_ != previousRecord_.cpsr_) ? CPSR_CHANGED : 0;
+    changed |= (record.spsr_ != previousRecord_.spsr_) ? SPSR_CHANGED : 0;
+
+    // PC usually moves a short distance, so store it as a zigzag encoded signed delta
+    int32_t pcDelta = static_cast<int32_t>(record.pc_ - previousRecord_.pc_);
+    uint32_t zigzagPcDelta = (static_cast<uint32_t>(pcDelta) << 1) ^ static_cast<uint32_t>(pcDelta >> 31);
+
+    output_.push_back(static_cast<char>(INSTRUCTION_TAG));
+    PutVarint(output_, record.cycle_ - previousRecord_.cycle_);
+    PutVarint(output_, zigzagPcDelta);
+    PutVarint(output_, record.opcode_);
+    PutVarint(output_, changed);
+
+    for (int i = 0; i < 16; ++i)
+    {
+        if (changed & (0x01 << i))
+        {
+            PutWord(output_, record.registers_[i]);
+        }
+    }
+
+    if (changed & CPSR_CHANGED)
+    {
+        PutWord(output_, record.cpsr_);
+    }
+
+    if (changed & SPSR_CHANGED)
+    {
+        PutWord(output_, record.spsr_);
+    }
+
+    previousRecord_ = record;
+}
+
+void TraceWriter::EncodeMessage(std::string const& message)
+{
+    output_.push_back(static_cast<char>(MESSAGE_TAG));
+    PutVarint(output_, message.size());
+    output_.insert(output_.end(), message.begin(), message.end());
+}
+
+void DecodeTrace(fs::path tracePath, fs::path logPath)
+{
+    std::ifstream traceFile(tracePath, std::ios::binary);
+
+    if (traceFile.fail())
+    {
+        throw std::runtime_error("Unable to open trace file " + tracePath.string());
+    }
+
+    std::array<char, TRACE_MAGIC.size()> magic;
+
+    if (!traceFile.read(magic.data(), magic.size()) || (magic != TRACE_MAGIC))
+    {
+        throw std::runtime_error(tracePath.string() + " is not a trace file");
+    }
+
+    std::ofstream logFile(logPath, std::ios::trunc);
+
+    if (logFile.fail())
+    {
+        throw std::runtime_error("Unable to create log file " + logPath.string());
+    }
+
+    InstructionRecord record = {};
+    int tag;
+
+    while ((tag = traceFile.get()) != std::char_traits<char>::eof())
+    {
+        if (tag == MESSAGE_TAG)
+        {
+            std::string message(GetVarint(traceFile), '\0');
+
+            if (!traceFile.read(message.data(), message.size()))
+            {
+                throw std::runtime_error("Trace file ended unexpectedly");
+            }
+
+            logFile << message;
+        }
+        else if (tag == INSTRUCTION_TAG)
+        {
+            record.cycle_ += GetVarint(traceFile);
+            uint32_t zigzagPcDelta = GetVarint(traceFile);
+            record.pc_ += (zigzagPcDelta >> 1) ^ (~(zigzagPcDelta & 0x01) + 1);
+            record.opcode_ = GetVarint(traceFile);
+            uint32_t changed = GetVarint(traceFile);
+
+            for (int i = 0; i < 16; ++i)
+            {
+                if (changed & (0x01 << i))
+                {
+                    record.registers_[i] = GetWord(traceFile);
+                }
+            }
+
+            if (changed & CPSR_CHANGED)
+            {
+                record.cpsr_ = GetWord(traceFile);
+            }
+
+            if (changed & SPSR_CHANGED)
+            {
+                record.spsr_ = GetWord(traceFile);
+            }
+
+            logFile << InstructionString(record);
+        }
+        else
+        {
+            throw std::runtime_error("Malformed entry in trace file");
+        }
+    }
+}
+}
@@ -0,0 +1,194 @@
+#include <Profiling/Profiler.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <AdvancedBoy.hpp>
+#include <Config.hpp>
+#include <System/EventScheduler.hpp>
+
+namespace
+{
+constexpr std::array<char const*, Profiling::REGION_COUNT> REGION_NAMES = {
+    "BIOS", "UNUSED", "EWRAM", "IWRAM", "IO", "PRAM", "VRAM", "OAM",
+    "ROM_WS0", "ROM_WS0", "ROM_WS1", "ROM_WS1", "ROM_WS2", "ROM_WS2", "SRAM", "SRAM"
+};
+
+/// @brief Get the name of an event type.
+/// @param eventType Event type.
+/// @return Name of event type.
+char const* EventName(EventType eventType)
+{
+    switch (eventType)
+    {
+        case EventType::Timer0Overflow:
+            return "Timer0Overflow";
+        case EventType::Timer1Overflow:
+            return "Timer1Overflow";
+        case EventType::Timer2Overflow:
+            return "Timer2Overflow";
+        case EventType::Timer3Overflow:
+            return "Timer3Overflow";
+        case EventType::HBlank:
+            return "HBlank";
+        case EventType::VBlank:
+            return "VBlank";
+        case EventType::VDraw:
+            return "VDraw";
+        case EventType::SampleAPU:
+            return "SampleAPU";
+        case EventType::COUNT:
+        default:
+            break;
+    }
+
+    return "Unknown";
+}
+}
+
+namespace Profiling
+{
+Profiler::Profiler(EventScheduler& scheduler) :
+    scheduler_(scheduler)
+{
+    Reset();
+}
+
+void Profiler::Reset()
+{
+    pcRanges_.clear();
+    lastRangeKey_ = 0;
+    lastRange_ = nullptr;
+    accesses_.fill(0);
+    accessCycles_.fill(0);
+    cpuCycles_ = 0;
+    dmaCycles_ = 0;
+    haltCycles_ = 0;
+    idleLoopCycles_ = 0;
+    eventCountsAtReset_ = scheduler_.EventCounts();
+    scheduler_.ResetEventLateness();
+}
+
+void Profiler::RecordInstruction(uint32_t pc, uint64_t cycles)
+{
+    uint32_t key = pc >> PC_RANGE_SHIFT;
+
+    if ((lastRange_ == nullptr) || (key != lastRangeKey_))
+    {
+        lastRangeKey_ = key;
+        lastRange_ = &pcRanges_[key];
+    }
+
+    ++lastRange_->instructions_;
+    lastRange_->cycles_ += cycles;
+}
+
+ProfileReport Profiler::Report() const
+{
+    ProfileReport report = {};
+    report.available_ = PROFILER_ENABLED;
+
+    if (!report.available_)
+    {
+        return report;
+    }
+
+    report.cpuCycles_ = cpuCycles_;
+    report.dmaCycles_ = dmaCycles_;
+    report.haltCycles_ = haltCycles_;
+    report.idleLoopCycles_ = idleLoopCycles_;
+    report.totalCycles_ = cpuCycles_ + dmaCycles_ + haltCycles_ + idleLoopCycles_;
+
+    for (size_t i = 0; i < REGION_COUNT; ++i)
+    {
+        report.regions_.push_back({REGION_NAMES[i], 0, 0, accesses_[i], accessCycles_[i]});
+    }
+
+    report.pcRanges_.reserve(pcRanges_.size());
+
+    for (auto const& [key, stats] : pcRanges_)
+    {
+        uint32_t startAddr = key << PC_RANGE_SHIFT;
+        report.pcRanges_.push_back({startAddr, startAddr + (1 << PC_RANGE_SHIFT) - 1, stats.instructions_, stats.cycles_});
+
+        RegionProfile& region = report.regions_[(startAddr < 0x1000'0000) ? (startAddr >> 24) : 1];
+        region.instructions_ += stats.instructions_;
+        region.executionCycles_ += stats.cycles_;
+    }
+
+    std::sort(report.pcRanges_.begin(), report.pcRanges_.end(), [](PcRangeProfile const& a, PcRangeProfile const& b)
+    {
+        return (a.cycles_ != b.cycles_) ? (a.cycles_ > b.cycles_) : (a.startAddr_ < b.startAddr_);
+    });
+
+    auto const& eventCounts = scheduler_.EventCounts();
+    auto const& eventLateness = scheduler_.EventLatenessStats();
+
+    for (size_t i = 0; i < eventCounts.size(); ++i)
+    {
+        EventLateness const& lateness = eventLateness[i];
+        report.events_.push_back({EventName(static_cast<EventType>(i)),
+                                  eventCounts[i] - eventCountsAtReset_[i],
+                                  lateness.total_,
+                                  lateness.max_,
+                                  {lateness.histogram_.begin(), lateness.histogram_.end()}});
+    }
+
+    return report;
+}
+
+void Profiler::WriteFlameGraph(fs::path path) const
+{
+    if (!PROFILER_ENABLED)
+    {
+        throw std::runtime_error("GbaLib was built without the profiler");
+    }
+
+    std::ofstream flameGraph(path, std::ios::trunc);
+
+    if (flameGraph.fail())
+    {
+        throw std::runtime_error("Unable to create profile " + path.string());
+    }
+
+    ProfileReport report = Report();
+    uint64_t attributedCycles = 0;
+    flameGraph << std::hex << std::uppercase << std::setfill('0');
+
+    for (PcRangeProfile const& range : report.pcRanges_)
+    {
+        uint32_t region = (range.startAddr_ < 0x1000'0000) ? (range.startAddr_ >> 24) : 1;
+        flameGraph << "cpu;" << REGION_NAMES[region] << ";0x" << std::setw(8) << range.startAddr_ << "-0x" << std::setw(8)
+                   << range.endAddr_ << ' ' << std::dec << range.cycles_ << std::hex << '\n';
+        attributedCycles += range.cycles_;
+    }
+
+    flameGraph << std::dec;
+
+    // Refilling the pipeline after a branch or IRQ isn't part of any one instruction
+    if (report.cpuCycles_ > attributedCycles)
+    {
+        flameGraph << "cpu;pipeline " << (report.cpuCycles_ - attributedCycles) << '\n';
+    }
+
+    std::array<std::pair<char const*, uint64_t>, 3> otherCycles = {{
+        {"dma", report.dmaCycles_},
+        {"halt", report.haltCycles_},
+        {"idle_loop", report.idleLoopCycles_}
+    }};
+
+    for (auto [name, cycles] : otherCycles)
+    {
+        if (cycles > 0)
+        {
+            flameGraph << name << ' ' << cycles << '\n';
+        }
+    }
+}
+}
@@ -0,0 +1,653 @@
+#include <System/AvCapture.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include <AdvancedBoy.hpp>
+#include <CPU/CpuTypes.hpp>
+#include <Graphics/FrameBuffer.hpp>
+#include <PixelFormat.hpp>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <signal.h>
+#endif
+
+namespace
+{
+constexpr std::array<char, 8> CAPTURE_MAGIC = {'G', 'B', 'A', 'V', 'I', 'D', 'E', 'O'};
+
+// 228 scanlines of 1232 cycles each
+constexpr int CYCLES_PER_FRAME = 280'896;
+
+// Gaps in the frame sequence longer than this come from loading a state rather than skipped or dropped frames, so they aren't
+// filled in
+constexpr uint64_t MAX_REPEATED_FRAMES = 60;
+
+// Changed bytes separated by fewer unchanged bytes than this are stored as one run, so that scattered changes within a scanline
+// don't each cost a pair of run lengths
+constexpr size_t MIN_UNCHANGED_RUN = 8;
+
+constexpr uint32_t WAV_HEADER_SIZE = 44;
+constexpr std::array<float, 1024> SILENCE = {};
+
+/// @brief Append an unsigned LEB128 value to a buffer.
+/// @param buffer Buffer to append to.
+/// @param value Value to encode.
+void PutVarint(std::vector<char>& buffer, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        buffer.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+
+    buffer.push_back(static_cast<char>(value));
+}
+
+/// @brief Append a little endian value to a buffer.
+/// @param buffer Buffer to append to.
+/// @param value Value to encode.
+/// @param size Number of bytes to encode.
+void PutLittleEndian(std::vector<char>& buffer, uint32_t value, int size)
+{
+    for (int i = 0; i < size; ++i)
+    {
+        buffer.push_back(static_cast<char>(value & 0xFF));
+        value >>= 8;
+    }
+}
+
+/// @brief Read an unsigned LEB128 value from a capture.
+/// @param capture File to read from.
+/// @return Decoded value.
+/// @throws std::runtime_error if the file ends mid value.
+uint64_t GetVarint(std::ifstream& capture)
+{
+    uint64_t value = 0;
+
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        int byte = capture.get();
+
+        if (byte == std::char_traits<char>::eof())
+        {
+            throw std::runtime_error("Capture ended unexpectedly");
+        }
+
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+        if (!(byte & 0x80))
+        {
+            return value;
+        }
+    }
+
+    throw std::runtime_error("Malformed value in capture");
+}
+
+/// @brief Get the size of a frame.
+/// @param format Pixel format of frame.
+/// @return Number of bytes in a frame.
+size_t FrameSize(PixelFormat format)
+{
+    return Graphics::LCD_WIDTH * Graphics::LCD_HEIGHT * BytesPerPixel(format);
+}
+
+/// @brief Get the name ffmpeg uses for a pixel format.
+/// @param format Pixel format.
+/// @return Name of pixel format.
+char const* FFmpegPixelFormat(PixelFormat format)
+{
+    switch (format)
+    {
+        case PixelFormat::BGR555:
+            return "bgr555le";
+        case PixelFormat::RGB565:
+            return "rgb565le";
+        case PixelFormat::XRGB8888:
+            return "bgr0";
+        case PixelFormat::RGBA8888:
+            return "rgba";
+    }
+
+    return "rgba";
+}
+
+/// @brief Start a process that reads binary data from a pipe.
+/// @param command Command line to run.
+/// @return Pipe to the process's standard input, or nullptr if it couldn't be started.
+std::FILE* OpenPipe(std::string const& command)
+{
+#ifdef _WIN32
+    return _popen(command.c_str(), "wb");
+#else
+    return popen(command.c_str(), "w");
+#endif
+}
+
+/// @brief Close a pipe and wait for the process on the other end to exit.
+/// @param pipe Pipe returned by OpenPipe.
+/// @return Exit status of the process. 0 means success.
+int ClosePipe(std::FILE* pipe)
+{
+#ifdef _WIN32
+    return _pclose(pipe);
+#else
+    return pclose(pipe);
+#endif
+}
+}
+
+AvCapture::AvCapture(fs::path path, CaptureFormat format, std::string const& ffmpegOptions, PixelFormat pixelFormat, int sampleRate) :
+    path_(path),
+    audioPath_(path),
+    logPath_(path),
+    ffmpegVideoPath_(path),
+    format_(format),
+    pixelFormat_(pixelFormat),
+    sampleRate_(sampleRate),
+    frameSize_(FrameSize(pixelFormat)),
+    framePool_(FRAME_POOL_SIZE * frameSize_),
+    pendingSilence_(0),
+    work_(0),
+    stop_(false),
+    framesWritten_(0),
+    framesDropped_(0),
+    samplesWritten_(0),
+    samplesDropped_(0),
+    stopped_(false),
+    ffmpegPipe_(nullptr),
+    previousFrame_(frameSize_, 0),
+    previousSequence_(0),
+    loggedFramesDropped_(0),
+    loggedSamplesDropped_(0),
+    audioBytes_(0)
+{
+    audioPath_ += ".wav";
+    logPath_ += ".log";
+    ffmpegVideoPath_ += ".video.mkv";
+
+    // Don't leave a log from an earlier capture to the same path lying around
+    std::error_code error;
+    fs::remove(logPath_, error);
+
+    for (uint32_t slot = 0; slot < FRAME_POOL_SIZE; ++slot)
+    {
+        freeSlots_.Write(&slot, 1);
+    }
+
+    audioFile_.open(audioPath_, std::ios::binary | std::ios::trunc);
+
+    if (audioFile_.fail())
+    {
+        throw std::runtime_error("Unable to create audio capture " + audioPath_.string());
+    }
+
+    // 32 bit float stereo. Sizes are filled in once the capture stops.
+    output_.insert(output_.end(), {'R', 'I', 'F', 'F'});
+    PutLittleEndian(output_, 0, 4);
+    output_.insert(output_.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+    PutLittleEndian(output_, 16, 4);
+    PutLittleEndian(output_, 3, 2);
+    PutLittleEndian(output_, 2, 2);
+    PutLittleEndian(output_, sampleRate_, 4);
+    PutLittleEndian(output_, sampleRate_ * 2 * sizeof(float), 4);
+    PutLittleEndian(output_, 2 * sizeof(float), 2);
+    PutLittleEndian(output_, 32, 2);
+    output_.insert(output_.end(), {'d', 'a', 't', 'a'});
+    PutLittleEndian(output_, 0, 4);
+    audioFile_.write(output_.data(), output_.size());
+    output_.clear();
+
+    if (format_ == CaptureFormat::FFmpeg)
+    {
+        std::string command = std::format(
+            "ffmpeg -hide_banner -loglevel error -y -f rawvideo -pixel_format {} -video_size {}x{} -framerate {}/{} -i - {} \"{}\"",
+            FFmpegPixelFormat(pixelFormat_), Graphics::LCD_WIDTH, Graphics::LCD_HEIGHT, CPU::CPU_FREQUENCY_HZ, CYCLES_PER_FRAME,
+            ffmpegOptions, ffmpegVideoPath_.string());
+
+        ffmpegPipe_ = OpenPipe(command);
+
+        if (ffmpegPipe_ == nullptr)
+        {
+            throw std::runtime_error("Unable to start ffmpeg");
+        }
+    }
+    else
+    {
+        videoFile_.open(path_, std::ios::binary | std::ios::trunc);
+
+        if (videoFile_.fail())
+        {
+            throw std::runtime_error("Unable to create video capture " + path_.string());
+        }
+
+        if (format_ == CaptureFormat::Lossless)
+        {
+            videoFile_.write(CAPTURE_MAGIC.data(), CAPTURE_MAGIC.size());
+            PutLittleEndian(output_, static_cast<uint32_t>(pixelFormat_), 4);
+            videoFile_.write(output_.data(), output_.size());
+            output_.clear();
+        }
+    }
+
+    encoderThread_ = std::thread(&AvCapture::EncoderLoop, this);
+}
+
+AvCapture::~AvCapture()
+{
+    try
+    {
+        Stop();
+    }
+    catch (std::exception const&)
+    {
+    }
+}
+
+void AvCapture::PushFrame(uint8_t const* pixels, uint64_t sequence)
+{
+    uint32_t slot;
+
+    if (!freeSlots_.Read(&slot, 1))
+    {
+        framesDropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    std::memcpy(&framePool_[slot * frameSize_], pixels, frameSize_);
+    QueuedFrame frame = {sequence, slot};
+    queuedFrames_.Write(&frame, 1);
+    WakeEncoder();
+}
+
+void AvCapture::PushAudio(float const* samples, size_t cnt)
+{
+    if (cnt == 0)
+    {
+        return;
+    }
+
+    while (pendingSilence_ > 0)
+    {
+        size_t silenceCnt = std::min(pendingSilence_, SILENCE.size());
+
+        if (!queuedAudio_.Write(SILENCE.data(), silenceCnt))
+        {
+            break;
+        }
+
+        pendingSilence_ -= silenceCnt;
+    }
+
+    if ((pendingSilence_ > 0) || !queuedAudio_.Write(samples, cnt))
+    {
+        pendingSilence_ += cnt;
+        samplesDropped_.fetch_add(cnt, std::memory_order_relaxed);
+    }
+
+    WakeEncoder();
+}
+
+CaptureStats AvCapture::Stats() const
+{
+    return {framesWritten_.load(std::memory_order_relaxed),
+            framesDropped_.load(std::memory_order_relaxed),
+            samplesWritten_.load(std::memory_order_relaxed),
+            samplesDropped_.load(std::memory_order_relaxed)};
+}
+
+CaptureStats AvCapture::Stop()
+{
+    if (!stopped_)
+    {
+        stopped_ = true;
+        stop_.store(true, std::memory_order_release);
+        WakeEncoder();
+        encoderThread_.join();
+    }
+
+    if (!error_.empty())
+    {
+        throw std::runtime_error(error_);
+    }
+
+    return Stats();
+}
+
+void AvCapture::EncoderLoop()
+{
+#ifndef _WIN32
+    // Writing to ffmpeg after it exited should fail with an error instead of killing the process
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+#endif
+
+    while (true)
+    {
+        // Anything queued before the stop was requested is encoded by this pass
+        uint32_t work = work_.load(std::memory_order_acquire);
+        bool stopping = stop_.load(std::memory_order_acquire);
+        EncodeQueued();
+
+        if (stopping)
+        {
+            break;
+        }
+
+        work_.wait(work, std::memory_order_acquire);
+    }
+
+    LogDrops(previousSequence_);
+    FinishWav();
+
+    if (format_ == CaptureFormat::FFmpeg)
+    {
+        FinishFFmpeg();
+    }
+    else
+    {
+        videoFile_.close();
+
+        if (videoFile_.fail())
+        {
+            Fail("Unable to finish writing video capture " + path_.string());
+        }
+    }
+}
+
+void AvCapture::EncodeQueued()
+{
+    size_t sampleCnt;
+
+    while ((sampleCnt = queuedAudio_.ReadUpTo(audioBlock_.data(), audioBlock_.size())) > 0)
+    {
+        WriteAudio(audioBlock_.data(), sampleCnt);
+    }
+
+    QueuedFrame frame;
+
+    while (queuedFrames_.Read(&frame, 1))
+    {
+        EncodeFrame(&framePool_[frame.slot_ * frameSize_], frame.sequence_);
+        freeSlots_.Write(&frame.slot_, 1);
+    }
+}
+
+void AvCapture::EncodeFrame(uint8_t const* pixels, uint64_t sequence)
+{
+    if ((previousSequence_ != 0) && (sequence > previousSequence_))
+    {
+        uint64_t missingFrames = sequence - previousSequence_ - 1;
+
+        if (missingFrames <= MAX_REPEATED_FRAMES)
+        {
+            for (uint64_t i = 0; i < missingFrames; ++i)
+            {
+                WriteFrame(previousFrame_.data());
+            }
+        }
+    }
+
+    WriteFrame(pixels);
+    previousSequence_ = sequence;
+    LogDrops(sequence);
+}
+
+void AvCapture::WriteFrame(uint8_t const* pixels)
+{
+    if (!error_.empty())
+    {
+        return;
+    }
+
+    if (format_ == CaptureFormat::FFmpeg)
+    {
+        if (std::fwrite(pixels, 1, frameSize_, ffmpegPipe_) != frameSize_)
+        {
+            Fail("ffmpeg stopped accepting frames");
+            return;
+        }
+    }
+    else if (format_ == CaptureFormat::Raw)
+    {
+        videoFile_.write(reinterpret_cast<char const*>(pixels), frameSize_);
+    }
+    else
+    {
+        // Alternating runs of unchanged and changed bytes, each run length followed by the bytes of the changed run
+        size_t i = 0;
+
+        while (i < frameSize_)
+        {
+            size_t unchangedStart = i;
+
+            while ((i < frameSize_) && (pixels[i] == previousFrame_[i]))
+            {
+                ++i;
+            }
+
+            size_t changedStart = i;
+            size_t matching = 0;
+
+            while ((i < frameSize_) && (matching < MIN_UNCHANGED_RUN))
+            {
+                matching = (pixels[i] == previousFrame_[i]) ? (matching + 1) : 0;
+                ++i;
+            }
+
+            i -= matching;
+            PutVarint(output_, changedStart - unchangedStart);
+            PutVarint(output_, i - changedStart);
+            output_.insert(output_.end(), pixels + changedStart, pixels + i);
+        }
+
+        videoFile_.write(output_.data(), output_.size());
+        output_.clear();
+    }
+
+    if (videoFile_.fail())
+    {
+        Fail("Unable to write video capture " + path_.string());
+        return;
+    }
+
+    if (pixels != previousFrame_.data())
+    {
+        std::memcpy(previousFrame_.data(), pixels, frameSize_);
+    }
+
+    framesWritten_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AvCapture::WriteAudio(float const* samples, size_t cnt)
+{
+    if (!error_.empty())
+    {
+        return;
+    }
+
+    audioFile_.write(reinterpret_cast<char const*>(samples), cnt * sizeof(float));
+
+    if (audioFile_.fail())
+    {
+        Fail("Unable to write audio capture " + audioPath_.string());
+        return;
+    }
+
+    audioBytes_ += cnt * sizeof(float);
+    samplesWritten_.fetch_add(cnt, std::memory_order_relaxed);
+}
+
+void AvCapture::LogDrops(uint64_t sequence)
+{
+    uint64_t framesDropped = framesDropped_.load(std::memory_order_relaxed);
+    uint64_t samplesDropped = samplesDropped_.load(std::memory_order_relaxed);
+
+    if (framesDropped != loggedFramesDropped_)
+    {
+        Log(std::format("Frame {}: encoder fell behind, dropped {} frames", sequence, framesDropped - loggedFramesDropped_));
+        loggedFramesDropped_ = framesDropped;
+    }
+
+    if (samplesDropped != loggedSamplesDropped_)
+    {
+        Log(std::format("Frame {}: encoder fell behind, replaced {} audio samples with silence",
+                        sequence,
+                        samplesDropped - loggedSamplesDropped_));
+        loggedSamplesDropped_ = samplesDropped;
+    }
+}
+
+void AvCapture::Log(std::string const& message)
+{
+    if (!logFile_.is_open())
+    {
+        logFile_.open(logPath_, std::ios::trunc);
+    }
+
+    logFile_ << message << '\n';
+    logFile_.flush();
+}
+
+void AvCapture::Fail(std::string const& message)
+{
+    if (error_.empty())
+    {
+        error_ = message;
+        Log(message);
+    }
+}
+
+void AvCapture::FinishWav()
+{
+    // Sizes are capped at what a WAV header can hold. Players read past them until the end of the file.
+    uint32_t dataSize = static_cast<uint32_t>(std::min<uint64_t>(audioBytes_, UINT32_MAX - WAV_HEADER_SIZE));
+    PutLittleEndian(output_, dataSize + WAV_HEADER_SIZE - 8, 4);
+    audioFile_.seekp(4);
+    audioFile_.write(output_.data(), 4);
+    audioFile_.seekp(WAV_HEADER_SIZE - 4);
+    PutLittleEndian(output_, dataSize, 4);
+    audioFile_.write(output_.data() + 4, 4);
+    output_.clear();
+    audioFile_.close();
+
+    if (audioFile_.fail())
+    {
+        Fail("Unable to finish writing audio capture " + audioPath_.string());
+    }
+}
+
+void AvCapture::FinishFFmpeg()
+{
+    if (ClosePipe(ffmpegPipe_) != 0)
+    {
+        Fail("ffmpeg failed to encode " + ffmpegVideoPath_.string());
+    }
+
+    ffmpegPipe_ = nullptr;
+
+    if (!error_.empty())
+    {
+        return;
+    }
+
+    std::string command = std::format("ffmpeg -hide_banner -loglevel error -y -i \"{}\" -i \"{}\" -map 0:v -map 1:a -c:v copy \"{}\"",
+                                      ffmpegVideoPath_.string(),
+                                      audioPath_.string(),
+                                      path_.string());
+
+    if (std::system(command.c_str()) != 0)
+    {
+        Fail(std::format("ffmpeg failed to mux {} and {} into {}", ffmpegVideoPath_.string(), audioPath_.string(), path_.string()));
+        return;
+    }
+
+    std::error_code error;
+    fs::remove(ffmpegVideoPath_, error);
+    fs::remove(audioPath_, error);
+}
+
+void DecodeLosslessCapture(fs::path capturePath, fs::path rawPath)
+{
+    std::ifstream capture(capturePath, std::ios::binary);
+
+    if (capture.fail())
+    {
+        throw std::runtime_error("Unable to open capture " + capturePath.string());
+    }
+
+    std::array<char, CAPTURE_MAGIC.size()> magic;
+    std::array<unsigned char, 4> formatBytes;
+
+    if (!capture.read(magic.data(), magic.size()) || (magic != CAPTURE_MAGIC) ||
+        !capture.read(reinterpret_cast<char*>(formatBytes.data()), formatBytes.size()))
+    {
+        throw std::runtime_error(capturePath.string() + " is not a lossless capture");
+    }
+
+    uint32_t format = formatBytes[0] | (formatBytes[1] << 8) | (formatBytes[2] << 16) | (static_cast<uint32_t>(formatBytes[3]) << 24);
+
+    if (format > static_cast<uint32_t>(PixelFormat::RGBA8888))
+    {
+        throw std::runtime_error("Unknown pixel format in capture");
+    }
+
+    std::ofstream raw(rawPath, std::ios::binary | std::ios::trunc);
+
+    if (raw.fail())
+    {
+        throw std::runtime_error("Unable to create raw video " + rawPath.string());
+    }
+
+    size_t frameSize = FrameSize(static_cast<PixelFormat>(format));
+    std::vector<char> frame(frameSize, 0);
+
+    while (capture.peek() != std::char_traits<char>::eof())
+    {
+        size_t i = 0;
+
+        while (i < frameSize)
+        {
+            uint64_t unchanged = GetVarint(capture);
+            uint64_t changed = GetVarint(capture);
+
+            if ((unchanged > (frameSize - i)) || (changed > (frameSize - i - unchanged)))
+            {
+                throw std::runtime_error("Malformed frame in capture");
+            }
+
+            i += unchanged;
+
+            if (!capture.read(frame.data() + i, changed))
+            {
+                throw std::runtime_error("Capture ended unexpectedly");
+            }
+
+            i += changed;
+        }
+
+        raw.write(frame.data(), frame.size());
+    }
+
+    if (raw.fail())
+    {
+        throw std::runtime_error("Unable to write raw video " + rawPath.string());
+    }
+}
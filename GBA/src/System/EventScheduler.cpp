@@ -1,76 +1,83 @@
 #include <System/EventScheduler.hpp>
 #include <algorithm>
+#include <bit>
+#include <chrono>
 #include <cstdint>
-#include <format>
 #include <functional>
 #include <optional>
 #include <stdexcept>
-#include <unordered_map>
 #include <utility>
-
-// Global Scheduler instance
-EventScheduler Scheduler;
-
-// Event struct defintions
-
-bool Event::operator>(Event const& rhs) const
-{
-    if (eventType_ == rhs.eventType_)
-    {
-        return false;
-    }
-
-    if (cycleToExecute_ == rhs.cycleToExecute_)
-    {
-        return eventType_ > rhs.eventType_;
-    }
-
-    return cycleToExecute_ > rhs.cycleToExecute_;
-}
-
-// EventScheduler definitions
+#include <Config.hpp>
+#include <Utilities/MemoryUtilities.hpp>
+#include <Utilities/StateSerializer.hpp>
 
 EventScheduler::EventScheduler()
 {
-    queue_.reserve(static_cast<size_t>(EventType::COUNT) + 1);
+    Reset();
+    eventCounts_.fill(0);
+    eventHostTime_.fill(0);
+    totalEventHostTime_ = 0;
+    ResetEventLateness();
 }
 
 void EventScheduler::Reset()
 {
     totalCycles_ = 0;
     irqPending_ = false;
-    queue_.clear();
-}
-
-void EventScheduler::Step(uint64_t cycles)
-{
-    totalCycles_ += cycles;
-    CheckEventQueue();
+    scheduledEvents_ = 0;
+    UpdateNextEvent();
 }
 
 void EventScheduler::CheckEventQueue()
 {
-    Event nextEvent = queue_.front();
+    if (totalCycles_ < nextEventCycle_)
+    {
+        return;
+    }
 
-    while (totalCycles_ >= nextEvent.cycleToExecute_)
+    // Each callback is timed from the end of the previous one, so only one clock read is needed per event
+    std::chrono::steady_clock::time_point startTime;
+
+    if constexpr (COMPONENT_TELEMETRY_ENABLED)
     {
-        std::pop_heap(queue_.begin(), queue_.end(), std::greater<>{});
-        queue_.pop_back();
-        auto& callback = registeredEvents_[nextEvent.eventType_];
-        callback(totalCycles_ - nextEvent.cycleToExecute_);
-        nextEvent = queue_.front();
+        startTime = std::chrono::steady_clock::now();
+    }
+
+    while (totalCycles_ >= nextEventCycle_)
+    {
+        EventType eventType = nextEvent_;
+        uint64_t cycleToExecute = nextEventCycle_;
+        scheduledEvents_ &= ~EventBit(eventType);
+        UpdateNextEvent();
+        registeredEvents_[static_cast<size_t>(eventType)](totalCycles_ - cycleToExecute);
+
+        if constexpr (PROFILER_ENABLED)
+        {
+            RecordLateness(eventType, totalCycles_ - cycleToExecute);
+        }
+
+        ++eventCounts_[static_cast<size_t>(eventType)];
+
+        if constexpr (COMPONENT_TELEMETRY_ENABLED)
+        {
+            auto endTime = std::chrono::steady_clock::now();
+            uint64_t hostTime = std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+            startTime = endTime;
+            eventHostTime_[static_cast<size_t>(eventType)] += hostTime;
+            totalEventHostTime_ += hostTime;
+        }
     }
 }
 
 void EventScheduler::SkipToNextEvent()
 {
-    totalCycles_ = queue_.front().cycleToExecute_;
+    totalCycles_ = nextEventCycle_;
     CheckEventQueue();
 }
 
 void EventScheduler::RegisterEvent(EventType eventType, std::function<void(int)> callback)
 {
-    registeredEvents_.insert({eventType, callback});
+    registeredEvents_[static_cast<size_t>(eventType)] = callback;
 }
 
 void EventScheduler::ScheduleEvent(EventType eventType, int cycles)
@@ -81,75 +88,110 @@ void EventScheduler::ScheduleEvent(EventType eventType, int cycles)
     }
 
     uint64_t cycleToExecute = cycles + totalCycles_;
-    queue_.push_back({eventType, totalCycles_, cycleToExecute});
-    std::make_heap(queue_.begin(), queue_.end(), std::greater<>{});
+    bool wasNextEvent = ((scheduledEvents_ & EventBit(eventType)) != 0) && (nextEvent_ == eventType);
+    events_[static_cast<size_t>(eventType)] = {totalCycles_, cycleToExecute};
+    scheduledEvents_ |= EventBit(eventType);
+
+    if (wasNextEvent)
+    {
+        UpdateNextEvent();
+    }
+    else if ((cycleToExecute < nextEventCycle_) || ((cycleToExecute == nextEventCycle_) && (eventType < nextEvent_)))
+    {
+        nextEvent_ = eventType;
+        nextEventCycle_ = cycleToExecute;
+    }
 }
 
 void EventScheduler::UnscheduleEvent(EventType eventType)
 {
-    auto it = queue_.begin();
-
-    while (it != queue_.end())
+    if ((scheduledEvents_ & EventBit(eventType)) == 0)
     {
-        if (it->eventType_ == eventType)
-        {
-            queue_.erase(it);
-            std::make_heap(queue_.begin(), queue_.end(), std::greater<>{});
-            break;
-        }
+        return;
+    }
+
+    scheduledEvents_ &= ~EventBit(eventType);
 
-        ++it;
+    if (nextEvent_ == eventType)
+    {
+        UpdateNextEvent();
     }
 }
 
 std::optional<int> EventScheduler::ElapsedCycles(EventType eventType) const
 {
-    for (Event const& event : queue_)
+    if (!EventScheduled(eventType))
     {
-        if (event.eventType_ == eventType)
-        {
-            return totalCycles_ - event.cycleQueued_;
-        }
+        return {};
     }
 
-    return {};
+    return totalCycles_ - events_[static_cast<size_t>(eventType)].cycleQueued_;
 }
 
 std::optional<int> EventScheduler::CyclesRemaining(EventType eventType) const
 {
-    for (Event const& event : queue_)
+    if (!EventScheduled(eventType))
     {
-        if (event.eventType_ == eventType)
-        {
-            return event.cycleToExecute_ - totalCycles_;
-        }
+        return {};
     }
 
-    return {};
+    return events_[static_cast<size_t>(eventType)].cycleToExecute_ - totalCycles_;
 }
 
 std::optional<int> EventScheduler::EventLength(EventType eventType) const
 {
-    for (Event const& event : queue_)
+    if (!EventScheduled(eventType))
     {
-        if (event.eventType_ == eventType)
-        {
-            return event.cycleToExecute_ - event.cycleQueued_;
-        }
+        return {};
     }
 
-    return {};
+    Event const& event = events_[static_cast<size_t>(eventType)];
+    return event.cycleToExecute_ - event.cycleQueued_;
 }
 
 bool EventScheduler::EventScheduled(EventType eventType) const
 {
-    for (Event const& event : queue_)
+    return (scheduledEvents_ & EventBit(eventType)) != 0;
+}
+
+void EventScheduler::Serialize(StateSerializer& state)
+{
+    // Callbacks are registered by each component's constructor and never change, so only the timing is saved.
+    state.Value(events_);
+    state.Value(scheduledEvents_);
+    state.Value(totalCycles_);
+    state.Value(irqPending_);
+
+    if (state.Loading())
     {
-        if (event.eventType_ == eventType)
+        UpdateNextEvent();
+    }
+}
+
+void EventScheduler::RecordLateness(EventType eventType, uint64_t lateCycles)
+{
+    EventLateness& lateness = eventLateness_[static_cast<size_t>(eventType)];
+    lateness.total_ += lateCycles;
+    lateness.max_ = std::max(lateness.max_, lateCycles);
+    ++lateness.histogram_[std::min<size_t>(std::bit_width(lateCycles), LATENESS_BUCKETS - 1)];
+}
+
+void EventScheduler::UpdateNextEvent()
+{
+    nextEvent_ = EventType::COUNT;
+    nextEventCycle_ = MAX_U64;
+    uint32_t remainingEvents = scheduledEvents_;
+
+    // Events are checked in priority order, so ties go to the lower event type.
+    while (remainingEvents != 0)
+    {
+        size_t index = std::countr_zero(remainingEvents);
+        remainingEvents &= (remainingEvents - 1);
+
+        if (events_[index].cycleToExecute_ < nextEventCycle_)
         {
-            return true;
+            nextEvent_ = static_cast<EventType>(index);
+            nextEventCycle_ = events_[index].cycleToExecute_;
         }
     }
-
-    return false;
 }
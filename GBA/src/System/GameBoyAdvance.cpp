@@ -1,15 +1,21 @@
 #include <System/GameBoyAdvance.hpp>
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <cstring>
 #include <exception>
 #include <filesystem>
 #include <format>
 #include <fstream>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <tuple>
 #include <utility>
+#include <vector>
 #include <Audio/APU.hpp>
 #include <Cartridge/GamePak.hpp>
 #include <Config.hpp>
@@ -18,270 +24,1368 @@
 #include <Gamepad/GamepadManager.hpp>
 #include <Graphics/PPU.hpp>
 #include <Logging/Logging.hpp>
+#include <System/AvCapture.hpp>
 #include <System/MemoryMap.hpp>
 #include <System/EventScheduler.hpp>
+#include <System/HookRegistry.hpp>
+#include <System/InputMovie.hpp>
+#include <System/PageTable.hpp>
 #include <System/SystemControl.hpp>
+#include <System/TelemetryRecorder.hpp>
 #include <Timers/TimerManager.hpp>
-#include <Utilities/Functor.hpp>
 #include <Utilities/MemoryUtilities.hpp>
+#include <Utilities/RewindBuffer.hpp>
+#include <Utilities/StateSerializer.hpp>
 
 namespace fs = std::filesystem;
 
+namespace
+{
+constexpr uint32_t SAVE_STATE_MAGIC = 0x5453'4241;  // "ABST"
+
+// Increment whenever the fields saved by any component change
+constexpr uint32_t SAVE_STATE_VERSION = 2;
+
+constexpr int MAX_RUN_AHEAD_FRAMES = 4;
+
+struct SaveStateHeader
+{
+    uint32_t magic_;
+    uint32_t version_;
+    uint64_t size_;
+    uint32_t romSize_;
+    uint32_t romHeaderCrc_;
+};
+}
+
 GameBoyAdvance::GameBoyAdvance(fs::path biosPath) :
-    biosLoaded_(LoadBIOS(BIOS_PATH)),
-    cpu_(CPU::MemReadCallback(&ReadMemory, *this), CPU::MemWriteCallback(&WriteMemory, *this)),
-    dmaMgr_(*this),
-    gamePak_(nullptr)
+    GameBoyAdvance(LoadBIOS(BIOS_PATH))
+{
+    (void)biosPath;
+}
+
+GameBoyAdvance::GameBoyAdvance(std::shared_ptr<BiosImage const> bios) :
+    biosLoaded_(bios != nullptr),
+    scheduler_(),
+    log_(scheduler_),
+    systemControl_(scheduler_, log_),
+    profiler_(scheduler_),
+    telemetry_(scheduler_),
+    capture_(nullptr),
+    apu_(scheduler_),
+    cpu_(*this, scheduler_, log_),
+    dmaMgr_(*this, scheduler_, systemControl_, log_),
+    gamepad_(systemControl_),
+    ppu_(scheduler_, systemControl_),
+    timerMgr_(scheduler_, systemControl_, log_),
+    gamePak_(nullptr),
+    BIOS_(biosLoaded_ ? std::move(bios) : std::make_shared<BiosImage const>()),
+    rewindBuffer_(nullptr),
+    framesPerRewindCapture_(0),
+    framesUntilRewindCapture_(0),
+    rewindCapturePending_(false),
+    runAheadFrames_(0),
+    runAheadPending_(false),
+    runningAhead_(false),
+    framesCompleted_(0),
+    movie_(),
+    hooks_(),
+    hookStop_(false)
+{
+    log_.Initialize();
+
+    // State
+    gamePakLoaded_ = false;
+    directBoot_ = false;
+
+    scheduler_.RegisterEvent(EventType::HBlank, std::bind(&HBlank, this, std::placeholders::_1));
+    scheduler_.RegisterEvent(EventType::VBlank, std::bind(&VBlank, this, std::placeholders::_1));
+    scheduler_.RegisterEvent(EventType::Timer0Overflow, std::bind(&Timer0Overflow, this, std::placeholders::_1));
+    scheduler_.RegisterEvent(EventType::Timer1Overflow, std::bind(&Timer1Overflow, this, std::placeholders::_1));
+
+    BuildPageTable();
+    BuildIoTable();
+    UpdateMemoryUsage();
+}
+
+GameBoyAdvance::~GameBoyAdvance()
+{
+    log_.DumpLogs();
+}
+
+std::unique_ptr<GameBoyAdvance> GameBoyAdvance::Clone()
+{
+    std::unique_ptr<GameBoyAdvance> clone(new GameBoyAdvance(biosLoaded_ ? BIOS_ : nullptr));
+    clone->directBoot_ = directBoot_;
+    clone->cpu_.SetBiosHle(cpu_.BiosHle());
+
+    if (gamePakLoaded_)
+    {
+        clone->gamePak_ = std::make_unique<Cartridge::GamePak>(*gamePak_, clone->scheduler_, clone->systemControl_);
+        clone->gamePakLoaded_ = true;
+        clone->MapGamePakPages();
+    }
+
+    SaveState(cloneState_);
+    clone->LoadState(cloneState_.data(), cloneState_.size());
+    clone->apu_.CopyResampling(apu_);
+    clone->UpdateMemoryUsage();
+    UpdateMemoryUsage();
+    return clone;
+}
+
+void GameBoyAdvance::UpdateMemoryUsage()
+{
+    uint64_t instanceBytes = sizeof(GameBoyAdvance) + cpu_.BlockCacheMemory() + rewindCapture_.capacity() +
+                             runAheadState_.capacity() + cloneState_.capacity();
+    uint64_t sharedBytes = BIOS_->size();
+
+    if (rewindBuffer_ != nullptr)
+    {
+        instanceBytes += rewindBuffer_->MemoryUsage();
+    }
+
+    if (gamePakLoaded_)
+    {
+        instanceBytes += sizeof(Cartridge::GamePak) + gamePak_->BackupSize();
+        sharedBytes += gamePak_->RomSize();
+    }
+
+    telemetry_.SetMemoryUsage(instanceBytes, sharedBytes);
+}
+
+void GameBoyAdvance::Reset()
+{
+    // Scheduler
+    scheduler_.Reset();
+
+    // Components
+    apu_.Reset();
+    cpu_.Reset();
+    dmaMgr_.Reset();
+    gamepad_.Reset();
+    ppu_.Reset();
+    timerMgr_.Reset();
+    systemControl_.Reset();
+    UpdateWramTiming();
+
+    if (gamePakLoaded_)
+    {
+        gamePak_->Reset();
+    }
+
+    // Memory
+    onBoardWRAM_.fill(0);
+    onChipWRAM_.fill(0);
+    placeholderIoRegisters_.fill(0);
+
+    // Open bus
+    lastBiosFetch_ = 0;
+    lastReadValue_ = 0;
+    runAheadPending_ = false;
+
+    // Scheduler
+    scheduler_.ScheduleEvent(EventType::HBlank, 960);
+
+    if (directBoot_ && gamePakLoaded_)
+    {
+        SkipBIOS();
+    }
+}
+
+void GameBoyAdvance::SkipBIOS()
+{
+    // Registers the BIOS sets up during its intro and leaves set when it jumps to the GamePak. The intro ends with the PPU and
+    // timers in no particular state, so the scheduler is left as it is after a reset, starting from the first scanline.
+    cpu_.SkipBIOS();
+    WriteMemory<AccessSize::HALFWORD>(0x0400'0020, 0x0100);  // BG2PA
+    WriteMemory<AccessSize::HALFWORD>(0x0400'0026, 0x0100);  // BG2PD
+    WriteMemory<AccessSize::HALFWORD>(0x0400'0030, 0x0100);  // BG3PA
+    WriteMemory<AccessSize::HALFWORD>(0x0400'0036, 0x0100);  // BG3PD
+    WriteMemory<AccessSize::HALFWORD>(0x0400'0088, 0x0200);  // SOUNDBIAS
+    WriteMemory<AccessSize::BYTE>(0x0400'0300, 0x01);  // POSTFLG
+
+    // Last opcode the BIOS fetched before jumping to the GamePak, which BIOS reads return until a SWI or IRQ runs BIOS code
+    lastBiosFetch_ = 0xE129'F000;
+}
+
+void GameBoyAdvance::FillAudioBuffer()
+{
+    if (!biosLoaded_ && !gamePakLoaded_)
+    {
+        return;
+    }
+
+    size_t samplesToGenerate = apu_.FreeBufferSpace();
+    hookStop_ = false;
+    PollHostInput();
+
+    while ((samplesToGenerate > 0) && !hookStop_)
+    {
+        Run(samplesToGenerate);
+
+        auto flushStartTime = TelemetryRecorder::Clock::now();
+        apu_.FlushSamples();
+        telemetry_.AddApuTime(TelemetryRecorder::Clock::now() - flushStartTime);
+
+        samplesToGenerate = apu_.FreeBufferSpace();
+    }
+}
+
+void GameBoyAdvance::RunFrames(int frames, std::vector<float>* audio)
+{
+    if ((!biosLoaded_ && !gamePakLoaded_) || (frames <= 0))
+    {
+        return;
+    }
+
+    apu_.SetOutputMode((audio != nullptr) ? Audio::OutputMode::Record : Audio::OutputMode::Discard, audio);
+    RunFramesWithOutput(frames);
+}
+
+size_t GameBoyAdvance::RunFrames(int frames, float* audio, size_t capacity)
+{
+    if ((!biosLoaded_ && !gamePakLoaded_) || (frames <= 0))
+    {
+        return 0;
+    }
+
+    if (audio != nullptr)
+    {
+        apu_.SetOutputMode(Audio::OutputMode::Capture, audio, capacity);
+    }
+    else
+    {
+        apu_.SetOutputMode(Audio::OutputMode::Discard);
+    }
+
+    RunFramesWithOutput(frames);
+    return (audio != nullptr) ? apu_.CapturedSize() : 0;
+}
+
+void GameBoyAdvance::RunFramesWithOutput(int frames)
+{
+    uint64_t targetFrame = framesCompleted_ + frames;
+    hookStop_ = false;
+    PollHostInput();
+
+    while ((framesCompleted_ < targetFrame) && !hookStop_)
+    {
+        RunUntilNextEvent();
+    }
+
+    // Flush the rest of the recording and go back to buffering for FillAudioBuffer
+    apu_.SetOutputMode(Audio::OutputMode::Buffer);
+    ppu_.FinishRendering();
+}
+
+void GameBoyAdvance::Run(size_t samples)
+{
+    apu_.ClearSampleCounter();
+
+    while ((apu_.GetSampleCounter() < samples) && !hookStop_)
+    {
+        RunUntilNextEvent();
+    }
+}
+
+void GameBoyAdvance::RunUntilNextEvent()
+{
+    if (runAheadPending_)
+    {
+        RunAhead();
+    }
+
+    if (rewindCapturePending_)
+    {
+        CaptureRewindState();
+    }
+
+    uint64_t startCycle = scheduler_.TotalCycles();
+
+    if (dmaMgr_.DmaActive())
+    {
+        if constexpr (COMPONENT_TELEMETRY_ENABLED)
+        {
+            uint64_t startEventTime = scheduler_.TotalEventHostTime();
+            auto dmaStartTime = TelemetryRecorder::Clock::now();
+            dmaMgr_.RunUntilNextEvent();
+            telemetry_.AddDmaTime(TelemetryRecorder::Clock::now() - dmaStartTime,
+                                  scheduler_.TotalEventHostTime() - startEventTime);
+        }
+        else
+        {
+            dmaMgr_.RunUntilNextEvent();
+        }
+
+        if constexpr (PROFILER_ENABLED)
+        {
+            profiler_.AddDmaCycles(scheduler_.TotalCycles() - startCycle);
+        }
+
+        scheduler_.CheckEventQueue();
+    }
+    else if (systemControl_.Halted())
+    {
+        scheduler_.SkipToNextEvent();
+
+        if constexpr (PROFILER_ENABLED)
+        {
+            profiler_.AddHaltCycles(scheduler_.TotalCycles() - startCycle);
+        }
+    }
+    else
+    {
+        if constexpr (COMPONENT_TELEMETRY_ENABLED)
+        {
+            uint64_t startEventTime = scheduler_.TotalEventHostTime();
+            auto cpuStartTime = TelemetryRecorder::Clock::now();
+            cpu_.RunUntilNextEvent();
+            telemetry_.AddCpuTime(TelemetryRecorder::Clock::now() - cpuStartTime,
+                                  scheduler_.TotalEventHostTime() - startEventTime);
+        }
+        else
+        {
+            cpu_.RunUntilNextEvent();
+        }
+
+        if constexpr (PROFILER_ENABLED)
+        {
+            uint64_t cpuEndCycle = scheduler_.TotalCycles();
+            profiler_.AddCpuCycles(cpuEndCycle - startCycle);
+            startCycle = cpuEndCycle;
+        }
+
+        if (cpu_.IdleLoopDetected())
+        {
+            scheduler_.SkipToNextEvent();
+
+            if constexpr (PROFILER_ENABLED)
+            {
+                profiler_.AddIdleLoopCycles(scheduler_.TotalCycles() - startCycle);
+            }
+        }
+        else
+        {
+            scheduler_.CheckEventQueue();
+        }
+    }
+
+    if ((framesCompleted_ != telemetry_.PublishedFrame()) && !runningAhead_)
+    {
+        telemetry_.FrameCompleted(framesCompleted_, scheduler_.TotalCycles());
+        UpdateMemoryUsage();
+    }
+}
+
+std::pair<uint32_t, int> GameBoyAdvance::ReadUnmappedMemory(uint32_t addr, AccessSize alignment)
+{
+    if (hooks_.HasMemoryWatches())
+    {
+        return ReadWatchedMemory(addr, alignment);
+    }
+
+    return ReadMemoryRegion(addr, alignment);
+}
+
+int GameBoyAdvance::WriteUnmappedMemory(uint32_t addr, uint32_t value, AccessSize alignment)
+{
+    if (hooks_.HasMemoryWatches())
+    {
+        return WriteWatchedMemory(addr, value, alignment);
+    }
+
+    return WriteMemoryRegion(addr, value, alignment);
+}
+
+std::pair<uint32_t, int> GameBoyAdvance::ReadMemoryRegion(uint32_t addr, AccessSize alignment)
+{
+    uint32_t value = 0;
+    int cycles = 1;
+    bool openBus = false;
+    auto page = MemoryPage::INVALID;
+
+    if (addr < 0x1000'0000)
+    {
+        #pragma GCC diagnostic push
+        #pragma GCC diagnostic ignored "-Wnarrowing"
+        page = MemoryPage{(addr & 0x0F00'0000) >> 24};
+        #pragma GCC diagnostic pop
+    }
+
+    switch (page)
+    {
+        case MemoryPage::BIOS:
+            std::tie(value, cycles) = ReadBIOS(addr, alignment);
+            break;
+        case MemoryPage::WRAM_SLOW:
+            std::tie(value, cycles) = ReadOnBoardWRAM(addr, alignment);
+            break;
+        case MemoryPage::WRAM_FAST:
+            std::tie(value, cycles) = ReadOnChipWRAM(addr, alignment);
+            break;
+        case MemoryPage::IO_REG:
+            std::tie(value, cycles) = ReadIoReg(addr, alignment);
+            break;
+        case MemoryPage::PRAM:
+            std::tie(value, cycles) = ppu_.ReadPRAM(addr, alignment);
+            break;
+        case MemoryPage::VRAM:
+            std::tie(value, cycles) = ppu_.ReadVRAM(addr, alignment);
+            break;
+        case MemoryPage::OAM:
+            std::tie(value, cycles) = ppu_.ReadOAM(addr, alignment);
+            break;
+        case MemoryPage::GAMEPAK_MIN ... MemoryPage::GAMEPAK_MAX:
+            std::tie(value, cycles, openBus) = gamePak_->ReadGamePak(addr, alignment);
+            break;
+        case MemoryPage::INVALID:
+        default:
+            openBus = true;
+            break;
+    }
+
+    if (openBus)
+    {
+        std::tie(value, cycles) = ReadOpenBus(addr, alignment);
+    }
+
+    lastReadValue_ = value;
+
+    if constexpr (PROFILER_ENABLED)
+    {
+        profiler_.RecordAccess(addr, cycles);
+    }
+
+    return {value, cycles};
+}
+
+int GameBoyAdvance::WriteMemoryRegion(uint32_t addr, uint32_t value, AccessSize alignment)
+{
+    int cycles = 1;
+    auto page = MemoryPage::INVALID;
+
+    if (addr < 0x1000'0000)
+    {
+        #pragma GCC diagnostic push
+        #pragma GCC diagnostic ignored "-Wnarrowing"
+        page = MemoryPage{(addr & 0x0F00'0000) >> 24};
+        #pragma GCC diagnostic pop
+    }
+
+    switch (page)
+    {
+        case MemoryPage::BIOS:
+            break;
+        case MemoryPage::WRAM_SLOW:
+            cycles = WriteOnBoardWRAM(addr, value, alignment);
+            break;
+        case MemoryPage::WRAM_FAST:
+            cycles = WriteOnChipWRAM(addr, value, alignment);
+            break;
+        case MemoryPage::IO_REG:
+            cycles = WriteIoReg(addr, value, alignment);
+            cpu_.ExitBlock();
+            break;
+        case MemoryPage::PRAM:
+            cycles = ppu_.WritePRAM(addr, value, alignment);
+            break;
+        case MemoryPage::VRAM:
+            cycles = ppu_.WriteVRAM(addr, value, alignment);
+            break;
+        case MemoryPage::OAM:
+            cycles = ppu_.WriteOAM(addr, value, alignment);
+            break;
+        case MemoryPage::GAMEPAK_MIN ... MemoryPage::GAMEPAK_MAX:
+            cycles = gamePak_->WriteGamePak(addr, value, alignment);
+            break;
+        case MemoryPage::INVALID:
+        default:
+            break;
+    }
+
+    if constexpr (PROFILER_ENABLED)
+    {
+        profiler_.RecordAccess(addr, cycles);
+    }
+
+    return cycles;
+}
+
+std::pair<uint32_t, int> GameBoyAdvance::ReadWatchedMemory(uint32_t addr, AccessSize alignment)
+{
+    std::pair<uint32_t, int> result;
+    uint32_t canonicalAddr = addr;
+
+    if (addr < 0x1000'0000)
+    {
+        PageTableEntry const& entry = UnwatchedEntry(addr);
+
+        if (entry.type_ != PageType::SLOW)
+        {
+            canonicalAddr = entry.baseAddr_ + (addr & entry.mask_);
+        }
+
+        if (entry.readMemory_ != nullptr)
+        {
+            result = DispatchAccessSize(alignment, [&](auto size) { return ReadMappedMemory<size>(entry, addr); });
+        }
+        else
+        {
+            result = ReadMemoryRegion(addr, alignment);
+        }
+    }
+    else
+    {
+        result = ReadMemoryRegion(addr, alignment);
+    }
+
+    if (hooks_.CheckMemory(canonicalAddr, result.first, alignment, false))
+    {
+        hookStop_ = true;
+        cpu_.ExitBlock();
+    }
+
+    return result;
+}
+
+int GameBoyAdvance::WriteWatchedMemory(uint32_t addr, uint32_t value, AccessSize alignment)
+{
+    int cycles = 0;
+    uint32_t canonicalAddr = addr;
+
+    if (addr < 0x1000'0000)
+    {
+        PageTableEntry const& entry = UnwatchedEntry(addr);
+
+        if (entry.type_ != PageType::SLOW)
+        {
+            canonicalAddr = entry.baseAddr_ + (addr & entry.mask_);
+        }
+
+        if ((entry.writeMemory_ != nullptr) && ((alignment != AccessSize::BYTE) || entry.byteWritable_))
+        {
+            cycles = DispatchAccessSize(alignment, [&](auto size) { return WriteMappedMemory<size>(entry, addr, value); });
+        }
+        else
+        {
+            cycles = WriteMemoryRegion(addr, value, alignment);
+        }
+    }
+    else
+    {
+        cycles = WriteMemoryRegion(addr, value, alignment);
+    }
+
+    if (hooks_.CheckMemory(canonicalAddr, value, alignment, true))
+    {
+        hookStop_ = true;
+        cpu_.ExitBlock();
+    }
+
+    return cycles;
+}
+
+PageTableEntry const& GameBoyAdvance::UnwatchedEntry(uint32_t addr) const
+{
+    auto watchedPage = watchedPages_.find(addr >> PAGE_SHIFT);
+    return (watchedPage != watchedPages_.end()) ? watchedPage->second : pageTable_[addr >> PAGE_SHIFT];
+}
+
+void GameBoyAdvance::CheckPcHooks(uint32_t pc)
+{
+    if (hooks_.CheckPc(pc))
+    {
+        hookStop_ = true;
+        cpu_.ExitBlock();
+    }
+}
+
+HookId GameBoyAdvance::AddMemoryWatch(uint32_t addr, uint32_t length, WatchType type, MemoryHook hook)
+{
+    if (addr < 0x1000'0000)
+    {
+        PageTableEntry const& entry = UnwatchedEntry(addr);
+
+        if (entry.type_ != PageType::SLOW)
+        {
+            addr = entry.baseAddr_ + (addr & entry.mask_);
+        }
+    }
+
+    HookId id = hooks_.AddMemoryWatch(addr, length, type, std::move(hook));
+    RestoreWatchedPages();
+    RemoveWatchedPages();
+    return id;
+}
+
+HookId GameBoyAdvance::AddPcHook(uint32_t pc, PcHook hook)
+{
+    HookId id = hooks_.AddPcHook(pc, std::move(hook));
+
+    // Blocks that were cached before the hook existed would run straight past it
+    cpu_.FlushBlockCache();
+    return id;
+}
+
+bool GameBoyAdvance::RemoveHook(HookId id)
+{
+    bool removed = hooks_.Remove(id);
+    RestoreWatchedPages();
+    RemoveWatchedPages();
+    return removed;
+}
+
+std::pair<uint8_t*, int> GameBoyAdvance::ReadMemoryBlock(uint32_t addr, uint32_t units, AccessSize alignment)
+{
+    addr = AlignAddress(addr, alignment);
+
+    if (addr >= 0x1000'0000)
+    {
+        return {nullptr, 0};
+    }
+
+    PageTableEntry const& entry = pageTable_[addr >> PAGE_SHIFT];
+    uint32_t unitSize = static_cast<uint32_t>(alignment);
+    uint32_t offset = addr & entry.mask_;
+    uint32_t length = units * unitSize;
+
+    if ((entry.readMemory_ == nullptr) || ((entry.mask_ + 1 - offset) < length))
+    {
+        return {nullptr, 0};
+    }
+
+    uint8_t* memory = entry.readMemory_ + offset;
+    lastReadValue_ = ReadPointer(memory + length - unitSize, alignment);
+    int cycles = (entry.type_ == PageType::ROM) ?
+        gamePak_->RomBurstCycles(addr, alignment, units, std::numeric_limits<int>::max(), 0).second :
+        (units * entry.cycles_[alignment == AccessSize::WORD]);
+    return {memory, cycles};
+}
+
+std::pair<bool, int> GameBoyAdvance::WriteMemoryBlock(uint32_t addr, uint8_t const* values, uint32_t units, AccessSize alignment)
+{
+    addr = AlignAddress(addr, alignment);
+
+    if (addr >= 0x1000'0000)
+    {
+        return {false, 0};
+    }
+
+    PageTableEntry const& entry = pageTable_[addr >> PAGE_SHIFT];
+    uint32_t unitSize = static_cast<uint32_t>(alignment);
+    uint32_t offset = addr & entry.mask_;
+    uint32_t length = units * unitSize;
+
+    if ((entry.writeMemory_ == nullptr) || ((entry.mask_ + 1 - offset) < length))
+    {
+        return {false, 0};
+    }
+
+    uint8_t* memory = entry.writeMemory_ + offset;
+
+    if (entry.type_ == PageType::VIDEO)
+    {
+        for (uint32_t i = 0; i < length; i += unitSize)
+        {
+            if (WritePointerAndCompare(memory + i, ReadPointer(values + i, alignment), alignment))
+            {
+                ppu_.VideoMemoryWritten(entry.baseAddr_ + offset + i, alignment);
+            }
+        }
+    }
+    else
+    {
+        std::memcpy(memory, values, length);
+
+        if (entry.type_ == PageType::WRAM)
+        {
+            cpu_.InvalidateBlocks(entry.baseAddr_ + offset, length);
+        }
+    }
+
+    return {true, static_cast<int>(units * entry.cycles_[alignment == AccessSize::WORD])};
+}
+
+std::pair<uint32_t, int> GameBoyAdvance::ReadMemoryBurst(uint32_t addr, uint32_t* values, uint32_t maxCount, int maxCycles)
+{
+    addr = AlignAddress<AccessSize::WORD>(addr);
+
+    if (addr >= 0x1000'0000)
+    {
+        return {0, 0};
+    }
+
+    PageTableEntry const& entry = pageTable_[addr >> PAGE_SHIFT];
+    uint32_t offset = addr & entry.mask_;
+
+    if ((entry.readMemory_ == nullptr) || ((entry.mask_ + 1 - offset) < (maxCount * 4)))
+    {
+        return {0, 0};
+    }
+
+    // Stop at the first word that reaches the cycle limit, so that events fire between the same words they would have
+    uint32_t count = 0;
+    int cycles = 0;
+
+    if (entry.type_ == PageType::ROM)
+    {
+        std::tie(count, cycles) = gamePak_->RomBurstCycles(addr, AccessSize::WORD, maxCount, maxCycles, 0);
+    }
+    else
+    {
+        int cyclesPerWord = entry.cycles_[1];
+        count = static_cast<uint32_t>(std::min<int64_t>(maxCount, (maxCycles + cyclesPerWord - 1) / cyclesPerWord));
+        cycles = count * cyclesPerWord;
+    }
+
+    uint8_t const* memory = entry.readMemory_ + offset;
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        values[i] = ReadPointer<AccessSize::WORD>(memory + (i * 4));
+    }
+
+    if (count != 0)
+    {
+        lastReadValue_ = values[count - 1];
+    }
+
+    if constexpr (PROFILER_ENABLED)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            profiler_.RecordAccess(addr + (i * 4), cycles / count);
+        }
+    }
+
+    return {count, cycles};
+}
+
+std::pair<uint32_t, int> GameBoyAdvance::WriteMemoryBurst(uint32_t addr,
+                                                          uint32_t const* values,
+                                                          uint32_t maxCount,
+                                                          int maxCycles)
+{
+    addr = AlignAddress<AccessSize::WORD>(addr);
+
+    if (addr >= 0x1000'0000)
+    {
+        return {0, 0};
+    }
+
+    PageTableEntry const& entry = pageTable_[addr >> PAGE_SHIFT];
+    uint32_t offset = addr & entry.mask_;
+
+    if ((entry.writeMemory_ == nullptr) || ((entry.mask_ + 1 - offset) < (maxCount * 4)))
+    {
+        return {0, 0};
+    }
+
+    int cyclesPerWord = entry.cycles_[1];
+    auto count = static_cast<uint32_t>(std::min<int64_t>(maxCount, (maxCycles + cyclesPerWord - 1) / cyclesPerWord));
+    uint8_t* memory = entry.writeMemory_ + offset;
+
+    if (entry.type_ == PageType::VIDEO)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (WritePointerAndCompare<AccessSize::WORD>(memory + (i * 4), values[i]))
+            {
+                ppu_.VideoMemoryWritten(entry.baseAddr_ + offset + (i * 4), AccessSize::WORD);
+            }
+        }
+    }
+    else
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            WritePointer<AccessSize::WORD>(memory + (i * 4), values[i]);
+        }
+
+        if ((entry.type_ == PageType::WRAM) && (count != 0))
+        {
+            cpu_.InvalidateBlocks(entry.baseAddr_ + offset, count * 4);
+        }
+    }
+
+    if constexpr (PROFILER_ENABLED)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            profiler_.RecordAccess(addr + (i * 4), cyclesPerWord);
+        }
+    }
+
+    return {count, static_cast<int>(count) * cyclesPerWord};
+}
+
+std::pair<uint32_t, int> GameBoyAdvance::CopyMemory(uint32_t srcAddr,
+                                                    uint32_t destAddr,
+                                                    uint32_t maxUnits,
+                                                    AccessSize alignment,
+                                                    bool fixedSrc,
+                                                    int maxCycles)
+{
+    srcAddr = AlignAddress(srcAddr, alignment);
+    destAddr = AlignAddress(destAddr, alignment);
+
+    if ((srcAddr >= 0x1000'0000) || (destAddr >= 0x1000'0000))
+    {
+        return {0, 0};
+    }
+
+    PageTableEntry const& srcEntry = pageTable_[srcAddr >> PAGE_SHIFT];
+    PageTableEntry const& destEntry = pageTable_[destAddr >> PAGE_SHIFT];
+
+    if ((srcEntry.readMemory_ == nullptr) || (destEntry.writeMemory_ == nullptr))
+    {
+        return {0, 0};
+    }
+
+    // Repeated reads of one ROM address are all non-sequential, which the burst timing doesn't model
+    if (fixedSrc && (srcEntry.type_ == PageType::ROM))
+    {
+        return {0, 0};
+    }
+
+    // Stop at the end of either page or mirror so that each side is one contiguous block of host memory
+    uint32_t unitSize = static_cast<uint32_t>(alignment);
+    uint32_t srcOffset = srcAddr & srcEntry.mask_;
+    uint32_t destOffset = destAddr & destEntry.mask_;
+    uint32_t units = std::min(maxUnits, (destEntry.mask_ + 1 - destOffset) / unitSize);
+
+    if (!fixedSrc)
+    {
+        units = std::min(units, (srcEntry.mask_ + 1 - srcOffset) / unitSize);
+    }
+
+    uint8_t* src = srcEntry.readMemory_ + srcOffset;
+    uint8_t* dest = destEntry.writeMemory_ + destOffset;
+    uint32_t srcLength = fixedSrc ? unitSize : (units * unitSize);
+    uint32_t destLength = units * unitSize;
+
+    // Overlapping transfers depend on the order units are copied in, so leave those to the per-unit path
+    if ((src < (dest + destLength)) && (dest < (src + srcLength)))
+    {
+        return {0, 0};
+    }
+
+    // Stop at the first unit that reaches the cycle limit
+    bool word = alignment == AccessSize::WORD;
+    int writeCyclesPerUnit = destEntry.cycles_[word];
+    int readCycles = 0;
+
+    if (srcEntry.type_ == PageType::ROM)
+    {
+        std::tie(units, readCycles) = gamePak_->RomBurstCycles(srcAddr, alignment, units, maxCycles, writeCyclesPerUnit);
+    }
+    else
+    {
+        int64_t cyclesPerUnit = srcEntry.cycles_[word] + writeCyclesPerUnit;
+        units = static_cast<uint32_t>(std::min<int64_t>(units, (maxCycles + cyclesPerUnit - 1) / cyclesPerUnit));
+        readCycles = units * srcEntry.cycles_[word];
+    }
+
+    destLength = units * unitSize;
+
+    if (destEntry.type_ == PageType::VIDEO)
+    {
+        // The renderer keeps its own copy of video memory, so only units that actually changed need to be sent to it
+        for (uint32_t i = 0; i < units; ++i)
+        {
+            uint32_t offset = i * unitSize;
+            uint32_t value = ReadPointer(fixedSrc ? src : (src + offset), alignment);
+
+            if (WritePointerAndCompare(dest + offset, value, alignment))
+            {
+                ppu_.VideoMemoryWritten(destEntry.baseAddr_ + destOffset + offset, alignment);
+            }
+        }
+    }
+    else if (fixedSrc)
+    {
+        uint32_t value = ReadPointer(src, alignment);
+
+        for (uint32_t i = 0; i < units; ++i)
+        {
+            WritePointer(dest + (i * unitSize), value, alignment);
+        }
+    }
+    else
+    {
+        std::memcpy(dest, src, destLength);
+    }
+
+    if (destEntry.type_ == PageType::WRAM)
+    {
+        cpu_.InvalidateBlocks(destEntry.baseAddr_ + destOffset, destLength);
+    }
+
+    lastReadValue_ = ReadPointer(fixedSrc ? src : (src + destLength - unitSize), alignment);
+    return {units, readCycles + (units * writeCyclesPerUnit)};
+}
+
+size_t GameBoyAdvance::DrainAudioBuffer(float* buffer, size_t cnt)
+{
+    size_t drained = apu_.DrainBuffer(buffer, cnt);
+    telemetry_.AudioDrained(drained < cnt);
+    return drained;
+}
+
+bool GameBoyAdvance::LoadGamePak(fs::path romPath)
+{
+    std::vector<uint8_t> discardedMovie;
+    movie_.Stop(discardedMovie);
+
+    gamePak_.reset();
+    gamePak_ = std::make_unique<Cartridge::GamePak>(romPath, scheduler_, systemControl_);
+    gamePakLoaded_ = gamePak_->RomLoaded();
+    RestoreWatchedPages();
+    MapGamePakPages();
+    RemoveWatchedPages();
+
+    if (rewindBuffer_ != nullptr)
+    {
+        rewindBuffer_->Clear();
+    }
+
+    if (gamePakLoaded_)
+    {
+        Reset();
+    }
+
+    UpdateMemoryUsage();
+    return gamePakLoaded_;
+}
+
+void GameBoyAdvance::UpdateGamepad(Gamepad gamepad)
+{
+    switch (movie_.Mode())
+    {
+        case MovieMode::Idle:
+            gamepad_.PostInput(gamepad);
+            break;
+        case MovieMode::Recording:
+            movie_.SetPendingInput(gamepad);
+            break;
+        case MovieMode::Playing:
+            break;
+    }
+}
+
+void GameBoyAdvance::StartMovieRecording()
+{
+    uint32_t romSize = gamePakLoaded_ ? gamePak_->RomSize() : 0;
+    uint32_t romHeaderCrc = gamePakLoaded_ ? gamePak_->HeaderCrc() : 0;
+
+    Reset();
+    movie_.StartRecording(romSize, romHeaderCrc);
+    ApplyMovieInput();
+}
+
+bool GameBoyAdvance::StartMoviePlayback(uint8_t const* data, size_t size)
+{
+    uint32_t romSize = gamePakLoaded_ ? gamePak_->RomSize() : 0;
+    uint32_t romHeaderCrc = gamePakLoaded_ ? gamePak_->HeaderCrc() : 0;
+
+    if (!movie_.StartPlayback(data, size, romSize, romHeaderCrc))
+    {
+        return false;
+    }
+
+    Reset();
+    ApplyMovieInput();
+    return true;
+}
+
+void GameBoyAdvance::ApplyMovieInput()
+{
+    auto gamepad = movie_.NextFrame();
+
+    if (gamepad)
+    {
+        gamepad_.UpdateGamepad(*gamepad);
+    }
+}
+
+void GameBoyAdvance::StartCapture(fs::path path, CaptureFormat format, std::string const& ffmpegOptions)
+{
+    StopCapture();
+    capture_ = std::make_unique<AvCapture>(path, format, ffmpegOptions, ppu_.GetOutputFormat(), apu_.SampleRate());
+    ppu_.SetCapture(capture_.get());
+    apu_.SetCapture(capture_.get());
+}
+
+CaptureStats GameBoyAdvance::StopCapture()
+{
+    if (!capture_)
+    {
+        return {};
+    }
+
+    ppu_.SetCapture(nullptr);
+    apu_.SetCapture(nullptr);
+    std::unique_ptr<AvCapture> capture = std::move(capture_);
+    return capture->Stop();
+}
+
+void GameBoyAdvance::DumpLogs()
+{
+    log_.DumpLogs();
+}
+
+std::string GameBoyAdvance::RomTitle() const
+{
+    if (gamePakLoaded_)
+    {
+        return gamePak_->RomTitle();
+    }
+
+    return "";
+}
+
+void GameBoyAdvance::SaveState(std::vector<uint8_t>& state)
 {
-    (void)biosPath;
-    Logging::LogMgr.Initialize();
+    SaveStateHeader header = {SAVE_STATE_MAGIC, SAVE_STATE_VERSION, 0, 0, 0};
 
-    // State
-    gamePakLoaded_ = false;
+    if (gamePakLoaded_)
+    {
+        header.romSize_ = gamePak_->RomSize();
+        header.romHeaderCrc_ = gamePak_->HeaderCrc();
+    }
 
-    Scheduler.RegisterEvent(EventType::HBlank, std::bind(&HBlank, this, std::placeholders::_1));
-    Scheduler.RegisterEvent(EventType::VBlank, std::bind(&VBlank, this, std::placeholders::_1));
-    Scheduler.RegisterEvent(EventType::Timer0Overflow, std::bind(&Timer0Overflow, this, std::placeholders::_1));
-    Scheduler.RegisterEvent(EventType::Timer1Overflow, std::bind(&Timer1Overflow, this, std::placeholders::_1));
+    StateSerializer serializer(state);
+    serializer.Value(header);
+    Serialize(serializer);
+    serializer.Finish();
+
+    // Fill in the final size now that everything has been written
+    header.size_ = state.size();
+    std::memcpy(state.data(), &header, sizeof(header));
 }
 
-GameBoyAdvance::~GameBoyAdvance()
+bool GameBoyAdvance::LoadState(uint8_t const* data, size_t size)
 {
-    Logging::LogMgr.DumpLogs();
+    if ((data == nullptr) || (size < sizeof(SaveStateHeader)))
+    {
+        return false;
+    }
+
+    SaveStateHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    uint32_t romSize = gamePakLoaded_ ? gamePak_->RomSize() : 0;
+    uint32_t romHeaderCrc = gamePakLoaded_ ? gamePak_->HeaderCrc() : 0;
+
+    if ((header.magic_ != SAVE_STATE_MAGIC) ||
+        (header.version_ != SAVE_STATE_VERSION) ||
+        (header.size_ != size) ||
+        (header.romSize_ != romSize) ||
+        (header.romHeaderCrc_ != romHeaderCrc))
+    {
+        return false;
+    }
+
+    // Movies only replay correctly from the start, so jumping to another point ends them
+    std::vector<uint8_t> discardedMovie;
+    movie_.Stop(discardedMovie);
+
+    StateSerializer serializer(data + sizeof(header), size - sizeof(header));
+
+    try
+    {
+        Serialize(serializer);
+    }
+    catch (std::runtime_error const&)
+    {
+        // Some components may have already been overwritten, so there's no consistent state to continue from
+        Reset();
+        return false;
+    }
+
+    // Run-ahead only starts from the beginning of VBlank
+    runAheadPending_ = false;
+    return true;
 }
 
-void GameBoyAdvance::Reset()
+void GameBoyAdvance::SetRewind(bool enabled, int framesPerCapture, size_t bufferSize)
 {
-    // Scheduler
-    Scheduler.Reset();
+    rewindBuffer_.reset();
+    rewindCapture_.clear();
+    rewindCapture_.shrink_to_fit();
+    rewindCapturePending_ = false;
 
-    // Components
-    apu_.Reset();
-    cpu_.Reset();
-    dmaMgr_.Reset();
-    gamepad_.Reset();
-    ppu_.Reset();
-    timerMgr_.Reset();
-    SystemController.Reset();
+    if (enabled)
+    {
+        rewindBuffer_ = std::make_unique<RewindBuffer>(bufferSize);
+        framesPerRewindCapture_ = std::max(framesPerCapture, 1);
+        framesUntilRewindCapture_ = framesPerRewindCapture_;
+    }
 
-    if (gamePakLoaded_)
+    UpdateMemoryUsage();
+}
+
+bool GameBoyAdvance::Rewind()
+{
+    if ((rewindBuffer_ == nullptr) || (rewindBuffer_->Count() == 0))
     {
-        gamePak_->Reset();
+        return false;
     }
 
-    // Memory
-    onBoardWRAM_.fill(0);
-    onChipWRAM_.fill(0);
-    placeholderIoRegisters_.fill(0);
+    auto const& state = rewindBuffer_->Newest();
+    bool loaded = LoadState(state.data(), state.size());
+    (void)rewindBuffer_->Pop();
 
-    // Open bus
-    lastBiosFetch_ = 0;
-    lastReadValue_ = 0;
+    // Wait a full interval before capturing again so that holding rewind keeps stepping back
+    framesUntilRewindCapture_ = framesPerRewindCapture_;
+    rewindCapturePending_ = false;
+    return loaded;
+}
 
-    // Scheduler
-    Scheduler.ScheduleEvent(EventType::HBlank, 960);
+void GameBoyAdvance::CaptureRewindState()
+{
+    rewindCapturePending_ = false;
+    SaveState(rewindCapture_);
+    rewindBuffer_->Push(rewindCapture_);
 }
 
-void GameBoyAdvance::FillAudioBuffer()
+void GameBoyAdvance::SetRunAhead(int frames)
 {
-    if (!biosLoaded_ && !gamePakLoaded_)
+    runAheadFrames_ = std::clamp(frames, 0, MAX_RUN_AHEAD_FRAMES);
+
+    if (runAheadFrames_ == 0)
     {
-        return;
+        runAheadPending_ = false;
     }
+}
 
-    size_t samplesToGenerate = apu_.FreeBufferSpace();
+void GameBoyAdvance::RunAhead()
+{
+    runAheadPending_ = false;
+    uint64_t framesCompleted = framesCompleted_;
+
+    SaveState(runAheadState_);
+    apu_.BeginRunAhead();
+    ppu_.BeginRunAhead(runAheadFrames_);
+    runningAhead_ = true;
 
-    while (samplesToGenerate > 0)
+    while (framesCompleted_ < (framesCompleted + runAheadFrames_))
     {
-        Run(samplesToGenerate);
-        samplesToGenerate = apu_.FreeBufferSpace();
+        RunUntilNextEvent();
     }
+
+    (void)LoadState(runAheadState_.data(), runAheadState_.size());
+    framesCompleted_ = framesCompleted;
+    runningAhead_ = false;
+    ppu_.EndRunAhead();
+    apu_.EndRunAhead();
 }
 
-void GameBoyAdvance::Run(size_t samples)
+void GameBoyAdvance::BuildPageTable()
 {
-    apu_.ClearSampleCounter();
+    pageTable_.fill({nullptr, nullptr, 0, 0, PageType::SLOW, false, {1, 1}});
+
+    MapPages(0x0200'0000, 0x02FF'FFFF, WRAM_ON_BOARD_ADDR_MIN, onBoardWRAM_.data(), onBoardWRAM_.size(),
+             PageType::WRAM, true, true, {3, 6});
+    MapPages(0x0300'0000, 0x03FF'FFFF, WRAM_ON_CHIP_ADDR_MIN, onChipWRAM_.data(), onChipWRAM_.size(),
+             PageType::WRAM, true, true, {1, 1});
+    MapPages(0x0500'0000, 0x05FF'FFFF, PALETTE_RAM_ADDR_MIN, ppu_.GetRawPRAM(), 1 * KiB,
+             PageType::VIDEO, true, false, {1, 2});
+    MapPages(0x0700'0000, 0x07FF'FFFF, OAM_ADDR_MIN, ppu_.GetRawOAM(), 1 * KiB,
+             PageType::VIDEO, true, false, {1, 1});
 
-    while (apu_.GetSampleCounter() < samples)
+    // VRAM is mirrored every 128K, with the upper 32K of each mirror mapping to the upper 32K of VRAM.
+    uint8_t* vram = ppu_.GetRawVRAM();
+
+    for (uint32_t addr = 0x0600'0000; addr < 0x0700'0000; addr += PAGE_SIZE)
     {
-        if (SystemController.Halted() || dmaMgr_.DmaActive())
+        uint32_t offset = addr % (128 * KiB);
+
+        if (offset >= (96 * KiB))
         {
-            Scheduler.SkipToNextEvent();
+            offset -= (32 * KiB);
         }
-        else
+
+        pageTable_[addr >> PAGE_SHIFT] = {vram + offset, vram + offset, PAGE_SIZE - 1, VRAM_ADDR_MIN + offset,
+                                          PageType::VIDEO, false, {1, 2}};
+    }
+
+    MapGamePakPages();
+}
+
+void GameBoyAdvance::BuildIoTable()
+{
+    for (size_t index = 0; index < ioTable_.size(); ++index)
+    {
+        uint32_t addr = IO_REG_ADDR_MIN + (index * 2);
+        IoRegisterEntry& entry = ioTable_[index];
+
+        switch (addr)
         {
-            cpu_.Step(Scheduler.GetPendingIRQ());
-            Scheduler.CheckEventQueue();
+            case LCD_IO_ADDR_MIN ... LCD_IO_ADDR_MAX:
+                entry = {ppu_.RegisterMemory(addr), IoRegion::LCD};
+                break;
+            case SOUND_IO_ADDR_MIN ... SOUND_IO_ADDR_MAX:
+                entry = {nullptr, IoRegion::SOUND};
+                break;
+            case DMA_TRANSFER_CHANNELS_IO_ADDR_MIN ... DMA_TRANSFER_CHANNELS_IO_ADDR_MAX:
+                entry = {nullptr, IoRegion::DMA};
+                break;
+            case TIMER_IO_ADDR_MIN ... TIMER_IO_ADDR_MAX:
+                entry = {nullptr, IoRegion::TIMER};
+                break;
+            case SERIAL_COMMUNICATION_1_IO_ADDR_MIN ... SERIAL_COMMUNICATION_1_IO_ADDR_MAX:
+            case SERIAL_COMMUNICATION_2_IO_ADDR_MIN ... SERIAL_COMMUNICATION_2_IO_ADDR_MAX:
+                entry = {&placeholderIoRegisters_[addr - IO_REG_ADDR_MIN], IoRegion::SERIAL};
+                break;
+            case KEYPAD_INPUT_IO_ADDR_MIN ... KEYPAD_INPUT_IO_ADDR_MAX:
+                entry = {nullptr, IoRegion::KEYPAD};
+                break;
+            case INT_WTST_PWRDWN_IO_ADDR_MIN ... INT_WTST_PWRDWN_IO_ADDR_MAX:
+                entry = {systemControl_.RegisterMemory(addr), IoRegion::SYSTEM_CONTROL};
+                break;
+            default:
+                entry = {nullptr, IoRegion::OPEN_BUS};
+                break;
         }
     }
 }
 
-std::pair<uint32_t, int> GameBoyAdvance::ReadMemory(uint32_t addr, AccessSize alignment)
+void GameBoyAdvance::MapGamePakPages()
 {
-    addr = AlignAddress(addr, alignment);
-    uint32_t value = 0;
-    int cycles = 1;
-    bool openBus = false;
-    auto page = MemoryPage::INVALID;
-
-    if (addr < 0x1000'0000)
+    for (uint32_t addr = GAME_PAK_ADDR_MIN; addr < 0x1000'0000; addr += PAGE_SIZE)
     {
-        #pragma GCC diagnostic push
-        #pragma GCC diagnostic ignored "-Wnarrowing"
-        page = MemoryPage{(addr & 0x0F00'0000) >> 24};
-        #pragma GCC diagnostic pop
+        pageTable_[addr >> PAGE_SHIFT] = {nullptr, nullptr, 0, 0, PageType::SLOW, false, {1, 1}};
     }
 
-    switch (page)
+    if (!gamePakLoaded_)
     {
-        case MemoryPage::BIOS:
-            std::tie(value, cycles) = ReadBIOS(addr, alignment);
-            break;
-        case MemoryPage::WRAM_SLOW:
-            std::tie(value, cycles) = ReadOnBoardWRAM(addr, alignment);
-            break;
-        case MemoryPage::WRAM_FAST:
-            std::tie(value, cycles) = ReadOnChipWRAM(addr, alignment);
-            break;
-        case MemoryPage::IO_REG:
-            std::tie(value, cycles) = ReadIoReg(addr, alignment);
-            break;
-        case MemoryPage::PRAM:
-            std::tie(value, cycles) = ppu_.ReadPRAM(addr, alignment);
-            break;
-        case MemoryPage::VRAM:
-            std::tie(value, cycles) = ppu_.ReadVRAM(addr, alignment);
-            break;
-        case MemoryPage::OAM:
-            std::tie(value, cycles) = ppu_.ReadOAM(addr, alignment);
-            break;
-        case MemoryPage::GAMEPAK_MIN ... MemoryPage::GAMEPAK_MAX:
-            std::tie(value, cycles, openBus) = gamePak_->ReadGamePak(addr, alignment);
-            break;
-        case MemoryPage::INVALID:
-        default:
-            openBus = true;
-            break;
+        return;
     }
 
-    if (openBus)
+    uint8_t* rom = gamePak_->GetRawROM();
+    size_t romSize = gamePak_->RomSize();
+
+    // Pages at 0x0D00'0000 and above may be EEPROM, so leave them on the slow path.
+    for (uint32_t addr = GAME_PAK_ADDR_MIN; addr < 0x0D00'0000; addr += PAGE_SIZE)
     {
-        std::tie(value, cycles) = ReadOpenBus(addr, alignment);
-    }
+        uint32_t offset = (addr - GAME_PAK_ADDR_MIN) % (32 * MiB);
 
-    lastReadValue_ = value;
-    return {value, cycles};
+        if ((offset + PAGE_SIZE) <= romSize)
+        {
+            pageTable_[addr >> PAGE_SHIFT] = {rom + offset, nullptr, PAGE_SIZE - 1, GAME_PAK_ADDR_MIN + offset,
+                                              PageType::ROM, false, {1, 1}};
+        }
+    }
 }
 
-int GameBoyAdvance::WriteMemory(uint32_t addr, uint32_t value, AccessSize alignment)
+void GameBoyAdvance::UpdateWramTiming()
 {
-    addr = AlignAddress(addr, alignment);
-    int cycles = 1;
-    auto page = MemoryPage::INVALID;
+    std::array<uint8_t, 2> cycles = systemControl_.WramCycles();
 
-    if (addr < 0x1000'0000)
+    for (uint32_t addr = 0x0200'0000; addr < 0x0300'0000; addr += PAGE_SIZE)
     {
-        #pragma GCC diagnostic push
-        #pragma GCC diagnostic ignored "-Wnarrowing"
-        page = MemoryPage{(addr & 0x0F00'0000) >> 24};
-        #pragma GCC diagnostic pop
+        pageTable_[addr >> PAGE_SHIFT].cycles_ = cycles;
     }
 
-    switch (page)
+    for (auto& [page, entry] : watchedPages_)
     {
-        case MemoryPage::BIOS:
-            break;
-        case MemoryPage::WRAM_SLOW:
-            cycles = WriteOnBoardWRAM(addr, value, alignment);
-            break;
-        case MemoryPage::WRAM_FAST:
-            cycles = WriteOnChipWRAM(addr, value, alignment);
-            break;
-        case MemoryPage::IO_REG:
-            cycles = WriteIoReg(addr, value, alignment);
-            break;
-        case MemoryPage::PRAM:
-            cycles = ppu_.WritePRAM(addr, value, alignment);
-            break;
-        case MemoryPage::VRAM:
-            cycles = ppu_.WriteVRAM(addr, value, alignment);
-            break;
-        case MemoryPage::OAM:
-            cycles = ppu_.WriteOAM(addr, value, alignment);
-            break;
-        case MemoryPage::GAMEPAK_MIN ... MemoryPage::GAMEPAK_MAX:
-            cycles = gamePak_->WriteGamePak(addr, value, alignment);
-            break;
-        case MemoryPage::INVALID:
-        default:
-            break;
+        if ((entry.baseAddr_ >> 24) == 0x02)
+        {
+            entry.cycles_ = cycles;
+        }
     }
-
-    return cycles;
 }
 
-bool GameBoyAdvance::LoadGamePak(fs::path romPath)
+void GameBoyAdvance::RestoreWatchedPages()
 {
-    gamePak_.reset();
-    gamePak_ = std::make_unique<Cartridge::GamePak>(romPath);
-    gamePakLoaded_ = gamePak_->RomLoaded();
-
-    if (gamePakLoaded_)
+    for (auto const& [page, entry] : watchedPages_)
     {
-        Reset();
+        pageTable_[page] = entry;
     }
 
-    return gamePakLoaded_;
+    watchedPages_.clear();
 }
 
-void GameBoyAdvance::UpdateGamepad(Gamepad gamepad)
+void GameBoyAdvance::RemoveWatchedPages()
 {
-    gamepad_.UpdateGamepad(gamepad);
-}
+    if (!hooks_.HasMemoryWatches())
+    {
+        return;
+    }
 
-void GameBoyAdvance::DumpLogs() const
-{
-    Logging::LogMgr.DumpLogs();
+    for (uint32_t page = 0; page < PAGE_TABLE_SIZE; ++page)
+    {
+        PageTableEntry& entry = pageTable_[page];
+
+        if (entry.type_ == PageType::SLOW)
+        {
+            continue;
+        }
+
+        uint32_t addrMax = entry.baseAddr_ + entry.mask_;
+        bool readWatched = (entry.readMemory_ != nullptr) && hooks_.Watched(entry.baseAddr_, addrMax, false);
+        bool writeWatched = (entry.writeMemory_ != nullptr) && hooks_.Watched(entry.baseAddr_, addrMax, true);
+
+        if (readWatched || writeWatched)
+        {
+            watchedPages_.emplace(page, entry);
+            entry.readMemory_ = readWatched ? nullptr : entry.readMemory_;
+            entry.writeMemory_ = writeWatched ? nullptr : entry.writeMemory_;
+        }
+    }
 }
 
-std::string GameBoyAdvance::RomTitle() const
+void GameBoyAdvance::MapPages(uint32_t addrMin,
+                              uint32_t addrMax,
+                              uint32_t regionAddr,
+                              uint8_t* memory,
+                              uint32_t size,
+                              PageType type,
+                              bool writable,
+                              bool byteWritable,
+                              std::array<uint8_t, 2> cycles)
 {
-    if (gamePakLoaded_)
+    uint32_t mask = std::min(size, PAGE_SIZE) - 1;
+
+    for (uint64_t addr = addrMin; addr <= addrMax; addr += PAGE_SIZE)
     {
-        return gamePak_->RomTitle();
+        uint32_t offset = (size > PAGE_SIZE) ? (addr % size) : 0;
+        pageTable_[addr >> PAGE_SHIFT] = {memory + offset, writable ? (memory + offset) : nullptr, mask,
+                                          regionAddr + offset, type, byteWritable, cycles};
     }
-
-    return "";
 }
 
-bool GameBoyAdvance::LoadBIOS(fs::path biosPath)
+std::shared_ptr<GameBoyAdvance::BiosImage const> GameBoyAdvance::LoadBIOS(fs::path biosPath)
 {
     if (biosPath.empty())
     {
-        return false;
+        return nullptr;
     }
 
     auto fileSizeInBytes = fs::file_size(biosPath);
+    auto bios = std::make_shared<BiosImage>();
 
-    if (fileSizeInBytes != BIOS_.size())
+    if (fileSizeInBytes != bios->size())
     {
-        return false;
+        return nullptr;
     }
 
-    std::ifstream bios(biosPath, std::ios::binary);
+    std::ifstream biosFile(biosPath, std::ios::binary);
 
-    if (bios.fail())
+    if (biosFile.fail())
     {
-        return false;
+        return nullptr;
     }
 
-    bios.read(reinterpret_cast<char*>(BIOS_.data()), fileSizeInBytes);
-    return true;
+    biosFile.read(reinterpret_cast<char*>(bios->data()), fileSizeInBytes);
+    return bios;
 }
 
 void GameBoyAdvance::HBlank(int extraCycles)
 {
     ppu_.HBlank(extraCycles);
+    PollHostInput();
 
     if (ppu_.CurrentScanline() < 160)
     {
@@ -295,25 +1399,56 @@ void GameBoyAdvance::VBlank(int extraCycles)
 
     if (ppu_.CurrentScanline() == 160)
     {
+        ++framesCompleted_;
         dmaMgr_.CheckVBlankChannels();
+
+        if (movie_.Mode() != MovieMode::Idle)
+        {
+            ApplyMovieInput();
+        }
+
+        if (runningAhead_)
+        {
+            // Nothing from frames run ahead is kept, so they're neither saved to disk nor captured for rewinding
+            return;
+        }
+
+        if (gamePakLoaded_)
+        {
+            gamePak_->CheckSaveFlush();
+        }
+
+        if ((rewindBuffer_ != nullptr) && (--framesUntilRewindCapture_ <= 0))
+        {
+            framesUntilRewindCapture_ = framesPerRewindCapture_;
+            rewindCapturePending_ = true;
+        }
+
+        // Memory watches, PC hooks, and movies must only ever see the real timeline
+        runAheadPending_ = (runAheadFrames_ > 0) &&
+                           (movie_.Mode() == MovieMode::Idle) &&
+                           !hooks_.HasMemoryWatches() &&
+                           !hooks_.HasPcHooks();
     }
 }
 
 void GameBoyAdvance::TimerOverflow(int timer, int extraCycles)
 {
+    int overflowCount = 0;
+
     switch (timer)
     {
         case 0:
-            timerMgr_.Timer0Overflow(extraCycles);
+            overflowCount = timerMgr_.Timer0Overflow(extraCycles);
             break;
         case 1:
-            timerMgr_.Timer1Overflow(extraCycles);
+            overflowCount = timerMgr_.Timer1Overflow(extraCycles);
             break;
         default:
             return;
     }
 
-    auto [replenishA, replenishB] = apu_.TimerOverflow(timer);
+    auto [replenishA, replenishB] = apu_.TimerOverflow(timer, overflowCount);
 
     if (replenishA)
     {
@@ -326,6 +1461,46 @@ void GameBoyAdvance::TimerOverflow(int timer, int extraCycles)
     }
 }
 
+void GameBoyAdvance::UpdateFifoTimers()
+{
+    timerMgr_.SetFifoTimers(apu_.FifoTimerMask(dmaMgr_.FifoChannelsEnabled(DmaXfer::FIFO_A),
+                                               dmaMgr_.FifoChannelsEnabled(DmaXfer::FIFO_B)));
+}
+
+void GameBoyAdvance::Serialize(StateSerializer& state)
+{
+    // The scheduler goes first since some components restart their timing relative to the loaded cycle count
+    scheduler_.Serialize(state);
+    systemControl_.Serialize(state);
+
+    if (state.Loading())
+    {
+        UpdateWramTiming();
+    }
+
+    // Components
+    apu_.Serialize(state);
+    cpu_.Serialize(state);
+    dmaMgr_.Serialize(state);
+    gamepad_.Serialize(state);
+    ppu_.Serialize(state);
+    timerMgr_.Serialize(state);
+
+    if (gamePakLoaded_)
+    {
+        gamePak_->Serialize(state);
+    }
+
+    // Memory
+    state.Value(onBoardWRAM_);
+    state.Value(onChipWRAM_);
+    state.Value(placeholderIoRegisters_);
+
+    // Open bus
+    state.Value(lastBiosFetch_);
+    state.Value(lastReadValue_);
+}
+
 std::pair<uint32_t, int> GameBoyAdvance::ReadBIOS(uint32_t addr, AccessSize alignment)
 {
     uint32_t value = 0;
@@ -336,7 +1511,7 @@ std::pair<uint32_t, int> GameBoyAdvance::ReadBIOS(uint32_t addr, AccessSize alig
         if (cpu_.GetPC() <= BIOS_ADDR_MAX)
         {
             size_t index = addr - BIOS_ADDR_MIN;
-            uint8_t* bytePtr = &BIOS_.at(index);
+            uint8_t const* bytePtr = &BIOS_->at(index);
             value = ReadPointer(bytePtr, alignment);
             lastBiosFetch_ = value;
         }
@@ -377,6 +1552,7 @@ int GameBoyAdvance::WriteOnBoardWRAM(uint32_t addr, uint32_t value, AccessSize a
     size_t index = addr - WRAM_ON_BOARD_ADDR_MIN;
     uint8_t* bytePtr = &onBoardWRAM_.at(index);
     WritePointer(bytePtr, value, alignment);
+    cpu_.InvalidateBlocks(addr, alignment);
     return (alignment == AccessSize::WORD) ? 6 : 3;
 }
 
@@ -403,6 +1579,7 @@ int GameBoyAdvance::WriteOnChipWRAM(uint32_t addr, uint32_t value, AccessSize al
     size_t index = addr - WRAM_ON_CHIP_ADDR_MIN;
     uint8_t* bytePtr = &onChipWRAM_.at(index);
     WritePointer(bytePtr, value, alignment);
+    cpu_.InvalidateBlocks(addr, alignment);
     return 1;
 }
 
@@ -413,49 +1590,57 @@ std::pair<uint32_t, int> GameBoyAdvance::ReadIoReg(uint32_t addr, AccessSize ali
         addr = 0x0400'0800 + (addr % (64 * KiB));
     }
 
+    if (addr > IO_REG_ADDR_MAX)
+    {
+        return ReadOpenBus(addr, alignment);
+    }
+
+    size_t index = (addr - IO_REG_ADDR_MIN) / 2;
+    IoRegisterEntry const& entry = ioTable_[index];
+
+    // Word reads can only skip the component if both halfwords are stored next to each other
+    if ((entry.readMemory_ != nullptr) &&
+        ((alignment != AccessSize::WORD) || (ioTable_[index + 1].readMemory_ == (entry.readMemory_ + 2))))
+    {
+        return {ReadPointer(entry.readMemory_ + (addr & 0x01), alignment), 1};
+    }
+
     uint32_t value = 0;
     int cycles = 1;
     bool openBus = false;
-    bool unhandledRegion = false;
 
-    switch (addr)
+    switch (entry.region_)
     {
-        case LCD_IO_ADDR_MIN ... LCD_IO_ADDR_MAX:
+        case IoRegion::LCD:
             std::tie(value, openBus) = ppu_.ReadReg(addr, alignment);
             break;
-        case SOUND_IO_ADDR_MIN ... SOUND_IO_ADDR_MAX:
+        case IoRegion::SOUND:
             std::tie(value, openBus) = apu_.ReadReg(addr, alignment);
             break;
-        case DMA_TRANSFER_CHANNELS_IO_ADDR_MIN ... DMA_TRANSFER_CHANNELS_IO_ADDR_MAX:
+        case IoRegion::DMA:
             std::tie(value, openBus) = dmaMgr_.ReadReg(addr, alignment);
             break;
-        case TIMER_IO_ADDR_MIN ... TIMER_IO_ADDR_MAX:
+        case IoRegion::TIMER:
             std::tie(value, openBus) = timerMgr_.ReadReg(addr, alignment);
+            cpu_.MarkVolatileRead();
             break;
-        case SERIAL_COMMUNICATION_1_IO_ADDR_MIN ... SERIAL_COMMUNICATION_1_IO_ADDR_MAX:
-            unhandledRegion = true;
+        case IoRegion::SERIAL:
+            value = ReadPointer(&placeholderIoRegisters_[addr - IO_REG_ADDR_MIN], alignment);
             break;
-        case KEYPAD_INPUT_IO_ADDR_MIN ... KEYPAD_INPUT_IO_ADDR_MAX:
+        case IoRegion::KEYPAD:
+            PollHostInput();
             std::tie(value, openBus) = gamepad_.ReadReg(addr, alignment);
             break;
-        case SERIAL_COMMUNICATION_2_IO_ADDR_MIN ... SERIAL_COMMUNICATION_2_IO_ADDR_MAX:
-            unhandledRegion = true;
-            break;
-        case INT_WTST_PWRDWN_IO_ADDR_MIN ... INT_WTST_PWRDWN_IO_ADDR_MAX:
-            std::tie(value, openBus) = SystemController.ReadReg(addr, alignment);
+        case IoRegion::SYSTEM_CONTROL:
+            std::tie(value, openBus) = systemControl_.ReadReg(addr, alignment);
             break;
+        case IoRegion::OPEN_BUS:
         default:
             openBus = true;
             break;
     }
 
-    if (unhandledRegion)
-    {
-        size_t index = addr - IO_REG_ADDR_MIN;
-        uint8_t* bytePtr = &placeholderIoRegisters_.at(index);
-        value = ReadPointer(bytePtr, alignment);
-    }
-    else if (openBus)
+    if (openBus)
     {
         std::tie(value, cycles) = ReadOpenBus(addr, alignment);
     }
@@ -470,45 +1655,46 @@ int GameBoyAdvance::WriteIoReg(uint32_t addr, uint32_t value, AccessSize alignme
         addr = 0x0400'0800 + (addr % (64 * KiB));
     }
 
-    bool unhandledRegion = false;
+    if (addr > IO_REG_ADDR_MAX)
+    {
+        return 1;
+    }
 
-    switch (addr)
+    switch (ioTable_[(addr - IO_REG_ADDR_MIN) / 2].region_)
     {
-        case LCD_IO_ADDR_MIN ... LCD_IO_ADDR_MAX:
+        case IoRegion::LCD:
             ppu_.WriteReg(addr, value, alignment);
             break;
-        case SOUND_IO_ADDR_MIN ... SOUND_IO_ADDR_MAX:
+        case IoRegion::SOUND:
             apu_.WriteReg(addr, value, alignment);
+            UpdateFifoTimers();
             break;
-        case DMA_TRANSFER_CHANNELS_IO_ADDR_MIN ... DMA_TRANSFER_CHANNELS_IO_ADDR_MAX:
+        case IoRegion::DMA:
             dmaMgr_.WriteReg(addr, value, alignment);
+            UpdateFifoTimers();
             break;
-        case TIMER_IO_ADDR_MIN ... TIMER_IO_ADDR_MAX:
+        case IoRegion::TIMER:
             timerMgr_.WriteReg(addr, value, alignment);
             break;
-        case SERIAL_COMMUNICATION_1_IO_ADDR_MIN ... SERIAL_COMMUNICATION_1_IO_ADDR_MAX:
-            unhandledRegion = true;
+        case IoRegion::SERIAL:
+            WritePointer(&placeholderIoRegisters_[addr - IO_REG_ADDR_MIN], value, alignment);
             break;
-        case KEYPAD_INPUT_IO_ADDR_MIN ... KEYPAD_INPUT_IO_ADDR_MAX:
+        case IoRegion::KEYPAD:
             gamepad_.WriteReg(addr, value, alignment);
             break;
-        case SERIAL_COMMUNICATION_2_IO_ADDR_MIN ... SERIAL_COMMUNICATION_2_IO_ADDR_MAX:
-            unhandledRegion = true;
-            break;
-        case INT_WTST_PWRDWN_IO_ADDR_MIN ... INT_WTST_PWRDWN_IO_ADDR_MAX:
-            SystemController.WriteReg(addr, value, alignment);
+        case IoRegion::SYSTEM_CONTROL:
+            systemControl_.WriteReg(addr, value, alignment);
+
+            if (addr >= INTERNAL_MEM_CONTROL_ADDR_MIN)
+            {
+                UpdateWramTiming();
+            }
             break;
+        case IoRegion::OPEN_BUS:
         default:
             break;
     }
 
-    if (unhandledRegion)
-    {
-        size_t index = addr - IO_REG_ADDR_MIN;
-        uint8_t* bytePtr = &placeholderIoRegisters_.at(index);
-        WritePointer(bytePtr, value, alignment);
-    }
-
     return 1;
 }
 
@@ -0,0 +1,112 @@
+#include <System/HookRegistry.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <AdvancedBoy.hpp>
+#include <System/PageTable.hpp>
+#include <Utilities/MemoryUtilities.hpp>
+
+HookRegistry::HookRegistry() :
+    pcHookPages_(PAGE_TABLE_SIZE, false),
+    nextId_(1)
+{
+}
+
+HookId HookRegistry::AddMemoryWatch(uint32_t addr, uint32_t length, WatchType type, MemoryHook hook)
+{
+    uint32_t addrMax = addr + std::max(length, 1U) - 1;
+    memoryWatches_.push_back({nextId_, addr, std::max(addr, addrMax), type, std::move(hook)});
+    return nextId_++;
+}
+
+HookId HookRegistry::AddPcHook(uint32_t pc, PcHook hook)
+{
+    pcHooks_.push_back({nextId_, pc, std::move(hook)});
+    UpdatePcHookPages();
+    return nextId_++;
+}
+
+bool HookRegistry::Remove(HookId id)
+{
+    auto watch = std::find_if(memoryWatches_.begin(), memoryWatches_.end(), [id](MemoryWatch const& w) { return w.id_ == id; });
+
+    if (watch != memoryWatches_.end())
+    {
+        memoryWatches_.erase(watch);
+        return true;
+    }
+
+    auto pcHook = std::find_if(pcHooks_.begin(), pcHooks_.end(), [id](PcHookEntry const& h) { return h.id_ == id; });
+
+    if (pcHook != pcHooks_.end())
+    {
+        pcHooks_.erase(pcHook);
+        UpdatePcHookPages();
+        return true;
+    }
+
+    return false;
+}
+
+bool HookRegistry::Watched(uint32_t addrMin, uint32_t addrMax, bool write) const
+{
+    WatchType excluded = write ? WatchType::Read : WatchType::Write;
+
+    for (MemoryWatch const& watch : memoryWatches_)
+    {
+        if ((watch.type_ != excluded) && (watch.addrMin_ <= addrMax) && (addrMin <= watch.addrMax_))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool HookRegistry::CheckMemory(uint32_t addr, uint32_t value, AccessSize alignment, bool write)
+{
+    WatchType excluded = write ? WatchType::Read : WatchType::Write;
+    uint32_t addrMax = addr + static_cast<uint32_t>(alignment) - 1;
+    uint32_t mask = (alignment == AccessSize::WORD) ? MAX_U32 : ((1U << (8 * static_cast<uint32_t>(alignment))) - 1);
+    MemoryAccess access = {addr, value & mask, static_cast<int>(alignment), write};
+    bool stop = false;
+
+    for (MemoryWatch const& watch : memoryWatches_)
+    {
+        if ((watch.type_ != excluded) && (watch.addrMin_ <= addrMax) && (addr <= watch.addrMax_))
+        {
+            stop |= watch.hook_(access);
+        }
+    }
+
+    return stop;
+}
+
+bool HookRegistry::CheckPc(uint32_t pc)
+{
+    bool stop = false;
+
+    for (PcHookEntry const& pcHook : pcHooks_)
+    {
+        if (pcHook.pc_ == pc)
+        {
+            stop |= pcHook.hook_(pc);
+        }
+    }
+
+    return stop;
+}
+
+void HookRegistry::UpdatePcHookPages()
+{
+    std::fill(pcHookPages_.begin(), pcHookPages_.end(), false);
+
+    for (PcHookEntry const& pcHook : pcHooks_)
+    {
+        if (pcHook.pc_ < 0x1000'0000)
+        {
+            pcHookPages_[pcHook.pc_ >> PAGE_SHIFT] = true;
+        }
+    }
+}
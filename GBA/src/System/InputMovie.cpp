@@ -0,0 +1,204 @@
+#include <System/InputMovie.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <vector>
+#include <AdvancedBoy.hpp>
+#include <Gamepad.hpp>
+
+namespace
+{
+constexpr uint32_t MOVIE_MAGIC = 0x564D'4241;  // "ABMV"
+constexpr uint32_t MOVIE_VERSION = 1;
+
+struct MovieHeader
+{
+    uint32_t magic_;
+    uint32_t version_;
+    uint32_t romSize_;
+    uint32_t romHeaderCrc_;
+    uint64_t length_;
+};
+}
+
+InputMovie::InputMovie() :
+    mode_(MovieMode::Idle),
+    frame_(0),
+    pendingInput_(Gamepad().halfword_),
+    lastChangeFrame_(0),
+    lastInput_(0),
+    readIndex_(0),
+    nextChangeFrame_(0),
+    nextChangeInput_(0),
+    changePending_(false),
+    length_(0)
+{
+}
+
+void InputMovie::StartRecording(uint32_t romSize, uint32_t romHeaderCrc)
+{
+    MovieHeader header = {MOVIE_MAGIC, MOVIE_VERSION, romSize, romHeaderCrc, 0};
+    stream_.resize(sizeof(header));
+    std::memcpy(stream_.data(), &header, sizeof(header));
+
+    frame_ = 0;
+    pendingInput_.store(Gamepad().halfword_, std::memory_order_relaxed);
+    lastChangeFrame_ = 0;
+    mode_ = MovieMode::Recording;
+}
+
+bool InputMovie::StartPlayback(uint8_t const* data, size_t size, uint32_t romSize, uint32_t romHeaderCrc)
+{
+    mode_ = MovieMode::Idle;
+
+    if ((data == nullptr) || (size < sizeof(MovieHeader)))
+    {
+        return false;
+    }
+
+    MovieHeader header;
+    std::memcpy(&header, data, sizeof(header));
+
+    if ((header.magic_ != MOVIE_MAGIC) ||
+        (header.version_ != MOVIE_VERSION) ||
+        (header.romSize_ != romSize) ||
+        (header.romHeaderCrc_ != romHeaderCrc))
+    {
+        return false;
+    }
+
+    stream_.assign(data, data + size);
+
+    // Check the whole stream up front so that playback never has to deal with a truncated change
+    size_t index = sizeof(header);
+    uint64_t frame = 0;
+
+    while (index < size)
+    {
+        uint64_t delta;
+
+        if (!ReadVarint(index, delta) || ((size - index) < sizeof(uint16_t)) || ((frame += delta) >= header.length_))
+        {
+            stream_.clear();
+            return false;
+        }
+
+        index += sizeof(uint16_t);
+    }
+
+    frame_ = 0;
+    length_ = header.length_;
+    readIndex_ = sizeof(header);
+    nextChangeFrame_ = 0;
+    ReadChange();
+    mode_ = MovieMode::Playing;
+    return true;
+}
+
+void InputMovie::Stop(std::vector<uint8_t>& movie)
+{
+    movie.clear();
+
+    if (Mode() == MovieMode::Recording)
+    {
+        MovieHeader header;
+        std::memcpy(&header, stream_.data(), sizeof(header));
+        header.length_ = frame_;
+        std::memcpy(stream_.data(), &header, sizeof(header));
+        movie.swap(stream_);
+    }
+
+    stream_.clear();
+    mode_ = MovieMode::Idle;
+}
+
+std::optional<Gamepad> InputMovie::NextFrame()
+{
+    std::optional<Gamepad> change;
+    MovieMode mode = Mode();
+
+    if (mode == MovieMode::Recording)
+    {
+        Gamepad gamepad;
+        gamepad.halfword_ = pendingInput_.load(std::memory_order_relaxed);
+
+        if ((frame_ == 0) || (gamepad.halfword_ != lastInput_))
+        {
+            WriteChange(frame_, gamepad.halfword_);
+            change = gamepad;
+        }
+
+        ++frame_;
+    }
+    else if (mode == MovieMode::Playing)
+    {
+        if (frame_ == length_)
+        {
+            stream_.clear();
+            mode_ = MovieMode::Idle;
+            return change;
+        }
+
+        if (changePending_ && (nextChangeFrame_ == frame_))
+        {
+            Gamepad gamepad;
+            gamepad.halfword_ = nextChangeInput_;
+            change = gamepad;
+            ReadChange();
+        }
+
+        ++frame_;
+    }
+
+    return change;
+}
+
+bool InputMovie::ReadVarint(size_t& index, uint64_t& value) const
+{
+    value = 0;
+
+    for (int shift = 0; (shift < 64) && (index < stream_.size()); shift += 7)
+    {
+        uint8_t byte = stream_[index++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void InputMovie::ReadChange()
+{
+    uint64_t delta;
+    changePending_ = ReadVarint(readIndex_, delta);
+
+    if (changePending_)
+    {
+        nextChangeFrame_ += delta;
+        nextChangeInput_ = stream_[readIndex_] | (stream_[readIndex_ + 1] << 8);
+        readIndex_ += sizeof(uint16_t);
+    }
+}
+
+void InputMovie::WriteChange(uint64_t frame, uint16_t keyinput)
+{
+    uint64_t delta = frame - lastChangeFrame_;
+
+    do
+    {
+        uint8_t byte = delta & 0x7F;
+        delta >>= 7;
+        stream_.push_back((delta == 0) ? byte : (byte | 0x80));
+    } while (delta != 0);
+
+    stream_.push_back(keyinput & 0xFF);
+    stream_.push_back(keyinput >> 8);
+    lastChangeFrame_ = frame;
+    lastInput_ = keyinput;
+}
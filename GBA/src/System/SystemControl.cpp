@@ -4,19 +4,21 @@
 #include <Logging/Logging.hpp>
 #include <System/EventScheduler.hpp>
 #include <System/MemoryMap.hpp>
-
-SystemControl SystemController;
+#include <Utilities/StateSerializer.hpp>
 
 static constexpr int NonSequentialWaitStates[4] = {4, 3, 2, 8};
 static constexpr int SequentialWaitStates[3][2] = { {2, 1}, {4, 1}, {8, 1} };
 
-SystemControl::SystemControl() :
+SystemControl::SystemControl(EventScheduler& scheduler, Logging::LogManager& log) :
     interruptAndWaitcntRegisters_(),
     postFlgAndHaltcntRegisters_(),
     ie_(*reinterpret_cast<uint16_t*>(&interruptAndWaitcntRegisters_[0])),
     if_(*reinterpret_cast<uint16_t*>(&interruptAndWaitcntRegisters_[2])),
     ime_(*reinterpret_cast<uint16_t*>(&interruptAndWaitcntRegisters_[8])),
-    waitcnt_(*reinterpret_cast<WAITCNT*>(&interruptAndWaitcntRegisters_[4]))
+    waitcnt_(*reinterpret_cast<WAITCNT*>(&interruptAndWaitcntRegisters_[4])),
+    waitStateTable_(),
+    scheduler_(scheduler),
+    log_(log)
 {
 }
 
@@ -27,6 +29,24 @@ void SystemControl::Reset()
     postFlgAndHaltcntRegisters_.fill(0);
     undocumentedRegisters_.fill(0);
     internalMemoryControlRegisters_.fill(0);
+
+    // Power-on value of the internal memory control register sets on-board work RAM to 2 wait states
+    WritePointer<AccessSize::WORD>(internalMemoryControlRegisters_.data(), 0x0D00'0020);
+    UpdateWaitStateTable();
+}
+
+void SystemControl::Serialize(StateSerializer& state)
+{
+    state.Value(halted_);
+    state.Value(interruptAndWaitcntRegisters_);
+    state.Value(postFlgAndHaltcntRegisters_);
+    state.Value(undocumentedRegisters_);
+    state.Value(internalMemoryControlRegisters_);
+
+    if (state.Loading())
+    {
+        UpdateWaitStateTable();
+    }
 }
 
 std::pair<uint32_t, bool> SystemControl::ReadReg(uint32_t addr, AccessSize alignment)
@@ -62,6 +82,21 @@ std::pair<uint32_t, bool> SystemControl::ReadReg(uint32_t addr, AccessSize align
     return {value, openBus};
 }
 
+uint8_t const* SystemControl::RegisterMemory(uint32_t addr) const
+{
+    switch (addr)
+    {
+        case INT_WAITCNT_ADDR_MIN ... INT_WAITCNT_ADDR_MAX:
+            return &interruptAndWaitcntRegisters_.at(addr - INT_WAITCNT_ADDR_MIN);
+        case UNDOCUMENTED_ADDR_MIN ... UNDOCUMENTED_ADDR_MAX:
+            return &undocumentedRegisters_.at(addr - UNDOCUMENTED_ADDR_MIN);
+        case INTERNAL_MEM_CONTROL_ADDR_MIN ... INTERNAL_MEM_CONTROL_ADDR_MAX:
+            return &internalMemoryControlRegisters_.at(addr - INTERNAL_MEM_CONTROL_ADDR_MIN);
+        default:
+            return nullptr;
+    }
+}
+
 void SystemControl::WriteReg(uint32_t addr, uint32_t value, AccessSize alignment)
 {
     uint8_t* bytePtr = nullptr;
@@ -105,77 +140,34 @@ void SystemControl::CheckForInterrupt()
             irqPending = true;
         }
 
-        if (halted_ && Logging::LogMgr.SystemLoggingEnabled())
+        if (halted_ && log_.SystemLoggingEnabled())
         {
-            Logging::LogMgr.LogUnhalt(if_, ie_);
+            log_.LogUnhalt(if_, ie_);
         }
 
         halted_ = false;
     }
 
-    Scheduler.SetPendingIRQ(irqPending);
+    scheduler_.SetPendingIRQ(irqPending);
 }
 
 void SystemControl::RequestInterrupt(InterruptType interrupt)
 {
-    if (Logging::LogMgr.SystemLoggingEnabled())
+    if (log_.SystemLoggingEnabled())
     {
-        Logging::LogMgr.LogInterruptRequest(interrupt, ie_, ime_);
+        log_.LogInterruptRequest(interrupt, ie_, ime_);
     }
 
     if_ |= static_cast<uint16_t>(interrupt);
     CheckForInterrupt();
 }
 
-int SystemControl::WaitStates(WaitState state, bool sequential, AccessSize alignment) const
+std::array<uint8_t, 2> SystemControl::WramCycles() const
 {
-    int firstAccess = 0;
-    int secondAccess = 0;
-
-    switch (state)
-    {
-        case WaitState::ZERO:
-        {
-            firstAccess = sequential ? SequentialWaitStates[0][waitcnt_.waitState0SecondAccess] :
-                                       NonSequentialWaitStates[waitcnt_.waitState0FirstAccess];
-
-            if (alignment == AccessSize::WORD)
-            {
-                secondAccess = SequentialWaitStates[0][waitcnt_.waitState0SecondAccess];
-            }
-
-            break;
-        }
-        case WaitState::ONE:
-        {
-            firstAccess = sequential ? SequentialWaitStates[1][waitcnt_.waitState1SecondAccess] :
-                                       NonSequentialWaitStates[waitcnt_.waitState1FirstAccess];
-
-            if (alignment == AccessSize::WORD)
-            {
-                secondAccess = SequentialWaitStates[1][waitcnt_.waitState1SecondAccess];
-            }
-
-            break;
-        }
-        case WaitState::TWO:
-        {
-            firstAccess = sequential ? SequentialWaitStates[2][waitcnt_.waitState2SecondAccess] :
-                                       NonSequentialWaitStates[waitcnt_.waitState2FirstAccess];
-
-            if (alignment == AccessSize::WORD)
-            {
-                secondAccess = SequentialWaitStates[2][waitcnt_.waitState2SecondAccess];
-            }
-
-            break;
-        }
-        case WaitState::SRAM:
-            firstAccess = NonSequentialWaitStates[waitcnt_.sramWaitCtrl];
-            break;
-    }
-
-    return firstAccess + secondAccess;
+    uint8_t waitControl = internalMemoryControlRegisters_[3] & 0x0F;
+    uint8_t waitStates = (waitControl == 0x0F) ? 0 : (15 - waitControl);
+    uint8_t halfwordCycles = 1 + waitStates;
+    return {halfwordCycles, static_cast<uint8_t>(2 * halfwordCycles)};
 }
 
 std::pair<uint32_t, bool> SystemControl::ReadPostFlgHaltcnt(uint32_t addr, AccessSize alignment)
@@ -227,7 +219,33 @@ void SystemControl::WriteInterruptWaitcnt(uint32_t addr, uint32_t value, AccessS
     if (bytePtr != nullptr)
     {
         WritePointer(bytePtr, value, alignment);
+        UpdateWaitStateTable();
+    }
+}
+
+void SystemControl::UpdateWaitStateTable()
+{
+    std::array<int, 3> const firstAccess = {waitcnt_.waitState0FirstAccess,
+                                            waitcnt_.waitState1FirstAccess,
+                                            waitcnt_.waitState2FirstAccess};
+    std::array<int, 3> const secondAccess = {waitcnt_.waitState0SecondAccess,
+                                             waitcnt_.waitState1SecondAccess,
+                                             waitcnt_.waitState2SecondAccess};
+
+    for (int region = 0; region < 3; ++region)
+    {
+        uint8_t nonSequential = NonSequentialWaitStates[firstAccess[region]];
+        uint8_t sequential = SequentialWaitStates[region][secondAccess[region]];
+
+        // Word accesses are split into two halfword accesses, the second of which is always sequential
+        waitStateTable_[region][false] = {nonSequential, static_cast<uint8_t>(nonSequential + sequential)};
+        waitStateTable_[region][true] = {sequential, static_cast<uint8_t>(2 * sequential)};
     }
+
+    // SRAM is only ever accessed a byte at a time, and has no sequential timing
+    uint8_t sram = NonSequentialWaitStates[waitcnt_.sramWaitCtrl];
+    waitStateTable_[static_cast<int>(WaitState::SRAM)][false] = {sram, sram};
+    waitStateTable_[static_cast<int>(WaitState::SRAM)][true] = {sram, sram};
 }
 
 void SystemControl::AcknowledgeInterrupt(uint16_t acknowledgement)
@@ -258,9 +276,9 @@ void SystemControl::CheckHaltWrite(uint32_t addr, uint32_t value, AccessSize ali
     {
         halted_ = (haltcnt & MSB_8) == 0x00;
 
-        if (halted_ && Logging::LogMgr.SystemLoggingEnabled())
+        if (halted_ && log_.SystemLoggingEnabled())
         {
-            Logging::LogMgr.LogHalt(ie_);
+            log_.LogHalt(ie_);
         }
     }
 }
@@ -0,0 +1,133 @@
+#include <System/TelemetryRecorder.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <AdvancedBoy.hpp>
+#include <CPU/CpuTypes.hpp>
+#include <System/EventScheduler.hpp>
+
+namespace
+{
+/// @brief Sum the growth of a set of per-event totals over a frame.
+/// @param current Totals now.
+/// @param frameStart Totals when the frame started.
+/// @param eventTypes Events to include.
+/// @return Combined growth of the selected events.
+template <size_t N>
+uint64_t EventDelta(std::array<uint64_t, static_cast<size_t>(EventType::COUNT)> const& current,
+                    std::array<uint64_t, static_cast<size_t>(EventType::COUNT)> const& frameStart,
+                    std::array<EventType, N> const& eventTypes)
+{
+    uint64_t delta = 0;
+
+    for (EventType eventType : eventTypes)
+    {
+        size_t index = static_cast<size_t>(eventType);
+        delta += current[index] - frameStart[index];
+    }
+
+    return delta;
+}
+
+constexpr std::array<EventType, 3> PPU_EVENTS = {EventType::HBlank, EventType::VBlank, EventType::VDraw};
+constexpr std::array<EventType, 1> APU_EVENTS = {EventType::SampleAPU};
+constexpr std::array<EventType, 4> TIMER_EVENTS = {
+    EventType::Timer0Overflow, EventType::Timer1Overflow, EventType::Timer2Overflow, EventType::Timer3Overflow
+};
+}
+
+TelemetryRecorder::TelemetryRecorder(EventScheduler& scheduler) :
+    scheduler_(scheduler),
+    cpuTime_(0),
+    dmaTime_(0),
+    apuTime_(0),
+    frameStartEventCounts_(scheduler.EventCounts()),
+    frameStartEventHostTime_(scheduler.EventHostTime()),
+    frameStartCycle_(scheduler.TotalCycles()),
+    frameStartTime_(Clock::now()),
+    publishedFrame_(0),
+    sequence_(0),
+    audioUnderruns_(0),
+    instanceMemory_(0),
+    sharedMemory_(0)
+{
+    for (auto& word : published_)
+    {
+        word.store(0, std::memory_order_relaxed);
+    }
+}
+
+void TelemetryRecorder::FrameCompleted(uint64_t frame, uint64_t totalCycles)
+{
+    auto const& eventCounts = scheduler_.EventCounts();
+    auto const& eventHostTime = scheduler_.EventHostTime();
+    Clock::time_point now = Clock::now();
+
+    // The cycle counter restarts when a ROM is loaded or moves arbitrarily when a state is loaded
+    uint64_t emulatedCycles = (totalCycles >= frameStartCycle_) ? (totalCycles - frameStartCycle_) : totalCycles;
+    double emulatedSeconds = static_cast<double>(emulatedCycles) / CPU::CPU_FREQUENCY_HZ;
+    double hostSeconds = std::chrono::duration<double>(now - frameStartTime_).count();
+
+    Telemetry telemetry = {};
+    telemetry.frame_ = frame;
+    telemetry.frameTime_ = std::chrono::duration_cast<std::chrono::nanoseconds>(now - frameStartTime_).count();
+    telemetry.cpuTime_ = cpuTime_;
+    telemetry.dmaTime_ = dmaTime_;
+    telemetry.ppuTime_ = EventDelta(eventHostTime, frameStartEventHostTime_, PPU_EVENTS);
+    telemetry.apuTime_ = apuTime_ + EventDelta(eventHostTime, frameStartEventHostTime_, APU_EVENTS);
+    telemetry.timerTime_ = EventDelta(eventHostTime, frameStartEventHostTime_, TIMER_EVENTS);
+    telemetry.ppuEvents_ = EventDelta(eventCounts, frameStartEventCounts_, PPU_EVENTS);
+    telemetry.apuEvents_ = EventDelta(eventCounts, frameStartEventCounts_, APU_EVENTS);
+    telemetry.timerEvents_ = EventDelta(eventCounts, frameStartEventCounts_, TIMER_EVENTS);
+    telemetry.speedRatio_ = (hostSeconds > 0.0) ? (emulatedSeconds / hostSeconds) : 0.0;
+
+    std::array<uint64_t, TELEMETRY_WORDS> words;
+    std::memcpy(words.data(), &telemetry, sizeof(Telemetry));
+
+    uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (size_t i = 0; i < TELEMETRY_WORDS; ++i)
+    {
+        published_[i].store(words[i], std::memory_order_relaxed);
+    }
+
+    sequence_.store(sequence + 2, std::memory_order_release);
+
+    cpuTime_ = 0;
+    dmaTime_ = 0;
+    apuTime_ = 0;
+    frameStartEventCounts_ = eventCounts;
+    frameStartEventHostTime_ = eventHostTime;
+    frameStartCycle_ = totalCycles;
+    frameStartTime_ = now;
+    publishedFrame_ = frame;
+}
+
+Telemetry TelemetryRecorder::Read() const
+{
+    std::array<uint64_t, TELEMETRY_WORDS> words;
+    uint64_t sequence;
+
+    do
+    {
+        sequence = sequence_.load(std::memory_order_acquire);
+
+        for (size_t i = 0; i < TELEMETRY_WORDS; ++i)
+        {
+            words[i] = published_[i].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((sequence & 0x01) || (sequence != sequence_.load(std::memory_order_relaxed)));
+
+    Telemetry telemetry;
+    std::memcpy(&telemetry, words.data(), sizeof(Telemetry));
+    telemetry.audioUnderruns_ = audioUnderruns_.load(std::memory_order_relaxed);
+    telemetry.instanceMemory_ = instanceMemory_.load(std::memory_order_relaxed);
+    telemetry.sharedMemory_ = sharedMemory_.load(std::memory_order_relaxed);
+    return telemetry;
+}
@@ -1,18 +1,23 @@
 #include <Timers/Timer.hpp>
+#include <algorithm>
 #include <array>
 #include <cstdint>
 #include <optional>
+#include <utility>
+#include <Audio/Constants.hpp>
 #include <System/EventScheduler.hpp>
 #include <System/SystemControl.hpp>
 #include <Utilities/MemoryUtilities.hpp>
+#include <Utilities/StateSerializer.hpp>
 
-Timer::Timer(int index, EventType overflowEvent, InterruptType interruptType) :
+Timer::Timer(int index, EventType overflowEvent, InterruptType interruptType, EventScheduler& scheduler) :
     timerRegisters_(),
     timerReload_(*reinterpret_cast<uint16_t*>(&timerRegisters_[0])),
     timerControl_(*reinterpret_cast<TIMCNT*>(&timerRegisters_[2])),
     timerIndex_(index),
     overflowEvent_(overflowEvent),
-    interruptType_(interruptType)
+    interruptType_(interruptType),
+    scheduler_(scheduler)
 {
 }
 
@@ -20,6 +25,20 @@ void Timer::Reset()
 {
     timerRegisters_.fill(0);
     internalTimer_ = 0;
+    counterCycle_ = 0;
+    overflowMode_ = OverflowMode::NONE;
+    pendingOverflows_ = 0;
+    prescalerShift_ = 0;
+}
+
+void Timer::Serialize(StateSerializer& state)
+{
+    state.Value(timerRegisters_);
+    state.Value(internalTimer_);
+    state.Value(counterCycle_);
+    state.Value(overflowMode_);
+    state.Value(pendingOverflows_);
+    state.Value(prescalerShift_);
 }
 
 uint32_t Timer::ReadReg(uint32_t addr, AccessSize alignment)
@@ -31,19 +50,21 @@ uint32_t Timer::ReadReg(uint32_t addr, AccessSize alignment)
     {
         if (!CascadeMode() && timerControl_.start)
         {
-            UpdateInternalCounter(GetDivider(timerControl_.prescalerSelection));
+            UpdateInternalCounter();
         }
 
+        uint16_t counter = internalTimer_;
+
         switch (alignment)
         {
             case AccessSize::BYTE:
-                value = ((index == 0) ? (internalTimer_ & MAX_U8) : ((internalTimer_ >> 8) & MAX_U8));
+                value = ((index == 0) ? (counter & MAX_U8) : ((counter >> 8) & MAX_U8));
                 break;
             case AccessSize::HALFWORD:
-                value = internalTimer_;
+                value = counter;
                 break;
             case AccessSize::WORD:
-                value = (timerControl_.value << 16) | internalTimer_;
+                value = (timerControl_.value << 16) | counter;
                 break;
         }
     }
@@ -60,7 +81,7 @@ void Timer::WriteReg(uint32_t addr, uint32_t value, AccessSize alignment)
 {
     if (!CascadeMode() && timerControl_.start)
     {
-        UpdateInternalCounter(GetDivider(timerControl_.prescalerSelection));
+        UpdateInternalCounter();
     }
 
     TIMCNT prevControl = timerControl_;
@@ -68,6 +89,7 @@ void Timer::WriteReg(uint32_t addr, uint32_t value, AccessSize alignment)
     size_t index = addr & 0x03;
     uint8_t* bytePtr = &timerRegisters_.at(index);
     WritePointer(bytePtr, value, alignment);
+    prescalerShift_ = PRESCALER_SHIFTS[timerControl_.prescalerSelection];
 
     if (!prevControl.start && timerControl_.start)  // Starting the timer
     {
@@ -75,7 +97,7 @@ void Timer::WriteReg(uint32_t addr, uint32_t value, AccessSize alignment)
     }
     else if (prevControl.start && !timerControl_.start)  // Stopping the timer
     {
-        Scheduler.UnscheduleEvent(overflowEvent_);
+        scheduler_.UnscheduleEvent(overflowEvent_);
     }
     else if (prevControl.start && timerControl_.start)  // Timer was and still is running
     {
@@ -85,7 +107,17 @@ void Timer::WriteReg(uint32_t addr, uint32_t value, AccessSize alignment)
         }
         else if (!prevControl.countUpTiming && timerControl_.countUpTiming)  // Switch from normal to cascade
         {
-            Scheduler.UnscheduleEvent(overflowEvent_);
+            scheduler_.UnscheduleEvent(overflowEvent_);
+        }
+        else if (!CascadeMode() && (prevControl.prescalerSelection != timerControl_.prescalerSelection))
+        {
+            // Partial progress towards the next tick is lost when the prescaler changes
+            counterCycle_ = std::max(counterCycle_, scheduler_.TotalCycles());
+
+            if (overflowMode_ != OverflowMode::NONE)
+            {
+                ScheduleOverflow();
+            }
         }
     }
 }
@@ -93,45 +125,78 @@ void Timer::WriteReg(uint32_t addr, uint32_t value, AccessSize alignment)
 void Timer::StartTimer()
 {
     internalTimer_ = timerReload_;
+    counterCycle_ = scheduler_.TotalCycles() + 2;
+    pendingOverflows_ = 0;
 
-    if (!CascadeMode())
+    if (!CascadeMode() && (overflowMode_ != OverflowMode::NONE))
     {
-        uint64_t cyclesUntilOverflow = ((0x0001'0000 - internalTimer_) * GetDivider(timerControl_.prescalerSelection)) + 2;
-        Scheduler.ScheduleEvent(overflowEvent_, cyclesUntilOverflow);
+        ScheduleOverflow();
     }
 }
 
 int Timer::Overflow(int extraCycles)
 {
-    int overflowCount = 1;
-    internalTimer_ = timerReload_;
+    (void)extraCycles;
 
-    if (!CascadeMode())
+    if (CascadeMode())
     {
-        uint16_t divider = GetDivider(timerControl_.prescalerSelection);
-        uint64_t timerDuration = (0x0001'0000 - timerReload_) * divider;
-
-        if (timerDuration <= static_cast<uint64_t>(extraCycles))
-        {
-            overflowCount += extraCycles / timerDuration;
-            extraCycles %= timerDuration;
-        }
+        internalTimer_ = timerReload_;
+        return 1;
+    }
 
-        internalTimer_ += (extraCycles / divider);
-        extraCycles %= divider;
+    UpdateInternalCounter();
+    int overflowCount = pendingOverflows_;
+    pendingOverflows_ = 0;
 
-        int cyclesUntilOverflow = ((0x0001'0000 - internalTimer_) * divider) - extraCycles;
-        Scheduler.ScheduleEvent(overflowEvent_, cyclesUntilOverflow);
+    if (overflowMode_ != OverflowMode::NONE)
+    {
+        ScheduleOverflow();
     }
 
     return overflowCount;
 }
 
+void Timer::SetOverflowMode(OverflowMode mode)
+{
+    if (mode == overflowMode_)
+    {
+        return;
+    }
+
+    bool counting = timerControl_.start && !CascadeMode();
+
+    if (counting)
+    {
+        UpdateInternalCounter();
+    }
+
+    overflowMode_ = mode;
+
+    if (counting)
+    {
+        if (overflowMode_ == OverflowMode::NONE)
+        {
+            scheduler_.UnscheduleEvent(overflowEvent_);
+        }
+        else
+        {
+            ScheduleOverflow();
+        }
+    }
+}
+
 void Timer::CascadeModeIncrement(int incrementCount)
 {
     if ((internalTimer_ + incrementCount) > 0xFFFF)
     {
-        Scheduler.ScheduleEvent(overflowEvent_, SCHEDULE_NOW);
+        if (overflowMode_ == OverflowMode::NONE)
+        {
+            internalTimer_ = AdvanceCounter(incrementCount).first;
+        }
+        else
+        {
+            scheduler_.ScheduleEvent(overflowEvent_, SCHEDULE_NOW);
+        }
     }
     else
     {
@@ -139,29 +204,67 @@ void Timer::CascadeModeIncrement(int incrementCount)
     }
 }
 
-void Timer::UpdateInternalCounter(uint16_t divider)
+uint64_t Timer::ElapsedTicks() const
+{
+    uint64_t currentCycle = scheduler_.TotalCycles();
+    return (currentCycle > counterCycle_) ? ((currentCycle - counterCycle_) >> prescalerShift_) : 0;
+}
+
+std::pair<uint16_t, int> Timer::AdvanceCounter(uint64_t ticks) const
 {
-    auto elapsedCycles = Scheduler.ElapsedCycles(overflowEvent_);
+    uint64_t counter = internalTimer_ + ticks;
 
-    if (elapsedCycles.has_value())
+    if (counter <= 0xFFFF)
     {
-        internalTimer_ += (elapsedCycles.value() / divider);
+        return {counter, 0};
     }
+
+    uint64_t period = 0x0001'0000 - timerReload_;
+    counter -= 0x0001'0000;
+    int overflowCount = 1 + (counter / period);
+    return {timerReload_ + (counter % period), overflowCount};
 }
 
-uint16_t Timer::GetDivider(uint16_t prescalerSelection) const
+void Timer::UpdateInternalCounter()
 {
-    switch (prescalerSelection)
+    uint64_t ticks = ElapsedTicks();
+    auto [counter, overflowCount] = AdvanceCounter(ticks);
+    internalTimer_ = counter;
+    counterCycle_ += ticks << prescalerShift_;
+
+    // Overflows that happen while nothing depends on them don't need to be reported
+    if (overflowMode_ != OverflowMode::NONE)
+    {
+        pendingOverflows_ += overflowCount;
+    }
+}
+
+void Timer::ScheduleOverflow()
+{
+    uint64_t currentCycle = scheduler_.TotalCycles();
+    uint64_t overflowCycle = counterCycle_ + (static_cast<uint64_t>(0x0001'0000 - internalTimer_) << prescalerShift_);
+
+    if (overflowMode_ == OverflowMode::BATCHED)
     {
-        case 0:
-            return 1;
-        case 1:
-            return 64;
-        case 2:
-            return 256;
-        case 3:
-            return 1024;
+        // DMA audio FIFOs only need to be up to date when the APU samples them, so deliver every overflow up until the first
+        // sample after the next overflow in one event. Events on the same cycle as a sample fire first.
+        auto cyclesUntilSample = scheduler_.CyclesRemaining(EventType::SampleAPU);
+
+        if (cyclesUntilSample.has_value())
+        {
+            uint64_t sampleCycle = currentCycle + cyclesUntilSample.value();
+
+            if (sampleCycle < overflowCycle)
+            {
+                uint64_t samplePeriod = Audio::CPU_CYCLES_PER_SAMPLE;
+                sampleCycle += ((overflowCycle - sampleCycle + samplePeriod - 1) / samplePeriod) * samplePeriod;
+            }
+
+            uint64_t timerDuration = static_cast<uint64_t>(0x0001'0000 - timerReload_) << prescalerShift_;
+            uint64_t batchedOverflows = (sampleCycle - overflowCycle) / timerDuration;
+            overflowCycle += std::min<uint64_t>(batchedOverflows, MAX_BATCHED_OVERFLOWS - 1) * timerDuration;
+        }
     }
 
-    return 1;
+    scheduler_.ScheduleEvent(overflowEvent_, overflowCycle - currentCycle);
 }
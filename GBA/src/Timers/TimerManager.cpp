@@ -7,15 +7,19 @@
 #include <System/SystemControl.hpp>
 #include <Timers/Timer.hpp>
 #include <Utilities/MemoryUtilities.hpp>
+#include <Utilities/StateSerializer.hpp>
 
-TimerManager::TimerManager() :
-    timers_({Timer(0, EventType::Timer0Overflow, InterruptType::TIMER_0_OVERFLOW),
-             Timer(1, EventType::Timer1Overflow, InterruptType::TIMER_1_OVERFLOW),
-             Timer(2, EventType::Timer2Overflow, InterruptType::TIMER_2_OVERFLOW),
-             Timer(3, EventType::Timer3Overflow, InterruptType::TIMER_3_OVERFLOW)})
+TimerManager::TimerManager(EventScheduler& scheduler, SystemControl& systemControl, Logging::LogManager& log) :
+    timers_({Timer(0, EventType::Timer0Overflow, InterruptType::TIMER_0_OVERFLOW, scheduler),
+             Timer(1, EventType::Timer1Overflow, InterruptType::TIMER_1_OVERFLOW, scheduler),
+             Timer(2, EventType::Timer2Overflow, InterruptType::TIMER_2_OVERFLOW, scheduler),
+             Timer(3, EventType::Timer3Overflow, InterruptType::TIMER_3_OVERFLOW, scheduler)}),
+    fifoTimers_(0),
+    systemControl_(systemControl),
+    log_(log)
 {
-    Scheduler.RegisterEvent(EventType::Timer2Overflow, std::bind(&Timer2Overflow, this, std::placeholders::_1));
-    Scheduler.RegisterEvent(EventType::Timer3Overflow, std::bind(&Timer3Overflow, this, std::placeholders::_1));
+    scheduler.RegisterEvent(EventType::Timer2Overflow, std::bind(&Timer2Overflow, this, std::placeholders::_1));
+    scheduler.RegisterEvent(EventType::Timer3Overflow, std::bind(&Timer3Overflow, this, std::placeholders::_1));
 }
 
 void TimerManager::Reset()
@@ -24,6 +28,18 @@ void TimerManager::Reset()
     {
         timer.Reset();
     }
+
+    fifoTimers_ = 0;
+}
+
+void TimerManager::Serialize(StateSerializer& state)
+{
+    for (auto& timer : timers_)
+    {
+        timer.Serialize(state);
+    }
+
+    state.Value(fifoTimers_);
 }
 
 std::pair<uint32_t, bool> TimerManager::ReadReg(uint32_t addr, AccessSize alignment)
@@ -68,13 +84,24 @@ void TimerManager::WriteReg(uint32_t addr, uint32_t value, AccessSize alignment)
     {
         timers_[3].WriteReg(addr, value, alignment);
     }
+
+    UpdateOverflowModes();
 }
 
-void TimerManager::TimerOverflow(int timerIndex, int extraCycles)
+void TimerManager::SetFifoTimers(uint8_t timerMask)
 {
-    if (Logging::LogMgr.SystemLoggingEnabled())
+    if (timerMask != fifoTimers_)
     {
-        Logging::LogMgr.LogTimerOverflow(timerIndex);
+        fifoTimers_ = timerMask;
+        UpdateOverflowModes();
+    }
+}
+
+int TimerManager::TimerOverflow(int timerIndex, int extraCycles)
+{
+    if (log_.SystemLoggingEnabled())
+    {
+        log_.LogTimerOverflow(timerIndex);
     }
 
     Timer& overflowTimer = timers_[timerIndex];
@@ -85,15 +112,39 @@ void TimerManager::TimerOverflow(int timerIndex, int extraCycles)
         nextTimer = &timers_[timerIndex + 1];
     }
 
-    if (overflowTimer.GenerateIRQ())
+    int overflowCount = overflowTimer.Overflow(extraCycles);
+
+    if (overflowTimer.GenerateIRQ() && (overflowCount > 0))
     {
-        SystemController.RequestInterrupt(overflowTimer.GetInterruptType());
+        systemControl_.RequestInterrupt(overflowTimer.GetInterruptType());
     }
 
-    int overflowCount = overflowTimer.Overflow(extraCycles);
-
-    if ((nextTimer != nullptr) && (nextTimer->CascadeMode()))
+    if ((nextTimer != nullptr) && nextTimer->Running() && nextTimer->CascadeMode())
     {
         nextTimer->CascadeModeIncrement(overflowCount);
     }
+
+    return overflowCount;
+}
+
+void TimerManager::UpdateOverflowModes()
+{
+    for (size_t i = 0; i < timers_.size(); ++i)
+    {
+        Timer& timer = timers_[i];
+        bool cascadeDependant = (i < 3) && timers_[i + 1].Running() && timers_[i + 1].CascadeMode();
+
+        if (timer.GenerateIRQ() || cascadeDependant)
+        {
+            timer.SetOverflowMode(OverflowMode::EACH);
+        }
+        else if (fifoTimers_ & (1 << i))
+        {
+            timer.SetOverflowMode(OverflowMode::BATCHED);
+        }
+        else
+        {
+            timer.SetOverflowMode(OverflowMode::NONE);
+        }
+    }
 }
@@ -0,0 +1,87 @@
+#include <Utilities/MappedFile.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <system_error>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(fs::path const& path) :
+    data_(nullptr),
+    size_(0)
+{
+    std::error_code error;
+    auto const fileSize = fs::file_size(path, error);
+
+    if (error || (fileSize == 0))
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    CloseHandle(file);
+
+    if (mapping == nullptr)
+    {
+        return;
+    }
+
+    // The view keeps the mapping alive after its handle is closed.
+    void* view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+    CloseHandle(mapping);
+
+    if (view == nullptr)
+    {
+        return;
+    }
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+
+    if (fd < 0)
+    {
+        return;
+    }
+
+    // The mapping stays valid after the file descriptor is closed.
+    void* view = mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (view == MAP_FAILED)
+    {
+        return;
+    }
+#endif
+
+    data_ = static_cast<uint8_t*>(view);
+    size_ = fileSize;
+}
+
+MappedFile::~MappedFile()
+{
+    if (data_ == nullptr)
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+#else
+    munmap(data_, size_);
+#endif
+}
@@ -0,0 +1,248 @@
+#include <Utilities/RewindBuffer.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace
+{
+// Average delta size assumed when sizing the delta table. Deltas of a frame where little changed can be smaller, in which case
+// the table fills up before the arena does.
+constexpr size_t EXPECTED_DELTA_SIZE = 4 * 1024;
+constexpr size_t MIN_ENTRY_COUNT = 16;
+
+// Unchanged bytes are only split out of a literal run when there are at least this many in a row
+constexpr size_t MIN_ZERO_RUN = 8;
+
+// Longest encoding of a size_t, 7 bits per byte
+constexpr size_t MAX_VARINT_SIZE = 10;
+
+/// @brief Read 8 bytes from any alignment.
+/// @param ptr Pointer to first byte.
+/// @return Bytes packed into an integer.
+uint64_t Load64(uint8_t const* ptr)
+{
+    uint64_t value;
+    std::memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+/// @brief Write a variable length integer.
+/// @param dest Pointer to write to. Advanced past the written bytes.
+/// @param value Value to write.
+void WriteVarint(uint8_t*& dest, size_t value)
+{
+    while (value >= 0x80)
+    {
+        *dest++ = static_cast<uint8_t>(value) | 0x80;
+        value >>= 7;
+    }
+
+    *dest++ = static_cast<uint8_t>(value);
+}
+
+/// @brief Read a variable length integer.
+/// @param src Pointer to read from. Advanced past the read bytes.
+/// @return Value that was read.
+size_t ReadVarint(uint8_t const*& src)
+{
+    size_t value = 0;
+    int shift = 0;
+
+    while (*src & 0x80)
+    {
+        value |= static_cast<size_t>(*src++ & 0x7F) << shift;
+        shift += 7;
+    }
+
+    value |= static_cast<size_t>(*src++) << shift;
+    return value;
+}
+}
+
+RewindBuffer::RewindBuffer(size_t capacity) :
+    capacity_(capacity),
+    arena_(new uint8_t[capacity]),
+    entries_(std::max(capacity / EXPECTED_DELTA_SIZE, MIN_ENTRY_COUNT)),
+    oldestEntry_(0),
+    entryCount_(0)
+{
+}
+
+void RewindBuffer::Push(std::vector<uint8_t>& state)
+{
+    if (!newest_.empty())
+    {
+        if (encodeBuffer_.size() < MaxEncodedSize(newest_.size()))
+        {
+            encodeBuffer_.resize(MaxEncodedSize(newest_.size()));
+        }
+
+        size_t length = EncodeDelta(newest_, state, encodeBuffer_.data());
+
+        if (length > capacity_)
+        {
+            // Too different from the previous state to fit, so there's no way to step back past this state
+            oldestEntry_ = 0;
+            entryCount_ = 0;
+        }
+        else
+        {
+            if (entryCount_ == entries_.size())
+            {
+                DropOldest();
+            }
+
+            size_t offset = Allocate(length);
+            std::memcpy(&arena_[offset], encodeBuffer_.data(), length);
+            entries_[(oldestEntry_ + entryCount_) % entries_.size()] = {offset, length, newest_.size()};
+            ++entryCount_;
+        }
+    }
+
+    newest_.swap(state);
+}
+
+bool RewindBuffer::Pop()
+{
+    if (entryCount_ == 0)
+    {
+        return false;
+    }
+
+    Entry const& entry = entries_[(oldestEntry_ + entryCount_ - 1) % entries_.size()];
+    newest_.resize(entry.stateSize_);
+    DecodeDelta(&arena_[entry.offset_], entry.length_, newest_);
+    --entryCount_;
+    return true;
+}
+
+void RewindBuffer::Clear()
+{
+    newest_.clear();
+    oldestEntry_ = 0;
+    entryCount_ = 0;
+}
+
+size_t RewindBuffer::EncodeDelta(std::vector<uint8_t> const& older, std::vector<uint8_t> const& newer, uint8_t* dest)
+{
+    // The delta is a series of tokens, each a count of unchanged bytes followed by a count of changed bytes and their XOR values.
+    uint8_t const* olderPtr = older.data();
+    uint8_t const* newerPtr = newer.data();
+    size_t const commonSize = std::min(older.size(), newer.size());
+    uint8_t* const start = dest;
+    size_t index = 0;
+
+    while (index < commonSize)
+    {
+        size_t zeroStart = index;
+
+        while (((index + 8) <= commonSize) && (Load64(olderPtr + index) == Load64(newerPtr + index)))
+        {
+            index += 8;
+        }
+
+        while ((index < commonSize) && (olderPtr[index] == newerPtr[index]))
+        {
+            ++index;
+        }
+
+        size_t literalStart = index;
+
+        while ((index < commonSize) &&
+               !(((index + MIN_ZERO_RUN) <= commonSize) && (Load64(olderPtr + index) == Load64(newerPtr + index))))
+        {
+            ++index;
+        }
+
+        WriteVarint(dest, literalStart - zeroStart);
+        WriteVarint(dest, index - literalStart);
+
+        for (size_t i = literalStart; i < index; ++i)
+        {
+            *dest++ = olderPtr[i] ^ newerPtr[i];
+        }
+    }
+
+    // Bytes past the end of the newer state are restored as is
+    if (older.size() > commonSize)
+    {
+        WriteVarint(dest, 0);
+        WriteVarint(dest, older.size() - commonSize);
+        std::memcpy(dest, olderPtr + commonSize, older.size() - commonSize);
+        dest += older.size() - commonSize;
+    }
+
+    return dest - start;
+}
+
+void RewindBuffer::DecodeDelta(uint8_t const* src, size_t length, std::vector<uint8_t>& state)
+{
+    uint8_t const* const end = src + length;
+    uint8_t* statePtr = state.data();
+
+    while (src < end)
+    {
+        statePtr += ReadVarint(src);
+        size_t literalLength = ReadVarint(src);
+
+        for (size_t i = 0; i < literalLength; ++i)
+        {
+            statePtr[i] ^= src[i];
+        }
+
+        statePtr += literalLength;
+        src += literalLength;
+    }
+}
+
+size_t RewindBuffer::MaxEncodedSize(size_t stateSize)
+{
+    // Every token but the first starts with at least MIN_ZERO_RUN unchanged bytes, plus one more token for the size change
+    size_t maxTokens = (stateSize / MIN_ZERO_RUN) + 2;
+    return stateSize + (maxTokens * MAX_VARINT_SIZE * 2);
+}
+
+size_t RewindBuffer::Allocate(size_t length)
+{
+    if (entryCount_ == 0)
+    {
+        return 0;
+    }
+
+    Entry const& newest = entries_[(oldestEntry_ + entryCount_ - 1) % entries_.size()];
+    size_t offset = newest.offset_ + newest.length_;
+
+    if ((offset + length) > capacity_)
+    {
+        // Wrap around. Deltas between the newest one and the end of the arena are the oldest, and would be left stranded.
+        while ((entryCount_ > 0) && (entries_[oldestEntry_].offset_ >= offset))
+        {
+            DropOldest();
+        }
+
+        offset = 0;
+    }
+
+    while (entryCount_ > 0)
+    {
+        Entry const& oldest = entries_[oldestEntry_];
+
+        if ((oldest.offset_ >= (offset + length)) || ((oldest.offset_ + oldest.length_) <= offset))
+        {
+            break;
+        }
+
+        DropOldest();
+    }
+
+    return offset;
+}
+
+void RewindBuffer::DropOldest()
+{
+    oldestEntry_ = (oldestEntry_ + 1) % entries_.size();
+    --entryCount_;
+}
@@ -0,0 +1,78 @@
+#include <Utilities/StateSerializer.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+StateSerializer::StateSerializer(std::vector<uint8_t>& buffer) :
+    loading_(false),
+    buffer_(&buffer),
+    data_(nullptr),
+    size_(0),
+    offset_(0)
+{
+    // Bytes past the end are zero filled once when the buffer first grows, and then simply overwritten by later saves
+    buffer_->resize(buffer_->capacity());
+}
+
+StateSerializer::StateSerializer(uint8_t const* data, size_t size) :
+    loading_(true),
+    buffer_(nullptr),
+    data_(data),
+    size_(size),
+    offset_(0)
+{
+}
+
+void StateSerializer::Bytes(void* data, size_t size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    if (loading_)
+    {
+        CheckRemaining(size, 1);
+        std::memcpy(data, data_ + offset_, size);
+    }
+    else
+    {
+        if ((offset_ + size) > buffer_->size())
+        {
+            buffer_->resize(std::max(offset_ + size, buffer_->size() * 2));
+        }
+
+        std::memcpy(buffer_->data() + offset_, data, size);
+    }
+
+    offset_ += size;
+}
+
+void StateSerializer::Finish()
+{
+    if (!loading_)
+    {
+        buffer_->resize(offset_);
+    }
+}
+
+void StateSerializer::CheckRemaining(uint64_t count, size_t itemSize) const
+{
+    if (count > ((size_ - offset_) / itemSize))
+    {
+        throw std::runtime_error("Save state is truncated");
+    }
+}
+
+bool StateSerializer::Matches(size_t offset, void const* data, size_t size) const
+{
+    if (!loading_ || (offset > size_) || (size > (size_ - offset)))
+    {
+        return false;
+    }
+
+    return std::memcmp(data_ + offset, data, size) == 0;
+}
@@ -0,0 +1,115 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <Graphics/BlendKernels.hpp>
+
+namespace
+{
+// A full scanline plus a few pixels, so that every kernel also runs its scalar tail
+constexpr size_t SPAN_LENGTH = 243;
+constexpr uint16_t MAX_COEFFICIENT = 0x10;
+
+typedef std::array<uint16_t, SPAN_LENGTH> Span;
+
+/// @brief Fill a span with random pixels, including the unused top bit so that kernels are checked for ignoring it.
+/// @param span Span to fill.
+/// @param rng Random number generator.
+void Randomize(Span& span, std::mt19937& rng)
+{
+    std::uniform_int_distribution<uint32_t> distribution(0, 0xFFFF);
+
+    for (uint16_t& pixel : span)
+    {
+        pixel = static_cast<uint16_t>(distribution(rng));
+    }
+}
+
+/// @brief Check that a kernel produced exactly the same span as the scalar kernel, and report the first difference if not.
+/// @param kernel Name of kernel set being checked.
+/// @param operation Name of blending operation and its coefficients.
+/// @param expected Output of scalar kernel.
+/// @param actual Output of kernel being checked.
+/// @return True if both spans match.
+bool Matches(std::string const& kernel, std::string const& operation, Span const& expected, Span const& actual)
+{
+    for (size_t i = 0; i < SPAN_LENGTH; ++i)
+    {
+        if (expected[i] != actual[i])
+        {
+            std::cerr << kernel << " " << operation << " differs at pixel " << i << ": expected " << std::hex << expected[i]
+                      << ", got " << actual[i] << std::dec << "\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+}  // namespace
+
+int main()
+{
+    std::vector<Graphics::BlendKernelSet> kernels = Graphics::SupportedBlendKernels();
+    Graphics::BlendKernelSet const& scalar = kernels.front();
+    std::mt19937 rng(0x4742'4121);
+    Span targetA;
+    Span targetB;
+    Span expected;
+    Span actual;
+    bool passed = true;
+
+    for (uint16_t eva = 0; eva <= MAX_COEFFICIENT; ++eva)
+    {
+        for (uint16_t evb = 0; evb <= MAX_COEFFICIENT; ++evb)
+        {
+            Randomize(targetA, rng);
+            Randomize(targetB, rng);
+            scalar.alphaBlend_(targetA.data(), targetB.data(), expected.data(), SPAN_LENGTH, eva, evb);
+            std::string operation = "alpha blend EVA=" + std::to_string(eva) + " EVB=" + std::to_string(evb);
+
+            for (auto const& kernel : kernels)
+            {
+                kernel.alphaBlend_(targetA.data(), targetB.data(), actual.data(), SPAN_LENGTH, eva, evb);
+                passed &= Matches(kernel.name_, operation, expected, actual);
+            }
+        }
+    }
+
+    for (uint16_t evy = 0; evy <= MAX_COEFFICIENT; ++evy)
+    {
+        Randomize(targetA, rng);
+        std::string operation = "EVY=" + std::to_string(evy);
+
+        scalar.increaseBrightness_(targetA.data(), expected.data(), SPAN_LENGTH, evy);
+
+        for (auto const& kernel : kernels)
+        {
+            kernel.increaseBrightness_(targetA.data(), actual.data(), SPAN_LENGTH, evy);
+            passed &= Matches(kernel.name_, "brightness increase " + operation, expected, actual);
+        }
+
+        scalar.decreaseBrightness_(targetA.data(), expected.data(), SPAN_LENGTH, evy);
+
+        for (auto const& kernel : kernels)
+        {
+            kernel.decreaseBrightness_(targetA.data(), actual.data(), SPAN_LENGTH, evy);
+            passed &= Matches(kernel.name_, "brightness decrease " + operation, expected, actual);
+        }
+    }
+
+    if (!passed)
+    {
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 1; i < kernels.size(); ++i)
+    {
+        std::cout << kernels[i].name_ << " kernels match the scalar kernels\n";
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,30 @@
+# Run with cmake -P after training. Clang writes one raw profile per process, which must be merged into the single profile that
+# -fprofile-use reads. GCC reads the profiles it wrote directly, so there's nothing to do for it.
+#
+#   PROFILE_DIR  Directory that the instrumented binaries wrote profiles to.
+#   COMPILER_ID  CMAKE_CXX_COMPILER_ID of the build.
+
+if (NOT COMPILER_ID MATCHES "Clang")
+    return()
+endif()
+
+find_program(LLVM_PROFDATA NAMES llvm-profdata llvm-profdata-19 llvm-profdata-18 llvm-profdata-17 llvm-profdata-16 llvm-profdata-15)
+
+if (NOT LLVM_PROFDATA)
+    message(FATAL_ERROR "llvm-profdata is needed to merge profiles collected by Clang")
+endif()
+
+file(GLOB rawProfiles "${PROFILE_DIR}/*.profraw")
+
+if (NOT rawProfiles)
+    message(FATAL_ERROR "No profiles were written to ${PROFILE_DIR}")
+endif()
+
+execute_process(
+    COMMAND ${LLVM_PROFDATA} merge -output=${PROFILE_DIR}/default.profdata ${rawProfiles}
+    RESULT_VARIABLE result
+)
+
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "Merging profiles failed")
+endif()
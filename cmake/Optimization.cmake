@@ -0,0 +1,61 @@
+# Build configuration shared by GbaLib and every executable that links it. Included before any targets are defined, so that
+# everything is compiled and linked with the same optimization settings.
+
+include(CheckIPOSupported)
+
+if (NOT CMAKE_BUILD_TYPE AND NOT CMAKE_CONFIGURATION_TYPES)
+    set(CMAKE_BUILD_TYPE RelWithDebInfo CACHE STRING "Build type" FORCE)
+endif()
+
+option(GBA_ENABLE_LTO "Build GbaLib and the executables that link it with link time optimization" OFF)
+set(GBA_ARCH "" CACHE STRING "Architecture to compile for, passed to -march (such as native or x86-64-v3). Empty uses the compiler's default.")
+set(GBA_PGO "OFF" CACHE STRING "Profile guided optimization stage: OFF, GENERATE to build instrumented binaries, or USE to build with collected profiles")
+set_property(CACHE GBA_PGO PROPERTY STRINGS OFF GENERATE USE)
+set(GBA_PGO_DIR "${PROJECT_BINARY_DIR}/pgo-profiles" CACHE PATH "Directory that profiles are written to when training and read from when optimizing")
+set(GBA_PGO_ROMS "" CACHE STRING "Semicolon separated list of ROMs that the pgo-train target runs through GbaBench")
+
+if (GBA_ENABLE_LTO)
+    check_ipo_supported(RESULT ltoSupported OUTPUT ltoError LANGUAGES CXX)
+
+    if (NOT ltoSupported)
+        message(FATAL_ERROR "GBA_ENABLE_LTO is on, but the compiler doesn't support link time optimization: ${ltoError}")
+    endif()
+
+    set(CMAKE_INTERPROCEDURAL_OPTIMIZATION ON)
+endif()
+
+if (GBA_ARCH)
+    add_compile_options(-march=${GBA_ARCH})
+endif()
+
+if (GBA_PGO STREQUAL "GENERATE")
+    if (CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+        add_compile_options(-fprofile-generate=${GBA_PGO_DIR})
+        add_link_options(-fprofile-generate=${GBA_PGO_DIR})
+    else()
+        # The render thread updates counters concurrently with the emulation thread
+        add_compile_options(-fprofile-generate=${GBA_PGO_DIR} -fprofile-update=atomic)
+        add_link_options(-fprofile-generate=${GBA_PGO_DIR} -fprofile-update=atomic)
+    endif()
+elseif (GBA_PGO STREQUAL "USE")
+    if (CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+        set(profile "${GBA_PGO_DIR}/default.profdata")
+
+        if (NOT EXISTS ${profile})
+            message(FATAL_ERROR "GBA_PGO is USE, but ${profile} doesn't exist. Build and run the pgo-train target first.")
+        endif()
+
+        add_compile_options(-fprofile-use=${profile} -Wno-profile-instr-unprofiled)
+        add_link_options(-fprofile-use=${profile})
+    else()
+        if (NOT EXISTS ${GBA_PGO_DIR})
+            message(FATAL_ERROR "GBA_PGO is USE, but ${GBA_PGO_DIR} doesn't exist. Build and run the pgo-train target first.")
+        endif()
+
+        # Code that training never reached, such as the UI, is still optimized normally instead of for size
+        add_compile_options(-fprofile-use=${GBA_PGO_DIR} -fprofile-partial-training -Wno-missing-profile)
+        add_link_options(-fprofile-use=${GBA_PGO_DIR} -fprofile-partial-training)
+    endif()
+elseif (NOT GBA_PGO STREQUAL "OFF")
+    message(FATAL_ERROR "GBA_PGO must be OFF, GENERATE, or USE, not ${GBA_PGO}")
+endif()